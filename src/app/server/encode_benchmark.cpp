@@ -0,0 +1,436 @@
+#include "app/server/encode_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "common/log_manager.h"
+#include "media/codec/copy_rect.h"
+#include "media/codec/encoder/roi_map.h"
+#include "media/pipeline/frame_size_limiter.h"
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+using media::capture::MoveRect;
+
+constexpr uint8_t kDesktop = 200;
+constexpr uint8_t kTitleBar = 60;
+constexpr uint8_t kPaper = 235;
+constexpr uint8_t kInk = 30;
+constexpr int kGlyphWidth = 8;
+constexpr int kGlyphHeight = 14;
+constexpr int kAdvance = 10;
+constexpr int kLineHeight = 20;
+
+/// 合成的办公桌面（只有亮度平面，色度恒为 128）
+class SyntheticDesktop {
+ public:
+  SyntheticDesktop(int width, int height, int framerate, int scroll_interval)
+      : width_(width),
+        caret_period_(std::max(framerate / 2, 1)),
+        scroll_interval_(scroll_interval),
+        luma_(static_cast<size_t>(width) * height, kDesktop) {
+    const int margin = std::max(width / 12, kAdvance);
+    doc_ = {margin, 64, width - margin, height - 64};
+    // 对齐到整行，滚动时行不跨边界
+    doc_.bottom = doc_.top + std::max(doc_.Height() / kLineHeight, 1) *
+                                 kLineHeight;
+    Fill({0, 0, width, std::min(32, height)}, kTitleBar);
+    Fill(doc_, kPaper);
+    for (int y = doc_.top; y < doc_.bottom; y += kLineHeight) {
+      const int length = static_cast<int>(Next() % Columns());
+      for (int column = 0; column < length; ++column) {
+        DrawGlyph(doc_.left + column * kAdvance, y);
+      }
+    }
+    cursor_x_ = doc_.left;
+    cursor_y_ = doc_.bottom - kLineHeight;
+    Fill({doc_.left, cursor_y_, doc_.right, cursor_y_ + kLineHeight}, kPaper);
+  }
+
+  const uint8_t* Luma() const { return luma_.data(); }
+
+  /**
+   * @brief 生成下一帧
+   * @param dirty 相对上一帧变化的区域（不含移动区域）
+   * @param moves 滚动时文档区的移动，语义同 DXGI 的移动区域
+   */
+  void Advance(int frame_index,
+               std::vector<DirtyRect>& dirty,
+               std::vector<MoveRect>& moves) {
+    dirty.clear();
+    moves.clear();
+    if (scroll_interval_ > 0 && frame_index > 0 &&
+        frame_index % scroll_interval_ == 0) {
+      Scroll();
+      moves.push_back({{doc_.left, doc_.top + kLineHeight, doc_.right,
+                        doc_.bottom},
+                       {doc_.left, doc_.top, doc_.right,
+                        doc_.bottom - kLineHeight}});
+      dirty.push_back({doc_.left, doc_.bottom - kLineHeight, doc_.right,
+                       doc_.bottom});
+    }
+
+    // 输入一个字符
+    EraseCaret(dirty);
+    if (cursor_x_ + kAdvance > doc_.right) {
+      NewLine(dirty);
+    }
+    DrawGlyph(cursor_x_, cursor_y_);
+    dirty.push_back({cursor_x_, cursor_y_, cursor_x_ + kGlyphWidth,
+                     cursor_y_ + kGlyphHeight});
+    cursor_x_ += kAdvance;
+
+    // 光标闪烁
+    if ((frame_index / caret_period_) % 2 == 0) {
+      Fill(CaretRect(), kInk);
+      dirty.push_back(CaretRect());
+      caret_visible_ = true;
+    }
+  }
+
+ private:
+  int Columns() const { return std::max(doc_.Width() / kAdvance, 1); }
+
+  uint32_t Next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+
+  DirtyRect CaretRect() const {
+    return {cursor_x_, cursor_y_, std::min(cursor_x_ + 2, doc_.right),
+            cursor_y_ + kLineHeight - 2};
+  }
+
+  void Fill(const DirtyRect& rect, uint8_t value) {
+    for (int y = rect.top; y < rect.bottom; ++y) {
+      std::memset(&luma_[static_cast<size_t>(y) * width_ + rect.left], value,
+                  static_cast<size_t>(rect.Width()));
+    }
+  }
+
+  void DrawGlyph(int x, int y) {
+    for (int row = 0; row < kGlyphHeight; ++row) {
+      const uint32_t bits = Next();
+      uint8_t* line = &luma_[static_cast<size_t>(y + row) * width_ + x];
+      for (int column = 0; column < kGlyphWidth; ++column) {
+        line[column] = (bits >> column) & 1 ? kInk : kPaper;
+      }
+    }
+  }
+
+  void EraseCaret(std::vector<DirtyRect>& dirty) {
+    if (caret_visible_) {
+      Fill(CaretRect(), kPaper);
+      dirty.push_back(CaretRect());
+      caret_visible_ = false;
+    }
+  }
+
+  void NewLine(std::vector<DirtyRect>& dirty) {
+    cursor_x_ = doc_.left;
+    cursor_y_ += kLineHeight;
+    if (cursor_y_ + kLineHeight > doc_.bottom) {
+      cursor_y_ = doc_.top;
+    }
+    const DirtyRect line{doc_.left, cursor_y_, doc_.right,
+                         cursor_y_ + kLineHeight};
+    Fill(line, kPaper);
+    dirty.push_back(line);
+  }
+
+  void Scroll() {
+    for (int y = doc_.top; y + kLineHeight < doc_.bottom; ++y) {
+      std::memcpy(&luma_[static_cast<size_t>(y) * width_ + doc_.left],
+                  &luma_[static_cast<size_t>(y + kLineHeight) * width_ +
+                         doc_.left],
+                  static_cast<size_t>(doc_.Width()));
+    }
+    Fill({doc_.left, doc_.bottom - kLineHeight, doc_.right, doc_.bottom},
+         kPaper);
+    cursor_y_ = std::max(cursor_y_ - kLineHeight, doc_.top);
+  }
+
+  int width_;
+  int caret_period_;
+  int scroll_interval_;
+  std::vector<uint8_t> luma_;
+  DirtyRect doc_{};
+  int cursor_x_ = 0;
+  int cursor_y_ = 0;
+  bool caret_visible_ = false;
+  uint32_t state_ = 0x9E3779B9u;
+};
+
+enum class RunMode {
+  kFullFrame,
+  kRoi,       ///< 脏区域作为 ROI
+  kCopyRect,  ///< 滚动以复制命令发送，只编码残差区域
+  kTiled,       ///< 分块编码，每帧编码全部分块
+  kTiledDirty,  ///< 分块编码，跳过没有变化的分块
+};
+
+const char* RateControlName(RateControlMode mode) {
+  switch (mode) {
+    case RateControlMode::kCRF:
+      return "crf";
+    case RateControlMode::kCBR:
+      return "cbr";
+    case RateControlMode::kVBR:
+      return "vbr";
+    case RateControlMode::kCQP:
+      return "cqp";
+    case RateControlMode::kLowLatency:
+      return "lowlat";
+  }
+  return "unknown";
+}
+
+Result<EncodeBenchmarkReport::Run> RunOnce(const EncodeBenchmarkConfig& config,
+                                           RateControlMode rate_control,
+                                           RunMode mode) {
+  const bool roi = mode == RunMode::kRoi;
+  const bool tiled = mode == RunMode::kTiled || mode == RunMode::kTiledDirty;
+  EncoderConfig encoder_config;
+  encoder_config.width = config.width;
+  encoder_config.height = config.height;
+  encoder_config.framerate = config.framerate;
+  encoder_config.encoder_type = EncoderType::kSoftware;
+  encoder_config.rate_control = rate_control;
+  encoder_config.bitrate = config.bitrate_bps;
+  encoder_config.max_bitrate = config.bitrate_bps;
+  encoder_config.crf = config.crf;
+  encoder_config.latency_budget_ms = config.latency_budget_ms;
+  encoder_config.roi_encoding = roi;
+  encoder_config.roi_qp_delta = config.roi_qp_delta;
+  encoder_config.thread_count = config.threads;
+  if (tiled) {
+    encoder_config.tile_columns = config.tile_columns;
+    encoder_config.tile_rows = config.tile_rows;
+  }
+
+  auto encoder = CreateVideoEncoder(encoder_config);
+  if (encoder.IsErr()) {
+    return Result<EncodeBenchmarkReport::Run>::Err(encoder.Code(),
+                                                   encoder.Message());
+  }
+
+  AVFramePtr frame = MakeAVFrame();
+  if (!frame) {
+    return Result<EncodeBenchmarkReport::Run>::Err(ErrorCode::kOutOfMemory,
+                                                   "Failed to allocate frame");
+  }
+  frame->format = AV_PIX_FMT_NV12;
+  frame->width = config.width;
+  frame->height = config.height;
+  if (av_frame_get_buffer(frame.get(), 32) < 0) {
+    return Result<EncodeBenchmarkReport::Run>::Err(
+        ErrorCode::kOutOfMemory, "Failed to allocate frame buffer");
+  }
+  for (int y = 0; y < config.height / 2; ++y) {
+    std::memset(frame->data[1] + static_cast<size_t>(y) * frame->linesize[1],
+                128, static_cast<size_t>(config.width));
+  }
+
+  EncodeBenchmarkReport::Run run;
+  run.name = RateControlName(rate_control);
+  switch (mode) {
+    case RunMode::kFullFrame:
+      run.name += " full-frame";
+      break;
+    case RunMode::kRoi:
+      run.name += " roi";
+      break;
+    case RunMode::kCopyRect:
+      run.name += " copy-rect";
+      break;
+    case RunMode::kTiled:
+    case RunMode::kTiledDirty:
+      run.name += fmt::format(" tiled {}x{}{}", config.tile_columns,
+                              config.tile_rows,
+                              mode == RunMode::kTiledDirty ? " dirty" : "");
+      break;
+  }
+  SyntheticDesktop desktop(config.width, config.height, config.framerate,
+                           config.scroll_interval);
+  std::vector<DirtyRect> dirty;
+  std::vector<MoveRect> moves;
+  CopyRectTracker tracker;
+  tracker.Reset(config.width, config.height);
+  CopyRectCommand command;
+  uint64_t total_bytes = 0;
+  double encode_ms = 0.0;
+  const size_t frame_cap = FrameSizeLimiter::ComputeFrameCap(
+      config.bitrate_bps, config.framerate,
+      std::chrono::milliseconds(config.latency_budget_ms));
+  auto count = [&](const EncodedPacket& packet) {
+    ++run.frames;
+    total_bytes += packet.data.size();
+    run.max_frame_bits = std::max(
+        run.max_frame_bits, static_cast<double>(packet.data.size()) * 8);
+    run.frames_over_cap += packet.data.size() > frame_cap ? 1 : 0;
+    if (packet.is_keyframe && run.keyframe_bits == 0.0) {
+      run.keyframe_bits = static_cast<double>(packet.data.size()) * 8;
+    }
+  };
+
+  EncodedPacket packet;
+  for (int i = 0; i < config.frames; ++i) {
+    if (av_frame_make_writable(frame.get()) < 0) {
+      return Result<EncodeBenchmarkReport::Run>::Err(
+          ErrorCode::kOutOfMemory, "Failed to make frame writable");
+    }
+    desktop.Advance(i, dirty, moves);
+    const bool copy_rect = mode == RunMode::kCopyRect && i > 0;
+    if (copy_rect) {
+      // 编码器输入帧只更新残差区域，移动区域由接收端复制
+      tracker.AddFrame(dirty, moves);
+      for (const auto& rect : tracker.GetResidualRects()) {
+        for (int y = rect.top; y < rect.bottom; ++y) {
+          std::memcpy(
+              frame->data[0] + static_cast<size_t>(y) * frame->linesize[0] +
+                  rect.left,
+              desktop.Luma() + static_cast<size_t>(y) * config.width +
+                  rect.left,
+              static_cast<size_t>(rect.Width()));
+        }
+      }
+    } else {
+      for (int y = 0; y < config.height; ++y) {
+        std::memcpy(
+            frame->data[0] + static_cast<size_t>(y) * frame->linesize[0],
+            desktop.Luma() + static_cast<size_t>(y) * config.width,
+            static_cast<size_t>(config.width));
+      }
+    }
+    for (const auto& move : moves) {
+      dirty.push_back(move.destination);
+    }
+    if (roi) {
+      // 首帧整帧都是新内容
+      const auto rects =
+          i == 0 ? std::vector<DirtyRect>()
+                 : BuildRoiRects(dirty, config.width, config.height,
+                                 config.width, config.height);
+      auto attached =
+          AttachRegionsOfInterest(frame.get(), rects, config.roi_qp_delta);
+      if (attached.IsErr()) {
+        return Result<EncodeBenchmarkReport::Run>::Err(attached.Code(),
+                                                       attached.Message());
+      }
+      run.roi_frames += rects.empty() ? 0 : 1;
+    }
+    if (mode == RunMode::kTiledDirty && i > 0) {
+      encoder.Value()->SetChangedRegions(dirty);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto encoded = encoder.Value()->Encode(frame.get(), packet);
+    encode_ms += std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    if (encoded.IsErr()) {
+      return Result<EncodeBenchmarkReport::Run>::Err(encoded.Code(),
+                                                     encoded.Message());
+    }
+    if (encoded.Value()) {
+      if (copy_rect && tracker.TakeCommand(command)) {
+        // 零延迟编码，输出的就是刚输入的帧
+        auto sei = BuildCopyRectSei(command, encoder_config.codec_id);
+        auto inserted =
+            sei.IsOk()
+                ? InsertCopyRectSei(sei.Value(), encoder_config.codec_id,
+                                    packet.data)
+                : Result<void>::Err(sei.Code(), sei.Message());
+        if (inserted.IsErr()) {
+          return Result<EncodeBenchmarkReport::Run>::Err(inserted.Code(),
+                                                         inserted.Message());
+        }
+        ++run.copy_rect_frames;
+      }
+      count(packet);
+    }
+  }
+
+  std::vector<EncodedPacket> remaining;
+  auto flushed = encoder.Value()->Flush(remaining);
+  if (flushed.IsErr()) {
+    return Result<EncodeBenchmarkReport::Run>::Err(flushed.Code(),
+                                                   flushed.Message());
+  }
+  for (const auto& rest : remaining) {
+    count(rest);
+  }
+
+  if (run.frames > 0) {
+    run.bits_per_frame =
+        static_cast<double>(total_bytes) * 8 / static_cast<double>(run.frames);
+  }
+  run.encode_ms_per_frame = encode_ms / std::max(config.frames, 1);
+  return Result<EncodeBenchmarkReport::Run>::Ok(std::move(run));
+}
+
+}  // namespace
+
+std::string EncodeBenchmarkReport::Format() const {
+  std::string text;
+  char line[256];
+  std::snprintf(line, sizeof(line),
+                "%-24s %6s %12s %12s %12s %8s %10s %6s %6s\n", "run", "frames",
+                "bits/frame", "key bits", "max bits", "over cap", "encode ms",
+                "roi", "copy");
+  text += line;
+  for (const auto& run : runs) {
+    std::snprintf(line, sizeof(line),
+                  "%-24s %6llu %12.0f %12.0f %12.0f %8llu %10.3f %6llu %6llu\n",
+                  run.name.c_str(), static_cast<unsigned long long>(run.frames),
+                  run.bits_per_frame, run.keyframe_bits, run.max_frame_bits,
+                  static_cast<unsigned long long>(run.frames_over_cap),
+                  run.encode_ms_per_frame,
+                  static_cast<unsigned long long>(run.roi_frames),
+                  static_cast<unsigned long long>(run.copy_rect_frames));
+    text += line;
+  }
+  return text;
+}
+
+Result<EncodeBenchmarkReport> RunEncodeBenchmark(
+    const EncodeBenchmarkConfig& config) {
+  if (config.width < 64 || config.height < 160 || config.width % 2 != 0 ||
+      config.height % 2 != 0 || config.framerate <= 0 || config.frames <= 0) {
+    return Result<EncodeBenchmarkReport>::Err(
+        ErrorCode::kInvalidParameter, "Invalid encode benchmark parameters");
+  }
+
+  std::vector<RunMode> run_modes = {RunMode::kFullFrame, RunMode::kRoi,
+                                    RunMode::kCopyRect};
+  if (config.tile_columns * config.tile_rows > 1) {
+    run_modes.push_back(RunMode::kTiled);
+    run_modes.push_back(RunMode::kTiledDirty);
+  }
+
+  EncodeBenchmarkReport report;
+  for (RateControlMode mode : {RateControlMode::kCRF, RateControlMode::kCBR,
+                               RateControlMode::kLowLatency}) {
+    for (RunMode run_mode : run_modes) {
+      auto run = RunOnce(config, mode, run_mode);
+      if (run.IsErr()) {
+        return Result<EncodeBenchmarkReport>::Err(run.Code(), run.Message());
+      }
+      ZENREMOTE_INFO("Encode benchmark {}: {:.0f} bits/frame, {:.3f} ms/frame",
+                     run.Value().name, run.Value().bits_per_frame,
+                     run.Value().encode_ms_per_frame);
+      report.runs.push_back(std::move(run.Value()));
+    }
+  }
+  return Result<EncodeBenchmarkReport>::Ok(std::move(report));
+}
+
+}  // namespace zenremote
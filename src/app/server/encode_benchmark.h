@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+#include "media/codec/encoder/video_encoder.h"
+
+namespace zenremote {
+
+/**
+ * @brief 合成屏幕内容上的编码基准（无头模式 --encode-bench）
+ *
+ * 生成办公桌面式的 NV12 序列：白底文档上的文字行，每帧在光标处输入一个
+ * 字符，光标每半秒闪烁，每 scroll_interval 帧文档区滚动一行。同一序列
+ * 分别以整帧编码、按脏区域 ROI 编码（EncoderConfig::roi_encoding）和
+ * 滚动以复制命令发送（copy_rect.h，编码器只看到新露出的行），在 CRF、
+ * CBR 与低延迟（RateControlMode::kLowLatency）三种码率控制下各编码一遍，
+ * 报告每帧比特数（含命令的 SEI）、编码耗时、最大帧，以及超过单帧上限
+ * （bitrate_bps × latency_budget_ms，见 frame_size_limiter.h）的帧数：
+ * 滚动与首帧在 CRF/CBR 下远超上限，发送它们的排队时间即延迟尖峰。
+ *
+ * tile_columns x tile_rows 大于 1x1 时另以分块编码（tiled_encoder.h）各
+ * 编码两遍：每帧编码全部分块（内容全屏变化时的延迟），以及按脏区域跳过
+ * 没有变化的分块。与整帧编码（单实例条带线程）比较单帧编码耗时，观察
+ * 4K/8K 下延迟随核数的变化。
+ */
+struct EncodeBenchmarkConfig {
+  int width = 1920;
+  int height = 1080;
+  int framerate = 60;
+  int frames = 600;
+  int bitrate_bps = 4000000;  ///< CBR 与低延迟的目标码率
+  int latency_budget_ms = 50;  ///< 单帧上限的延迟预算
+  int crf = 23;
+  int roi_qp_delta = -6;
+  int scroll_interval = 120;  ///< 0 表示不滚动
+  int tile_columns = 1;
+  int tile_rows = 1;
+  int threads = 0;  ///< EncoderConfig::thread_count，0 表示自动
+};
+
+struct EncodeBenchmarkReport {
+  struct Run {
+    std::string name;
+    uint64_t frames = 0;
+    double bits_per_frame = 0.0;
+    double keyframe_bits = 0.0;  ///< 首个关键帧
+    double max_frame_bits = 0.0;
+    uint64_t frames_over_cap = 0;  ///< 超过单帧上限的帧
+    double encode_ms_per_frame = 0.0;
+    uint64_t roi_frames = 0;  ///< 带 ROI 的帧
+    uint64_t copy_rect_frames = 0;  ///< 带复制命令的帧
+  };
+
+  std::vector<Run> runs;
+
+  /// @brief 每次编码一行的文本表格
+  std::string Format() const;
+};
+
+Result<EncodeBenchmarkReport> RunEncodeBenchmark(
+    const EncodeBenchmarkConfig& config);
+
+}  // namespace zenremote
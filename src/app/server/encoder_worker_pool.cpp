@@ -0,0 +1,152 @@
+#include "app/server/encoder_worker_pool.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace zenremote {
+
+struct EncoderWorkerPool::Session {
+  std::deque<Job> pending;
+  bool running = false;  ///< 有任务正在某个线程执行
+  bool queued = false;   ///< 在就绪队列中
+  bool removed = false;
+  SessionStats stats;
+};
+
+EncoderWorkerPool::EncoderWorkerPool() : EncoderWorkerPool(Config{}) {}
+
+EncoderWorkerPool::EncoderWorkerPool(const Config& config) : config_(config) {
+  if (config_.threads == 0) {
+    config_.threads =
+        std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  config_.max_pending_per_session =
+      std::max<size_t>(config_.max_pending_per_session, 1);
+  for (size_t i = 0; i < config_.threads; ++i) {
+    threads_.emplace_back([this]() { Run(); });
+  }
+}
+
+EncoderWorkerPool::~EncoderWorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_stop_ = true;
+    ready_.clear();
+  }
+  work_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+EncoderWorkerPool::SessionId EncoderWorkerPool::AddSession() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const SessionId id = next_id_++;
+  sessions_.emplace(id, std::make_shared<Session>());
+  return id;
+}
+
+void EncoderWorkerPool::RemoveSession(SessionId id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto it = sessions_.find(id);
+  if (it == sessions_.end()) {
+    return;
+  }
+  auto session = it->second;
+  sessions_.erase(it);
+  session->removed = true;
+  session->pending.clear();
+  ready_.erase(std::remove(ready_.begin(), ready_.end(), session),
+               ready_.end());
+  idle_cv_.wait(lock, [&]() { return !session->running; });
+}
+
+Result<void> EncoderWorkerPool::Submit(SessionId id, Job job) {
+  if (!job) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter, "Empty job");
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+      return Result<void>::Err(ErrorCode::kInvalidParameter,
+                               "Unknown encoder session");
+    }
+    Session& session = *it->second;
+    session.stats.jobs_submitted++;
+    if (session.pending.size() >= config_.max_pending_per_session) {
+      session.pending.pop_front();
+      session.stats.jobs_dropped++;
+    }
+    session.pending.push_back(std::move(job));
+    if (session.running || session.queued) {
+      // 执行中的会话在任务结束后重新排队，不占第二个线程
+      return Result<void>::Ok();
+    }
+    session.queued = true;
+    ready_.push_back(it->second);
+  }
+  work_cv_.notify_one();
+  return Result<void>::Ok();
+}
+
+Result<EncoderWorkerPool::SessionStats> EncoderWorkerPool::GetSessionStats(
+    SessionId id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(id);
+  if (it == sessions_.end()) {
+    return Result<SessionStats>::Err(ErrorCode::kInvalidParameter,
+                                     "Unknown encoder session");
+  }
+  return Result<SessionStats>::Ok(it->second->stats);
+}
+
+EncoderWorkerPool::Stats EncoderWorkerPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.threads = threads_.size();
+  stats.sessions = sessions_.size();
+  stats.busy_time_us = busy_time_us_;
+  return stats;
+}
+
+void EncoderWorkerPool::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cv_.wait(lock, [this]() { return should_stop_ || !ready_.empty(); });
+    if (should_stop_) {
+      return;
+    }
+    auto session = ready_.front();
+    ready_.pop_front();
+    session->queued = false;
+    Job job = std::move(session->pending.front());
+    session->pending.pop_front();
+    session->running = true;
+
+    lock.unlock();
+    const auto start = std::chrono::steady_clock::now();
+    job();
+    const auto busy_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+    // 任务持有的资源（帧缓冲、会话引用）在解锁状态下释放
+    job = nullptr;
+    lock.lock();
+
+    session->running = false;
+    session->stats.jobs_completed++;
+    session->stats.busy_time_us += busy_us;
+    busy_time_us_ += busy_us;
+    if (session->removed) {
+      idle_cv_.notify_all();
+    } else if (!session->pending.empty() && !should_stop_) {
+      session->queued = true;
+      ready_.push_back(session);
+      work_cv_.notify_one();
+    }
+  }
+}
+
+}  // namespace zenremote
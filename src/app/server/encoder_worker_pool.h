@@ -0,0 +1,91 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/error.h"
+
+namespace zenremote {
+
+/**
+ * @brief 多个会话共享的有界编码线程池
+ *
+ * - 同一会话的任务串行、按提交顺序执行（编码器不可重入，帧须按序编码），
+ *   不同会话的任务在不同线程并行
+ * - 公平：有待执行任务的会话按轮转顺序排队，每次只取队首会话的一个任务，
+ *   执行完仍有积压则排到队尾；一个会话积压不会挤占其他会话
+ * - 有界：每个会话最多排队 max_pending_per_session 个任务，超出时丢弃最旧
+ *   的一个（实时画面新帧优先），计入 jobs_dropped
+ * - 记录每个会话任务的执行耗时，供 SessionManager 估算实际 CPU 占用
+ *
+ * 线程安全：所有方法可在任意线程调用；RemoveSession() 不能在该会话自己的
+ * 任务中调用。
+ */
+class EncoderWorkerPool {
+ public:
+  struct Config {
+    size_t threads = 0;  ///< 0 表示硬件线程数
+    size_t max_pending_per_session = 1;
+  };
+
+  using SessionId = uint64_t;
+  using Job = std::function<void()>;
+
+  struct SessionStats {
+    uint64_t jobs_submitted = 0;
+    uint64_t jobs_completed = 0;
+    uint64_t jobs_dropped = 0;  ///< 排队超限被丢弃
+    uint64_t busy_time_us = 0;  ///< 任务累计执行时间
+  };
+
+  struct Stats {
+    size_t threads = 0;
+    size_t sessions = 0;
+    uint64_t busy_time_us = 0;  ///< 所有会话（含已移除的）累计执行时间
+  };
+
+  EncoderWorkerPool();
+  explicit EncoderWorkerPool(const Config& config);
+  /// @brief 丢弃未执行的任务，等待执行中的任务返回
+  ~EncoderWorkerPool();
+
+  EncoderWorkerPool(const EncoderWorkerPool&) = delete;
+  EncoderWorkerPool& operator=(const EncoderWorkerPool&) = delete;
+
+  SessionId AddSession();
+
+  /// @brief 丢弃该会话排队的任务，并等待它正在执行的任务返回
+  void RemoveSession(SessionId id);
+
+  Result<void> Submit(SessionId id, Job job);
+
+  Result<SessionStats> GetSessionStats(SessionId id) const;
+  Stats GetStats() const;
+
+ private:
+  struct Session;
+
+  void Run();
+
+  Config config_;
+  std::vector<std::thread> threads_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;  ///< 有会话进入就绪队列或停止
+  std::condition_variable idle_cv_;  ///< 某个任务执行完毕
+  bool should_stop_ = false;
+  std::unordered_map<SessionId, std::shared_ptr<Session>> sessions_;
+  std::deque<std::shared_ptr<Session>> ready_;  ///< 有任务且未在执行的会话
+  SessionId next_id_ = 1;
+  uint64_t busy_time_us_ = 0;
+};
+
+}  // namespace zenremote
@@ -0,0 +1,304 @@
+#include "app/server/headless_host.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/server/encode_benchmark.h"
+#include "app/server/load_test.h"
+#include "app/server/session_manager.h"
+#include "app/server/synthetic_video_source.h"
+#include "common/log_manager.h"
+
+namespace zenremote {
+
+namespace {
+
+constexpr int kStatsIntervalSeconds = 5;
+
+std::atomic<bool> g_stop_requested{false};
+
+void OnStopSignal(int) {
+  g_stop_requested = true;
+}
+
+struct HeadlessOptions {
+  std::vector<ControllerSession::ViewerEndpoint> sessions;
+  size_t load_test_sessions = 0;
+  int encode_bench_frames = 0;
+  int roi_qp_delta = -6;
+  int bench_width = 1920;
+  int bench_height = 1080;
+  int tile_columns = 1;
+  int tile_rows = 1;
+  int latency_budget_ms = 50;
+  uint16_t base_port = 47600;
+  double duration_s = 10.0;
+
+  uint32_t framerate = 30;
+  uint32_t bitrate_bps = 2000000;
+  double session_cpu_cores = 0.25;
+  SyntheticVideoSource::Config source;
+  SessionManager::Config manager;
+};
+
+void PrintUsage() {
+  std::fprintf(
+      stderr,
+      "Usage: zenremote --headless (--session <ip:port>... | "
+      "--load-test <N> | --encode-bench <frames>) [options]\n"
+      "  --duration <s>  --base-port <port>  --fps <n>  --bitrate-kbps <n>\n"
+      "  --frame-bytes <n>  --encode-ms <ms>  --session-cpu <cores>\n"
+      "  --reactor-threads <n>  --encoder-threads <n>  --cpu-budget <cores>\n"
+      "  --bandwidth-mbps <n>  --roi-qp <delta>  --size <WxH>\n"
+      "  --tiles <CxR>  --latency-budget <ms>\n");
+}
+
+bool ParseEndpoint(const std::string& text,
+                   ControllerSession::ViewerEndpoint& endpoint) {
+  const size_t colon = text.rfind(':');
+  if (colon == std::string::npos || colon == 0) {
+    return false;
+  }
+  const long port = std::strtol(text.c_str() + colon + 1, nullptr, 10);
+  if (port <= 0 || port > 65535) {
+    return false;
+  }
+  endpoint.remote_ip = text.substr(0, colon);
+  endpoint.remote_port = static_cast<uint16_t>(port);
+  return true;
+}
+
+bool ParseGrid(const char* text, int& first, int& second) {
+  return std::sscanf(text, "%dx%d", &first, &second) == 2 && first > 0 &&
+         second > 0;
+}
+
+bool ParseOptions(int argc, char* argv[], HeadlessOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--headless") {
+      continue;
+    }
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Missing value for %s\n", arg.c_str());
+      return false;
+    }
+    const char* value = argv[++i];
+    const double number = std::strtod(value, nullptr);
+    if (arg == "--session") {
+      ControllerSession::ViewerEndpoint endpoint;
+      if (!ParseEndpoint(value, endpoint)) {
+        std::fprintf(stderr, "Invalid endpoint: %s\n", value);
+        return false;
+      }
+      options.sessions.push_back(endpoint);
+    } else if (arg == "--load-test") {
+      options.load_test_sessions = static_cast<size_t>(number);
+    } else if (arg == "--encode-bench") {
+      options.encode_bench_frames = static_cast<int>(number);
+    } else if (arg == "--size") {
+      if (!ParseGrid(value, options.bench_width, options.bench_height)) {
+        std::fprintf(stderr, "Invalid size: %s\n", value);
+        return false;
+      }
+    } else if (arg == "--tiles") {
+      if (!ParseGrid(value, options.tile_columns, options.tile_rows)) {
+        std::fprintf(stderr, "Invalid tile grid: %s\n", value);
+        return false;
+      }
+    } else if (arg == "--latency-budget") {
+      options.latency_budget_ms = static_cast<int>(number);
+    } else if (arg == "--roi-qp") {
+      options.roi_qp_delta = static_cast<int>(number);
+    } else if (arg == "--duration") {
+      options.duration_s = number;
+    } else if (arg == "--base-port") {
+      options.base_port = static_cast<uint16_t>(number);
+    } else if (arg == "--fps") {
+      options.framerate = static_cast<uint32_t>(number);
+    } else if (arg == "--bitrate-kbps") {
+      options.bitrate_bps = static_cast<uint32_t>(number * 1000);
+    } else if (arg == "--frame-bytes") {
+      options.source.frame_bytes = static_cast<size_t>(number);
+      options.source.keyframe_bytes = options.source.frame_bytes;
+    } else if (arg == "--encode-ms") {
+      options.source.encode_cost_ms = number;
+    } else if (arg == "--session-cpu") {
+      options.session_cpu_cores = number;
+    } else if (arg == "--reactor-threads") {
+      options.manager.reactor_threads = static_cast<size_t>(number);
+    } else if (arg == "--encoder-threads") {
+      options.manager.encoder_threads = static_cast<size_t>(number);
+    } else if (arg == "--cpu-budget") {
+      options.manager.cpu_budget_cores = number;
+    } else if (arg == "--bandwidth-mbps") {
+      options.manager.bandwidth_budget_bps =
+          static_cast<uint64_t>(number * 1000000);
+    } else {
+      std::fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+      return false;
+    }
+  }
+  const int modes = (options.sessions.empty() ? 0 : 1) +
+                    (options.load_test_sessions > 0 ? 1 : 0) +
+                    (options.encode_bench_frames > 0 ? 1 : 0);
+  if (modes != 1) {
+    std::fprintf(stderr,
+                 "Specify one of --session, --load-test or --encode-bench\n");
+    return false;
+  }
+  if (options.framerate == 0) {
+    std::fprintf(stderr, "--fps must be positive\n");
+    return false;
+  }
+  return true;
+}
+
+int RunLoadTestCommand(const HeadlessOptions& options) {
+  LoadTestConfig config;
+  config.sessions = options.load_test_sessions;
+  config.base_port = options.base_port;
+  config.duration = std::chrono::milliseconds(
+      static_cast<int64_t>(options.duration_s * 1000));
+  config.framerate = options.framerate;
+  config.bitrate_bps = options.bitrate_bps;
+  config.session_cpu_cores = options.session_cpu_cores;
+  config.source = options.source;
+  config.manager = options.manager;
+
+  auto report = RunLoadTest(config);
+  if (report.IsErr()) {
+    std::fprintf(stderr, "Load test failed: %s\n", report.Message().c_str());
+    return 1;
+  }
+  std::fputs(report.Value().Format().c_str(), stdout);
+  return 0;
+}
+
+int RunEncodeBenchmarkCommand(const HeadlessOptions& options) {
+  EncodeBenchmarkConfig config;
+  config.frames = options.encode_bench_frames;
+  config.framerate = static_cast<int>(options.framerate);
+  config.bitrate_bps = static_cast<int>(options.bitrate_bps);
+  config.roi_qp_delta = options.roi_qp_delta;
+  config.width = options.bench_width;
+  config.height = options.bench_height;
+  config.tile_columns = options.tile_columns;
+  config.tile_rows = options.tile_rows;
+  config.latency_budget_ms = options.latency_budget_ms;
+  config.threads = static_cast<int>(options.manager.encoder_threads);
+
+  auto report = RunEncodeBenchmark(config);
+  if (report.IsErr()) {
+    std::fprintf(stderr, "Encode benchmark failed: %s\n",
+                 report.Message().c_str());
+    return 1;
+  }
+  std::fputs(report.Value().Format().c_str(), stdout);
+  return 0;
+}
+
+void PrintSessionStats(const SessionManager& manager) {
+  for (SessionManager::SessionId id : manager.GetSessionIds()) {
+    auto stats = manager.GetSessionStats(id);
+    if (stats.IsErr()) {
+      continue;
+    }
+    const auto& value = stats.Value();
+    std::printf(
+        "%-24s sent %llu dropped %llu latency p50 %.2f p99 %.2f ms "
+        "cpu %.2f\n",
+        value.name.c_str(), static_cast<unsigned long long>(value.frames_sent),
+        static_cast<unsigned long long>(value.frames_dropped),
+        value.latency.p50_ms, value.latency.p99_ms, value.cpu_cores);
+  }
+  const auto stats = manager.GetStats();
+  std::printf("%zu sessions, CPU %.2f/%.2f cores, %llu rejected\n",
+              stats.sessions, stats.cpu_measured_cores, stats.cpu_budget_cores,
+              static_cast<unsigned long long>(stats.sessions_rejected));
+  std::fflush(stdout);
+}
+
+int RunSessionsCommand(const HeadlessOptions& options) {
+  SessionManager manager(options.manager);
+  auto result = manager.Start();
+  if (result.IsErr()) {
+    std::fprintf(stderr, "Failed to start: %s\n", result.Message().c_str());
+    return 1;
+  }
+
+  for (const auto& endpoint : options.sessions) {
+    SessionManager::SessionConfig config;
+    config.name =
+        endpoint.remote_ip + ":" + std::to_string(endpoint.remote_port);
+    config.controller.remote_ip = endpoint.remote_ip;
+    config.controller.remote_port = endpoint.remote_port;
+    config.controller.enable_audio = false;
+    config.controller.video_bitrate_bps = options.bitrate_bps;
+    config.controller.video_framerate = options.framerate;
+    config.source = std::make_shared<SyntheticVideoSource>(options.source);
+    config.cpu_cores = options.session_cpu_cores;
+    auto added = manager.AddSession(config);
+    if (added.IsErr()) {
+      std::fprintf(stderr, "Session %s not started: %s\n",
+                   config.name.c_str(), added.Message().c_str());
+    }
+  }
+  if (manager.GetSessionIds().empty()) {
+    return 1;
+  }
+
+  auto next_report = std::chrono::steady_clock::now() +
+                     std::chrono::seconds(kStatsIntervalSeconds);
+  while (!g_stop_requested) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (std::chrono::steady_clock::now() >= next_report) {
+      PrintSessionStats(manager);
+      next_report += std::chrono::seconds(kStatsIntervalSeconds);
+    }
+  }
+  manager.Stop();
+  return 0;
+}
+
+}  // namespace
+
+bool IsHeadlessCommandLine(int argc, char* argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--headless") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int RunHeadlessHost(int argc, char* argv[]) {
+  HeadlessOptions options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 2;
+  }
+  if (!LogManager::Initialize(LogManager::LogLevel::INFO)) {
+    return -1;
+  }
+  std::signal(SIGINT, OnStopSignal);
+  std::signal(SIGTERM, OnStopSignal);
+
+  ZENREMOTE_INFO("Starting ZenRemote headless host");
+  if (options.load_test_sessions > 0) {
+    return RunLoadTestCommand(options);
+  }
+  if (options.encode_bench_frames > 0) {
+    return RunEncodeBenchmarkCommand(options);
+  }
+  return RunSessionsCommand(options);
+}
+
+}  // namespace zenremote
@@ -0,0 +1,25 @@
+#pragma once
+
+namespace zenremote {
+
+/// @brief 命令行含 --headless 时返回 true（须在创建 QApplication 之前判断）
+bool IsHeadlessCommandLine(int argc, char* argv[]);
+
+/**
+ * @brief 无头主机入口：不创建窗口，不需要显示服务，可在 Linux 服务器上运行
+ *
+ *   --headless --session <ip:port> [--session ...]
+ *       为每个观看者建立一个会话，运行到 SIGINT/SIGTERM，定期打印统计
+ *   --headless --load-test <N> [--duration <秒>] [--base-port <端口>]
+ *       在本机回环上运行 N 个会话的压测，打印每个会话的延迟分位数
+ *
+ * 公共选项：--fps、--bitrate-kbps、--frame-bytes、--encode-ms、
+ * --session-cpu、--reactor-threads、--encoder-threads、--cpu-budget、
+ * --bandwidth-mbps。
+ *
+ * 会话使用 SyntheticVideoSource：此处没有 Linux 屏幕采集实现。
+ * @return 进程退出码
+ */
+int RunHeadlessHost(int argc, char* argv[]);
+
+}  // namespace zenremote
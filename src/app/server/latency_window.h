@@ -0,0 +1,69 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace zenremote {
+
+/**
+ * @brief 最近 capacity 个延迟样本的滑动窗口，报告分位数
+ *
+ * 不是线程安全的，由调用方加锁。
+ */
+class LatencyWindow {
+ public:
+  struct Summary {
+    size_t samples = 0;  ///< 窗口中的样本数
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+  };
+
+  explicit LatencyWindow(size_t capacity = 1024)
+      : capacity_(std::max<size_t>(capacity, 1)) {
+    samples_.reserve(capacity_);
+  }
+
+  void Add(double latency_ms) {
+    if (samples_.size() < capacity_) {
+      samples_.push_back(latency_ms);
+    } else {
+      samples_[next_] = latency_ms;
+    }
+    next_ = (next_ + 1) % capacity_;
+  }
+
+  Summary Summarize() const {
+    Summary summary;
+    summary.samples = samples_.size();
+    if (samples_.empty()) {
+      return summary;
+    }
+    std::vector<double> sorted = samples_;
+    std::sort(sorted.begin(), sorted.end());
+    // 最近秩法：第 ceil(p * n) 个样本
+    auto percentile = [&sorted](double p) {
+      const size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+      return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+    };
+    summary.p50_ms = percentile(0.50);
+    summary.p90_ms = percentile(0.90);
+    summary.p99_ms = percentile(0.99);
+    summary.max_ms = sorted.back();
+    return summary;
+  }
+
+  void Clear() {
+    samples_.clear();
+    next_ = 0;
+  }
+
+ private:
+  size_t capacity_;
+  std::vector<double> samples_;
+  size_t next_ = 0;
+};
+
+}  // namespace zenremote
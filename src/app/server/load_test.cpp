@@ -0,0 +1,184 @@
+#include "app/server/load_test.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "app/session/controlled_session.h"
+#include "common/log_manager.h"
+#include "network/connection/network_reactor.h"
+
+namespace zenremote {
+
+namespace {
+
+/// 接收端：统计收到的帧与端到端延迟（在接收反应器线程更新）
+struct Viewer {
+  ControlledSession session;
+  std::mutex mutex;
+  uint64_t frames_received = 0;
+  LatencyWindow latency;
+};
+
+uint64_t NowMicros() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+}  // namespace
+
+std::string LoadTestReport::Format() const {
+  std::string text;
+  char line[256];
+  std::snprintf(line, sizeof(line),
+                "%-12s %6s %6s %5s %8s %8s %8s %8s %8s %6s\n", "session",
+                "sent", "recv", "drop", "send.p50", "send.p99", "e2e.p50",
+                "e2e.p90", "e2e.p99", "cpu");
+  text += line;
+  for (const auto& session : sessions) {
+    if (!session.admitted) {
+      std::snprintf(line, sizeof(line), "%-12s rejected\n",
+                    session.name.c_str());
+      text += line;
+      continue;
+    }
+    std::snprintf(line, sizeof(line),
+                  "%-12s %6llu %6llu %5llu %8.2f %8.2f %8.2f %8.2f %8.2f "
+                  "%6.2f\n",
+                  session.name.c_str(),
+                  static_cast<unsigned long long>(session.frames_sent),
+                  static_cast<unsigned long long>(session.frames_received),
+                  static_cast<unsigned long long>(session.frames_dropped),
+                  session.send_latency.p50_ms, session.send_latency.p99_ms,
+                  session.end_to_end_latency.p50_ms,
+                  session.end_to_end_latency.p90_ms,
+                  session.end_to_end_latency.p99_ms, session.cpu_cores);
+    text += line;
+  }
+  std::snprintf(line, sizeof(line),
+                "%zu/%zu sessions admitted in %.1f s, CPU %.2f/%.2f cores, "
+                "reactor %llu wakeups\n",
+                sessions_admitted, sessions.size(), duration_s,
+                manager.cpu_measured_cores, manager.cpu_budget_cores,
+                static_cast<unsigned long long>(manager.reactor.wakeups));
+  text += line;
+  return text;
+}
+
+Result<LoadTestReport> RunLoadTest(const LoadTestConfig& config) {
+  if (config.sessions == 0 ||
+      config.base_port + config.sessions - 1 > UINT16_MAX) {
+    return Result<LoadTestReport>::Err(ErrorCode::kInvalidParameter,
+                                       "Invalid session count or port range");
+  }
+
+  NetworkReactor::Config viewer_reactor_config;
+  viewer_reactor_config.threads = config.viewer_reactor_threads;
+  auto viewer_reactor =
+      std::make_shared<NetworkReactor>(viewer_reactor_config);
+  auto result = viewer_reactor->Start();
+  if (result.IsErr()) {
+    return Result<LoadTestReport>::Err(result.Code(), result.Message());
+  }
+
+  // 接收端先就绪，发送端连接后的第一帧即可被收到
+  std::vector<std::unique_ptr<Viewer>> viewers;
+  for (size_t i = 0; i < config.sessions; ++i) {
+    auto viewer = std::make_unique<Viewer>();
+    Viewer* raw = viewer.get();
+    raw->session.SetOnVideoFrameCallback(
+        [raw](const uint8_t* data, size_t length, uint32_t) {
+          auto capture_us = SyntheticVideoSource::ReadCaptureTime(data, length);
+          std::lock_guard<std::mutex> lock(raw->mutex);
+          raw->frames_received++;
+          if (capture_us) {
+            raw->latency.Add(static_cast<double>(NowMicros() - *capture_us) /
+                             1000.0);
+          }
+        });
+    ControlledSession::Config viewer_config;
+    viewer_config.local_port = static_cast<uint16_t>(config.base_port + i);
+    viewer_config.reactor = viewer_reactor;
+    result = raw->session.Initialize(viewer_config);
+    viewers.push_back(std::move(viewer));
+    if (result.IsErr()) {
+      return Result<LoadTestReport>::Err(
+          result.Code(), "Viewer " + std::to_string(i) + ": " +
+                             result.Message());
+    }
+  }
+
+  SessionManager manager(config.manager);
+  result = manager.Start();
+  if (result.IsErr()) {
+    return Result<LoadTestReport>::Err(result.Code(), result.Message());
+  }
+
+  LoadTestReport report;
+  std::vector<SessionManager::SessionId> ids(config.sessions, 0);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < config.sessions; ++i) {
+    SessionManager::SessionConfig session_config;
+    session_config.name = "session-" + std::to_string(i);
+    session_config.controller.remote_ip = "127.0.0.1";
+    session_config.controller.remote_port =
+        static_cast<uint16_t>(config.base_port + i);
+    session_config.controller.enable_audio = false;
+    session_config.controller.video_bitrate_bps = config.bitrate_bps;
+    session_config.controller.video_framerate = config.framerate;
+    session_config.source =
+        std::make_shared<SyntheticVideoSource>(config.source);
+    session_config.cpu_cores = config.session_cpu_cores;
+
+    LoadTestReport::Session entry;
+    entry.name = session_config.name;
+    auto added = manager.AddSession(session_config);
+    if (added.IsOk()) {
+      entry.admitted = true;
+      ids[i] = added.Value();
+      report.sessions_admitted++;
+    } else if (added.Code() != ErrorCode::kResourceExhausted) {
+      return Result<LoadTestReport>::Err(added.Code(), added.Message());
+    }
+    report.sessions.push_back(entry);
+  }
+
+  std::this_thread::sleep_for(config.duration);
+
+  for (size_t i = 0; i < config.sessions; ++i) {
+    if (!report.sessions[i].admitted) {
+      continue;
+    }
+    auto stats = manager.GetSessionStats(ids[i]);
+    if (stats.IsOk()) {
+      auto& entry = report.sessions[i];
+      entry.frames_sent = stats.Value().frames_sent;
+      entry.frames_dropped = stats.Value().frames_dropped;
+      entry.send_latency = stats.Value().latency;
+      entry.cpu_cores = stats.Value().cpu_cores;
+    }
+  }
+  report.manager = manager.GetStats();
+  report.duration_s = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  manager.Stop();
+
+  // 发送端停止后再读接收端，在途的帧也计入
+  for (size_t i = 0; i < config.sessions; ++i) {
+    viewers[i]->session.Shutdown();
+    std::lock_guard<std::mutex> lock(viewers[i]->mutex);
+    report.sessions[i].frames_received = viewers[i]->frames_received;
+    report.sessions[i].end_to_end_latency = viewers[i]->latency.Summarize();
+  }
+  viewer_reactor->Stop();
+
+  ZENREMOTE_INFO("Load test finished: {}/{} sessions admitted",
+                 report.sessions_admitted, config.sessions);
+  return Result<LoadTestReport>::Ok(report);
+}
+
+}  // namespace zenremote
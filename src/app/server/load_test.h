@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "app/server/latency_window.h"
+#include "app/server/session_manager.h"
+#include "app/server/synthetic_video_source.h"
+#include "common/error.h"
+
+namespace zenremote {
+
+/**
+ * @brief 多会话压测配置
+ *
+ * 在本机回环上启动 sessions 个 ControlledSession 接收端（端口
+ * base_port + i，共享一个接收反应器），再由 SessionManager 为每个接收端
+ * 建立一个合成来源的会话，运行 duration 后汇总。
+ */
+struct LoadTestConfig {
+  size_t sessions = 4;
+  uint16_t base_port = 47600;
+  std::chrono::milliseconds duration{5000};
+
+  uint32_t framerate = 30;
+  uint32_t bitrate_bps = 2000000;  ///< 准入用的会话码率
+  double session_cpu_cores = 0.1;  ///< 每个会话声明的 CPU（核）
+  SyntheticVideoSource::Config source;
+
+  SessionManager::Config manager;
+  size_t viewer_reactor_threads = 1;
+};
+
+struct LoadTestReport {
+  struct Session {
+    std::string name;
+    bool admitted = false;
+    uint64_t frames_sent = 0;
+    uint64_t frames_received = 0;
+    uint64_t frames_dropped = 0;  ///< 编码排队超限
+    LatencyWindow::Summary send_latency;  ///< 调度到发送完成
+    /// 调度到接收端收到（同一主机的 steady_clock）
+    LatencyWindow::Summary end_to_end_latency;
+    double cpu_cores = 0.0;
+  };
+
+  std::vector<Session> sessions;
+  size_t sessions_admitted = 0;
+  double duration_s = 0.0;
+  SessionManager::Stats manager;
+
+  /// @brief 每个会话一行的文本表格
+  std::string Format() const;
+};
+
+Result<LoadTestReport> RunLoadTest(const LoadTestConfig& config);
+
+}  // namespace zenremote
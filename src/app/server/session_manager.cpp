@@ -0,0 +1,381 @@
+#include "app/server/session_manager.h"
+
+#include <algorithm>
+
+#include "common/log_manager.h"
+
+namespace zenremote {
+
+namespace {
+
+uint64_t ToMicros(std::chrono::steady_clock::time_point time) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          time.time_since_epoch())
+          .count());
+}
+
+}  // namespace
+
+struct SessionManager::Session {
+  SessionId id = 0;
+  std::string name;
+  std::shared_ptr<SessionVideoSource> source;
+  std::unique_ptr<ControllerSession> controller;
+  EncoderWorkerPool::SessionId pool_id = 0;
+  double declared_cpu_cores = 0.0;
+  uint64_t bandwidth_bps = 0;
+
+  // 以下由 mutex_ 保护（帧时钟线程）
+  std::chrono::microseconds frame_interval{0};
+  std::chrono::steady_clock::time_point next_frame;
+  uint64_t measured_busy_us = 0;  ///< 上次测量时的累计编码耗时
+  double measured_cpu_cores = 0.0;
+
+  // 以下由 stats_mutex 保护（编码线程）
+  std::mutex stats_mutex;
+  SessionStats stats;
+  LatencyWindow latency;
+};
+
+SessionManager::SessionManager() : SessionManager(Config{}) {}
+
+SessionManager::SessionManager(const Config& config) : config_(config) {
+  config_.reactor_threads = std::max<size_t>(config_.reactor_threads, 1);
+  config_.cpu_measure_interval_ms =
+      std::max<uint32_t>(config_.cpu_measure_interval_ms, 1);
+}
+
+SessionManager::~SessionManager() {
+  Stop();
+}
+
+Result<void> SessionManager::Start() {
+  if (running_) {
+    return Result<void>::Err(ErrorCode::kAlreadyRunning,
+                             "SessionManager already running");
+  }
+
+  NetworkReactor::Config reactor_config;
+  reactor_config.threads = config_.reactor_threads;
+  reactor_ = std::make_shared<NetworkReactor>(reactor_config);
+  auto result = reactor_->Start();
+  if (result.IsErr()) {
+    reactor_.reset();
+    return result;
+  }
+
+  EncoderWorkerPool::Config pool_config;
+  pool_config.threads = config_.encoder_threads;
+  pool_config.max_pending_per_session = config_.max_pending_frames;
+  pool_ = std::make_unique<EncoderWorkerPool>(pool_config);
+  if (config_.cpu_budget_cores <= 0.0) {
+    config_.cpu_budget_cores =
+        static_cast<double>(pool_->GetStats().threads);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_stop_ = false;
+  }
+  clock_thread_ = std::thread([this]() { RunFrameClock(); });
+  running_ = true;
+
+  ZENREMOTE_INFO(
+      "SessionManager started: {} reactor threads, {} encoder threads, "
+      "budget {:.2f} cores / {} bps",
+      config_.reactor_threads, pool_->GetStats().threads,
+      config_.cpu_budget_cores, config_.bandwidth_budget_bps);
+  return Result<void>::Ok();
+}
+
+void SessionManager::Stop() {
+  if (!running_) {
+    return;
+  }
+  for (SessionId id : GetSessionIds()) {
+    RemoveSession(id);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_stop_ = true;
+  }
+  clock_cv_.notify_all();
+  if (clock_thread_.joinable()) {
+    clock_thread_.join();
+  }
+  pool_.reset();
+  reactor_->Stop();
+  reactor_.reset();
+  running_ = false;
+  ZENREMOTE_INFO("SessionManager stopped");
+}
+
+Result<SessionManager::SessionId> SessionManager::AddSession(
+    const SessionConfig& config) {
+  if (!running_) {
+    return Result<SessionId>::Err(ErrorCode::kNotRunning,
+                                  "SessionManager not running");
+  }
+  if (!config.source || !config.controller.enable_video ||
+      config.controller.video_framerate == 0) {
+    return Result<SessionId>::Err(
+        ErrorCode::kInvalidParameter,
+        "Session needs a video source and a non-zero framerate");
+  }
+
+  std::lock_guard<std::mutex> admission_lock(admission_mutex_);
+  const uint64_t bandwidth_bps = SessionBandwidth(config.controller);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double committed_cpu = CommittedCpuLocked();
+    if (committed_cpu + config.cpu_cores > config_.cpu_budget_cores) {
+      sessions_rejected_++;
+      ZENREMOTE_WARN("Session '{}' rejected: CPU {:.2f} + {:.2f} > {:.2f}",
+                     config.name, committed_cpu, config.cpu_cores,
+                     config_.cpu_budget_cores);
+      return Result<SessionId>::Err(ErrorCode::kResourceExhausted,
+                                    "CPU budget exceeded");
+    }
+    const uint64_t committed_bandwidth = CommittedBandwidthLocked();
+    if (committed_bandwidth + bandwidth_bps > config_.bandwidth_budget_bps) {
+      sessions_rejected_++;
+      ZENREMOTE_WARN("Session '{}' rejected: bandwidth {} + {} > {} bps",
+                     config.name, committed_bandwidth, bandwidth_bps,
+                     config_.bandwidth_budget_bps);
+      return Result<SessionId>::Err(ErrorCode::kResourceExhausted,
+                                    "Bandwidth budget exceeded");
+    }
+  }
+
+  auto session = std::make_shared<Session>();
+  session->name = config.name;
+  session->source = config.source;
+  session->declared_cpu_cores = config.cpu_cores;
+  session->bandwidth_bps = bandwidth_bps;
+  session->stats.name = config.name;
+  session->frame_interval =
+      std::chrono::microseconds(1000000 / config.controller.video_framerate);
+
+  ControllerSession::Config controller_config = config.controller;
+  controller_config.reactor = reactor_;
+  session->controller = std::make_unique<ControllerSession>();
+  std::weak_ptr<SessionVideoSource> weak_source = config.source;
+  session->controller->SetOnKeyFrameRequestCallback([weak_source]() {
+    if (auto source = weak_source.lock()) {
+      source->ForceKeyFrame();
+    }
+  });
+  auto result = session->controller->Initialize(controller_config);
+  if (result.IsErr()) {
+    session->controller->Shutdown();
+    return Result<SessionId>::Err(result.Code(), "Session '" + config.name +
+                                                     "': " + result.Message());
+  }
+
+  session->pool_id = pool_->AddSession();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    session->id = next_id_++;
+    session->next_frame = std::chrono::steady_clock::now();
+    sessions_.emplace(session->id, session);
+  }
+  clock_cv_.notify_all();
+
+  ZENREMOTE_INFO("Session '{}' added (id {}, {:.2f} cores, {} bps)",
+                 session->name, session->id, session->declared_cpu_cores,
+                 session->bandwidth_bps);
+  return Result<SessionId>::Ok(session->id);
+}
+
+void SessionManager::RemoveSession(SessionId id) {
+  std::lock_guard<std::mutex> admission_lock(admission_mutex_);
+  std::shared_ptr<Session> session;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+      return;
+    }
+    session = it->second;
+    sessions_.erase(it);
+  }
+  // 帧时钟不再调度它；丢弃排队的帧并等待正在编码的帧发送完
+  pool_->RemoveSession(session->pool_id);
+  session->controller->Shutdown();
+  ZENREMOTE_INFO("Session '{}' removed", session->name);
+}
+
+Result<SessionManager::SessionStats> SessionManager::GetSessionStats(
+    SessionId id) const {
+  std::shared_ptr<Session> session;
+  double cpu_cores = 0.0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sessions_.find(id);
+    if (it == sessions_.end()) {
+      return Result<SessionStats>::Err(ErrorCode::kInvalidParameter,
+                                       "Unknown session");
+    }
+    session = it->second;
+    cpu_cores = session->measured_cpu_cores;
+  }
+
+  SessionStats stats;
+  {
+    std::lock_guard<std::mutex> lock(session->stats_mutex);
+    stats = session->stats;
+    stats.latency = session->latency.Summarize();
+  }
+  stats.cpu_cores = cpu_cores;
+  auto pool_stats = pool_->GetSessionStats(session->pool_id);
+  if (pool_stats.IsOk()) {
+    stats.frames_dropped = pool_stats.Value().jobs_dropped;
+  }
+  return Result<SessionStats>::Ok(stats);
+}
+
+std::vector<SessionManager::SessionId> SessionManager::GetSessionIds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<SessionId> ids;
+  ids.reserve(sessions_.size());
+  for (const auto& entry : sessions_) {
+    ids.push_back(entry.first);
+  }
+  return ids;
+}
+
+SessionManager::Stats SessionManager::GetStats() const {
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.sessions = sessions_.size();
+    stats.sessions_rejected = sessions_rejected_;
+    stats.cpu_budget_cores = config_.cpu_budget_cores;
+    stats.cpu_committed_cores = CommittedCpuLocked();
+    stats.bandwidth_committed_bps = CommittedBandwidthLocked();
+    for (const auto& entry : sessions_) {
+      stats.cpu_measured_cores += entry.second->measured_cpu_cores;
+    }
+  }
+  if (reactor_) {
+    stats.reactor = reactor_->GetStats();
+  }
+  return stats;
+}
+
+uint64_t SessionManager::SessionBandwidth(
+    const ControllerSession::Config& config) {
+  const uint64_t viewers =
+      std::max<size_t>(config.broadcast_viewers.size(), 1);
+  return static_cast<uint64_t>(config.video_bitrate_bps) * viewers;
+}
+
+double SessionManager::CommittedCpuLocked() const {
+  double committed = 0.0;
+  for (const auto& entry : sessions_) {
+    const Session& session = *entry.second;
+    committed +=
+        std::max(session.declared_cpu_cores, session.measured_cpu_cores);
+  }
+  return committed;
+}
+
+uint64_t SessionManager::CommittedBandwidthLocked() const {
+  uint64_t committed = 0;
+  for (const auto& entry : sessions_) {
+    committed += entry.second->bandwidth_bps;
+  }
+  return committed;
+}
+
+void SessionManager::RunFrameClock() {
+  const auto measure_interval =
+      std::chrono::milliseconds(config_.cpu_measure_interval_ms);
+  auto last_measure = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!should_stop_) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_measure >= measure_interval) {
+      MeasureCpuLocked(now - last_measure);
+      last_measure = now;
+    }
+
+    auto wake = last_measure + measure_interval;
+    for (auto& entry : sessions_) {
+      auto session = entry.second;
+      if (session->next_frame <= now) {
+        const auto capture_time = now;
+        auto submitted = pool_->Submit(
+            session->pool_id, [this, session, capture_time]() {
+              EncodeAndSend(*session, capture_time);
+            });
+        if (submitted.IsOk()) {
+          std::lock_guard<std::mutex> stats_lock(session->stats_mutex);
+          session->stats.frames_scheduled++;
+        }
+        // 落后超过一帧时不补发，从现在重新计时
+        session->next_frame += session->frame_interval;
+        if (session->next_frame <= now) {
+          session->next_frame = now + session->frame_interval;
+        }
+      }
+      wake = std::min(wake, session->next_frame);
+    }
+    clock_cv_.wait_until(lock, wake);
+  }
+}
+
+void SessionManager::MeasureCpuLocked(
+    std::chrono::steady_clock::duration elapsed) {
+  const double elapsed_us = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  for (auto& entry : sessions_) {
+    Session& session = *entry.second;
+    auto stats = pool_->GetSessionStats(session.pool_id);
+    if (stats.IsErr()) {
+      continue;
+    }
+    const uint64_t busy_us = stats.Value().busy_time_us;
+    session.measured_cpu_cores =
+        static_cast<double>(busy_us - session.measured_busy_us) / elapsed_us;
+    session.measured_busy_us = busy_us;
+  }
+}
+
+void SessionManager::EncodeAndSend(
+    Session& session,
+    std::chrono::steady_clock::time_point capture_time) {
+  const uint64_t capture_us = ToMicros(capture_time);
+  SessionVideoSource::Frame frame;
+  auto encoded = session.source->EncodeFrame(capture_us, frame);
+  if (encoded.IsErr() || !encoded.Value()) {
+    std::lock_guard<std::mutex> lock(session.stats_mutex);
+    if (encoded.IsErr()) {
+      session.stats.encode_errors++;
+    } else {
+      session.stats.frames_skipped++;
+    }
+    return;
+  }
+
+  // RTP 视频时钟 90kHz
+  const auto timestamp_90khz = static_cast<uint32_t>(capture_us * 9 / 100);
+  auto sent = session.controller->SendVideoFrame(
+      frame.data.data(), frame.data.size(), timestamp_90khz,
+      frame.is_keyframe, frame.temporal_id);
+  const double latency_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - capture_time)
+                                .count();
+
+  std::lock_guard<std::mutex> lock(session.stats_mutex);
+  if (sent.IsErr()) {
+    session.stats.send_errors++;
+    return;
+  }
+  session.stats.frames_sent++;
+  session.latency.Add(latency_ms);
+}
+
+}  // namespace zenremote
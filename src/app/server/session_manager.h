@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "app/server/encoder_worker_pool.h"
+#include "app/server/latency_window.h"
+#include "app/session/controller_session.h"
+#include "common/error.h"
+#include "network/connection/network_reactor.h"
+
+namespace zenremote {
+
+/**
+ * @brief 会话的视频来源：采集并编码一帧
+ *
+ * EncodeFrame() 在编码线程池中调用，同一来源的调用串行、按帧序执行，
+ * 但可能落在不同线程上。
+ */
+class SessionVideoSource {
+ public:
+  struct Frame {
+    std::vector<uint8_t> data;
+    bool is_keyframe = false;
+    uint8_t temporal_id = 0;
+  };
+
+  virtual ~SessionVideoSource() = default;
+
+  /**
+   * @param capture_time_us 本帧的调度时刻（steady_clock 微秒）
+   * @return false 表示本次没有输出（画面未变化或编码器仍在缓冲）
+   */
+  virtual Result<bool> EncodeFrame(uint64_t capture_time_us, Frame& frame) = 0;
+
+  /// @brief 观看者请求关键帧；可能在网络线程调用，应只设置标志
+  virtual void ForceKeyFrame() = 0;
+};
+
+/**
+ * @brief 多会话主机：一个进程同时服务多个控制端会话
+ *
+ * - 所有会话的连接在共享的 NetworkReactor 上接收，线程数不随会话增长
+ * - 帧时钟线程按各会话的帧率把编码任务提交到共享的 EncoderWorkerPool，
+ *   线程池在会话之间轮转；编码跟不上时丢弃最旧的待编码帧而不是积压
+ * - 准入：新会话声明的 CPU（核）与码率加上已有会话的占用超出预算时
+ *   以 kResourceExhausted 拒绝。已有会话的 CPU 占用取声明值与最近一个
+ *   测量周期实测值（编码任务耗时）中的较大者
+ * - 统计每个会话从调度到发送完成（排队 + 编码 + 打包）的延迟分位数
+ *
+ * 不依赖窗口系统，可在无头服务器上运行（见 headless_host.h）。
+ * 线程安全：Start/Stop 在同一控制线程调用，其他方法可在任意线程调用。
+ */
+class SessionManager {
+ public:
+  struct Config {
+    size_t reactor_threads = 1;
+    size_t encoder_threads = 0;  ///< 0 表示硬件线程数
+    /// 每个会话排队等待编码的帧数上限
+    size_t max_pending_frames = 1;
+    /// CPU 预算（核），0 表示编码线程数
+    double cpu_budget_cores = 0.0;
+    uint64_t bandwidth_budget_bps = 1000000000;
+    uint32_t cpu_measure_interval_ms = 1000;
+  };
+
+  using SessionId = uint64_t;
+
+  struct SessionConfig {
+    std::string name;
+    /// 会话的连接与媒体参数；reactor 由 SessionManager 填写
+    ControllerSession::Config controller;
+    std::shared_ptr<SessionVideoSource> source;
+    /// 预计的编码 CPU 占用（核），用于准入
+    double cpu_cores = 0.25;
+  };
+
+  struct SessionStats {
+    std::string name;
+    uint64_t frames_scheduled = 0;
+    uint64_t frames_sent = 0;
+    uint64_t frames_skipped = 0;  ///< 来源没有输出
+    uint64_t frames_dropped = 0;  ///< 编码排队超限被丢弃
+    uint64_t encode_errors = 0;
+    uint64_t send_errors = 0;
+    /// 调度到发送完成（排队 + 编码 + 打包）
+    LatencyWindow::Summary latency;
+    double cpu_cores = 0.0;  ///< 最近一个测量周期的实测值
+  };
+
+  struct Stats {
+    size_t sessions = 0;
+    uint64_t sessions_rejected = 0;
+    double cpu_budget_cores = 0.0;
+    double cpu_committed_cores = 0.0;  ///< 各会话 max(声明, 实测) 之和
+    double cpu_measured_cores = 0.0;
+    uint64_t bandwidth_committed_bps = 0;
+    NetworkReactor::Stats reactor;
+  };
+
+  SessionManager();
+  explicit SessionManager(const Config& config);
+  ~SessionManager();
+
+  SessionManager(const SessionManager&) = delete;
+  SessionManager& operator=(const SessionManager&) = delete;
+
+  Result<void> Start();
+  /// @brief 关闭所有会话并停止线程
+  void Stop();
+  bool IsRunning() const { return running_; }
+
+  /// @brief 准入检查通过后连接会话并开始按帧率编码发送
+  Result<SessionId> AddSession(const SessionConfig& config);
+  void RemoveSession(SessionId id);
+
+  Result<SessionStats> GetSessionStats(SessionId id) const;
+  std::vector<SessionId> GetSessionIds() const;
+  Stats GetStats() const;
+
+ private:
+  struct Session;
+
+  /// @brief 会话的码率预算：视频码率 × 观看者数
+  static uint64_t SessionBandwidth(const ControllerSession::Config& config);
+  double CommittedCpuLocked() const;
+  uint64_t CommittedBandwidthLocked() const;
+
+  void RunFrameClock();
+  void MeasureCpuLocked(std::chrono::steady_clock::duration elapsed);
+  void EncodeAndSend(Session& session,
+                     std::chrono::steady_clock::time_point capture_time);
+
+  Config config_;
+  std::atomic<bool> running_{false};
+  std::shared_ptr<NetworkReactor> reactor_;
+  std::unique_ptr<EncoderWorkerPool> pool_;
+
+  /// 串行化 AddSession/RemoveSession，准入检查到加入之间预算不被并发占用
+  std::mutex admission_mutex_;
+
+  mutable std::mutex mutex_;  ///< 保护 sessions_ 与帧时钟
+  std::condition_variable clock_cv_;
+  bool should_stop_ = false;
+  std::thread clock_thread_;
+  std::map<SessionId, std::shared_ptr<Session>> sessions_;
+  SessionId next_id_ = 1;
+  uint64_t sessions_rejected_ = 0;
+};
+
+}  // namespace zenremote
@@ -0,0 +1,72 @@
+#include "app/server/synthetic_video_source.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace zenremote {
+
+namespace {
+
+void WriteLittleEndian64(uint64_t value, uint8_t* out) {
+  for (size_t i = 0; i < 8; ++i) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint64_t ReadLittleEndian64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+SyntheticVideoSource::SyntheticVideoSource()
+    : SyntheticVideoSource(Config{}) {}
+
+SyntheticVideoSource::SyntheticVideoSource(const Config& config)
+    : config_(config) {
+  config_.frame_bytes = std::max(config_.frame_bytes, kHeaderSize);
+  config_.keyframe_bytes = std::max(config_.keyframe_bytes, kHeaderSize);
+}
+
+Result<bool> SyntheticVideoSource::EncodeFrame(uint64_t capture_time_us,
+                                               Frame& frame) {
+  const bool periodic_keyframe =
+      config_.keyframe_interval > 0 &&
+      frame_index_ % config_.keyframe_interval == 0;
+  frame.is_keyframe = force_keyframe_.exchange(false) || periodic_keyframe;
+  frame.temporal_id = 0;
+  frame.data.resize(frame.is_keyframe ? config_.keyframe_bytes
+                                      : config_.frame_bytes);
+
+  // 模拟编码耗时：反复生成负载直到用完预算，至少生成一遍
+  const auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double, std::milli>(config_.encode_cost_ms));
+  do {
+    for (size_t i = kHeaderSize; i < frame.data.size(); ++i) {
+      state_ = state_ * 1664525U + 1013904223U;
+      frame.data[i] = static_cast<uint8_t>(state_ >> 24U);
+    }
+  } while (std::chrono::steady_clock::now() < deadline);
+
+  WriteLittleEndian64(capture_time_us, frame.data.data());
+  WriteLittleEndian64(frame_index_, frame.data.data() + 8);
+  frame_index_++;
+  return Result<bool>::Ok(true);
+}
+
+std::optional<uint64_t> SyntheticVideoSource::ReadCaptureTime(
+    const uint8_t* data,
+    size_t length) {
+  if (!data || length < kHeaderSize) {
+    return std::nullopt;
+  }
+  return ReadLittleEndian64(data);
+}
+
+}  // namespace zenremote
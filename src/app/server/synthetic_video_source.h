@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "app/server/session_manager.h"
+
+namespace zenremote {
+
+/**
+ * @brief 合成视频来源（无头模式与压测）
+ *
+ * 不采集屏幕，也不调用编码器：按配置的帧大小生成数据，并以忙等模拟每帧的
+ * 编码耗时（占用编码线程的 CPU）。帧头 kHeaderSize 字节写入调度时刻与帧序号，
+ * 同一主机上的接收端用 ReadCaptureTime() 计算端到端延迟。
+ */
+class SyntheticVideoSource : public SessionVideoSource {
+ public:
+  struct Config {
+    size_t frame_bytes = 1200;
+    size_t keyframe_bytes = 1200;
+    double encode_cost_ms = 1.0;
+    uint32_t keyframe_interval = 60;  ///< 0 表示只有请求时才出关键帧
+  };
+
+  /// 调度时刻（8）+ 帧序号（8），小端序
+  static constexpr size_t kHeaderSize = 16;
+
+  SyntheticVideoSource();
+  explicit SyntheticVideoSource(const Config& config);
+
+  Result<bool> EncodeFrame(uint64_t capture_time_us, Frame& frame) override;
+  void ForceKeyFrame() override { force_keyframe_ = true; }
+
+  /// @brief 从接收到的帧中读取调度时刻（steady_clock 微秒）
+  static std::optional<uint64_t> ReadCaptureTime(const uint8_t* data,
+                                                 size_t length);
+
+ private:
+  Config config_;
+  uint64_t frame_index_ = 0;
+  uint32_t state_ = 1;  ///< 填充数据的伪随机状态
+  std::atomic<bool> force_keyframe_{true};
+};
+
+}  // namespace zenremote
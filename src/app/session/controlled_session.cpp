@@ -43,6 +43,7 @@ Result<void> ControlledSession::Initialize(const Config& config) {
   PeerConnection::Config pc_config;
   pc_config.mode = PeerConnection::ConnectionMode::kDirect;
   pc_config.local_port = config_.local_port;
+  pc_config.reactor = config_.reactor;
 
   auto result = peer_connection_->Initialize(pc_config);
   if (result.IsErr()) {
@@ -136,12 +137,31 @@ Result<void> ControlledSession::SendKeyEvent(uint32_t key_code,
                               sizeof(event));
 }
 
+Result<void> ControlledSession::RequestKeyFrame() {
+  const uint32_t ssrc = video_ssrc_.load();
+  if (!peer_connection_ || ssrc == 0) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "Video track not received yet");
+  }
+  return peer_connection_->RequestKeyFrame(ssrc);
+}
+
+Result<void> ControlledSession::SendBandwidthEstimate(uint64_t bitrate_bps) {
+  const uint32_t ssrc = video_ssrc_.load();
+  if (!peer_connection_ || ssrc == 0) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "Video track not received yet");
+  }
+  return peer_connection_->SendBandwidthEstimate(ssrc, bitrate_bps);
+}
+
 void ControlledSession::OnRemoteTrackAdded(std::shared_ptr<MediaTrack> track) {
   ZENREMOTE_INFO(
       "Remote track added: {}, kind: {}", track->GetId(),
       track->GetKind() == MediaTrack::Kind::kVideo ? "video" : "audio");
 
   if (track->GetKind() == MediaTrack::Kind::kVideo) {
+    video_ssrc_ = track->GetSSRC();
     track->SetOnFrameCallback(
         [this](const uint8_t* data, size_t len, uint32_t ts) {
           if (on_video_frame_callback_) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -19,6 +20,8 @@ class ControlledSession {
  public:
   struct Config {
     uint16_t local_port = 50000;
+    /// 共享的接收反应器，为空时使用独立的接收线程
+    std::shared_ptr<NetworkReactor> reactor;
   };
 
   ControlledSession();
@@ -33,6 +36,12 @@ class ControlledSession {
                             bool is_down,
                             uint32_t modifiers);
 
+  /// @brief 解码出错后请求被控端发送关键帧（RTCP PLI）
+  Result<void> RequestKeyFrame();
+
+  /// @brief 报告本端的接收带宽估计（RTCP REMB），发送端据此丢弃高时间层
+  Result<void> SendBandwidthEstimate(uint64_t bitrate_bps);
+
   using OnVideoFrameCallback =
       std::function<void(const uint8_t*, size_t, uint32_t)>;
   using OnAudioPacketCallback =
@@ -53,6 +62,7 @@ class ControlledSession {
   Config config_;
   std::unique_ptr<PeerConnection> peer_connection_;
   std::shared_ptr<DataChannel> input_channel_;
+  std::atomic<uint32_t> video_ssrc_{0};  ///< 远端视频轨道，收到首包后设置
 
   OnVideoFrameCallback on_video_frame_callback_;
   OnAudioPacketCallback on_audio_packet_callback_;
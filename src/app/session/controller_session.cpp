@@ -13,20 +13,12 @@ ControllerSession::~ControllerSession() {
 Result<void> ControllerSession::Initialize(const Config& config) {
   config_ = config;
 
-  peer_connection_ = std::make_unique<PeerConnection>();
-
-  PeerConnection::Config pc_config;
-  pc_config.mode = PeerConnection::ConnectionMode::kDirect;
-  pc_config.remote_ip = config_.remote_ip;
-  pc_config.remote_port = config_.remote_port;
-
-  auto result = peer_connection_->Initialize(pc_config);
-  if (result.IsErr()) {
-    return Result<void>::Err(
-        ErrorCode::kPeerConnectionError,
-        "Failed to initialize PeerConnection: " + result.Message());
+  if (!config_.broadcast_viewers.empty()) {
+    return InitializeBroadcast();
   }
 
+  peer_connection_ = std::make_unique<PeerConnection>();
+
   if (config_.enable_video) {
     VideoTrack::Config video_config;
     video_config.id = "video0";
@@ -35,12 +27,6 @@ Result<void> ControllerSession::Initialize(const Config& config) {
     video_config.framerate = config_.video_framerate;
 
     video_track_ = std::make_shared<VideoTrack>(video_config);
-    auto add_result = peer_connection_->AddTrack(video_track_);
-    if (add_result.IsErr()) {
-      return Result<void>::Err(
-          ErrorCode::kVideoTrackError,
-          "Failed to add video track: " + add_result.Message());
-    }
   }
 
   if (config_.enable_audio) {
@@ -50,7 +36,97 @@ Result<void> ControllerSession::Initialize(const Config& config) {
     audio_config.sample_rate = config_.audio_sample_rate;
 
     audio_track_ = std::make_shared<AudioTrack>(audio_config);
-    auto add_result = peer_connection_->AddTrack(audio_track_);
+  }
+
+  auto result = ConnectPeer(*peer_connection_, config_.remote_ip,
+                            config_.remote_port, video_track_, audio_track_,
+                            input_channel_);
+  if (result.IsErr()) {
+    return result;
+  }
+
+  ZENREMOTE_INFO("ControllerSession initialized and connected");
+  return Result<void>::Ok();
+}
+
+Result<void> ControllerSession::InitializeBroadcast() {
+  if (config_.enable_video) {
+    MediaBroadcaster::Config broadcast_config;
+    broadcast_config.payload_type = VideoTrack::kPayloadType;
+    broadcast_config.temporal_layers = config_.video_temporal_layers;
+    broadcaster_ = std::make_shared<MediaBroadcaster>(broadcast_config);
+    broadcaster_->SetOnKeyFrameRequestCallback([this]() {
+      if (on_keyframe_request_callback_) {
+        on_keyframe_request_callback_();
+      }
+    });
+  }
+
+  for (size_t i = 0; i < config_.broadcast_viewers.size(); ++i) {
+    const auto& endpoint = config_.broadcast_viewers[i];
+    Viewer viewer;
+    viewer.peer_connection = std::make_unique<PeerConnection>();
+    if (broadcaster_) {
+      viewer.video_track = broadcaster_->CreateTrack("video0");
+    }
+    if (config_.enable_audio) {
+      // 音频码率低，每个观看者一个轨道即可，编码仍只有一路
+      AudioTrack::Config audio_config;
+      audio_config.id = "audio0";
+      audio_config.codec = "Opus";
+      audio_config.sample_rate = config_.audio_sample_rate;
+      viewer.audio_track = std::make_shared<AudioTrack>(audio_config);
+    }
+
+    auto result = ConnectPeer(*viewer.peer_connection, endpoint.remote_ip,
+                              endpoint.remote_port, viewer.video_track,
+                              viewer.audio_track, viewer.input_channel);
+    viewers_.push_back(std::move(viewer));
+    if (result.IsErr()) {
+      return Result<void>::Err(result.Code(),
+                               "Viewer " + std::to_string(i) + " (" +
+                                   endpoint.remote_ip + "): " +
+                                   result.Message());
+    }
+  }
+
+  ZENREMOTE_INFO("ControllerSession broadcasting to {} viewers",
+                 viewers_.size());
+  return Result<void>::Ok();
+}
+
+Result<void> ControllerSession::ConnectPeer(
+    PeerConnection& peer_connection,
+    const std::string& remote_ip,
+    uint16_t remote_port,
+    std::shared_ptr<MediaTrack> video_track,
+    std::shared_ptr<AudioTrack> audio_track,
+    std::shared_ptr<DataChannel>& input_channel) {
+  PeerConnection::Config pc_config;
+  pc_config.mode = PeerConnection::ConnectionMode::kDirect;
+  pc_config.remote_ip = remote_ip;
+  pc_config.remote_port = remote_port;
+  pc_config.reactor = config_.reactor;
+  pc_config.controlling = true;
+
+  auto result = peer_connection.Initialize(pc_config);
+  if (result.IsErr()) {
+    return Result<void>::Err(
+        ErrorCode::kPeerConnectionError,
+        "Failed to initialize PeerConnection: " + result.Message());
+  }
+
+  if (video_track) {
+    auto add_result = peer_connection.AddTrack(video_track);
+    if (add_result.IsErr()) {
+      return Result<void>::Err(
+          ErrorCode::kVideoTrackError,
+          "Failed to add video track: " + add_result.Message());
+    }
+  }
+
+  if (audio_track) {
+    auto add_result = peer_connection.AddTrack(audio_track);
     if (add_result.IsErr()) {
       return Result<void>::Err(
           ErrorCode::kAudioTrackError,
@@ -61,12 +137,13 @@ Result<void> ControllerSession::Initialize(const Config& config) {
   DataChannel::Config channel_config;
   channel_config.ordered = true;
   channel_config.max_retransmits = 3;
+  channel_config.priority = DataChannel::Priority::kHigh;
 
   auto channel_result =
-      peer_connection_->CreateDataChannel("input", channel_config);
+      peer_connection.CreateDataChannel("input", channel_config);
   if (channel_result.IsOk()) {
-    input_channel_ = channel_result.Value();
-    input_channel_->SetOnMessageCallback(
+    input_channel = channel_result.Value();
+    input_channel->SetOnMessageCallback(
         [this](const uint8_t* data, size_t len) {
           OnInputEventReceived(data, len);
         });
@@ -75,13 +152,11 @@ Result<void> ControllerSession::Initialize(const Config& config) {
                    channel_result.Message());
   }
 
-  result = peer_connection_->Connect();
+  result = peer_connection.Connect();
   if (result.IsErr()) {
     return Result<void>::Err(ErrorCode::kPeerConnectionError,
                              "Failed to connect: " + result.Message());
   }
-
-  ZENREMOTE_INFO("ControllerSession initialized and connected");
   return Result<void>::Ok();
 }
 
@@ -90,6 +165,11 @@ void ControllerSession::Shutdown() {
     peer_connection_->Disconnect();
     peer_connection_.reset();
   }
+  for (auto& viewer : viewers_) {
+    viewer.peer_connection->Disconnect();
+  }
+  viewers_.clear();
+  broadcaster_.reset();
 
   video_track_.reset();
   audio_track_.reset();
@@ -100,7 +180,14 @@ void ControllerSession::Shutdown() {
 
 Result<void> ControllerSession::SendVideoFrame(const uint8_t* data,
                                                size_t length,
-                                               uint32_t timestamp_90khz) {
+                                               uint32_t timestamp_90khz,
+                                               bool is_keyframe,
+                                               uint8_t temporal_id) {
+  if (broadcaster_) {
+    return broadcaster_->SendFrame(data, length, timestamp_90khz, is_keyframe,
+                                   temporal_id);
+  }
+
   if (!video_track_) {
     return Result<void>::Err(ErrorCode::kVideoTrackError,
                              "Video track not initialized");
@@ -112,6 +199,22 @@ Result<void> ControllerSession::SendVideoFrame(const uint8_t* data,
 Result<void> ControllerSession::SendAudioPacket(const uint8_t* data,
                                                 size_t length,
                                                 uint32_t timestamp_48khz) {
+  if (!viewers_.empty()) {
+    for (auto& viewer : viewers_) {
+      if (!viewer.audio_track) {
+        return Result<void>::Err(ErrorCode::kAudioTrackError,
+                                 "Audio track not initialized");
+      }
+      auto result =
+          viewer.audio_track->SendFrame(data, length, timestamp_48khz);
+      if (result.IsErr()) {
+        ZENREMOTE_DEBUG("Audio send failed for a viewer: {}",
+                        result.Message());
+      }
+    }
+    return Result<void>::Ok();
+  }
+
   if (!audio_track_) {
     return Result<void>::Err(ErrorCode::kAudioTrackError,
                              "Audio track not initialized");
@@ -124,12 +227,22 @@ void ControllerSession::SetVideoEnabled(bool enabled) {
   if (video_track_) {
     video_track_->SetEnabled(enabled);
   }
+  for (auto& viewer : viewers_) {
+    if (viewer.video_track) {
+      viewer.video_track->SetEnabled(enabled);
+    }
+  }
 }
 
 void ControllerSession::SetAudioEnabled(bool enabled) {
   if (audio_track_) {
     audio_track_->SetEnabled(enabled);
   }
+  for (auto& viewer : viewers_) {
+    if (viewer.audio_track) {
+      viewer.audio_track->SetEnabled(enabled);
+    }
+  }
 }
 
 void ControllerSession::OnInputEventReceived(const uint8_t* data,
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "common/error.h"
 #include "transport/channel/data_channel.h"
 #include "transport/track/media_track.h"
 #include "transport/peer_connection.h"
+#include "transport/track/broadcast_track.h"
+#include "transport/track/media_broadcaster.h"
 #include "transport/track/video_track.h"
 
 namespace zenremote {
@@ -15,19 +19,35 @@ namespace zenremote {
  * @brief 控制端会话
  *
  * 应用层类，负责被控端的屏幕捕获和音频采集
+ *
+ * 配置了 broadcast_viewers 时进入广播模式：每个观看者一个 PeerConnection，
+ * 视频由 MediaBroadcaster 打包一次后分发，采集与编码只有一路。
  */
 class ControllerSession {
  public:
+  struct ViewerEndpoint {
+    std::string remote_ip;
+    uint16_t remote_port = 50000;
+  };
+
   struct Config {
     std::string remote_ip;
     uint16_t remote_port = 50000;
 
+    /// 非空时进入广播模式，忽略 remote_ip / remote_port
+    std::vector<ViewerEndpoint> broadcast_viewers;
+
     bool enable_video = true;
     uint32_t video_bitrate_bps = 2500000;
     uint32_t video_framerate = 30;
+    /// 广播模式的时间层数（与编码器一致），按观看者带宽丢弃高层
+    uint8_t video_temporal_layers = 1;
 
     bool enable_audio = true;
     uint32_t audio_sample_rate = 48000;
+
+    /// 多会话主机（SessionManager）共享的接收反应器，为空时每个连接一个线程
+    std::shared_ptr<NetworkReactor> reactor;
   };
 
   ControllerSession();
@@ -38,7 +58,9 @@ class ControllerSession {
 
   Result<void> SendVideoFrame(const uint8_t* data,
                               size_t length,
-                              uint32_t timestamp_90khz);
+                              uint32_t timestamp_90khz,
+                              bool is_keyframe = false,
+                              uint8_t temporal_id = 0);
   Result<void> SendAudioPacket(const uint8_t* data,
                                size_t length,
                                uint32_t timestamp_48khz);
@@ -46,7 +68,36 @@ class ControllerSession {
   void SetVideoEnabled(bool enabled);
   void SetAudioEnabled(bool enabled);
 
+  /**
+   * @brief 观看者请求关键帧时调用（广播模式，已按最小间隔合并）
+   *
+   * 可能在网络线程调用，应只通知编码器（如 ForceKeyFrame）。
+   */
+  void SetOnKeyFrameRequestCallback(std::function<void()> callback) {
+    on_keyframe_request_callback_ = std::move(callback);
+  }
+
+  /// @brief 广播模式的分发器（查询统计）；单连接模式返回 nullptr
+  std::shared_ptr<MediaBroadcaster> GetBroadcaster() const {
+    return broadcaster_;
+  }
+
  private:
+  struct Viewer {
+    std::unique_ptr<PeerConnection> peer_connection;
+    std::shared_ptr<BroadcastTrack> video_track;
+    std::shared_ptr<AudioTrack> audio_track;
+    std::shared_ptr<DataChannel> input_channel;
+  };
+
+  Result<void> InitializeBroadcast();
+  /// @brief 初始化连接、加入轨道、创建输入通道并连接
+  Result<void> ConnectPeer(PeerConnection& peer_connection,
+                           const std::string& remote_ip,
+                           uint16_t remote_port,
+                           std::shared_ptr<MediaTrack> video_track,
+                           std::shared_ptr<AudioTrack> audio_track,
+                           std::shared_ptr<DataChannel>& input_channel);
   void OnInputEventReceived(const uint8_t* data, size_t length);
 
   Config config_;
@@ -54,6 +105,10 @@ class ControllerSession {
   std::shared_ptr<VideoTrack> video_track_;
   std::shared_ptr<AudioTrack> audio_track_;
   std::shared_ptr<DataChannel> input_channel_;
+
+  std::shared_ptr<MediaBroadcaster> broadcaster_;
+  std::vector<Viewer> viewers_;
+  std::function<void()> on_keyframe_request_callback_;
 };
 
 }  // namespace zenremote
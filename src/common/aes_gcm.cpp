@@ -0,0 +1,597 @@
+#include "aes_gcm.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define ZENREMOTE_AESNI 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#define AESNI_TARGET __attribute__((target("aes,pclmul,sse4.1")))
+#else
+#include <intrin.h>
+#define AESNI_TARGET
+#endif
+#endif
+
+namespace zenremote {
+
+namespace {
+
+constexpr size_t kBlock = 16;
+
+inline uint32_t LoadBe32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) |
+         (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+inline void StoreBe32(uint32_t value, uint8_t* p) {
+  p[0] = static_cast<uint8_t>(value >> 24);
+  p[1] = static_cast<uint8_t>(value >> 16);
+  p[2] = static_cast<uint8_t>(value >> 8);
+  p[3] = static_cast<uint8_t>(value);
+}
+
+inline uint64_t LoadBe64(const uint8_t* p) {
+  return (static_cast<uint64_t>(LoadBe32(p)) << 32) | LoadBe32(p + 4);
+}
+
+inline void StoreBe64(uint64_t value, uint8_t* p) {
+  StoreBe32(static_cast<uint32_t>(value >> 32), p);
+  StoreBe32(static_cast<uint32_t>(value), p + 4);
+}
+
+inline uint8_t Xtime(uint8_t x) {
+  return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+}
+
+inline uint8_t RotateLeft8(uint8_t x, int bits) {
+  return static_cast<uint8_t>((x << bits) | (x >> (8 - bits)));
+}
+
+inline uint32_t RotateRight32(uint32_t x, int bits) {
+  return (x >> bits) | (x << (32 - bits));
+}
+
+struct AesTables {
+  uint8_t sbox[256];
+  uint32_t te[4][256];  ///< SubBytes + MixColumns 合并后的查表（大端字）
+};
+
+AesTables BuildTables() {
+  AesTables tables{};
+  // 以 3 为生成元遍历 GF(2^8)*：p 乘 3、q 除 3，q 即 p 的逆元
+  uint8_t p = 1;
+  uint8_t q = 1;
+  do {
+    p = static_cast<uint8_t>(p ^ (p << 1) ^ ((p & 0x80) ? 0x1B : 0));
+    q = static_cast<uint8_t>(q ^ (q << 1));
+    q = static_cast<uint8_t>(q ^ (q << 2));
+    q = static_cast<uint8_t>(q ^ (q << 4));
+    q = static_cast<uint8_t>(q ^ ((q & 0x80) ? 0x09 : 0));
+    const uint8_t affine = static_cast<uint8_t>(
+        q ^ RotateLeft8(q, 1) ^ RotateLeft8(q, 2) ^ RotateLeft8(q, 3) ^
+        RotateLeft8(q, 4));
+    tables.sbox[p] = static_cast<uint8_t>(affine ^ 0x63);
+  } while (p != 1);
+  tables.sbox[0] = 0x63;
+
+  for (int i = 0; i < 256; ++i) {
+    const uint8_t s = tables.sbox[i];
+    const uint8_t s2 = Xtime(s);
+    const uint8_t s3 = static_cast<uint8_t>(s2 ^ s);
+    const uint32_t word = (static_cast<uint32_t>(s2) << 24) |
+                          (static_cast<uint32_t>(s) << 16) |
+                          (static_cast<uint32_t>(s) << 8) | s3;
+    tables.te[0][i] = word;
+    tables.te[1][i] = RotateRight32(word, 8);
+    tables.te[2][i] = RotateRight32(word, 16);
+    tables.te[3][i] = RotateRight32(word, 24);
+  }
+  return tables;
+}
+
+const AesTables& Tables() {
+  static const AesTables tables = BuildTables();
+  return tables;
+}
+
+// 4 位表 GHASH 的约简常量：移出的 4 位对应的 R 多项式倍数
+constexpr uint16_t kLast4[16] = {0x0000, 0x1c20, 0x3840, 0x2460,
+                                 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+                                 0xe100, 0xfd20, 0xd940, 0xc560,
+                                 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+inline void IncrementCounter(uint8_t* block) {
+  StoreBe32(LoadBe32(block + 12) + 1, block + 12);
+}
+
+bool DetectHardware() {
+#ifdef ZENREMOTE_AESNI
+#if defined(__GNUC__) || defined(__clang__)
+  unsigned int eax = 0;
+  unsigned int ebx = 0;
+  unsigned int ecx = 0;
+  unsigned int edx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+#else
+  int info[4] = {};
+  __cpuid(info, 1);
+  const unsigned int ecx = static_cast<unsigned int>(info[2]);
+#endif
+  // ECX: bit 1 PCLMULQDQ，bit 19 SSE4.1，bit 25 AES
+  return (ecx & (1U << 1)) && (ecx & (1U << 19)) && (ecx & (1U << 25));
+#else
+  return false;
+#endif
+}
+
+#ifdef ZENREMOTE_AESNI
+
+AESNI_TARGET inline __m128i ByteSwap(__m128i x) {
+  return _mm_shuffle_epi8(
+      x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/// @brief 无约简的 128x128 位无进位乘法（字节反转表示），结果为 256 位
+AESNI_TARGET inline void ClmulUnreduced(__m128i a,
+                                        __m128i b,
+                                        __m128i& low,
+                                        __m128i& high) {
+  __m128i lo = _mm_clmulepi64_si128(a, b, 0x00);
+  __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+                              _mm_clmulepi64_si128(a, b, 0x01));
+  __m128i hi = _mm_clmulepi64_si128(a, b, 0x11);
+  low = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+  high = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+}
+
+/**
+ * @brief 256 位乘积左移一位（位反射）后模 x^128 + x^7 + x^2 + x + 1 约简
+ *
+ * 移位与约简都是线性的，多个乘积可先异或再约简一次（聚合约简）。
+ */
+AESNI_TARGET inline __m128i Reduce(__m128i low, __m128i high) {
+  __m128i carry_low = _mm_srli_epi32(low, 31);
+  __m128i carry_high = _mm_srli_epi32(high, 31);
+  low = _mm_slli_epi32(low, 1);
+  high = _mm_slli_epi32(high, 1);
+  const __m128i cross = _mm_srli_si128(carry_low, 12);
+  carry_high = _mm_slli_si128(carry_high, 4);
+  carry_low = _mm_slli_si128(carry_low, 4);
+  low = _mm_or_si128(low, carry_low);
+  high = _mm_or_si128(_mm_or_si128(high, carry_high), cross);
+
+  __m128i a = _mm_xor_si128(
+      _mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)),
+      _mm_slli_epi32(low, 25));
+  const __m128i b = _mm_srli_si128(a, 4);
+  a = _mm_slli_si128(a, 12);
+  low = _mm_xor_si128(low, a);
+  __m128i c = _mm_xor_si128(
+      _mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)),
+      _mm_srli_epi32(low, 7));
+  c = _mm_xor_si128(c, b);
+  low = _mm_xor_si128(low, c);
+  return _mm_xor_si128(high, low);
+}
+
+AESNI_TARGET inline __m128i GfMultiply(__m128i a, __m128i b) {
+  __m128i low;
+  __m128i high;
+  ClmulUnreduced(a, b, low, high);
+  return Reduce(low, high);
+}
+
+struct HardwareKey {
+  __m128i rk[11];
+  __m128i h[4];  ///< H^1..H^4
+};
+
+AESNI_TARGET inline __m128i EncryptBlock(const HardwareKey& key,
+                                         __m128i block) {
+  block = _mm_xor_si128(block, key.rk[0]);
+  for (int r = 1; r < 10; ++r) {
+    block = _mm_aesenc_si128(block, key.rk[r]);
+  }
+  return _mm_aesenclast_si128(block, key.rk[10]);
+}
+
+/// @brief 4 个块交错执行各轮，掩盖 AESENC 的延迟
+AESNI_TARGET inline void EncryptBlocks4(const HardwareKey& key, __m128i* b) {
+  for (int i = 0; i < 4; ++i) {
+    b[i] = _mm_xor_si128(b[i], key.rk[0]);
+  }
+  for (int r = 1; r < 10; ++r) {
+    for (int i = 0; i < 4; ++i) {
+      b[i] = _mm_aesenc_si128(b[i], key.rk[r]);
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    b[i] = _mm_aesenclast_si128(b[i], key.rk[10]);
+  }
+}
+
+AESNI_TARGET inline __m128i CounterBlock(__m128i j0, uint32_t counter) {
+  const uint32_t be = ((counter & 0xFFU) << 24) | ((counter & 0xFF00U) << 8) |
+                      ((counter >> 8) & 0xFF00U) | (counter >> 24);
+  return _mm_insert_epi32(j0, static_cast<int>(be), 3);
+}
+
+/// @brief 不足一块的数据按 0 填充后参与 GHASH
+AESNI_TARGET inline __m128i LoadPartial(const uint8_t* data, size_t length) {
+  alignas(16) uint8_t block[kBlock] = {};
+  std::memcpy(block, data, length);
+  return _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+}
+
+AESNI_TARGET void CryptHardware(const HardwareKey& key,
+                                const uint8_t* iv,
+                                const uint8_t* aad,
+                                size_t aad_length,
+                                uint8_t* data,
+                                size_t length,
+                                uint8_t* tag,
+                                bool decrypt) {
+  alignas(16) uint8_t j0_bytes[kBlock] = {};
+  std::memcpy(j0_bytes, iv, AesGcm128::kIvSize);
+  j0_bytes[15] = 1;
+  const __m128i j0 = _mm_load_si128(reinterpret_cast<const __m128i*>(j0_bytes));
+
+  __m128i x = _mm_setzero_si128();
+  size_t offset = 0;
+  for (; offset + kBlock <= aad_length; offset += kBlock) {
+    const __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(aad + offset));
+    x = GfMultiply(_mm_xor_si128(x, ByteSwap(block)), key.h[0]);
+  }
+  if (offset < aad_length) {
+    const __m128i block = LoadPartial(aad + offset, aad_length - offset);
+    x = GfMultiply(_mm_xor_si128(x, ByteSwap(block)), key.h[0]);
+  }
+
+  uint32_t counter = 1;
+  offset = 0;
+  for (; offset + 4 * kBlock <= length; offset += 4 * kBlock) {
+    __m128i keystream[4];
+    for (int i = 0; i < 4; ++i) {
+      keystream[i] = CounterBlock(j0, ++counter);
+    }
+    EncryptBlocks4(key, keystream);
+
+    __m128i hashed[4];
+    for (int i = 0; i < 4; ++i) {
+      auto* p = reinterpret_cast<__m128i*>(data + offset + i * kBlock);
+      const __m128i in = _mm_loadu_si128(p);
+      const __m128i out = _mm_xor_si128(in, keystream[i]);
+      _mm_storeu_si128(p, out);
+      hashed[i] = ByteSwap(decrypt ? in : out);
+    }
+
+    // X' = (X + C0)·H^4 + C1·H^3 + C2·H^2 + C3·H，四个乘积只约简一次
+    __m128i low;
+    __m128i high;
+    ClmulUnreduced(_mm_xor_si128(x, hashed[0]), key.h[3], low, high);
+    for (int i = 1; i < 4; ++i) {
+      __m128i l;
+      __m128i h;
+      ClmulUnreduced(hashed[i], key.h[3 - i], l, h);
+      low = _mm_xor_si128(low, l);
+      high = _mm_xor_si128(high, h);
+    }
+    x = Reduce(low, high);
+  }
+  for (; offset < length; offset += kBlock) {
+    const size_t n = std::min(kBlock, length - offset);
+    const __m128i keystream = EncryptBlock(key, CounterBlock(j0, ++counter));
+    if (n == kBlock) {
+      auto* p = reinterpret_cast<__m128i*>(data + offset);
+      const __m128i in = _mm_loadu_si128(p);
+      const __m128i out = _mm_xor_si128(in, keystream);
+      _mm_storeu_si128(p, out);
+      x = GfMultiply(_mm_xor_si128(x, ByteSwap(decrypt ? in : out)),
+                     key.h[0]);
+    } else {
+      alignas(16) uint8_t block[kBlock] = {};
+      std::memcpy(block, data + offset, n);
+      const __m128i in =
+          _mm_load_si128(reinterpret_cast<const __m128i*>(block));
+      _mm_store_si128(reinterpret_cast<__m128i*>(block),
+                      _mm_xor_si128(in, keystream));
+      std::memcpy(data + offset, block, n);
+      // 填充部分必须为 0，不能带上密钥流
+      const __m128i hashed = decrypt ? in : LoadPartial(block, n);
+      x = GfMultiply(_mm_xor_si128(x, ByteSwap(hashed)), key.h[0]);
+    }
+  }
+
+  const __m128i lengths =
+      _mm_set_epi64x(static_cast<int64_t>(aad_length) * 8,
+                     static_cast<int64_t>(length) * 8);
+  x = GfMultiply(_mm_xor_si128(x, lengths), key.h[0]);
+  const __m128i result = _mm_xor_si128(ByteSwap(x), EncryptBlock(key, j0));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(tag), result);
+}
+
+AESNI_TARGET void LoadHardwareKey(const uint8_t* round_keys,
+                                  const uint8_t (*h_powers)[16],
+                                  HardwareKey& key) {
+  for (int i = 0; i < 11; ++i) {
+    key.rk[i] =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(round_keys + 16 * i));
+  }
+  for (int i = 0; i < 4; ++i) {
+    key.h[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(h_powers[i]));
+  }
+}
+
+AESNI_TARGET void ComputeHPowers(const uint8_t* h, uint8_t (*h_powers)[16]) {
+  const __m128i h1 =
+      ByteSwap(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)));
+  __m128i power = h1;
+  for (int i = 0; i < 4; ++i) {
+    _mm_store_si128(reinterpret_cast<__m128i*>(h_powers[i]), power);
+    power = GfMultiply(power, h1);
+  }
+}
+
+AESNI_TARGET void CryptBatchHardware(const uint8_t* round_keys,
+                                     const uint8_t (*h_powers)[16],
+                                     const AesGcm128::Job* jobs,
+                                     size_t count) {
+  HardwareKey key;
+  LoadHardwareKey(round_keys, h_powers, key);
+  for (size_t i = 0; i < count; ++i) {
+    const auto& job = jobs[i];
+    CryptHardware(key, job.iv, job.aad, job.aad_length, job.data, job.length,
+                  job.tag, false);
+  }
+}
+
+#endif  // ZENREMOTE_AESNI
+
+}  // namespace
+
+AesGcm128::AesGcm128(const uint8_t* key, Implementation implementation) {
+  const auto& tables = Tables();
+  static constexpr uint8_t kRcon[10] = {0x01, 0x02, 0x04, 0x08, 0x10,
+                                        0x20, 0x40, 0x80, 0x1B, 0x36};
+  for (int i = 0; i < 4; ++i) {
+    round_words_[i] = LoadBe32(key + 4 * i);
+  }
+  for (int i = 4; i < 44; ++i) {
+    uint32_t t = round_words_[i - 1];
+    if (i % 4 == 0) {
+      t = (t << 8) | (t >> 24);
+      t = (static_cast<uint32_t>(tables.sbox[t >> 24]) << 24) |
+          (static_cast<uint32_t>(tables.sbox[(t >> 16) & 0xFF]) << 16) |
+          (static_cast<uint32_t>(tables.sbox[(t >> 8) & 0xFF]) << 8) |
+          tables.sbox[t & 0xFF];
+      t ^= static_cast<uint32_t>(kRcon[i / 4 - 1]) << 24;
+    }
+    round_words_[i] = round_words_[i - 4] ^ t;
+  }
+  for (int i = 0; i < 44; ++i) {
+    StoreBe32(round_words_[i], round_keys_ + 4 * i);
+  }
+
+  uint8_t h[kBlock] = {};
+  EncryptBlockPortable(h, h);
+
+  // 4 位表：h_table[i] = i·H（GCM 的位反射约定，最高位对应 x^0）
+  uint64_t vh = LoadBe64(h);
+  uint64_t vl = LoadBe64(h + 8);
+  h_table_high_[0] = 0;
+  h_table_low_[0] = 0;
+  h_table_high_[8] = vh;
+  h_table_low_[8] = vl;
+  for (int i = 4; i > 0; i >>= 1) {
+    const uint64_t reduce = (vl & 1) ? 0xE100000000000000ULL : 0;
+    vl = (vh << 63) | (vl >> 1);
+    vh = (vh >> 1) ^ reduce;
+    h_table_high_[i] = vh;
+    h_table_low_[i] = vl;
+  }
+  for (int i = 2; i <= 8; i *= 2) {
+    for (int j = 1; j < i; ++j) {
+      h_table_high_[i + j] = h_table_high_[i] ^ h_table_high_[j];
+      h_table_low_[i + j] = h_table_low_[i] ^ h_table_low_[j];
+    }
+  }
+
+  std::memset(h_powers_, 0, sizeof(h_powers_));
+#ifdef ZENREMOTE_AESNI
+  hardware_ = implementation == Implementation::kAuto && HardwareAvailable();
+  if (hardware_) {
+    ComputeHPowers(h, h_powers_);
+  }
+#else
+  (void)implementation;
+#endif
+}
+
+bool AesGcm128::HardwareAvailable() {
+  static const bool available = DetectHardware();
+  return available;
+}
+
+void AesGcm128::Seal(const uint8_t* iv,
+                     const uint8_t* aad,
+                     size_t aad_length,
+                     uint8_t* data,
+                     size_t length,
+                     uint8_t* tag) const {
+  Crypt(iv, aad, aad_length, data, length, tag, false);
+}
+
+bool AesGcm128::Open(const uint8_t* iv,
+                     const uint8_t* aad,
+                     size_t aad_length,
+                     uint8_t* data,
+                     size_t length,
+                     const uint8_t* tag) const {
+  uint8_t expected[kTagSize];
+  Crypt(iv, aad, aad_length, data, length, expected, true);
+  // 常量时间比较
+  uint8_t diff = 0;
+  for (size_t i = 0; i < kTagSize; ++i) {
+    diff |= static_cast<uint8_t>(expected[i] ^ tag[i]);
+  }
+  return diff == 0;
+}
+
+void AesGcm128::SealBatch(const Job* jobs, size_t count) const {
+#ifdef ZENREMOTE_AESNI
+  if (hardware_) {
+    CryptBatchHardware(round_keys_, h_powers_, jobs, count);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < count; ++i) {
+    const auto& job = jobs[i];
+    CryptPortable(job.iv, job.aad, job.aad_length, job.data, job.length,
+                  job.tag, false);
+  }
+}
+
+void AesGcm128::Crypt(const uint8_t* iv,
+                      const uint8_t* aad,
+                      size_t aad_length,
+                      uint8_t* data,
+                      size_t length,
+                      uint8_t* tag,
+                      bool decrypt) const {
+#ifdef ZENREMOTE_AESNI
+  if (hardware_) {
+    HardwareKey key;
+    LoadHardwareKey(round_keys_, h_powers_, key);
+    CryptHardware(key, iv, aad, aad_length, data, length, tag, decrypt);
+    return;
+  }
+#endif
+  CryptPortable(iv, aad, aad_length, data, length, tag, decrypt);
+}
+
+void AesGcm128::CryptPortable(const uint8_t* iv,
+                              const uint8_t* aad,
+                              size_t aad_length,
+                              uint8_t* data,
+                              size_t length,
+                              uint8_t* tag,
+                              bool decrypt) const {
+  uint8_t j0[kBlock] = {};
+  std::memcpy(j0, iv, kIvSize);
+  j0[15] = 1;
+
+  uint8_t x[kBlock] = {};
+  for (size_t offset = 0; offset < aad_length; offset += kBlock) {
+    const size_t n = std::min(kBlock, aad_length - offset);
+    for (size_t i = 0; i < n; ++i) {
+      x[i] ^= aad[offset + i];
+    }
+    GhashMultiply(x);
+  }
+
+  uint8_t counter[kBlock];
+  std::memcpy(counter, j0, kBlock);
+  uint8_t keystream[kBlock];
+  for (size_t offset = 0; offset < length; offset += kBlock) {
+    const size_t n = std::min(kBlock, length - offset);
+    IncrementCounter(counter);
+    EncryptBlockPortable(counter, keystream);
+    uint8_t* block = data + offset;
+    if (decrypt) {
+      for (size_t i = 0; i < n; ++i) {
+        x[i] ^= block[i];
+        block[i] ^= keystream[i];
+      }
+    } else {
+      for (size_t i = 0; i < n; ++i) {
+        block[i] ^= keystream[i];
+        x[i] ^= block[i];
+      }
+    }
+    GhashMultiply(x);
+  }
+
+  uint8_t lengths[kBlock];
+  StoreBe64(static_cast<uint64_t>(aad_length) * 8, lengths);
+  StoreBe64(static_cast<uint64_t>(length) * 8, lengths + 8);
+  for (size_t i = 0; i < kBlock; ++i) {
+    x[i] ^= lengths[i];
+  }
+  GhashMultiply(x);
+
+  EncryptBlockPortable(j0, keystream);
+  for (size_t i = 0; i < kTagSize; ++i) {
+    tag[i] = static_cast<uint8_t>(x[i] ^ keystream[i]);
+  }
+}
+
+void AesGcm128::EncryptBlockPortable(const uint8_t* in, uint8_t* out) const {
+  const auto& t = Tables();
+  const uint32_t* rk = round_words_;
+  uint32_t s0 = LoadBe32(in) ^ rk[0];
+  uint32_t s1 = LoadBe32(in + 4) ^ rk[1];
+  uint32_t s2 = LoadBe32(in + 8) ^ rk[2];
+  uint32_t s3 = LoadBe32(in + 12) ^ rk[3];
+  for (int round = 1; round < 10; ++round) {
+    rk += 4;
+    const uint32_t t0 = t.te[0][s0 >> 24] ^ t.te[1][(s1 >> 16) & 0xFF] ^
+                        t.te[2][(s2 >> 8) & 0xFF] ^ t.te[3][s3 & 0xFF] ^ rk[0];
+    const uint32_t t1 = t.te[0][s1 >> 24] ^ t.te[1][(s2 >> 16) & 0xFF] ^
+                        t.te[2][(s3 >> 8) & 0xFF] ^ t.te[3][s0 & 0xFF] ^ rk[1];
+    const uint32_t t2 = t.te[0][s2 >> 24] ^ t.te[1][(s3 >> 16) & 0xFF] ^
+                        t.te[2][(s0 >> 8) & 0xFF] ^ t.te[3][s1 & 0xFF] ^ rk[2];
+    const uint32_t t3 = t.te[0][s3 >> 24] ^ t.te[1][(s0 >> 16) & 0xFF] ^
+                        t.te[2][(s1 >> 8) & 0xFF] ^ t.te[3][s2 & 0xFF] ^ rk[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+  rk += 4;
+  // 最后一轮没有 MixColumns
+  const uint32_t state[4] = {s0, s1, s2, s3};
+  for (int i = 0; i < 4; ++i) {
+    const uint32_t word =
+        (static_cast<uint32_t>(t.sbox[state[i] >> 24]) << 24) |
+        (static_cast<uint32_t>(t.sbox[(state[(i + 1) % 4] >> 16) & 0xFF])
+         << 16) |
+        (static_cast<uint32_t>(t.sbox[(state[(i + 2) % 4] >> 8) & 0xFF])
+         << 8) |
+        t.sbox[state[(i + 3) % 4] & 0xFF];
+    StoreBe32(word ^ rk[i], out + 4 * i);
+  }
+}
+
+void AesGcm128::GhashMultiply(uint8_t* x) const {
+  uint8_t low_nibble = x[15] & 0x0F;
+  uint64_t zh = h_table_high_[low_nibble];
+  uint64_t zl = h_table_low_[low_nibble];
+  for (int i = 15; i >= 0; --i) {
+    low_nibble = x[i] & 0x0F;
+    const uint8_t high_nibble = (x[i] >> 4) & 0x0F;
+    if (i != 15) {
+      const uint8_t rem = static_cast<uint8_t>(zl & 0x0F);
+      zl = (zh << 60) | (zl >> 4);
+      zh = (zh >> 4) ^ (static_cast<uint64_t>(kLast4[rem]) << 48);
+      zh ^= h_table_high_[low_nibble];
+      zl ^= h_table_low_[low_nibble];
+    }
+    const uint8_t rem = static_cast<uint8_t>(zl & 0x0F);
+    zl = (zh << 60) | (zl >> 4);
+    zh = (zh >> 4) ^ (static_cast<uint64_t>(kLast4[rem]) << 48);
+    zh ^= h_table_high_[high_nibble];
+    zl ^= h_table_low_[high_nibble];
+  }
+  StoreBe64(zh, x);
+  StoreBe64(zl, x + 8);
+}
+
+}  // namespace zenremote
@@ -0,0 +1,105 @@
+/**
+ * @file aes_gcm.h
+ * @brief AES-128-GCM 认证加密（NIST SP 800-38D，96 位 IV，128 位标签）
+ *
+ * 两套实现，构造时选定：
+ * - x86/x64 且 CPU 支持 AES-NI + PCLMULQDQ + SSE4.1：每轮 4 个计数器块
+ *   并行加密，GHASH 用 H^1..H^4 聚合后一次约简
+ * - 其他情况：T 表 AES 与 4 位表 GHASH（Shoup）的可移植实现。T 表查表
+ *   存在缓存时序侧信道，只作为没有硬件指令时的后备
+ *
+ * 加解密都在调用方缓冲区上就地进行；SealBatch() 一次处理一帧的多个报文，
+ * 轮密钥与 H 的幂只加载一次。
+ *
+ * @note 对象构造后只读，可在多个线程并发使用
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace zenremote {
+
+class AesGcm128 {
+ public:
+  static constexpr size_t kKeySize = 16;
+  static constexpr size_t kIvSize = 12;
+  static constexpr size_t kTagSize = 16;
+
+  enum class Implementation {
+    kAuto,      ///< 有硬件指令时使用 AES-NI/PCLMUL
+    kPortable,  ///< 强制可移植实现（测试与基准对比用）
+  };
+
+  /// @brief 批量加密中的一个报文
+  struct Job {
+    const uint8_t* iv = nullptr;  ///< kIvSize 字节
+    const uint8_t* aad = nullptr;
+    size_t aad_length = 0;
+    uint8_t* data = nullptr;  ///< 明文，就地替换为密文
+    size_t length = 0;
+    uint8_t* tag = nullptr;  ///< 输出 kTagSize 字节
+  };
+
+  explicit AesGcm128(const uint8_t* key,
+                     Implementation implementation = Implementation::kAuto);
+
+  /// @brief 加密 data 并输出标签
+  void Seal(const uint8_t* iv,
+            const uint8_t* aad,
+            size_t aad_length,
+            uint8_t* data,
+            size_t length,
+            uint8_t* tag) const;
+
+  /**
+   * @brief 校验标签并解密
+   * @return 标签匹配返回 true；失败时 data 内容未定义，调用方应丢弃
+   */
+  bool Open(const uint8_t* iv,
+            const uint8_t* aad,
+            size_t aad_length,
+            uint8_t* data,
+            size_t length,
+            const uint8_t* tag) const;
+
+  void SealBatch(const Job* jobs, size_t count) const;
+
+  bool IsHardwareAccelerated() const { return hardware_; }
+
+  /// @brief 当前 CPU 是否支持 AES-NI + PCLMULQDQ
+  static bool HardwareAvailable();
+
+ private:
+  /// @brief 计算 GCM 并把标签写入 tag；decrypt 时 GHASH 作用于输入
+  void Crypt(const uint8_t* iv,
+             const uint8_t* aad,
+             size_t aad_length,
+             uint8_t* data,
+             size_t length,
+             uint8_t* tag,
+             bool decrypt) const;
+  void CryptPortable(const uint8_t* iv,
+                     const uint8_t* aad,
+                     size_t aad_length,
+                     uint8_t* data,
+                     size_t length,
+                     uint8_t* tag,
+                     bool decrypt) const;
+  void EncryptBlockPortable(const uint8_t* in, uint8_t* out) const;
+  void GhashMultiply(uint8_t* x) const;
+
+  alignas(16) uint8_t round_keys_[176];  ///< FIPS-197 字节序，两套实现共用
+  uint32_t round_words_[44];             ///< 可移植实现的大端字
+  bool hardware_ = false;
+
+  // 硬件实现：H^1..H^4（字节反转后的表示）
+  alignas(16) uint8_t h_powers_[4][16];
+  // 可移植实现：i * H 的 4 位表（高/低 64 位）
+  uint64_t h_table_high_[16];
+  uint64_t h_table_low_[16];
+};
+
+}  // namespace zenremote
@@ -0,0 +1,68 @@
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint32_t kCrc32cPolynomial = 0x82F63B78U;  // 反射形式
+
+struct Crc32cTables {
+  std::array<std::array<uint32_t, 256>, 8> table{};
+
+  Crc32cTables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ ((crc & 1U) ? kCrc32cPolynomial : 0U);
+      }
+      table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (size_t slice = 1; slice < 8; ++slice) {
+        const uint32_t prev = table[slice - 1][i];
+        table[slice][i] = (prev >> 8) ^ table[0][prev & 0xFFU];
+      }
+    }
+  }
+};
+
+const Crc32cTables& Tables() {
+  static const Crc32cTables tables;
+  return tables;
+}
+
+}  // namespace
+
+uint32_t Crc32c(const uint8_t* data, size_t length, uint32_t crc) {
+  const auto& t = Tables().table;
+  crc = ~crc;
+
+  // slicing-by-8：每次处理 8 字节（按小端解释）
+  while (length >= 8) {
+    uint32_t low;
+    uint32_t high;
+    std::memcpy(&low, data, 4);
+    std::memcpy(&high, data + 4, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    low = __builtin_bswap32(low);
+    high = __builtin_bswap32(high);
+#endif
+    low ^= crc;
+    crc = t[7][low & 0xFFU] ^ t[6][(low >> 8) & 0xFFU] ^
+          t[5][(low >> 16) & 0xFFU] ^ t[4][low >> 24] ^
+          t[3][high & 0xFFU] ^ t[2][(high >> 8) & 0xFFU] ^
+          t[1][(high >> 16) & 0xFFU] ^ t[0][high >> 24];
+    data += 8;
+    length -= 8;
+  }
+
+  while (length-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFFU];
+  }
+  return ~crc;
+}
+
+}  // namespace zenremote
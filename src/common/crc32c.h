@@ -0,0 +1,22 @@
+/**
+ * @file crc32c.h
+ * @brief CRC-32C（Castagnoli）校验
+ *
+ * 用于文件传输的分块校验。软件实现采用 slicing-by-8 查表，
+ * 单核吞吐约 1-2 GB/s，远高于千兆链路所需。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zenremote {
+
+/**
+ * @brief 计算 CRC-32C
+ * @param crc 上一段数据的结果，用于分段累积计算；首段传 0
+ */
+uint32_t Crc32c(const uint8_t* data, size_t length, uint32_t crc = 0);
+
+}  // namespace zenremote
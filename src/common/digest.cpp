@@ -0,0 +1,333 @@
+#include "digest.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace zenremote {
+
+namespace {
+
+constexpr size_t kBlockSize = 64;
+
+inline uint32_t RotateLeft(uint32_t value, int bits) {
+  return (value << bits) | (value >> (32 - bits));
+}
+
+/**
+ * @brief Merkle-Damgård 填充：0x80、若干 0、64 位消息比特长度
+ * @param big_endian 长度字段字节序（SHA-1 大端，MD5 小端）
+ */
+std::vector<uint8_t> PadMessage(const uint8_t* data,
+                                size_t length,
+                                bool big_endian) {
+  const size_t padded = ((length + 8) / kBlockSize + 1) * kBlockSize;
+  std::vector<uint8_t> buffer(padded, 0);
+  if (length > 0) {
+    std::memcpy(buffer.data(), data, length);
+  }
+  buffer[length] = 0x80;
+  const uint64_t bits = static_cast<uint64_t>(length) * 8;
+  for (int i = 0; i < 8; ++i) {
+    const size_t index = big_endian ? padded - 1 - i : padded - 8 + i;
+    buffer[index] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  return buffer;
+}
+
+}  // namespace
+
+Md5Digest Md5(const uint8_t* data, size_t length) {
+  static constexpr uint32_t kK[64] = {
+      0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+      0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+      0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+      0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+      0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+      0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+      0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+      0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+      0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+      0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+      0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+  static constexpr int kShift[64] = {
+      7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+      5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+      4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+      6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+  uint32_t h[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+  const auto buffer = PadMessage(data, length, false);
+
+  for (size_t offset = 0; offset < buffer.size(); offset += kBlockSize) {
+    uint32_t m[16];
+    for (int i = 0; i < 16; ++i) {
+      const uint8_t* p = buffer.data() + offset + i * 4;
+      m[i] = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+             (static_cast<uint32_t>(p[2]) << 16) |
+             (static_cast<uint32_t>(p[3]) << 24);
+    }
+    uint32_t a = h[0];
+    uint32_t b = h[1];
+    uint32_t c = h[2];
+    uint32_t d = h[3];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t f;
+      int g;
+      if (i < 16) {
+        f = (b & c) | (~b & d);
+        g = i;
+      } else if (i < 32) {
+        f = (d & b) | (~d & c);
+        g = (5 * i + 1) % 16;
+      } else if (i < 48) {
+        f = b ^ c ^ d;
+        g = (3 * i + 5) % 16;
+      } else {
+        f = c ^ (b | ~d);
+        g = (7 * i) % 16;
+      }
+      const uint32_t temp = d;
+      d = c;
+      c = b;
+      b = b + RotateLeft(a + f + kK[i] + m[g], kShift[i]);
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+  }
+
+  Md5Digest digest;
+  for (int i = 0; i < 16; ++i) {
+    digest[i] = static_cast<uint8_t>(h[i / 4] >> (8 * (i % 4)));
+  }
+  return digest;
+}
+
+Sha1Digest Sha1(const uint8_t* data, size_t length) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                   0xC3D2E1F0};
+  const auto buffer = PadMessage(data, length, true);
+
+  for (size_t offset = 0; offset < buffer.size(); offset += kBlockSize) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const uint8_t* p = buffer.data() + offset + i * 4;
+      w[i] = (static_cast<uint32_t>(p[0]) << 24) |
+             (static_cast<uint32_t>(p[1]) << 16) |
+             (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+    for (int i = 16; i < 80; ++i) {
+      w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = h[0];
+    uint32_t b = h[1];
+    uint32_t c = h[2];
+    uint32_t d = h[3];
+    uint32_t e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f;
+      uint32_t k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      const uint32_t temp = RotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = RotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  Sha1Digest digest;
+  for (int i = 0; i < 20; ++i) {
+    digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+  }
+  return digest;
+}
+
+Sha1Digest HmacSha1(const uint8_t* key,
+                    size_t key_length,
+                    const uint8_t* data,
+                    size_t length) {
+  uint8_t block_key[kBlockSize] = {};
+  if (key_length > kBlockSize) {
+    const auto hashed = Sha1(key, key_length);
+    std::memcpy(block_key, hashed.data(), hashed.size());
+  } else if (key_length > 0) {
+    std::memcpy(block_key, key, key_length);
+  }
+
+  std::vector<uint8_t> inner(kBlockSize + length);
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    inner[i] = block_key[i] ^ 0x36;
+  }
+  if (length > 0) {
+    std::memcpy(inner.data() + kBlockSize, data, length);
+  }
+  const auto inner_hash = Sha1(inner.data(), inner.size());
+
+  uint8_t outer[kBlockSize + 20];
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    outer[i] = block_key[i] ^ 0x5C;
+  }
+  std::memcpy(outer + kBlockSize, inner_hash.data(), inner_hash.size());
+  return Sha1(outer, sizeof(outer));
+}
+
+Sha256Digest Sha256(const uint8_t* data, size_t length) {
+  static constexpr uint32_t kK[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+      0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+      0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+      0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+      0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+      0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+      0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+  uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  const auto buffer = PadMessage(data, length, true);
+
+  for (size_t offset = 0; offset < buffer.size(); offset += kBlockSize) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+      const uint8_t* p = buffer.data() + offset + i * 4;
+      w[i] = (static_cast<uint32_t>(p[0]) << 24) |
+             (static_cast<uint32_t>(p[1]) << 16) |
+             (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+    for (int i = 16; i < 64; ++i) {
+      const uint32_t s0 = RotateLeft(w[i - 15], 25) ^
+                          RotateLeft(w[i - 15], 14) ^ (w[i - 15] >> 3);
+      const uint32_t s1 = RotateLeft(w[i - 2], 15) ^ RotateLeft(w[i - 2], 13) ^
+                          (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t v[8];
+    std::memcpy(v, h, sizeof(v));
+    for (int i = 0; i < 64; ++i) {
+      // 右旋 n 位 = 左旋 32 - n 位
+      const uint32_t s1 =
+          RotateLeft(v[4], 26) ^ RotateLeft(v[4], 21) ^ RotateLeft(v[4], 7);
+      const uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+      const uint32_t temp1 = v[7] + s1 + ch + kK[i] + w[i];
+      const uint32_t s0 =
+          RotateLeft(v[0], 30) ^ RotateLeft(v[0], 19) ^ RotateLeft(v[0], 10);
+      const uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+      const uint32_t temp2 = s0 + maj;
+      v[7] = v[6];
+      v[6] = v[5];
+      v[5] = v[4];
+      v[4] = v[3] + temp1;
+      v[3] = v[2];
+      v[2] = v[1];
+      v[1] = v[0];
+      v[0] = temp1 + temp2;
+    }
+    for (int i = 0; i < 8; ++i) {
+      h[i] += v[i];
+    }
+  }
+
+  Sha256Digest digest;
+  for (int i = 0; i < 32; ++i) {
+    digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+  }
+  return digest;
+}
+
+Sha256Digest HmacSha256(const uint8_t* key,
+                        size_t key_length,
+                        const uint8_t* data,
+                        size_t length) {
+  uint8_t block_key[kBlockSize] = {};
+  if (key_length > kBlockSize) {
+    const auto hashed = Sha256(key, key_length);
+    std::memcpy(block_key, hashed.data(), hashed.size());
+  } else if (key_length > 0) {
+    std::memcpy(block_key, key, key_length);
+  }
+
+  std::vector<uint8_t> inner(kBlockSize + length);
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    inner[i] = block_key[i] ^ 0x36;
+  }
+  if (length > 0) {
+    std::memcpy(inner.data() + kBlockSize, data, length);
+  }
+  const auto inner_hash = Sha256(inner.data(), inner.size());
+
+  uint8_t outer[kBlockSize + 32];
+  for (size_t i = 0; i < kBlockSize; ++i) {
+    outer[i] = block_key[i] ^ 0x5C;
+  }
+  std::memcpy(outer + kBlockSize, inner_hash.data(), inner_hash.size());
+  return Sha256(outer, sizeof(outer));
+}
+
+std::vector<uint8_t> HkdfSha256(const uint8_t* salt,
+                                size_t salt_length,
+                                const uint8_t* ikm,
+                                size_t ikm_length,
+                                const std::string& info,
+                                size_t length) {
+  // 未提供 salt 时按 RFC 5869 使用全 0 的 HashLen 字节
+  const uint8_t zero_salt[32] = {};
+  const auto prk = salt_length > 0
+                       ? HmacSha256(salt, salt_length, ikm, ikm_length)
+                       : HmacSha256(zero_salt, sizeof(zero_salt), ikm,
+                                    ikm_length);
+  return HkdfExpandSha256(prk.data(), prk.size(), info, length);
+}
+
+std::vector<uint8_t> HkdfExpandSha256(const uint8_t* prk,
+                                      size_t prk_length,
+                                      const std::string& info,
+                                      size_t length) {
+  std::vector<uint8_t> output;
+  if (length > 255 * 32) {
+    return output;
+  }
+  output.reserve(length);
+  std::vector<uint8_t> block;
+  Sha256Digest previous{};
+  for (uint8_t counter = 1; output.size() < length; ++counter) {
+    block.clear();
+    if (counter > 1) {
+      block.insert(block.end(), previous.begin(), previous.end());
+    }
+    block.insert(block.end(), info.begin(), info.end());
+    block.push_back(counter);
+    previous = HmacSha256(prk, prk_length, block.data(), block.size());
+    const size_t take = std::min(previous.size(), length - output.size());
+    output.insert(output.end(), previous.begin(), previous.begin() + take);
+  }
+  return output;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,64 @@
+/**
+ * @file digest.h
+ * @brief MD5 / SHA-1 / SHA-256 摘要与 HMAC、HKDF
+ *
+ * 用于 STUN/TURN 长期凭据（RFC 8489 9.2）：key = MD5(username:realm:password)，
+ * MESSAGE-INTEGRITY = HMAC-SHA1(key, message)；以及握手后从 ECDH 共享密钥
+ * 派生 SRTP 密钥（HKDF-SHA256）。都只处理控制消息，软件实现即可，
+ * 媒体加密见 aes_gcm.h。
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zenremote {
+
+using Md5Digest = std::array<uint8_t, 16>;
+using Sha1Digest = std::array<uint8_t, 20>;
+using Sha256Digest = std::array<uint8_t, 32>;
+
+Md5Digest Md5(const uint8_t* data, size_t length);
+
+inline Md5Digest Md5(const std::string& text) {
+  return Md5(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+Sha1Digest Sha1(const uint8_t* data, size_t length);
+
+/// @brief HMAC-SHA1 (RFC 2104)
+Sha1Digest HmacSha1(const uint8_t* key,
+                    size_t key_length,
+                    const uint8_t* data,
+                    size_t length);
+
+Sha256Digest Sha256(const uint8_t* data, size_t length);
+
+/// @brief HMAC-SHA256 (RFC 2104)
+Sha256Digest HmacSha256(const uint8_t* key,
+                        size_t key_length,
+                        const uint8_t* data,
+                        size_t length);
+
+/**
+ * @brief HKDF-SHA256 (RFC 5869)：Extract(salt, ikm) 后 Expand(info, length)
+ * @param length 输出字节数，至多 255 * 32
+ */
+std::vector<uint8_t> HkdfSha256(const uint8_t* salt,
+                                size_t salt_length,
+                                const uint8_t* ikm,
+                                size_t ikm_length,
+                                const std::string& info,
+                                size_t length);
+
+/// @brief HKDF-Expand：prk 已是均匀的密钥（如上一级 HKDF 的输出）
+std::vector<uint8_t> HkdfExpandSha256(const uint8_t* prk,
+                                      size_t prk_length,
+                                      const std::string& info,
+                                      size_t length);
+
+}  // namespace zenremote
@@ -0,0 +1,383 @@
+#include "file_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zenremote {
+
+namespace {
+
+#ifdef _WIN32
+std::string LastErrorMessage() {
+  return "error " + std::to_string(GetLastError());
+}
+#else
+std::string LastErrorMessage() {
+  return std::strerror(errno);
+}
+
+ErrorCode OpenErrorCode() {
+  switch (errno) {
+    case ENOENT:
+      return ErrorCode::kFileNotFound;
+    case EACCES:
+    case EPERM:
+      return ErrorCode::kFileAccessDenied;
+    default:
+      return ErrorCode::kIOError;
+  }
+}
+#endif
+
+}  // namespace
+
+// ============================================================================
+// MappedFile
+// ============================================================================
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#ifdef _WIN32
+
+Result<void> MappedFile::Open(const std::string& path) {
+  Close();
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return Result<void>::Err(ErrorCode::kFileNotFound,
+                             "Failed to open " + path + ": " +
+                                 LastErrorMessage());
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "Failed to stat " + path + ": " +
+                                 LastErrorMessage());
+  }
+
+  file_handle_ = file;
+  size_ = static_cast<uint64_t>(size.QuadPart);
+  opened_ = true;
+  if (size_ == 0) {
+    return Result<void>::Ok();  // 空文件无法映射
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    Close();
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "Failed to map " + path + ": " +
+                                 LastErrorMessage());
+  }
+  mapping_handle_ = mapping;
+
+  data_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!data_) {
+    Close();
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "Failed to map " + path + ": " +
+                                 LastErrorMessage());
+  }
+  return Result<void>::Ok();
+}
+
+void MappedFile::Close() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+    data_ = nullptr;
+  }
+  if (mapping_handle_) {
+    CloseHandle(mapping_handle_);
+    mapping_handle_ = nullptr;
+  }
+  if (file_handle_) {
+    CloseHandle(file_handle_);
+    file_handle_ = nullptr;
+  }
+  size_ = 0;
+  opened_ = false;
+}
+
+#else
+
+Result<void> MappedFile::Open(const std::string& path) {
+  Close();
+
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    return Result<void>::Err(OpenErrorCode(), "Failed to open " + path +
+                                                  ": " + LastErrorMessage());
+  }
+
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) {
+    Close();
+    return Result<void>::Err(ErrorCode::kIOError, "Failed to stat " + path +
+                                                      ": " +
+                                                      LastErrorMessage());
+  }
+
+  size_ = static_cast<uint64_t>(st.st_size);
+  opened_ = true;
+  if (size_ == 0) {
+    return Result<void>::Ok();  // 空文件无法映射
+  }
+
+  void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapped == MAP_FAILED) {
+    Close();
+    return Result<void>::Err(ErrorCode::kIOError, "Failed to mmap " + path +
+                                                      ": " +
+                                                      LastErrorMessage());
+  }
+  // 顺序读取：提示内核加大预读
+  ::madvise(mapped, size_, MADV_SEQUENTIAL);
+  data_ = static_cast<const uint8_t*>(mapped);
+  return Result<void>::Ok();
+}
+
+void MappedFile::Close() {
+  if (data_) {
+    ::munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  size_ = 0;
+  opened_ = false;
+}
+
+#endif
+
+// ============================================================================
+// RandomAccessFile
+// ============================================================================
+
+RandomAccessFile::~RandomAccessFile() {
+  Close();
+}
+
+#ifdef _WIN32
+
+Result<void> RandomAccessFile::Open(const std::string& path) {
+  Close();
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return Result<void>::Err(ErrorCode::kFileAccessDenied,
+                             "Failed to open " + path + ": " +
+                                 LastErrorMessage());
+  }
+  file_handle_ = file;
+  return Result<void>::Ok();
+}
+
+void RandomAccessFile::Close() {
+  if (file_handle_) {
+    CloseHandle(file_handle_);
+    file_handle_ = nullptr;
+  }
+}
+
+bool RandomAccessFile::IsOpen() const {
+  return file_handle_ != nullptr;
+}
+
+Result<void> RandomAccessFile::Preallocate(uint64_t size) {
+  FILE_END_OF_FILE_INFO info;
+  info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+  if (!SetFileInformationByHandle(file_handle_, FileEndOfFileInfo, &info,
+                                  sizeof(info))) {
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "Failed to preallocate: " + LastErrorMessage());
+  }
+  return Result<void>::Ok();
+}
+
+Result<void> RandomAccessFile::WriteAt(uint64_t offset,
+                                       const uint8_t* data,
+                                       size_t length) {
+  while (length > 0) {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFULL);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    const DWORD to_write =
+        static_cast<DWORD>(std::min<size_t>(length, 0x40000000));
+    DWORD written = 0;
+    if (!WriteFile(file_handle_, data, to_write, &written, &overlapped)) {
+      return Result<void>::Err(ErrorCode::kIOError,
+                               "Write failed: " + LastErrorMessage());
+    }
+    data += written;
+    offset += written;
+    length -= written;
+  }
+  return Result<void>::Ok();
+}
+
+Result<size_t> RandomAccessFile::ReadAt(uint64_t offset,
+                                        uint8_t* data,
+                                        size_t length) {
+  OVERLAPPED overlapped = {};
+  overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFULL);
+  overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+  DWORD read = 0;
+  if (!ReadFile(file_handle_, data,
+                static_cast<DWORD>(std::min<size_t>(length, 0x40000000)),
+                &read, &overlapped) &&
+      GetLastError() != ERROR_HANDLE_EOF) {
+    return Result<size_t>::Err(ErrorCode::kIOError,
+                               "Read failed: " + LastErrorMessage());
+  }
+  return Result<size_t>::Ok(read);
+}
+
+Result<uint64_t> RandomAccessFile::GetSize() const {
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file_handle_, &size)) {
+    return Result<uint64_t>::Err(ErrorCode::kIOError,
+                                 "Failed to stat: " + LastErrorMessage());
+  }
+  return Result<uint64_t>::Ok(static_cast<uint64_t>(size.QuadPart));
+}
+
+Result<void> RandomAccessFile::Sync() {
+  if (!FlushFileBuffers(file_handle_)) {
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "Sync failed: " + LastErrorMessage());
+  }
+  return Result<void>::Ok();
+}
+
+#else
+
+Result<void> RandomAccessFile::Open(const std::string& path) {
+  Close();
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    return Result<void>::Err(OpenErrorCode(), "Failed to open " + path +
+                                                  ": " + LastErrorMessage());
+  }
+  return Result<void>::Ok();
+}
+
+void RandomAccessFile::Close() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool RandomAccessFile::IsOpen() const {
+  return fd_ >= 0;
+}
+
+Result<void> RandomAccessFile::Preallocate(uint64_t size) {
+#ifdef __linux__
+  // 不支持 fallocate 的文件系统（如 tmpfs 旧版本）退回 ftruncate；
+  // fallocate 不接受零长度
+  if (size > 0) {
+    if (::fallocate(fd_, 0, 0, static_cast<off_t>(size)) == 0) {
+      return Result<void>::Ok();
+    }
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+      return Result<void>::Err(ErrorCode::kIOError,
+                               "fallocate failed: " + LastErrorMessage());
+    }
+  }
+#endif
+  if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "ftruncate failed: " + LastErrorMessage());
+  }
+  return Result<void>::Ok();
+}
+
+Result<void> RandomAccessFile::WriteAt(uint64_t offset,
+                                       const uint8_t* data,
+                                       size_t length) {
+  while (length > 0) {
+    const ssize_t written =
+        ::pwrite(fd_, data, length, static_cast<off_t>(offset));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Result<void>::Err(ErrorCode::kIOError,
+                               "pwrite failed: " + LastErrorMessage());
+    }
+    data += written;
+    offset += static_cast<uint64_t>(written);
+    length -= static_cast<size_t>(written);
+  }
+  return Result<void>::Ok();
+}
+
+Result<size_t> RandomAccessFile::ReadAt(uint64_t offset,
+                                        uint8_t* data,
+                                        size_t length) {
+  size_t total = 0;
+  while (total < length) {
+    const ssize_t n = ::pread(fd_, data + total, length - total,
+                              static_cast<off_t>(offset + total));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Result<size_t>::Err(ErrorCode::kIOError,
+                                 "pread failed: " + LastErrorMessage());
+    }
+    if (n == 0) {
+      break;
+    }
+    total += static_cast<size_t>(n);
+  }
+  return Result<size_t>::Ok(total);
+}
+
+Result<uint64_t> RandomAccessFile::GetSize() const {
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) {
+    return Result<uint64_t>::Err(ErrorCode::kIOError,
+                                 "fstat failed: " + LastErrorMessage());
+  }
+  return Result<uint64_t>::Ok(static_cast<uint64_t>(st.st_size));
+}
+
+Result<void> RandomAccessFile::Sync() {
+#ifdef __linux__
+  const int result = ::fdatasync(fd_);
+#else
+  const int result = ::fsync(fd_);
+#endif
+  if (result != 0) {
+    return Result<void>::Err(ErrorCode::kIOError,
+                             "fsync failed: " + LastErrorMessage());
+  }
+  return Result<void>::Ok();
+}
+
+#endif
+
+}  // namespace zenremote
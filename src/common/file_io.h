@@ -0,0 +1,89 @@
+/**
+ * @file file_io.h
+ * @brief 大文件读写封装 - 内存映射读取与定位写入
+ *
+ * - MappedFile：只读映射整个文件，发送端可直接引用映射区而不经用户态缓冲复制
+ * - RandomAccessFile：按偏移读写（pread/pwrite），支持预分配磁盘空间
+ *
+ * Windows 使用 CreateFileMapping / ReadFile(OVERLAPPED)，
+ * POSIX 使用 mmap / pread / pwrite / fallocate。
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "common/error.h"
+
+namespace zenremote {
+
+/**
+ * @brief 只读内存映射文件
+ *
+ * 映射在 Close() 或析构前保持有效；配合 std::shared_ptr 的别名构造，
+ * 可把映射区的一段作为 shared_ptr<const uint8_t> 交给发送队列。
+ */
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  Result<void> Open(const std::string& path);
+  void Close();
+
+  bool IsOpen() const { return opened_; }
+  const uint8_t* GetData() const { return data_; }
+  uint64_t GetSize() const { return size_; }
+
+ private:
+#ifdef _WIN32
+  void* file_handle_ = nullptr;
+  void* mapping_handle_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  const uint8_t* data_ = nullptr;
+  uint64_t size_ = 0;
+  bool opened_ = false;
+};
+
+/**
+ * @brief 按偏移读写的文件
+ *
+ * WriteAt/ReadAt 不移动文件指针，可在多个偏移上乱序写入。
+ */
+class RandomAccessFile {
+ public:
+  RandomAccessFile() = default;
+  ~RandomAccessFile();
+
+  RandomAccessFile(const RandomAccessFile&) = delete;
+  RandomAccessFile& operator=(const RandomAccessFile&) = delete;
+
+  /// @brief 打开文件用于读写，不存在时创建
+  Result<void> Open(const std::string& path);
+  void Close();
+  bool IsOpen() const;
+
+  /// @brief 预分配磁盘空间并设置文件长度，减少写入时的碎片与元数据更新
+  Result<void> Preallocate(uint64_t size);
+
+  Result<void> WriteAt(uint64_t offset, const uint8_t* data, size_t length);
+  Result<size_t> ReadAt(uint64_t offset, uint8_t* data, size_t length);
+  Result<uint64_t> GetSize() const;
+  Result<void> Sync();
+
+ private:
+#ifdef _WIN32
+  void* file_handle_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+}  // namespace zenremote
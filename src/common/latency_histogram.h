@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace zenremote {
+
+/**
+ * @brief 无锁延迟直方图
+ *
+ * 桶按对数划分：第 i 个桶的上界为 kFirstBucketUs * 2^(i / kBucketsPerOctave)，
+ * 覆盖 10us 到约 650ms，相对误差约 19%；更大的值计入最后一个桶。
+ * Record() 只做几次原子加，可在流水线各阶段线程中调用；Snapshot() 在任意
+ * 线程读取，结果是近似一致的。
+ */
+class LatencyHistogram {
+ public:
+  static constexpr double kFirstBucketUs = 10.0;
+  static constexpr size_t kBucketsPerOctave = 4;
+  static constexpr size_t kBucketCount = 65;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    double mean_us = 0.0;
+    double p50_us = 0.0;
+    double p90_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+  };
+
+  void Record(double latency_us) {
+    if (latency_us < 0.0) {
+      latency_us = 0.0;
+    }
+    buckets_[BucketIndex(latency_us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    const auto value = static_cast<uint64_t>(latency_us);
+    sum_us_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t max = max_us_.load(std::memory_order_relaxed);
+    while (value > max && !max_us_.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  /// @brief 分位数取所在桶的上界（不超过最大值），落在最后一个桶时取最大值
+  Snapshot GetSnapshot() const {
+    std::array<uint64_t, kBucketCount> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+      counts[i] = buckets_[i].load(std::memory_order_relaxed);
+      total += counts[i];
+    }
+
+    Snapshot snapshot;
+    snapshot.count = total;
+    if (total == 0) {
+      return snapshot;
+    }
+    snapshot.max_us =
+        static_cast<double>(max_us_.load(std::memory_order_relaxed));
+    snapshot.mean_us =
+        static_cast<double>(sum_us_.load(std::memory_order_relaxed)) /
+        static_cast<double>(count_.load(std::memory_order_relaxed));
+
+    auto percentile = [&](double p) {
+      const auto rank =
+          static_cast<uint64_t>(std::ceil(p * static_cast<double>(total)));
+      uint64_t seen = 0;
+      for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts[i];
+        // 最后一个桶没有上界
+        if (seen >= rank && i + 1 < kBucketCount) {
+          return std::fmin(BucketUpperBound(i), snapshot.max_us);
+        }
+      }
+      return snapshot.max_us;
+    };
+    snapshot.p50_us = percentile(0.50);
+    snapshot.p90_us = percentile(0.90);
+    snapshot.p99_us = percentile(0.99);
+    return snapshot;
+  }
+
+  void Reset() {
+    for (auto& bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_us_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+  }
+
+  static double BucketUpperBound(size_t index) {
+    return kFirstBucketUs *
+           std::exp2(static_cast<double>(index) / kBucketsPerOctave);
+  }
+
+ private:
+  static size_t BucketIndex(double latency_us) {
+    if (latency_us <= kFirstBucketUs) {
+      return 0;
+    }
+    const double index =
+        std::ceil(std::log2(latency_us / kFirstBucketUs) * kBucketsPerOctave);
+    return index >= kBucketCount - 1 ? kBucketCount - 1
+                                     : static_cast<size_t>(index);
+  }
+
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_us_{0};
+  std::atomic<uint64_t> max_us_{0};
+};
+
+}  // namespace zenremote
@@ -0,0 +1,97 @@
+#include "slice_pool.h"
+
+#include <algorithm>
+
+namespace zenremote {
+
+SlicePool::SlicePool(size_t threads) {
+  if (threads == 0) {
+    threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  workers_.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+SlicePool::~SlicePool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  start_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void SlicePool::RunImpl(size_t count, TaskFunction function, void* context) {
+  if (count == 0) {
+    return;
+  }
+  if (workers_.empty() || count == 1) {
+    for (size_t i = 0; i < count; ++i) {
+      function(context, i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    function_ = function;
+    context_ = context;
+    count_ = count;
+    next_index_.store(0, std::memory_order_relaxed);
+    active_workers_ = workers_.size();
+    ++generation_;
+  }
+  start_cv_.notify_all();
+
+  Drain(function, context, count);
+
+  // 所有分片已领完，还需等待工作线程执行完手上的分片
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [this]() { return active_workers_ == 0; });
+}
+
+void SlicePool::WorkerLoop() {
+  uint64_t seen_generation = 0;
+  while (true) {
+    TaskFunction function = nullptr;
+    void* context = nullptr;
+    size_t count = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_cv_.wait(lock, [this, seen_generation]() {
+        return stopping_ || generation_ != seen_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+      function = function_;
+      context = context_;
+      count = count_;
+    }
+
+    Drain(function, context, count);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--active_workers_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void SlicePool::Drain(TaskFunction function, void* context, size_t count) {
+  while (true) {
+    const size_t index =
+        next_index_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= count) {
+      return;
+    }
+    function(context, index);
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace zenremote {
+
+/**
+ * @brief 常驻线程的分片并行执行器
+ *
+ * Run(count, task) 把 [0, count) 个分片分给工作线程和调用线程，全部完成后
+ * 返回。线程在构造时创建、析构时退出，每次 Run() 只有一次唤醒和一次汇合，
+ * 不创建线程也不分配内存，适合每帧调用（如按水平条带并行色彩转换）。
+ *
+ * 分片按原子计数领取，先完成的线程继续领取剩余分片。
+ *
+ * 线程安全：同一时刻只能有一个线程调用 Run()；task 不能再调用 Run()。
+ */
+class SlicePool {
+ public:
+  /// @param threads 总并行度（含调用线程），0 表示硬件线程数
+  explicit SlicePool(size_t threads = 0);
+  ~SlicePool();
+
+  SlicePool(const SlicePool&) = delete;
+  SlicePool& operator=(const SlicePool&) = delete;
+
+  /// @brief 对 [0, count) 的每个 index 调用一次 task(index)，等待全部完成
+  template <typename Task>
+  void Run(size_t count, Task&& task) {
+    using TaskType = std::remove_reference_t<Task>;
+    RunImpl(
+        count,
+        [](void* context, size_t index) {
+          (*static_cast<TaskType*>(context))(index);
+        },
+        const_cast<void*>(static_cast<const void*>(&task)));
+  }
+
+  /// @brief 总并行度（含调用线程）
+  size_t GetThreadCount() const { return workers_.size() + 1; }
+
+ private:
+  using TaskFunction = void (*)(void* context, size_t index);
+
+  void RunImpl(size_t count, TaskFunction function, void* context);
+  void WorkerLoop();
+  /// @brief 领取并执行分片，直到全部领完
+  void Drain(TaskFunction function, void* context, size_t count);
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  uint64_t generation_ = 0;  ///< 每次 Run() 加一，唤醒工作线程
+  bool stopping_ = false;
+  TaskFunction function_ = nullptr;
+  void* context_ = nullptr;
+  size_t count_ = 0;
+  size_t active_workers_ = 0;  ///< 尚未完成本轮的工作线程
+
+  std::atomic<size_t> next_index_{0};
+};
+
+}  // namespace zenremote
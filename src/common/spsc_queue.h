@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace zenremote {
+
+/**
+ * @brief 单生产者/单消费者无锁环形队列
+ *
+ * 特性：
+ * - 无锁：生产者只写 tail_，消费者只写 head_，各占一条缓存行
+ * - 原地读写：槽位对象在构造时创建并一直复用，生产者通过 PrepareWrite()
+ *   直接填充槽位，消费者通过 Front() 原地读取，元素（如 std::vector）的
+ *   容量可跨轮次保留，稳态下不再分配内存
+ * - 容量固定，满时 PrepareWrite() 返回 nullptr，由调用方决定丢弃或重试
+ *
+ * 使用场景：
+ * - 网络接收线程把报文交给各轨道的处理线程，接收线程从不阻塞
+ *
+ * @note 生产者侧（PrepareWrite/CommitWrite）与消费者侧（Front/PopFront）
+ *       必须各自固定在一个线程调用
+ * @tparam T 槽位元素类型，需可默认构造
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  /**
+   * @param capacity 可同时容纳的元素数（至少为 1）
+   */
+  explicit SpscQueue(size_t capacity)
+      : size_(capacity + 1), slots_(std::make_unique<T[]>(capacity + 1)) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // ---- 生产者 ----
+
+  /**
+   * @brief 获取下一个可写槽位
+   * @return 槽位指针，队列已满时返回 nullptr
+   */
+  T* PrepareWrite() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t next = Next(tail);
+    if (next == head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &slots_[tail];
+  }
+
+  /// @brief 发布 PrepareWrite() 返回的槽位，之后消费者可见
+  void CommitWrite() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    tail_.store(Next(tail), std::memory_order_release);
+  }
+
+  // ---- 消费者 ----
+
+  /**
+   * @brief 获取队首元素
+   * @return 元素指针，队列为空时返回 nullptr
+   */
+  T* Front() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &slots_[head];
+  }
+
+  /// @brief 释放 Front() 返回的槽位，槽位对象保留以供复用
+  void PopFront() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    head_.store(Next(head), std::memory_order_release);
+  }
+
+  // ---- 任意线程（结果仅为近似值）----
+
+  bool Empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  size_t Size() const {
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + size_ - head;
+  }
+
+  size_t Capacity() const { return size_ - 1; }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  size_t Next(size_t index) const {
+    return index + 1 == size_ ? 0 : index + 1;
+  }
+
+  const size_t size_;  ///< 槽位数 = 容量 + 1（留空一个槽位区分满与空）
+  std::unique_ptr<T[]> slots_;
+
+  alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace zenremote
@@ -0,0 +1,207 @@
+#include "x25519.h"
+
+#include <random>
+
+namespace zenremote {
+
+namespace {
+
+// GF(2^255 - 19) 元素：16 个 16 位分量（存放在 int64 中留出进位空间）
+using Field = int64_t[16];
+
+void Carry(Field o) {
+  for (int i = 0; i < 16; ++i) {
+    o[i] += static_cast<int64_t>(1) << 16;
+    const int64_t c = o[i] >> 16;
+    // 最高分量的进位乘 38（2^256 = 38 mod p）折回最低分量
+    if (i < 15) {
+      o[i + 1] += c - 1;
+    } else {
+      o[0] += 38 * (c - 1);
+    }
+    o[i] -= c * 65536;
+  }
+}
+
+/// @brief b 为 1 时交换 p、q（常量时间）
+void Swap(Field p, Field q, int64_t b) {
+  const int64_t mask = ~(b - 1);
+  for (int i = 0; i < 16; ++i) {
+    const int64_t t = mask & (p[i] ^ q[i]);
+    p[i] ^= t;
+    q[i] ^= t;
+  }
+}
+
+void Pack(uint8_t* out, const Field n) {
+  Field t;
+  Field m;
+  for (int i = 0; i < 16; ++i) {
+    t[i] = n[i];
+  }
+  Carry(t);
+  Carry(t);
+  Carry(t);
+  // 两次条件减 p，得到 [0, p) 内的规范表示
+  for (int j = 0; j < 2; ++j) {
+    m[0] = t[0] - 0xffed;
+    for (int i = 1; i < 15; ++i) {
+      m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+      m[i - 1] &= 0xffff;
+    }
+    m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+    const int64_t borrow = (m[15] >> 16) & 1;
+    m[14] &= 0xffff;
+    Swap(t, m, 1 - borrow);
+  }
+  for (int i = 0; i < 16; ++i) {
+    out[2 * i] = static_cast<uint8_t>(t[i] & 0xff);
+    out[2 * i + 1] = static_cast<uint8_t>(t[i] >> 8);
+  }
+}
+
+void Unpack(Field o, const uint8_t* n) {
+  for (int i = 0; i < 16; ++i) {
+    o[i] = n[2 * i] + (static_cast<int64_t>(n[2 * i + 1]) << 8);
+  }
+  o[15] &= 0x7fff;
+}
+
+void Add(Field o, const Field a, const Field b) {
+  for (int i = 0; i < 16; ++i) {
+    o[i] = a[i] + b[i];
+  }
+}
+
+void Sub(Field o, const Field a, const Field b) {
+  for (int i = 0; i < 16; ++i) {
+    o[i] = a[i] - b[i];
+  }
+}
+
+void Mul(Field o, const Field a, const Field b) {
+  int64_t t[31] = {};
+  for (int i = 0; i < 16; ++i) {
+    for (int j = 0; j < 16; ++j) {
+      t[i + j] += a[i] * b[j];
+    }
+  }
+  for (int i = 0; i < 15; ++i) {
+    t[i] += 38 * t[i + 16];
+  }
+  for (int i = 0; i < 16; ++i) {
+    o[i] = t[i];
+  }
+  Carry(o);
+  Carry(o);
+}
+
+void Square(Field o, const Field a) {
+  Mul(o, a, a);
+}
+
+/// @brief 费马小定理求逆：i^(p-2)
+void Invert(Field o, const Field in) {
+  Field c;
+  for (int i = 0; i < 16; ++i) {
+    c[i] = in[i];
+  }
+  for (int a = 253; a >= 0; --a) {
+    Square(c, c);
+    if (a != 2 && a != 4) {
+      Mul(c, c, in);
+    }
+  }
+  for (int i = 0; i < 16; ++i) {
+    o[i] = c[i];
+  }
+}
+
+}  // namespace
+
+X25519Key X25519(const X25519Key& scalar, const X25519Key& point) {
+  uint8_t z[32];
+  for (int i = 0; i < 32; ++i) {
+    z[i] = scalar[i];
+  }
+  z[31] = static_cast<uint8_t>((z[31] & 127) | 64);
+  z[0] &= 248;
+
+  static const Field k121665 = {0xDB41, 1};
+  Field x;
+  Unpack(x, point.data());
+  Field a = {1};
+  Field b;
+  Field c = {};
+  Field d = {1};
+  Field e;
+  Field f;
+  for (int i = 0; i < 16; ++i) {
+    b[i] = x[i];
+  }
+
+  // Montgomery ladder（RFC 7748 5 节）
+  for (int i = 254; i >= 0; --i) {
+    const int64_t bit = (z[i >> 3] >> (i & 7)) & 1;
+    Swap(a, b, bit);
+    Swap(c, d, bit);
+    Add(e, a, c);
+    Sub(a, a, c);
+    Add(c, b, d);
+    Sub(b, b, d);
+    Square(d, e);
+    Square(f, a);
+    Mul(a, c, a);
+    Mul(c, b, e);
+    Add(e, a, c);
+    Sub(a, a, c);
+    Square(b, a);
+    Sub(c, d, f);
+    Mul(a, c, k121665);
+    Add(a, a, d);
+    Mul(c, c, a);
+    Mul(a, d, f);
+    Mul(d, b, x);
+    Square(b, e);
+    Swap(a, b, bit);
+    Swap(c, d, bit);
+  }
+
+  Invert(c, c);
+  Mul(a, a, c);
+  X25519Key out;
+  Pack(out.data(), a);
+  return out;
+}
+
+X25519Key X25519PublicKey(const X25519Key& private_key) {
+  X25519Key base{};
+  base[0] = 9;
+  return X25519(private_key, base);
+}
+
+X25519KeyPair GenerateX25519KeyPair() {
+  std::random_device random;
+  X25519KeyPair pair;
+  for (size_t i = 0; i < pair.private_key.size(); i += 4) {
+    const uint32_t value = random();
+    for (size_t j = 0; j < 4; ++j) {
+      pair.private_key[i + j] = static_cast<uint8_t>(value >> (8 * j));
+    }
+  }
+  pair.public_key = X25519PublicKey(pair.private_key);
+  return pair;
+}
+
+bool X25519SharedSecret(const X25519Key& private_key,
+                        const X25519Key& peer_public_key,
+                        X25519Key& shared_secret) {
+  shared_secret = X25519(private_key, peer_public_key);
+  uint8_t accumulated = 0;
+  for (uint8_t byte : shared_secret) {
+    accumulated |= byte;
+  }
+  return accumulated != 0;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,44 @@
+/**
+ * @file x25519.h
+ * @brief X25519 密钥交换（RFC 7748）
+ *
+ * 握手时双方各生成一次性密钥对并交换公钥，ECDH 共享密钥经 HKDF 派生出
+ * SRTP 主密钥（见 network/protocol/srtp.h）。每个会话只做一次标量乘法，
+ * 使用 16 x 16 位分量的可移植实现，按私钥位做常量时间条件交换。
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace zenremote {
+
+constexpr size_t kX25519KeySize = 32;
+
+using X25519Key = std::array<uint8_t, kX25519KeySize>;
+
+struct X25519KeyPair {
+  X25519Key private_key{};
+  X25519Key public_key{};
+};
+
+/// @brief 标量乘法 scalar * point（u 坐标），私钥按 RFC 7748 5 节裁剪
+X25519Key X25519(const X25519Key& scalar, const X25519Key& point);
+
+/// @brief 私钥对应的公钥（与基点 9 相乘）
+X25519Key X25519PublicKey(const X25519Key& private_key);
+
+/// @brief 用系统随机源生成一次性密钥对
+X25519KeyPair GenerateX25519KeyPair();
+
+/**
+ * @brief ECDH 共享密钥
+ * @return 对端公钥为小阶点（结果全 0）时返回 false
+ */
+bool X25519SharedSecret(const X25519Key& private_key,
+                        const X25519Key& peer_public_key,
+                        X25519Key& shared_secret);
+
+}  // namespace zenremote
@@ -5,6 +5,7 @@
 #include <QStyleFactory>
 #include <QTextStream>
 
+#include "app/server/headless_host.h"
 #include "common/log_manager.h"
 #include "loki/src/main_message_loop_with_not_main_thread.h"
 #include "loki/src/threading/loki_thread.h"
@@ -21,6 +22,11 @@ class ZenPlayMessageLoopDelegate : public loki::MainMessageLoop::Delegate {
 };
 
 int main(int argc, char* argv[]) {
+  // 无头模式（Linux 服务器）：不创建 QApplication，不需要显示服务
+  if (zenremote::IsHeadlessCommandLine(argc, argv)) {
+    return zenremote::RunHeadlessHost(argc, argv);
+  }
+
   QApplication app(argc, argv);
 
   // 初始化日志系统
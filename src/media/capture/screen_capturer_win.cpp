@@ -137,6 +137,7 @@ bool ScreenCapturerDxgi::Start() {
 
   is_running_ = true;
   frame_count_ = 0;
+  fps_frame_count_ = 0;
   fps_timer_.Reset();
 
   ZENREMOTE_INFO("ScreenCapturerDxgi started");
@@ -197,8 +198,15 @@ std::optional<Frame> ScreenCapturerDxgi::CaptureFrame() {
     return std::nullopt;
   }
 
+  // LastPresentTime 为 0 表示只有鼠标指针更新,桌面图像没有变化:
+  // Staging Texture 中仍是上一帧,不必复制,也没有脏区域
+  const bool image_updated =
+      frame_info.LastPresentTime.QuadPart != 0 || frame_count_ == 0;
+
   // 复制到 Staging Texture(CPU 可访问)
-  d3d_context_->CopyResource(staging_texture_, frame_texture);
+  if (image_updated) {
+    d3d_context_->CopyResource(staging_texture_, frame_texture);
+  }
   frame_texture->Release();
 
   // 映射 Staging Texture 以获取像素数据
@@ -233,7 +241,9 @@ std::optional<Frame> ScreenCapturerDxgi::CaptureFrame() {
   frame.metadata.accumulated_frames = frame_info.AccumulatedFrames;
 
   // 处理脏区域
-  if (config_.enable_dirty_rect) {
+  if (!image_updated) {
+    // 静止画面: 脏区域和移动区域均为空
+  } else if (config_.enable_dirty_rect) {
     ExtractDirtyRects(frame_info, &frame.metadata);
   } else {
     // 没有脏区域: 整个屏幕被标记为需要编码
@@ -241,7 +251,7 @@ std::optional<Frame> ScreenCapturerDxgi::CaptureFrame() {
   }
 
   // 处理移动区域
-  if (config_.enable_move_rect) {
+  if (image_updated && config_.enable_move_rect) {
     ExtractMoveRects(frame_info, &frame.metadata);
   }
 
@@ -254,6 +264,7 @@ std::optional<Frame> ScreenCapturerDxgi::CaptureFrame() {
 
   // 更新 FPS 计数
   frame_count_++;
+  fps_frame_count_++;
   UpdateFpsCounter();
 
   // 注意: 此时 staging_texture_ 仍被映射,需要在 ReleaseFrame() 后 Unmap
@@ -584,8 +595,9 @@ void ScreenCapturerDxgi::UpdateFpsCounter() {
   const int64_t elapsed_ms = fps_timer_.ElapsedMsInt();
 
   if (elapsed_ms >= 1000) {  // 每秒更新一次
-    current_fps_ = static_cast<uint32_t>(frame_count_ * 1000 / elapsed_ms);
-    frame_count_ = 0;
+    current_fps_ =
+        static_cast<uint32_t>(fps_frame_count_ * 1000 / elapsed_ms);
+    fps_frame_count_ = 0;
     fps_timer_.Reset();
     ZENREMOTE_DEBUG("Capture FPS: {}", current_fps_);
   }
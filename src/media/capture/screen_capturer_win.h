@@ -72,11 +72,12 @@ class ScreenCapturerDxgi : public ScreenCapturer {
   int32_t height_;
   int32_t stride_;  // 一行的字节数
   uint32_t current_fps_;
-  uint32_t frame_count_;
+  uint32_t frame_count_;  // 启动以来的帧数(0 表示首帧,需要关键帧)
   bool should_force_key_frame_;
 
   // 帧率统计
   TimerUtil fps_timer_{};
+  uint32_t fps_frame_count_ = 0;  // 当前统计窗口内的帧数
 
   // 当前映射的资源(用于 Unmap)
   D3D11_MAPPED_SUBRESOURCE last_mapped_resource_;
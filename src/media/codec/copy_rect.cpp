@@ -0,0 +1,571 @@
+#include "copy_rect.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+using media::capture::MoveRect;
+
+/// user_data_unregistered 的 UUID："zenremote-copy01"
+constexpr uint8_t kCopyRectUuid[16] = {'z', 'e', 'n', 'r', 'e', 'm', 'o', 't',
+                                       'e', '-', 'c', 'o', 'p', 'y', '0', '1'};
+constexpr uint8_t kCopyRectVersion = 1;
+constexpr int kSeiUserDataUnregistered = 5;
+constexpr uint8_t kH264NalSei = 6;
+constexpr uint8_t kHevcNalPrefixSei = 39;
+
+/// [version:u8][copies:u8][residuals:u8]
+constexpr size_t kCommandHeaderSize = 3;
+/// [src left/top/right/bottom:u16][dst left/top:u16]
+constexpr size_t kCopyEntrySize = 12;
+/// [left/top/right/bottom:u16]
+constexpr size_t kResidualEntrySize = 8;
+
+bool IsEmpty(const DirtyRect& rect) {
+  return rect.Width() <= 0 || rect.Height() <= 0;
+}
+
+bool IsEven(const DirtyRect& rect) {
+  return ((rect.left | rect.top | rect.right | rect.bottom) & 1) == 0;
+}
+
+DirtyRect Intersect(const DirtyRect& a, const DirtyRect& b) {
+  return {std::max(a.left, b.left), std::max(a.top, b.top),
+          std::min(a.right, b.right), std::min(a.bottom, b.bottom)};
+}
+
+bool Contains(const DirtyRect& outer, const DirtyRect& inner) {
+  return outer.left <= inner.left && outer.top <= inner.top &&
+         outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+/// a 减去 b，结果（至多 4 个）追加到 out
+void Subtract(const DirtyRect& a,
+              const DirtyRect& b,
+              std::vector<DirtyRect>& out) {
+  const DirtyRect overlap = Intersect(a, b);
+  if (IsEmpty(overlap)) {
+    out.push_back(a);
+    return;
+  }
+  const DirtyRect pieces[] = {
+      {a.left, a.top, a.right, overlap.top},
+      {a.left, overlap.bottom, a.right, a.bottom},
+      {a.left, overlap.top, overlap.left, overlap.bottom},
+      {overlap.right, overlap.top, a.right, overlap.bottom},
+  };
+  for (const auto& piece : pieces) {
+    if (!IsEmpty(piece)) {
+      out.push_back(piece);
+    }
+  }
+}
+
+bool NalIsSei(const uint8_t* nal, AVCodecID codec) {
+  return codec == AV_CODEC_ID_HEVC ? ((nal[0] >> 1) & 0x3F) == kHevcNalPrefixSei
+                                   : (nal[0] & 0x1F) == kH264NalSei;
+}
+
+bool NalIsVcl(const uint8_t* nal, AVCodecID codec) {
+  if (codec == AV_CODEC_ID_HEVC) {
+    return ((nal[0] >> 1) & 0x3F) < 32;
+  }
+  const int type = nal[0] & 0x1F;
+  return type >= 1 && type <= 5;
+}
+
+size_t NalHeaderSize(AVCodecID codec) {
+  return codec == AV_CODEC_ID_HEVC ? 2 : 1;
+}
+
+/// 返回 from 之后第一个 00 00 01 的位置，没有时返回 length
+size_t FindStartCode(const uint8_t* data, size_t length, size_t from) {
+  for (size_t i = from; i + 3 <= length; ++i) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      return i;
+    }
+  }
+  return length;
+}
+
+void WriteU16(std::vector<uint8_t>& out, int32_t value) {
+  out.push_back(static_cast<uint8_t>(value >> 8));
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+int32_t ReadU16(const uint8_t* data) {
+  return static_cast<int32_t>((data[0] << 8) | data[1]);
+}
+
+bool FitsU16(const DirtyRect& rect) {
+  return rect.left >= 0 && rect.top >= 0 && rect.right <= 0xFFFF &&
+         rect.bottom <= 0xFFFF && !IsEmpty(rect);
+}
+
+std::optional<CopyRectCommand> DecodeCommand(const uint8_t* data,
+                                             size_t length) {
+  if (length < kCommandHeaderSize || data[0] != kCopyRectVersion) {
+    return std::nullopt;
+  }
+  const size_t copies = data[1];
+  const size_t residuals = data[2];
+  if (length < kCommandHeaderSize + copies * kCopyEntrySize +
+                   residuals * kResidualEntrySize) {
+    return std::nullopt;
+  }
+  CopyRectCommand command;
+  const uint8_t* cursor = data + kCommandHeaderSize;
+  for (size_t i = 0; i < copies; ++i, cursor += kCopyEntrySize) {
+    MoveRect move;
+    move.source = {ReadU16(cursor), ReadU16(cursor + 2), ReadU16(cursor + 4),
+                   ReadU16(cursor + 6)};
+    const int32_t left = ReadU16(cursor + 8);
+    const int32_t top = ReadU16(cursor + 10);
+    move.destination = {left, top, left + move.source.Width(),
+                        top + move.source.Height()};
+    if (IsEmpty(move.source)) {
+      return std::nullopt;
+    }
+    command.copies.push_back(move);
+  }
+  for (size_t i = 0; i < residuals; ++i, cursor += kResidualEntrySize) {
+    const DirtyRect rect{ReadU16(cursor), ReadU16(cursor + 2),
+                         ReadU16(cursor + 4), ReadU16(cursor + 6)};
+    if (IsEmpty(rect)) {
+      return std::nullopt;
+    }
+    command.residual_rects.push_back(rect);
+  }
+  return command;
+}
+
+/// 像素格式的平面布局：每个平面的字节/像素与色度下采样
+struct PlaneLayout {
+  int planes = 0;
+  int bytes_per_pixel[3] = {};
+  int shift_x[3] = {};
+  int shift_y[3] = {};
+};
+
+bool GetPlaneLayout(int format, PlaneLayout& layout) {
+  switch (format) {
+    case AV_PIX_FMT_NV12:
+      layout = {2, {1, 2, 0}, {0, 1, 0}, {0, 1, 0}};
+      return true;
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+      layout = {3, {1, 1, 1}, {0, 1, 1}, {0, 1, 1}};
+      return true;
+    case AV_PIX_FMT_BGRA:
+    case AV_PIX_FMT_RGBA:
+      layout = {1, {4, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+      return true;
+    default:
+      return false;
+  }
+}
+
+/// 把 src 中的 rect 复制到 dst 的 (x, y)；src 与 dst 可以是同一帧且重叠
+void CopyRegion(const PlaneLayout& layout,
+                const AVFrame* src,
+                const DirtyRect& rect,
+                AVFrame* dst,
+                int32_t x,
+                int32_t y) {
+  for (int plane = 0; plane < layout.planes; ++plane) {
+    const int bpp = layout.bytes_per_pixel[plane];
+    const int sx = layout.shift_x[plane];
+    const int sy = layout.shift_y[plane];
+    const int rows = rect.Height() >> sy;
+    const auto bytes = static_cast<size_t>((rect.Width() >> sx) * bpp);
+    const uint8_t* from = src->data[plane] +
+                          static_cast<ptrdiff_t>(rect.top >> sy) *
+                              src->linesize[plane] +
+                          (rect.left >> sx) * bpp;
+    uint8_t* to = dst->data[plane] +
+                  static_cast<ptrdiff_t>(y >> sy) * dst->linesize[plane] +
+                  (x >> sx) * bpp;
+    // 向下滚动时源在目标之上，自下而上复制才不会覆盖未读的行
+    const bool bottom_up = src == dst && y > rect.top;
+    for (int i = 0; i < rows; ++i) {
+      const int row = bottom_up ? rows - 1 - i : i;
+      std::memmove(to + static_cast<ptrdiff_t>(row) * dst->linesize[plane],
+                   from + static_cast<ptrdiff_t>(row) * src->linesize[plane],
+                   bytes);
+    }
+  }
+}
+
+bool FitsFrame(const DirtyRect& rect, const AVFrame* frame) {
+  return IsEven(rect) && !IsEmpty(rect) && rect.left >= 0 && rect.top >= 0 &&
+         rect.right <= frame->width && rect.bottom <= frame->height;
+}
+
+}  // namespace
+
+Result<std::vector<uint8_t>> BuildCopyRectSei(const CopyRectCommand& command,
+                                              AVCodecID codec) {
+  if (codec != AV_CODEC_ID_H264 && codec != AV_CODEC_ID_HEVC) {
+    return Result<std::vector<uint8_t>>::Err(
+        ErrorCode::kUnsupportedCodec, "Copy-rect SEI needs H.264 or HEVC");
+  }
+  if (command.copies.size() > 0xFF || command.residual_rects.size() > 0xFF) {
+    return Result<std::vector<uint8_t>>::Err(ErrorCode::kInvalidParameter,
+                                             "Too many copy-rect regions");
+  }
+
+  std::vector<uint8_t> payload(kCopyRectUuid,
+                               kCopyRectUuid + sizeof(kCopyRectUuid));
+  payload.push_back(kCopyRectVersion);
+  payload.push_back(static_cast<uint8_t>(command.copies.size()));
+  payload.push_back(static_cast<uint8_t>(command.residual_rects.size()));
+  for (const auto& copy : command.copies) {
+    if (!FitsU16(copy.source) || !FitsU16(copy.destination) ||
+        copy.source.Width() != copy.destination.Width() ||
+        copy.source.Height() != copy.destination.Height()) {
+      return Result<std::vector<uint8_t>>::Err(ErrorCode::kInvalidParameter,
+                                               "Invalid copy rect");
+    }
+    WriteU16(payload, copy.source.left);
+    WriteU16(payload, copy.source.top);
+    WriteU16(payload, copy.source.right);
+    WriteU16(payload, copy.source.bottom);
+    WriteU16(payload, copy.destination.left);
+    WriteU16(payload, copy.destination.top);
+  }
+  for (const auto& rect : command.residual_rects) {
+    if (!FitsU16(rect)) {
+      return Result<std::vector<uint8_t>>::Err(ErrorCode::kInvalidParameter,
+                                               "Invalid residual rect");
+    }
+    WriteU16(payload, rect.left);
+    WriteU16(payload, rect.top);
+    WriteU16(payload, rect.right);
+    WriteU16(payload, rect.bottom);
+  }
+
+  // sei_message：payload_type、payload_size 以 0xFF 延续编码
+  std::vector<uint8_t> rbsp;
+  rbsp.push_back(kSeiUserDataUnregistered);
+  size_t size = payload.size();
+  for (; size >= 0xFF; size -= 0xFF) {
+    rbsp.push_back(0xFF);
+  }
+  rbsp.push_back(static_cast<uint8_t>(size));
+  rbsp.insert(rbsp.end(), payload.begin(), payload.end());
+  rbsp.push_back(0x80);  // rbsp_trailing_bits
+
+  std::vector<uint8_t> nal = {0, 0, 0, 1};
+  if (codec == AV_CODEC_ID_HEVC) {
+    nal.push_back(kHevcNalPrefixSei << 1);
+    nal.push_back(1);  // nuh_layer_id 0，nuh_temporal_id_plus1 1
+  } else {
+    nal.push_back(kH264NalSei);
+  }
+  // 防竞争字节：00 00 之后的 00~03 前插入 03
+  int zeros = 0;
+  for (uint8_t byte : rbsp) {
+    if (zeros >= 2 && byte <= 3) {
+      nal.push_back(3);
+      zeros = 0;
+    }
+    nal.push_back(byte);
+    zeros = byte == 0 ? zeros + 1 : 0;
+  }
+  return Result<std::vector<uint8_t>>::Ok(std::move(nal));
+}
+
+Result<void> InsertCopyRectSei(const std::vector<uint8_t>& sei,
+                               AVCodecID codec,
+                               std::vector<uint8_t>& access_unit) {
+  const uint8_t* data = access_unit.data();
+  const size_t length = access_unit.size();
+  const size_t header_size = NalHeaderSize(codec);
+  for (size_t pos = FindStartCode(data, length, 0); pos < length;
+       pos = FindStartCode(data, length, pos + 3)) {
+    const size_t nal = pos + 3;
+    if (nal + header_size > length || !NalIsVcl(data + nal, codec)) {
+      continue;
+    }
+    // 四字节起始码的前导 0 属于这个 NAL
+    const size_t insert_at = pos > 0 && data[pos - 1] == 0 ? pos - 1 : pos;
+    access_unit.insert(
+        access_unit.begin() + static_cast<std::ptrdiff_t>(insert_at),
+        sei.begin(), sei.end());
+    return Result<void>::Ok();
+  }
+  return Result<void>::Err(ErrorCode::kInvalidParameter,
+                           "No Annex B slice in access unit");
+}
+
+std::optional<CopyRectCommand> ParseCopyRectSei(const uint8_t* data,
+                                                size_t length,
+                                                AVCodecID codec) {
+  if (!data || (codec != AV_CODEC_ID_H264 && codec != AV_CODEC_ID_HEVC)) {
+    return std::nullopt;
+  }
+  const size_t header_size = NalHeaderSize(codec);
+  std::vector<uint8_t> rbsp;
+  for (size_t pos = FindStartCode(data, length, 0); pos < length;) {
+    const size_t begin = pos + 3;
+    pos = FindStartCode(data, length, begin);
+    if (begin + header_size > pos) {
+      continue;
+    }
+    if (NalIsVcl(data + begin, codec)) {
+      break;  // 本帧的 SEI 都在条带之前
+    }
+    if (!NalIsSei(data + begin, codec)) {
+      continue;
+    }
+
+    rbsp.clear();
+    int zeros = 0;
+    for (size_t i = begin + header_size; i < pos; ++i) {
+      if (zeros >= 2 && data[i] == 3) {
+        zeros = 0;
+        continue;
+      }
+      rbsp.push_back(data[i]);
+      zeros = data[i] == 0 ? zeros + 1 : 0;
+    }
+
+    size_t cursor = 0;
+    while (rbsp.size() - cursor >= 2) {
+      size_t type = 0;
+      while (cursor < rbsp.size() && rbsp[cursor] == 0xFF) {
+        type += 0xFF;
+        ++cursor;
+      }
+      if (cursor >= rbsp.size()) {
+        break;
+      }
+      type += rbsp[cursor++];
+      size_t size = 0;
+      while (cursor < rbsp.size() && rbsp[cursor] == 0xFF) {
+        size += 0xFF;
+        ++cursor;
+      }
+      if (cursor >= rbsp.size()) {
+        break;
+      }
+      size += rbsp[cursor++];
+      if (size > rbsp.size() - cursor) {
+        break;
+      }
+      const uint8_t* message = rbsp.data() + cursor;
+      if (type == kSeiUserDataUnregistered && size >= sizeof(kCopyRectUuid) &&
+          std::memcmp(message, kCopyRectUuid, sizeof(kCopyRectUuid)) == 0) {
+        return DecodeCommand(message + sizeof(kCopyRectUuid),
+                             size - sizeof(kCopyRectUuid));
+      }
+      cursor += size;
+    }
+  }
+  return std::nullopt;
+}
+
+void CopyRectTracker::Reset(int width, int height) {
+  width_ = width;
+  height_ = height;
+  composited_ = false;
+  copies_.clear();
+  residual_.clear();
+}
+
+void CopyRectTracker::AddResidual(DirtyRect rect) {
+  // 外扩到偶数坐标，4:2:0 的色度与亮度一起更新
+  rect.left &= ~1;
+  rect.top &= ~1;
+  rect.right = (rect.right + 1) & ~1;
+  rect.bottom = (rect.bottom + 1) & ~1;
+  rect = Intersect(rect, {0, 0, width_, height_});
+  if (IsEmpty(rect)) {
+    return;
+  }
+  for (const auto& existing : residual_) {
+    if (Contains(existing, rect)) {
+      return;
+    }
+  }
+  residual_.erase(std::remove_if(residual_.begin(), residual_.end(),
+                                 [&rect](const DirtyRect& existing) {
+                                   return Contains(rect, existing);
+                                 }),
+                  residual_.end());
+  residual_.push_back(rect);
+}
+
+void CopyRectTracker::AddFrame(const std::vector<DirtyRect>& dirty_rects,
+                               const std::vector<MoveRect>& move_rects) {
+  const DirtyRect frame{0, 0, width_, height_};
+  frame_destinations_.clear();
+  for (const auto& move : move_rects) {
+    const DirtyRect& source = move.source;
+    const DirtyRect& destination = move.destination;
+    bool copyable = !IsEmpty(source) && IsEven(source) &&
+                    IsEven(destination) &&
+                    source.Width() == destination.Width() &&
+                    source.Height() == destination.Height() &&
+                    Contains(frame, source) && Contains(frame, destination) &&
+                    copies_.size() < kMaxCopyRects;
+    for (const auto& written : frame_destinations_) {
+      copyable = copyable && IsEmpty(Intersect(source, written));
+    }
+    if (copyable && source.left == destination.left &&
+        source.top == destination.top) {
+      continue;
+    }
+    frame_destinations_.push_back(destination);
+    if (!copyable) {
+      AddResidual(destination);
+      continue;
+    }
+
+    // 接收端复制前尚未更新的像素被复制到目标区域，残差随之平移
+    const int32_t dx = destination.left - source.left;
+    const int32_t dy = destination.top - source.top;
+    scratch_.clear();
+    for (const auto& rect : residual_) {
+      Subtract(rect, destination, scratch_);
+    }
+    for (const auto& rect : residual_) {
+      const DirtyRect moved = Intersect(rect, source);
+      if (!IsEmpty(moved)) {
+        scratch_.push_back({moved.left + dx, moved.top + dy, moved.right + dx,
+                            moved.bottom + dy});
+      }
+    }
+    residual_.clear();
+    for (const auto& rect : scratch_) {
+      AddResidual(rect);
+    }
+    copies_.push_back(move);
+  }
+
+  for (const auto& rect : dirty_rects) {
+    AddResidual(rect);
+  }
+  if (residual_.size() > kMaxResidualRects) {
+    // 外接矩形整块转换，编码器输入帧在其中与屏幕一致，贴上去仍然正确
+    DirtyRect bounds = residual_.front();
+    for (const auto& rect : residual_) {
+      bounds = {std::min(bounds.left, rect.left),
+                std::min(bounds.top, rect.top),
+                std::max(bounds.right, rect.right),
+                std::max(bounds.bottom, rect.bottom)};
+    }
+    residual_.assign(1, bounds);
+  }
+}
+
+bool CopyRectTracker::TakeCommand(CopyRectCommand& command) {
+  if (copies_.empty() && !composited_) {
+    residual_.clear();
+    return false;
+  }
+  command.copies.assign(copies_.begin(), copies_.end());
+  command.residual_rects.assign(residual_.begin(), residual_.end());
+  copies_.clear();
+  residual_.clear();
+  composited_ = true;
+  return true;
+}
+
+CopyRectCompositor::CopyRectCompositor()
+    : last_decoded_(MakeAVFrame()), display_(MakeAVFrame()) {}
+
+void CopyRectCompositor::Reset() {
+  if (last_decoded_) {
+    av_frame_unref(last_decoded_.get());
+  }
+  composited_ = false;
+}
+
+Result<const AVFrame*> CopyRectCompositor::Compose(
+    const AVFrame* decoded,
+    const CopyRectCommand* command) {
+  if (!decoded || !decoded->data[0] || decoded->width <= 0 ||
+      decoded->height <= 0) {
+    return Result<const AVFrame*>::Err(ErrorCode::kInvalidParameter,
+                                       "Invalid decoded frame");
+  }
+  if (!last_decoded_ || !display_) {
+    return Result<const AVFrame*>::Err(ErrorCode::kOutOfMemory,
+                                       "Failed to allocate frame");
+  }
+
+  if (!command) {
+    composited_ = false;
+    av_frame_unref(last_decoded_.get());
+    if (av_frame_ref(last_decoded_.get(), decoded) < 0) {
+      return Result<const AVFrame*>::Err(ErrorCode::kOutOfMemory,
+                                         "Failed to reference frame");
+    }
+    return Result<const AVFrame*>::Ok(decoded);
+  }
+
+  PlaneLayout layout;
+  if (!GetPlaneLayout(decoded->format, layout)) {
+    return Result<const AVFrame*>::Err(ErrorCode::kUnsupportedPixelFormat,
+                                       "Copy-rect needs a software frame");
+  }
+  const DirtyRect whole{0, 0, decoded->width, decoded->height};
+  if (!composited_) {
+    const AVFrame* base = last_decoded_.get();
+    if (!base->data[0] || base->width != decoded->width ||
+        base->height != decoded->height || base->format != decoded->format) {
+      return Result<const AVFrame*>::Err(ErrorCode::kInvalidState,
+                                         "No base frame for copy-rect");
+    }
+    if (!display_->data[0] || display_->width != decoded->width ||
+        display_->height != decoded->height ||
+        display_->format != decoded->format) {
+      av_frame_unref(display_.get());
+      display_->format = decoded->format;
+      display_->width = decoded->width;
+      display_->height = decoded->height;
+      if (av_frame_get_buffer(display_.get(), 32) < 0) {
+        return Result<const AVFrame*>::Err(ErrorCode::kOutOfMemory,
+                                           "Failed to allocate display frame");
+      }
+    }
+    CopyRegion(layout, base, whole, display_.get(), 0, 0);
+    av_frame_unref(last_decoded_.get());
+    composited_ = true;
+  } else if (display_->width != decoded->width ||
+             display_->height != decoded->height ||
+             display_->format != decoded->format) {
+    return Result<const AVFrame*>::Err(ErrorCode::kInvalidState,
+                                       "Frame size changed while composited");
+  }
+
+  for (const auto& copy : command->copies) {
+    if (!FitsFrame(copy.source, decoded) ||
+        !FitsFrame(copy.destination, decoded)) {
+      return Result<const AVFrame*>::Err(ErrorCode::kInvalidParameter,
+                                         "Copy rect outside frame");
+    }
+  }
+  for (const auto& rect : command->residual_rects) {
+    if (!FitsFrame(rect, decoded)) {
+      return Result<const AVFrame*>::Err(ErrorCode::kInvalidParameter,
+                                         "Residual rect outside frame");
+    }
+  }
+  for (const auto& copy : command->copies) {
+    CopyRegion(layout, display_.get(), copy.source, display_.get(),
+               copy.destination.left, copy.destination.top);
+  }
+  for (const auto& rect : command->residual_rects) {
+    CopyRegion(layout, decoded, rect, display_.get(), rect.left, rect.top);
+  }
+  display_->pts = decoded->pts;
+  return Result<const AVFrame*>::Ok(display_.get());
+}
+
+}  // namespace zenremote
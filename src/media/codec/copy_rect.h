@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "../../common/error.h"
+#include "../capture/screen_capturer.h"
+#include "ffmpeg_types.h"
+
+namespace zenremote {
+
+/**
+ * @brief 随视频帧发送的复制命令（滚动、窗口拖动）
+ *
+ * 接收端在上一次显示的画面上依次执行 copies（destination 与 source
+ * 同尺寸，按顺序执行，源与目标可以重叠），再把本帧解码结果中
+ * residual_rects 覆盖的区域贴上去。其余区域沿用上一次显示的内容，
+ * 解码帧在这些位置的像素不显示。
+ *
+ * 坐标为编码帧像素坐标，均为偶数（4:2:0 色度平面逐像素对应）。
+ */
+struct CopyRectCommand {
+  std::vector<media::capture::MoveRect> copies;
+  std::vector<media::capture::DirtyRect> residual_rects;
+};
+
+/// 每条命令的复制区域上限，超出的移动区域按脏区域编码
+constexpr size_t kMaxCopyRects = 16;
+/// 每条命令的残差区域上限，超出时取外接矩形
+constexpr size_t kMaxResidualRects = 32;
+
+/**
+ * @brief 把命令编码为 SEI（user_data_unregistered）NAL 单元，含起始码
+ *
+ * 不认识该 UUID 的解码器忽略它，命令与所属帧在同一个访问单元中传输、
+ * 丢失和重传，不需要额外的通道与时间戳匹配。
+ * @param codec AV_CODEC_ID_H264 或 AV_CODEC_ID_HEVC
+ */
+Result<std::vector<uint8_t>> BuildCopyRectSei(const CopyRectCommand& command,
+                                              AVCodecID codec);
+
+/**
+ * @brief 把 BuildCopyRectSei() 的输出插入 Annex B 访问单元的第一个 VCL NAL
+ *        之前（SEI 须位于本帧的条带之前）
+ */
+Result<void> InsertCopyRectSei(const std::vector<uint8_t>& sei,
+                               AVCodecID codec,
+                               std::vector<uint8_t>& access_unit);
+
+/// @brief 从 Annex B 访问单元中查找复制命令，没有时返回 std::nullopt
+std::optional<CopyRectCommand> ParseCopyRectSei(const uint8_t* data,
+                                                size_t length,
+                                                AVCodecID codec);
+
+/**
+ * @brief 发送端：累积采集帧的脏区域与移动区域，生成复制命令
+ *
+ * 编码器的参考帧是上一次编码的画面，不会随滚动平移；因此移动区域不转换
+ * 到编码器输入帧上，编码器在这些位置看到的是没有变化的内容（编为 skip
+ * 块），只有新露出的条带和其他脏区域（GetResidualRects()）需要转换和
+ * 编码。这样编码器输入帧在移动过的位置与屏幕不一致，此后每一帧都必须
+ * 带命令（可以没有 copies），直到整帧转换后调用 Reset()。
+ *
+ * 多帧合并（中间的帧被丢弃）时逐帧调用 AddFrame()：接收端执行复制前
+ * 尚未更新的像素随复制移动，对应的残差区域也跟着平移。同一采集帧内的
+ * 移动区域以上一帧为源，源与本帧较早的目标相交时不能顺序执行，按脏区域
+ * 处理。奇数坐标、越界或超出 kMaxCopyRects 的移动区域同样按脏区域处理。
+ *
+ * 非线程安全。
+ */
+class CopyRectTracker {
+ public:
+  /// @brief 整帧更新后调用：编码器输入帧与屏幕一致，接收端直接显示解码帧
+  void Reset(int width, int height);
+
+  /// @brief 并入一个采集帧的变化（坐标为编码帧坐标）
+  void AddFrame(const std::vector<media::capture::DirtyRect>& dirty_rects,
+                const std::vector<media::capture::MoveRect>& move_rects);
+
+  /// @brief 需要转换到编码器输入帧、并由接收端从解码帧贴上的区域
+  const std::vector<media::capture::DirtyRect>& GetResidualRects() const {
+    return residual_;
+  }
+
+  /**
+   * @brief 取出本帧的命令并清空累积的区域
+   * @return false 表示本帧不需要命令，接收端直接显示解码帧
+   */
+  bool TakeCommand(CopyRectCommand& command);
+
+  /// @brief 编码器输入帧与屏幕不一致（已发送过复制命令）
+  bool IsComposited() const { return composited_; }
+
+ private:
+  void AddResidual(media::capture::DirtyRect rect);
+
+  int width_ = 0;
+  int height_ = 0;
+  bool composited_ = false;
+  std::vector<media::capture::MoveRect> copies_;
+  std::vector<media::capture::DirtyRect> residual_;
+  std::vector<media::capture::DirtyRect> scratch_;
+  std::vector<media::capture::DirtyRect> frame_destinations_;
+};
+
+/**
+ * @brief 接收端：按复制命令合成显示的画面
+ *
+ * 没有命令的帧原样返回，并保留一个引用作为下一条命令的基准；有命令时
+ * 在内部的显示帧上执行复制并贴上残差区域。进入合成状态时复制一次
+ * 基准帧，之后在显示帧上原地更新。
+ *
+ * 只支持内存中的 NV12、YUV420P、YUVJ420P、BGRA、RGBA 帧，硬件帧须先
+ * av_hwframe_transfer_data()。Compose() 失败（如丢包后缺少基准帧）时
+ * 画面不可信，调用方应请求关键帧并 Reset()。
+ */
+class CopyRectCompositor {
+ public:
+  CopyRectCompositor();
+
+  /**
+   * @brief 合成一帧
+   * @param decoded 解码帧
+   * @param command 该帧码流中的命令（ParseCopyRectSei），没有时为 nullptr
+   * @return 用于显示的帧，在下一次调用 Compose()/Reset() 前有效
+   */
+  Result<const AVFrame*> Compose(const AVFrame* decoded,
+                                 const CopyRectCommand* command);
+
+  /// @brief 丢弃基准帧与显示帧（解码出错、分辨率变化）
+  void Reset();
+
+ private:
+  AVFramePtr last_decoded_;  ///< 最近一次原样显示的解码帧
+  AVFramePtr display_;       ///< 合成状态下显示的帧
+  bool composited_ = false;
+};
+
+}  // namespace zenremote
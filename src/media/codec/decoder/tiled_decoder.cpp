@@ -0,0 +1,241 @@
+#include "tiled_decoder.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "common/log_manager.h"
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+
+namespace zenremote {
+
+TiledVideoDecoder::TiledVideoDecoder() = default;
+
+TiledVideoDecoder::~TiledVideoDecoder() {
+  Shutdown();
+}
+
+Result<void> TiledVideoDecoder::Initialize(const DecoderConfig& config) {
+  if (initialized_) {
+    return Result<void>::Err(ErrorCode::kAlreadyInitialized,
+                             "Decoder already initialized");
+  }
+  canvas_ = MakeAVFrame();
+  if (!canvas_) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to allocate frame");
+  }
+  config_ = config;
+  layout_ = TileLayout{};
+  initialized_ = true;
+  return Result<void>::Ok();
+}
+
+void TiledVideoDecoder::Shutdown() {
+  if (!initialized_) {
+    return;
+  }
+  pool_.reset();
+  tiles_.clear();
+  canvas_.reset();
+  layout_ = TileLayout{};
+  initialized_ = false;
+}
+
+Result<void> TiledVideoDecoder::EnsureLayout(const TileLayout& layout) {
+  if (!tiles_.empty() && layout.columns == layout_.columns &&
+      layout.rows == layout_.rows && layout.width == layout_.width &&
+      layout.height == layout_.height) {
+    return Result<void>::Ok();
+  }
+  pool_.reset();
+  tiles_.clear();
+  layout_ = TileLayout{};
+  av_frame_unref(canvas_.get());
+
+  std::vector<Tile> tiles(layout.TileCount());
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    DecoderConfig tile_config = config_;
+    tile_config.width = layout.tiles[i].Width();
+    tile_config.height = layout.tiles[i].Height();
+    // 分块之间已并行；帧级线程还会增加一帧延迟
+    tile_config.thread_count = 1;
+    tiles[i].decoder = std::make_unique<VideoDecoder>();
+    auto result = tiles[i].decoder->Initialize(tile_config);
+    if (result.IsErr()) {
+      return Result<void>::Err(
+          result.Code(),
+          fmt::format("Tile {} decoder: {}", i, result.Message()));
+    }
+    tiles[i].frame = MakeAVFrame();
+    tiles[i].transfer = MakeAVFrame();
+    if (!tiles[i].frame || !tiles[i].transfer) {
+      return Result<void>::Err(ErrorCode::kOutOfMemory,
+                               "Failed to allocate frame");
+    }
+  }
+  tiles_ = std::move(tiles);
+  layout_ = layout;
+  const size_t threads =
+      std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                       tiles_.size());
+  pool_ = std::make_unique<SlicePool>(threads);
+  ZENREMOTE_INFO("TiledVideoDecoder: {}x{} as {}x{} tiles", layout_.width,
+                 layout_.height, layout_.columns, layout_.rows);
+  return Result<void>::Ok();
+}
+
+Result<void> TiledVideoDecoder::EnsureCanvas(const AVFrame* tile) {
+  AVFrame* canvas = canvas_.get();
+  if (canvas->data[0] && canvas->format == tile->format &&
+      canvas->width == layout_.width && canvas->height == layout_.height) {
+    // 调用方仍持有上一次输出的引用时复制一份，保留未更新分块的内容
+    if (av_frame_make_writable(canvas) < 0) {
+      return Result<void>::Err(ErrorCode::kOutOfMemory,
+                               "Failed to make frame writable");
+    }
+    return Result<void>::Ok();
+  }
+  av_frame_unref(canvas);
+  canvas->format = tile->format;
+  canvas->width = layout_.width;
+  canvas->height = layout_.height;
+  if (av_frame_get_buffer(canvas, 32) < 0) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to allocate frame buffer");
+  }
+  canvas->colorspace = tile->colorspace;
+  canvas->color_range = tile->color_range;
+  canvas->color_primaries = tile->color_primaries;
+  canvas->color_trc = tile->color_trc;
+  for (auto& entry : tiles_) {
+    entry.valid = false;
+  }
+  return Result<void>::Ok();
+}
+
+Result<bool> TiledVideoDecoder::Decode(const uint8_t* data,
+                                       int size,
+                                       int64_t pts,
+                                       AVFrame* frame) {
+  if (!initialized_) {
+    return Result<bool>::Err(ErrorCode::kNotInitialized,
+                             "Decoder not initialized");
+  }
+  if (!data || size <= 0 || !frame) {
+    return Result<bool>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid input data");
+  }
+  auto parsed = ParseTiledFrame(data, static_cast<size_t>(size));
+  if (parsed.IsErr()) {
+    return Result<bool>::Err(parsed.Code(), parsed.Message());
+  }
+  const TiledFrame& tiled = parsed.Value();
+  auto layout_result = EnsureLayout(tiled.layout);
+  if (layout_result.IsErr()) {
+    return Result<bool>::Err(layout_result.Code(), layout_result.Message());
+  }
+
+  for (auto& tile : tiles_) {
+    tile.input = nullptr;
+  }
+  std::vector<size_t> decoding;
+  decoding.reserve(tiled.tiles.size());
+  for (const auto& input : tiled.tiles) {
+    Tile& tile = tiles_[input.index];
+    if (tile.input) {
+      // 同一解码器不能并行解码两次
+      return Result<bool>::Err(ErrorCode::kInvalidParameter,
+                               "Duplicate tile in tiled frame");
+    }
+    if (input.size > 0) {
+      tile.input = &input;
+      decoding.push_back(input.index);
+    }
+  }
+
+  pool_->Run(decoding.size(), [this, pts, &decoding](size_t k) {
+    Tile& tile = tiles_[decoding[k]];
+    tile.result = tile.decoder->Decode(tile.input->data,
+                                       static_cast<int>(tile.input->size), pts,
+                                       pts, tile.frame.get());
+    if (tile.result.IsOk() && tile.result.Value() &&
+        tile.frame->hw_frames_ctx) {
+      av_frame_unref(tile.transfer.get());
+      if (av_hwframe_transfer_data(tile.transfer.get(), tile.frame.get(), 0) <
+          0) {
+        tile.result = Result<bool>::Err(ErrorCode::kDecodeFailed,
+                                        "Failed to download tile");
+      }
+    }
+  });
+
+  // 先检查全部分块，画面只在本包全部可用时更新
+  std::vector<size_t> ready;
+  ready.reserve(decoding.size());
+  Result<void> status = Result<void>::Ok();
+  for (size_t index : decoding) {
+    Tile& tile = tiles_[index];
+    const AVFrame* output =
+        tile.frame->hw_frames_ctx ? tile.transfer.get() : tile.frame.get();
+    if (tile.result.IsOk() && tile.result.Value() &&
+        (output->width != layout_.tiles[index].Width() ||
+         output->height != layout_.tiles[index].Height())) {
+      tile.result = Result<bool>::Err(ErrorCode::kDecodeFailed,
+                                      "Tile size does not match the grid");
+    }
+    if (tile.result.IsErr()) {
+      tile.valid = false;
+      if (status.IsOk()) {
+        status = Result<void>::Err(
+            tile.result.Code(), fmt::format("Tile {} decode failed: {}",
+                                            index, tile.result.Message()));
+      }
+      continue;
+    }
+    if (tile.result.Value() && status.IsOk()) {
+      status = EnsureCanvas(output);
+    }
+    if (tile.result.Value()) {
+      ready.push_back(index);
+    }
+  }
+  if (status.IsErr()) {
+    return Result<bool>::Err(status.Code(), status.Message());
+  }
+
+  std::vector<Result<void>> copied(ready.size());
+  pool_->Run(ready.size(), [this, &ready, &copied](size_t k) {
+    Tile& tile = tiles_[ready[k]];
+    const AVFrame* output =
+        tile.frame->hw_frames_ctx ? tile.transfer.get() : tile.frame.get();
+    const auto& rect = layout_.tiles[ready[k]];
+    copied[k] = CopyTileToFrame(output, canvas_.get(), rect.left, rect.top);
+  });
+  for (size_t k = 0; k < ready.size(); ++k) {
+    tiles_[ready[k]].valid = copied[k].IsOk();
+    if (copied[k].IsErr()) {
+      return Result<bool>::Err(copied[k].Code(), copied[k].Message());
+    }
+  }
+
+  // 流式输出的帧在最后一个包到达后才显示，不出现新旧分块混合的半帧
+  const bool complete =
+      tiled.end_of_frame &&
+      std::all_of(tiles_.begin(), tiles_.end(),
+                  [](const Tile& tile) { return tile.valid; });
+  if (!complete) {
+    return Result<bool>::Ok(false);
+  }
+  av_frame_unref(frame);
+  if (av_frame_ref(frame, canvas_.get()) < 0) {
+    return Result<bool>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to reference frame");
+  }
+  frame->pts = pts;
+  return Result<bool>::Ok(true);
+}
+
+}  // namespace zenremote
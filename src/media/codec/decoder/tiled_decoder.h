@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../../../common/error.h"
+#include "../../../common/slice_pool.h"
+#include "../ffmpeg_types.h"
+#include "../tiled_frame.h"
+#include "video_decoder.h"
+
+namespace zenremote {
+
+/**
+ * @brief 分块编码（TiledVideoEncoder）的解码器
+ *
+ * 每个分块一个 VideoDecoder，同一包内的分块在 SlicePool 上并行解码，
+ * 再复制到整帧画面的对应位置；包内没有的分块保留上一次的内容。网格或
+ * 尺寸变化时重建全部分块解码器。硬件解码的分块先传回内存，画面为
+ * 内存中的 NV12/YUV420P。
+ *
+ * 重建后或分块解码出错后，在每个分块都成功解码过之前不输出画面
+ * （Decode() 返回 Ok(false)）；出错时调用方应请求关键帧。流式输出的帧
+ * 拆成多个包，每个包到达即解码，帧的最后一个包才输出画面。
+ *
+ * 非线程安全。
+ */
+class TiledVideoDecoder {
+ public:
+  TiledVideoDecoder();
+  ~TiledVideoDecoder();
+
+  TiledVideoDecoder(const TiledVideoDecoder&) = delete;
+  TiledVideoDecoder& operator=(const TiledVideoDecoder&) = delete;
+
+  /// @brief 初始化；config 用于每个分块，其中 width/height 被忽略
+  Result<void> Initialize(const DecoderConfig& config);
+
+  void Shutdown();
+
+  /**
+   * @brief 解码一个 tiled_frame.h 格式的包
+   * @param[out] frame 整帧画面的引用
+   * @return Ok(true) 有输出画面，Ok(false) 不是帧的最后一个包或还有分块
+   *         没有内容
+   */
+  Result<bool> Decode(const uint8_t* data,
+                      int size,
+                      int64_t pts,
+                      AVFrame* frame);
+
+  bool IsInitialized() const { return initialized_; }
+
+  const TileLayout& GetLayout() const { return layout_; }
+
+ private:
+  struct Tile {
+    std::unique_ptr<VideoDecoder> decoder;
+    AVFramePtr frame;
+    AVFramePtr transfer;  ///< 硬件帧传回内存的目标
+    const TiledFrameTile* input = nullptr;
+    Result<bool> result;
+    bool valid = false;  ///< 画面上有该分块的内容
+  };
+
+  /// @brief 网格或尺寸变化时重建分块解码器
+  Result<void> EnsureLayout(const TileLayout& layout);
+
+  /// @brief 按解码出的分块格式分配（或就地复用）整帧画面
+  Result<void> EnsureCanvas(const AVFrame* tile);
+
+  DecoderConfig config_;
+  TileLayout layout_;
+  std::vector<Tile> tiles_;
+  std::unique_ptr<SlicePool> pool_;
+  AVFramePtr canvas_;
+  bool initialized_ = false;
+};
+
+}  // namespace zenremote
@@ -0,0 +1,608 @@
+#include "bgra_to_nv12.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "common/slice_pool.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define ZENREMOTE_X86_SIMD 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw")))
+#else
+#include <intrin.h>
+#define SSE41_TARGET
+#define AVX2_TARGET
+#define AVX512_TARGET
+#endif
+#endif
+
+namespace zenremote {
+
+namespace {
+
+constexpr int kShift = 14;
+/// 色度是 4 个像素之和，多移 2 位
+constexpr int kChromaShift = kShift + 2;
+constexpr int kChromaRound = 1 << (kChromaShift - 1);
+constexpr int kChromaOffset = 128;
+
+/**
+ * BT.709：Kr = 0.2126，Kb = 0.0722。limited range 的 Y 乘 219/255 加 16，
+ * UV 乘 224/255；系数取整后保证每组之和不变（Y 为 1，UV 为 0）。
+ */
+struct RangeCoefficients {
+  int y_r, y_g, y_b, y_offset;
+  int u_r, u_g, u_b;
+  int v_r, v_g, v_b;
+};
+
+constexpr RangeCoefficients kFullRange = {3483,  11718, 1183,  0,    -1877,
+                                          -6315, 8192,  8192,  -7441, -751};
+constexpr RangeCoefficients kLimitedRange = {
+    2991, 10064, 1016, 16, -1649, -5547, 7196, 7196, -6536, -660};
+
+int64_t PackBgra(int b, int g, int r) {
+  return static_cast<int64_t>(static_cast<uint16_t>(b)) |
+         (static_cast<int64_t>(static_cast<uint16_t>(g)) << 16) |
+         (static_cast<int64_t>(static_cast<uint16_t>(r)) << 32);
+}
+
+inline int Component(int64_t packed, int index) {
+  return static_cast<int16_t>(static_cast<uint16_t>(packed >> (16 * index)));
+}
+
+inline uint8_t Clamp8(int value) {
+  return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+inline uint8_t Luma(const uint8_t* p, const BgraToNv12::Coefficients& c) {
+  const int sum = Component(c.y, 0) * p[0] + Component(c.y, 1) * p[1] +
+                  Component(c.y, 2) * p[2] + c.y_bias;
+  return Clamp8(sum >> kShift);
+}
+
+inline uint8_t Chroma(int64_t coefficients, int b, int g, int r) {
+  const int sum = Component(coefficients, 0) * b +
+                  Component(coefficients, 1) * g +
+                  Component(coefficients, 2) * r + kChromaRound;
+  return Clamp8((sum >> kChromaShift) + kChromaOffset);
+}
+
+/// 参考实现；宽度为奇数时最后一列与自身组成色度块
+int RowPairScalar(const uint8_t* row0,
+                  const uint8_t* row1,
+                  uint8_t* y0,
+                  uint8_t* y1,
+                  uint8_t* uv,
+                  int count,
+                  const BgraToNv12::Coefficients& c) {
+  for (int x = 0; x < count; x += 2) {
+    const int x1 = std::min(x + 1, count - 1);
+    const uint8_t* p00 = row0 + 4 * x;
+    const uint8_t* p01 = row0 + 4 * x1;
+    const uint8_t* p10 = row1 + 4 * x;
+    const uint8_t* p11 = row1 + 4 * x1;
+    y0[x] = Luma(p00, c);
+    y1[x] = Luma(p10, c);
+    if (x1 != x) {
+      y0[x1] = Luma(p01, c);
+      y1[x1] = Luma(p11, c);
+    }
+    const int b = p00[0] + p01[0] + p10[0] + p11[0];
+    const int g = p00[1] + p01[1] + p10[1] + p11[1];
+    const int r = p00[2] + p01[2] + p10[2] + p11[2];
+    uv[x] = Chroma(c.u, b, g, r);
+    uv[x + 1] = Chroma(c.v, b, g, r);
+  }
+  return count;
+}
+
+#ifdef ZENREMOTE_X86_SIMD
+
+/*
+ * 向量实现的共同思路：像素扩展为 16 位后与 [cb, cg, cr, 0] 做 madd，
+ * 每个像素得到两个 32 位部分和，水平相加即该像素的 Y（或 U/V 贡献）。
+ * 色度先把两行的 16 位像素相加，再把相邻两个像素的贡献相加，得到 2x2
+ * 块之和乘系数，与标量实现的整数运算完全相同。
+ */
+
+SSE41_TARGET inline __m128i Sum4Sse41(__m128i lo, __m128i hi, __m128i coef) {
+  return _mm_hadd_epi32(_mm_madd_epi16(lo, coef), _mm_madd_epi16(hi, coef));
+}
+
+/// @return 4 个像素对应的 [U01, V01, U23, V23]
+SSE41_TARGET inline __m128i ChromaSse41(__m128i lo,
+                                        __m128i hi,
+                                        __m128i u_coef,
+                                        __m128i v_coef) {
+  const __m128i u = Sum4Sse41(lo, hi, u_coef);
+  const __m128i v = Sum4Sse41(lo, hi, v_coef);
+  const __m128i uv =
+      _mm_shuffle_epi32(_mm_hadd_epi32(u, v), _MM_SHUFFLE(3, 1, 2, 0));
+  return _mm_add_epi32(
+      _mm_srai_epi32(_mm_add_epi32(uv, _mm_set1_epi32(kChromaRound)),
+                     kChromaShift),
+      _mm_set1_epi32(kChromaOffset));
+}
+
+/// 每次 16 个像素
+SSE41_TARGET int RowPairSse41(const uint8_t* row0,
+                              const uint8_t* row1,
+                              uint8_t* y0,
+                              uint8_t* y1,
+                              uint8_t* uv,
+                              int count,
+                              const BgraToNv12::Coefficients& c) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i y_coef = _mm_set1_epi64x(c.y);
+  const __m128i u_coef = _mm_set1_epi64x(c.u);
+  const __m128i v_coef = _mm_set1_epi64x(c.v);
+  const __m128i y_bias = _mm_set1_epi32(c.y_bias);
+
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    __m128i luma0[4];
+    __m128i luma1[4];
+    __m128i chroma[4];
+    for (int i = 0; i < 4; ++i) {
+      const __m128i p0 = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(row0 + 4 * (x + 4 * i)));
+      const __m128i p1 = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(row1 + 4 * (x + 4 * i)));
+      const __m128i lo0 = _mm_unpacklo_epi8(p0, zero);
+      const __m128i hi0 = _mm_unpackhi_epi8(p0, zero);
+      const __m128i lo1 = _mm_unpacklo_epi8(p1, zero);
+      const __m128i hi1 = _mm_unpackhi_epi8(p1, zero);
+      luma0[i] = _mm_srai_epi32(
+          _mm_add_epi32(Sum4Sse41(lo0, hi0, y_coef), y_bias), kShift);
+      luma1[i] = _mm_srai_epi32(
+          _mm_add_epi32(Sum4Sse41(lo1, hi1, y_coef), y_bias), kShift);
+      chroma[i] = ChromaSse41(_mm_add_epi16(lo0, lo1),
+                              _mm_add_epi16(hi0, hi1), u_coef, v_coef);
+    }
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(y0 + x),
+        _mm_packus_epi16(_mm_packs_epi32(luma0[0], luma0[1]),
+                         _mm_packs_epi32(luma0[2], luma0[3])));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(y1 + x),
+        _mm_packus_epi16(_mm_packs_epi32(luma1[0], luma1[1]),
+                         _mm_packs_epi32(luma1[2], luma1[3])));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(uv + x),
+        _mm_packus_epi16(_mm_packs_epi32(chroma[0], chroma[1]),
+                         _mm_packs_epi32(chroma[2], chroma[3])));
+  }
+  return x;
+}
+
+/*
+ * AVX2 的 unpack/hadd/pack 都在 128 位半区内进行：hadd 的结果恰好按像素
+ * 顺序排列，pack 之后用 permute4x64 把两个半区交错的 64 位块排回顺序。
+ */
+
+AVX2_TARGET inline __m256i Sum8Avx2(__m256i lo, __m256i hi, __m256i coef) {
+  return _mm256_hadd_epi32(_mm256_madd_epi16(lo, coef),
+                           _mm256_madd_epi16(hi, coef));
+}
+
+AVX2_TARGET inline __m256i ChromaAvx2(__m256i lo,
+                                      __m256i hi,
+                                      __m256i u_coef,
+                                      __m256i v_coef) {
+  const __m256i u = Sum8Avx2(lo, hi, u_coef);
+  const __m256i v = Sum8Avx2(lo, hi, v_coef);
+  const __m256i uv =
+      _mm256_shuffle_epi32(_mm256_hadd_epi32(u, v), _MM_SHUFFLE(3, 1, 2, 0));
+  return _mm256_add_epi32(
+      _mm256_srai_epi32(_mm256_add_epi32(uv, _mm256_set1_epi32(kChromaRound)),
+                        kChromaShift),
+      _mm256_set1_epi32(kChromaOffset));
+}
+
+/// 4 组按序排列的 8 个 int32 → 32 个按序排列的 uint8（饱和）
+AVX2_TARGET inline __m256i Pack32Avx2(const __m256i* values) {
+  const __m256i a = _mm256_permute4x64_epi64(
+      _mm256_packs_epi32(values[0], values[1]), _MM_SHUFFLE(3, 1, 2, 0));
+  const __m256i b = _mm256_permute4x64_epi64(
+      _mm256_packs_epi32(values[2], values[3]), _MM_SHUFFLE(3, 1, 2, 0));
+  return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b),
+                                  _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+/// 每次 32 个像素
+AVX2_TARGET int RowPairAvx2(const uint8_t* row0,
+                            const uint8_t* row1,
+                            uint8_t* y0,
+                            uint8_t* y1,
+                            uint8_t* uv,
+                            int count,
+                            const BgraToNv12::Coefficients& c) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i y_coef = _mm256_set1_epi64x(c.y);
+  const __m256i u_coef = _mm256_set1_epi64x(c.u);
+  const __m256i v_coef = _mm256_set1_epi64x(c.v);
+  const __m256i y_bias = _mm256_set1_epi32(c.y_bias);
+
+  int x = 0;
+  for (; x + 32 <= count; x += 32) {
+    __m256i luma0[4];
+    __m256i luma1[4];
+    __m256i chroma[4];
+    for (int i = 0; i < 4; ++i) {
+      const __m256i p0 = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(row0 + 4 * (x + 8 * i)));
+      const __m256i p1 = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(row1 + 4 * (x + 8 * i)));
+      const __m256i lo0 = _mm256_unpacklo_epi8(p0, zero);
+      const __m256i hi0 = _mm256_unpackhi_epi8(p0, zero);
+      const __m256i lo1 = _mm256_unpacklo_epi8(p1, zero);
+      const __m256i hi1 = _mm256_unpackhi_epi8(p1, zero);
+      luma0[i] = _mm256_srai_epi32(
+          _mm256_add_epi32(Sum8Avx2(lo0, hi0, y_coef), y_bias), kShift);
+      luma1[i] = _mm256_srai_epi32(
+          _mm256_add_epi32(Sum8Avx2(lo1, hi1, y_coef), y_bias), kShift);
+      chroma[i] = ChromaAvx2(_mm256_add_epi16(lo0, lo1),
+                             _mm256_add_epi16(hi0, hi1), u_coef, v_coef);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(y0 + x),
+                        Pack32Avx2(luma0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(y1 + x),
+                        Pack32Avx2(luma1));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(uv + x),
+                        Pack32Avx2(chroma));
+  }
+  return x;
+}
+
+/*
+ * AVX-512 没有 hadd：像素直接零扩展为 16 位（按序），madd 后用
+ * permutex2var 取出偶数和奇数位置的部分和相加；U/V 相邻像素的配对求和
+ * 也用同样的方法，同时完成交错。
+ */
+
+// GCC 12 的 avx512fintrin.h 以未初始化的 _mm512_undefined_*() 作直通
+// 操作数，会误报 -Wmaybe-uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+alignas(64) constexpr int32_t kEvenIndex[16] = {0,  2,  4,  6,  8,  10,
+                                                12, 14, 16, 18, 20, 22,
+                                                24, 26, 28, 30};
+alignas(64) constexpr int32_t kOddIndex[16] = {1,  3,  5,  7,  9,  11,
+                                               13, 15, 17, 19, 21, 23,
+                                               25, 27, 29, 31};
+/// 输出 [U(2k), V(2k), ...] 与 [U(2k+1), V(2k+1), ...]
+alignas(64) constexpr int32_t kUvEvenIndex[16] = {0,  16, 2,  18, 4,  20,
+                                                  6,  22, 8,  24, 10, 26,
+                                                  12, 28, 14, 30};
+alignas(64) constexpr int32_t kUvOddIndex[16] = {1,  17, 3,  19, 5,  21,
+                                                 7,  23, 9,  25, 11, 27,
+                                                 13, 29, 15, 31};
+
+AVX512_TARGET inline __m512i LoadIndex(const int32_t* index) {
+  return _mm512_load_si512(index);
+}
+
+/// @param a, b 像素 0-7、8-15 的 16 位分量
+AVX512_TARGET inline __m512i Sum16Avx512(__m512i a, __m512i b, __m512i coef) {
+  const __m512i ma = _mm512_madd_epi16(a, coef);
+  const __m512i mb = _mm512_madd_epi16(b, coef);
+  return _mm512_add_epi32(
+      _mm512_permutex2var_epi32(ma, LoadIndex(kEvenIndex), mb),
+      _mm512_permutex2var_epi32(ma, LoadIndex(kOddIndex), mb));
+}
+
+AVX512_TARGET inline __m512i ExpandAvx512(const uint8_t* pixels) {
+  return _mm512_cvtepu8_epi16(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels)));
+}
+
+/// 每次 16 个像素
+AVX512_TARGET int RowPairAvx512(const uint8_t* row0,
+                                const uint8_t* row1,
+                                uint8_t* y0,
+                                uint8_t* y1,
+                                uint8_t* uv,
+                                int count,
+                                const BgraToNv12::Coefficients& c) {
+  const __m512i y_coef = _mm512_set1_epi64(c.y);
+  const __m512i u_coef = _mm512_set1_epi64(c.u);
+  const __m512i v_coef = _mm512_set1_epi64(c.v);
+  const __m512i y_bias = _mm512_set1_epi32(c.y_bias);
+  const __m512i chroma_round = _mm512_set1_epi32(kChromaRound);
+  const __m512i chroma_offset = _mm512_set1_epi32(kChromaOffset);
+  const __m512i zero = _mm512_setzero_si512();
+
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    const __m512i a0 = ExpandAvx512(row0 + 4 * x);
+    const __m512i b0 = ExpandAvx512(row0 + 4 * x + 32);
+    const __m512i a1 = ExpandAvx512(row1 + 4 * x);
+    const __m512i b1 = ExpandAvx512(row1 + 4 * x + 32);
+
+    const __m512i luma0 = _mm512_srai_epi32(
+        _mm512_add_epi32(Sum16Avx512(a0, b0, y_coef), y_bias), kShift);
+    const __m512i luma1 = _mm512_srai_epi32(
+        _mm512_add_epi32(Sum16Avx512(a1, b1, y_coef), y_bias), kShift);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y0 + x),
+                     _mm512_cvtusepi32_epi8(luma0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(y1 + x),
+                     _mm512_cvtusepi32_epi8(luma1));
+
+    const __m512i a = _mm512_add_epi16(a0, a1);
+    const __m512i b = _mm512_add_epi16(b0, b1);
+    const __m512i u = Sum16Avx512(a, b, u_coef);
+    const __m512i v = Sum16Avx512(a, b, v_coef);
+    const __m512i sums = _mm512_add_epi32(
+        _mm512_permutex2var_epi32(u, LoadIndex(kUvEvenIndex), v),
+        _mm512_permutex2var_epi32(u, LoadIndex(kUvOddIndex), v));
+    const __m512i chroma = _mm512_max_epi32(
+        _mm512_add_epi32(
+            _mm512_srai_epi32(_mm512_add_epi32(sums, chroma_round),
+                              kChromaShift),
+            chroma_offset),
+        zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(uv + x),
+                     _mm512_cvtusepi32_epi8(chroma));
+  }
+  return x;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // ZENREMOTE_X86_SIMD
+
+struct CpuFeatures {
+  bool sse41 = false;
+  bool avx2 = false;
+  bool avx512 = false;  ///< F + BW
+};
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures features;
+#ifdef ZENREMOTE_X86_SIMD
+#if defined(__GNUC__) || defined(__clang__)
+  // 同时检查操作系统是否保存 YMM/ZMM 状态
+  __builtin_cpu_init();
+  features.sse41 = __builtin_cpu_supports("sse4.1");
+  features.avx2 = __builtin_cpu_supports("avx2");
+  features.avx512 = __builtin_cpu_supports("avx512f") &&
+                    __builtin_cpu_supports("avx512bw");
+#else
+  int info[4] = {};
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+  __cpuid(info, 1);
+  const unsigned int ecx = static_cast<unsigned int>(info[2]);
+  // ECX: bit 19 SSE4.1，bit 27 OSXSAVE，bit 28 AVX
+  features.sse41 = (ecx & (1U << 19)) != 0;
+  const bool os_avx = (ecx & (1U << 27)) && (ecx & (1U << 28));
+  if (os_avx && max_leaf >= 7) {
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    const unsigned int ebx = static_cast<unsigned int>(info[1]);
+    // XCR0: bit 1-2 XMM/YMM，bit 5-7 opmask/ZMM；EBX: bit 5 AVX2，
+    // bit 16 AVX512F，bit 30 AVX512BW
+    features.avx2 = (xcr0 & 0x6) == 0x6 && (ebx & (1U << 5));
+    features.avx512 = (xcr0 & 0xE6) == 0xE6 && (ebx & (1U << 16)) &&
+                      (ebx & (1U << 30));
+  }
+#endif
+#endif
+  return features;
+}
+
+const CpuFeatures& GetCpuFeatures() {
+  static const CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
+
+}  // namespace
+
+BgraToNv12::BgraToNv12(bool full_range, Isa isa)
+    : full_range_(full_range), isa_(isa), row_pair_(RowPairScalar) {
+  const RangeCoefficients& range = full_range ? kFullRange : kLimitedRange;
+  coefficients_.y = PackBgra(range.y_b, range.y_g, range.y_r);
+  coefficients_.u = PackBgra(range.u_b, range.u_g, range.u_r);
+  coefficients_.v = PackBgra(range.v_b, range.v_g, range.v_r);
+  coefficients_.y_bias = (range.y_offset << kShift) + (1 << (kShift - 1));
+
+  if (isa_ == Isa::kAuto || !IsaAvailable(isa_)) {
+    isa_ = IsaAvailable(Isa::kAvx512) ? Isa::kAvx512
+           : IsaAvailable(Isa::kAvx2) ? Isa::kAvx2
+           : IsaAvailable(Isa::kSse41) ? Isa::kSse41
+                                       : Isa::kScalar;
+  }
+#ifdef ZENREMOTE_X86_SIMD
+  switch (isa_) {
+    case Isa::kAvx512:
+      row_pair_ = RowPairAvx512;
+      break;
+    case Isa::kAvx2:
+      row_pair_ = RowPairAvx2;
+      break;
+    case Isa::kSse41:
+      row_pair_ = RowPairSse41;
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
+bool BgraToNv12::IsaAvailable(Isa isa) {
+  const CpuFeatures& features = GetCpuFeatures();
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+    case Isa::kSse41:
+      return features.sse41;
+    case Isa::kAvx2:
+      return features.avx2;
+    case Isa::kAvx512:
+      return features.avx512;
+    default:
+      return false;
+  }
+}
+
+const char* BgraToNv12::IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::kAuto:
+      return "auto";
+    case Isa::kScalar:
+      return "scalar";
+    case Isa::kSse41:
+      return "sse4.1";
+    case Isa::kAvx2:
+      return "avx2";
+    case Isa::kAvx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+void BgraToNv12::Convert(const uint8_t* bgra,
+                         int bgra_stride,
+                         int width,
+                         int height,
+                         uint8_t* y,
+                         int y_stride,
+                         uint8_t* uv,
+                         int uv_stride,
+                         SlicePool* pool) const {
+  if (width <= 0 || height <= 0) {
+    return;
+  }
+  if (!pool || pool->GetThreadCount() == 1 ||
+      static_cast<int64_t>(width) * height < kMinParallelPixels) {
+    ConvertAligned(bgra, bgra_stride, height, 0, 0, width, height, y,
+                   y_stride, uv, uv_stride);
+    return;
+  }
+  ConvertRects(bgra, bgra_stride, width, height, {{0, 0, width, height}}, y,
+               y_stride, uv, uv_stride, pool);
+}
+
+void BgraToNv12::ConvertRects(
+    const uint8_t* bgra,
+    int bgra_stride,
+    int width,
+    int height,
+    const std::vector<media::capture::DirtyRect>& rects,
+    uint8_t* y,
+    int y_stride,
+    uint8_t* uv,
+    int uv_stride,
+    SlicePool* pool) const {
+  int64_t area = 0;
+  int top = height;
+  int bottom = 0;
+  for (const auto& rect : rects) {
+    const int clipped_width =
+        std::min<int>(rect.right, width) - std::max<int>(rect.left, 0);
+    const int clipped_height =
+        std::min<int>(rect.bottom, height) - std::max<int>(rect.top, 0);
+    if (clipped_width > 0 && clipped_height > 0) {
+      area += static_cast<int64_t>(clipped_width) * clipped_height;
+      top = std::min<int>(top, std::max<int>(rect.top, 0));
+      bottom = std::max<int>(bottom, std::min<int>(rect.bottom, height));
+    }
+  }
+  if (area == 0) {
+    return;
+  }
+
+  if (!pool || pool->GetThreadCount() == 1 || area < kMinParallelPixels) {
+    for (const auto& rect : rects) {
+      ConvertRect(bgra, bgra_stride, width, height, rect.left, rect.top,
+                  rect.right, rect.bottom, y, y_stride, uv, uv_stride);
+    }
+    return;
+  }
+
+  // 条带边界取偶数行，相邻条带不共享色度行
+  top &= ~1;
+  const int bands = static_cast<int>(pool->GetThreadCount());
+  const int band_rows = ((bottom - top + bands - 1) / bands + 1) & ~1;
+  pool->Run(static_cast<size_t>(bands), [&](size_t index) {
+    const int band_top = top + static_cast<int>(index) * band_rows;
+    const int band_bottom = std::min(band_top + band_rows, bottom);
+    for (const auto& rect : rects) {
+      const int rect_top = std::max<int>(rect.top, band_top);
+      const int rect_bottom = std::min<int>(rect.bottom, band_bottom);
+      if (rect_top < rect_bottom) {
+        ConvertRect(bgra, bgra_stride, width, height, rect.left, rect_top,
+                    rect.right, rect_bottom, y, y_stride, uv, uv_stride);
+      }
+    }
+  });
+}
+
+void BgraToNv12::ConvertRect(const uint8_t* bgra,
+                             int bgra_stride,
+                             int width,
+                             int height,
+                             int left,
+                             int top,
+                             int right,
+                             int bottom,
+                             uint8_t* y,
+                             int y_stride,
+                             uint8_t* uv,
+                             int uv_stride) const {
+  // 外扩到偶数坐标；帧尺寸为奇数时右/下边界裁到帧边缘
+  left = std::max(left, 0) & ~1;
+  top = std::max(top, 0) & ~1;
+  right = std::min((right + 1) & ~1, width);
+  bottom = std::min((bottom + 1) & ~1, height);
+  if (left >= right || top >= bottom) {
+    return;
+  }
+  ConvertAligned(bgra, bgra_stride, height, left, top, right, bottom, y,
+                 y_stride, uv, uv_stride);
+}
+
+void BgraToNv12::ConvertAligned(const uint8_t* bgra,
+                                int bgra_stride,
+                                int height,
+                                int left,
+                                int top,
+                                int right,
+                                int bottom,
+                                uint8_t* y,
+                                int y_stride,
+                                uint8_t* uv,
+                                int uv_stride) const {
+  const int count = right - left;
+  for (int row = top; row < bottom; row += 2) {
+    // 高度为奇数时最后一行与自身组成色度块
+    const int next = std::min(row + 1, height - 1);
+    const uint8_t* row0 =
+        bgra + static_cast<ptrdiff_t>(row) * bgra_stride + 4 * left;
+    const uint8_t* row1 =
+        bgra + static_cast<ptrdiff_t>(next) * bgra_stride + 4 * left;
+    uint8_t* y0 = y + static_cast<ptrdiff_t>(row) * y_stride + left;
+    uint8_t* y1 = y + static_cast<ptrdiff_t>(next) * y_stride + left;
+    uint8_t* uv_row = uv + static_cast<ptrdiff_t>(row / 2) * uv_stride + left;
+
+    const int done =
+        row_pair_(row0, row1, y0, y1, uv_row, count, coefficients_);
+    if (done < count) {
+      RowPairScalar(row0 + 4 * done, row1 + 4 * done, y0 + done, y1 + done,
+                    uv_row + done, count - done, coefficients_);
+    }
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,153 @@
+/**
+ * @file bgra_to_nv12.h
+ * @brief 手写向量化的 BGRA → NV12 色彩转换（BT.709，full/limited range）
+ *
+ * 屏幕采集到编码器输入的固定路径（同尺寸、BGRA → NV12）不需要 swscale
+ * 的通用缩放框架，这里按 2x2 色度块逐行对处理：
+ * - 系数放大 2^14 的定点运算；色度取 2x2 块四个像素的和再乘系数，与
+ *   先平均再转换等价
+ * - 标量、SSE4.1、AVX2、AVX-512（F + BW）四套实现，结果逐位相同；
+ *   构造时按 CPU 运行时选择，不需要额外的编译选项
+ * - ConvertRect() 只转换一个矩形（外扩到 2x2 色度块边界），用于按脏区域
+ *   增量更新持久的 NV12 帧
+ * - 传入 SlicePool 时按偶数行对齐的水平条带并行转换；条带之间没有共享的
+ *   色度块，结果与单线程相同
+ *
+ * @note 对象构造后只读，可在多个线程并发使用
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "media/capture/screen_capturer.h"
+
+namespace zenremote {
+
+class SlicePool;
+
+class BgraToNv12 {
+ public:
+  enum class Isa {
+    kAuto,  ///< CPU 支持的最快实现
+    kScalar,
+    kSse41,
+    kAvx2,
+    kAvx512,
+  };
+
+  /// 定点系数（BGRA 字节序），内部使用
+  struct Coefficients {
+    int64_t y;  ///< 4 个 int16：B、G、R、0
+    int64_t u;
+    int64_t v;
+    int32_t y_bias;  ///< 偏移与舍入，已乘 2^14
+  };
+
+  /**
+   * @param full_range true 为 full range（Y 0-255），false 为 limited
+   *                   range（Y 16-235，UV 16-240），与 EncoderConfig 一致
+   * @param isa 请求的实现；CPU 不支持时退回可用的最快实现
+   */
+  explicit BgraToNv12(bool full_range, Isa isa = Isa::kAuto);
+
+  /// 脏区域总面积低于此值时不分条带（唤醒线程的开销超过收益）
+  static constexpr int64_t kMinParallelPixels = 256 * 1024;
+
+  /**
+   * @brief 整帧转换
+   * @param uv NV12 交错色度平面，(height + 1) / 2 行，每行 width 向上取偶
+   *           个字节
+   * @param pool 非空时按条带并行
+   */
+  void Convert(const uint8_t* bgra,
+               int bgra_stride,
+               int width,
+               int height,
+               uint8_t* y,
+               int y_stride,
+               uint8_t* uv,
+               int uv_stride,
+               SlicePool* pool = nullptr) const;
+
+  /**
+   * @brief 只转换 [left, right) x [top, bottom)
+   *
+   * 矩形外扩到偶数坐标并裁剪到帧内，保证色度块完整；其他区域不写。
+   * 同一帧按多个矩形转换的结果与整帧转换在这些区域内相同。
+   */
+  void ConvertRect(const uint8_t* bgra,
+                   int bgra_stride,
+                   int width,
+                   int height,
+                   int left,
+                   int top,
+                   int right,
+                   int bottom,
+                   uint8_t* y,
+                   int y_stride,
+                   uint8_t* uv,
+                   int uv_stride) const;
+
+  /**
+   * @brief 转换多个矩形，等价于逐个调用 ConvertRect()
+   * @param pool 非空且总面积不小于 kMinParallelPixels 时按条带并行，每个
+   *             条带转换各矩形与它的交集
+   */
+  void ConvertRects(const uint8_t* bgra,
+                    int bgra_stride,
+                    int width,
+                    int height,
+                    const std::vector<media::capture::DirtyRect>& rects,
+                    uint8_t* y,
+                    int y_stride,
+                    uint8_t* uv,
+                    int uv_stride,
+                    SlicePool* pool = nullptr) const;
+
+  bool IsFullRange() const { return full_range_; }
+
+  /// @brief 实际使用的实现（不会是 kAuto）
+  Isa GetIsa() const { return isa_; }
+
+  /// @brief 当前 CPU 是否支持该实现
+  static bool IsaAvailable(Isa isa);
+
+  static const char* IsaName(Isa isa);
+
+ private:
+  /**
+   * @brief 处理一对行的 [0, count) 像素，返回已处理的像素数
+   *
+   * 向量实现只处理整块，余下的由标量实现补齐。
+   */
+  using RowPairFunction = int (*)(const uint8_t* row0,
+                                  const uint8_t* row1,
+                                  uint8_t* y0,
+                                  uint8_t* y1,
+                                  uint8_t* uv,
+                                  int count,
+                                  const Coefficients& coefficients);
+
+  /// @brief 转换已对齐到色度块的矩形
+  void ConvertAligned(const uint8_t* bgra,
+                      int bgra_stride,
+                      int height,
+                      int left,
+                      int top,
+                      int right,
+                      int bottom,
+                      uint8_t* y,
+                      int y_stride,
+                      uint8_t* uv,
+                      int uv_stride) const;
+
+  bool full_range_;
+  Isa isa_;
+  Coefficients coefficients_;
+  RowPairFunction row_pair_;
+};
+
+}  // namespace zenremote
@@ -1,15 +1,36 @@
 #include "color_converter.h"
 
+#include <algorithm>
+#include <thread>
+#include <utility>
+
 #include "common/log_manager.h"
 
 namespace zenremote {
 
+namespace {
+
+/// threads = 0 时每个线程负责的像素数
+constexpr int64_t kAutoPixelsPerThread = 2500000;
+
+bool IsRgbFormat(AVPixelFormat format) {
+  return format == AV_PIX_FMT_BGRA || format == AV_PIX_FMT_RGBA ||
+         format == AV_PIX_FMT_BGR0;
+}
+
+}  // namespace
+
 ColorConverter::~ColorConverter() {
   Shutdown();
 }
 
 ColorConverter::ColorConverter(ColorConverter&& other) noexcept
     : sws_ctx_(other.sws_ctx_),
+      fast_path_(std::move(other.fast_path_)),
+      slice_pool_(std::move(other.slice_pool_)),
+      frame_pool_(std::move(other.frame_pool_)),
+      incremental_frame_(std::move(other.incremental_frame_)),
+      spare_frame_(std::move(other.spare_frame_)),
       src_width_(other.src_width_),
       src_height_(other.src_height_),
       src_format_(other.src_format_),
@@ -24,6 +45,11 @@ ColorConverter& ColorConverter::operator=(ColorConverter&& other) noexcept {
   if (this != &other) {
     Shutdown();
     sws_ctx_ = other.sws_ctx_;
+    fast_path_ = std::move(other.fast_path_);
+    slice_pool_ = std::move(other.slice_pool_);
+    frame_pool_ = std::move(other.frame_pool_);
+    incremental_frame_ = std::move(other.incremental_frame_);
+    spare_frame_ = std::move(other.spare_frame_);
     src_width_ = other.src_width_;
     src_height_ = other.src_height_;
     src_format_ = other.src_format_;
@@ -63,6 +89,20 @@ Result<void> ColorConverter::Initialize(const ColorConverterConfig& config) {
                                                        : AV_PIX_FMT_NV12;
   sws_flags_ = config.sws_flags;
 
+  // 输出帧从池中分配；池不支持的格式（硬件格式）退回 av_frame_get_buffer
+  VideoFramePoolConfig pool_config;
+  pool_config.width = dst_width_;
+  pool_config.height = dst_height_;
+  pool_config.format = dst_format_;
+  pool_config.huge_pages = config.huge_pages;
+  frame_pool_ = std::make_unique<VideoFramePool>();
+  auto pool_result = frame_pool_->Initialize(pool_config);
+  if (pool_result.IsErr()) {
+    ZENREMOTE_DEBUG("ColorConverter frame pool unavailable: {}",
+                    pool_result.Message());
+    frame_pool_.reset();
+  }
+
   // 创建 swscale 上下文
   sws_ctx_ = sws_getContext(src_width_, src_height_, src_format_, dst_width_,
                             dst_height_, dst_format_, sws_flags_, nullptr,
@@ -73,14 +113,49 @@ Result<void> ColorConverter::Initialize(const ColorConverterConfig& config) {
                              "Failed to create swscale context");
   }
 
-  ZENREMOTE_INFO("ColorConverter initialized: {}x{} ({}) -> {}x{} ({})",
-                 src_width_, src_height_, av_get_pix_fmt_name(src_format_),
-                 dst_width_, dst_height_, av_get_pix_fmt_name(dst_format_));
+  // swscale 默认输出 BT.601 limited range，改为与编码器标注的一致
+  const bool full_range = config.color_range == AVCOL_RANGE_JPEG;
+  if (IsRgbFormat(src_format_) && !IsRgbFormat(dst_format_)) {
+    const int* coefficients = sws_getCoefficients(
+        config.color_space == AVCOL_SPC_BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+    sws_setColorspaceDetails(sws_ctx_, coefficients, 1, coefficients,
+                             full_range ? 1 : 0, 0, 1 << 16, 1 << 16);
+  }
+
+  if (src_format_ == AV_PIX_FMT_BGRA && dst_format_ == AV_PIX_FMT_NV12 &&
+      dst_width_ == src_width_ && dst_height_ == src_height_ &&
+      config.color_space == AVCOL_SPC_BT709) {
+    fast_path_ = std::make_unique<BgraToNv12>(full_range);
+
+    size_t threads = static_cast<size_t>(std::max(config.threads, 0));
+    if (threads == 0) {
+      const int64_t pixels = static_cast<int64_t>(src_width_) * src_height_;
+      threads = std::min<size_t>(
+          static_cast<size_t>((pixels + kAutoPixelsPerThread - 1) /
+                              kAutoPixelsPerThread),
+          std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    }
+    if (threads > 1) {
+      slice_pool_ = std::make_unique<SlicePool>(threads);
+    }
+  }
+
+  ZENREMOTE_INFO(
+      "ColorConverter initialized: {}x{} ({}) -> {}x{} ({}), {} x{}",
+      src_width_, src_height_, av_get_pix_fmt_name(src_format_), dst_width_,
+      dst_height_, av_get_pix_fmt_name(dst_format_),
+      fast_path_ ? BgraToNv12::IsaName(fast_path_->GetIsa()) : "swscale",
+      GetThreadCount());
 
   return Result<void>::Ok();
 }
 
 void ColorConverter::Shutdown() {
+  fast_path_.reset();
+  slice_pool_.reset();
+  incremental_frame_.reset();
+  spare_frame_.reset();
+  frame_pool_.reset();
   if (sws_ctx_) {
     sws_freeContext(sws_ctx_);
     sws_ctx_ = nullptr;
@@ -109,17 +184,9 @@ Result<void> ColorConverter::Convert(const AVFrame* src_frame,
                     src_frame->height));
   }
 
-  // 设置目标帧属性
-  dst_frame->width = dst_width_;
-  dst_frame->height = dst_height_;
-  dst_frame->format = static_cast<int>(dst_format_);
-
-  // 执行转换
-  int result = sws_scale(sws_ctx_, src_frame->data, src_frame->linesize, 0,
-                         src_height_, dst_frame->data, dst_frame->linesize);
-
-  if (result <= 0) {
-    return Result<void>::Err(ErrorCode::kCodecError, "sws_scale failed");
+  auto result = Scale(src_frame->data, src_frame->linesize, dst_frame);
+  if (result.IsErr()) {
+    return result;
   }
 
   // 复制时间戳
@@ -175,11 +242,104 @@ Result<void> ColorConverter::Convert(const uint8_t* const* src_data,
     return Result<void>::Err(ErrorCode::kInvalidParameter, "Null pointer");
   }
 
+  return Scale(src_data, src_linesize, dst_frame);
+}
+
+Result<void> ColorConverter::ConvertIncremental(
+    const uint8_t* src_data,
+    int src_linesize,
+    const std::vector<media::capture::DirtyRect>& dirty_rects,
+    bool full_frame,
+    AVFrame* dst_frame) {
+  if (!sws_ctx_) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "ColorConverter not initialized");
+  }
+
+  if (!src_data || !dst_frame) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter, "Null pointer");
+  }
+
+  full_frame = full_frame || !fast_path_;
+  if (!incremental_frame_) {
+    incremental_frame_ = MakeAVFrame();
+    if (!incremental_frame_) {
+      return Result<void>::Err(ErrorCode::kOutOfMemory,
+                               "Failed to allocate frame");
+    }
+    auto alloc_result = AllocateDstFrame(incremental_frame_.get());
+    if (alloc_result.IsErr()) {
+      incremental_frame_.reset();
+      return alloc_result;
+    }
+    full_frame = true;
+  }
+
+  // 下游仍持有引用时从池中取新缓冲并复制当前内容，之后就地更新
+  AVFrame* frame = incremental_frame_.get();
+  if (!av_frame_is_writable(frame)) {
+    if (!spare_frame_) {
+      spare_frame_ = MakeAVFrame();
+      if (!spare_frame_) {
+        return Result<void>::Err(ErrorCode::kOutOfMemory,
+                                 "Failed to allocate frame");
+      }
+    }
+    auto alloc_result = AllocateDstFrame(spare_frame_.get());
+    if (alloc_result.IsErr()) {
+      return alloc_result;
+    }
+    if (av_frame_copy(spare_frame_.get(), frame) < 0) {
+      av_frame_unref(spare_frame_.get());
+      return Result<void>::Err(ErrorCode::kCodecError,
+                               "Failed to copy frame");
+    }
+    std::swap(incremental_frame_, spare_frame_);
+    av_frame_unref(spare_frame_.get());
+    frame = incremental_frame_.get();
+  }
+
+  if (full_frame) {
+    const uint8_t* src_planes[4] = {src_data, nullptr, nullptr, nullptr};
+    const int src_linesizes[4] = {src_linesize, 0, 0, 0};
+    auto result = Scale(src_planes, src_linesizes, frame);
+    if (result.IsErr()) {
+      // 内容不完整，下次整帧转换
+      incremental_frame_.reset();
+      return result;
+    }
+  } else {
+    fast_path_->ConvertRects(src_data, src_linesize, src_width_,
+                             src_height_, dirty_rects, frame->data[0],
+                             frame->linesize[0], frame->data[1],
+                             frame->linesize[1], slice_pool_.get());
+  }
+
+  av_frame_unref(dst_frame);
+  if (av_frame_ref(dst_frame, frame) < 0) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to reference frame");
+  }
+
+  return Result<void>::Ok();
+}
+
+Result<void> ColorConverter::Scale(const uint8_t* const* src_data,
+                                   const int* src_linesize,
+                                   AVFrame* dst_frame) {
   // 设置目标帧属性
   dst_frame->width = dst_width_;
   dst_frame->height = dst_height_;
   dst_frame->format = static_cast<int>(dst_format_);
 
+  if (fast_path_) {
+    fast_path_->Convert(src_data[0], src_linesize[0], src_width_, src_height_,
+                        dst_frame->data[0], dst_frame->linesize[0],
+                        dst_frame->data[1], dst_frame->linesize[1],
+                        slice_pool_.get());
+    return Result<void>::Ok();
+  }
+
   // 执行转换
   int result = sws_scale(sws_ctx_, src_data, src_linesize, 0, src_height_,
                          dst_frame->data, dst_frame->linesize);
@@ -197,6 +357,11 @@ Result<void> ColorConverter::AllocateDstFrame(AVFrame* frame) const {
                              "Null frame pointer");
   }
 
+  if (frame_pool_) {
+    return frame_pool_->Acquire(frame);
+  }
+
+  av_frame_unref(frame);
   frame->format = static_cast<int>(dst_format_);
   frame->width = dst_width_;
   frame->height = dst_height_;
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "../../../common/error.h"
+#include "../../../common/slice_pool.h"
+#include "../../capture/screen_capturer.h"
 #include "../ffmpeg_types.h"
+#include "../video_frame_pool.h"
+#include "bgra_to_nv12.h"
 
 extern "C" {
 #include <libavutil/frame.h>
@@ -28,16 +33,65 @@ struct ColorConverterConfig {
 
   // 缩放算法
   int sws_flags = SWS_BILINEAR;  ///< 缩放算法标志
+
+  // YUV 矩阵与范围，应与 EncoderConfig 一致
+  AVColorSpace color_space = AVCOL_SPC_BT709;
+  AVColorRange color_range = AVCOL_RANGE_JPEG;
+
+  /// 向量化内核的并行线程数（含调用线程）；0 表示按分辨率自动选择（约每
+  /// 250 万像素一个线程，不超过硬件线程数）。swscale 路径总是单线程
+  int threads = 1;
+
+  /// 输出帧缓冲池使用大页（见 VideoFramePoolConfig）
+  bool huge_pages = false;
+};
+
+/// @brief 增量色彩转换接口（VideoSendPipeline 的转换阶段）
+///
+/// 默认实现为 ColorConverter；测试可替换为不依赖 swscale 的替身。
+class IFrameConverter {
+ public:
+  virtual ~IFrameConverter() = default;
+
+  /// @brief 初始化；已初始化时须先 Shutdown()
+  virtual Result<void> Initialize(const ColorConverterConfig& config) = 0;
+
+  /// @brief 释放资源，之后可重新 Initialize()
+  virtual void Shutdown() = 0;
+
+  /// @brief 增量转换，语义见 ColorConverter::ConvertIncremental()
+  virtual Result<void> ConvertIncremental(
+      const uint8_t* src_data,
+      int src_linesize,
+      const std::vector<media::capture::DirtyRect>& dirty_rects,
+      bool full_frame,
+      AVFrame* dst_frame) = 0;
+
+  /// @brief 输出与源逐像素对应（不缩放的向量化内核），复制命令依赖它
+  virtual bool UsesFastPath() const = 0;
+
+  virtual bool IsInitialized() const = 0;
+  virtual int GetSrcWidth() const = 0;
+  virtual int GetSrcHeight() const = 0;
+  virtual AVPixelFormat GetSrcFormat() const = 0;
 };
 
 /// @brief 色彩空间转换器
 ///
 /// 负责将屏幕采集的 BGRA 格式转换为编码器需要的 NV12/YUV420P 格式。
 /// 也可用于分辨率缩放。
-class ColorConverter {
+///
+/// BGRA → NV12、不缩放且为 BT.709 时使用 BgraToNv12 向量化内核，其余
+/// 情况使用 swscale。ConvertIncremental() 维护一个持久的目标帧，只转换
+/// 采集器报告的脏区域。threads 大于 1 时向量化内核在常驻线程上按水平
+/// 条带并行，每帧不创建线程。
+///
+/// 输出帧（AllocateDstFrame、Convert(src_frame)、增量转换的持久帧及其写时
+/// 复制）都从固定尺寸的 VideoFramePool 中分配，稳态下不再分配大块内存。
+class ColorConverter : public IFrameConverter {
  public:
   ColorConverter() = default;
-  ~ColorConverter();
+  ~ColorConverter() override;
 
   // 禁止拷贝
   ColorConverter(const ColorConverter&) = delete;
@@ -50,10 +104,10 @@ class ColorConverter {
   /// @brief 初始化转换器
   /// @param config 转换配置
   /// @return 成功返回 Ok，失败返回错误
-  Result<void> Initialize(const ColorConverterConfig& config);
+  Result<void> Initialize(const ColorConverterConfig& config) override;
 
   /// @brief 关闭转换器并释放资源
-  void Shutdown();
+  void Shutdown() override;
 
   /// @brief 转换帧
   /// @param src_frame 源帧（BGRA 等）
@@ -75,15 +129,47 @@ class ColorConverter {
                        const int* src_linesize,
                        AVFrame* dst_frame);
 
+  /// @brief 增量转换：只转换脏区域，其余区域保留上一次的结果
+  ///
+  /// 转换结果写入内部持久帧，dst_frame 被替换为它的引用。下游仍持有上一次
+  /// 的引用时，持久帧先复制一份再更新，不会改动已交出的帧。
+  /// 首次调用、full_frame 为 true 或不走向量化内核（缩放时脏区域无法逐像
+  /// 素对应）时整帧转换。
+  /// @param src_data 源 BGRA 数据
+  /// @param src_linesize 源行字节数
+  /// @param dirty_rects 相对上一次调用变化的区域（源坐标）
+  /// @param full_frame 忽略 dirty_rects 整帧转换
+  /// @param dst_frame 输出，原有引用被释放
+  /// @return 成功返回 Ok
+  Result<void> ConvertIncremental(
+      const uint8_t* src_data,
+      int src_linesize,
+      const std::vector<media::capture::DirtyRect>& dirty_rects,
+      bool full_frame,
+      AVFrame* dst_frame) override;
+
+  /// @brief 是否使用向量化内核
+  bool UsesFastPath() const override { return fast_path_ != nullptr; }
+
+  /// @brief 输出帧池统计；池不可用（如硬件像素格式）时全为 0
+  VideoFramePool::Stats GetFramePoolStats() const {
+    return frame_pool_ ? frame_pool_->GetStats() : VideoFramePool::Stats{};
+  }
+
+  /// @brief 转换使用的线程数（含调用线程）
+  size_t GetThreadCount() const {
+    return slice_pool_ ? slice_pool_->GetThreadCount() : 1;
+  }
+
   /// @brief 检查是否已初始化
   /// @return 如果已初始化返回 true
-  bool IsInitialized() const { return sws_ctx_ != nullptr; }
+  bool IsInitialized() const override { return sws_ctx_ != nullptr; }
 
   /// @brief 获取源宽度
-  int GetSrcWidth() const { return src_width_; }
+  int GetSrcWidth() const override { return src_width_; }
 
   /// @brief 获取源高度
-  int GetSrcHeight() const { return src_height_; }
+  int GetSrcHeight() const override { return src_height_; }
 
   /// @brief 获取目标宽度
   int GetDstWidth() const { return dst_width_; }
@@ -92,18 +178,30 @@ class ColorConverter {
   int GetDstHeight() const { return dst_height_; }
 
   /// @brief 获取源像素格式
-  AVPixelFormat GetSrcFormat() const { return src_format_; }
+  AVPixelFormat GetSrcFormat() const override { return src_format_; }
 
   /// @brief 获取目标像素格式
   AVPixelFormat GetDstFormat() const { return dst_format_; }
 
-  /// @brief 分配目标帧 buffer
-  /// @param frame 帧对象
+  /// @brief 分配目标帧 buffer（优先从帧池中取）
+  /// @param frame 帧对象，原有引用先释放
   /// @return 成功返回 Ok
   Result<void> AllocateDstFrame(AVFrame* frame) const;
 
  private:
+  /// @brief 整帧转换到已分配的目标帧
+  Result<void> Scale(const uint8_t* const* src_data,
+                     const int* src_linesize,
+                     AVFrame* dst_frame);
+
   ::SwsContext* sws_ctx_ = nullptr;
+  std::unique_ptr<BgraToNv12> fast_path_;
+  std::unique_ptr<SlicePool> slice_pool_;  ///< 仅向量化内核使用
+  /// 输出帧缓冲池；unique_ptr 使 const 的 AllocateDstFrame() 可以取帧，
+  /// 也让 ColorConverter 可移动（池的分配回调持有池的地址）
+  std::unique_ptr<VideoFramePool> frame_pool_;
+  AVFramePtr incremental_frame_;  ///< ConvertIncremental() 的持久帧
+  AVFramePtr spare_frame_;        ///< 持久帧写时复制的目标，复用结构体
 
   int src_width_ = 0;
   int src_height_ = 0;
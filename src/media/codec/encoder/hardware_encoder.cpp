@@ -27,6 +27,13 @@ Result<void> HardwareEncoder::Initialize(const EncoderConfig& config) {
   config_ = config;
   hw_type_ = config.hw_encoder_type;
 
+  // 硬件编码器的参考帧结构不可控，只输出单层
+  if (config_.temporal_layers > 1) {
+    ZENREMOTE_WARN(
+        "Temporal layers not supported by hardware encoders, using one layer");
+    config_.temporal_layers = 1;
+  }
+
   // 验证参数
   if (config_.width <= 0 || config_.height <= 0) {
     return Result<void>::Err(ErrorCode::kInvalidParameter,
@@ -154,6 +161,13 @@ Result<void> HardwareEncoder::ConfigureContext() {
       ctx->rc_buffer_size = config_.max_bitrate;
       break;
 
+    case RateControlMode::kLowLatency:
+      // 缓冲约一帧，由编码器在帧内限制大小
+      ctx->bit_rate = config_.bitrate;
+      ctx->rc_max_rate = config_.bitrate;
+      ctx->rc_buffer_size = config_.bitrate / config_.framerate;
+      break;
+
     case RateControlMode::kCQP:
       // 通过私有选项设置
       break;
@@ -216,7 +230,8 @@ Result<void> HardwareEncoder::SetNVENCOptions() {
   }
 
   // 码率控制
-  if (config_.rate_control == RateControlMode::kCBR) {
+  if (config_.rate_control == RateControlMode::kCBR ||
+      config_.rate_control == RateControlMode::kLowLatency) {
     av_opt_set(ctx->priv_data, "rc", "cbr", 0);
   } else if (config_.rate_control == RateControlMode::kVBR) {
     av_opt_set(ctx->priv_data, "rc", "vbr", 0);
@@ -305,7 +320,8 @@ Result<void> HardwareEncoder::SetAMFOptions() {
   }
 
   // 码率控制
-  if (config_.rate_control == RateControlMode::kCBR) {
+  if (config_.rate_control == RateControlMode::kCBR ||
+      config_.rate_control == RateControlMode::kLowLatency) {
     av_opt_set(ctx->priv_data, "rc", "cbr", 0);
   } else if (config_.rate_control == RateControlMode::kVBR) {
     av_opt_set(ctx->priv_data, "rc", "vbr_peak", 0);
@@ -430,6 +446,7 @@ Result<bool> HardwareEncoder::ProcessOutput(EncodedPacket& packet) {
   packet.dts = pkt_->dts;
   packet.duration = pkt_->duration;
   packet.is_keyframe = (pkt_->flags & AV_PKT_FLAG_KEY) != 0;
+  packet.temporal_id = 0;
 
   return Result<bool>::Ok(true);
 }
@@ -486,7 +503,12 @@ Result<void> HardwareEncoder::UpdateBitrate(int bitrate) {
   // 硬件编码器的动态码率更新可能需要重新配置
   // 这里只是更新配置，实际效果取决于具体的硬件编码器支持
   codec_ctx_->bit_rate = bitrate;
-  codec_ctx_->rc_max_rate = bitrate + bitrate / 4;
+  if (config_.rate_control == RateControlMode::kLowLatency) {
+    codec_ctx_->rc_max_rate = bitrate;
+    codec_ctx_->rc_buffer_size = bitrate / config_.framerate;
+  } else {
+    codec_ctx_->rc_max_rate = bitrate + bitrate / 4;
+  }
 
   config_.bitrate = bitrate;
 
@@ -0,0 +1,171 @@
+#include "roi_map.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+
+/// H.264/HEVC 8bit 的 QP 范围，libx264/libx265 以它换算 qoffset
+constexpr int kQpRange = 51;
+
+int64_t Area(const DirtyRect& rect) {
+  return static_cast<int64_t>(rect.Width()) * rect.Height();
+}
+
+DirtyRect Union(const DirtyRect& a, const DirtyRect& b) {
+  return {std::min(a.left, b.left), std::min(a.top, b.top),
+          std::max(a.right, b.right), std::max(a.bottom, b.bottom)};
+}
+
+bool Contains(const DirtyRect& outer, const DirtyRect& inner) {
+  return outer.left <= inner.left && outer.top <= inner.top &&
+         outer.right >= inner.right && outer.bottom >= inner.bottom;
+}
+
+/// 缩放到目标尺寸（向外取整），外扩到块边界并裁剪
+DirtyRect ScaleAndAlign(const DirtyRect& rect,
+                        int src_width,
+                        int src_height,
+                        int dst_width,
+                        int dst_height,
+                        int block) {
+  auto scale_down = [](int32_t value, int dst, int src) {
+    return static_cast<int32_t>(static_cast<int64_t>(value) * dst / src);
+  };
+  auto scale_up = [](int32_t value, int dst, int src) {
+    return static_cast<int32_t>(
+        (static_cast<int64_t>(value) * dst + src - 1) / src);
+  };
+  DirtyRect out{scale_down(rect.left, dst_width, src_width),
+                scale_down(rect.top, dst_height, src_height),
+                scale_up(rect.right, dst_width, src_width),
+                scale_up(rect.bottom, dst_height, src_height)};
+  out.left = std::max(out.left / block * block, 0);
+  out.top = std::max(out.top / block * block, 0);
+  out.right = std::min((out.right + block - 1) / block * block, dst_width);
+  out.bottom = std::min((out.bottom + block - 1) / block * block, dst_height);
+  return out;
+}
+
+}  // namespace
+
+std::vector<DirtyRect> BuildRoiRects(const std::vector<DirtyRect>& dirty_rects,
+                                     int src_width,
+                                     int src_height,
+                                     int dst_width,
+                                     int dst_height,
+                                     const RoiMapConfig& config) {
+  std::vector<DirtyRect> rects;
+  if (dirty_rects.empty() || src_width <= 0 || src_height <= 0 ||
+      dst_width <= 0 || dst_height <= 0) {
+    return rects;
+  }
+
+  const int block = std::max(config.block_size, 1);
+  rects.reserve(dirty_rects.size());
+  for (const auto& dirty : dirty_rects) {
+    if (dirty.Width() <= 0 || dirty.Height() <= 0) {
+      continue;
+    }
+    const DirtyRect rect = ScaleAndAlign(dirty, src_width, src_height,
+                                         dst_width, dst_height, block);
+    if (rect.Width() > 0 && rect.Height() > 0) {
+      rects.push_back(rect);
+    }
+  }
+
+  // 对齐后常有重复（同一宏块内的多个字符），去掉被包含的
+  for (size_t i = 0; i < rects.size(); ++i) {
+    for (size_t j = 0; j < rects.size();) {
+      if (i != j && Contains(rects[i], rects[j])) {
+        rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(j));
+        if (j < i) {
+          --i;
+        }
+      } else {
+        ++j;
+      }
+    }
+  }
+
+  const size_t max_regions = std::max<size_t>(config.max_regions, 1);
+  if (rects.size() > max_regions * 4) {
+    // 贪心合并是 O(n^3)，矩形很多时取外接矩形
+    DirtyRect bounds = rects.front();
+    for (const auto& rect : rects) {
+      bounds = Union(bounds, rect);
+    }
+    rects.assign(1, bounds);
+  }
+  while (rects.size() > max_regions) {
+    size_t best_i = 0;
+    size_t best_j = 1;
+    int64_t best_cost = INT64_MAX;
+    for (size_t i = 0; i < rects.size(); ++i) {
+      for (size_t j = i + 1; j < rects.size(); ++j) {
+        const int64_t cost =
+            Area(Union(rects[i], rects[j])) - Area(rects[i]) - Area(rects[j]);
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+    rects[best_i] = Union(rects[best_i], rects[best_j]);
+    rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(best_j));
+  }
+
+  int64_t area = 0;
+  for (const auto& rect : rects) {
+    area += Area(rect);
+  }
+  const auto frame_area = static_cast<double>(dst_width) * dst_height;
+  if (static_cast<double>(area) > config.max_area_ratio * frame_area) {
+    rects.clear();
+  }
+  return rects;
+}
+
+Result<void> AttachRegionsOfInterest(AVFrame* frame,
+                                     const std::vector<DirtyRect>& rects,
+                                     int qp_delta) {
+  if (!frame) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Null frame pointer");
+  }
+
+  av_frame_remove_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+  if (rects.empty()) {
+    return Result<void>::Ok();
+  }
+
+  AVFrameSideData* side_data = av_frame_new_side_data(
+      frame, AV_FRAME_DATA_REGIONS_OF_INTEREST,
+      rects.size() * sizeof(AVRegionOfInterest));
+  if (!side_data) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to allocate ROI side data");
+  }
+
+  const int delta = std::clamp(qp_delta, -kQpRange, kQpRange);
+  auto* regions = reinterpret_cast<AVRegionOfInterest*>(side_data->data);
+  for (size_t i = 0; i < rects.size(); ++i) {
+    AVRegionOfInterest& roi = regions[i];
+    std::memset(&roi, 0, sizeof(roi));
+    roi.self_size = sizeof(AVRegionOfInterest);
+    roi.left = rects[i].left;
+    roi.top = rects[i].top;
+    roi.right = rects[i].right;
+    roi.bottom = rects[i].bottom;
+    roi.qoffset = AVRational{delta, kQpRange};
+  }
+  return Result<void>::Ok();
+}
+
+}  // namespace zenremote
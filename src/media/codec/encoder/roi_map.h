@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "../../../common/error.h"
+#include "../../capture/screen_capturer.h"
+#include "../ffmpeg_types.h"
+
+namespace zenremote {
+
+/// @brief 脏区域到编码器 ROI 的转换参数
+struct RoiMapConfig {
+  /// ROI 对齐的块大小（H.264 宏块 16，HEVC CTU 常用 32/64）
+  int block_size = 16;
+
+  /// 最多的区域数，超出时合并增加面积最少的一对
+  size_t max_regions = 16;
+
+  /// 变化区域占整帧的比例超过此值时不生成 ROI（整帧都是重点）
+  double max_area_ratio = 0.5;
+};
+
+/**
+ * @brief 把采集坐标下的脏区域换算为编码器坐标下的 ROI 矩形
+ *
+ * 按 src → dst 的比例缩放，外扩到 block_size 的整数倍并裁剪到帧内，
+ * 去掉被其他矩形包含的矩形。数量超过 max_regions 时贪心合并外接矩形
+ * 增加面积最少的一对，矩形过多时直接取外接矩形。结果可能相交（各区域
+ * 偏移相同，不影响编码）。变化面积超过 max_area_ratio 或没有脏区域时
+ * 返回空列表。
+ */
+std::vector<media::capture::DirtyRect> BuildRoiRects(
+    const std::vector<media::capture::DirtyRect>& dirty_rects,
+    int src_width,
+    int src_height,
+    int dst_width,
+    int dst_height,
+    const RoiMapConfig& config = {});
+
+/**
+ * @brief 以 AV_FRAME_DATA_REGIONS_OF_INTEREST 附加到帧上
+ *
+ * 原有的 ROI side data 先移除；rects 为空时只移除。
+ * @param qp_delta 区域内相对帧 QP 的偏移，负值提高质量；按 H.264/HEVC
+ *        的 QP 范围 51 换算为 AVRegionOfInterest::qoffset
+ */
+Result<void> AttachRegionsOfInterest(
+    AVFrame* frame,
+    const std::vector<media::capture::DirtyRect>& rects,
+    int qp_delta);
+
+}  // namespace zenremote
@@ -4,6 +4,7 @@
 
 #include "common/log_manager.h"
 #include "common/timer_util.h"
+#include "media/codec/encoder/temporal_layers.h"
 
 extern "C" {
 #include <libavutil/opt.h>
@@ -11,6 +12,28 @@ extern "C" {
 
 namespace zenremote {
 
+namespace {
+
+/**
+ * @brief 以分层 B 帧实现的时间层参考结构
+ *
+ * 固定的 minigop（b-adapt=0、无场景切换）保证显示顺序上 TID 的周期不变：
+ * L1T2 为 P b P b，b 不被参考；L1T3 为 P b B b P，B 只参考 P（b-pyramid
+ * strict），b 不被参考；ref=1 使 P 只参考上一个 P。代价是 minigop 内
+ * TemporalLayerCycle - 1 帧的重排序延迟。
+ */
+std::string TemporalLayerParams(int temporal_layers, bool hevc) {
+  const int b_frames = TemporalLayerCycle(temporal_layers) - 1;
+  const bool pyramid = temporal_layers > 2;
+  // x265 的 b-pyramid 为布尔值，x264 区分 none / strict / normal
+  const char* b_pyramid =
+      hevc ? (pyramid ? "1" : "0") : (pyramid ? "strict" : "none");
+  return fmt::format("bframes={}:b-adapt=0:b-pyramid={}:scenecut=0:ref=1",
+                     b_frames, b_pyramid);
+}
+
+}  // namespace
+
 SoftwareEncoder::SoftwareEncoder() = default;
 
 SoftwareEncoder::~SoftwareEncoder() {
@@ -35,6 +58,17 @@ Result<void> SoftwareEncoder::Initialize(const EncoderConfig& config) {
     return Result<void>::Err(ErrorCode::kInvalidParameter, "Invalid framerate");
   }
 
+  if (config_.temporal_layers < 1 ||
+      config_.temporal_layers > kMaxTemporalLayers) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid temporal layer count");
+  }
+  if (config_.temporal_layers > 1) {
+    // 关键帧必须落在 TL0 上
+    const int cycle = TemporalLayerCycle(config_.temporal_layers);
+    config_.gop_size = (config_.gop_size + cycle - 1) / cycle * cycle;
+  }
+
   // 查找编码器
   const char* encoder_name = "libx264";
   if (config_.codec_id == AV_CODEC_ID_HEVC) {
@@ -118,7 +152,9 @@ Result<void> SoftwareEncoder::ConfigureContext() {
 
   // GOP 设置
   ctx->gop_size = config_.gop_size;
-  ctx->max_b_frames = config_.max_b_frames;
+  ctx->max_b_frames = config_.temporal_layers > 1
+                          ? TemporalLayerCycle(config_.temporal_layers) - 1
+                          : config_.max_b_frames;
 
   // 线程设置
   if (config_.thread_count > 0) {
@@ -143,6 +179,13 @@ Result<void> SoftwareEncoder::ConfigureContext() {
       ctx->rc_buffer_size = config_.max_bitrate;
       break;
 
+    case RateControlMode::kLowLatency:
+      // 缓冲约一帧：场景切换时编码器在帧内提高 QP，而不是输出数倍大小的帧
+      ctx->bit_rate = config_.bitrate;
+      ctx->rc_max_rate = config_.bitrate;
+      ctx->rc_buffer_size = config_.bitrate / config_.framerate;
+      break;
+
     case RateControlMode::kCRF:
       // CRF 通过私有选项设置
       break;
@@ -200,20 +243,59 @@ Result<void> SoftwareEncoder::SetX264Options() {
     ZENREMOTE_WARN("Failed to set x264 profile: {}", config_.profile);
   }
 
+  // x264-params / x265-params，在 preset/tune 之后生效
+  const bool hevc = config_.codec_id == AV_CODEC_ID_HEVC;
+  std::string params;
+
   // 禁用 B-frames 以降低延迟
-  if (config_.max_b_frames == 0) {
+  if (config_.temporal_layers > 1) {
+    // 覆盖 zerolatency 的 bframes=0
+    params = TemporalLayerParams(config_.temporal_layers, hevc);
+  } else if (config_.max_b_frames == 0) {
     av_opt_set_int(ctx->priv_data, "b-frames", 0, 0);
     av_opt_set_int(ctx->priv_data, "b-adapt", 0, 0);
   }
 
+  // ROI 依赖自适应量化：ultrafast 预设关闭了 AQ，此时 FFmpeg 忽略 ROI
+  if (config_.roi_encoding) {
+    if (hevc) {
+      params += params.empty() ? "aq-mode=1" : ":aq-mode=1";
+    } else {
+      av_opt_set_int(ctx->priv_data, "aq-mode", 1, 0);  // variance
+    }
+  }
+
+  if (config_.slice_max_size > 0) {
+    if (hevc) {
+      ZENREMOTE_WARN("slice-max-size is not supported by libx265, ignored");
+    } else {
+      if (!params.empty()) {
+        params += ':';
+      }
+      params += fmt::format("slice-max-size={}", config_.slice_max_size);
+    }
+  }
+
+  if (!params.empty()) {
+    const char* params_key = hevc ? "x265-params" : "x264-params";
+    ret = av_opt_set(ctx->priv_data, params_key, params.c_str(), 0);
+    if (ret < 0) {
+      return Result<void>::Err(
+          ErrorCode::kEncoderInitFailed,
+          fmt::format("Failed to set encoder params: {}", params));
+    }
+  }
+
   // 禁用前向预测以降低延迟
   if (config_.zero_latency) {
     av_opt_set_int(ctx->priv_data, "lookahead", 0, 0);
     av_opt_set_int(ctx->priv_data, "rc-lookahead", 0, 0);
   }
 
-  // 快速首帧
-  av_opt_set_int(ctx->priv_data, "intra-refresh", 1, 0);
+  // 快速首帧（周期帧内刷新跨越多帧，与时间分层同时使用时丢层会破坏刷新）
+  if (config_.temporal_layers == 1) {
+    av_opt_set_int(ctx->priv_data, "intra-refresh", 1, 0);
+  }
 
   return Result<void>::Ok();
 }
@@ -245,8 +327,9 @@ Result<bool> SoftwareEncoder::Encode(AVFrame* frame, EncodedPacket& packet) {
   if (frame) {
     frame->pts = frame_count_++;
 
-    // 强制关键帧
-    if (force_keyframe_) {
+    // 强制关键帧（分层时推迟到下一个 TL0，保持层周期）
+    if (force_keyframe_ &&
+        TemporalLayerId(frame->pts, config_.temporal_layers) == 0) {
       frame->pict_type = AV_PICTURE_TYPE_I;
       force_keyframe_ = false;
     } else {
@@ -316,6 +399,8 @@ Result<bool> SoftwareEncoder::ProcessOutput(EncodedPacket& packet) {
   packet.dts = pkt_->dts;
   packet.duration = pkt_->duration;
   packet.is_keyframe = (pkt_->flags & AV_PKT_FLAG_KEY) != 0;
+  // 输出为解码顺序，层号按显示顺序（pts 即输入帧序号）计算
+  packet.temporal_id = TemporalLayerId(pkt_->pts, config_.temporal_layers);
 
   return Result<bool>::Ok(true);
 }
@@ -373,7 +458,12 @@ Result<void> SoftwareEncoder::UpdateBitrate(int bitrate) {
 
   // 动态更新码率（libx264 支持）
   codec_ctx_->bit_rate = bitrate;
-  codec_ctx_->rc_max_rate = bitrate + bitrate / 4;  // 25% 余量
+  if (config_.rate_control == RateControlMode::kLowLatency) {
+    codec_ctx_->rc_max_rate = bitrate;
+    codec_ctx_->rc_buffer_size = bitrate / config_.framerate;
+  } else {
+    codec_ctx_->rc_max_rate = bitrate + bitrate / 4;  // 25% 余量
+  }
 
   config_.bitrate = bitrate;
 
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+namespace zenremote {
+
+/// @brief 支持的最大时间层数（L1T3）
+constexpr int kMaxTemporalLayers = 3;
+
+/**
+ * @brief 时间可伸缩的参考结构（按显示顺序的帧序号）
+ *
+ * - L1T1：全部为 TL0
+ * - L1T2：0 1 0 1 ...，TL1 帧不被参考
+ * - L1T3：0 2 1 2 ...，TL1 只参考 TL0，TL2 不被参考
+ *
+ * 丢弃 TID 大于 N 的帧后，剩余帧仍可解码，帧率减半（或 1/4）。
+ */
+inline uint8_t TemporalLayerId(int64_t frame_index, int temporal_layers) {
+  if (temporal_layers <= 1 || frame_index < 0) {
+    return 0;
+  }
+  if (temporal_layers == 2) {
+    return frame_index % 2 == 0 ? 0 : 1;
+  }
+  switch (frame_index % 4) {
+    case 0:
+      return 0;
+    case 2:
+      return 1;
+    default:
+      return 2;
+  }
+}
+
+/// @brief 一个 TL0 周期内的帧数（1、2、4）
+inline int TemporalLayerCycle(int temporal_layers) {
+  if (temporal_layers <= 1) {
+    return 1;
+  }
+  return temporal_layers == 2 ? 2 : 4;
+}
+
+/// @brief 该帧是否被其他帧参考（最高层的帧不被参考，可直接丢弃）
+inline bool IsTemporalLayerReference(uint8_t temporal_id,
+                                     int temporal_layers) {
+  return temporal_id + 1 < temporal_layers;
+}
+
+}  // namespace zenremote
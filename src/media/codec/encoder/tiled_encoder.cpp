@@ -0,0 +1,392 @@
+#include "tiled_encoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "common/log_manager.h"
+#include "common/timer_util.h"
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+
+/// @brief 把输入帧上与 rect 相交的 ROI 平移到分块坐标，附加到分块帧
+Result<void> CropRegionsOfInterest(const AVFrame* frame,
+                                   const DirtyRect& rect,
+                                   AVFrame* tile) {
+  av_frame_remove_side_data(tile, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+  const AVFrameSideData* side_data =
+      av_frame_get_side_data(frame, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+  if (!side_data || side_data->size < sizeof(AVRegionOfInterest)) {
+    return Result<void>::Ok();
+  }
+  const uint32_t self_size =
+      reinterpret_cast<const AVRegionOfInterest*>(side_data->data)->self_size;
+  if (self_size < sizeof(AVRegionOfInterest) ||
+      side_data->size % self_size != 0) {
+    return Result<void>::Ok();
+  }
+
+  std::vector<AVRegionOfInterest> cropped;
+  for (size_t offset = 0; offset < side_data->size; offset += self_size) {
+    AVRegionOfInterest roi;
+    std::memcpy(&roi, side_data->data + offset, sizeof(roi));
+    const int left = std::max(roi.left, rect.left);
+    const int top = std::max(roi.top, rect.top);
+    const int right = std::min(roi.right, rect.right);
+    const int bottom = std::min(roi.bottom, rect.bottom);
+    if (left >= right || top >= bottom) {
+      continue;
+    }
+    roi.self_size = sizeof(AVRegionOfInterest);
+    roi.left = left - rect.left;
+    roi.top = top - rect.top;
+    roi.right = right - rect.left;
+    roi.bottom = bottom - rect.top;
+    cropped.push_back(roi);
+  }
+  if (cropped.empty()) {
+    return Result<void>::Ok();
+  }
+  const size_t size = cropped.size() * sizeof(AVRegionOfInterest);
+  AVFrameSideData* out =
+      av_frame_new_side_data(tile, AV_FRAME_DATA_REGIONS_OF_INTEREST, size);
+  if (!out) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to allocate tile ROI");
+  }
+  std::memcpy(out->data, cropped.data(), size);
+  return Result<void>::Ok();
+}
+
+}  // namespace
+
+TiledVideoEncoder::TiledVideoEncoder(TileEncoderFactory factory)
+    : factory_(std::move(factory)) {}
+
+TiledVideoEncoder::~TiledVideoEncoder() {
+  Shutdown();
+}
+
+Result<void> TiledVideoEncoder::Initialize(const EncoderConfig& config) {
+  if (initialized_) {
+    return Result<void>::Err(ErrorCode::kAlreadyInitialized,
+                             "Encoder already initialized");
+  }
+  if (!factory_ || config.width <= 0 || config.height <= 0 ||
+      config.framerate <= 0 || config.tile_columns < 1 ||
+      config.tile_rows < 1) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid tiled encoder parameters");
+  }
+  if (config.input_format != AV_PIX_FMT_NV12 &&
+      config.input_format != AV_PIX_FMT_YUV420P) {
+    return Result<void>::Err(ErrorCode::kUnsupportedPixelFormat,
+                             "Tiled encoding needs NV12 or YUV420P input");
+  }
+  if (config.temporal_layers != 1 || config.max_b_frames != 0) {
+    // 跳过的分块使各编码器的帧序不同，有重排时无法按输入帧组包
+    return Result<void>::Err(
+        ErrorCode::kNotSupported,
+        "Tiled encoding needs zero-delay tiles (no B-frames or layers)");
+  }
+
+  config_ = config;
+  layout_ = ComputeTileLayout(config.width, config.height, config.tile_columns,
+                              config.tile_rows);
+  tiles_.clear();
+  tiles_.resize(layout_.TileCount());
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    const DirtyRect& rect = layout_.tiles[i];
+    EncoderConfig tile_config = config;
+    tile_config.width = rect.Width();
+    tile_config.height = rect.Height();
+    tile_config.tile_columns = 1;
+    tile_config.tile_rows = 1;
+    // 分块之间已并行，编码器内部再开线程只会争抢核心
+    tile_config.thread_count = 1;
+    tile_config.bitrate = TileBitrate(config.bitrate, i);
+    tile_config.max_bitrate = TileBitrate(config.max_bitrate, i);
+
+    auto encoder = factory_(tile_config);
+    tiles_[i].frame = MakeAVFrame();
+    if (encoder.IsErr() || !tiles_[i].frame) {
+      const ErrorCode code =
+          encoder.IsErr() ? encoder.Code() : ErrorCode::kOutOfMemory;
+      const std::string message = encoder.IsErr()
+                                      ? encoder.Message()
+                                      : std::string("Failed to allocate frame");
+      tiles_.clear();
+      return Result<void>::Err(
+          code, fmt::format("Tile {} encoder: {}", i, message));
+    }
+    tiles_[i].encoder = std::move(encoder.Value());
+  }
+
+  size_t threads = config.thread_count > 0
+                       ? static_cast<size_t>(config.thread_count)
+                       : std::max(std::thread::hardware_concurrency(), 1u);
+  threads = std::min(threads, tiles_.size());
+  pool_ = std::make_unique<SlicePool>(threads);
+
+  encoder_name_ = fmt::format("tiled {}x{} {}", layout_.columns, layout_.rows,
+                              tiles_.front().encoder->GetEncoderName());
+  initialized_ = true;
+  force_keyframe_ = false;
+  regions_known_ = false;
+  frame_count_ = 0;
+  stats_ = EncoderStats{};
+  total_encode_time_ms_ = 0;
+
+  ZENREMOTE_INFO("TiledVideoEncoder initialized: {}x{} as {} tiles on {} "
+                 "threads, encoder={}",
+                 config_.width, config_.height, tiles_.size(),
+                 pool_->GetThreadCount(), encoder_name_);
+  return Result<void>::Ok();
+}
+
+void TiledVideoEncoder::Shutdown() {
+  if (!initialized_) {
+    return;
+  }
+  pool_.reset();
+  tiles_.clear();
+  initialized_ = false;
+  ZENREMOTE_INFO("TiledVideoEncoder shutdown, encoded {} frames",
+                 stats_.frames_encoded);
+}
+
+int TiledVideoEncoder::TileBitrate(int bitrate, size_t index) const {
+  const DirtyRect& rect = layout_.tiles[index];
+  const int64_t area = static_cast<int64_t>(rect.Width()) * rect.Height();
+  const int64_t total = static_cast<int64_t>(layout_.width) * layout_.height;
+  return static_cast<int>(
+      std::max<int64_t>(static_cast<int64_t>(bitrate) * area / total, 1));
+}
+
+void TiledVideoEncoder::SetChangedRegions(
+    const std::vector<DirtyRect>& rects) {
+  if (!regions_known_) {
+    dirty_.assign(layout_.TileCount(), false);
+    regions_known_ = true;
+  }
+  MarkDirtyTiles(layout_, rects, dirty_);
+}
+
+Result<void> TiledVideoEncoder::PrepareTileFrame(const AVFrame* frame,
+                                                 size_t index) {
+  AVFrame* tile = tiles_[index].frame.get();
+  const DirtyRect& rect = layout_.tiles[index];
+  av_frame_unref(tile);
+  if (av_frame_ref(tile, frame) < 0) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to reference frame");
+  }
+  tile->crop_left = static_cast<size_t>(rect.left);
+  tile->crop_top = static_cast<size_t>(rect.top);
+  tile->crop_right = static_cast<size_t>(frame->width - rect.right);
+  tile->crop_bottom = static_cast<size_t>(frame->height - rect.bottom);
+  if (av_frame_apply_cropping(tile, AV_FRAME_CROP_UNALIGNED) < 0) {
+    av_frame_unref(tile);
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Failed to crop tile");
+  }
+  return CropRegionsOfInterest(frame, rect, tile);
+}
+
+Result<bool> TiledVideoEncoder::Encode(AVFrame* frame, EncodedPacket& packet) {
+  if (!initialized_) {
+    return Result<bool>::Err(ErrorCode::kNotInitialized,
+                             "Encoder not initialized");
+  }
+  if (!frame || frame->width != config_.width ||
+      frame->height != config_.height ||
+      frame->format != config_.input_format || frame->hw_frames_ctx) {
+    return Result<bool>::Err(ErrorCode::kInvalidParameter,
+                             "Frame does not match the tiled encoder");
+  }
+
+  TimerUtil timer;
+  const bool keyframe = force_keyframe_ || frame_count_ == 0;
+  const bool all_tiles = keyframe || !regions_known_;
+  force_keyframe_ = false;
+  regions_known_ = false;
+  selected_.clear();
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    if (all_tiles || dirty_[i]) {
+      selected_.push_back(i);
+    }
+  }
+
+  for (size_t index : selected_) {
+    if (keyframe) {
+      tiles_[index].encoder->ForceKeyFrame();
+    }
+    auto prepared = PrepareTileFrame(frame, index);
+    if (prepared.IsErr()) {
+      for (auto& tile : tiles_) {
+        av_frame_unref(tile.frame.get());
+      }
+      force_keyframe_ = keyframe;
+      return Result<bool>::Err(prepared.Code(), prepared.Message());
+    }
+  }
+
+  finished_tiles_ = 0;
+  streamed_bytes_ = 0;
+  pool_->Run(selected_.size(), [this](size_t k) {
+    Tile& tile = tiles_[selected_[k]];
+    tile.streamed = false;
+    tile.result = tile.encoder->Encode(tile.frame.get(), tile.packet);
+    // 释放对输入帧的引用，调用方可以就地更新它
+    av_frame_unref(tile.frame.get());
+    if (partial_output_) {
+      EmitPartialTile(selected_[k]);
+    }
+  });
+
+  BeginTiledFrame(layout_, true, packet.data);
+  bool all_keyframes = selected_.size() == tiles_.size();
+  for (size_t index : selected_) {
+    Tile& tile = tiles_[index];
+    if (tile.result.IsErr()) {
+      // 已编码的分块随本帧一起丢弃，接收端缺少它们的参考帧
+      force_keyframe_ = true;
+      return Result<bool>::Err(
+          tile.result.Code(),
+          fmt::format("Tile {} encode failed: {}", index,
+                      tile.result.Message()));
+    }
+    if (!tile.result.Value()) {
+      all_keyframes = false;
+      continue;
+    }
+    all_keyframes = all_keyframes && tile.packet.is_keyframe;
+    if (tile.streamed) {
+      continue;
+    }
+    auto appended =
+        AppendTile(layout_, index, tile.packet.is_keyframe,
+                   tile.packet.data.data(), tile.packet.data.size(),
+                   packet.data);
+    if (appended.IsErr()) {
+      force_keyframe_ = true;
+      return Result<bool>::Err(appended.Code(), appended.Message());
+    }
+  }
+
+  packet.pts = frame_count_;
+  packet.dts = frame_count_;
+  packet.duration = 1;
+  packet.is_keyframe = all_keyframes;
+  packet.temporal_id = 0;
+  packet.end_of_frame = true;
+  ++frame_count_;
+  UpdateStats(packet.data.size() + streamed_bytes_, packet.is_keyframe,
+              timer.ElapsedMs());
+  return Result<bool>::Ok(true);
+}
+
+void TiledVideoEncoder::EmitPartialTile(size_t index) {
+  std::lock_guard<std::mutex> lock(partial_mutex_);
+  // 最后完成的分块由 Encode() 输出，帧结束标记不必等待额外的包
+  if (++finished_tiles_ == selected_.size()) {
+    return;
+  }
+  Tile& tile = tiles_[index];
+  // 出错由 Encode() 报告；已交出的分块接收端照常解码，不会显示半帧
+  if (tile.result.IsErr() || !tile.result.Value()) {
+    return;
+  }
+  BeginTiledFrame(layout_, false, partial_packet_.data);
+  if (AppendTile(layout_, index, tile.packet.is_keyframe,
+                 tile.packet.data.data(), tile.packet.data.size(),
+                 partial_packet_.data)
+          .IsErr()) {
+    return;  // 留在 Encode() 的包里并在那里报错
+  }
+  partial_packet_.pts = frame_count_;
+  partial_packet_.dts = frame_count_;
+  partial_packet_.duration = 1;
+  partial_packet_.is_keyframe = false;
+  partial_packet_.temporal_id = 0;
+  partial_packet_.end_of_frame = false;
+  streamed_bytes_ += partial_packet_.data.size();
+  partial_output_(partial_packet_);
+  tile.streamed = true;
+}
+
+Result<void> TiledVideoEncoder::Flush(std::vector<EncodedPacket>& packets) {
+  if (!initialized_) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "Encoder not initialized");
+  }
+  // 零延迟的分块编码器通常没有剩余输出；有则各自成包，接收端按分块合成
+  std::vector<EncodedPacket> flushed;
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    flushed.clear();
+    auto result = tiles_[i].encoder->Flush(flushed);
+    if (result.IsErr()) {
+      return result;
+    }
+    for (const auto& tile_packet : flushed) {
+      EncodedPacket packet;
+      BeginTiledFrame(layout_, true, packet.data);
+      auto appended = AppendTile(layout_, i, tile_packet.is_keyframe,
+                                 tile_packet.data.data(),
+                                 tile_packet.data.size(), packet.data);
+      if (appended.IsErr()) {
+        return appended;
+      }
+      packet.pts = std::max<int64_t>(frame_count_ - 1, 0);
+      packet.dts = packet.pts;
+      packet.duration = 1;
+      packets.push_back(std::move(packet));
+    }
+  }
+  return Result<void>::Ok();
+}
+
+Result<void> TiledVideoEncoder::UpdateBitrate(int bitrate) {
+  if (!initialized_) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "Encoder not initialized");
+  }
+  if (bitrate <= 0) {
+    return Result<void>::Err(ErrorCode::kInvalidBitrate, "Invalid bitrate");
+  }
+  for (size_t i = 0; i < tiles_.size(); ++i) {
+    auto result = tiles_[i].encoder->UpdateBitrate(TileBitrate(bitrate, i));
+    if (result.IsErr()) {
+      return result;
+    }
+  }
+  config_.bitrate = bitrate;
+  return Result<void>::Ok();
+}
+
+EncoderType TiledVideoEncoder::GetEncoderType() const {
+  return tiles_.empty() ? config_.encoder_type
+                        : tiles_.front().encoder->GetEncoderType();
+}
+
+void TiledVideoEncoder::UpdateStats(size_t bytes,
+                                    bool keyframe,
+                                    double encode_time_ms) {
+  stats_.frames_encoded++;
+  if (keyframe) {
+    stats_.keyframes_encoded++;
+  }
+  stats_.total_bytes += bytes;
+  total_encode_time_ms_ += encode_time_ms;
+  stats_.avg_encode_time_ms =
+      total_encode_time_ms_ / static_cast<double>(stats_.frames_encoded);
+  stats_.avg_bitrate = static_cast<double>(stats_.total_bytes) * 8 *
+                       config_.framerate /
+                       static_cast<double>(stats_.frames_encoded);
+}
+
+}  // namespace zenremote
@@ -3,6 +3,7 @@
 #include "common/log_manager.h"
 #include "hardware_encoder.h"
 #include "software_encoder.h"
+#include "tiled_encoder.h"
 
 namespace zenremote {
 
@@ -10,6 +11,20 @@ Result<std::unique_ptr<IVideoEncoder>> CreateVideoEncoder(
     const EncoderConfig& config) {
   std::unique_ptr<IVideoEncoder> encoder;
 
+  if (config.tile_columns * config.tile_rows > 1) {
+    // 每个分块按 1x1 配置递归创建，硬件编码器失败时同样逐块回退
+    auto tiled = std::make_unique<TiledVideoEncoder>(
+        [](const EncoderConfig& tile_config) {
+          return CreateVideoEncoder(tile_config);
+        });
+    auto result = tiled->Initialize(config);
+    if (result.IsErr()) {
+      return Result<std::unique_ptr<IVideoEncoder>>::Err(result.Code(),
+                                                         result.Message());
+    }
+    return Result<std::unique_ptr<IVideoEncoder>>::Ok(std::move(tiled));
+  }
+
   if (config.encoder_type == EncoderType::kHardware) {
     // 创建硬件编码器
     auto hw_encoder = std::make_unique<HardwareEncoder>();
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "../../../common/error.h"
+#include "../../capture/screen_capturer.h"
 #include "../ffmpeg_types.h"
 #include "hw_encoder_type.h"
 
@@ -28,6 +29,9 @@ enum class RateControlMode {
   kVBR,  ///< 可变码率
   kCRF,  ///< 恒定质量因子（仅软件编码）
   kCQP,  ///< 恒定量化参数
+  /// 低延迟：码率上限等于目标码率，VBV 约一帧；单帧大小受
+  /// EncoderConfig::latency_budget_ms 限制（见 frame_size_limiter.h）
+  kLowLatency,
 };
 
 /// @brief 编码预设（速度与质量权衡）
@@ -71,6 +75,8 @@ struct EncoderConfig {
   int max_bitrate = 12000000;  ///< 最大码率（bps）
   int crf = 23;                ///< CRF 值（0-51，越低质量越好）
   int qp = 23;                 ///< QP 值
+  /// kLowLatency：一帧以目标码率发送完毕的最长时间（毫秒）
+  int latency_budget_ms = 50;
 
   // 编码预设
   EncoderPreset preset = EncoderPreset::kLowLatency;
@@ -82,6 +88,44 @@ struct EncoderConfig {
   int gop_size = 120;    ///< 关键帧间隔
   int max_b_frames = 0;  ///< B帧数量（远程桌面通常为0）
 
+  /**
+   * 时间层数：1、2（L1T2）、3（L1T3），见 temporal_layers.h
+   *
+   * 大于 1 时上层帧编码为不被参考（或只被上层参考）的帧，接收端带宽不足时
+   * 可由发送端逐层丢弃；gop_size 向上取整到层周期的整数倍。
+   */
+  int temporal_layers = 1;
+
+  /**
+   * 按脏区域设置 ROI（AV_FRAME_DATA_REGIONS_OF_INTEREST，见 roi_map.h）
+   *
+   * 变化区域的 QP 降低 roi_qp_delta 的绝对值，码率控制相应提高其余区域的
+   * QP，静止区域更多地编码为 skip 块。libx264/libx265（自动开启 AQ）、
+   * QSV 与 VAAPI 编码器读取 ROI，其他编码器忽略。
+   */
+  bool roi_encoding = false;
+  int roi_qp_delta = -6;
+
+  /**
+   * 分块编码的网格（见 tiled_encoder.h）
+   *
+   * 大于 1x1 时画面切分为 tile_columns x tile_rows 个分块，每块由独立的
+   * 编码器实例并行编码，没有变化的分块跳过（IVideoEncoder::
+   * SetChangedRegions()）；输出为 tiled_frame.h 的容器格式，接收端须用
+   * TiledVideoDecoder 解码。thread_count 为分块的并行度，每个分块编码器
+   * 单线程。要求零延迟（无 B 帧、单时间层）。
+   */
+  int tile_columns = 1;
+  int tile_rows = 1;
+
+  /**
+   * 每个条带的最大字节数，0 表示不限制（libx264 的 slice-max-size）
+   *
+   * 设为 RTP 负载大小（RTPSender::kDefaultMaxPayloadSize）时每个 NAL 恰好
+   * 装入一个 RTP 包，丢包只影响一个条带。其他编码器忽略。
+   */
+  int slice_max_size = 0;
+
   // 低延迟设置
   bool zero_latency = true;  ///< 零延迟模式（禁用 lookahead）
   int thread_count = 0;      ///< 线程数（0=自动）
@@ -101,6 +145,10 @@ struct EncodedPacket {
   int64_t dts = 0;            ///< 解码时间戳
   bool is_keyframe = false;   ///< 是否为关键帧
   int64_t duration = 0;       ///< 帧时长
+  uint8_t temporal_id = 0;    ///< 时间层（EncoderConfig::temporal_layers）
+  /// 帧的最后一部分；流式输出（IVideoEncoder::SetPartialOutputCallback()）
+  /// 的其余部分为假，此时 is_keyframe 只在最后一部分上表示整帧
+  bool end_of_frame = true;
 };
 
 /// @brief 编码统计信息
@@ -115,6 +163,9 @@ struct EncoderStats {
 /// @brief 视频编码器接口
 class IVideoEncoder {
  public:
+  /// @brief 流式输出的回调，part 在回调返回后不再使用（可以交换走其缓冲）
+  using PartialOutputCallback = std::function<void(EncodedPacket& part)>;
+
   virtual ~IVideoEncoder() = default;
 
   /// @brief 初始化编码器
@@ -139,6 +190,26 @@ class IVideoEncoder {
   /// @brief 强制生成关键帧
   virtual void ForceKeyFrame() = 0;
 
+  /// @brief 提示下一次 Encode() 的帧相对上一次变化的区域（编码帧坐标）
+  ///
+  /// 不调用时按整帧变化处理。分块编码器据此跳过没有变化的分块，
+  /// 其他编码器忽略。
+  virtual void SetChangedRegions(
+      const std::vector<media::capture::DirtyRect>& rects) {
+    (void)rects;
+  }
+
+  /// @brief 开启流式输出：帧中可以独立解码的部分编码完即交给 callback
+  ///
+  /// 此后 Encode() 返回前，除最后一部分外的各部分（end_of_frame 为假）依次
+  /// 经 callback 交出，调用串行但可能在编码器内部的线程；最后一部分仍由
+  /// Encode() 输出。打包发送因此可以与本帧其余部分的编码重叠。
+  /// @return 编码器不支持时返回 false，仍按整帧输出
+  virtual bool SetPartialOutputCallback(PartialOutputCallback callback) {
+    (void)callback;
+    return false;
+  }
+
   /// @brief 动态更新码率
   /// @param bitrate 新的目标码率（bps）
   /// @return 成功返回 true
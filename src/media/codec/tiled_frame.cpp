@@ -0,0 +1,262 @@
+#include "tiled_frame.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+
+constexpr uint8_t kTiledMagic[2] = {'Z', 'T'};
+constexpr uint8_t kTiledVersion = 2;
+constexpr size_t kTileCountOffset = 5;
+constexpr size_t kFrameFlagsOffset = 10;
+/// [magic:2][version:u8][columns:u8][rows:u8][tiles:u8][width/height:u16]
+/// [flags:u8]
+constexpr size_t kTiledHeaderSize = 11;
+/// [index:u8][flags:u8][left/top/width/height:u16][size:u32]
+constexpr size_t kTileHeaderSize = 14;
+constexpr uint8_t kTileFlagKeyframe = 0x01;
+constexpr uint8_t kFrameFlagPartial = 0x01;
+
+void WriteU16(std::vector<uint8_t>& out, int32_t value) {
+  out.push_back(static_cast<uint8_t>(value >> 8));
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+void WriteU32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+int32_t ReadU16(const uint8_t* data) {
+  return static_cast<int32_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t ReadU32(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) |
+         (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+/**
+ * @brief 一个方向上的分块步长
+ * @param[in,out] count 请求的分块数，返回实际的分块数
+ */
+int TileStep(int extent, int& count) {
+  const int max_count =
+      std::max((extent + kTileAlignment - 1) / kTileAlignment, 1);
+  count = std::min(count, max_count);
+  const int step = ((extent + count - 1) / count + kTileAlignment - 1) /
+                   kTileAlignment * kTileAlignment;
+  count = (extent + step - 1) / step;
+  return step;
+}
+
+bool Intersects(const DirtyRect& a, const DirtyRect& b) {
+  return a.left < b.right && b.left < a.right && a.top < b.bottom &&
+         b.top < a.bottom;
+}
+
+bool SameRect(const DirtyRect& a, const DirtyRect& b) {
+  return a.left == b.left && a.top == b.top && a.right == b.right &&
+         a.bottom == b.bottom;
+}
+
+/// 4:2:0 格式的平面布局：每个平面的字节/像素与色度下采样
+struct PlaneLayout {
+  int planes = 0;
+  int bytes_per_pixel[3] = {};
+  int shift[3] = {};
+};
+
+bool GetPlaneLayout(int format, PlaneLayout& layout) {
+  switch (format) {
+    case AV_PIX_FMT_NV12:
+      layout = {2, {1, 2, 0}, {0, 1, 0}};
+      return true;
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+      layout = {3, {1, 1, 1}, {0, 1, 1}};
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+TileLayout ComputeTileLayout(int width, int height, int columns, int rows) {
+  TileLayout layout;
+  if (width <= 0 || height <= 0) {
+    return layout;
+  }
+  layout.width = width;
+  layout.height = height;
+  layout.columns = std::clamp(columns, 1, kMaxTileColumns);
+  layout.rows = std::clamp(rows, 1, kMaxTileRows);
+  const int step_x = TileStep(width, layout.columns);
+  const int step_y = TileStep(height, layout.rows);
+  layout.tiles.reserve(static_cast<size_t>(layout.columns) * layout.rows);
+  for (int row = 0; row < layout.rows; ++row) {
+    for (int column = 0; column < layout.columns; ++column) {
+      layout.tiles.push_back({column * step_x, row * step_y,
+                              std::min((column + 1) * step_x, width),
+                              std::min((row + 1) * step_y, height)});
+    }
+  }
+  return layout;
+}
+
+void MarkDirtyTiles(const TileLayout& layout,
+                    const std::vector<DirtyRect>& rects,
+                    std::vector<bool>& dirty) {
+  if (dirty.size() < layout.TileCount()) {
+    dirty.resize(layout.TileCount(), false);
+  }
+  for (const auto& rect : rects) {
+    for (size_t i = 0; i < layout.TileCount(); ++i) {
+      if (!dirty[i] && Intersects(rect, layout.tiles[i])) {
+        dirty[i] = true;
+      }
+    }
+  }
+}
+
+void BeginTiledFrame(const TileLayout& layout,
+                     bool end_of_frame,
+                     std::vector<uint8_t>& out) {
+  out.clear();
+  out.insert(out.end(), std::begin(kTiledMagic), std::end(kTiledMagic));
+  out.push_back(kTiledVersion);
+  out.push_back(static_cast<uint8_t>(layout.columns));
+  out.push_back(static_cast<uint8_t>(layout.rows));
+  out.push_back(0);
+  WriteU16(out, layout.width);
+  WriteU16(out, layout.height);
+  out.push_back(end_of_frame ? 0 : kFrameFlagPartial);
+}
+
+Result<void> AppendTile(const TileLayout& layout,
+                        size_t index,
+                        bool keyframe,
+                        const uint8_t* data,
+                        size_t size,
+                        std::vector<uint8_t>& out) {
+  if (out.size() < kTiledHeaderSize || index >= layout.TileCount() ||
+      size > UINT32_MAX || (size > 0 && !data)) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid tile for tiled frame");
+  }
+  if (out[kTileCountOffset] == UINT8_MAX) {
+    return Result<void>::Err(ErrorCode::kBufferOverflow,
+                             "Too many tiles in tiled frame");
+  }
+  const DirtyRect& rect = layout.tiles[index];
+  out.push_back(static_cast<uint8_t>(index));
+  out.push_back(keyframe ? kTileFlagKeyframe : 0);
+  WriteU16(out, rect.left);
+  WriteU16(out, rect.top);
+  WriteU16(out, rect.Width());
+  WriteU16(out, rect.Height());
+  WriteU32(out, static_cast<uint32_t>(size));
+  if (size > 0) {
+    out.insert(out.end(), data, data + size);
+  }
+  ++out[kTileCountOffset];
+  return Result<void>::Ok();
+}
+
+bool IsTiledFrame(const uint8_t* data, size_t length) {
+  return data && length >= kTiledHeaderSize && data[0] == kTiledMagic[0] &&
+         data[1] == kTiledMagic[1];
+}
+
+Result<TiledFrame> ParseTiledFrame(const uint8_t* data, size_t length) {
+  if (!IsTiledFrame(data, length) || data[2] != kTiledVersion) {
+    return Result<TiledFrame>::Err(ErrorCode::kInvalidParameter,
+                                   "Not a tiled frame");
+  }
+  TiledFrame frame;
+  frame.end_of_frame = (data[kFrameFlagsOffset] & kFrameFlagPartial) == 0;
+  frame.layout =
+      ComputeTileLayout(ReadU16(data + 6), ReadU16(data + 8), data[3], data[4]);
+  if (frame.layout.TileCount() == 0 || frame.layout.columns != data[3] ||
+      frame.layout.rows != data[4]) {
+    return Result<TiledFrame>::Err(ErrorCode::kInvalidParameter,
+                                   "Invalid tile grid");
+  }
+
+  const size_t tiles = data[kTileCountOffset];
+  size_t offset = kTiledHeaderSize;
+  frame.tiles.reserve(tiles);
+  for (size_t i = 0; i < tiles; ++i) {
+    if (length - offset < kTileHeaderSize) {
+      return Result<TiledFrame>::Err(ErrorCode::kBufferUnderflow,
+                                     "Truncated tile header");
+    }
+    const uint8_t* header = data + offset;
+    TiledFrameTile tile;
+    tile.index = header[0];
+    tile.keyframe = (header[1] & kTileFlagKeyframe) != 0;
+    const int32_t left = ReadU16(header + 2);
+    const int32_t top = ReadU16(header + 4);
+    tile.rect = {left, top, left + ReadU16(header + 6),
+                 top + ReadU16(header + 8)};
+    tile.size = ReadU32(header + 10);
+    offset += kTileHeaderSize;
+    if (tile.index >= frame.layout.TileCount() ||
+        !SameRect(tile.rect, frame.layout.tiles[tile.index])) {
+      return Result<TiledFrame>::Err(ErrorCode::kInvalidParameter,
+                                     "Tile does not match the grid");
+    }
+    if (length - offset < tile.size) {
+      return Result<TiledFrame>::Err(ErrorCode::kBufferUnderflow,
+                                     "Truncated tile data");
+    }
+    tile.data = data + offset;
+    offset += tile.size;
+    frame.tiles.push_back(tile);
+  }
+  return Result<TiledFrame>::Ok(std::move(frame));
+}
+
+Result<void> CopyTileToFrame(const AVFrame* tile,
+                             AVFrame* frame,
+                             int x,
+                             int y) {
+  PlaneLayout layout;
+  if (!tile || !frame || tile->format != frame->format ||
+      !GetPlaneLayout(tile->format, layout)) {
+    return Result<void>::Err(ErrorCode::kUnsupportedPixelFormat,
+                             "Tile needs a software 4:2:0 frame");
+  }
+  if (x < 0 || y < 0 || x % 2 != 0 || y % 2 != 0 ||
+      x + tile->width > frame->width || y + tile->height > frame->height) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Tile outside frame");
+  }
+  for (int plane = 0; plane < layout.planes; ++plane) {
+    const int shift = layout.shift[plane];
+    const int bpp = layout.bytes_per_pixel[plane];
+    // 奇数宽高的分块：色度向上取整
+    const int rows = (tile->height + shift) >> shift;
+    const auto bytes =
+        static_cast<size_t>(((tile->width + shift) >> shift) * bpp);
+    uint8_t* to = frame->data[plane] +
+                  static_cast<ptrdiff_t>(y >> shift) * frame->linesize[plane] +
+                  (x >> shift) * bpp;
+    for (int row = 0; row < rows; ++row) {
+      std::memcpy(to + static_cast<ptrdiff_t>(row) * frame->linesize[plane],
+                  tile->data[plane] +
+                      static_cast<ptrdiff_t>(row) * tile->linesize[plane],
+                  bytes);
+    }
+  }
+  return Result<void>::Ok();
+}
+
+}  // namespace zenremote
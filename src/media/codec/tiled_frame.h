@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../common/error.h"
+#include "../capture/screen_capturer.h"
+#include "ffmpeg_types.h"
+
+namespace zenremote {
+
+/// 分块边界对齐到 H.264 宏块
+constexpr int kTileAlignment = 16;
+/// 每行、每列的最大分块数
+constexpr int kMaxTileColumns = 16;
+constexpr int kMaxTileRows = 16;
+
+/**
+ * @brief 分块编码的网格：按行优先排列的矩形，覆盖整帧且互不相交
+ *
+ * 除最后一列/行外，分块宽高相同且为 kTileAlignment 的整数倍（分块边界
+ * 与宏块边界重合，色度平面逐像素对应）；最后一列/行取剩余部分。
+ */
+struct TileLayout {
+  int columns = 1;
+  int rows = 1;
+  int width = 0;
+  int height = 0;
+  std::vector<media::capture::DirtyRect> tiles;
+
+  size_t TileCount() const { return tiles.size(); }
+};
+
+/**
+ * @brief 把 width x height 均分为 columns x rows 个分块
+ *
+ * 帧太小时减少行列数，使每个分块至少 kTileAlignment 宽高（最后一列/行
+ * 除外）；实际的行列数见返回值的 columns/rows。
+ */
+TileLayout ComputeTileLayout(int width, int height, int columns, int rows);
+
+/// @brief 在 dirty 中标记与 rects 相交的分块（dirty 按需扩展，已有标记保留）
+void MarkDirtyTiles(const TileLayout& layout,
+                    const std::vector<media::capture::DirtyRect>& rects,
+                    std::vector<bool>& dirty);
+
+/**
+ * @brief 分块帧的容器格式（一个输入帧对应一个或多个包）
+ *
+ *   [magic "ZT"][version:u8][columns:u8][rows:u8][tiles:u8]
+ *   [width:u16][height:u16][flags:u8]
+ *   每个分块：[index:u8][flags:u8][left/top/width/height:u16][size:u32]
+ *             [size 字节的分块码流]
+ *
+ * 多字节字段为大端序。头部 flags 的 bit0 表示本帧还有后续的包（流式输出
+ * 时各分块编码完即成包，见 IVideoEncoder::SetPartialOutputCallback()），
+ * 分块 flags 的 bit0 表示该分块是关键帧。没有变化的分块不出现，接收端
+ * 保留它上一次的内容；没有分块的包只有头部。Annex B 码流以 0x00 开头，
+ * 与 magic 不会混淆。
+ */
+struct TiledFrameTile {
+  size_t index = 0;
+  media::capture::DirtyRect rect{};
+  bool keyframe = false;
+  const uint8_t* data = nullptr;  ///< 指向被解析的缓冲
+  size_t size = 0;
+};
+
+struct TiledFrame {
+  TileLayout layout;
+  bool end_of_frame = true;  ///< 本帧的最后一个包
+  std::vector<TiledFrameTile> tiles;
+};
+
+/**
+ * @brief 写入只有头部的容器（out 被清空）
+ * @param end_of_frame 本帧的最后一个包；为假时接收端解码后等待后续的包
+ */
+void BeginTiledFrame(const TileLayout& layout,
+                     bool end_of_frame,
+                     std::vector<uint8_t>& out);
+
+/// @brief 追加一个分块的码流
+Result<void> AppendTile(const TileLayout& layout,
+                        size_t index,
+                        bool keyframe,
+                        const uint8_t* data,
+                        size_t size,
+                        std::vector<uint8_t>& out);
+
+/// @brief 数据以容器的 magic 开头
+bool IsTiledFrame(const uint8_t* data, size_t length);
+
+/**
+ * @brief 解析容器，校验分块坐标与头部的网格一致
+ *
+ * 返回的 TiledFrameTile::data 指向 data，在 data 释放前有效。
+ */
+Result<TiledFrame> ParseTiledFrame(const uint8_t* data, size_t length);
+
+/**
+ * @brief 把解码出的分块复制到整帧画面的 (x, y)
+ *
+ * 只支持内存中的 NV12、YUV420P、YUVJ420P 帧，两者格式相同，x、y 为偶数。
+ */
+Result<void> CopyTileToFrame(const AVFrame* tile, AVFrame* frame, int x, int y);
+
+}  // namespace zenremote
@@ -0,0 +1,224 @@
+#include "video_frame_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/log_manager.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace zenremote {
+
+namespace {
+
+#ifndef _WIN32
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+#endif
+
+size_t RoundUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+void* AlignedAlloc(size_t size, size_t alignment) {
+#ifdef _WIN32
+  return _aligned_malloc(size, alignment);
+#else
+  void* data = nullptr;
+  return posix_memalign(&data, alignment, size) == 0 ? data : nullptr;
+#endif
+}
+
+void FreeAligned(void* /*opaque*/, uint8_t* data) {
+#ifdef _WIN32
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
+#ifdef _WIN32
+void FreeLargePages(void* /*opaque*/, uint8_t* data) {
+  VirtualFree(data, 0, MEM_RELEASE);
+}
+#endif
+
+}  // namespace
+
+VideoFramePool::~VideoFramePool() {
+  Shutdown();
+}
+
+Result<void> VideoFramePool::Initialize(const VideoFramePoolConfig& config) {
+  if (pool_) {
+    return Result<void>::Err(ErrorCode::kAlreadyInitialized,
+                             "VideoFramePool already initialized");
+  }
+
+  if (config.width <= 0 || config.height <= 0) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid frame dimensions");
+  }
+
+  // 对齐须为 2 的幂，且不小于 SIMD 加载宽度
+  if (config.alignment <= 0 ||
+      (config.alignment & (config.alignment - 1)) != 0) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Alignment must be a power of two");
+  }
+
+  const int size = av_image_get_buffer_size(config.format, config.width,
+                                            config.height, config.alignment);
+  if (size <= 0) {
+    return Result<void>::Err(
+        ErrorCode::kInvalidParameter,
+        fmt::format("Unsupported pixel format for frame pool: {}",
+                    static_cast<int>(config.format)));
+  }
+
+  config_ = config;
+  buffer_size_ = static_cast<size_t>(size);
+  buffers_allocated_ = 0;
+  huge_page_buffers_ = 0;
+  frames_acquired_ = 0;
+
+  pool_ = av_buffer_pool_init2(buffer_size_, this, &AllocateBuffer, nullptr);
+  if (!pool_) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to create buffer pool");
+  }
+
+  ZENREMOTE_INFO("VideoFramePool initialized: {}x{} ({}), {} bytes/frame{}",
+                 config_.width, config_.height,
+                 av_get_pix_fmt_name(config_.format), buffer_size_,
+                 config_.huge_pages ? ", huge pages" : "");
+
+  return Result<void>::Ok();
+}
+
+void VideoFramePool::Shutdown() {
+  if (pool_) {
+    // 仍在使用的缓冲释放时由 FFmpeg 回收池本身
+    av_buffer_pool_uninit(&pool_);
+    pool_ = nullptr;
+    ZENREMOTE_DEBUG("VideoFramePool shutdown");
+  }
+}
+
+Result<void> VideoFramePool::Acquire(AVFrame* frame) {
+  if (!pool_) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "VideoFramePool not initialized");
+  }
+
+  if (!frame) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Null frame pointer");
+  }
+
+  av_frame_unref(frame);
+  AVBufferRef* buffer = av_buffer_pool_get(pool_);
+  if (!buffer) {
+    return Result<void>::Err(ErrorCode::kOutOfMemory,
+                             "Failed to get buffer from pool");
+  }
+
+  frame->buf[0] = buffer;
+  frame->format = static_cast<int>(config_.format);
+  frame->width = config_.width;
+  frame->height = config_.height;
+  int ret = av_image_fill_arrays(frame->data, frame->linesize, buffer->data,
+                                 config_.format, config_.width,
+                                 config_.height, config_.alignment);
+  if (ret < 0) {
+    av_frame_unref(frame);
+    return Result<void>::Err(ErrorCode::kCodecError,
+                             "av_image_fill_arrays failed");
+  }
+
+  frames_acquired_.fetch_add(1, std::memory_order_relaxed);
+  return Result<void>::Ok();
+}
+
+Result<AVFramePtr> VideoFramePool::Acquire() {
+  AVFramePtr frame = MakeAVFrame();
+  if (!frame) {
+    return Result<AVFramePtr>::Err(ErrorCode::kOutOfMemory,
+                                   "Failed to allocate frame");
+  }
+
+  auto result = Acquire(frame.get());
+  if (result.IsErr()) {
+    return Result<AVFramePtr>::Err(result.Code(), result.Message());
+  }
+
+  return Result<AVFramePtr>::Ok(std::move(frame));
+}
+
+VideoFramePool::Stats VideoFramePool::GetStats() const {
+  Stats stats;
+  stats.buffer_size = buffer_size_;
+  stats.buffers_allocated = buffers_allocated_.load(std::memory_order_relaxed);
+  stats.huge_page_buffers = huge_page_buffers_.load(std::memory_order_relaxed);
+  stats.frames_acquired = frames_acquired_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+AVBufferRef* VideoFramePool::AllocateBuffer(void* opaque, size_t size) {
+  auto* self = static_cast<VideoFramePool*>(opaque);
+  const size_t alignment =
+      std::max<size_t>(static_cast<size_t>(self->config_.alignment), 64);
+  uint8_t* data = nullptr;
+  void (*free_buffer)(void*, uint8_t*) = FreeAligned;
+  bool huge_pages = false;
+
+  if (self->config_.huge_pages) {
+#ifdef _WIN32
+    const size_t large_page = GetLargePageMinimum();
+    if (large_page > 0) {
+      data = static_cast<uint8_t*>(VirtualAlloc(
+          nullptr, RoundUp(size, large_page),
+          MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+      if (data) {
+        free_buffer = FreeLargePages;
+        huge_pages = true;
+      }
+    }
+#else
+    // 按大页对齐并取整，内核才能整页映射
+    const size_t rounded = RoundUp(size, kHugePageSize);
+    data = static_cast<uint8_t*>(AlignedAlloc(rounded, kHugePageSize));
+#ifdef MADV_HUGEPAGE
+    huge_pages = data && madvise(data, rounded, MADV_HUGEPAGE) == 0;
+#endif
+#endif
+  }
+  if (!data) {
+    data = static_cast<uint8_t*>(AlignedAlloc(size, alignment));
+  }
+  if (!data) {
+    return nullptr;
+  }
+
+  // 预先触碰所有页面，缺页只在扩容时发生一次
+  std::memset(data, 0, size);
+
+  AVBufferRef* buffer = av_buffer_create(data, size, free_buffer, nullptr, 0);
+  if (!buffer) {
+    free_buffer(nullptr, data);
+    return nullptr;
+  }
+
+  self->buffers_allocated_.fetch_add(1, std::memory_order_relaxed);
+  if (huge_pages) {
+    self->huge_page_buffers_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return buffer;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "../../common/error.h"
+#include "ffmpeg_types.h"
+
+namespace zenremote {
+
+/// @brief 视频帧池配置
+struct VideoFramePoolConfig {
+  int width = 0;
+  int height = 0;
+  AVPixelFormat format = AV_PIX_FMT_NV12;  ///< 软件像素格式（NV12、YUV420P 等）
+  int alignment = 64;  ///< 行宽与缓冲起始地址的对齐字节数
+
+  /// 使用大页：Linux 为透明大页（madvise），Windows 为 large page（需要
+  /// SeLockMemoryPrivilege，不可用时退回普通页）
+  bool huge_pages = false;
+};
+
+/// @brief 固定尺寸与格式的 AVFrame 缓冲池
+///
+/// 基于 AVBufferPool：每帧的所有平面放在一块缓冲中，帧的最后一个引用释放
+/// 时缓冲回到池里而不是归还给分配器。稳态下同时在用的帧数不变，
+/// 不再有大块分配，也不会因为重新映射内存产生缺页。
+/// 新缓冲在分配时预先写零，缺页只发生在池扩容时。
+///
+/// 从池中取出的帧与 av_frame_get_buffer() 分配的帧用法相同，可以
+/// av_frame_ref()、交给编码器或放进队列；池关闭后仍在使用的帧保持有效。
+///
+/// 线程安全：Acquire() 与帧的释放可在任意线程进行；Initialize/Shutdown
+/// 在同一线程调用。
+class VideoFramePool {
+ public:
+  struct Stats {
+    size_t buffer_size = 0;          ///< 每帧缓冲字节数
+    uint64_t buffers_allocated = 0;  ///< 向分配器申请的缓冲数
+    uint64_t huge_page_buffers = 0;  ///< 其中使用大页的缓冲数
+    uint64_t frames_acquired = 0;
+  };
+
+  VideoFramePool() = default;
+  ~VideoFramePool();
+
+  // 分配回调持有 this，禁止拷贝和移动
+  VideoFramePool(const VideoFramePool&) = delete;
+  VideoFramePool& operator=(const VideoFramePool&) = delete;
+
+  /// @brief 初始化帧池
+  /// @param config 帧池配置
+  /// @return 成功返回 Ok，失败返回错误
+  Result<void> Initialize(const VideoFramePoolConfig& config);
+
+  /// @brief 关闭帧池，仍在使用的帧在最后一个引用释放时回收
+  void Shutdown();
+
+  /// @brief 取一帧到 frame（原有引用先释放）
+  /// @param frame 已分配的 AVFrame 结构
+  /// @return 成功返回 Ok
+  Result<void> Acquire(AVFrame* frame);
+
+  /// @brief 取一帧（分配新的 AVFrame 结构）
+  /// @return 帧或错误
+  Result<AVFramePtr> Acquire();
+
+  /// @brief 检查是否已初始化
+  bool IsInitialized() const { return pool_ != nullptr; }
+
+  int GetWidth() const { return config_.width; }
+  int GetHeight() const { return config_.height; }
+  AVPixelFormat GetFormat() const { return config_.format; }
+
+  Stats GetStats() const;
+
+ private:
+  /// AVBufferPool 的分配回调，opaque 为 this
+  static AVBufferRef* AllocateBuffer(void* opaque, size_t size);
+
+  AVBufferPool* pool_ = nullptr;
+  VideoFramePoolConfig config_;
+  size_t buffer_size_ = 0;
+
+  std::atomic<uint64_t> buffers_allocated_{0};
+  std::atomic<uint64_t> huge_page_buffers_{0};
+  std::atomic<uint64_t> frames_acquired_{0};
+};
+
+}  // namespace zenremote
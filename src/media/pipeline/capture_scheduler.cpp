@@ -0,0 +1,93 @@
+#include "media/pipeline/capture_scheduler.h"
+
+#include <algorithm>
+
+namespace zenremote {
+
+namespace {
+
+constexpr std::chrono::seconds kFpsWindow{1};
+
+}  // namespace
+
+CaptureScheduler::CaptureScheduler(const CaptureSchedulerConfig& config)
+    : config_(config),
+      frame_interval_(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::microseconds(1000000 / std::max(config.framerate, 1)))),
+      interval_(frame_interval_) {
+  Reset(Clock::now());
+}
+
+void CaptureScheduler::Reset(Clock::time_point now) {
+  interval_ = frame_interval_;
+  next_capture_ = now;
+  last_forwarded_ = now;
+  fps_window_start_ = now;
+  fps_window_frames_ = 0;
+  effective_fps_ = 0.0;
+}
+
+CaptureScheduler::Decision CaptureScheduler::OnFrame(bool has_damage,
+                                                     Clock::time_point now) {
+  Decision decision = Decision::kForward;
+  if (has_damage || !config_.skip_static_frames) {
+    interval_ = frame_interval_;
+  } else {
+    Backoff();
+    const bool keepalive =
+        config_.keepalive_interval.count() > 0 &&
+        now - last_forwarded_ >= config_.keepalive_interval;
+    decision = keepalive ? Decision::kKeepAlive : Decision::kSkip;
+  }
+
+  if (decision != Decision::kSkip) {
+    CountForwarded(now);
+  }
+  UpdateFps(now);
+  Schedule(now);
+  return decision;
+}
+
+void CaptureScheduler::OnNoFrame(Clock::time_point now) {
+  if (config_.skip_static_frames) {
+    Backoff();
+  }
+  UpdateFps(now);
+  Schedule(now);
+}
+
+void CaptureScheduler::OnActivity(Clock::time_point now) {
+  interval_ = frame_interval_;
+  next_capture_ = std::min(next_capture_, now);
+}
+
+void CaptureScheduler::Schedule(Clock::time_point now) {
+  // 落后时不补采，从当前时刻重新计时
+  next_capture_ = std::max(next_capture_ + interval_, now);
+}
+
+void CaptureScheduler::Backoff() {
+  const auto idle =
+      std::chrono::duration_cast<Clock::duration>(config_.idle_interval);
+  if (idle > interval_) {
+    interval_ = std::min(interval_ * 2, idle);
+  }
+}
+
+void CaptureScheduler::CountForwarded(Clock::time_point now) {
+  last_forwarded_ = now;
+  ++fps_window_frames_;
+}
+
+void CaptureScheduler::UpdateFps(Clock::time_point now) {
+  const auto elapsed = now - fps_window_start_;
+  if (elapsed < kFpsWindow) {
+    return;
+  }
+  effective_fps_ = static_cast<double>(fps_window_frames_) /
+                   std::chrono::duration<double>(elapsed).count();
+  fps_window_start_ = now;
+  fps_window_frames_ = 0;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace zenremote {
+
+/// @brief 采集调度配置
+struct CaptureSchedulerConfig {
+  int framerate = 30;  ///< 有画面变化时的采集帧率
+
+  /// 没有脏区域和移动区域的帧不转换、不编码
+  bool skip_static_frames = true;
+
+  /// 画面静止时采集间隔逐次加倍，最长为此值；不大于帧间隔时不退避
+  std::chrono::milliseconds idle_interval{100};
+
+  /// 静止期间每隔此时间仍送出一帧（内容不变，编码后只有几十字节），
+  /// 让接收端确认连接存活、并修复最后一帧的丢包；0 表示不发送
+  std::chrono::milliseconds keepalive_interval{1000};
+};
+
+/**
+ * @brief 按画面变化调度屏幕采集
+ *
+ * 桌面静止时采集器仍按帧率返回帧，但没有脏区域：这些帧跳过转换和编码，
+ * 采集间隔逐次加倍到 idle_interval。出现变化的帧立即恢复全帧率；
+ * OnActivity()（如收到远端输入）在变化出现之前就恢复，使第一帧变化不必
+ * 等待退避后的间隔。
+ *
+ * 只在采集线程使用，不是线程安全的。
+ */
+class CaptureScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Decision {
+    kForward,    ///< 有变化，转换并编码
+    kKeepAlive,  ///< 静止，但到了保活时间，送出内容不变的一帧
+    kSkip,       ///< 静止，丢弃
+  };
+
+  explicit CaptureScheduler(const CaptureSchedulerConfig& config = {});
+
+  /// @brief 重新开始调度，立即采集下一帧
+  void Reset(Clock::time_point now);
+
+  /// @brief 下一次采集的时刻
+  Clock::time_point GetNextCaptureTime() const { return next_capture_; }
+
+  /// @brief 当前采集间隔（静止时大于帧间隔）
+  Clock::duration GetInterval() const { return interval_; }
+
+  /**
+   * @brief 采集到一帧后调用，决定如何处理并安排下一次采集
+   * @param has_damage 帧有脏区域/移动区域，或需要整帧（关键帧、出错后）
+   */
+  Decision OnFrame(bool has_damage, Clock::time_point now);
+
+  /// @brief 采集器没有返回帧（超时或出错），按静止处理
+  void OnNoFrame(Clock::time_point now);
+
+  /// @brief 可能即将出现画面变化，恢复全帧率并立即采集
+  void OnActivity(Clock::time_point now);
+
+  /// @brief 最近约一秒内送出（含保活）的帧率
+  double GetEffectiveFps() const { return effective_fps_; }
+
+ private:
+  void Schedule(Clock::time_point now);
+  void Backoff();
+  void CountForwarded(Clock::time_point now);
+  void UpdateFps(Clock::time_point now);
+
+  CaptureSchedulerConfig config_;
+  Clock::duration frame_interval_;
+  Clock::duration interval_;
+  Clock::time_point next_capture_;
+  Clock::time_point last_forwarded_;
+
+  Clock::time_point fps_window_start_;
+  uint32_t fps_window_frames_ = 0;
+  double effective_fps_ = 0.0;
+};
+
+}  // namespace zenremote
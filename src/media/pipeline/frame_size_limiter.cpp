@@ -0,0 +1,71 @@
+#include "media/pipeline/frame_size_limiter.h"
+
+#include <algorithm>
+
+namespace zenremote {
+
+size_t FrameSizeLimiter::ComputeFrameCap(
+    int bitrate,
+    int framerate,
+    std::chrono::milliseconds latency_budget) {
+  const int64_t bytes_per_second = std::max(bitrate, 1) / 8;
+  const int64_t budget_bytes = bytes_per_second * latency_budget.count() / 1000;
+  const int64_t frame_bytes = bytes_per_second / std::max(framerate, 1);
+  return static_cast<size_t>(std::max<int64_t>({budget_bytes, frame_bytes, 1}));
+}
+
+FrameSizeLimiter::FrameSizeLimiter(const FrameSizeLimiterConfig& config)
+    : config_(config) {
+  SetBitrate(config.bitrate);
+  Reset(Clock::now());
+}
+
+void FrameSizeLimiter::Reset(Clock::time_point now) {
+  backlog_bytes_ = 0.0;
+  last_drain_ = now;
+  stats_ = Stats{};
+}
+
+void FrameSizeLimiter::SetBitrate(int bitrate) {
+  config_.bitrate = std::max(bitrate, 1);
+  frame_cap_ = ComputeFrameCap(config_.bitrate, config_.framerate,
+                               config_.latency_budget);
+  average_frame_bytes_ = static_cast<size_t>(config_.bitrate / 8 /
+                                             std::max(config_.framerate, 1));
+}
+
+void FrameSizeLimiter::Drain(Clock::time_point now) {
+  if (now <= last_drain_) {
+    return;
+  }
+  const double seconds =
+      std::chrono::duration<double>(now - last_drain_).count();
+  backlog_bytes_ =
+      std::max(backlog_bytes_ - seconds * config_.bitrate / 8.0, 0.0);
+  last_drain_ = now;
+}
+
+bool FrameSizeLimiter::ShouldDrop(Clock::time_point now) {
+  Drain(now);
+  // 下一帧按平均大小估计，它发送完毕的时刻不能超出预算
+  if (backlog_bytes_ + static_cast<double>(average_frame_bytes_) <=
+      static_cast<double>(frame_cap_)) {
+    return false;
+  }
+  ++stats_.frames_dropped;
+  return true;
+}
+
+bool FrameSizeLimiter::OnFrameEncoded(size_t bytes, Clock::time_point now) {
+  Drain(now);
+  backlog_bytes_ += static_cast<double>(bytes);
+  ++stats_.frames;
+  stats_.max_frame_bytes = std::max(stats_.max_frame_bytes, bytes);
+  if (bytes <= frame_cap_) {
+    return false;
+  }
+  ++stats_.frames_over_cap;
+  return true;
+}
+
+}  // namespace zenremote
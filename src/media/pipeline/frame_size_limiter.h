@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace zenremote {
+
+/// @brief 单帧大小限制配置（RateControlMode::kLowLatency）
+struct FrameSizeLimiterConfig {
+  int bitrate = 8000000;  ///< 当前带宽估计（bps）
+  int framerate = 60;
+
+  /// 一帧编码完成到发送完毕的最长时间，帧大小上限 = 码率 × 预算；
+  /// 不小于两个帧间隔，否则正常大小的帧也会触发跳帧
+  std::chrono::milliseconds latency_budget{50};
+};
+
+/**
+ * @brief 低延迟码率控制的单帧大小上限与跳帧
+ *
+ * 编码器的 VBV 只有约一帧，通常已把每帧限制在上限以内；场景切换（如
+ * 切换窗口）时仍可能输出数倍于平均大小的帧，以链路速率要发送多个帧
+ * 间隔。这样的帧已是后续帧的参考，丢弃它只能换来更大的关键帧，因此
+ * 照常发送；同时按链路速率模拟发送积压（漏桶），积压加上一帧平均大小
+ * 超过上限时 ShouldDrop() 返回真，在超出部分排空之前不再编码新帧。
+ * 之后每帧的发送排队时间因此不超过预算，延迟尖峰只持续到超出部分
+ * 发送完毕，而不会随后续帧的累积延长。
+ *
+ * 只在编码线程使用，不是线程安全的。
+ */
+class FrameSizeLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Stats {
+    uint64_t frames = 0;           ///< 编码输出的帧
+    uint64_t frames_over_cap = 0;  ///< 超过上限的帧
+    uint64_t frames_dropped = 0;   ///< 为排空积压而跳过的帧
+    size_t max_frame_bytes = 0;
+
+    /// @brief 超过上限的帧占编码输出的比例
+    double CapHitRate() const {
+      return frames > 0 ? static_cast<double>(frames_over_cap) /
+                              static_cast<double>(frames)
+                        : 0.0;
+    }
+  };
+
+  /// @brief 码率在预算内可发送的字节数，至少一帧的平均大小
+  static size_t ComputeFrameCap(int bitrate,
+                                int framerate,
+                                std::chrono::milliseconds latency_budget);
+
+  explicit FrameSizeLimiter(const FrameSizeLimiterConfig& config = {});
+
+  /// @brief 清空积压与统计
+  void Reset(Clock::time_point now);
+
+  /// @brief 带宽估计变化，上限随之调整
+  void SetBitrate(int bitrate);
+
+  /// @brief 单帧大小上限（字节）
+  size_t GetFrameCap() const { return frame_cap_; }
+
+  /// @brief 上一次调用时尚未以链路速率发送完的字节数
+  size_t GetBacklog() const { return static_cast<size_t>(backlog_bytes_); }
+
+  /**
+   * @brief 编码下一帧之前调用
+   * @return 积压太多，本帧应跳过（计入 frames_dropped）
+   */
+  bool ShouldDrop(Clock::time_point now);
+
+  /**
+   * @brief 记录编码输出的一帧（含流式输出的各部分）
+   * @return 超过上限
+   */
+  bool OnFrameEncoded(size_t bytes, Clock::time_point now);
+
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  void Drain(Clock::time_point now);
+
+  FrameSizeLimiterConfig config_;
+  size_t frame_cap_ = 0;
+  size_t average_frame_bytes_ = 0;
+  double backlog_bytes_ = 0.0;
+  Clock::time_point last_drain_;
+  Stats stats_;
+};
+
+}  // namespace zenremote
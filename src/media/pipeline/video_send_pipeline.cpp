@@ -0,0 +1,732 @@
+#include "media/pipeline/video_send_pipeline.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "common/log_manager.h"
+#include "media/codec/encoder/roi_map.h"
+
+namespace zenremote {
+
+namespace {
+
+/// 没有输入或输出槽位时的最长等待，通知丢失时也能继续
+constexpr std::chrono::milliseconds kIdleWait{100};
+
+double ToMicros(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+AVPixelFormat ToAVPixelFormat(media::capture::PixelFormat format) {
+  return format == media::capture::PixelFormat::RGBA32 ? AV_PIX_FMT_RGBA
+                                                       : AV_PIX_FMT_BGRA;
+}
+
+/// 采集坐标的区域换算为编码帧坐标；缩放时外扩 2 像素，覆盖插值的邻域
+void ScaleChangedRects(const std::vector<media::capture::DirtyRect>& rects,
+                       int src_width,
+                       int src_height,
+                       int dst_width,
+                       int dst_height,
+                       std::vector<media::capture::DirtyRect>& out) {
+  const bool scaled = src_width != dst_width || src_height != dst_height;
+  const int64_t margin = scaled ? 2 : 0;
+  for (const auto& rect : rects) {
+    const int64_t left =
+        static_cast<int64_t>(rect.left) * dst_width / src_width - margin;
+    const int64_t top =
+        static_cast<int64_t>(rect.top) * dst_height / src_height - margin;
+    const int64_t right =
+        (static_cast<int64_t>(rect.right) * dst_width + src_width - 1) /
+            src_width +
+        margin;
+    const int64_t bottom =
+        (static_cast<int64_t>(rect.bottom) * dst_height + src_height - 1) /
+            src_height +
+        margin;
+    const media::capture::DirtyRect clipped{
+        static_cast<int32_t>(std::max<int64_t>(left, 0)),
+        static_cast<int32_t>(std::max<int64_t>(top, 0)),
+        static_cast<int32_t>(std::min<int64_t>(right, dst_width)),
+        static_cast<int32_t>(std::min<int64_t>(bottom, dst_height))};
+    if (clipped.Width() > 0 && clipped.Height() > 0) {
+      out.push_back(clipped);
+    }
+  }
+}
+
+}  // namespace
+
+void VideoSendPipeline::Signal::Notify() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notified_ = true;
+  }
+  cv_.notify_one();
+}
+
+void VideoSendPipeline::Signal::Wait(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait_for(lock, timeout, [this]() { return notified_; });
+  notified_ = false;
+}
+
+void VideoSendPipeline::Signal::WaitUntil(Clock::time_point deadline) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait_until(lock, deadline, [this]() { return notified_; });
+  notified_ = false;
+}
+
+VideoSendPipeline::VideoSendPipeline() : VideoSendPipeline(Config{}) {}
+
+VideoSendPipeline::VideoSendPipeline(const Config& config) : config_(config) {
+  config_.frame_queue_depth = std::max<size_t>(config_.frame_queue_depth, 1);
+  config_.packet_queue_depth = std::max<size_t>(config_.packet_queue_depth, 1);
+}
+
+VideoSendPipeline::~VideoSendPipeline() {
+  Stop();
+}
+
+Result<void> VideoSendPipeline::Start(Stages stages) {
+  if (running_) {
+    return Result<void>::Err(ErrorCode::kAlreadyRunning,
+                             "VideoSendPipeline already running");
+  }
+  if (!stages.capturer || !stages.converter || !stages.encoder ||
+      !stages.sink) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Capturer, converter, encoder and sink are "
+                             "required");
+  }
+  if (config_.encoder.width <= 0 || config_.encoder.height <= 0 ||
+      config_.encoder.framerate <= 0) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid encoder size or framerate");
+  }
+
+  capturer_ = stages.capturer;
+  converter_ = std::move(stages.converter);
+  encoder_ = std::move(stages.encoder);
+  sink_ = std::move(stages.sink);
+  // 消费者处理期间占用一个槽位，另加一个
+  raw_queue_ =
+      std::make_unique<SpscQueue<RawFrame>>(config_.frame_queue_depth + 1);
+  converted_queue_ = std::make_unique<SpscQueue<ConvertedFrame>>(
+      config_.frame_queue_depth + 1);
+  packet_queue_ =
+      std::make_unique<SpscQueue<PacketSlot>>(config_.packet_queue_depth + 1);
+  frames_submitted_ = 0;
+  pending_dirty_rects_.clear();
+  pending_full_frame_ = true;
+  capture_full_frame_ = true;
+  copy_rect_active_ = false;
+  tiled_ = config_.encoder.tile_columns * config_.encoder.tile_rows > 1;
+  encode_changed_rects_.clear();
+  encode_changed_full_frame_ = false;
+  latency_bounded_ =
+      config_.encoder.rate_control == RateControlMode::kLowLatency;
+  FrameSizeLimiterConfig limiter_config;
+  limiter_config.bitrate = config_.encoder.bitrate;
+  limiter_config.framerate = config_.encoder.framerate;
+  limiter_config.latency_budget =
+      std::chrono::milliseconds(config_.encoder.latency_budget_ms);
+  frame_limiter_ = FrameSizeLimiter(limiter_config);
+  streaming_ = false;
+  if (config_.slice_streaming) {
+    streaming_ = encoder_->SetPartialOutputCallback(
+        [this](EncodedPacket& part) { OnPartialOutput(part); });
+    if (!streaming_) {
+      ZENREMOTE_INFO("{} does not stream partial frames, sending whole frames",
+                     encoder_->GetEncoderName());
+    }
+  }
+  resync_ = false;
+  for (auto& sei : copy_rect_seis_) {
+    sei.clear();
+  }
+
+  should_stop_ = false;
+  running_ = true;
+  threads_[static_cast<size_t>(Stage::kCapture)] =
+      std::thread([this]() { RunCapture(); });
+  threads_[static_cast<size_t>(Stage::kConvert)] =
+      std::thread([this]() { RunConvert(); });
+  threads_[static_cast<size_t>(Stage::kEncode)] =
+      std::thread([this]() { RunEncode(); });
+  threads_[static_cast<size_t>(Stage::kPacketize)] =
+      std::thread([this]() { RunPacketize(); });
+
+  ZENREMOTE_INFO("VideoSendPipeline started: {}x{}@{} ({})",
+                 config_.encoder.width, config_.encoder.height,
+                 config_.encoder.framerate, encoder_->GetEncoderName());
+  return Result<void>::Ok();
+}
+
+void VideoSendPipeline::Stop() {
+  if (!running_) {
+    return;
+  }
+  should_stop_ = true;
+  NotifyAll();
+  for (auto& thread : threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  converter_->Shutdown();
+  converter_.reset();
+  encoder_.reset();
+  sink_ = nullptr;
+  capturer_ = nullptr;
+  raw_queue_.reset();
+  converted_queue_.reset();
+  packet_queue_.reset();
+  running_ = false;
+  ZENREMOTE_INFO("VideoSendPipeline stopped");
+}
+
+VideoSendPipeline::Stats VideoSendPipeline::GetStats() const {
+  Stats stats;
+  for (size_t i = 0; i < kStageCount; ++i) {
+    const StageCounters& counters = counters_[i];
+    StageStats& stage = stats.stages[i];
+    stage.processed = counters.processed.load(std::memory_order_relaxed);
+    stage.dropped = counters.dropped.load(std::memory_order_relaxed);
+    stage.errors = counters.errors.load(std::memory_order_relaxed);
+    stage.service = counters.service.GetSnapshot();
+    stage.queue_wait = counters.queue_wait.GetSnapshot();
+  }
+  stats.frames_coalesced = frames_coalesced_.load(std::memory_order_relaxed);
+  stats.frames_static = frames_static_.load(std::memory_order_relaxed);
+  stats.keepalive_frames = keepalive_frames_.load(std::memory_order_relaxed);
+  stats.roi_frames = roi_frames_.load(std::memory_order_relaxed);
+  stats.copy_rect_frames = copy_rect_frames_.load(std::memory_order_relaxed);
+  stats.partial_packets = partial_packets_.load(std::memory_order_relaxed);
+  stats.frames_over_cap = frames_over_cap_.load(std::memory_order_relaxed);
+  const uint64_t limited =
+      limited_frames_encoded_.load(std::memory_order_relaxed);
+  if (limited > 0) {
+    stats.cap_hit_rate = static_cast<double>(stats.frames_over_cap) /
+                         static_cast<double>(limited);
+  }
+  stats.frames_rate_limited =
+      frames_rate_limited_.load(std::memory_order_relaxed);
+  stats.effective_fps = effective_fps_.load(std::memory_order_relaxed);
+  // 丢弃的帧省去了复制缓冲及之后的全部阶段
+  double frame_cost_us = 0.0;
+  for (const StageStats& stage : stats.stages) {
+    frame_cost_us += stage.service.mean_us;
+  }
+  stats.cpu_saved_ms =
+      static_cast<double>(stats.frames_static) * frame_cost_us / 1000.0;
+  stats.glass_to_network = glass_to_network_.GetSnapshot();
+  return stats;
+}
+
+void VideoSendPipeline::ForceKeyFrame() {
+  if (config_.copy_rect) {
+    // 关键帧请求通常意味着接收端丢了帧，合成的画面不再可信：先整帧转换，
+    // 接收端随之直接显示解码帧
+    resync_ = true;
+  } else {
+    force_keyframe_ = true;
+  }
+}
+
+void VideoSendPipeline::NotifyActivity() {
+  activity_ = true;
+  signals_[static_cast<size_t>(Stage::kCapture)].Notify();
+}
+
+void VideoSendPipeline::NotifyAll() {
+  for (auto& signal : signals_) {
+    signal.Notify();
+  }
+}
+
+template <typename Slot>
+Slot* VideoSendPipeline::TakeLatest(SpscQueue<Slot>& queue,
+                                    Stage stage,
+                                    bool& keyframe) {
+  Slot* slot = queue.Front();
+  bool dropped = false;
+  while (slot && queue.Size() > 1 && CanDrop(*slot)) {
+    keyframe = keyframe || slot->is_keyframe;
+    OnFrameDropped(*slot);
+    queue.PopFront();
+    Counters(stage).dropped.fetch_add(1, std::memory_order_relaxed);
+    dropped = true;
+    slot = queue.Front();
+  }
+  if (dropped) {
+    // 上游可能在等待槽位
+    signals_[static_cast<size_t>(stage) - 1].Notify();
+  }
+  if (slot) {
+    keyframe = keyframe || slot->is_keyframe;
+  }
+  return slot;
+}
+
+void VideoSendPipeline::AppendFrameRects(const RawFrame& frame) {
+  if (copy_rect_active_) {
+    copy_rect_tracker_.AddFrame(frame.dirty_rects, frame.move_rects);
+    return;
+  }
+  pending_dirty_rects_.insert(pending_dirty_rects_.end(),
+                              frame.dirty_rects.begin(),
+                              frame.dirty_rects.end());
+  for (const auto& move : frame.move_rects) {
+    pending_dirty_rects_.push_back(move.destination);
+  }
+}
+
+void VideoSendPipeline::OnFrameDropped(const RawFrame& frame) {
+  pending_full_frame_ = pending_full_frame_ || frame.full_frame;
+  if (!pending_full_frame_) {
+    AppendFrameRects(frame);
+  }
+}
+
+void VideoSendPipeline::OnFrameDropped(ConvertedFrame& frame) {
+  av_frame_unref(frame.frame.get());
+  encode_changed_full_frame_ =
+      encode_changed_full_frame_ || frame.changed_full_frame;
+  if (!encode_changed_full_frame_) {
+    encode_changed_rects_.insert(encode_changed_rects_.end(),
+                                 frame.changed_rects.begin(),
+                                 frame.changed_rects.end());
+  }
+}
+
+void VideoSendPipeline::RunCapture() {
+  StageCounters& counters = Counters(Stage::kCapture);
+  Signal& signal = signals_[static_cast<size_t>(Stage::kCapture)];
+  CaptureSchedulerConfig scheduler_config;
+  scheduler_config.framerate = config_.encoder.framerate;
+  scheduler_config.skip_static_frames = config_.skip_static_frames;
+  scheduler_config.idle_interval = config_.idle_capture_interval;
+  scheduler_config.keepalive_interval = config_.keepalive_interval;
+  CaptureScheduler scheduler(scheduler_config);
+
+  while (!should_stop_) {
+    RawFrame* out = raw_queue_->PrepareWrite();
+    if (!out) {
+      // 下游跟不上：暂停采集，期间的屏幕变化由采集器合并到下一帧
+      signal.Wait(kIdleWait);
+      continue;
+    }
+    // 等到下一次采集时刻；输入活动提前唤醒
+    while (!should_stop_) {
+      if (activity_.exchange(false)) {
+        scheduler.OnActivity(Clock::now());
+      }
+      if (Clock::now() >= scheduler.GetNextCaptureTime()) {
+        break;
+      }
+      signal.WaitUntil(scheduler.GetNextCaptureTime());
+    }
+    if (should_stop_) {
+      break;
+    }
+
+    auto frame = capturer_->CaptureFrame();
+    if (!frame) {
+      scheduler.OnNoFrame(Clock::now());
+      effective_fps_.store(scheduler.GetEffectiveFps(),
+                           std::memory_order_relaxed);
+      continue;
+    }
+    const auto start = Clock::now();
+    frames_coalesced_.fetch_add(frame->metadata.accumulated_frames,
+                                std::memory_order_relaxed);
+    const bool has_damage = capture_full_frame_ ||
+                            frame->metadata.is_key_frame ||
+                            !frame->metadata.dirty_rects.empty() ||
+                            !frame->metadata.move_rects.empty();
+    const auto decision = scheduler.OnFrame(has_damage, start);
+    effective_fps_.store(scheduler.GetEffectiveFps(),
+                         std::memory_order_relaxed);
+    if (decision == CaptureScheduler::Decision::kSkip) {
+      // 静止画面：持久帧已是当前内容，不复制也不转换
+      capturer_->ReleaseFrame();
+      frames_static_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (decision == CaptureScheduler::Decision::kKeepAlive) {
+      keepalive_frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+    const size_t size = static_cast<size_t>(frame->stride) * frame->height;
+    if (!frame->data || frame->width <= 0 || frame->height <= 0 ||
+        frame->stride < frame->width * 4 || frame->size < size) {
+      capturer_->ReleaseFrame();
+      counters.errors.fetch_add(1, std::memory_order_relaxed);
+      // 这一帧的脏区域丢失
+      capture_full_frame_ = true;
+      continue;
+    }
+    // 采集器的缓冲在 ReleaseFrame() 后失效，复制到复用的槽位缓冲
+    out->pixels.resize(size);
+    std::memcpy(out->pixels.data(), frame->data, size);
+    out->width = frame->width;
+    out->height = frame->height;
+    out->stride = frame->stride;
+    out->format = frame->format;
+    out->is_keyframe = frame->metadata.is_key_frame;
+    // 分辨率变化时转换器重建，持久帧随之整帧转换
+    out->full_frame = capture_full_frame_ || frame->metadata.is_key_frame;
+    out->dirty_rects = frame->metadata.dirty_rects;
+    out->move_rects = frame->metadata.move_rects;
+    capture_full_frame_ = false;
+    out->capture_time = start;
+    capturer_->ReleaseFrame();
+
+    out->enqueue_time = Clock::now();
+    raw_queue_->CommitWrite();
+    signals_[static_cast<size_t>(Stage::kConvert)].Notify();
+    counters.processed.fetch_add(1, std::memory_order_relaxed);
+    counters.service.Record(ToMicros(out->enqueue_time - start));
+  }
+}
+
+Result<void> VideoSendPipeline::EnsureConverter(const RawFrame& frame) {
+  const AVPixelFormat src_format = ToAVPixelFormat(frame.format);
+  if (converter_->IsInitialized() &&
+      converter_->GetSrcWidth() == frame.width &&
+      converter_->GetSrcHeight() == frame.height &&
+      converter_->GetSrcFormat() == src_format) {
+    return Result<void>::Ok();
+  }
+  // 首帧或采集分辨率变化：输出尺寸不变，只重建转换器
+  converter_->Shutdown();
+  ColorConverterConfig converter_config;
+  converter_config.src_width = frame.width;
+  converter_config.src_height = frame.height;
+  converter_config.src_format = src_format;
+  converter_config.dst_width = config_.encoder.width;
+  converter_config.dst_height = config_.encoder.height;
+  converter_config.dst_format = config_.encoder.input_format;
+  converter_config.color_space = config_.encoder.color_space;
+  converter_config.color_range = config_.encoder.color_range;
+  converter_config.threads = config_.convert_threads;
+  converter_config.huge_pages = config_.huge_pages;
+  auto result = converter_->Initialize(converter_config);
+  // 新的持久帧需要整帧转换
+  pending_full_frame_ = true;
+  // 复制命令要求编码帧与采集帧逐像素对应，接收端按顺序合成每一帧
+  const AVCodecID codec = config_.encoder.codec_id;
+  const bool annex_b_codec =
+      codec == AV_CODEC_ID_H264 || codec == AV_CODEC_ID_HEVC;
+  copy_rect_active_ = result.IsOk() && config_.copy_rect &&
+                      converter_->UsesFastPath() && annex_b_codec &&
+                      config_.encoder.temporal_layers <= 1 && !tiled_ &&
+                      !streaming_;
+  return result;
+}
+
+void VideoSendPipeline::RunConvert() {
+  StageCounters& counters = Counters(Stage::kConvert);
+  Signal& signal = signals_[static_cast<size_t>(Stage::kConvert)];
+
+  while (!should_stop_) {
+    // 先取输出槽位，等待期间到达的帧在取输入时按最新帧优先丢弃
+    ConvertedFrame* out = converted_queue_->PrepareWrite();
+    if (!out) {
+      signal.Wait(kIdleWait);
+      continue;
+    }
+    bool keyframe = false;
+    RawFrame* in = TakeLatest(*raw_queue_, Stage::kConvert, keyframe);
+    if (!in) {
+      signal.Wait(kIdleWait);
+      continue;
+    }
+
+    const auto start = Clock::now();
+    counters.queue_wait.Record(ToMicros(start - in->enqueue_time));
+    if (resync_.exchange(false)) {
+      pending_full_frame_ = true;
+      keyframe = true;
+    }
+    auto result = EnsureConverter(*in);
+    if (result.IsOk() && !out->frame) {
+      out->frame = MakeAVFrame();
+      if (!out->frame) {
+        result = Result<void>::Err(ErrorCode::kOutOfMemory,
+                                   "Failed to allocate frame");
+      }
+    }
+    // 只转换自上次转换以来变化的区域（含被丢弃帧的）
+    const bool full_frame = pending_full_frame_ || in->full_frame;
+    if (!full_frame) {
+      AppendFrameRects(*in);
+    }
+    const auto& dirty_rects = copy_rect_active_
+                                  ? copy_rect_tracker_.GetResidualRects()
+                                  : pending_dirty_rects_;
+    if (result.IsOk()) {
+      result = converter_->ConvertIncremental(in->pixels.data(), in->stride,
+                                              dirty_rects, full_frame,
+                                              out->frame.get());
+    }
+    if (result.IsOk() && config_.encoder.roi_encoding) {
+      // 整帧变化或关键帧没有重点区域；编码阶段丢弃的帧的区域不会并入，
+      // 那些区域按帧 QP 编码
+      const bool whole_frame = full_frame || keyframe;
+      const auto roi_rects =
+          whole_frame ? std::vector<media::capture::DirtyRect>()
+                      : BuildRoiRects(dirty_rects, in->width,
+                                      in->height, config_.encoder.width,
+                                      config_.encoder.height);
+      result = AttachRegionsOfInterest(out->frame.get(), roi_rects,
+                                       config_.encoder.roi_qp_delta);
+      if (!roi_rects.empty()) {
+        roi_frames_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    out->copy_rect_sei.clear();
+    out->droppable = !copy_rect_active_;
+    if (result.IsOk() && copy_rect_active_) {
+      if (full_frame) {
+        copy_rect_tracker_.Reset(config_.encoder.width,
+                                 config_.encoder.height);
+      } else if (copy_rect_tracker_.TakeCommand(copy_rect_command_)) {
+        auto sei =
+            BuildCopyRectSei(copy_rect_command_, config_.encoder.codec_id);
+        if (sei.IsOk()) {
+          out->copy_rect_sei = std::move(sei.Value());
+          copy_rect_frames_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          result = Result<void>::Err(sei.Code(), sei.Message());
+        }
+      }
+    }
+    out->changed_rects.clear();
+    out->changed_full_frame = full_frame || !tiled_;
+    if (!out->changed_full_frame) {
+      ScaleChangedRects(dirty_rects, in->width, in->height,
+                        config_.encoder.width, config_.encoder.height,
+                        out->changed_rects);
+    }
+    pending_dirty_rects_.clear();
+    // 失败时持久帧可能缺少这些区域
+    pending_full_frame_ = result.IsErr();
+    out->is_keyframe = keyframe;
+    out->capture_time = in->capture_time;
+    raw_queue_->PopFront();
+    signals_[static_cast<size_t>(Stage::kCapture)].Notify();
+
+    if (result.IsErr()) {
+      counters.errors.fetch_add(1, std::memory_order_relaxed);
+      ZENREMOTE_DEBUG("Pipeline convert failed: {}", result.Message());
+      if (keyframe) {
+        force_keyframe_ = true;
+      }
+      continue;
+    }
+    out->enqueue_time = Clock::now();
+    converted_queue_->CommitWrite();
+    signals_[static_cast<size_t>(Stage::kEncode)].Notify();
+    counters.processed.fetch_add(1, std::memory_order_relaxed);
+    counters.service.Record(ToMicros(out->enqueue_time - start));
+  }
+}
+
+void VideoSendPipeline::ApplyEncoderControls() {
+  const int bitrate = pending_bitrate_.exchange(0);
+  if (bitrate > 0) {
+    auto result = encoder_->UpdateBitrate(bitrate);
+    if (result.IsErr()) {
+      ZENREMOTE_WARN("Pipeline bitrate update failed: {}", result.Message());
+    }
+    frame_limiter_.SetBitrate(bitrate);
+  }
+}
+
+VideoSendPipeline::PacketSlot* VideoSendPipeline::WaitForPacketSlot() {
+  Signal& signal = signals_[static_cast<size_t>(Stage::kEncode)];
+  PacketSlot* slot = packet_queue_->PrepareWrite();
+  while (!slot && !should_stop_) {
+    signal.Wait(kIdleWait);
+    slot = packet_queue_->PrepareWrite();
+  }
+  return slot;
+}
+
+void VideoSendPipeline::OnPartialOutput(EncodedPacket& part) {
+  // 编码线程此时阻塞在 Encode() 中，回调串行调用，打包队列仍只有一个
+  // 生产者
+  PacketSlot* out = WaitForPacketSlot();
+  if (!out) {
+    return;
+  }
+  partial_bytes_ += part.data.size();
+  std::swap(out->packet, part);
+  out->capture_time = partial_capture_time_;
+  out->enqueue_time = Clock::now();
+  packet_queue_->CommitWrite();
+  partial_packets_.fetch_add(1, std::memory_order_relaxed);
+  signals_[static_cast<size_t>(Stage::kPacketize)].Notify();
+}
+
+void VideoSendPipeline::RunEncode() {
+  StageCounters& counters = Counters(Stage::kEncode);
+  Signal& signal = signals_[static_cast<size_t>(Stage::kEncode)];
+
+  while (!should_stop_) {
+    // 编码后的包不能丢弃，打包队列满时等待
+    PacketSlot* out = packet_queue_->PrepareWrite();
+    if (!out) {
+      signal.Wait(kIdleWait);
+      continue;
+    }
+    bool keyframe = false;
+    ConvertedFrame* in =
+        TakeLatest(*converted_queue_, Stage::kEncode, keyframe);
+    if (!in) {
+      signal.Wait(kIdleWait);
+      continue;
+    }
+
+    const auto start = Clock::now();
+    counters.queue_wait.Record(ToMicros(start - in->enqueue_time));
+    ApplyEncoderControls();
+    if (latency_bounded_ && in->droppable && frame_limiter_.ShouldDrop(start)) {
+      // 链路还在发送超过上限的帧：本帧不编码，关键帧请求与变化区域转移到
+      // 下一帧
+      if (keyframe) {
+        force_keyframe_ = true;
+      }
+      OnFrameDropped(*in);
+      converted_queue_->PopFront();
+      signals_[static_cast<size_t>(Stage::kConvert)].Notify();
+      frames_rate_limited_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    if (force_keyframe_.exchange(false) || keyframe) {
+      encoder_->ForceKeyFrame();
+    }
+    const int64_t frame_index = frames_submitted_++;
+    capture_times_[frame_index % kCaptureTimeHistory] = in->capture_time;
+    std::vector<uint8_t>& submitted_sei =
+        copy_rect_seis_[frame_index % kCaptureTimeHistory];
+    submitted_sei.swap(in->copy_rect_sei);
+    in->copy_rect_sei.clear();
+    if (tiled_) {
+      // 被丢弃帧变化过的分块在本帧一起编码
+      encode_changed_full_frame_ =
+          encode_changed_full_frame_ || in->changed_full_frame;
+      if (!encode_changed_full_frame_) {
+        encode_changed_rects_.insert(encode_changed_rects_.end(),
+                                     in->changed_rects.begin(),
+                                     in->changed_rects.end());
+        encoder_->SetChangedRegions(encode_changed_rects_);
+      }
+      encode_changed_rects_.clear();
+      encode_changed_full_frame_ = false;
+    }
+    // 流式输出的各部分由回调写入打包队列，最后一部分之后再取槽位
+    partial_capture_time_ = in->capture_time;
+    partial_bytes_ = 0;
+    auto encoded = encoder_->Encode(in->frame.get(),
+                                    streaming_ ? frame_packet_ : out->packet);
+    // 释放对持久帧的引用，转换阶段可以就地更新而不必复制
+    av_frame_unref(in->frame.get());
+    const auto fallback_capture_time = in->capture_time;
+    converted_queue_->PopFront();
+    signals_[static_cast<size_t>(Stage::kConvert)].Notify();
+
+    if (encoded.IsErr()) {
+      counters.errors.fetch_add(1, std::memory_order_relaxed);
+      ZENREMOTE_DEBUG("Pipeline encode failed: {}", encoded.Message());
+      if (!submitted_sei.empty()) {
+        // 接收端收不到这条复制命令
+        submitted_sei.clear();
+        resync_ = true;
+      }
+      continue;
+    }
+    counters.processed.fetch_add(1, std::memory_order_relaxed);
+    counters.service.Record(ToMicros(Clock::now() - start));
+    if (!encoded.Value()) {
+      continue;
+    }
+    if (streaming_) {
+      out = WaitForPacketSlot();
+      if (!out) {
+        break;
+      }
+      std::swap(out->packet, frame_packet_);
+    }
+
+    // 编码器以输入帧序号作 pts；有重排（B 帧）时输出的不是刚输入的帧
+    const int64_t pts = out->packet.pts;
+    const bool known = pts >= 0 && pts < frames_submitted_ &&
+                       frames_submitted_ - pts <=
+                           static_cast<int64_t>(kCaptureTimeHistory);
+    out->capture_time = known ? capture_times_[pts % kCaptureTimeHistory]
+                              : fallback_capture_time;
+    if (known && !copy_rect_seis_[pts % kCaptureTimeHistory].empty()) {
+      std::vector<uint8_t>& sei = copy_rect_seis_[pts % kCaptureTimeHistory];
+      auto inserted =
+          InsertCopyRectSei(sei, config_.encoder.codec_id, out->packet.data);
+      sei.clear();
+      if (inserted.IsErr()) {
+        ZENREMOTE_WARN("Copy-rect command dropped: {}", inserted.Message());
+        resync_ = true;
+      }
+    }
+    if (latency_bounded_) {
+      const size_t bytes = partial_bytes_ + out->packet.data.size();
+      limited_frames_encoded_.fetch_add(1, std::memory_order_relaxed);
+      if (frame_limiter_.OnFrameEncoded(bytes, Clock::now())) {
+        frames_over_cap_.fetch_add(1, std::memory_order_relaxed);
+        ZENREMOTE_DEBUG("Frame of {} bytes exceeds the {} byte cap", bytes,
+                        frame_limiter_.GetFrameCap());
+      }
+    }
+    out->enqueue_time = Clock::now();
+    packet_queue_->CommitWrite();
+    signals_[static_cast<size_t>(Stage::kPacketize)].Notify();
+  }
+}
+
+void VideoSendPipeline::RunPacketize() {
+  StageCounters& counters = Counters(Stage::kPacketize);
+  Signal& signal = signals_[static_cast<size_t>(Stage::kPacketize)];
+
+  while (!should_stop_) {
+    PacketSlot* in = packet_queue_->Front();
+    if (!in) {
+      signal.Wait(kIdleWait);
+      continue;
+    }
+
+    const auto start = Clock::now();
+    counters.queue_wait.Record(ToMicros(start - in->enqueue_time));
+    // RTP 视频时钟 90kHz，取采集时刻而不是编码器的帧序号，丢帧不压缩时间轴
+    const auto capture_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            in->capture_time.time_since_epoch())
+            .count();
+    const auto timestamp_90khz = static_cast<uint32_t>(capture_us * 9 / 100);
+    auto sent = sink_(in->packet, timestamp_90khz);
+    const auto done = Clock::now();
+    if (sent.IsErr()) {
+      counters.errors.fetch_add(1, std::memory_order_relaxed);
+      ZENREMOTE_DEBUG("Pipeline send failed: {}", sent.Message());
+    } else {
+      counters.processed.fetch_add(1, std::memory_order_relaxed);
+      if (in->packet.end_of_frame) {
+        glass_to_network_.Record(ToMicros(done - in->capture_time));
+      }
+    }
+    counters.service.Record(ToMicros(done - start));
+    packet_queue_->PopFront();
+    signals_[static_cast<size_t>(Stage::kEncode)].Notify();
+  }
+}
+
+}  // namespace zenremote
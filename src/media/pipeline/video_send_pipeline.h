@@ -0,0 +1,365 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/error.h"
+#include "common/latency_histogram.h"
+#include "common/spsc_queue.h"
+#include "media/capture/screen_capturer.h"
+#include "media/codec/copy_rect.h"
+#include "media/codec/encoder/color_converter.h"
+#include "media/codec/encoder/video_encoder.h"
+#include "media/pipeline/capture_scheduler.h"
+#include "media/pipeline/frame_size_limiter.h"
+
+namespace zenremote {
+
+/**
+ * @brief 视频发送流水线：采集 → 色彩转换 → 编码 → 打包发送
+ *
+ * 四个阶段各占一个线程，相邻阶段之间是 SpscQueue，槽位（BGRA 缓冲、
+ * AVFrame、EncodedPacket）在启动后复用，稳态下不再分配内存。转换阶段
+ * 按采集器报告的脏区域增量更新 ColorConverter 的持久帧，输出槽位只引用
+ * 它；编码阶段用完即释放引用，使下一帧可以就地更新。串行执行时
+ * 每帧的耗时是各阶段之和，帧率受它限制；流水线化后吞吐只受最慢的阶段
+ * 限制，各阶段同时处理相邻的帧。
+ *
+ * 丢帧策略（最新帧优先）：
+ * - 转换和编码阶段每次只取队列中最新的一帧，更早的帧直接丢弃并计入该阶段
+ *   的 dropped；被丢弃帧的关键帧请求和脏区域转移到取出的帧上
+ * - 下游队列满时上游阶段等待，不继续取帧；采集阶段等待期间屏幕变化由系统
+ *   合并，下一帧的 FrameMetadata::accumulated_frames 计入 frames_coalesced
+ * - 编码后的包按序全部发送（后续帧参考它们），打包队列满时编码阶段等待
+ *
+ * 因此某阶段变慢时排队时间不会累积：每帧的玻璃到网络延迟约为各阶段处理
+ * 时间之和，而不会因积压无限增长。
+ *
+ * 静止画面：没有脏区域和移动区域的帧在采集阶段丢弃，不复制、不转换、
+ * 不编码，采集间隔退避到 idle_capture_interval（见 CaptureScheduler）；
+ * 每隔 keepalive_interval 仍送出一帧。NotifyActivity() 立即恢复全帧率。
+ *
+ * EncoderConfig::roi_encoding 开启时，转换阶段把本帧（含被丢弃帧）的脏区域
+ * 换算为 ROI 附加到输出帧上（见 roi_map.h）。
+ *
+ * Config::copy_rect 开启时，采集器报告的移动区域（滚动、窗口拖动）不转换
+ * 到编码器输入帧上，而是作为复制命令以 SEI 随该帧发送，接收端在上一帧上
+ * 执行复制后贴上解码出的残差区域（见 copy_rect.h）；编码器只需编码新露出
+ * 的条带。此后每帧都带命令，直到整帧转换；编码阶段不再丢弃帧（接收端
+ * 依次在上一帧上合成），积压由转换阶段按最新帧优先合并。关键帧请求
+ * 先整帧转换，接收端随之直接显示解码帧。
+ *
+ * 分块编码（EncoderConfig::tile_columns/tile_rows）时，转换阶段把本帧的
+ * 变化区域换算为编码帧坐标随帧传递，编码阶段并入被丢弃帧的区域后交给
+ * 编码器（IVideoEncoder::SetChangedRegions()），没有变化的分块不编码。
+ *
+ * Config::slice_streaming 开启且编码器支持时，编码器交出的帧的各部分
+ * （IVideoEncoder::SetPartialOutputCallback()）立即进入打包队列，打包
+ * 阶段与本帧其余部分的编码重叠，玻璃到网络延迟减少最多约一帧的编码
+ * 时间；glass_to_network 只在帧的最后一部分发送后记录。
+ *
+ * RateControlMode::kLowLatency 时编码阶段按当前码率（SetBitrate()）
+ * 限制单帧大小（见 frame_size_limiter.h）：超过上限的帧照常发送并计入
+ * frames_over_cap，在超出部分以链路速率排空之前到达的帧不编码
+ * （frames_rate_limited），其变化区域与关键帧请求转移到下一帧。
+ *
+ * 各阶段的实现通过 Stages 传入：采集 ScreenCapturer、转换 IFrameConverter、
+ * 编码 IVideoEncoder、发送 PacketSink。流水线只负责线程、队列与丢帧策略，
+ * 不创建具体实现，测试可用替身驱动各阶段。
+ *
+ * 线程安全：Start/Stop 在同一控制线程调用，其他方法可在任意线程调用。
+ */
+class VideoSendPipeline {
+ public:
+  enum class Stage : size_t {
+    kCapture = 0,
+    kConvert,
+    kEncode,
+    kPacketize,
+  };
+  static constexpr size_t kStageCount = 4;
+
+  struct Config {
+    /// 编码参数；输出尺寸与采集不同时由转换阶段缩放
+    EncoderConfig encoder;
+    /// 采集 → 转换、转换 → 编码队列可容纳的帧数
+    size_t frame_queue_depth = 2;
+    /// 编码 → 打包队列可容纳的包数
+    size_t packet_queue_depth = 16;
+    /// 色彩转换线程数，0 表示按分辨率自动（见 ColorConverterConfig）
+    int convert_threads = 0;
+    /// 编码器输入帧的缓冲池使用大页
+    bool huge_pages = false;
+    /// 丢弃没有变化的帧（见 CaptureSchedulerConfig）
+    bool skip_static_frames = true;
+    /// 画面静止时的最长采集间隔
+    std::chrono::milliseconds idle_capture_interval{100};
+    /// 画面静止时送出内容不变的帧的间隔，0 表示不送
+    std::chrono::milliseconds keepalive_interval{1000};
+    /// 移动区域以复制命令发送；只对 H.264/HEVC、单时间层、不分块、不缩放
+    /// 的 BGRA → NV12（向量化内核）生效，其他情况按脏区域编码
+    bool copy_rect = false;
+    /// 帧的各部分编码完即发送（目前为分块编码的各分块），不支持流式输出
+    /// 的编码器按整帧发送；sink 按 EncodedPacket::end_of_frame 设置 RTP
+    /// marker。不与 copy_rect 同时生效
+    bool slice_streaming = false;
+  };
+
+  /**
+   * @brief 打包阶段的输出，在打包线程调用
+   * @param timestamp_90khz 由采集时刻换算的 RTP 时间戳
+   */
+  using PacketSink = std::function<Result<void>(const EncodedPacket& packet,
+                                                uint32_t timestamp_90khz)>;
+
+  struct StageStats {
+    uint64_t processed = 0;
+    uint64_t dropped = 0;  ///< 最新帧优先策略丢弃的帧
+    uint64_t errors = 0;
+    LatencyHistogram::Snapshot service;     ///< 本阶段处理时间
+    LatencyHistogram::Snapshot queue_wait;  ///< 在输入队列中的等待时间
+  };
+
+  struct Stats {
+    std::array<StageStats, kStageCount> stages;
+    uint64_t frames_coalesced = 0;  ///< 采集端合并的帧（accumulated_frames）
+    uint64_t frames_static = 0;     ///< 没有变化而丢弃的帧
+    uint64_t keepalive_frames = 0;  ///< 静止期间送出的保活帧
+    uint64_t roi_frames = 0;  ///< 带 ROI 的帧（EncoderConfig::roi_encoding）
+    uint64_t copy_rect_frames = 0;  ///< 带复制命令的帧（Config::copy_rect）
+    /// 流式输出的部分帧包（Config::slice_streaming）
+    uint64_t partial_packets = 0;
+    /// RateControlMode::kLowLatency：超过单帧上限的帧，及其占编码帧的比例
+    uint64_t frames_over_cap = 0;
+    double cap_hit_rate = 0.0;
+    /// RateControlMode::kLowLatency：为排空超出部分而不编码的帧
+    uint64_t frames_rate_limited = 0;
+    double effective_fps = 0.0;     ///< 最近约一秒实际送出的帧率
+    /// 估算节省的处理时间：丢弃的帧数 × 各阶段平均处理时间
+    double cpu_saved_ms = 0.0;
+    /// 采集到打包阶段发送完成
+    LatencyHistogram::Snapshot glass_to_network;
+  };
+
+  /**
+   * @brief 各阶段的实现
+   *
+   * 默认实现：采集 CreateScreenCapturer()，转换 ColorConverter，
+   * 编码 CreateVideoEncoder(Config::encoder)。
+   */
+  struct Stages {
+    /// 已初始化并 Start() 的采集器，Stop() 之前保持有效
+    media::capture::ScreenCapturer* capturer = nullptr;
+    /// 未初始化的转换器，由转换阶段按采集帧的尺寸初始化
+    std::unique_ptr<IFrameConverter> converter;
+    /// 已按 Config::encoder 初始化的编码器
+    std::unique_ptr<IVideoEncoder> encoder;
+    PacketSink sink;
+  };
+
+  VideoSendPipeline();
+  explicit VideoSendPipeline(const Config& config);
+  ~VideoSendPipeline();
+
+  VideoSendPipeline(const VideoSendPipeline&) = delete;
+  VideoSendPipeline& operator=(const VideoSendPipeline&) = delete;
+
+  /// @brief 启动各阶段线程，Stages 的各项均须提供
+  Result<void> Start(Stages stages);
+
+  /// @brief 停止并等待所有阶段线程退出，未发送的帧被丢弃
+  void Stop();
+
+  bool IsRunning() const { return running_; }
+
+  /// @brief 下一个编码的帧为关键帧（在编码线程生效；copy_rect 开启时在
+  ///        转换线程整帧转换后生效）
+  void ForceKeyFrame();
+
+  /// @brief 更新编码码率（在编码线程生效）
+  void SetBitrate(int bitrate_bps) { pending_bitrate_ = bitrate_bps; }
+
+  /**
+   * @brief 即将出现画面变化（如收到远端的键鼠输入）
+   *
+   * 画面静止、采集间隔已退避时立即采集并恢复全帧率。
+   */
+  void NotifyActivity();
+
+  Stats GetStats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /// 采集阶段复制出的 BGRA/RGBA 帧
+  struct RawFrame {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    media::capture::PixelFormat format = media::capture::PixelFormat::BGRA32;
+    bool is_keyframe = false;
+    /// 相对上一帧变化的区域（不含移动区域）
+    std::vector<media::capture::DirtyRect> dirty_rects;
+    std::vector<media::capture::MoveRect> move_rects;
+    bool full_frame = true;  ///< 忽略 dirty_rects，整帧转换
+    Clock::time_point capture_time;
+    Clock::time_point enqueue_time;
+  };
+
+  /// 转换阶段输出的编码器输入格式帧（引用转换器的持久帧）
+  struct ConvertedFrame {
+    AVFramePtr frame;
+    bool is_keyframe = false;
+    /// 复制命令的 SEI NAL，为空表示没有命令
+    std::vector<uint8_t> copy_rect_sei;
+    bool droppable = true;  ///< 接收端按顺序合成的帧不能丢弃
+    /// 分块编码：相对上一帧变化的区域（编码帧坐标）
+    std::vector<media::capture::DirtyRect> changed_rects;
+    bool changed_full_frame = true;  ///< 忽略 changed_rects，整帧变化
+    Clock::time_point capture_time;
+    Clock::time_point enqueue_time;
+  };
+
+  struct PacketSlot {
+    EncodedPacket packet;
+    Clock::time_point capture_time;
+    Clock::time_point enqueue_time;
+  };
+
+  /// @brief 阶段线程的唤醒信号：上游提交或下游腾出槽位时通知
+  class Signal {
+   public:
+    void Notify();
+    /// @brief 等待通知或超时，返回时清除通知
+    void Wait(std::chrono::milliseconds timeout);
+    /// @brief 等待通知或到达 deadline，返回时清除通知
+    void WaitUntil(Clock::time_point deadline);
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool notified_ = false;
+  };
+
+  struct StageCounters {
+    std::atomic<uint64_t> processed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> errors{0};
+    LatencyHistogram service;
+    LatencyHistogram queue_wait;
+  };
+
+  void RunCapture();
+  void RunConvert();
+  void RunEncode();
+  void RunPacketize();
+
+  /**
+   * @brief 丢弃队列中除最新一帧外的所有帧
+   * @return 最新一帧，队列为空时返回 nullptr
+   */
+  template <typename Slot>
+  Slot* TakeLatest(SpscQueue<Slot>& queue, Stage stage, bool& keyframe);
+
+  static bool CanDrop(const RawFrame&) { return true; }
+  static bool CanDrop(const ConvertedFrame& frame) { return frame.droppable; }
+
+  /// @brief 采集帧的变化并入待转换的区域（转换线程）
+  void AppendFrameRects(const RawFrame& frame);
+
+  /// @brief 被丢弃的采集帧的脏区域并入下一次转换
+  void OnFrameDropped(const RawFrame& frame);
+  /// @brief 释放被丢弃帧对持久帧的引用，变化区域并入下一次编码
+  void OnFrameDropped(ConvertedFrame& frame);
+
+  Result<void> EnsureConverter(const RawFrame& frame);
+  void ApplyEncoderControls();
+
+  /// @brief 等待打包队列的空槽位，停止时返回 nullptr（编码线程或编码器的
+  ///        流式输出回调）
+  PacketSlot* WaitForPacketSlot();
+
+  /// @brief 编码器流式输出的一部分，Encode() 期间串行调用
+  void OnPartialOutput(EncodedPacket& part);
+  StageCounters& Counters(Stage stage) {
+    return counters_[static_cast<size_t>(stage)];
+  }
+  void NotifyAll();
+
+  Config config_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> should_stop_{false};
+
+  media::capture::ScreenCapturer* capturer_ = nullptr;
+  std::unique_ptr<IVideoEncoder> encoder_;
+  PacketSink sink_;
+  std::unique_ptr<IFrameConverter> converter_;  ///< 只在转换线程使用
+  /// 转换线程：尚未转换到持久帧的脏区域
+  std::vector<media::capture::DirtyRect> pending_dirty_rects_;
+  bool pending_full_frame_ = true;
+  /// 转换线程：移动区域以复制命令发送（转换器重建时确定）
+  bool copy_rect_active_ = false;
+  CopyRectTracker copy_rect_tracker_;
+  CopyRectCommand copy_rect_command_;
+  bool capture_full_frame_ = true;  ///< 采集线程：上一帧出错，下一帧整帧
+  /// 分块编码，编码器跳过没有变化的分块（Start() 时确定）
+  bool tiled_ = false;
+  /// 编码线程：被丢弃帧的变化区域
+  std::vector<media::capture::DirtyRect> encode_changed_rects_;
+  bool encode_changed_full_frame_ = false;
+  /// 编码器交出帧的各部分（Start() 时确定）
+  bool streaming_ = false;
+  /// 编码线程：流式输出时最后一部分先写到这里，再放入打包队列
+  EncodedPacket frame_packet_;
+  /// 正在编码的帧的采集时刻，供流式输出回调使用
+  Clock::time_point partial_capture_time_;
+  /// 正在编码的帧已由回调交出的字节数
+  size_t partial_bytes_ = 0;
+  /// 编码线程：RateControlMode::kLowLatency 的单帧大小限制
+  bool latency_bounded_ = false;
+  FrameSizeLimiter frame_limiter_;
+
+  std::unique_ptr<SpscQueue<RawFrame>> raw_queue_;
+  std::unique_ptr<SpscQueue<ConvertedFrame>> converted_queue_;
+  std::unique_ptr<SpscQueue<PacketSlot>> packet_queue_;
+  std::array<Signal, kStageCount> signals_;
+  std::array<std::thread, kStageCount> threads_;
+
+  /// 编码器输出的 pts 是输入帧序号，按它找回采集时刻（编码线程使用）
+  static constexpr size_t kCaptureTimeHistory = 64;
+  std::array<Clock::time_point, kCaptureTimeHistory> capture_times_{};
+  /// 同样按 pts 找回该帧的复制命令
+  std::array<std::vector<uint8_t>, kCaptureTimeHistory> copy_rect_seis_;
+  int64_t frames_submitted_ = 0;
+
+  std::atomic<bool> force_keyframe_{false};
+  /// 复制命令丢失或收到关键帧请求：下一帧整帧转换并编码为关键帧
+  std::atomic<bool> resync_{false};
+  std::atomic<int> pending_bitrate_{0};
+  std::atomic<bool> activity_{false};
+
+  std::array<StageCounters, kStageCount> counters_;
+  std::atomic<uint64_t> frames_coalesced_{0};
+  std::atomic<uint64_t> frames_static_{0};
+  std::atomic<uint64_t> keepalive_frames_{0};
+  std::atomic<uint64_t> roi_frames_{0};
+  std::atomic<uint64_t> copy_rect_frames_{0};
+  std::atomic<uint64_t> partial_packets_{0};
+  std::atomic<uint64_t> limited_frames_encoded_{0};
+  std::atomic<uint64_t> frames_over_cap_{0};
+  std::atomic<uint64_t> frames_rate_limited_{0};
+  std::atomic<double> effective_fps_{0.0};
+  LatencyHistogram glass_to_network_;
+};
+
+}  // namespace zenremote
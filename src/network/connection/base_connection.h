@@ -2,8 +2,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 #include "common/error.h"
+#include "network/io/socket_types.h"
 
 namespace zenremote {
 
@@ -75,6 +77,32 @@ class BaseConnection {
    * @brief 获取连接类型
    */
   virtual ConnectionType GetType() const = 0;
+
+  /**
+   * @brief 获取可供 poll 等待可读的底层句柄
+   *
+   * ReceiveLoop 据此与唤醒句柄一起等待，无需轮询；任一句柄可读时以
+   * timeout 0 调用 Recv() 取数据。返回空表示不支持，ReceiveLoop 退回到
+   * 带超时的 Recv() 轮询。句柄集合变化时 GetPollHandlesGeneration() 递增。
+   */
+  virtual std::vector<socket_t> GetPollHandles() const { return {}; }
+
+  /**
+   * @brief 句柄集合的版本号
+   *
+   * 连接迁移等会在接收线程里增删 socket；ReceiveLoop 缓存句柄集合，在每次
+   * 等待前比较版本号，变化时重新调用 GetPollHandles()。
+   */
+  virtual uint32_t GetPollHandlesGeneration() const { return 0; }
+
+  /**
+   * @brief 处理连接自身的定时任务（如 TURN 分配刷新）
+   *
+   * 与 Recv() 在同一（接收）线程调用，PeerConnection 在每次等待前把它与
+   * 传输层定时器合并。
+   * @return 距下一次需要调用的毫秒数，-1 表示没有定时任务
+   */
+  virtual int ProcessTimers() { return -1; }
 };
 
 }  // namespace zenremote
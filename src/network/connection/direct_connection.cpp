@@ -1,5 +1,7 @@
 #include "network/connection/direct_connection.h"
 
+#include <algorithm>
+
 #include "common/log_manager.h"
 
 namespace zenremote {
@@ -27,19 +29,15 @@ Result<void> DirectConnection::Initialize(const Config& config) {
   config_ = config;
 
   // Create UdpSocket (Network I/O layer)
-  UdpSocket::Config socket_config;
-  socket_config.local_ip = config.local_ip;
-  socket_config.local_port = config.local_port;
-  socket_config.socket_buffer_size = config.socket_buffer_size;
-  socket_config.recv_timeout_ms = static_cast<int>(config.recv_timeout.count());
-
-  socket_ = std::make_unique<UdpSocket>(socket_config);
-
-  if (!socket_->Open()) {
-    socket_.reset();
+  auto socket = OpenSocket(config.local_ip, config.local_port);
+  if (!socket) {
     return Result<void>::Err(ErrorCode::kNetworkError,
                              "Failed to open UDP socket");
   }
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    socket_ = std::move(socket);
+  }
 
   // Socket is now open and ready to use
 
@@ -52,6 +50,35 @@ Result<void> DirectConnection::Initialize(const Config& config) {
     }
   }
 
+  if (config_.enable_migration && config_.session_id == 0) {
+    ZENREMOTE_WARN(LOG_MODULE_NETWORK,
+                   "Connection migration disabled: session_id is 0");
+    config_.enable_migration = false;
+  }
+  if (config_.enable_migration && config_.migration_key.empty()) {
+    ZENREMOTE_WARN(LOG_MODULE_NETWORK,
+                   "Connection migration disabled: no migration key");
+    config_.enable_migration = false;
+  }
+  if (config_.enable_migration) {
+    rng_.seed(std::random_device{}());
+    auto poller_result = poller_.Open();
+    if (poller_result.IsErr()) {
+      Shutdown();
+      return poller_result;
+    }
+    // 没有网卡事件时仍可响应对端迁移和手动 Migrate()
+    auto monitor_result = monitor_.Open();
+    if (monitor_result.IsErr()) {
+      ZENREMOTE_WARN(LOG_MODULE_NETWORK, "Network monitor unavailable: {}",
+                     monitor_result.Message());
+    } else if (monitor_.GetHandle() == kInvalidSocket) {
+      address_poll_at_ = Clock::now() + std::chrono::milliseconds(
+                                            NetworkMonitor::kPollIntervalMs);
+    }
+  }
+  handles_generation_.fetch_add(1, std::memory_order_release);
+
   ZENREMOTE_INFO(LOG_MODULE_NETWORK,
                  "DirectConnection initialized: local={}:{}, remote={}:{}",
                  config_.local_ip, config_.local_port, config_.remote.address,
@@ -60,15 +87,28 @@ Result<void> DirectConnection::Initialize(const Config& config) {
 }
 
 void DirectConnection::Shutdown() {
-  if (socket_) {
-    socket_->Close();
-    socket_.reset();
+  probe_.reset();
+  challenges_.clear();
+  retired_socket_.reset();
+  retire_at_ = Clock::time_point::max();
+  migrate_at_ = Clock::time_point::max();
+  address_poll_at_ = Clock::time_point::max();
+  monitor_.Close();
+  poller_.Close();
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    if (socket_) {
+      socket_->Close();
+      socket_.reset();
+    }
+    has_remote_endpoint_ = false;
   }
-  has_remote_endpoint_ = false;
+  handles_generation_.fetch_add(1, std::memory_order_release);
   ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "DirectConnection shutdown");
 }
 
 bool DirectConnection::IsOpen() const {
+  std::lock_guard<std::mutex> lock(path_mutex_);
   return socket_ && socket_->IsOpen();
 }
 
@@ -78,14 +118,27 @@ Result<void> DirectConnection::SetRemote(const Endpoint& endpoint) {
                              "Invalid remote endpoint");
   }
 
-  remote_endpoint_ = endpoint;
-  has_remote_endpoint_ = true;
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    remote_endpoint_ = endpoint;
+    has_remote_endpoint_ = true;
+  }
 
   ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "Remote endpoint set: {}:{}",
                   endpoint.address, endpoint.port);
   return Result<void>::Ok();
 }
 
+Endpoint DirectConnection::GetRemote() const {
+  std::lock_guard<std::mutex> lock(path_mutex_);
+  return remote_endpoint_;
+}
+
+uint16_t DirectConnection::GetLocalPort() const {
+  std::lock_guard<std::mutex> lock(path_mutex_);
+  return socket_ ? socket_->GetLocalPort() : 0;
+}
+
 Result<size_t> DirectConnection::Recv(uint8_t* buffer,
                                       size_t buffer_size,
                                       int timeout_ms) {
@@ -93,7 +146,8 @@ Result<size_t> DirectConnection::Recv(uint8_t* buffer,
 }
 
 Result<size_t> DirectConnection::Send(const uint8_t* data, size_t length) {
-  if (!IsOpen()) {
+  std::lock_guard<std::mutex> lock(path_mutex_);
+  if (!socket_ || !socket_->IsOpen()) {
     return Result<size_t>::Err(ErrorCode::kNotInitialized,
                                "DirectConnection not initialized");
   }
@@ -108,7 +162,7 @@ Result<size_t> DirectConnection::Send(const uint8_t* data, size_t length) {
                                "Remote endpoint not set");
   }
 
-  // Use UdpSocket layer to send
+  // Use UdpSocket layer to send（迁移时 socket_ 与远端地址在锁内切换）
   if (!socket_->SendTo(data, length, remote_endpoint_.address,
                        remote_endpoint_.port)) {
     send_failures_++;
@@ -137,6 +191,31 @@ Result<size_t> DirectConnection::Receive(uint8_t* buffer,
                                "Invalid receive parameters");
   }
 
+  if (config_.enable_migration) {
+    // 迁移期间同时有多个 socket，另外还要处理探测与网卡事件
+    const auto deadline = Clock::now() + timeout;
+    while (true) {
+      const size_t received = ReadAvailable(buffer, buffer_size);
+      if (received > 0) {
+        bytes_received_ += received;
+        packets_received_++;
+        return Result<size_t>::Ok(received);
+      }
+      const auto remaining =
+          std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                                Clock::now());
+      if (timeout.count() <= 0 || remaining.count() <= 0) {
+        recv_failures_++;
+        return Result<size_t>::Err(ErrorCode::kTimeout, "Receive timeout");
+      }
+      auto readable = poller_.Wait(GetPollHandles(),
+                                   static_cast<int>(remaining.count()));
+      if (readable.IsErr()) {
+        return Result<size_t>::Err(readable.Code(), readable.Message());
+      }
+    }
+  }
+
   // Use UdpSocket layer to receive
   std::string from_ip;
   uint16_t from_port;
@@ -161,7 +240,353 @@ DirectConnection::Stats DirectConnection::GetStats() const {
   stats.packets_received = packets_received_.load();
   stats.send_failures = send_failures_.load();
   stats.recv_failures = recv_failures_.load();
+  stats.migrations = migrations_.load();
+  stats.migration_failures = migration_failures_.load();
+  stats.path_switches = path_switches_.load();
+  stats.probes_rejected = probes_rejected_.load();
   return stats;
 }
 
+std::vector<socket_t> DirectConnection::GetPollHandles() const {
+  // socket_ 只在接收线程替换，这里（同一线程）不加锁读取
+  std::vector<socket_t> handles;
+  if (socket_) {
+    handles.push_back(socket_->GetHandle());
+  }
+  if (probe_) {
+    handles.push_back(probe_->socket->GetHandle());
+  }
+  if (retired_socket_) {
+    handles.push_back(retired_socket_->GetHandle());
+  }
+  if (monitor_.GetHandle() != kInvalidSocket) {
+    handles.push_back(monitor_.GetHandle());
+  }
+  return handles;
+}
+
+int DirectConnection::ProcessTimers() {
+  if (!config_.enable_migration) {
+    return -1;
+  }
+  const auto now = Clock::now();
+
+  if (address_poll_at_ <= now) {
+    address_poll_at_ =
+        now + std::chrono::milliseconds(NetworkMonitor::kPollIntervalMs);
+    if (monitor_.ReadChanges()) {
+      ScheduleMigration(now);
+    }
+  }
+
+  if (migrate_at_ <= now) {
+    migrate_at_ = Clock::time_point::max();
+    auto result = Migrate();
+    if (result.IsErr()) {
+      ZENREMOTE_WARN(LOG_MODULE_NETWORK, "Automatic migration failed: {}",
+                     result.Message());
+    }
+  }
+
+  if (probe_ && probe_->next_send <= now) {
+    if (probe_->attempts >= config_.max_probe_attempts) {
+      ZENREMOTE_WARN(LOG_MODULE_NETWORK,
+                     "Migration probe unanswered after {} attempts, "
+                     "keeping current path",
+                     probe_->attempts);
+      probe_.reset();
+      migration_failures_++;
+      handles_generation_.fetch_add(1, std::memory_order_release);
+    } else {
+      SendProbe(now);
+    }
+  }
+
+  auto next_challenge = Clock::time_point::max();
+  for (auto it = challenges_.begin(); it != challenges_.end();) {
+    if (it->next_send <= now) {
+      if (it->attempts >= config_.max_probe_attempts) {
+        ZENREMOTE_WARN(LOG_MODULE_NETWORK,
+                       "Path challenge to {}:{} unanswered, keeping remote",
+                       it->endpoint.address, it->endpoint.port);
+        it = challenges_.erase(it);
+        continue;
+      }
+      SendPathChallenge(*it, now);
+    }
+    next_challenge = std::min(next_challenge, it->next_send);
+    ++it;
+  }
+
+  if (retired_socket_ && retire_at_ <= now) {
+    retired_socket_.reset();
+    retire_at_ = Clock::time_point::max();
+    handles_generation_.fetch_add(1, std::memory_order_release);
+  }
+
+  const auto next = std::min(
+      {address_poll_at_, migrate_at_, retire_at_, next_challenge,
+       probe_ ? probe_->next_send : Clock::time_point::max()});
+  if (next == Clock::time_point::max()) {
+    return -1;
+  }
+  const auto delay =
+      std::chrono::duration_cast<std::chrono::milliseconds>(next - now);
+  return static_cast<int>(std::max<int64_t>(0, delay.count() + 1));
+}
+
+Result<void> DirectConnection::Migrate(const std::string& local_ip) {
+  if (!config_.enable_migration) {
+    return Result<void>::Err(ErrorCode::kInvalidState,
+                             "Connection migration not enabled");
+  }
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    if (!socket_ || !has_remote_endpoint_) {
+      return Result<void>::Err(ErrorCode::kNotInitialized,
+                               "DirectConnection not connected");
+    }
+  }
+
+  const std::string address = local_ip.empty() ? config_.local_ip : local_ip;
+  auto socket = OpenSocket(address, 0);
+  if (!socket) {
+    return Result<void>::Err(ErrorCode::kSocketBindFailed,
+                             "Failed to bind migration socket on " + address);
+  }
+
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK, "Probing new path from {}:{}", address,
+                 socket->GetLocalPort());
+  probe_.emplace();
+  probe_->socket = std::move(socket);
+  probe_->transaction_id = NewTransactionId();
+  migrate_at_ = Clock::time_point::max();
+  handles_generation_.fetch_add(1, std::memory_order_release);
+  SendProbe(Clock::now());
+  return Result<void>::Ok();
+}
+
+size_t DirectConnection::ReadSocket(UdpSocket& socket,
+                                    uint8_t* buffer,
+                                    size_t buffer_size) {
+  Endpoint from;
+  size_t received = buffer_size;
+  while (socket.RecvFrom(buffer, received, from.address, from.port, 0)) {
+    if (!HandleProbe(socket, buffer, received, from)) {
+      return received;
+    }
+    received = buffer_size;
+  }
+  return 0;
+}
+
+size_t DirectConnection::ReadAvailable(uint8_t* buffer, size_t buffer_size) {
+  // 每次重新取指针：读到探测响应会切换 socket 并替换旧 socket
+  for (int i = 0; i < 3; ++i) {
+    UdpSocket* socket = i == 0   ? socket_.get()
+                        : i == 1 ? (probe_ ? probe_->socket.get() : nullptr)
+                                 : retired_socket_.get();
+    if (!socket) {
+      continue;
+    }
+    if (const size_t received = ReadSocket(*socket, buffer, buffer_size)) {
+      return received;
+    }
+  }
+  // 网卡事件放在最后，收包热路径上不多一次系统调用
+  if (monitor_.GetHandle() != kInvalidSocket && monitor_.ReadChanges()) {
+    ScheduleMigration(Clock::now());
+  }
+  return 0;
+}
+
+bool DirectConnection::HandleProbe(UdpSocket& socket,
+                                   const uint8_t* data,
+                                   size_t length,
+                                   const Endpoint& from) {
+  if (!IsStunMessage(data, length)) {
+    return false;
+  }
+  auto message = ParseStunMessage(data, length);
+  if (!message || !message->IsBinding()) {
+    return false;
+  }
+  const auto session_id = message->GetUint32(StunAttributeType::kSessionId);
+  if (!session_id) {
+    return false;
+  }
+  if (*session_id != config_.session_id) {
+    ZENREMOTE_DEBUG(LOG_MODULE_NETWORK,
+                    "Ignoring migration probe for another session from {}:{}",
+                    from.address, from.port);
+    return true;
+  }
+  // 会话 ID 以明文传输，只有密钥签名的探测才能影响路径
+  if (!VerifyStunMessageIntegrity(data, length, config_.migration_key)) {
+    probes_rejected_++;
+    ZENREMOTE_WARN(LOG_MODULE_NETWORK,
+                   "Dropping unauthenticated migration probe from {}:{}",
+                   from.address, from.port);
+    return true;
+  }
+
+  if (message->message_class == StunClass::kRequest) {
+    // 签名的探测也可能是从其他地址重放的：先回复，新源地址需先通过挑战
+    bool new_path = false;
+    {
+      std::lock_guard<std::mutex> lock(path_mutex_);
+      new_path = !has_remote_endpoint_ || !(remote_endpoint_ == from);
+    }
+
+    StunMessage response;
+    response.message_class = StunClass::kSuccessResponse;
+    response.transaction_id = message->transaction_id;
+    response.AddXorAddress(StunAttributeType::kXorMappedAddress, from);
+    response.AddUint32(StunAttributeType::kSessionId, config_.session_id);
+    const auto bytes = SerializeStunMessage(response, config_.migration_key);
+    socket.SendTo(bytes.data(), bytes.size(), from.address, from.port);
+
+    if (new_path) {
+      StartPathChallenge(from, Clock::now());
+    }
+    return true;
+  }
+
+  if (message->message_class != StunClass::kSuccessResponse) {
+    return true;
+  }
+  if (probe_ && probe_->socket.get() == &socket &&
+      message->transaction_id == probe_->transaction_id) {
+    CommitMigration(Clock::now());
+    return true;
+  }
+  auto challenge = std::find_if(
+      challenges_.begin(), challenges_.end(), [&](const PathChallenge& c) {
+        return c.transaction_id == message->transaction_id;
+      });
+  if (challenge != challenges_.end() && challenge->endpoint == from) {
+    CompletePathChallenge(from);
+  }
+  return true;
+}
+
+void DirectConnection::SendProbe(Clock::time_point now) {
+  StunMessage request;
+  request.transaction_id = probe_->transaction_id;
+  request.AddUint32(StunAttributeType::kSessionId, config_.session_id);
+  const auto bytes = SerializeStunMessage(request, config_.migration_key);
+  const Endpoint remote = GetRemote();
+  probe_->socket->SendTo(bytes.data(), bytes.size(), remote.address,
+                         remote.port);
+  probe_->next_send =
+      now + std::chrono::milliseconds(config_.probe_rto_ms
+                                      << std::min(probe_->attempts, 10));
+  probe_->attempts++;
+}
+
+void DirectConnection::StartPathChallenge(const Endpoint& endpoint,
+                                          Clock::time_point now) {
+  // 对端重传探测时沿用进行中的挑战
+  for (const auto& challenge : challenges_) {
+    if (challenge.endpoint == endpoint) {
+      return;
+    }
+  }
+  if (challenges_.size() >= kMaxPathChallenges) {
+    challenges_.erase(challenges_.begin());
+  }
+  PathChallenge challenge;
+  challenge.endpoint = endpoint;
+  challenge.transaction_id = NewTransactionId();
+  challenges_.push_back(challenge);
+  ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "Validating new peer path {}:{}",
+                  endpoint.address, endpoint.port);
+  SendPathChallenge(challenges_.back(), now);
+}
+
+void DirectConnection::SendPathChallenge(PathChallenge& challenge,
+                                         Clock::time_point now) {
+  StunMessage request;
+  request.transaction_id = challenge.transaction_id;
+  request.AddUint32(StunAttributeType::kSessionId, config_.session_id);
+  const auto bytes = SerializeStunMessage(request, config_.migration_key);
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    if (socket_) {
+      socket_->SendTo(bytes.data(), bytes.size(), challenge.endpoint.address,
+                      challenge.endpoint.port);
+    }
+  }
+  challenge.next_send =
+      now + std::chrono::milliseconds(config_.probe_rto_ms
+                                      << std::min(challenge.attempts, 10));
+  challenge.attempts++;
+}
+
+void DirectConnection::CompletePathChallenge(const Endpoint& endpoint) {
+  challenges_.clear();
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    if (has_remote_endpoint_ && remote_endpoint_ == endpoint) {
+      return;
+    }
+    remote_endpoint_ = endpoint;
+    has_remote_endpoint_ = true;
+  }
+  path_switches_++;
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK, "Peer migrated to {}:{}",
+                 endpoint.address, endpoint.port);
+}
+
+void DirectConnection::CommitMigration(Clock::time_point now) {
+  {
+    std::lock_guard<std::mutex> lock(path_mutex_);
+    retired_socket_ = std::move(socket_);
+    socket_ = std::move(probe_->socket);
+  }
+  probe_.reset();
+  retire_at_ = now + std::chrono::milliseconds(config_.retire_grace_ms);
+  migrations_++;
+  handles_generation_.fetch_add(1, std::memory_order_release);
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK, "Migrated to local port {}",
+                 socket_->GetLocalPort());
+}
+
+void DirectConnection::ScheduleMigration(Clock::time_point now) {
+  // 地址变更常常是先删后加的一串事件，等它们平息后再迁移
+  migrate_at_ = now + std::chrono::milliseconds(config_.migration_debounce_ms);
+  ZENREMOTE_DEBUG(LOG_MODULE_NETWORK,
+                  "Network change detected, migrating in {} ms",
+                  config_.migration_debounce_ms);
+}
+
+std::unique_ptr<UdpSocket> DirectConnection::OpenSocket(
+    const std::string& local_ip,
+    uint16_t local_port) const {
+  UdpSocket::Config socket_config;
+  socket_config.local_ip = local_ip;
+  socket_config.local_port = local_port;
+  socket_config.socket_buffer_size = config_.socket_buffer_size;
+  socket_config.recv_timeout_ms =
+      static_cast<int>(config_.recv_timeout.count());
+
+  auto socket = std::make_unique<UdpSocket>(socket_config);
+  if (!socket->Open()) {
+    return nullptr;
+  }
+  return socket;
+}
+
+StunTransactionId DirectConnection::NewTransactionId() {
+  StunTransactionId id;
+  for (size_t i = 0; i < id.size(); i += 8) {
+    uint64_t value = rng_();
+    for (size_t j = i; j < std::min(id.size(), i + 8); ++j) {
+      id[j] = static_cast<uint8_t>(value);
+      value >>= 8U;
+    }
+  }
+  return id;
+}
+
 }  // namespace zenremote
@@ -5,24 +5,22 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "common/error.h"
 #include "network/connection/base_connection.h"
+#include "network/connection/network_monitor.h"
+#include "network/io/endpoint.h"
+#include "network/io/event_poller.h"
 #include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
 
 namespace zenremote {
 
-/**
- * @brief 网络端点 (IP + Port)
- */
-struct Endpoint {
-  std::string address;  ///< IP 地址
-  uint16_t port = 0;    ///< 端口号
-};
-
 /**
  * @brief 传输层实现 - 局域网直连 (Phase 1)
  *
@@ -40,6 +38,21 @@ struct Endpoint {
  * - 局域网内设备直连
  * - 已知对方 IP 和端口
  * - 低延迟场景 (< 5ms)
+ *
+ * 连接迁移（enable_migration，两端使用握手得到的同一会话 ID 与迁移密钥）：
+ * - 本端网卡地址变化（NetworkMonitor）或调用 Migrate() 时，在新地址上新建
+ *   socket，向对端发送带 SESSION-ID 的 STUN Binding 请求作为路径探测
+ * - 探测请求与响应都带以 migration_key 计算的 MESSAGE-INTEGRITY，校验失败的
+ *   一律丢弃；会话 ID 是明文，不能单独作为切换路径的凭据
+ * - 对端收到新源地址的探测后先回复，再向该地址发送路径挑战（同样签名的
+ *   Binding 请求），只有该地址回复了挑战才切换发送地址，重放到其他地址的
+ *   探测无法劫持媒体流；本端收到探测响应后改用新 socket 发送，旧 socket
+ *   保留 retire_grace_ms 接收在途报文
+ * - 只替换 UDP 路径，上层的传输状态、轨道与解码器不受影响，无需重新握手
+ *   或请求关键帧
+ *
+ * 线程模型：Recv()/ProcessTimers()/Migrate() 在接收线程调用，Send() 可在
+ * 任意线程调用。
  */
 class DirectConnection : public BaseConnection {
  public:
@@ -52,6 +65,16 @@ class DirectConnection : public BaseConnection {
     Endpoint remote;                       ///< 远程端点 (IP + Port)
     int socket_buffer_size = 1024 * 1024;  ///< Socket 缓冲区大小
     std::chrono::milliseconds recv_timeout{1000};  ///< 接收超时
+
+    bool enable_migration = false;  ///< 监视网卡变化并响应对端的迁移探测
+    uint32_t session_id = 0;        ///< 迁移探测携带的会话 ID，两端相同且非 0
+    /// 探测 MESSAGE-INTEGRITY 密钥，两端相同且非空，见
+    /// HandshakeManager::GetMigrationKey()
+    std::vector<uint8_t> migration_key;
+    int migration_debounce_ms = 100;  ///< 合并连续的网卡事件（先删后加地址）
+    int probe_rto_ms = 100;           ///< 探测无响应时的重传间隔（逐次翻倍）
+    int max_probe_attempts = 5;       ///< 探测最多发送次数，之后放弃新路径
+    int retire_grace_ms = 1000;  ///< 切换后旧 socket 继续接收在途报文的时长
   };
 
   /**
@@ -64,6 +87,10 @@ class DirectConnection : public BaseConnection {
     uint64_t packets_received = 0;  ///< 接收包总数
     uint64_t send_failures = 0;     ///< 发送失败次数
     uint64_t recv_failures = 0;     ///< 接收失败次数
+    uint64_t migrations = 0;        ///< 本端完成的路径迁移次数
+    uint64_t migration_failures = 0;  ///< 探测无响应而放弃的迁移次数
+    uint64_t path_switches = 0;     ///< 对端迁移导致的远端地址切换次数
+    uint64_t probes_rejected = 0;   ///< MESSAGE-INTEGRITY 校验失败的探测数
   };
 
   DirectConnection();
@@ -95,23 +122,99 @@ class DirectConnection : public BaseConnection {
                          std::chrono::milliseconds timeout);
 
   ConnectionType GetType() const override { return ConnectionType::kDirect; }
+  /// @brief 当前 socket；迁移时另含探测 socket、旧 socket 与网卡事件句柄
+  std::vector<socket_t> GetPollHandles() const override;
+  uint32_t GetPollHandlesGeneration() const override {
+    return handles_generation_.load(std::memory_order_acquire);
+  }
+  int ProcessTimers() override;
+
+  /**
+   * @brief 把连接迁移到新的本地地址
+   *
+   * 在 local_ip 上新建 socket 并发送路径探测，对端确认后切换；确认前继续
+   * 使用原路径收发。已有未完成的探测时以新的为准。须在接收线程调用。
+   * @param local_ip 新的本地地址，为空时沿用 config.local_ip（重新选路）
+   */
+  Result<void> Migrate(const std::string& local_ip = "");
 
   Result<void> SetRemote(const Endpoint& endpoint);
+  Endpoint GetRemote() const;
+  /// @brief 当前发送 socket 绑定的本地端口
+  uint16_t GetLocalPort() const;
   Stats GetStats() const;
   const Config& config() const { return config_; }
 
  private:
+  using Clock = std::chrono::steady_clock;
+
+  /// @brief 等待对端确认的新路径
+  struct Probe {
+    std::unique_ptr<UdpSocket> socket;
+    StunTransactionId transaction_id{};
+    Clock::time_point next_send{};
+    int attempts = 0;
+  };
+
+  /// @brief 对端新源地址的路径挑战，对方回复后才切换发送地址
+  struct PathChallenge {
+    Endpoint endpoint;
+    StunTransactionId transaction_id{};
+    Clock::time_point next_send{};
+    int attempts = 0;
+  };
+
+  static constexpr size_t kMaxPathChallenges = 4;
+
+  /// @brief 从一个 socket 非阻塞读取，迁移探测报文内部消费后返回 0
+  size_t ReadSocket(UdpSocket& socket, uint8_t* buffer, size_t buffer_size);
+  /// @brief 依次读取全部 socket 与网卡事件，返回首个数据报文的长度
+  size_t ReadAvailable(uint8_t* buffer, size_t buffer_size);
+  /// @brief 处理迁移探测（请求或响应），不是探测返回 false
+  bool HandleProbe(UdpSocket& socket,
+                   const uint8_t* data,
+                   size_t length,
+                   const Endpoint& from);
+  void SendProbe(Clock::time_point now);
+  void StartPathChallenge(const Endpoint& endpoint, Clock::time_point now);
+  void SendPathChallenge(PathChallenge& challenge, Clock::time_point now);
+  /// @brief 对端回复了路径挑战，切换发送地址
+  void CompletePathChallenge(const Endpoint& endpoint);
+  void CommitMigration(Clock::time_point now);
+  /// @brief 网卡变化后延迟 migration_debounce_ms 迁移
+  void ScheduleMigration(Clock::time_point now);
+  std::unique_ptr<UdpSocket> OpenSocket(const std::string& local_ip,
+                                        uint16_t local_port) const;
+  StunTransactionId NewTransactionId();
+
   Config config_{};
+  mutable std::mutex path_mutex_;  ///< 保护 socket_ 与远端地址（Send 任意线程）
   std::unique_ptr<UdpSocket> socket_;
   Endpoint remote_endpoint_;
   bool has_remote_endpoint_ = false;
 
+  // 以下迁移状态只在接收线程访问
+  std::optional<Probe> probe_;
+  std::vector<PathChallenge> challenges_;
+  std::unique_ptr<UdpSocket> retired_socket_;
+  Clock::time_point retire_at_ = Clock::time_point::max();
+  Clock::time_point migrate_at_ = Clock::time_point::max();
+  Clock::time_point address_poll_at_ = Clock::time_point::max();
+  NetworkMonitor monitor_;
+  EventPoller poller_;  ///< 多个 socket 时阻塞 Recv() 使用
+  std::mt19937_64 rng_;
+  std::atomic<uint32_t> handles_generation_{0};
+
   std::atomic<uint64_t> bytes_sent_{0};
   std::atomic<uint64_t> bytes_received_{0};
   std::atomic<uint64_t> packets_sent_{0};
   std::atomic<uint64_t> packets_received_{0};
   std::atomic<uint64_t> send_failures_{0};
   std::atomic<uint64_t> recv_failures_{0};
+  std::atomic<uint64_t> migrations_{0};
+  std::atomic<uint64_t> migration_failures_{0};
+  std::atomic<uint64_t> path_switches_{0};
+  std::atomic<uint64_t> probes_rejected_{0};
 };
 
 }  // namespace zenremote
@@ -0,0 +1,144 @@
+#include "network/connection/ice_candidate.h"
+
+#include <algorithm>
+#include <random>
+
+#include "network/io/socket_types.h"
+
+#ifdef _WIN32
+#include <iphlpapi.h>
+#pragma comment(lib, "iphlpapi.lib")
+#else
+#include <ifaddrs.h>
+#include <net/if.h>
+#endif
+
+namespace zenremote {
+
+namespace {
+
+uint8_t TypePreference(IceCandidateType type) {
+  switch (type) {
+    case IceCandidateType::kHost:
+      return 126;
+    case IceCandidateType::kPeerReflexive:
+      return 110;
+    case IceCandidateType::kRelay:
+      return 0;
+  }
+  return 0;
+}
+
+bool IsLinkLocalIpv6(const in6_addr& address) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(&address);
+  return bytes[0] == 0xFE && (bytes[1] & 0xC0) == 0x80;
+}
+
+// 格式化地址；不支持的地址族或链路本地 IPv6 返回空串
+std::string FormatAddress(const sockaddr* addr,
+                          bool enable_ipv4,
+                          bool enable_ipv6) {
+  char text[INET6_ADDRSTRLEN] = {};
+  if (addr->sa_family == AF_INET && enable_ipv4) {
+    const auto* addr4 = reinterpret_cast<const sockaddr_in*>(addr);
+    inet_ntop(AF_INET, &addr4->sin_addr, text, sizeof(text));
+  } else if (addr->sa_family == AF_INET6 && enable_ipv6) {
+    const auto* addr6 = reinterpret_cast<const sockaddr_in6*>(addr);
+    if (IsLinkLocalIpv6(addr6->sin6_addr)) {
+      return {};
+    }
+    inet_ntop(AF_INET6, &addr6->sin6_addr, text, sizeof(text));
+  }
+  return text;
+}
+
+}  // namespace
+
+uint32_t ComputeCandidatePriority(IceCandidateType type,
+                                  uint16_t local_preference,
+                                  uint8_t component_id) {
+  return (static_cast<uint32_t>(TypePreference(type)) << 24U) |
+         (static_cast<uint32_t>(local_preference) << 8U) |
+         static_cast<uint32_t>(256U - component_id);
+}
+
+uint64_t ComputePairPriority(uint32_t controlling_priority,
+                             uint32_t controlled_priority) {
+  const uint64_t g = controlling_priority;
+  const uint64_t d = controlled_priority;
+  return (std::min(g, d) << 32U) + 2 * std::max(g, d) + (g > d ? 1 : 0);
+}
+
+bool IsLoopbackAddress(const std::string& address) {
+  return address.rfind("127.", 0) == 0 || address == "::1";
+}
+
+std::string GenerateIcePassword() {
+  // ice-char = ALPHA / DIGIT / "+" / "/"，每个字符 6 位随机性
+  static constexpr char kIceChars[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::random_device random;
+  std::string password(kIcePasswordLength, '\0');
+  for (auto& c : password) {
+    c = kIceChars[random() % 64];
+  }
+  return password;
+}
+
+std::vector<HostAddress> EnumerateHostAddresses(bool enable_ipv4,
+                                                bool enable_ipv6) {
+  std::vector<HostAddress> addresses;
+
+#ifdef _WIN32
+  ULONG size = 16 * 1024;
+  std::vector<uint8_t> buffer(size);
+  auto* adapters = reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data());
+  const ULONG flags = GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST |
+                      GAA_FLAG_SKIP_DNS_SERVER;
+  ULONG ret = GetAdaptersAddresses(AF_UNSPEC, flags, nullptr, adapters, &size);
+  if (ret == ERROR_BUFFER_OVERFLOW) {
+    buffer.resize(size);
+    adapters = reinterpret_cast<IP_ADAPTER_ADDRESSES*>(buffer.data());
+    ret = GetAdaptersAddresses(AF_UNSPEC, flags, nullptr, adapters, &size);
+  }
+  if (ret != NO_ERROR) {
+    return addresses;
+  }
+  for (auto* adapter = adapters; adapter; adapter = adapter->Next) {
+    if (adapter->OperStatus != IfOperStatusUp) {
+      continue;
+    }
+    const bool loopback = adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK;
+    for (auto* unicast = adapter->FirstUnicastAddress; unicast;
+         unicast = unicast->Next) {
+      std::string text = FormatAddress(unicast->Address.lpSockaddr,
+                                       enable_ipv4, enable_ipv6);
+      if (!text.empty()) {
+        addresses.push_back({std::move(text), adapter->AdapterName, loopback});
+      }
+    }
+  }
+#else
+  ifaddrs* interfaces = nullptr;
+  if (getifaddrs(&interfaces) != 0) {
+    return addresses;
+  }
+  for (ifaddrs* it = interfaces; it; it = it->ifa_next) {
+    if (!it->ifa_addr || !(it->ifa_flags & IFF_UP)) {
+      continue;
+    }
+    std::string text = FormatAddress(it->ifa_addr, enable_ipv4, enable_ipv6);
+    if (!text.empty()) {
+      addresses.push_back({std::move(text), it->ifa_name,
+                           (it->ifa_flags & IFF_LOOPBACK) != 0});
+    }
+  }
+  freeifaddrs(interfaces);
+#endif
+
+  std::stable_partition(addresses.begin(), addresses.end(),
+                        [](const HostAddress& host) { return !host.loopback; });
+  return addresses;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "network/io/endpoint.h"
+
+namespace zenremote {
+
+/**
+ * @brief ICE 候选类型（RFC 8445 5.1.2.2 的类型偏好）
+ */
+enum class IceCandidateType : uint8_t {
+  kHost,            ///< 本机网卡地址
+  kPeerReflexive,   ///< 对端从未知地址发来检查时学到的候选
+  kRelay,           ///< TURN 中继
+};
+
+/**
+ * @brief ICE 候选
+ */
+struct IceCandidate {
+  IceCandidateType type = IceCandidateType::kHost;
+  Endpoint address;            ///< 中继候选为空（经中继连接收发）
+  uint32_t priority = 0;
+  std::string interface_name;  ///< 网卡名，仅用于日志
+  bool loopback = false;
+};
+
+/**
+ * @brief 本机网卡地址
+ */
+struct HostAddress {
+  std::string address;
+  std::string interface_name;
+  bool loopback = false;
+};
+
+/**
+ * @brief 候选优先级（RFC 8445 5.1.2.1）
+ *
+ * priority = 2^24 * type_pref + 2^8 * local_pref + (256 - component_id)
+ */
+uint32_t ComputeCandidatePriority(IceCandidateType type,
+                                  uint16_t local_preference,
+                                  uint8_t component_id = 1);
+
+/**
+ * @brief 候选对优先级（RFC 8445 6.1.2.3）
+ *
+ * 2^32 * MIN(G, D) + 2 * MAX(G, D) + (G > D ? 1 : 0)，G 为控制方候选优先级
+ */
+uint64_t ComputePairPriority(uint32_t controlling_priority,
+                             uint32_t controlled_priority);
+
+bool IsLoopbackAddress(const std::string& address);
+
+/// @brief ICE 密码长度（RFC 8445 5.3 要求至少 128 位随机性）
+constexpr size_t kIcePasswordLength = 24;
+
+/**
+ * @brief 生成每会话 ICE 密码（ice-char 字符集，std::random_device）
+ *
+ * 与候选一起交给对端，用作连通性检查 MESSAGE-INTEGRITY 的短期凭据。
+ */
+std::string GenerateIcePassword();
+
+/**
+ * @brief 枚举本机处于 UP 状态的网卡地址
+ *
+ * 跳过 IPv6 链路本地地址（fe80::/10，需要 scope id 才能使用）。
+ * 回环地址排在最后，便于按顺序分配优先级时优先选择真实网卡。
+ */
+std::vector<HostAddress> EnumerateHostAddresses(bool enable_ipv4,
+                                                bool enable_ipv6);
+
+}  // namespace zenremote
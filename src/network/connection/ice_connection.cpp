@@ -0,0 +1,886 @@
+#include "network/connection/ice_connection.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/log_manager.h"
+
+namespace zenremote {
+
+namespace {
+
+constexpr size_t kMaxDatagramSize = 65536;
+// Open() 期间缓存的数据报文上限，超出丢弃（对端的可靠传输会重传）
+constexpr size_t kMaxPendingData = 256;
+// 超过该时长仍未响应的事务不再等待，避免事务表无限增长
+constexpr auto kTransactionLifetime = std::chrono::seconds(5);
+// 连续无响应时重传间隔翻倍的上限 (2^kMaxBackoffShift)
+constexpr int kMaxBackoffShift = 4;
+// 没有任何检查需要发送时的检查线程等待时长上限
+constexpr auto kIdleCheckInterval = std::chrono::seconds(1);
+
+double ToMs(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+const char* CandidateTypeName(IceCandidateType type) {
+  switch (type) {
+    case IceCandidateType::kHost:
+      return "host";
+    case IceCandidateType::kPeerReflexive:
+      return "prflx";
+    case IceCandidateType::kRelay:
+      return "relay";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+IceConnection::IceConnection() = default;
+
+IceConnection::~IceConnection() {
+  Shutdown();
+}
+
+Result<void> IceConnection::Initialize(const Config& config) {
+  if (initialized_) {
+    return Result<void>::Err(ErrorCode::kAlreadyInitialized,
+                             "IceConnection already initialized");
+  }
+  if (config.remote_candidates.empty()) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "No remote candidates");
+  }
+  if (config.local_password.empty() != config.remote_password.empty()) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "ICE passwords must be set on both sides");
+  }
+
+  config_ = config;
+  // 短期凭据的密钥就是密码本身（RFC 8489 9.1.1）
+  local_key_.assign(config_.local_password.begin(),
+                    config_.local_password.end());
+  remote_key_.assign(config_.remote_password.begin(),
+                     config_.remote_password.end());
+  std::random_device device;
+  std::seed_seq seed{device(), device(), device(), device()};
+  rng_.seed(seed);
+  tie_breaker_ = rng_();
+  controlling_ = true;
+
+  std::vector<HostAddress> hosts;
+  if (config_.local_addresses.empty()) {
+    hosts = EnumerateHostAddresses(config_.enable_ipv4, config_.enable_ipv6);
+  } else {
+    for (const auto& address : config_.local_addresses) {
+      const bool ipv6 = IsIpv6Address(address);
+      if ((ipv6 && config_.enable_ipv6) || (!ipv6 && config_.enable_ipv4)) {
+        hosts.push_back({address, "", IsLoopbackAddress(address)});
+      }
+    }
+  }
+
+  // 按收集顺序递减本地偏好，靠前的地址（真实网卡）优先检查
+  uint16_t local_preference = 0xFFFF;
+  for (const auto& host : hosts) {
+    if (locals_.size() >= EventPoller::kMaxHandles) {
+      ZENREMOTE_WARN(LOG_MODULE_NETWORK,
+                     "Too many local addresses, ignoring {} and later",
+                     host.address);
+      break;
+    }
+    UdpSocket::Config socket_config;
+    socket_config.local_ip = host.address;
+    socket_config.local_port = config_.local_port;
+    socket_config.socket_buffer_size = config_.socket_buffer_size;
+    socket_config.recv_timeout_ms = 0;
+    auto socket = std::make_unique<UdpSocket>(socket_config);
+    if (!socket->Open()) {
+      ZENREMOTE_WARN(LOG_MODULE_NETWORK, "Skipping local candidate {}",
+                     host.address);
+      continue;
+    }
+
+    LocalCandidate local;
+    local.candidate.type = IceCandidateType::kHost;
+    local.candidate.address = {host.address, socket->GetLocalPort()};
+    local.candidate.priority =
+        ComputeCandidatePriority(IceCandidateType::kHost, local_preference--);
+    local.candidate.interface_name = host.interface_name;
+    local.candidate.loopback = host.loopback;
+    local.socket = std::move(socket);
+    locals_.push_back(std::move(local));
+  }
+
+  if (locals_.empty()) {
+    return Result<void>::Err(ErrorCode::kSocketBindFailed,
+                             "No usable local candidate");
+  }
+
+  auto poller_result = poller_.Open();
+  if (poller_result.IsErr()) {
+    locals_.clear();
+    return poller_result;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < locals_.size(); ++i) {
+      FormPairsLocked(i);
+    }
+    stop_checker_ = false;
+  }
+  initialized_ = true;
+
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK,
+                 "IceConnection initialized: {} local candidates, {} pairs",
+                 locals_.size(), pairs_.size());
+  return Result<void>::Ok();
+}
+
+void IceConnection::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_checker_ = true;
+  }
+  checker_cv_.notify_all();
+  if (checker_thread_.joinable()) {
+    checker_thread_.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    open_ = false;
+    send_path_ = {};
+  }
+
+  for (auto& local : locals_) {
+    if (local.socket) {
+      local.socket->Close();
+    }
+    if (local.relay) {
+      local.relay->Close();
+    }
+  }
+  locals_.clear();
+  poller_.Close();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  pairs_.clear();
+  triggered_checks_.clear();
+  peer_reflexive_pairs_ = 0;
+  transactions_.clear();
+  selected_pair_.reset();
+  nominating_pair_.reset();
+  has_success_ = false;
+  pending_data_.clear();
+  has_pending_data_ = false;
+  next_read_index_ = 0;
+  stats_ = {};
+  initialized_ = false;
+}
+
+Result<void> IceConnection::AddRelayCandidate(
+    std::unique_ptr<BaseConnection> relay) {
+  if (!initialized_ || IsOpen()) {
+    return Result<void>::Err(ErrorCode::kInvalidState,
+                             "Relay candidate must be added before Open()");
+  }
+  if (!relay || !relay->IsOpen()) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Relay connection not open");
+  }
+  if (locals_.size() + relay->GetPollHandles().size() >
+      EventPoller::kMaxHandles) {
+    return Result<void>::Err(ErrorCode::kInvalidOperation,
+                             "Too many local candidates");
+  }
+
+  LocalCandidate local;
+  local.candidate.type = IceCandidateType::kRelay;
+  local.candidate.priority =
+      ComputeCandidatePriority(IceCandidateType::kRelay, 0xFFFF);
+  local.relay = std::move(relay);
+  locals_.push_back(std::move(local));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // 中继只有一条路径：经中继连接发往对端
+  AddPairLocked(locals_.size() - 1, Endpoint{},
+                ComputeCandidatePriority(IceCandidateType::kRelay, 0xFFFF));
+  return Result<void>::Ok();
+}
+
+Result<void> IceConnection::Open() {
+  if (!initialized_) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "IceConnection not initialized");
+  }
+  if (IsOpen()) {
+    return Result<void>::Ok();
+  }
+
+  const auto start = Clock::now();
+  const auto deadline =
+      start + std::chrono::milliseconds(config_.connect_timeout_ms);
+  const std::vector<socket_t> handles = GetPollHandles();
+  std::vector<uint8_t> buffer(kMaxDatagramSize);
+
+  while (true) {
+    Clock::time_point next;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto now = Clock::now();
+      if (!selected_pair_ && now >= deadline && !controlling_) {
+        // 对端迟迟不提名：受控方退而选择自己测得的最快路径
+        std::optional<size_t> best;
+        for (size_t i = 0; i < pairs_.size(); ++i) {
+          if (pairs_[i].state == PairState::kSucceeded &&
+              (!best || pairs_[i].srtt_ms < pairs_[*best].srtt_ms)) {
+            best = i;
+          }
+        }
+        if (best) {
+          SelectPairLocked(*best);
+        }
+      }
+      if (selected_pair_) {
+        stats_.setup_time_ms = ToMs(now - start);
+        break;
+      }
+      if (now >= deadline) {
+        return Result<void>::Err(ErrorCode::kConnectionTimeout,
+                                 "ICE connectivity checks timed out");
+      }
+      next = std::min(ProcessChecksLocked(now), deadline);
+    }
+
+    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next - Clock::now() + std::chrono::microseconds(999));
+    auto readable =
+        poller_.Wait(handles, static_cast<int>(std::max<int64_t>(
+                                  0, static_cast<int64_t>(wait.count()))));
+    if (readable.IsErr()) {
+      return Result<void>::Err(readable.Code(), readable.Message());
+    }
+    if (!readable.Value()) {
+      continue;
+    }
+
+    // 对端可能先完成检查并开始发送数据，先缓存起来交给之后的 Recv()
+    while (const size_t length = ReadAvailable(buffer.data(), buffer.size())) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (pending_data_.size() < kMaxPendingData) {
+        pending_data_.emplace_back(buffer.begin(), buffer.begin() + length);
+        has_pending_data_ = true;
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    open_ = true;
+  }
+  checker_thread_ = std::thread([this]() { CheckerThread(); });
+
+  auto path = GetSelectedPath();
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK,
+                 "IceConnection open in {:.2f} ms: {} {}:{} -> {}:{}, "
+                 "rtt {:.3f} ms, role {}",
+                 stats_.setup_time_ms, CandidateTypeName(path->local.type),
+                 path->local.address.address, path->local.address.port,
+                 path->remote.address, path->remote.port, path->rtt_ms,
+                 IsControlling() ? "controlling" : "controlled");
+  return Result<void>::Ok();
+}
+
+void IceConnection::Close() {
+  Shutdown();
+}
+
+bool IceConnection::IsOpen() const {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  return open_;
+}
+
+Result<size_t> IceConnection::Send(const uint8_t* data, size_t length) {
+  if (!data || length == 0) {
+    return Result<size_t>::Err(ErrorCode::kInvalidParameter,
+                               "Invalid send parameters");
+  }
+
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  if (!open_) {
+    return Result<size_t>::Err(ErrorCode::kNotInitialized,
+                               "IceConnection not open");
+  }
+  const bool sent =
+      send_path_.socket
+          ? send_path_.socket->SendTo(data, length, send_path_.remote.address,
+                                      send_path_.remote.port)
+          : send_path_.relay->Send(data, length).IsOk();
+  if (!sent) {
+    return Result<size_t>::Err(ErrorCode::kSocketSendFailed, "Send failed");
+  }
+  return Result<size_t>::Ok(length);
+}
+
+Result<size_t> IceConnection::Recv(uint8_t* buffer,
+                                   size_t buffer_size,
+                                   int timeout_ms) {
+  if (!initialized_) {
+    return Result<size_t>::Err(ErrorCode::kNotInitialized,
+                               "IceConnection not initialized");
+  }
+  if (!buffer || buffer_size == 0) {
+    return Result<size_t>::Err(ErrorCode::kInvalidParameter,
+                               "Invalid receive parameters");
+  }
+
+  if (has_pending_data_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_data_.empty()) {
+      const auto& data = pending_data_.front();
+      const size_t length = std::min(buffer_size, data.size());
+      std::memcpy(buffer, data.data(), length);
+      pending_data_.pop_front();
+      has_pending_data_ = !pending_data_.empty();
+      return Result<size_t>::Ok(length);
+    }
+  }
+
+  const auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (true) {
+    const size_t length = ReadAvailable(buffer, buffer_size);
+    if (length > 0) {
+      return Result<size_t>::Ok(length);
+    }
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(deadline -
+                                                              Clock::now());
+    if (timeout_ms <= 0 || remaining.count() <= 0) {
+      return Result<size_t>::Err(ErrorCode::kTimeout, "Receive timeout");
+    }
+    auto readable = poller_.Wait(GetPollHandles(),
+                                 static_cast<int>(remaining.count()));
+    if (readable.IsErr()) {
+      return Result<size_t>::Err(readable.Code(), readable.Message());
+    }
+  }
+}
+
+ConnectionType IceConnection::GetType() const {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  return send_path_.relay ? ConnectionType::kRelay : ConnectionType::kDirect;
+}
+
+std::vector<socket_t> IceConnection::GetPollHandles() const {
+  std::vector<socket_t> handles;
+  for (const auto& local : locals_) {
+    if (local.socket) {
+      handles.push_back(local.socket->GetHandle());
+    } else if (local.relay) {
+      auto relay_handles = local.relay->GetPollHandles();
+      handles.insert(handles.end(), relay_handles.begin(),
+                     relay_handles.end());
+    }
+  }
+  return handles;
+}
+
+int IceConnection::ProcessTimers() {
+  int delay = -1;
+  for (auto& local : locals_) {
+    if (!local.relay) {
+      continue;
+    }
+    const int relay_delay = local.relay->ProcessTimers();
+    if (relay_delay >= 0 && (delay < 0 || relay_delay < delay)) {
+      delay = relay_delay;
+    }
+  }
+  return delay;
+}
+
+std::vector<IceCandidate> IceConnection::GetLocalCandidates() const {
+  std::vector<IceCandidate> candidates;
+  for (const auto& local : locals_) {
+    candidates.push_back(local.candidate);
+  }
+  return candidates;
+}
+
+std::optional<IceConnection::PathInfo> IceConnection::GetSelectedPath() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!selected_pair_) {
+    return std::nullopt;
+  }
+  const auto& pair = pairs_[*selected_pair_];
+  PathInfo path;
+  path.local = locals_[pair.local_index].candidate;
+  path.remote = pair.remote;
+  path.rtt_ms = std::max(0.0, pair.srtt_ms);
+  return path;
+}
+
+bool IceConnection::IsControlling() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return controlling_;
+}
+
+IceConnection::Stats IceConnection::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.local_candidates = locals_.size();
+  stats.candidate_pairs = pairs_.size();
+  stats.succeeded_pairs = static_cast<size_t>(
+      std::count_if(pairs_.begin(), pairs_.end(), [](const auto& pair) {
+        return pair.state == PairState::kSucceeded;
+      }));
+  return stats;
+}
+
+void IceConnection::FormPairsLocked(size_t local_index) {
+  const auto& local = locals_[local_index].candidate;
+  for (size_t i = 0; i < config_.remote_candidates.size(); ++i) {
+    const auto& remote = config_.remote_candidates[i];
+    // 只配对同一地址族；回环地址只与回环地址配对
+    if (IsIpv6Address(remote.address) != IsIpv6Address(local.address.address) ||
+        IsLoopbackAddress(remote.address) != local.loopback) {
+      continue;
+    }
+    const auto remote_preference =
+        static_cast<uint16_t>(0xFFFF - std::min<size_t>(i, 0xFFFF));
+    AddPairLocked(local_index, remote,
+                  ComputeCandidatePriority(IceCandidateType::kHost,
+                                           remote_preference));
+  }
+}
+
+size_t IceConnection::AddPairLocked(size_t local_index,
+                                    const Endpoint& remote,
+                                    uint32_t remote_priority) {
+  CandidatePair pair;
+  pair.local_index = local_index;
+  pair.remote = remote;
+  pair.remote_priority = remote_priority;
+  // 本地只用它决定检查顺序，双方各自以自己的候选作为 G 即可
+  pair.priority = ComputePairPriority(locals_[local_index].candidate.priority,
+                                      remote_priority);
+  pairs_.push_back(pair);
+  return pairs_.size() - 1;
+}
+
+std::optional<size_t> IceConnection::FindPairLocked(
+    size_t local_index,
+    const Endpoint& remote) const {
+  for (size_t i = 0; i < pairs_.size(); ++i) {
+    if (pairs_[i].local_index == local_index && pairs_[i].remote == remote) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+IceConnection::Clock::time_point IceConnection::ProcessChecksLocked(
+    Clock::time_point now) {
+  for (auto it = transactions_.begin(); it != transactions_.end();) {
+    it = now - it->second.sent_at > kTransactionLifetime
+             ? transactions_.erase(it)
+             : std::next(it);
+  }
+
+  EvaluateNominationLocked(now);
+
+  const auto pacing = std::chrono::milliseconds(config_.check_interval_ms);
+  if (now - last_check_sent_ >= pacing) {
+    std::optional<size_t> pick;
+    if (!triggered_checks_.empty()) {
+      pick = triggered_checks_.front();
+      triggered_checks_.pop_front();
+    } else {
+      // 先建立连通性（等待/进行中），再做后台复测；同类按优先级
+      auto rank = [this](size_t index) {
+        const auto state = pairs_[index].state;
+        const bool establishing =
+            state == PairState::kWaiting || state == PairState::kInProgress;
+        return std::make_pair(establishing, pairs_[index].priority);
+      };
+      for (size_t i = 0; i < pairs_.size(); ++i) {
+        if (pairs_[i].next_check <= now && (!pick || rank(i) > rank(*pick))) {
+          pick = i;
+        }
+      }
+    }
+    if (pick) {
+      SendCheckLocked(*pick, now);
+      last_check_sent_ = now;
+    }
+  }
+
+  const auto next_slot = last_check_sent_ + pacing;
+  if (!triggered_checks_.empty()) {
+    return next_slot;
+  }
+  auto next = now + kIdleCheckInterval;
+  for (const auto& pair : pairs_) {
+    next = std::min(next, pair.next_check);
+  }
+  if (controlling_ && !selected_pair_ && has_success_ && !nominating_pair_) {
+    next = std::min(
+        next, first_success_ + std::chrono::milliseconds(
+                                   config_.nomination_wait_ms));
+  }
+  return std::max(next, next_slot);
+}
+
+void IceConnection::SendCheckLocked(size_t pair_index, Clock::time_point now) {
+  auto& pair = pairs_[pair_index];
+
+  if (pair.state == PairState::kFailed) {
+    // 失败路径低频重试，响应到达后重新计入候选
+    pair.next_check = now + std::chrono::milliseconds(
+                                config_.recheck_interval_ms);
+  } else if (pair.unanswered >= config_.max_check_attempts) {
+    pair.state = PairState::kFailed;
+    pair.unanswered = 0;
+    pair.srtt_ms = -1.0;
+    pair.next_check = now + std::chrono::milliseconds(
+                                config_.recheck_interval_ms);
+    if (nominating_pair_ == pair_index) {
+      nominating_pair_.reset();
+    }
+    ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "ICE pair {} -> {}:{} failed",
+                    locals_[pair.local_index].candidate.address.address,
+                    pair.remote.address, pair.remote.port);
+    return;
+  } else {
+    if (pair.state == PairState::kWaiting) {
+      pair.state = PairState::kInProgress;
+    }
+    const int shift = std::min(pair.unanswered, kMaxBackoffShift);
+    pair.next_check =
+        now + std::chrono::milliseconds(config_.check_rto_ms << shift);
+  }
+  pair.unanswered++;
+
+  const bool use_candidate = controlling_ && nominating_pair_ == pair_index;
+  StunMessage request;
+  request.message_class = StunClass::kRequest;
+  request.transaction_id = NewTransactionIdLocked();
+  request.AddUint32(StunAttributeType::kPriority,
+                    locals_[pair.local_index].candidate.priority);
+  request.AddUint64(controlling_ ? StunAttributeType::kIceControlling
+                                 : StunAttributeType::kIceControlled,
+                    tie_breaker_);
+  if (use_candidate) {
+    request.AddFlag(StunAttributeType::kUseCandidate);
+  }
+
+  transactions_[request.transaction_id] = {pair_index, now, use_candidate};
+  SendStunLocked(pair.local_index, pair.remote, request, remote_key_);
+  stats_.checks_sent++;
+}
+
+void IceConnection::EvaluateNominationLocked(Clock::time_point now) {
+  if (!controlling_) {
+    return;
+  }
+  if (nominating_pair_) {
+    return;  // 等待提名检查的结果
+  }
+
+  std::optional<size_t> best;
+  bool establishing = false;
+  for (size_t i = 0; i < pairs_.size(); ++i) {
+    const auto& pair = pairs_[i];
+    establishing = establishing || pair.state == PairState::kWaiting ||
+                   pair.state == PairState::kInProgress;
+    if (pair.state == PairState::kSucceeded &&
+        (!best || pair.srtt_ms < pairs_[*best].srtt_ms)) {
+      best = i;
+    }
+  }
+  if (!best || best == selected_pair_) {
+    return;
+  }
+
+  if (!selected_pair_) {
+    // 其他路径仍在检查时，给它们一点时间追上首个成功的路径
+    if (establishing &&
+        now < first_success_ +
+                  std::chrono::milliseconds(config_.nomination_wait_ms)) {
+      return;
+    }
+  } else {
+    const auto& current = pairs_[*selected_pair_];
+    const double candidate_rtt = pairs_[*best].srtt_ms;
+    const bool current_lost = current.state != PairState::kSucceeded;
+    const bool much_faster =
+        candidate_rtt < current.srtt_ms * config_.switch_rtt_ratio &&
+        current.srtt_ms - candidate_rtt >= config_.min_switch_gain_ms;
+    if (!current_lost && !much_faster) {
+      return;
+    }
+  }
+
+  nominating_pair_ = best;
+  triggered_checks_.push_front(*best);
+}
+
+void IceConnection::SelectPairLocked(size_t pair_index) {
+  if (selected_pair_ == pair_index) {
+    return;
+  }
+  if (selected_pair_) {
+    stats_.path_switches++;
+  }
+  selected_pair_ = pair_index;
+
+  const auto& pair = pairs_[pair_index];
+  auto& local = locals_[pair.local_index];
+  {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    send_path_.socket = local.socket.get();
+    send_path_.relay = local.relay.get();
+    send_path_.remote = pair.remote;
+  }
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK,
+                 "ICE path selected: {} {}:{} -> {}:{} (rtt {:.3f} ms)",
+                 CandidateTypeName(local.candidate.type),
+                 local.candidate.address.address, local.candidate.address.port,
+                 pair.remote.address, pair.remote.port,
+                 std::max(0.0, pair.srtt_ms));
+}
+
+bool IceConnection::HandleIncomingLocked(size_t local_index,
+                                         const uint8_t* data,
+                                         size_t length,
+                                         const Endpoint& from) {
+  if (!IsStunMessage(data, length)) {
+    return false;
+  }
+  auto message = ParseStunMessage(data, length);
+  if (!message || !message->IsBinding()) {
+    return true;  // 格式错误或不认识的 STUN 消息直接丢弃
+  }
+  const bool is_request = message->message_class == StunClass::kRequest;
+  bool authenticated = false;
+  if (!local_key_.empty()) {
+    // MESSAGE-INTEGRITY 之后的属性不受保护，要求它是最后一个属性
+    const auto& key = is_request ? local_key_ : remote_key_;
+    if (message->attributes.empty() ||
+        message->attributes.back().type !=
+            static_cast<uint16_t>(StunAttributeType::kMessageIntegrity) ||
+        !VerifyStunMessageIntegrity(data, length, key)) {
+      stats_.checks_rejected++;
+      ZENREMOTE_DEBUG(LOG_MODULE_NETWORK,
+                      "Dropping unauthenticated ICE check from {}:{}",
+                      from.address, from.port);
+      return true;
+    }
+    authenticated = true;
+  }
+  switch (message->message_class) {
+    case StunClass::kRequest:
+      HandleRequestLocked(local_index, *message, from, authenticated);
+      break;
+    case StunClass::kSuccessResponse:
+      HandleResponseLocked(*message);
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+void IceConnection::HandleRequestLocked(size_t local_index,
+                                        const StunMessage& request,
+                                        const Endpoint& from,
+                                        bool authenticated) {
+  // 中继路径的对端地址由中继决定，统一记为空
+  const Endpoint remote = locals_[local_index].relay ? Endpoint{} : from;
+  auto pair_index = FindPairLocked(local_index, remote);
+  if (!pair_index) {
+    // 只有认证的请求才能带来新候选，且数量有上限，否则任何主机都能
+    // 让这里无限增加需要反复检查的候选对
+    if (!authenticated ||
+        peer_reflexive_pairs_ >= config_.max_peer_reflexive_pairs) {
+      stats_.checks_rejected++;
+      ZENREMOTE_DEBUG(LOG_MODULE_NETWORK,
+                      "Ignoring ICE check from unknown address {}:{}",
+                      from.address, from.port);
+      return;
+    }
+    const uint32_t priority =
+        request.GetUint32(StunAttributeType::kPriority)
+            .value_or(ComputeCandidatePriority(IceCandidateType::kPeerReflexive,
+                                               0));
+    pair_index = AddPairLocked(local_index, remote, priority);
+    peer_reflexive_pairs_++;
+    ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "ICE peer-reflexive candidate {}:{}",
+                    remote.address, remote.port);
+  }
+
+  stats_.checks_received++;
+  // 未认证的请求可能来自伪造源地址：路径选定后不再让它改变角色或提名
+  const bool trusted = authenticated || !selected_pair_;
+  if (trusted) {
+    ResolveRoleLocked(request);
+  }
+
+  StunMessage response;
+  response.message_class = StunClass::kSuccessResponse;
+  response.transaction_id = request.transaction_id;
+  if (!from.address.empty()) {
+    response.AddXorAddress(StunAttributeType::kXorMappedAddress, from);
+  }
+  response.AddUint64(controlling_ ? StunAttributeType::kIceControlling
+                                  : StunAttributeType::kIceControlled,
+                     tie_breaker_);
+  SendStunLocked(local_index, from, response, local_key_);
+
+  // 对端能到达这里，反方向很可能也通：立即触发一次检查
+  auto& pair = pairs_[*pair_index];
+  if (pair.state == PairState::kWaiting || pair.state == PairState::kFailed) {
+    pair.state = PairState::kWaiting;
+    pair.unanswered = 0;
+    if (std::find(triggered_checks_.begin(), triggered_checks_.end(),
+                  *pair_index) == triggered_checks_.end()) {
+      triggered_checks_.push_back(*pair_index);
+      checker_cv_.notify_one();
+    }
+  }
+
+  if (trusted && request.Has(StunAttributeType::kUseCandidate) &&
+      !controlling_) {
+    SelectPairLocked(*pair_index);
+  }
+}
+
+void IceConnection::HandleResponseLocked(const StunMessage& response) {
+  auto it = transactions_.find(response.transaction_id);
+  if (it == transactions_.end()) {
+    return;  // 过期或伪造的响应
+  }
+  const Transaction transaction = it->second;
+  transactions_.erase(it);
+  stats_.responses_received++;
+  ResolveRoleLocked(response);
+
+  const auto now = Clock::now();
+  auto& pair = pairs_[transaction.pair_index];
+  const double sample_ms = ToMs(now - transaction.sent_at);
+  pair.srtt_ms = pair.srtt_ms < 0 ? sample_ms
+                                  : 0.875 * pair.srtt_ms + 0.125 * sample_ms;
+  pair.state = PairState::kSucceeded;
+  pair.unanswered = 0;
+  pair.next_check =
+      now + std::chrono::milliseconds(config_.keepalive_interval_ms);
+
+  if (!has_success_) {
+    has_success_ = true;
+    first_success_ = now;
+  }
+  if (transaction.use_candidate && controlling_ &&
+      nominating_pair_ == transaction.pair_index) {
+    nominating_pair_.reset();
+    SelectPairLocked(transaction.pair_index);
+  }
+  // 新的 RTT 可能改变提名结果
+  checker_cv_.notify_one();
+}
+
+void IceConnection::ResolveRoleLocked(const StunMessage& message) {
+  if (auto peer = message.GetUint64(StunAttributeType::kIceControlling)) {
+    if (controlling_ && tie_breaker_ < *peer) {
+      controlling_ = false;
+      nominating_pair_.reset();
+      ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "ICE role: controlled");
+    }
+  } else if (auto peer = message.GetUint64(StunAttributeType::kIceControlled)) {
+    if (!controlling_ && tie_breaker_ > *peer) {
+      controlling_ = true;
+      ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "ICE role: controlling");
+    }
+  }
+}
+
+void IceConnection::SendStunLocked(size_t local_index,
+                                   const Endpoint& remote,
+                                   const StunMessage& message,
+                                   const std::vector<uint8_t>& key) {
+  const auto bytes =
+      key.empty() ? SerializeStunMessage(message)
+                  : SerializeStunMessage(message, key);
+  auto& local = locals_[local_index];
+  if (local.socket) {
+    local.socket->SendTo(bytes.data(), bytes.size(), remote.address,
+                         remote.port);
+  } else if (local.relay) {
+    local.relay->Send(bytes.data(), bytes.size());
+  }
+}
+
+size_t IceConnection::ReadAvailable(uint8_t* buffer, size_t buffer_size) {
+  const size_t count = locals_.size();
+  size_t index = next_read_index_ % count;
+  size_t idle = 0;
+  // 从上次收到数据的候选开始读，选定路径上的数据只需一次尝试
+  while (idle < count) {
+    auto& local = locals_[index];
+    size_t received = 0;
+    Endpoint from;
+    if (local.socket) {
+      received = buffer_size;
+      if (!local.socket->RecvFrom(buffer, received, from.address, from.port,
+                                  0)) {
+        received = 0;
+      }
+    } else if (local.relay) {
+      auto result = local.relay->Recv(buffer, buffer_size, 0);
+      received = result.IsOk() ? result.Value() : 0;
+    }
+
+    if (received == 0) {
+      idle++;
+      index = (index + 1) % count;
+      continue;
+    }
+    idle = 0;
+
+    bool consumed;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      consumed = HandleIncomingLocked(index, buffer, received, from);
+    }
+    if (!consumed) {
+      next_read_index_ = index;
+      return received;
+    }
+  }
+  return 0;
+}
+
+void IceConnection::CheckerThread() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_checker_) {
+    const auto next = ProcessChecksLocked(Clock::now());
+    // 响应或触发检查到来时被提前唤醒，重新计算下一次检查时间
+    checker_cv_.wait_until(lock, next);
+  }
+}
+
+StunTransactionId IceConnection::NewTransactionIdLocked() {
+  StunTransactionId id;
+  for (size_t i = 0; i < id.size(); i += 8) {
+    uint64_t value = rng_();
+    for (size_t j = i; j < std::min(id.size(), i + 8); ++j) {
+      id[j] = static_cast<uint8_t>(value);
+      value >>= 8U;
+    }
+  }
+  return id;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/error.h"
+#include "network/connection/base_connection.h"
+#include "network/connection/ice_candidate.h"
+#include "network/io/endpoint.h"
+#include "network/io/event_poller.h"
+#include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
+
+namespace zenremote {
+
+/**
+ * @brief 传输层实现 - 自动选路（ICE-lite 风格）
+ *
+ * 职责：
+ * - 收集候选：全部本机网卡地址（IPv4 + IPv6，每个地址一个 UdpSocket），
+ *   以及可选的中继候选（已打开的 TurnConnection）
+ * - 与对端候选两两配对，按候选对优先级以 check_interval_ms 的节奏并行发送
+ *   STUN Binding 检查，测量每条路径的 RTT
+ * - 控制方在首个检查成功后最多等待 nomination_wait_ms，提名 RTT 最低的路径
+ *   （带 USE-CANDIDATE 的检查成功即选定），受控方跟随对端的提名
+ * - Open() 返回后继续后台检查：已连通路径按 keepalive_interval_ms 复测 RTT，
+ *   失败路径按 recheck_interval_ms 重试；出现明显更快的路径时重新提名切换
+ *
+ * 角色由检查中携带的 64 位随机 tie-breaker 决定：双方初始都是控制方，
+ * 收到对端更大的 tie-breaker 后转为受控方。
+ *
+ * 认证：两端各自生成 ICE 密码（GenerateIcePassword()）与候选一起交换。
+ * 配置了密码时检查请求以对端密码、响应以本端密码计算 MESSAGE-INTEGRITY
+ * （RFC 8445 7.2.2 短期凭据），校验失败的报文直接丢弃；只有认证的请求能从
+ * 未配置的地址创建 peer-reflexive 候选（最多 max_peer_reflexive_pairs 个）。
+ * 未配置密码时只接受来自已配置对端候选的请求，选定路径后请求中的
+ * USE-CANDIDATE 与角色信息被忽略，受控方不再跟随对端的重新提名。
+ *
+ * 与完整 ICE 的区别：候选通过配置交换（没有信令通道），没有 STUN 服务器
+ * 反射候选，不使用 USERNAME 区分会话。
+ *
+ * 线程模型：Open() 在调用线程同步完成连通性检查；之后后台检查由内部线程
+ * 发送，检查响应由 Recv()（通常是 ReceiveLoop 线程）顺带处理，数据报文
+ * 原样返回给调用方。Send() 可在任意线程调用。
+ */
+class IceConnection : public BaseConnection {
+ public:
+  struct Config {
+    uint16_t local_port = 0;  ///< 所有本地候选使用的端口 (0 = 各自自动分配)
+    std::vector<std::string> local_addresses;  ///< 为空时枚举全部本机网卡
+    bool enable_ipv4 = true;
+    bool enable_ipv6 = true;
+    std::vector<Endpoint> remote_candidates;  ///< 对端候选，按优先级从高到低
+    int socket_buffer_size = 1024 * 1024;
+
+    int check_interval_ms = 5;       ///< Ta：相邻两次检查的最小间隔
+    int check_rto_ms = 100;          ///< 检查无响应时的重传间隔（逐次翻倍）
+    int max_check_attempts = 5;      ///< 连续无响应次数上限，超过判定路径失败
+    int nomination_wait_ms = 50;     ///< 首个检查成功后等待更优路径的最长时间
+    int keepalive_interval_ms = 500;  ///< 已连通路径的后台复测间隔
+    int recheck_interval_ms = 2000;   ///< 失败路径的后台重试间隔
+    double switch_rtt_ratio = 0.7;   ///< 新路径 RTT 低于当前路径该比例才切换
+    double min_switch_gain_ms = 1.0;  ///< 且至少快这么多，避免抖动造成来回切换
+    int connect_timeout_ms = 5000;
+
+    /// 短期凭据：本端与对端的 ICE 密码，两者都填写或都为空
+    std::string local_password;
+    std::string remote_password;
+    size_t max_peer_reflexive_pairs = 8;  ///< 认证请求最多学到的候选对数
+  };
+
+  /**
+   * @brief 选定路径
+   */
+  struct PathInfo {
+    IceCandidate local;
+    Endpoint remote;      ///< 中继路径为空
+    double rtt_ms = 0.0;  ///< 平滑 RTT
+  };
+
+  struct Stats {
+    uint64_t checks_sent = 0;
+    uint64_t checks_received = 0;
+    uint64_t responses_received = 0;
+    uint64_t path_switches = 0;   ///< 首次选定之后的切换次数
+    double setup_time_ms = 0.0;   ///< Open() 开始到选定路径的耗时
+    size_t local_candidates = 0;
+    size_t candidate_pairs = 0;
+    size_t succeeded_pairs = 0;
+    uint64_t checks_rejected = 0;  ///< 认证失败或来源未知而丢弃的请求/响应
+  };
+
+  IceConnection();
+  ~IceConnection();
+
+  IceConnection(const IceConnection&) = delete;
+  IceConnection& operator=(const IceConnection&) = delete;
+
+  /// @brief 收集本地候选并打开 socket，不发送任何数据
+  Result<void> Initialize(const Config& config);
+  void Shutdown();
+
+  /**
+   * @brief 添加中继候选（须在 Initialize 之后、Open 之前）
+   * @param relay 已打开的中继连接，经它发送的数据由中继转发给对端
+   */
+  Result<void> AddRelayCandidate(std::unique_ptr<BaseConnection> relay);
+
+  /// @brief 执行连通性检查，选定路径后返回；超时返回 kConnectionTimeout
+  Result<void> Open() override;
+  void Close() override;
+  bool IsOpen() const override;
+
+  Result<size_t> Send(const uint8_t* data, size_t length) override;
+  Result<size_t> Recv(uint8_t* buffer,
+                      size_t buffer_size,
+                      int timeout_ms) override;
+
+  ConnectionType GetType() const override;
+  std::vector<socket_t> GetPollHandles() const override;
+  /// @brief 转发给中继候选（TURN 分配刷新）
+  int ProcessTimers() override;
+
+  std::vector<IceCandidate> GetLocalCandidates() const;
+  std::optional<PathInfo> GetSelectedPath() const;
+  bool IsControlling() const;
+  Stats GetStats() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  enum class PairState : uint8_t {
+    kWaiting,
+    kInProgress,
+    kSucceeded,
+    kFailed,
+  };
+
+  struct LocalCandidate {
+    IceCandidate candidate;
+    std::unique_ptr<UdpSocket> socket;      ///< 本机候选
+    std::unique_ptr<BaseConnection> relay;  ///< 中继候选
+  };
+
+  struct CandidatePair {
+    size_t local_index = 0;
+    Endpoint remote;
+    uint32_t remote_priority = 0;
+    uint64_t priority = 0;
+    PairState state = PairState::kWaiting;
+    int unanswered = 0;              ///< 连续无响应的检查数
+    Clock::time_point next_check{};  ///< 下一次（重传或复测）检查时间
+    double srtt_ms = -1.0;
+  };
+
+  struct Transaction {
+    size_t pair_index = 0;
+    Clock::time_point sent_at{};
+    bool use_candidate = false;
+  };
+
+  /// @brief 发送路径快照，Send() 热路径只持有 send_mutex_
+  struct SendPath {
+    UdpSocket* socket = nullptr;
+    BaseConnection* relay = nullptr;
+    Endpoint remote;
+  };
+
+  void FormPairsLocked(size_t local_index);
+  size_t AddPairLocked(size_t local_index,
+                       const Endpoint& remote,
+                       uint32_t remote_priority);
+  std::optional<size_t> FindPairLocked(size_t local_index,
+                                       const Endpoint& remote) const;
+
+  /// @brief 发送到期的检查并评估提名，返回下一次需要处理的时间
+  Clock::time_point ProcessChecksLocked(Clock::time_point now);
+  void SendCheckLocked(size_t pair_index, Clock::time_point now);
+  void EvaluateNominationLocked(Clock::time_point now);
+  void SelectPairLocked(size_t pair_index);
+
+  /// @brief 处理收到的报文，STUN 消息在内部消费并返回 true
+  bool HandleIncomingLocked(size_t local_index,
+                            const uint8_t* data,
+                            size_t length,
+                            const Endpoint& from);
+  /// @param authenticated 请求通过了 MESSAGE-INTEGRITY 校验
+  void HandleRequestLocked(size_t local_index,
+                           const StunMessage& request,
+                           const Endpoint& from,
+                           bool authenticated);
+  void HandleResponseLocked(const StunMessage& response);
+  /// @brief 根据对端 tie-breaker 解决角色冲突
+  void ResolveRoleLocked(const StunMessage& message);
+  /// @param key 非空时追加 MESSAGE-INTEGRITY
+  void SendStunLocked(size_t local_index,
+                      const Endpoint& remote,
+                      const StunMessage& message,
+                      const std::vector<uint8_t>& key);
+
+  /// @brief 非阻塞读取所有候选 socket，返回第一个数据报文的长度，没有为 0
+  size_t ReadAvailable(uint8_t* buffer, size_t buffer_size);
+  void CheckerThread();
+  StunTransactionId NewTransactionIdLocked();
+
+  Config config_;
+  std::vector<uint8_t> local_key_;   ///< 校验收到的请求、签名发出的响应
+  std::vector<uint8_t> remote_key_;  ///< 签名发出的请求、校验收到的响应
+  bool initialized_ = false;
+  std::vector<LocalCandidate> locals_;
+  EventPoller poller_;  ///< Open() 与阻塞 Recv() 等待多个 socket
+
+  mutable std::mutex mutex_;  ///< 保护以下检查状态
+  std::vector<CandidatePair> pairs_;
+  std::deque<size_t> triggered_checks_;
+  size_t peer_reflexive_pairs_ = 0;
+  std::map<StunTransactionId, Transaction> transactions_;
+  std::optional<size_t> selected_pair_;
+  std::optional<size_t> nominating_pair_;
+  bool controlling_ = true;
+  uint64_t tie_breaker_ = 0;
+  Clock::time_point last_check_sent_{};
+  Clock::time_point first_success_{};
+  bool has_success_ = false;
+  std::deque<std::vector<uint8_t>> pending_data_;  ///< Open() 期间收到的数据
+  std::atomic<bool> has_pending_data_{false};
+  std::mt19937_64 rng_;
+  size_t next_read_index_ = 0;
+  Stats stats_;
+
+  mutable std::mutex send_mutex_;
+  SendPath send_path_;
+  bool open_ = false;
+
+  std::thread checker_thread_;
+  std::condition_variable checker_cv_;
+  bool stop_checker_ = false;
+};
+
+}  // namespace zenremote
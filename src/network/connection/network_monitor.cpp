@@ -0,0 +1,130 @@
+#include "network/connection/network_monitor.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include "common/log_manager.h"
+#include "network/connection/ice_candidate.h"
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if.h>
+#endif
+
+namespace zenremote {
+
+namespace {
+
+#ifndef __linux__
+std::vector<std::string> SnapshotAddresses() {
+  std::vector<std::string> addresses;
+  for (const auto& host : EnumerateHostAddresses(true, true)) {
+    addresses.push_back(host.interface_name + "|" + host.address);
+  }
+  std::sort(addresses.begin(), addresses.end());
+  return addresses;
+}
+#endif
+
+}  // namespace
+
+NetworkMonitor::NetworkMonitor() = default;
+
+NetworkMonitor::~NetworkMonitor() {
+  Close();
+}
+
+Result<void> NetworkMonitor::Open() {
+  if (open_) {
+    return Result<void>::Err(ErrorCode::kAlreadyInitialized,
+                             "NetworkMonitor already open");
+  }
+#ifdef __linux__
+  const int fd =
+      socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC,
+             NETLINK_ROUTE);
+  if (fd < 0) {
+    return Result<void>::Err(ErrorCode::kSocketError,
+                             "Failed to create netlink socket");
+  }
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+  if (bind(fd, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) < 0) {
+    close(fd);
+    return Result<void>::Err(ErrorCode::kSocketBindFailed,
+                             "Failed to subscribe to rtnetlink events");
+  }
+  handle_ = fd;
+#else
+  addresses_ = SnapshotAddresses();
+#endif
+  open_ = true;
+  ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "NetworkMonitor opened ({})",
+                  handle_ != kInvalidSocket ? "netlink" : "polling");
+  return Result<void>::Ok();
+}
+
+void NetworkMonitor::Close() {
+#ifdef __linux__
+  if (handle_ != kInvalidSocket) {
+    close(handle_);
+  }
+#endif
+  handle_ = kInvalidSocket;
+  addresses_.clear();
+  open_ = false;
+}
+
+bool NetworkMonitor::ReadChanges() {
+  if (!open_) {
+    return false;
+  }
+#ifdef __linux__
+  bool changed = false;
+  alignas(nlmsghdr) char buffer[8192];
+  while (true) {
+    const ssize_t received = recv(handle_, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+      // EAGAIN：已取完；ENOBUFS：内核队列溢出丢了事件，按有变化处理
+      if (received < 0 && errno == ENOBUFS) {
+        changed = true;
+        continue;
+      }
+      break;
+    }
+    int remaining = static_cast<int>(received);
+    for (auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+         NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+      switch (header->nlmsg_type) {
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+        case RTM_DELLINK:
+          changed = true;
+          break;
+        case RTM_NEWLINK: {
+          const auto* info = static_cast<const ifinfomsg*>(NLMSG_DATA(header));
+          if (info->ifi_change & (IFF_UP | IFF_RUNNING)) {
+            changed = true;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+  return changed;
+#else
+  auto current = SnapshotAddresses();
+  if (current == addresses_) {
+    return false;
+  }
+  addresses_ = std::move(current);
+  return true;
+#endif
+}
+
+}  // namespace zenremote
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+#include "network/io/socket_types.h"
+
+namespace zenremote {
+
+/**
+ * @brief 本机网卡地址变化监视
+ *
+ * - Linux: 订阅 rtnetlink 的地址与链路事件（RTMGRP_IPV4_IFADDR /
+ *   RTMGRP_IPV6_IFADDR / RTMGRP_LINK），GetHandle() 返回可 poll 的非阻塞
+ *   netlink socket，与连接的 socket 一起等待，没有变化时不产生任何唤醒
+ * - 其他平台: 没有可等待的句柄，由调用方每 kPollIntervalMs 调用一次
+ *   ReadChanges()，与上次枚举到的地址列表比较
+ *
+ * 链路事件只关心运行状态（IFF_RUNNING）的翻转，忽略统计信息等无关更新。
+ *
+ * @note 非线程安全，Open/ReadChanges 在同一线程调用
+ */
+class NetworkMonitor {
+ public:
+  /// @brief 没有事件句柄时的轮询间隔
+  static constexpr int kPollIntervalMs = 2000;
+
+  NetworkMonitor();
+  ~NetworkMonitor();
+
+  NetworkMonitor(const NetworkMonitor&) = delete;
+  NetworkMonitor& operator=(const NetworkMonitor&) = delete;
+
+  Result<void> Open();
+  void Close();
+  bool IsOpen() const { return open_; }
+
+  /// @brief 可 poll 的事件句柄，不支持事件通知的平台返回 kInvalidSocket
+  socket_t GetHandle() const { return handle_; }
+
+  /**
+   * @brief 取走积压的事件（非阻塞）
+   * @return 期间有地址增删或链路运行状态变化返回 true
+   */
+  bool ReadChanges();
+
+ private:
+  bool open_ = false;
+  socket_t handle_ = kInvalidSocket;
+  std::vector<std::string> addresses_;  ///< 轮询模式下上次的地址列表
+};
+
+}  // namespace zenremote
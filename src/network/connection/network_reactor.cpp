@@ -0,0 +1,308 @@
+#include "network/connection/network_reactor.h"
+
+#include <algorithm>
+#include <future>
+
+#include "common/log_manager.h"
+#include "network/connection/base_connection.h"
+
+namespace zenremote {
+
+struct NetworkReactor::Entry {
+  RegistrationId id = 0;
+  BaseConnection* connection = nullptr;
+  OnPacketCallback on_packet;
+  OnTimerCallback on_timer;
+  std::atomic<bool> removed{false};
+
+  // 以下只由所在的反应器线程访问
+  bool has_handles = false;
+  uint32_t handles_generation = 0;
+  std::vector<socket_t> handles;
+  bool handles_invalid = false;  ///< 句柄已关闭，等待连接换新句柄
+};
+
+struct NetworkReactor::Worker {
+  EventPoller poller;
+  std::thread thread;
+  std::atomic<bool> should_stop{false};
+  std::atomic<size_t> registrations{0};
+
+  std::mutex ops_mutex;
+  std::vector<Task> ops;  ///< 注册、注销与投递的任务，按顺序在本线程执行
+
+  // 以下只由本线程访问
+  std::vector<std::shared_ptr<Entry>> entries;
+};
+
+NetworkReactor::NetworkReactor() : NetworkReactor(Config{}) {}
+
+NetworkReactor::NetworkReactor(const Config& config) : config_(config) {
+  config_.threads = std::max<size_t>(config_.threads, 1);
+}
+
+NetworkReactor::~NetworkReactor() {
+  Stop();
+}
+
+Result<void> NetworkReactor::Start() {
+  if (running_) {
+    return Result<void>::Err(ErrorCode::kAlreadyRunning,
+                             "NetworkReactor already running");
+  }
+  for (size_t i = 0; i < config_.threads; ++i) {
+    auto worker = std::make_unique<Worker>();
+    auto result = worker->poller.Open();
+    if (result.IsErr()) {
+      workers_.clear();
+      return result;
+    }
+    workers_.push_back(std::move(worker));
+  }
+  running_ = true;
+  for (auto& worker : workers_) {
+    Worker* raw = worker.get();
+    raw->thread = std::thread([this, raw]() { Run(*raw); });
+  }
+  return Result<void>::Ok();
+}
+
+void NetworkReactor::Stop() {
+  if (!running_) {
+    return;
+  }
+  for (auto& worker : workers_) {
+    worker->should_stop = true;
+    worker->poller.Wakeup();
+  }
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    registrations_.clear();
+  }
+  // 未执行的注销操作在这里析构，等待中的 Unregister() 随之返回
+  workers_.clear();
+  running_ = false;
+}
+
+Result<NetworkReactor::RegistrationId> NetworkReactor::Register(
+    BaseConnection* connection,
+    OnPacketCallback on_packet,
+    OnTimerCallback on_timer) {
+  if (!connection || !on_packet) {
+    return Result<RegistrationId>::Err(
+        ErrorCode::kInvalidParameter,
+        "Connection and packet callback are required");
+  }
+  if (!running_) {
+    return Result<RegistrationId>::Err(ErrorCode::kNotRunning,
+                                       "NetworkReactor not running");
+  }
+
+  auto entry = std::make_shared<Entry>();
+  entry->connection = connection;
+  entry->on_packet = std::move(on_packet);
+  entry->on_timer = std::move(on_timer);
+
+  Worker* worker = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    worker = std::min_element(workers_.begin(), workers_.end(),
+                              [](const auto& a, const auto& b) {
+                                return a->registrations < b->registrations;
+                              })
+                 ->get();
+    entry->id = next_id_++;
+    registrations_.emplace(entry->id, std::make_pair(worker, entry));
+    worker->registrations++;
+  }
+  PostOp(*worker, [worker, entry]() { worker->entries.push_back(entry); });
+  return Result<RegistrationId>::Ok(entry->id);
+}
+
+void NetworkReactor::Unregister(RegistrationId id) {
+  Worker* worker = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = registrations_.find(id);
+    if (it == registrations_.end()) {
+      return;
+    }
+    worker = it->second.first;
+    // 之后不再执行它的回调；已在执行的回调由下面的同步等待覆盖
+    it->second.second->removed = true;
+    worker->registrations--;
+    registrations_.erase(it);
+  }
+  if (std::this_thread::get_id() == worker->thread.get_id()) {
+    return;
+  }
+
+  // 操作在两次回调之间执行，执行到它时该连接的回调都已返回
+  auto done = std::make_shared<std::promise<void>>();
+  auto future = done->get_future();
+  PostOp(*worker, [done]() { done->set_value(); });
+  future.wait();
+}
+
+void NetworkReactor::Wakeup(RegistrationId id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = registrations_.find(id);
+  if (it != registrations_.end()) {
+    it->second.first->poller.Wakeup();
+  }
+}
+
+void NetworkReactor::Post(RegistrationId id, Task task) {
+  Worker* worker = nullptr;
+  std::shared_ptr<Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = registrations_.find(id);
+    if (it == registrations_.end()) {
+      return;
+    }
+    worker = it->second.first;
+    entry = it->second.second;
+  }
+  PostOp(*worker, [this, entry, task = std::move(task)]() {
+    if (!entry->removed) {
+      task();
+      tasks_run_.fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+}
+
+NetworkReactor::Stats NetworkReactor::GetStats() const {
+  Stats stats;
+  stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+  stats.packets_received = packets_received_.load(std::memory_order_relaxed);
+  stats.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.registrations = registrations_.size();
+  return stats;
+}
+
+void NetworkReactor::PostOp(Worker& worker, Task op) {
+  {
+    std::lock_guard<std::mutex> lock(worker.ops_mutex);
+    worker.ops.push_back(std::move(op));
+  }
+  worker.poller.Wakeup();
+}
+
+void NetworkReactor::RunPendingOps(Worker& worker) {
+  std::vector<Task> ops;
+  {
+    std::lock_guard<std::mutex> lock(worker.ops_mutex);
+    if (worker.ops.empty()) {
+      return;
+    }
+    ops.swap(worker.ops);
+  }
+  for (auto& op : ops) {
+    op();
+  }
+}
+
+void NetworkReactor::Drain(Entry& entry, std::vector<uint8_t>& buffer) {
+  for (size_t i = 0; i < kMaxBatchPackets && !entry.removed; ++i) {
+    auto result = entry.connection->Recv(buffer.data(), buffer.size(), 0);
+    if (result.IsErr() || result.Value() == 0) {
+      break;
+    }
+    packets_received_.fetch_add(1, std::memory_order_relaxed);
+    entry.on_packet(buffer.data(), result.Value());
+  }
+}
+
+void NetworkReactor::Run(Worker& worker) {
+  std::vector<uint8_t> buffer(kMaxDatagramSize);
+  std::vector<socket_t> handles;
+  std::vector<size_t> handle_owners;  ///< handles[i] 所属的 entries 下标
+  std::vector<uint8_t> states;
+  std::vector<uint8_t> ready;
+
+  while (!worker.should_stop) {
+    RunPendingOps(worker);
+    auto& entries = worker.entries;
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [](const auto& entry) {
+                                   return entry->removed.load();
+                                 }),
+                  entries.end());
+
+    // 定时器与句柄集合；连接可能在任务或定时器中换了 socket（迁移）
+    int timeout_ms = -1;
+    bool polling_fallback = false;
+    handles.clear();
+    handle_owners.clear();
+    ready.assign(entries.size(), 0);
+    for (size_t i = 0; i < entries.size(); ++i) {
+      Entry& entry = *entries[i];
+      if (entry.on_timer && !entry.removed) {
+        const int delay_ms = entry.on_timer();
+        if (delay_ms >= 0) {
+          timeout_ms =
+              timeout_ms < 0 ? delay_ms : std::min(timeout_ms, delay_ms);
+        }
+      }
+      if (entry.removed) {
+        continue;
+      }
+      const uint32_t generation = entry.connection->GetPollHandlesGeneration();
+      if (!entry.has_handles || generation != entry.handles_generation) {
+        entry.has_handles = true;
+        entry.handles_generation = generation;
+        entry.handles = entry.connection->GetPollHandles();
+        entry.handles_invalid = false;
+      }
+      if (entry.handles_invalid) {
+        continue;
+      }
+      if (entry.handles.empty()) {
+        polling_fallback = true;
+        ready[i] = 1;
+        continue;
+      }
+      for (socket_t handle : entry.handles) {
+        handles.push_back(handle);
+        handle_owners.push_back(i);
+      }
+    }
+    if (polling_fallback) {
+      timeout_ms = timeout_ms < 0
+                       ? kFallbackPollIntervalMs
+                       : std::min(timeout_ms, kFallbackPollIntervalMs);
+    }
+
+    auto readable = worker.poller.Wait(handles, timeout_ms, states);
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    if (readable.IsErr()) {
+      ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "NetworkReactor thread stopped: {}",
+                      readable.Message());
+      break;
+    }
+    if (worker.should_stop) {
+      break;
+    }
+    for (size_t i = 0; i < handles.size(); ++i) {
+      if (states[i] == EventPoller::kHandleReadable) {
+        ready[handle_owners[i]] = 1;
+      } else if (states[i] == EventPoller::kHandleInvalid) {
+        entries[handle_owners[i]]->handles_invalid = true;
+      }
+    }
+    for (size_t i = 0; i < entries.size() && !worker.should_stop; ++i) {
+      if (ready[i] && !entries[i]->removed) {
+        Drain(*entries[i], buffer);
+      }
+    }
+  }
+}
+
+}  // namespace zenremote
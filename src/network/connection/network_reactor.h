@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/error.h"
+#include "network/io/event_poller.h"
+
+namespace zenremote {
+
+class BaseConnection;
+
+/**
+ * @brief 多个连接共享的接收反应器
+ *
+ * ReceiveLoop 每个连接一个线程，主机同时服务多个会话时线程数随会话增长。
+ * NetworkReactor 用固定数量的线程（Config::threads）服务任意多个连接：
+ * - 连接注册时固定分配到注册数最少的线程，它的报文、定时器与投递的任务
+ *   都在该线程串行执行，与 ReceiveLoop 的语义一致
+ * - 每个线程一个 EventPoller，一次等待该线程全部连接的 socket，只读取可读的
+ *   连接；每个连接一轮最多取 kMaxBatchPackets 个报文，繁忙的连接不会饿死
+ *   同一线程上的其他连接
+ * - 等待时长取该线程所有连接的 OnTimerCallback 中最近的一个
+ * - 不支持 GetPollHandles() 的连接退回到 kFallbackPollIntervalMs 间隔的
+ *   非阻塞 Recv()
+ *
+ * 线程安全：Start/Stop 在同一控制线程调用，其他方法可在任意线程调用。
+ * Unregister() 返回后该连接的回调不再执行；在该连接所在的反应器线程中调用
+ * 时（例如在它自己的回调里），当前回调返回后生效。
+ */
+class NetworkReactor {
+ public:
+  static constexpr size_t kMaxDatagramSize = 65536;
+  static constexpr size_t kMaxBatchPackets = 64;
+  static constexpr int kFallbackPollIntervalMs = 5;
+
+  struct Config {
+    size_t threads = 1;
+  };
+
+  using RegistrationId = uint64_t;
+  using OnPacketCallback =
+      std::function<void(const uint8_t* data, size_t length)>;
+  /// @brief 处理到期定时器，返回距下一个定时器的毫秒数，-1 表示没有
+  using OnTimerCallback = std::function<int()>;
+  using Task = std::function<void()>;
+
+  struct Stats {
+    uint64_t wakeups = 0;  ///< 所有线程从等待中返回的次数
+    uint64_t packets_received = 0;
+    uint64_t tasks_run = 0;
+    size_t registrations = 0;
+  };
+
+  NetworkReactor();
+  explicit NetworkReactor(const Config& config);
+  ~NetworkReactor();
+
+  NetworkReactor(const NetworkReactor&) = delete;
+  NetworkReactor& operator=(const NetworkReactor&) = delete;
+
+  Result<void> Start();
+
+  /// @brief 停止并等待所有线程退出，剩余的注册与未执行的任务被丢弃
+  void Stop();
+
+  bool IsRunning() const { return running_; }
+
+  /**
+   * @brief 把已打开的连接加入反应器
+   * @param connection Unregister() 之前必须保持有效
+   * @param on_timer 每次等待前调用，可为空
+   */
+  Result<RegistrationId> Register(BaseConnection* connection,
+                                  OnPacketCallback on_packet,
+                                  OnTimerCallback on_timer);
+
+  void Unregister(RegistrationId id);
+
+  /// @brief 打断该连接所在线程的等待，重新计算定时器
+  void Wakeup(RegistrationId id);
+
+  /// @brief 在该连接所在的线程执行任务；连接注销后任务被丢弃
+  void Post(RegistrationId id, Task task);
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry;
+  struct Worker;
+
+  void Run(Worker& worker);
+  void RunPendingOps(Worker& worker);
+  void PostOp(Worker& worker, Task op);
+  /// @brief 非阻塞读取一个连接，最多 kMaxBatchPackets 个报文
+  void Drain(Entry& entry, std::vector<uint8_t>& buffer);
+
+  Config config_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<bool> running_{false};
+
+  mutable std::mutex mutex_;
+  std::unordered_map<RegistrationId,
+                     std::pair<Worker*, std::shared_ptr<Entry>>>
+      registrations_;
+  RegistrationId next_id_ = 1;
+
+  std::atomic<uint64_t> wakeups_{0};
+  std::atomic<uint64_t> packets_received_{0};
+  std::atomic<uint64_t> tasks_run_{0};
+};
+
+}  // namespace zenremote
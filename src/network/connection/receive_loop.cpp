@@ -0,0 +1,184 @@
+#include "network/connection/receive_loop.h"
+
+#include <algorithm>
+
+#include "common/log_manager.h"
+#include "network/connection/base_connection.h"
+
+namespace zenremote {
+
+ReceiveLoop::ReceiveLoop() = default;
+
+ReceiveLoop::~ReceiveLoop() {
+  Stop();
+}
+
+Result<void> ReceiveLoop::Start(BaseConnection* connection,
+                                OnPacketCallback on_packet,
+                                OnTimerCallback on_timer,
+                                NetworkReactor* reactor) {
+  if (IsRunning()) {
+    return Result<void>::Err(ErrorCode::kAlreadyRunning,
+                             "ReceiveLoop already running");
+  }
+  if (!connection || !on_packet) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Connection and packet callback are required");
+  }
+
+  reactor_ = reactor;
+  if (reactor) {
+    // 计数放在本对象里，与独立线程时的 GetStats() 一致
+    auto registration = reactor->Register(
+        connection,
+        [this, on_packet = std::move(on_packet)](const uint8_t* data,
+                                                 size_t length) {
+          packets_received_.fetch_add(1, std::memory_order_relaxed);
+          on_packet(data, length);
+        },
+        std::move(on_timer));
+    if (registration.IsErr()) {
+      return Result<void>::Err(registration.Code(), registration.Message());
+    }
+    connection_ = connection;
+    registration_ = registration.Value();
+    return Result<void>::Ok();
+  }
+
+  auto result = poller_.Open();
+  if (result.IsErr()) {
+    return result;
+  }
+
+  connection_ = connection;
+  on_packet_ = std::move(on_packet);
+  on_timer_ = std::move(on_timer);
+  should_stop_ = false;
+  thread_ = std::make_unique<std::thread>([this]() { Run(); });
+  return Result<void>::Ok();
+}
+
+void ReceiveLoop::Stop() {
+  if (registration_ != 0) {
+    reactor_->Unregister(registration_.exchange(0));
+    return;
+  }
+  if (!thread_) {
+    return;
+  }
+  should_stop_ = true;
+  poller_.Wakeup();
+  if (thread_->joinable()) {
+    thread_->join();
+  }
+  thread_.reset();
+  // 唤醒句柄保留到析构，其他线程迟到的 Wakeup()/Post() 不会写入已关闭的句柄
+
+  std::lock_guard<std::mutex> lock(tasks_mutex_);
+  tasks_.clear();
+}
+
+void ReceiveLoop::Wakeup() {
+  if (reactor_) {
+    reactor_->Wakeup(registration_);
+  } else {
+    poller_.Wakeup();
+  }
+}
+
+void ReceiveLoop::Post(Task task) {
+  if (reactor_) {
+    reactor_->Post(registration_, [this, task = std::move(task)]() {
+      task();
+      tasks_run_.fetch_add(1, std::memory_order_relaxed);
+    });
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  poller_.Wakeup();
+}
+
+ReceiveLoop::Stats ReceiveLoop::GetStats() const {
+  Stats stats;
+  stats.wakeups = wakeups_.load(std::memory_order_relaxed);
+  stats.packets_received = packets_received_.load(std::memory_order_relaxed);
+  stats.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void ReceiveLoop::Run() {
+  std::vector<uint8_t> buffer(kMaxDatagramSize);
+  uint32_t handles_generation = connection_->GetPollHandlesGeneration();
+  std::vector<socket_t> handles = connection_->GetPollHandles();
+
+  while (!should_stop_) {
+    RunPendingTasks();
+    const int timer_delay_ms = on_timer_ ? on_timer_() : -1;
+    if (should_stop_) {
+      break;
+    }
+    // 任务与定时器可能让连接换了 socket（迁移）
+    const uint32_t generation = connection_->GetPollHandlesGeneration();
+    if (generation != handles_generation) {
+      handles_generation = generation;
+      handles = connection_->GetPollHandles();
+    }
+
+    if (handles.empty()) {
+      const int timeout_ms =
+          timer_delay_ms < 0
+              ? kFallbackPollIntervalMs
+              : std::min(timer_delay_ms, kFallbackPollIntervalMs);
+      auto result = connection_->Recv(buffer.data(), buffer.size(), timeout_ms);
+      wakeups_.fetch_add(1, std::memory_order_relaxed);
+      if (result.IsOk() && result.Value() > 0) {
+        packets_received_.fetch_add(1, std::memory_order_relaxed);
+        on_packet_(buffer.data(), result.Value());
+      }
+      continue;
+    }
+
+    auto readable = poller_.Wait(handles, timer_delay_ms);
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
+    if (readable.IsErr()) {
+      ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "ReceiveLoop stopped: {}",
+                      readable.Message());
+      break;
+    }
+    if (!readable.Value()) {
+      continue;
+    }
+
+    // 一次取完已到达的报文（有上限，避免饿死定时器）
+    for (size_t i = 0; i < kMaxBatchPackets && !should_stop_; ++i) {
+      auto result = connection_->Recv(buffer.data(), buffer.size(), 0);
+      if (result.IsErr()) {
+        break;
+      }
+      if (result.Value() > 0) {
+        packets_received_.fetch_add(1, std::memory_order_relaxed);
+        on_packet_(buffer.data(), result.Value());
+      }
+    }
+  }
+}
+
+void ReceiveLoop::RunPendingTasks() {
+  std::vector<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lock(tasks_mutex_);
+    if (tasks_.empty()) {
+      return;
+    }
+    tasks.swap(tasks_);
+  }
+  for (auto& task : tasks) {
+    task();
+    tasks_run_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/error.h"
+#include "network/connection/network_reactor.h"
+#include "network/io/event_poller.h"
+
+namespace zenremote {
+
+class BaseConnection;
+
+/**
+ * @brief 连接接收线程（事件驱动）
+ *
+ * 在一个线程里同时等待连接的 socket（可以是多个）与 EventPoller 的唤醒句柄：
+ * - 收到数据时一次最多取 kMaxBatchPackets 个报文交给 OnPacketCallback
+ * - 等待时长由 OnTimerCallback 返回的下一个定时器决定，没有定时器时无限
+ *   等待，空闲连接不产生任何唤醒
+ * - Stop() 通过唤醒句柄立即打断等待，不必等到超时
+ * - Post() 把任务（控制消息等）投递到接收线程执行
+ * - 连接增删 socket（GetPollHandlesGeneration() 变化）时，下一次等待前
+ *   重新取句柄集合
+ *
+ * 适用于任何实现了 BaseConnection::GetPollHandles() 的连接
+ * （DirectConnection、TurnConnection、IceConnection 等）；不支持的连接退回到
+ * 带 kFallbackPollIntervalMs 超时的 Recv() 轮询。
+ *
+ * 传入 NetworkReactor 时不创建线程，连接注册到共享反应器，回调、Post 的任务
+ * 在反应器线程执行，语义不变（同一连接的回调仍然串行）。
+ *
+ * 线程安全：Start/Stop 在同一控制线程调用；Wakeup/Post 可在任意线程调用；
+ * 回调均在接收线程执行，回调内不能调用 Stop()。
+ */
+class ReceiveLoop {
+ public:
+  static constexpr size_t kMaxDatagramSize = 65536;
+  static constexpr size_t kMaxBatchPackets = 64;
+  static constexpr int kFallbackPollIntervalMs = 5;
+
+  using OnPacketCallback =
+      std::function<void(const uint8_t* data, size_t length)>;
+  /// @brief 处理到期定时器，返回距下一个定时器的毫秒数，-1 表示没有
+  using OnTimerCallback = std::function<int()>;
+  using Task = std::function<void()>;
+
+  struct Stats {
+    uint64_t wakeups = 0;          ///< 从等待中返回的次数
+    uint64_t packets_received = 0;
+    uint64_t tasks_run = 0;
+  };
+
+  ReceiveLoop();
+  ~ReceiveLoop();
+
+  ReceiveLoop(const ReceiveLoop&) = delete;
+  ReceiveLoop& operator=(const ReceiveLoop&) = delete;
+
+  /**
+   * @brief 启动接收线程
+   * @param connection 已打开的连接，Stop() 之前必须保持有效
+   * @param on_packet 收到报文时调用
+   * @param on_timer 每次等待前调用，可为空
+   * @param reactor 非空时在该反应器上接收（须已 Start），Stop() 之前保持有效
+   */
+  Result<void> Start(BaseConnection* connection,
+                     OnPacketCallback on_packet,
+                     OnTimerCallback on_timer,
+                     NetworkReactor* reactor = nullptr);
+
+  /// @brief 停止并等待接收线程退出，未执行的任务被丢弃
+  void Stop();
+
+  bool IsRunning() const { return thread_ != nullptr || registration_ != 0; }
+
+  /// @brief 打断当前等待，重新调用 OnTimerCallback 计算超时
+  void Wakeup();
+
+  /// @brief 在接收线程执行任务
+  void Post(Task task);
+
+  /// @brief 共享反应器上 wakeups 为 0，见 NetworkReactor::GetStats()
+  Stats GetStats() const;
+
+ private:
+  void Run();
+  void RunPendingTasks();
+
+  BaseConnection* connection_ = nullptr;
+  OnPacketCallback on_packet_;
+  OnTimerCallback on_timer_;
+  EventPoller poller_;
+  std::unique_ptr<std::thread> thread_;
+  // Stop() 之后保留 reactor_，其他线程迟到的 Wakeup()/Post() 按已注销的 ID
+  // 被反应器忽略
+  NetworkReactor* reactor_ = nullptr;
+  std::atomic<NetworkReactor::RegistrationId> registration_{0};
+  std::atomic<bool> should_stop_{false};
+
+  std::mutex tasks_mutex_;
+  std::vector<Task> tasks_;
+
+  std::atomic<uint64_t> wakeups_{0};
+  std::atomic<uint64_t> packets_received_{0};
+  std::atomic<uint64_t> tasks_run_{0};
+};
+
+}  // namespace zenremote
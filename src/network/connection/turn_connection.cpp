@@ -1,10 +1,44 @@
 #include "network/connection/turn_connection.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
 #include "common/log_manager.h"
 
 namespace zenremote {
 
-TurnConnection::TurnConnection() = default;
+namespace {
+
+// REQUESTED-TRANSPORT：协议号 17（UDP）在最高字节，其余保留
+constexpr uint32_t kRequestedTransportUdp = 17U << 24U;
+// 权限 5 分钟、通道 10 分钟过期（RFC 8656 9 / 12），提前 1 分钟续期
+constexpr auto kPermissionRefreshInterval = std::chrono::minutes(4);
+constexpr auto kChannelRefreshInterval = std::chrono::minutes(9);
+// 后台刷新失败后的重试间隔
+constexpr auto kRefreshRetryDelay = std::chrono::seconds(5);
+// Open() 中同一请求的认证重试次数（401 取得 nonce、438 换 nonce）
+constexpr int kMaxAuthAttempts = 3;
+constexpr size_t kMaxDatagramSize = 65536;
+
+const char* MethodName(StunMethod method) {
+  switch (method) {
+    case StunMethod::kAllocate:
+      return "Allocate";
+    case StunMethod::kRefresh:
+      return "Refresh";
+    case StunMethod::kCreatePermission:
+      return "CreatePermission";
+    case StunMethod::kChannelBind:
+      return "ChannelBind";
+    default:
+      return "request";
+  }
+}
+
+}  // namespace
+
+TurnConnection::TurnConnection() : rng_(std::random_device{}()) {}
 
 TurnConnection::~TurnConnection() {
   Shutdown();
@@ -15,15 +49,22 @@ Result<void> TurnConnection::Initialize(const Config& config) {
     return Result<void>::Err(ErrorCode::kAlreadyInitialized,
                              "TurnConnection already initialized");
   }
+  if (config.turn_server_ip.empty()) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "TURN server address is empty");
+  }
 
   config_ = config;
+  if (config_.local_ip == "0.0.0.0" && IsIpv6Address(config_.turn_server_ip)) {
+    config_.local_ip = "::";
+  }
 
   // Create UdpSocket (Network I/O layer)
   UdpSocket::Config socket_config;
-  socket_config.local_ip = config.local_ip;
-  socket_config.local_port = config.local_port;
-  socket_config.socket_buffer_size = config.socket_buffer_size;
-  socket_config.recv_timeout_ms = config.recv_timeout_ms;
+  socket_config.local_ip = config_.local_ip;
+  socket_config.local_port = config_.local_port;
+  socket_config.socket_buffer_size = config_.socket_buffer_size;
+  socket_config.recv_timeout_ms = config_.recv_timeout_ms;
 
   socket_ = std::make_unique<UdpSocket>(socket_config);
 
@@ -35,17 +76,33 @@ Result<void> TurnConnection::Initialize(const Config& config) {
 
   ZENREMOTE_INFO(LOG_MODULE_NETWORK,
                  "TurnConnection initialized: local={}:{}, turn={}:{}",
-                 config_.local_ip, config_.local_port, config_.turn_server_ip,
-                 config_.turn_server_port);
+                 config_.local_ip, socket_->GetLocalPort(),
+                 config_.turn_server_ip, config_.turn_server_port);
   return Result<void>::Ok();
 }
 
 void TurnConnection::Shutdown() {
   if (socket_) {
+    if (has_allocation_) {
+      // 尽力释放分配，丢失时由服务器按 lifetime 回收
+      std::vector<uint8_t> bytes;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes = SerializeRequestLocked(
+            BuildRequestLocked(StunMethod::kRefresh, 0));
+      }
+      SendToServer(bytes);
+    }
     socket_->Close();
     socket_.reset();
   }
   has_allocation_ = false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.clear();
+  allocation_refresh_at_ = Clock::time_point::max();
+  permission_refresh_at_ = Clock::time_point::max();
+  channel_refresh_at_ = Clock::time_point::max();
   ZENREMOTE_DEBUG(LOG_MODULE_NETWORK, "TurnConnection shutdown");
 }
 
@@ -53,13 +110,22 @@ Result<void> TurnConnection::Open() {
   if (!socket_ || !socket_->IsOpen()) {
     return Result<void>::Err(ErrorCode::kSocketError, "Socket not open");
   }
+  if (has_allocation_) {
+    return Result<void>::Ok();
+  }
 
-  // Phase 2: Allocate relay address from TURN server
   auto result = AllocateRelay();
   if (result.IsErr()) {
     return result;
   }
 
+  if (!config_.peer.address.empty()) {
+    result = BindPeer();
+    if (result.IsErr()) {
+      Shutdown();
+      return result;
+    }
+  }
   return Result<void>::Ok();
 }
 
@@ -77,10 +143,14 @@ Result<size_t> TurnConnection::Send(const uint8_t* data, size_t length) {
                                "TurnConnection not open");
   }
 
-  if (!data || length == 0) {
+  if (!data || length == 0 || length > 0xFFFF) {
     return Result<size_t>::Err(ErrorCode::kInvalidParameter,
                                "Invalid send parameters");
   }
+  if (config_.peer.address.empty()) {
+    return Result<size_t>::Err(ErrorCode::kInvalidState,
+                               "TURN peer not configured");
+  }
 
   return SendTurnPacket(data, length);
 }
@@ -98,45 +168,486 @@ Result<size_t> TurnConnection::Recv(uint8_t* buffer,
                                "Invalid receive parameters");
   }
 
-  std::string from_ip;
-  uint16_t from_port;
-  size_t received = buffer_size;
+  const auto deadline =
+      Clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+  while (true) {
+    int wait_ms = -1;
+    if (timeout_ms >= 0) {
+      const auto remaining =
+          std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+      wait_ms = static_cast<int>(std::max<int64_t>(remaining.count(), 0));
+    }
 
-  if (!socket_->RecvFrom(buffer, received, from_ip, from_port, timeout_ms)) {
-    return Result<size_t>::Err(ErrorCode::kSocketError,
-                               "Receive timeout or error");
+    std::string from_ip;
+    uint16_t from_port = 0;
+    size_t received = buffer_size;
+    if (!socket_->RecvFrom(buffer, received, from_ip, from_port, wait_ms)) {
+      return Result<size_t>::Err(ErrorCode::kTimeout, "Receive timeout");
+    }
+    if (!IsFromServer(from_ip, from_port)) {
+      continue;
+    }
+
+    // 媒体走 ChannelData，原地去掉 4 字节头
+    size_t payload_length = 0;
+    if (auto channel =
+            ParseChannelDataHeader(buffer, received, payload_length)) {
+      if (*channel != channel_number_) {
+        continue;
+      }
+      std::memmove(buffer, buffer + kChannelDataHeaderSize, payload_length);
+      packets_received_++;
+      return Result<size_t>::Ok(payload_length);
+    }
+
+    auto message = ParseStunMessage(buffer, received);
+    if (!message) {
+      continue;
+    }
+    if (message->message_class == StunClass::kIndication &&
+        message->Is(StunMethod::kData)) {
+      const auto* data = message->Find(StunAttributeType::kData);
+      if (!data || data->value.empty()) {
+        continue;
+      }
+      const size_t length = std::min(buffer_size, data->value.size());
+      std::memcpy(buffer, data->value.data(), length);
+      packets_received_++;
+      return Result<size_t>::Ok(length);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    HandleServerMessageLocked(*message, buffer, received);
+  }
+}
+
+int TurnConnection::ProcessTimers() {
+  if (!has_allocation_) {
+    return -1;
+  }
+
+  const auto now = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    auto& request = it->second;
+    if (request.next_send > now) {
+      ++it;
+      continue;
+    }
+    if (request.attempts >= config_.max_request_attempts) {
+      ZENREMOTE_WARN(LOG_MODULE_NETWORK, "TURN {} timed out, retrying later",
+                     MethodName(request.method));
+      RefreshDeadlineLocked(request.method) = now + kRefreshRetryDelay;
+      it = pending_.erase(it);
+      continue;
+    }
+    SendPendingLocked(request, now);
+    ++it;
   }
 
-  return Result<size_t>::Ok(received);
+  if (now >= allocation_refresh_at_) {
+    StartRequestLocked(StunMethod::kRefresh, now);
+  }
+  if (now >= permission_refresh_at_) {
+    StartRequestLocked(StunMethod::kCreatePermission, now);
+  }
+  if (now >= channel_refresh_at_) {
+    StartRequestLocked(StunMethod::kChannelBind, now);
+  }
+
+  auto next = std::min(
+      {allocation_refresh_at_, permission_refresh_at_, channel_refresh_at_});
+  for (const auto& entry : pending_) {
+    next = std::min(next, entry.second.next_send);
+  }
+  if (next == Clock::time_point::max()) {
+    return -1;
+  }
+  const auto delay = std::chrono::ceil<std::chrono::milliseconds>(next - now);
+  return static_cast<int>(
+      std::clamp<int64_t>(delay.count(), 0, static_cast<int64_t>(INT_MAX)));
+}
+
+Endpoint TurnConnection::GetRelayedAddress() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return relayed_address_;
+}
+
+Endpoint TurnConnection::GetMappedAddress() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return mapped_address_;
+}
+
+TurnConnection::Stats TurnConnection::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.channel_data_sent = channel_data_sent_;
+  stats.indications_sent = indications_sent_;
+  stats.packets_received = packets_received_;
+  return stats;
 }
 
 Result<void> TurnConnection::AllocateRelay() {
-  // Phase 2: Send TURN Allocate request
-  // TODO: Implement TURN protocol
+  auto result = Transact(StunMethod::kAllocate, config_.lifetime_s);
+  if (result.IsErr()) {
+    return Result<void>::Err(result.Code(),
+                             "TURN allocation failed: " + result.Message());
+  }
+
+  const auto& response = result.Value();
+  auto relayed =
+      response.GetXorAddress(StunAttributeType::kXorRelayedAddress);
+  if (!relayed) {
+    return Result<void>::Err(ErrorCode::kProtocolError,
+                             "Allocate response without relayed address");
+  }
+
+  uint32_t lifetime_s = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    relayed_address_ = *relayed;
+    mapped_address_ =
+        response.GetXorAddress(StunAttributeType::kXorMappedAddress)
+            .value_or(Endpoint{});
+    lifetime_s = response.GetUint32(StunAttributeType::kLifetime)
+                     .value_or(config_.lifetime_s);
+    ScheduleRefreshLocked(StunMethod::kAllocate, response, Clock::now());
+  }
   has_allocation_ = true;
-  ZENREMOTE_INFO(LOG_MODULE_NETWORK, "TURN relay allocated: {}:{}",
-                 relay_address_, relay_port_);
+
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK, "TURN relay allocated: {}:{}, {}s",
+                 relayed->address, relayed->port, lifetime_s);
   return Result<void>::Ok();
 }
 
-Result<void> TurnConnection::RefreshAllocation() {
-  // Phase 2: Send TURN Refresh request
-  // TODO: Implement TURN protocol
+Result<void> TurnConnection::BindPeer() {
+  std::vector<StunMethod> methods = {StunMethod::kCreatePermission};
+  if (config_.use_channel_data) {
+    methods.push_back(StunMethod::kChannelBind);
+  }
+
+  for (StunMethod method : methods) {
+    auto result = Transact(method, 0);
+    if (result.IsErr()) {
+      return Result<void>::Err(result.Code(),
+                               std::string("TURN ") + MethodName(method) +
+                                   " failed: " + result.Message());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ScheduleRefreshLocked(method, result.Value(), Clock::now());
+  }
+
+  ZENREMOTE_INFO(LOG_MODULE_NETWORK, "TURN peer {}:{} bound to channel {:#x}",
+                 config_.peer.address, config_.peer.port, channel_number_);
   return Result<void>::Ok();
 }
 
 Result<size_t> TurnConnection::SendTurnPacket(const uint8_t* data,
                                               size_t length) {
-  // Phase 2: Wrap data in TURN Send indication
-  // TODO: Implement TURN protocol
+  if (config_.use_channel_data) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    send_buffer_.resize(kChannelDataHeaderSize + length);
+    WriteChannelDataHeader(channel_number_, length, send_buffer_.data());
+    std::memcpy(send_buffer_.data() + kChannelDataHeaderSize, data, length);
+    if (!SendToServer(send_buffer_)) {
+      return Result<size_t>::Err(ErrorCode::kSocketSendFailed, "Send failed");
+    }
+    channel_data_sent_++;
+    return Result<size_t>::Ok(length);
+  }
 
-  // For now, directly send to TURN server
-  if (!socket_->SendTo(data, length, config_.turn_server_ip,
-                       config_.turn_server_port)) {
+  // Send indication 不需要凭据（RFC 8656 11.1），每包多一个完整 STUN 头
+  std::vector<uint8_t> bytes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    StunMessage indication;
+    indication.method = static_cast<uint16_t>(StunMethod::kSend);
+    indication.message_class = StunClass::kIndication;
+    indication.transaction_id = NewTransactionIdLocked();
+    indication.AddXorAddress(StunAttributeType::kXorPeerAddress,
+                             config_.peer);
+    indication.AddAttribute(StunAttributeType::kData,
+                            std::vector<uint8_t>(data, data + length));
+    bytes = SerializeStunMessage(indication);
+  }
+  if (!SendToServer(bytes)) {
     return Result<size_t>::Err(ErrorCode::kSocketSendFailed, "Send failed");
   }
-
+  indications_sent_++;
   return Result<size_t>::Ok(length);
 }
 
+Result<StunMessage> TurnConnection::Transact(StunMethod method,
+                                             uint32_t lifetime_s) {
+  std::vector<uint8_t> buffer(kMaxDatagramSize);
+
+  for (int auth_attempt = 0; auth_attempt < kMaxAuthAttempts;
+       ++auth_attempt) {
+    StunMessage request;
+    std::vector<uint8_t> bytes;
+    bool sent_credentials = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      request = BuildRequestLocked(method, lifetime_s);
+      bytes = SerializeRequestLocked(request);
+      sent_credentials = !key_.empty();
+    }
+
+    std::optional<StunMessage> response;
+    int rto_ms = config_.request_rto_ms;
+    for (int sends = 0; sends < config_.max_request_attempts && !response;
+         ++sends) {
+      if (!SendToServer(bytes)) {
+        return Result<StunMessage>::Err(ErrorCode::kSocketSendFailed,
+                                        "Send failed");
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.requests_sent++;
+        if (sends > 0) {
+          stats_.retransmissions++;
+        }
+      }
+
+      const auto deadline = Clock::now() + std::chrono::milliseconds(rto_ms);
+      while (!response) {
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - Clock::now());
+        if (remaining.count() <= 0) {
+          break;
+        }
+        std::string from_ip;
+        uint16_t from_port = 0;
+        size_t received = buffer.size();
+        if (!socket_->RecvFrom(buffer.data(), received, from_ip, from_port,
+                               static_cast<int>(remaining.count())) ||
+            !IsFromServer(from_ip, from_port)) {
+          continue;
+        }
+        auto message = ParseStunMessage(buffer.data(), received);
+        if (!message || message->transaction_id != request.transaction_id ||
+            (message->message_class != StunClass::kSuccessResponse &&
+             message->message_class != StunClass::kErrorResponse)) {
+          continue;
+        }
+        // 带凭据的请求，成功响应必须通过完整性校验
+        if (sent_credentials &&
+            message->message_class == StunClass::kSuccessResponse) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (!VerifyStunMessageIntegrity(buffer.data(), received, key_)) {
+            continue;
+          }
+        }
+        response = std::move(message);
+      }
+      rto_ms *= 2;
+    }
+
+    if (!response) {
+      return Result<StunMessage>::Err(
+          ErrorCode::kConnectionTimeout,
+          std::string("No response to TURN ") + MethodName(method));
+    }
+    if (response->message_class == StunClass::kSuccessResponse) {
+      return Result<StunMessage>::Ok(std::move(*response));
+    }
+
+    const int code = response->GetErrorCode().value_or(0);
+    bool retry = false;
+    if (code == kStunErrorStaleNonce ||
+        (code == kStunErrorUnauthorized && !sent_credentials)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      retry = UpdateCredentialsLocked(*response);
+    }
+    if (retry) {
+      continue;
+    }
+    if (code == kStunErrorUnauthorized) {
+      return Result<StunMessage>::Err(ErrorCode::kPermissionDenied,
+                                      "TURN authentication failed");
+    }
+    return Result<StunMessage>::Err(
+        ErrorCode::kConnectionRefused,
+        "TURN server error " + std::to_string(code));
+  }
+  return Result<StunMessage>::Err(ErrorCode::kPermissionDenied,
+                                  "TURN authentication failed");
+}
+
+StunMessage TurnConnection::BuildRequestLocked(StunMethod method,
+                                               uint32_t lifetime_s) {
+  StunMessage request;
+  request.method = static_cast<uint16_t>(method);
+  request.message_class = StunClass::kRequest;
+  // XOR 地址（IPv6）依赖事务 ID，必须先生成
+  request.transaction_id = NewTransactionIdLocked();
+
+  switch (method) {
+    case StunMethod::kAllocate:
+      request.AddUint32(StunAttributeType::kRequestedTransport,
+                        kRequestedTransportUdp);
+      request.AddUint32(StunAttributeType::kLifetime, lifetime_s);
+      break;
+    case StunMethod::kRefresh:
+      request.AddUint32(StunAttributeType::kLifetime, lifetime_s);
+      break;
+    case StunMethod::kChannelBind:
+      request.AddUint32(StunAttributeType::kChannelNumber,
+                        static_cast<uint32_t>(channel_number_) << 16U);
+      request.AddXorAddress(StunAttributeType::kXorPeerAddress, config_.peer);
+      break;
+    case StunMethod::kCreatePermission:
+      request.AddXorAddress(StunAttributeType::kXorPeerAddress, config_.peer);
+      break;
+    default:
+      break;
+  }
+  return request;
+}
+
+StunTransactionId TurnConnection::NewTransactionIdLocked() {
+  StunTransactionId id;
+  for (auto& byte : id) {
+    byte = static_cast<uint8_t>(rng_());
+  }
+  return id;
+}
+
+std::vector<uint8_t> TurnConnection::SerializeRequestLocked(
+    const StunMessage& request) const {
+  if (key_.empty()) {
+    return SerializeStunMessage(request);
+  }
+  StunMessage signed_request = request;
+  signed_request.AddString(StunAttributeType::kUsername, config_.username);
+  signed_request.AddString(StunAttributeType::kRealm, realm_);
+  signed_request.AddString(StunAttributeType::kNonce, nonce_);
+  return SerializeStunMessage(signed_request, key_);
+}
+
+bool TurnConnection::UpdateCredentialsLocked(const StunMessage& response) {
+  auto nonce = response.GetString(StunAttributeType::kNonce);
+  if (!nonce) {
+    return false;
+  }
+  if (auto realm = response.GetString(StunAttributeType::kRealm)) {
+    realm_ = *realm;
+  }
+  nonce_ = *nonce;
+  key_ = ComputeStunLongTermKey(config_.username, realm_, config_.password);
+  return true;
+}
+
+void TurnConnection::StartRequestLocked(StunMethod method,
+                                        Clock::time_point now) {
+  const auto message = BuildRequestLocked(method, config_.lifetime_s);
+  PendingRequest request;
+  request.method = method;
+  request.bytes = SerializeRequestLocked(message);
+  auto& pending = pending_[message.transaction_id];
+  pending = std::move(request);
+  SendPendingLocked(pending, now);
+  // 等待响应期间不重复发起
+  RefreshDeadlineLocked(method) = Clock::time_point::max();
+}
+
+void TurnConnection::SendPendingLocked(PendingRequest& request,
+                                       Clock::time_point now) {
+  if (request.attempts > 0) {
+    stats_.retransmissions++;
+  }
+  request.next_send =
+      now + std::chrono::milliseconds(config_.request_rto_ms)
+                * (1 << std::min(request.attempts, 10));
+  request.attempts++;
+  stats_.requests_sent++;
+  SendToServer(request.bytes);
+}
+
+TurnConnection::Clock::time_point& TurnConnection::RefreshDeadlineLocked(
+    StunMethod method) {
+  switch (method) {
+    case StunMethod::kCreatePermission:
+      return permission_refresh_at_;
+    case StunMethod::kChannelBind:
+      return channel_refresh_at_;
+    default:
+      return allocation_refresh_at_;
+  }
+}
+
+void TurnConnection::ScheduleRefreshLocked(StunMethod method,
+                                           const StunMessage& response,
+                                           Clock::time_point now) {
+  switch (method) {
+    case StunMethod::kAllocate:
+    case StunMethod::kRefresh: {
+      // 分配在 lifetime 过半时刷新
+      const uint32_t lifetime_s =
+          response.GetUint32(StunAttributeType::kLifetime)
+              .value_or(config_.lifetime_s);
+      allocation_refresh_at_ =
+          now + std::chrono::milliseconds(lifetime_s * 500ULL);
+      break;
+    }
+    case StunMethod::kCreatePermission:
+      permission_refresh_at_ = now + kPermissionRefreshInterval;
+      break;
+    case StunMethod::kChannelBind:
+      channel_refresh_at_ = now + kChannelRefreshInterval;
+      break;
+    default:
+      break;
+  }
+}
+
+void TurnConnection::HandleServerMessageLocked(const StunMessage& message,
+                                               const uint8_t* data,
+                                               size_t length) {
+  if (message.message_class != StunClass::kSuccessResponse &&
+      message.message_class != StunClass::kErrorResponse) {
+    return;
+  }
+  auto it = pending_.find(message.transaction_id);
+  if (it == pending_.end()) {
+    return;
+  }
+
+  const StunMethod method = it->second.method;
+  const auto now = Clock::now();
+  if (message.message_class == StunClass::kSuccessResponse) {
+    if (!VerifyStunMessageIntegrity(data, length, key_)) {
+      return;  // 伪造或损坏的响应，等待重传
+    }
+    pending_.erase(it);
+    ScheduleRefreshLocked(method, message, now);
+    if (method == StunMethod::kRefresh) {
+      stats_.refreshes++;
+    }
+    return;
+  }
+
+  pending_.erase(it);
+  const int code = message.GetErrorCode().value_or(0);
+  if (code == kStunErrorStaleNonce && UpdateCredentialsLocked(message)) {
+    StartRequestLocked(method, now);
+    return;
+  }
+  ZENREMOTE_WARN(LOG_MODULE_NETWORK, "TURN {} rejected: {}",
+                 MethodName(method), code);
+  RefreshDeadlineLocked(method) = now + kRefreshRetryDelay;
+}
+
+bool TurnConnection::IsFromServer(const std::string& address,
+                                  uint16_t port) const {
+  return port == config_.turn_server_port &&
+         address == config_.turn_server_ip;
+}
+
+bool TurnConnection::SendToServer(const std::vector<uint8_t>& bytes) {
+  return socket_ && socket_->SendTo(bytes.data(), bytes.size(),
+                                    config_.turn_server_ip,
+                                    config_.turn_server_port);
+}
+
 }  // namespace zenremote
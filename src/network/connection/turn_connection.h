@@ -1,27 +1,70 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <vector>
 
 #include "common/error.h"
 #include "network/connection/base_connection.h"
+#include "network/io/endpoint.h"
 #include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
 
 namespace zenremote {
 
-// Transport layer: TURN relay connection (Phase 2)
-// Reuses the same UdpSocket (Network I/O layer) as DirectConnection
+/**
+ * @brief 传输层实现 - TURN 中继（RFC 8656 客户端，UDP）
+ *
+ * 与 DirectConnection 复用同一 UdpSocket 层。Open() 同步完成：
+ * 1. Allocate：首个请求不带凭据，服务器返回 401 + REALM/NONCE 后以长期凭据
+ *    （MESSAGE-INTEGRITY）重试，得到中继地址
+ * 2. CreatePermission：允许对端经中继发来数据
+ * 3. ChannelBind：为对端绑定通道号
+ *
+ * 之后数据以 4 字节头的 ChannelData 收发；关闭 use_channel_data 时退回到
+ * Send/Data indication（IPv4 每包 36 字节开销）。
+ *
+ * 分配、权限和通道都有时效，由 ProcessTimers() 在后台刷新：分配在 lifetime
+ * 过半时 Refresh，权限（5 分钟）每 4 分钟、通道（10 分钟）每 9 分钟续期。
+ * 刷新请求异步发送，响应由 Recv() 顺带消费；无响应按 RTO 翻倍重传，
+ * nonce 过期（438）时换新 nonce 重发。
+ *
+ * 线程模型：Open() 在调用线程完成；之后 Recv() 与 ProcessTimers() 在接收
+ * 线程调用，Send() 可在任意线程调用。
+ */
 class TurnConnection : public BaseConnection {
  public:
   struct Config {
-    std::string local_ip = "0.0.0.0";
+    std::string local_ip = "0.0.0.0";  ///< 服务器为 IPv6 时自动改为 "::"
     uint16_t local_port = 0;
     std::string turn_server_ip;
-    uint16_t turn_server_port;
+    uint16_t turn_server_port = 3478;
     std::string username;
     std::string password;
+    Endpoint peer;  ///< 对端地址，Open() 时为其创建权限并绑定通道
     int socket_buffer_size = 1024 * 1024;
     int recv_timeout_ms = 1000;
+
+    uint32_t lifetime_s = 600;      ///< 请求的分配时效，服务器可能缩短
+    int request_rto_ms = 100;       ///< 请求无响应时的重传间隔（逐次翻倍）
+    int max_request_attempts = 7;   ///< 同一请求最多发送次数（RFC 8489 Rc）
+    bool use_channel_data = true;   ///< false 时始终使用 Send indication
+  };
+
+  struct Stats {
+    uint64_t requests_sent = 0;  ///< 含重传
+    uint64_t retransmissions = 0;
+    uint64_t refreshes = 0;  ///< 成功的后台 Refresh 次数
+    uint64_t channel_data_sent = 0;
+    uint64_t indications_sent = 0;
+    uint64_t packets_received = 0;  ///< 交给调用方的数据报文
   };
 
   TurnConnection();
@@ -31,6 +74,7 @@ class TurnConnection : public BaseConnection {
   TurnConnection& operator=(const TurnConnection&) = delete;
 
   Result<void> Initialize(const Config& config);
+  /// @brief 释放分配（lifetime 0 的 Refresh，不等待响应）并关闭 socket
   void Shutdown();
 
   // BaseConnection interface
@@ -44,18 +88,92 @@ class TurnConnection : public BaseConnection {
                       int timeout_ms) override;
 
   ConnectionType GetType() const override { return ConnectionType::kRelay; }
+  std::vector<socket_t> GetPollHandles() const override {
+    if (!socket_) {
+      return {};
+    }
+    return {socket_->GetHandle()};
+  }
+
+  int ProcessTimers() override;
+
+  /// @brief 服务器分配的中继地址，对端发往该地址的数据转发给本端
+  Endpoint GetRelayedAddress() const;
+  /// @brief 服务器看到的本端地址（server-reflexive）
+  Endpoint GetMappedAddress() const;
+  Stats GetStats() const;
 
  private:
-  // TURN protocol methods (Phase 2 implementation)
+  using Clock = std::chrono::steady_clock;
+
+  /// @brief 后台刷新请求，等待响应或重传
+  struct PendingRequest {
+    StunMethod method = StunMethod::kRefresh;
+    std::vector<uint8_t> bytes;
+    Clock::time_point next_send{};
+    int attempts = 0;
+  };
+
+  // TURN protocol methods
   Result<void> AllocateRelay();
-  Result<void> RefreshAllocation();
+  /// @brief 为 config_.peer 创建权限并绑定通道
+  Result<void> BindPeer();
   Result<size_t> SendTurnPacket(const uint8_t* data, size_t length);
 
+  /**
+   * @brief Open() 期间的同步事务：发送请求并等待匹配的响应
+   *
+   * 处理 401（取得 realm/nonce 后带凭据重发）和 438（换 nonce 重发），
+   * 期间收到的其他报文丢弃。
+   */
+  Result<StunMessage> Transact(StunMethod method, uint32_t lifetime_s);
+  StunMessage BuildRequestLocked(StunMethod method, uint32_t lifetime_s);
+  StunTransactionId NewTransactionIdLocked();
+  /// @brief 有凭据时附加 USERNAME/REALM/NONCE 与 MESSAGE-INTEGRITY
+  std::vector<uint8_t> SerializeRequestLocked(const StunMessage& request) const;
+  /// @brief 从 401/438 响应更新 realm、nonce 与密钥，缺少 NONCE 返回 false
+  bool UpdateCredentialsLocked(const StunMessage& response);
+
+  /// @brief 发起后台刷新（Refresh/CreatePermission/ChannelBind）
+  void StartRequestLocked(StunMethod method, Clock::time_point now);
+  void SendPendingLocked(PendingRequest& request, Clock::time_point now);
+  /// @brief 各刷新请求对应的下次刷新时间
+  Clock::time_point& RefreshDeadlineLocked(StunMethod method);
+  /// @brief 更新刷新时间（成功响应或同步事务完成后）
+  void ScheduleRefreshLocked(StunMethod method,
+                             const StunMessage& response,
+                             Clock::time_point now);
+  /// @brief 处理服务器发来的 STUN 消息（刷新响应）
+  void HandleServerMessageLocked(const StunMessage& message,
+                                 const uint8_t* data,
+                                 size_t length);
+
+  bool IsFromServer(const std::string& address, uint16_t port) const;
+  bool SendToServer(const std::vector<uint8_t>& bytes);
+
   Config config_{};
   std::unique_ptr<UdpSocket> socket_;  // Reuses same UDP Socket layer!
-  std::string relay_address_;
-  uint16_t relay_port_ = 0;
-  bool has_allocation_ = false;
+  std::atomic<bool> has_allocation_{false};
+  uint16_t channel_number_ = kMinChannelNumber;
+
+  mutable std::mutex mutex_;  ///< 保护以下协议状态
+  Endpoint relayed_address_;
+  Endpoint mapped_address_;
+  std::string realm_;
+  std::string nonce_;
+  std::vector<uint8_t> key_;  ///< 长期凭据密钥，收到 realm 前为空
+  std::map<StunTransactionId, PendingRequest> pending_;
+  Clock::time_point allocation_refresh_at_ = Clock::time_point::max();
+  Clock::time_point permission_refresh_at_ = Clock::time_point::max();
+  Clock::time_point channel_refresh_at_ = Clock::time_point::max();
+  std::mt19937_64 rng_;
+  Stats stats_;  ///< 协议计数，数据报文计数见下面的原子变量
+
+  std::mutex send_mutex_;  ///< 保护 send_buffer_
+  std::vector<uint8_t> send_buffer_;
+  std::atomic<uint64_t> channel_data_sent_{0};
+  std::atomic<uint64_t> indications_sent_{0};
+  std::atomic<uint64_t> packets_received_{0};
 };
 
 }  // namespace zenremote
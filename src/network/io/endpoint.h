@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace zenremote {
+
+/**
+ * @brief 网络端点 (IP + Port)
+ */
+struct Endpoint {
+  std::string address;  ///< IP 地址 (IPv4 点分或 IPv6 冒号格式)
+  uint16_t port = 0;    ///< 端口号
+
+  bool operator==(const Endpoint& other) const {
+    return port == other.port && address == other.address;
+  }
+  bool operator!=(const Endpoint& other) const { return !(*this == other); }
+};
+
+}  // namespace zenremote
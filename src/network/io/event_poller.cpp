@@ -0,0 +1,278 @@
+#include "network/io/event_poller.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <poll.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#endif
+
+namespace zenremote {
+
+namespace {
+
+std::string LastErrorString() {
+#ifdef _WIN32
+  return std::to_string(WSAGetLastError());
+#else
+  return std::string(strerror(errno));
+#endif
+}
+
+}  // namespace
+
+EventPoller::EventPoller() = default;
+
+EventPoller::~EventPoller() {
+  Close();
+}
+
+bool EventPoller::IsOpen() const {
+#ifdef _WIN32
+  return wakeup_socket_ != kInvalidSocket;
+#else
+  return wakeup_read_fd_ >= 0;
+#endif
+}
+
+Result<void> EventPoller::Open() {
+  if (IsOpen()) {
+    return Result<void>::Ok();
+  }
+
+#ifdef _WIN32
+  WSADATA wsa_data;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+    return Result<void>::Err(ErrorCode::kNetworkError, "WSAStartup failed");
+  }
+  wakeup_socket_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (wakeup_socket_ == kInvalidSocket) {
+    WSACleanup();
+    return Result<void>::Err(ErrorCode::kNetworkError,
+                             "Failed to create wakeup socket: " +
+                                 LastErrorString());
+  }
+  // 绑定回环地址后连接到自身，send 的数据报只会被自己收到
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  int addr_len = sizeof(addr);
+  u_long non_blocking = 1;
+  if (bind(wakeup_socket_, reinterpret_cast<sockaddr*>(&addr), addr_len) != 0 ||
+      getsockname(wakeup_socket_, reinterpret_cast<sockaddr*>(&addr),
+                  &addr_len) != 0 ||
+      connect(wakeup_socket_, reinterpret_cast<sockaddr*>(&addr), addr_len) !=
+          0 ||
+      ioctlsocket(wakeup_socket_, FIONBIO, &non_blocking) != 0) {
+    const std::string error = LastErrorString();
+    Close();
+    return Result<void>::Err(ErrorCode::kNetworkError,
+                             "Failed to set up wakeup socket: " + error);
+  }
+#elif defined(__linux__)
+  wakeup_read_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_read_fd_ < 0) {
+    return Result<void>::Err(ErrorCode::kNetworkError,
+                             "eventfd failed: " + LastErrorString());
+  }
+  wakeup_write_fd_ = wakeup_read_fd_;
+#else
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return Result<void>::Err(ErrorCode::kNetworkError,
+                             "pipe failed: " + LastErrorString());
+  }
+  for (int fd : fds) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  wakeup_read_fd_ = fds[0];
+  wakeup_write_fd_ = fds[1];
+#endif
+
+  wakeup_pending_.store(false, std::memory_order_relaxed);
+  return Result<void>::Ok();
+}
+
+void EventPoller::Close() {
+  if (!IsOpen()) {
+    return;
+  }
+#ifdef _WIN32
+  closesocket(wakeup_socket_);
+  wakeup_socket_ = kInvalidSocket;
+  WSACleanup();
+#else
+  if (wakeup_write_fd_ != wakeup_read_fd_) {
+    close(wakeup_write_fd_);
+  }
+  close(wakeup_read_fd_);
+  wakeup_read_fd_ = -1;
+  wakeup_write_fd_ = -1;
+#endif
+}
+
+Result<bool> EventPoller::Wait(socket_t handle, int timeout_ms) {
+  return WaitHandles(&handle, handle != kInvalidSocket ? 1U : 0U, timeout_ms);
+}
+
+Result<bool> EventPoller::Wait(const std::vector<socket_t>& handles,
+                               int timeout_ms) {
+  return WaitHandles(handles.data(), handles.size(), timeout_ms);
+}
+
+Result<bool> EventPoller::Wait(const std::vector<socket_t>& handles,
+                               int timeout_ms,
+                               std::vector<uint8_t>& states) {
+  if (!IsOpen()) {
+    return Result<bool>::Err(ErrorCode::kNotInitialized,
+                             "EventPoller not opened");
+  }
+
+  // 只有 Wait() 所在的线程使用，复用以免每次等待分配
+#ifdef _WIN32
+  thread_local std::vector<WSAPOLLFD> fds;
+#else
+  thread_local std::vector<pollfd> fds;
+#endif
+  fds.resize(handles.size() + 1);
+#ifdef _WIN32
+  fds[0].fd = wakeup_socket_;
+#else
+  fds[0].fd = wakeup_read_fd_;
+#endif
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+  for (size_t i = 0; i < handles.size(); ++i) {
+    fds[i + 1].fd = handles[i];
+    fds[i + 1].events = POLLIN;
+    fds[i + 1].revents = 0;
+  }
+
+#ifdef _WIN32
+  const int ret =
+      WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), timeout_ms);
+#else
+  const int ret = poll(fds.data(), fds.size(), timeout_ms);
+  if (ret < 0 && errno == EINTR) {
+    states.assign(handles.size(), kHandleIdle);
+    return Result<bool>::Ok(false);
+  }
+#endif
+  if (ret < 0) {
+    return Result<bool>::Err(ErrorCode::kNetworkError,
+                             "poll failed: " + LastErrorString());
+  }
+
+  if (fds[0].revents & POLLIN) {
+    DrainWakeup();
+  }
+  bool readable = false;
+  states.resize(handles.size());
+  for (size_t i = 0; i < handles.size(); ++i) {
+    const auto revents = fds[i + 1].revents;
+    if (revents & POLLNVAL) {
+      states[i] = kHandleInvalid;
+    } else if (revents & (POLLIN | POLLHUP | POLLERR)) {
+      states[i] = kHandleReadable;
+      readable = true;
+    } else {
+      states[i] = kHandleIdle;
+    }
+  }
+  return Result<bool>::Ok(readable);
+}
+
+Result<bool> EventPoller::WaitHandles(const socket_t* handles,
+                                      size_t count,
+                                      int timeout_ms) {
+  if (!IsOpen()) {
+    return Result<bool>::Err(ErrorCode::kNotInitialized,
+                             "EventPoller not opened");
+  }
+  if (count > kMaxHandles) {
+    return Result<bool>::Err(ErrorCode::kInvalidParameter,
+                             "Too many handles to poll");
+  }
+
+#ifdef _WIN32
+  WSAPOLLFD fds[kMaxHandles + 1] = {};
+  fds[0].fd = wakeup_socket_;
+#else
+  pollfd fds[kMaxHandles + 1] = {};
+  fds[0].fd = wakeup_read_fd_;
+#endif
+  fds[0].events = POLLIN;
+  for (size_t i = 0; i < count; ++i) {
+    fds[i + 1].fd = handles[i];
+    fds[i + 1].events = POLLIN;
+  }
+  const auto total = static_cast<unsigned>(count + 1);
+
+#ifdef _WIN32
+  const int ret = WSAPoll(fds, total, timeout_ms);
+#else
+  const int ret = poll(fds, total, timeout_ms);
+  if (ret < 0 && errno == EINTR) {
+    return Result<bool>::Ok(false);
+  }
+#endif
+  if (ret < 0) {
+    return Result<bool>::Err(ErrorCode::kNetworkError,
+                             "poll failed: " + LastErrorString());
+  }
+
+  if (fds[0].revents & POLLIN) {
+    DrainWakeup();
+  }
+  bool readable = false;
+  for (size_t i = 1; i < total; ++i) {
+    if (fds[i].revents & (POLLERR | POLLNVAL)) {
+      return Result<bool>::Err(ErrorCode::kNetworkError,
+                               "Socket error while polling");
+    }
+    // POLLHUP 时仍交给调用方读取，由 recv 报告具体错误
+    readable = readable || (fds[i].revents & (POLLIN | POLLHUP)) != 0;
+  }
+  return Result<bool>::Ok(readable);
+}
+
+void EventPoller::Wakeup() {
+  if (wakeup_pending_.exchange(true, std::memory_order_acq_rel)) {
+    return;  // 上一次唤醒尚未被取走
+  }
+#ifdef _WIN32
+  const char byte = 1;
+  send(wakeup_socket_, &byte, 1, 0);
+#else
+  const uint64_t value = 1;
+  // eventfd 只接受 8 字节写入；pipe 写入同样的 8 字节即可
+  [[maybe_unused]] const ssize_t written =
+      write(wakeup_write_fd_, &value, sizeof(value));
+#endif
+}
+
+void EventPoller::DrainWakeup() {
+  // 先清除标志再读取：读取之后到来的 Wakeup() 会重新写入，不会丢失
+  wakeup_pending_.store(false, std::memory_order_release);
+#ifdef _WIN32
+  char buffer[64];
+  while (recv(wakeup_socket_, buffer, sizeof(buffer), 0) > 0) {
+  }
+#else
+  uint64_t buffer[8];
+  while (read(wakeup_read_fd_, buffer, sizeof(buffer)) > 0) {
+  }
+#endif
+}
+
+}  // namespace zenremote
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "common/error.h"
+#include "network/io/socket_types.h"
+
+namespace zenremote {
+
+/**
+ * @brief 可唤醒的可读事件等待器
+ *
+ * 在一次 poll 中同时等待 socket 可读与内部唤醒句柄：
+ * - Linux: eventfd
+ * - 其他 POSIX: 非阻塞 pipe
+ * - Windows: 连接到自身的回环 UDP socket（WSAPoll 只接受 socket）
+ *
+ * 其他线程通过 Wakeup() 让正在 Wait() 的线程立即返回，用于关闭、投递任务
+ * 或重新计算超时。未取走的唤醒会合并，连续多次 Wakeup() 只产生一次系统调用。
+ *
+ * @note Wait() 只能由一个线程调用；Wakeup() 线程安全
+ */
+class EventPoller {
+ public:
+  EventPoller();
+  ~EventPoller();
+
+  EventPoller(const EventPoller&) = delete;
+  EventPoller& operator=(const EventPoller&) = delete;
+
+  /// @brief 创建唤醒句柄
+  Result<void> Open();
+
+  void Close();
+
+  bool IsOpen() const;
+
+  /// @brief 一次等待的 socket 数上限（不含唤醒句柄）
+  static constexpr size_t kMaxHandles = 32;
+
+  /**
+   * @brief 等待 handle 可读或被唤醒
+   * @param handle 要等待的 socket，kInvalidSocket 表示只等待唤醒
+   * @param timeout_ms 超时时间 (毫秒)，-1 表示无限等待
+   * @return handle 可读返回 true；超时、被唤醒或被信号中断返回 false
+   */
+  Result<bool> Wait(socket_t handle, int timeout_ms);
+
+  /**
+   * @brief 等待任一 handle 可读或被唤醒
+   * @param handles 要等待的 socket（至多 kMaxHandles 个），为空表示只等待唤醒
+   * @return 至少一个 handle 可读返回 true
+   */
+  Result<bool> Wait(const std::vector<socket_t>& handles, int timeout_ms);
+
+  /**
+   * @brief 等待任一 handle 可读或被唤醒，并报告各 handle 的状态
+   *
+   * 不受 kMaxHandles 限制，供一个线程服务多个连接的 NetworkReactor 使用。
+   * 单个 socket 出错不使整个等待失败：出错或挂断的 handle 同样标记为可读，
+   * 由调用方的 recv 报告具体错误；已关闭的句柄标记为 kHandleInvalid。
+   * @param[out] states 与 handles 等长，取值为 kHandle* 常量
+   * @return 至少一个 handle 可读返回 true
+   */
+  Result<bool> Wait(const std::vector<socket_t>& handles,
+                    int timeout_ms,
+                    std::vector<uint8_t>& states);
+
+  static constexpr uint8_t kHandleIdle = 0;
+  static constexpr uint8_t kHandleReadable = 1;
+  static constexpr uint8_t kHandleInvalid = 2;
+
+  /// @brief 唤醒正在（或下一次）Wait() 的线程
+  void Wakeup();
+
+ private:
+  Result<bool> WaitHandles(const socket_t* handles,
+                           size_t count,
+                           int timeout_ms);
+  void DrainWakeup();
+
+#ifdef _WIN32
+  socket_t wakeup_socket_ = kInvalidSocket;
+#else
+  int wakeup_read_fd_ = -1;
+  int wakeup_write_fd_ = -1;  ///< eventfd 时与 wakeup_read_fd_ 相同
+#endif
+  std::atomic<bool> wakeup_pending_{false};
+};
+
+}  // namespace zenremote
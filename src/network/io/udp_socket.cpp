@@ -75,13 +75,30 @@ bool UdpSocket::SendTo(const uint8_t* data,
     return false;
   }
 
-  sockaddr_in addr{};
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(port);
-  inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+  sockaddr_storage addr{};
+  socklen_t addr_len = 0;
+  if (family_ == AF_INET6) {
+    auto* addr6 = reinterpret_cast<sockaddr_in6*>(&addr);
+    addr6->sin6_family = AF_INET6;
+    addr6->sin6_port = htons(port);
+    if (inet_pton(AF_INET6, ip.c_str(), &addr6->sin6_addr) != 1) {
+      ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "Invalid IPv6 destination: {}", ip);
+      return false;
+    }
+    addr_len = sizeof(sockaddr_in6);
+  } else {
+    auto* addr4 = reinterpret_cast<sockaddr_in*>(&addr);
+    addr4->sin_family = AF_INET;
+    addr4->sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr4->sin_addr) != 1) {
+      ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "Invalid IPv4 destination: {}", ip);
+      return false;
+    }
+    addr_len = sizeof(sockaddr_in);
+  }
 
   int sent = sendto(socket_fd_, reinterpret_cast<const char*>(data), length, 0,
-                    reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+                    reinterpret_cast<sockaddr*>(&addr), addr_len);
 
   if (sent < 0) {
     ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "sendto failed: {}",
@@ -108,7 +125,7 @@ bool UdpSocket::RecvFrom(uint8_t* buffer,
     return false;
   }
 
-  sockaddr_in addr{};
+  sockaddr_storage addr{};
   socklen_t addr_len = sizeof(addr);
 
   int received = recvfrom(socket_fd_, reinterpret_cast<char*>(buffer), length,
@@ -135,14 +152,37 @@ bool UdpSocket::RecvFrom(uint8_t* buffer,
   stats_.packets_received++;
 
   // Extract sender address
-  char ip_buffer[INET_ADDRSTRLEN];
-  inet_ntop(AF_INET, &addr.sin_addr, ip_buffer, sizeof(ip_buffer));
+  char ip_buffer[INET6_ADDRSTRLEN];
+  if (addr.ss_family == AF_INET6) {
+    const auto* addr6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+    inet_ntop(AF_INET6, &addr6->sin6_addr, ip_buffer, sizeof(ip_buffer));
+    from_port = ntohs(addr6->sin6_port);
+  } else {
+    const auto* addr4 = reinterpret_cast<const sockaddr_in*>(&addr);
+    inet_ntop(AF_INET, &addr4->sin_addr, ip_buffer, sizeof(ip_buffer));
+    from_port = ntohs(addr4->sin_port);
+  }
   from_ip = ip_buffer;
-  from_port = ntohs(addr.sin_port);
 
   return true;
 }
 
+uint16_t UdpSocket::GetLocalPort() const {
+  if (!IsOpen()) {
+    return 0;
+  }
+  sockaddr_storage addr{};
+  socklen_t addr_len = sizeof(addr);
+  if (getsockname(socket_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len) !=
+      0) {
+    return 0;
+  }
+  if (addr.ss_family == AF_INET6) {
+    return ntohs(reinterpret_cast<const sockaddr_in6*>(&addr)->sin6_port);
+  }
+  return ntohs(reinterpret_cast<const sockaddr_in*>(&addr)->sin_port);
+}
+
 bool UdpSocket::WaitForRead(int timeout_ms) {
   fd_set read_fds;
   FD_ZERO(&read_fds);
@@ -164,7 +204,8 @@ bool UdpSocket::WaitForRead(int timeout_ms) {
 }
 
 bool UdpSocket::CreateSocket() {
-  socket_fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  family_ = IsIpv6Address(config_.local_ip) ? AF_INET6 : AF_INET;
+  socket_fd_ = socket(family_, SOCK_DGRAM, IPPROTO_UDP);
   if (socket_fd_ == kInvalidSocket) {
     ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "socket() failed: {}",
                     GetLastErrorString());
@@ -174,6 +215,32 @@ bool UdpSocket::CreateSocket() {
 }
 
 bool UdpSocket::BindSocket() {
+  if (family_ == AF_INET6) {
+    // 只收发 IPv6，IPv4 由单独的 socket 负责，避免映射地址混入
+    int v6_only = 1;
+    setsockopt(socket_fd_, IPPROTO_IPV6, IPV6_V6ONLY,
+               reinterpret_cast<const char*>(&v6_only), sizeof(v6_only));
+
+    sockaddr_in6 addr6{};
+    addr6.sin6_family = AF_INET6;
+    addr6.sin6_port = htons(config_.local_port);
+    if (config_.local_ip == "::") {
+      addr6.sin6_addr = in6addr_any;
+    } else if (inet_pton(AF_INET6, config_.local_ip.c_str(),
+                         &addr6.sin6_addr) != 1) {
+      ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "Invalid IPv6 address: {}",
+                      config_.local_ip);
+      return false;
+    }
+    if (bind(socket_fd_, reinterpret_cast<sockaddr*>(&addr6), sizeof(addr6)) <
+        0) {
+      ZENREMOTE_ERROR(LOG_MODULE_NETWORK, "bind failed: {}",
+                      GetLastErrorString());
+      return false;
+    }
+    return true;
+  }
+
   sockaddr_in addr{};
   addr.sin_family = AF_INET;
   addr.sin_port = htons(config_.local_port);
@@ -4,25 +4,16 @@
 #include <cstdint>
 #include <string>
 
-#ifdef _WIN32
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#else
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <sys/socket.h>
-#include <unistd.h>
-#endif
+#include "network/io/socket_types.h"
 
 namespace zenremote {
 
-#ifdef _WIN32
-using socket_t = SOCKET;
-constexpr socket_t kInvalidSocket = INVALID_SOCKET;
-#else
-using socket_t = int;
-constexpr socket_t kInvalidSocket = -1;
-#endif
+/**
+ * @brief 判断字符串是否为 IPv6 地址文本（含 ':'）
+ */
+inline bool IsIpv6Address(const std::string& ip) {
+  return ip.find(':') != std::string::npos;
+}
 
 /**
  * @brief 网络 I/O 层 - 纯 UDP Socket 封装
@@ -49,7 +40,7 @@ class UdpSocket {
    * @brief Socket 配置
    */
   struct Config {
-    std::string local_ip;                  ///< 本地绑定 IP (0.0.0.0 = 所有接口)
+    std::string local_ip;  ///< 本地绑定 IP (0.0.0.0 = 所有接口，含 ':' 为 IPv6)
     uint16_t local_port = 0;               ///< 本地绑定端口 (0 = 自动分配)
     int socket_buffer_size = 1024 * 1024;  ///< Socket 缓冲区大小 (默认 1MB)
     int recv_timeout_ms = 1000;            ///< 接收超时时间 (毫秒)
@@ -129,9 +120,20 @@ class UdpSocket {
    */
   socket_t GetHandle() const { return socket_fd_; }
 
+  /**
+   * @brief 地址族 (AF_INET / AF_INET6)，由 local_ip 决定
+   */
+  int GetFamily() const { return family_; }
+
+  /**
+   * @brief 实际绑定的本地端口 (local_port 为 0 时由系统分配)
+   */
+  uint16_t GetLocalPort() const;
+
  private:
   Config config_;
   socket_t socket_fd_ = kInvalidSocket;
+  int family_ = AF_INET;
   Stats stats_;
 
   bool CreateSocket();
@@ -1,11 +1,50 @@
 #include "network/protocol/handshake.h"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <random>
 
 #include "common/log_manager.h"
 
 namespace zenremote {
 
+namespace {
+
+std::array<uint8_t, kResumeNonceSize> GenerateResumeNonce() {
+  std::random_device random;
+  std::array<uint8_t, kResumeNonceSize> nonce;
+  for (size_t i = 0; i < nonce.size(); i += 4) {
+    const uint32_t value = random();
+    for (size_t j = 0; j < 4; ++j) {
+      nonce[i + j] = static_cast<uint8_t>(value >> (8 * j));
+    }
+  }
+  return nonce;
+}
+
+static_assert(kResumeBinderSize == std::tuple_size<Sha256Digest>::value,
+              "binder is an HMAC-SHA256 digest");
+
+/// @brief 票据带恢复密钥时校验 binder（常量时间比较）
+bool VerifyResumeBinder(const ResumptionTicket& ticket,
+                        const ResumePayload& resume,
+                        const std::vector<uint8_t>& payload) {
+  if (!ticket.resumption_secret.has_value()) {
+    return true;  // 未启用 SRTP 的会话没有共享密钥可供证明
+  }
+  const auto expected = ComputeResumeBinder(*ticket.resumption_secret,
+                                            payload.data(),
+                                            kResumeBinderOffset);
+  uint8_t diff = 0;
+  for (size_t i = 0; i < kResumeBinderSize; ++i) {
+    diff |= static_cast<uint8_t>(expected[i] ^ resume.binder[i]);
+  }
+  return diff == 0;
+}
+
+}  // namespace
+
 HandshakeManager::HandshakeManager(uint32_t ssrc, BaseConnection* connection)
     : ssrc_(ssrc), connection_(connection) {
   rtp_sender_ = std::make_unique<RTPSender>(ssrc, connection);
@@ -26,6 +65,11 @@ bool HandshakeManager::InitiateHandshake(uint32_t session_id) {
   payload.ssrc = ssrc_;
   payload.supported_codecs = 0x03;
   payload.capabilities_flags = 0x0007;
+  if (srtp_enabled_) {
+    key_pair_ = GenerateX25519KeyPair();
+    payload.capabilities_flags |= kCapabilitySrtp;
+    payload.key_share = key_pair_.public_key;
+  }
 
   if (!SendHandshake(ControlMessageType::kHandshake, payload)) {
     state_ = HandshakeState::kFailed;
@@ -72,7 +116,32 @@ bool HandshakeManager::WaitForHandshakeResponse(int timeout_ms) {
     return false;
   }
 
+  if (response_payload->key_share.has_value() != srtp_enabled_) {
+    ZENREMOTE_ERROR("SRTP negotiation mismatch (local {})",
+                    srtp_enabled_ ? "enabled" : "disabled");
+    state_ = HandshakeState::kFailed;
+    return false;
+  }
+
   remote_ssrc_ = response_payload->ssrc;
+  if (srtp_enabled_ && !EstablishSrtp(*response_payload->key_share, ssrc_,
+                                      remote_ssrc_, true)) {
+    state_ = HandshakeState::kFailed;
+    return false;
+  }
+
+  const size_t ticket_offset = HandshakeWireSize(*response_payload);
+  if (ctrl_msg->payload.size() > ticket_offset) {
+    ticket_ = ParseResumptionTicket(ctrl_msg->payload.data() + ticket_offset,
+                                    ctrl_msg->payload.size() - ticket_offset);
+    if (ticket_.has_value()) {
+      parameters_ = ticket_->parameters;
+      if (master_secret_.has_value()) {
+        ticket_->resumption_secret =
+            DeriveResumptionSecret(*master_secret_, ticket_->ticket_id);
+      }
+    }
+  }
   state_ = HandshakeState::kCompleted;
 
   ZENREMOTE_INFO("Handshake completed: remote_ssrc=0x{:08X}", remote_ssrc_);
@@ -90,8 +159,28 @@ bool HandshakeManager::SendHandshakeResponse(uint32_t session_id,
   payload.ssrc = ssrc_;
   payload.supported_codecs = 0x03;
   payload.capabilities_flags = 0x0007;
+  if (srtp_enabled_) {
+    if (!peer_key_share_.has_value()) {
+      ZENREMOTE_ERROR("SRTP enabled but no key share from peer");
+      state_ = HandshakeState::kFailed;
+      return false;
+    }
+    key_pair_ = GenerateX25519KeyPair();
+    payload.capabilities_flags |= kCapabilitySrtp;
+    payload.key_share = key_pair_.public_key;
+    if (!EstablishSrtp(*peer_key_share_, remote_ssrc, ssrc_, false)) {
+      state_ = HandshakeState::kFailed;
+      return false;
+    }
+  }
 
-  if (!SendHandshake(ControlMessageType::kHandshakeAck, payload)) {
+  auto data = SerializeHandshake(payload);
+  if (ticket_cache_) {
+    auto ticket = ticket_cache_->Issue(session_id, remote_ssrc, ssrc_,
+                                       parameters_, master_secret_);
+    SerializeResumptionTicket(ticket, data);
+  }
+  if (!SendControl(ControlMessageType::kHandshakeAck, std::move(data))) {
     state_ = HandshakeState::kFailed;
     return false;
   }
@@ -113,6 +202,10 @@ bool HandshakeManager::WaitForHandshakeRequest(int timeout_ms) {
     return false;
   }
 
+  if (ctrl_msg->type == ControlMessageType::kResume) {
+    return HandleResumeRequest(*ctrl_msg);
+  }
+
   if (ctrl_msg->type != ControlMessageType::kHandshake) {
     ZENREMOTE_ERROR("Expected handshake request, got type {}",
                     static_cast<int>(ctrl_msg->type));
@@ -131,19 +224,247 @@ bool HandshakeManager::WaitForHandshakeRequest(int timeout_ms) {
       "remote_ssrc=0x{:08X}",
       request_payload->session_id, request_payload->ssrc);
 
+  if (request_payload->key_share.has_value() != srtp_enabled_) {
+    ZENREMOTE_ERROR("SRTP negotiation mismatch (local {})",
+                    srtp_enabled_ ? "enabled" : "disabled");
+    return false;
+  }
+  peer_key_share_ = request_payload->key_share;
+
+  // 完整握手之前不会有合法的媒体，缓存的只可能是被拒绝的 0-RTT 数据
+  early_packets_.clear();
   return SendHandshakeResponse(request_payload->session_id,
                                request_payload->ssrc);
 }
 
+bool HandshakeManager::ResumeSession(const ResumptionTicket& ticket) {
+  if (state_ != HandshakeState::kIdle) {
+    ZENREMOTE_ERROR("Handshake already in progress or completed");
+    return false;
+  }
+  if (ticket.client_ssrc != ssrc_) {
+    ZENREMOTE_ERROR("Ticket SSRC 0x{:08X} does not match local SSRC 0x{:08X}",
+                    ticket.client_ssrc, ssrc_);
+    return false;
+  }
+  if (ticket.resumption_secret.has_value() != srtp_enabled_) {
+    ZENREMOTE_ERROR("Ticket SRTP state does not match local configuration");
+    return false;
+  }
+
+  ResumePayload resume;
+  resume.ticket_id = ticket.ticket_id;
+  resume.session_id = ticket.session_id;
+  resume.ssrc = ssrc_;
+  resume.client_nonce = GenerateResumeNonce();
+  auto resume_payload = SerializeResumePayload(resume);
+  if (ticket.resumption_secret.has_value()) {
+    const auto binder = ComputeResumeBinder(
+        *ticket.resumption_secret, resume_payload.data(), kResumeBinderOffset);
+    std::copy(binder.begin(), binder.end(),
+              resume_payload.begin() + kResumeBinderOffset);
+  }
+  if (!SendControl(ControlMessageType::kResume, std::move(resume_payload))) {
+    state_ = HandshakeState::kFailed;
+    return false;
+  }
+
+  // 0-RTT：沿用票据中的会话状态，调用方可立即发送媒体
+  session_id_ = ticket.session_id;
+  remote_ssrc_ = ticket.server_ssrc;
+  parameters_ = ticket.parameters;
+  if (srtp_enabled_) {
+    StartSrtpSession(
+        DeriveResumedSessionSecret(*ticket.resumption_secret,
+                                   resume.client_nonce.data(),
+                                   resume.client_nonce.size()),
+        true);
+  }
+  ticket_.reset();  // 票据是一次性的
+  state_ = HandshakeState::kResumePending;
+  ZENREMOTE_INFO("Resume request sent: session_id=0x{:08X}", session_id_);
+  return true;
+}
+
+bool HandshakeManager::WaitForResumeResponse(int timeout_ms) {
+  if (state_ != HandshakeState::kResumePending) {
+    ZENREMOTE_ERROR("Invalid state for waiting resume response");
+    return false;
+  }
+
+  auto ctrl_msg = ReceiveControlMessage(timeout_ms);
+  if (!ctrl_msg.has_value() ||
+      ctrl_msg->type != ControlMessageType::kResumeAck ||
+      ctrl_msg->payload.size() < kResumeAckHeaderSize) {
+    ZENREMOTE_ERROR("Failed to receive resume response");
+    state_ = HandshakeState::kFailed;
+    return false;
+  }
+
+  const uint8_t* data = ctrl_msg->payload.data();
+  const auto status = static_cast<ResumeStatus>(data[0]);
+  if (status != ResumeStatus::kAccepted ||
+      ReadUint32LE(data + 1) != session_id_) {
+    ZENREMOTE_WARN("Resume rejected, full handshake required");
+    state_ = HandshakeState::kIdle;
+    master_secret_.reset();
+    srtp_session_.reset();
+    return false;
+  }
+
+  ticket_ = ParseResumptionTicket(data + kResumeAckHeaderSize,
+                                  ctrl_msg->payload.size() -
+                                      kResumeAckHeaderSize);
+  if (ticket_.has_value() && master_secret_.has_value()) {
+    ticket_->resumption_secret =
+        DeriveResumptionSecret(*master_secret_, ticket_->ticket_id);
+  }
+  resumed_ = true;
+  state_ = HandshakeState::kCompleted;
+  ZENREMOTE_INFO("Session resumed: session_id=0x{:08X}", session_id_);
+  return true;
+}
+
+bool HandshakeManager::HandleResumeRequest(const ControlMessage& message) {
+  auto resume =
+      ParseResumePayload(message.payload.data(), message.payload.size());
+  std::optional<ResumptionTicket> ticket;
+  if (resume.has_value() && ticket_cache_) {
+    ticket = ticket_cache_->Find(resume->ticket_id, resume->session_id);
+  }
+  if (ticket.has_value()) {
+    // 票据 ID 与会话 ID 都以明文传输过：binder 不对的请求直接忽略，不兑换
+    // 票据、不回复、不丢弃早到报文，真正的控制端仍可凭票据恢复
+    if (!VerifyResumeBinder(*ticket, *resume, message.payload)) {
+      ZENREMOTE_WARN("Ignoring resume request with invalid binder");
+      return false;
+    }
+    ticket = ticket_cache_->Redeem(resume->ticket_id, resume->session_id);
+  }
+  const bool accepted =
+      ticket.has_value() && ticket->client_ssrc == resume->ssrc &&
+      ticket->server_ssrc == ssrc_ &&
+      ticket->resumption_secret.has_value() == srtp_enabled_;
+
+  std::vector<uint8_t> payload;
+  payload.push_back(static_cast<uint8_t>(accepted ? ResumeStatus::kAccepted
+                                                  : ResumeStatus::kRejected));
+  WriteUint32LE(resume.has_value() ? resume->session_id : 0, payload);
+  WriteUint32LE(ssrc_, payload);
+
+  if (!accepted) {
+    ZENREMOTE_WARN("Rejecting resume request");
+    SendControl(ControlMessageType::kResumeAck, std::move(payload));
+    early_packets_.clear();  // 未通过验证的 0-RTT 数据不交付
+    return false;
+  }
+
+  session_id_ = ticket->session_id;
+  remote_ssrc_ = ticket->client_ssrc;
+  parameters_ = ticket->parameters;
+  if (srtp_enabled_) {
+    StartSrtpSession(
+        DeriveResumedSessionSecret(*ticket->resumption_secret,
+                                   resume->client_nonce.data(),
+                                   resume->client_nonce.size()),
+        false);
+    DecryptEarlyPackets();
+  }
+  auto next_ticket = ticket_cache_->Issue(session_id_, remote_ssrc_, ssrc_,
+                                          parameters_, master_secret_);
+  SerializeResumptionTicket(next_ticket, payload);
+  if (!SendControl(ControlMessageType::kResumeAck, std::move(payload))) {
+    state_ = HandshakeState::kFailed;
+    return false;
+  }
+
+  resumed_ = true;
+  state_ = HandshakeState::kCompleted;
+  ZENREMOTE_INFO("Session resumed: session_id=0x{:08X}, remote_ssrc=0x{:08X}",
+                 session_id_, remote_ssrc_);
+  return true;
+}
+
+std::vector<uint8_t> HandshakeManager::GetMigrationKey() const {
+  if (!master_secret_.has_value()) {
+    return {};
+  }
+  return DeriveMigrationKey(*master_secret_);
+}
+
+bool HandshakeManager::EstablishSrtp(const HandshakeKeyShare& peer_key_share,
+                                     uint32_t client_ssrc,
+                                     uint32_t server_ssrc,
+                                     bool is_client) {
+  X25519Key shared_secret;
+  if (!X25519SharedSecret(key_pair_.private_key, peer_key_share,
+                          shared_secret)) {
+    ZENREMOTE_ERROR("Invalid SRTP key share from peer");
+    return false;
+  }
+  StartSrtpSession(
+      DeriveSrtpMasterSecret(shared_secret.data(), shared_secret.size(),
+                             session_id_, client_ssrc, server_ssrc),
+      is_client);
+  // 一次性私钥用完即弃
+  key_pair_ = X25519KeyPair{};
+  return true;
+}
+
+void HandshakeManager::StartSrtpSession(const SrtpMasterSecret& master_secret,
+                                        bool is_client) {
+  master_secret_ = master_secret;
+  const auto keys = DeriveSrtpKeys(master_secret);
+  srtp_session_ =
+      is_client ? std::make_shared<SrtpSession>(keys.client_to_server,
+                                                keys.server_to_client)
+                : std::make_shared<SrtpSession>(keys.server_to_client,
+                                                keys.client_to_server);
+  ZENREMOTE_INFO("SRTP session established (AES-GCM {})",
+                 srtp_session_->IsHardwareAccelerated() ? "AES-NI"
+                                                        : "portable");
+}
+
+void HandshakeManager::DecryptEarlyPackets() {
+  std::vector<ReceivedPacket> decrypted;
+  decrypted.reserve(early_packets_.size());
+  for (auto& packet : early_packets_) {
+    RtpPacket rtp_packet;
+    rtp_packet.header = packet.header;
+    rtp_packet.payload = std::move(packet.payload);
+    auto buffer = SerializeRtpPacket(rtp_packet);
+    auto length = srtp_session_->UnprotectRtp(buffer.data(), buffer.size());
+    auto plain = length.has_value()
+                     ? ParseRtpPacket(buffer.data(), *length)
+                     : std::nullopt;
+    if (!plain.has_value()) {
+      ZENREMOTE_WARN("Dropping early packet that failed SRTP check");
+      continue;
+    }
+    decrypted.push_back(
+        {plain->header, std::move(plain->payload), packet.arrival_time});
+  }
+  early_packets_.swap(decrypted);
+}
+
+std::vector<ReceivedPacket> HandshakeManager::TakeEarlyPackets() {
+  std::vector<ReceivedPacket> packets;
+  packets.swap(early_packets_);
+  return packets;
+}
+
 bool HandshakeManager::SendHandshake(ControlMessageType type,
                                      const HandshakePayload& payload) {
-  auto handshake_data = SerializeHandshake(payload);
+  return SendControl(type, SerializeHandshake(payload));
+}
 
+bool HandshakeManager::SendControl(ControlMessageType type,
+                                   std::vector<uint8_t> payload) {
   ControlMessage ctrl_msg;
   ctrl_msg.type = type;
   ctrl_msg.sequence = 0;
   ctrl_msg.timestamp_ms = GetTimestampMs();
-  ctrl_msg.payload = handshake_data;
+  ctrl_msg.payload = std::move(payload);
 
   auto ctrl_data = SerializeControlMessage(ctrl_msg);
 
@@ -153,18 +474,34 @@ bool HandshakeManager::SendHandshake(ControlMessageType type,
 
 std::optional<ControlMessage> HandshakeManager::ReceiveControlMessage(
     int timeout_ms) {
-  auto received_packet = rtp_receiver_->ReceivePacket(connection_, timeout_ms);
-  if (!received_packet.has_value()) {
-    return std::nullopt;
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout_ms);
+  while (true) {
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now())
+            .count();
+    if (remaining <= 0) {
+      return std::nullopt;
+    }
+    auto received_packet = rtp_receiver_->ReceivePacket(
+        connection_, static_cast<int>(remaining));
+    if (!received_packet.has_value()) {
+      continue;
+    }
+
+    if (received_packet->header.payload_type == PayloadType::kControl) {
+      return ParseControlMessage(received_packet->payload.data(),
+                                 received_packet->payload.size());
+    }
+
+    // 对端以 0-RTT 发出的媒体/输入可能先于握手消息到达，缓存而非丢弃
+    if (early_packets_.size() < kMaxEarlyPackets) {
+      early_packets_.push_back(std::move(*received_packet));
+    } else {
+      ZENREMOTE_WARN("Early packet buffer full, dropping packet");
+    }
   }
-
-  if (received_packet->header.payload_type != PayloadType::kControl) {
-    ZENREMOTE_WARN("Received non-control packet during handshake");
-    return std::nullopt;
-  }
-
-  return ParseControlMessage(received_packet->payload.data(),
-                             received_packet->payload.size());
 }
 
 }  // namespace zenremote
@@ -1,12 +1,17 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <vector>
 
+#include "common/x25519.h"
 #include "network/connection/base_connection.h"
 #include "network/protocol/protocol.h"
+#include "network/protocol/resumption_cache.h"
 #include "network/protocol/rtp_receiver.h"
 #include "network/protocol/rtp_sender.h"
+#include "network/protocol/srtp.h"
 
 namespace zenremote {
 
@@ -14,12 +19,34 @@ enum class HandshakeState {
   kIdle,
   kRequestSent,
   kResponseReceived,
+  kResumePending,  ///< 已发出恢复请求，可立即发送媒体/输入（0-RTT）
   kCompleted,
   kFailed,
 };
 
+/**
+ * @brief 握手与会话恢复
+ *
+ * 完整握手：InitiateHandshake → WaitForHandshakeResponse（控制端），
+ * WaitForHandshakeRequest（被控端）。被控端设置了 ResumptionTicketCache 时，
+ * 在 HandshakeAck 中附带恢复票据。
+ *
+ * 会话恢复（网络闪断后重连）：控制端 ResumeSession(ticket) 发出恢复请求后
+ * 立即进入 kResumePending，沿用票据中的 SSRC 与协商参数直接发送媒体/输入，
+ * 不等待往返；WaitForResumeResponse 并行确认。被控端在恢复确认前收到的
+ * 媒体包不会丢弃，通过 TakeEarlyPackets() 取出。票据被拒绝时状态回到
+ * kIdle，调用方改走完整握手。
+ *
+ * SRTP（EnableSrtp）：握手消息本身是明文，双方在握手负载后附带一次性
+ * X25519 公钥，共享密钥经 HKDF 派生会话密钥。恢复的会话由票据的恢复密钥与
+ * kResume 中的随机 nonce 派生新密钥，0-RTT 媒体同样加密；被控端在接受恢复
+ * 后解密缓存的早到报文。kResume 带以恢复密钥计算的 binder，被控端校验通过
+ * 后才兑换票据，binder 不符的请求被忽略且不消耗票据。
+ */
 class HandshakeManager {
  public:
+  static constexpr size_t kMaxEarlyPackets = 256;
+
   explicit HandshakeManager(uint32_t ssrc, BaseConnection* connection);
 
   bool InitiateHandshake(uint32_t session_id);
@@ -28,16 +55,78 @@ class HandshakeManager {
 
   bool SendHandshakeResponse(uint32_t session_id, uint32_t remote_ssrc);
 
+  /**
+   * @brief 等待完整握手或恢复请求（被控端）
+   * @return 握手完成或恢复成功返回 true；恢复被拒绝时返回 false 且状态仍为
+   *         kIdle，可继续等待控制端的完整握手
+   */
   bool WaitForHandshakeRequest(int timeout_ms = 5000);
 
+  /// @brief 本端协商参数，签发票据时写入（被控端）
+  void SetSessionParameters(const SessionParameters& parameters) {
+    parameters_ = parameters;
+  }
+
+  /**
+   * @brief 启用 SRTP，握手前调用，双方须一致
+   *
+   * 一方启用而另一方未启用时握手失败，不会回退到明文。
+   */
+  void EnableSrtp(bool enable) { srtp_enabled_ = enable; }
+
+  /// @brief 握手或恢复后的 SRTP 会话，供媒体收发共用；未启用时为空
+  std::shared_ptr<SrtpSession> GetSrtpSession() const { return srtp_session_; }
+
+  /// @brief 连接迁移探测的签名密钥（DirectConnection::Config::migration_key），
+  ///        由会话主密钥派生；未启用 SRTP 时为空，不应开启迁移
+  std::vector<uint8_t> GetMigrationKey() const;
+
+  /// @brief 启用票据签发与会话恢复（被控端），cache 需比本对象存活更久
+  void SetTicketCache(ResumptionTicketCache* cache) { ticket_cache_ = cache; }
+
+  /**
+   * @brief 以票据恢复会话（控制端），发出请求后立即可发送媒体
+   * @return 票据与本端 SSRC 不匹配或发送失败时返回 false
+   */
+  bool ResumeSession(const ResumptionTicket& ticket);
+
+  /// @brief 等待恢复确认（控制端），成功后换发的新票据可通过
+  ///        GetResumptionTicket() 取得
+  bool WaitForResumeResponse(int timeout_ms = 3000);
+
   HandshakeState GetState() const { return state_; }
   bool IsCompleted() const { return state_ == HandshakeState::kCompleted; }
+  bool CanSendMedia() const {
+    return state_ == HandshakeState::kCompleted ||
+           state_ == HandshakeState::kResumePending;
+  }
+  bool IsResumed() const { return resumed_; }
 
   uint32_t GetRemoteSSRC() const { return remote_ssrc_; }
   uint32_t GetSessionID() const { return session_id_; }
 
+  /// @brief 协商参数；恢复的会话返回票据中缓存的参数
+  const SessionParameters& GetSessionParameters() const { return parameters_; }
+
+  /// @brief 最近收到的恢复票据（控制端）
+  const std::optional<ResumptionTicket>& GetResumptionTicket() const {
+    return ticket_;
+  }
+
+  /// @brief 取出握手期间收到的非控制包（如 0-RTT 媒体），按到达顺序
+  std::vector<ReceivedPacket> TakeEarlyPackets();
+
  private:
   bool SendHandshake(ControlMessageType type, const HandshakePayload& payload);
+  bool SendControl(ControlMessageType type, std::vector<uint8_t> payload);
+  bool HandleResumeRequest(const ControlMessage& message);
+  /// @brief 由对端公钥完成 ECDH 并建立 SRTP 会话
+  bool EstablishSrtp(const HandshakeKeyShare& peer_key_share,
+                     uint32_t client_ssrc,
+                     uint32_t server_ssrc,
+                     bool is_client);
+  void StartSrtpSession(const SrtpMasterSecret& master_secret, bool is_client);
+  void DecryptEarlyPackets();
   std::optional<ControlMessage> ReceiveControlMessage(int timeout_ms);
 
   uint32_t ssrc_;
@@ -48,6 +137,18 @@ class HandshakeManager {
   HandshakeState state_ = HandshakeState::kIdle;
   uint32_t session_id_ = 0;
   uint32_t remote_ssrc_ = 0;
+
+  SessionParameters parameters_;
+  ResumptionTicketCache* ticket_cache_ = nullptr;
+  std::optional<ResumptionTicket> ticket_;
+  bool resumed_ = false;
+  std::vector<ReceivedPacket> early_packets_;
+
+  bool srtp_enabled_ = false;
+  X25519KeyPair key_pair_;
+  std::optional<HandshakeKeyShare> peer_key_share_;
+  std::optional<SrtpMasterSecret> master_secret_;
+  std::shared_ptr<SrtpSession> srtp_session_;
 };
 
 }  // namespace zenremote
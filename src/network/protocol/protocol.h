@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -20,6 +22,8 @@ constexpr uint32_t kProtocolVersion = 1;
 enum class ControlMessageType : uint8_t {
   kHandshake = 0x01,
   kHandshakeAck = 0x02,
+  kResume = 0x03,
+  kResumeAck = 0x04,
   kInputEvent = 0x10,
   kInputAck = 0x11,
   kHeartbeat = 0x20,
@@ -32,14 +36,82 @@ struct ControlMessage {
   std::vector<uint8_t> payload;
 };
 
+// 能力位：媒体与输入走 SRTP（AES-128-GCM），握手负载后附 X25519 公钥
+constexpr uint16_t kCapabilitySrtp = 0x0008;
+constexpr size_t kHandshakeKeyShareSize = 32;
+
+using HandshakeKeyShare = std::array<uint8_t, kHandshakeKeyShareSize>;
+
 struct HandshakePayload {
   uint32_t version = kProtocolVersion;
   uint32_t session_id = 0;
   uint32_t ssrc = 0;
   uint8_t supported_codecs = 0;
   uint16_t capabilities_flags = 0;
+  std::optional<HandshakeKeyShare> key_share;  ///< 仅 kCapabilitySrtp 时
+};
+
+constexpr size_t kHandshakePayloadSize = 15;
+
+// 序列化后的握手负载长度；HandshakeAck 中恢复票据紧随其后
+inline size_t HandshakeWireSize(const HandshakePayload& handshake) {
+  return kHandshakePayloadSize +
+         (handshake.key_share.has_value() ? kHandshakeKeyShareSize : 0);
+}
+
+// RTP 头部扩展映射（扩展 ID → 扩展类型）
+struct RtpExtensionMapping {
+  uint8_t id = 0;
+  uint8_t type = 0;
+};
+
+// 协商结果，随恢复票据缓存，重连后无需重新协商
+struct SessionParameters {
+  uint8_t codecs = 0;
+  uint16_t capabilities_flags = 0;
+  std::vector<RtpExtensionMapping> extensions;
+  std::vector<uint8_t> decoder_config;  ///< 解码器参数（如 H.264 SPS/PPS）
+};
+
+// 会话恢复票据：由被控端在握手完成时签发，附加在 HandshakeAck 负载之后，
+// 控制端重连时凭 ticket_id 恢复会话（一次性，恢复成功后换发新票据）
+struct ResumptionTicket {
+  uint64_t ticket_id = 0;
+  uint32_t session_id = 0;
+  uint32_t client_ssrc = 0;
+  uint32_t server_ssrc = 0;
+  uint32_t lifetime_ms = 0;
+  SessionParameters parameters;
+  // 由握手主密钥与 ticket_id 派生的恢复密钥，双方各自计算、不序列化；
+  // 未启用 SRTP 的会话为空
+  std::optional<std::array<uint8_t, 32>> resumption_secret;
+};
+
+constexpr size_t kResumeNonceSize = 16;
+constexpr size_t kResumeBinderSize = 32;
+
+// kResume 负载：控制端沿用票据中的会话 ID 与 SSRC。client_nonce 每次恢复
+// 尝试随机生成并混入恢复密钥，重试同一票据时 0-RTT 媒体不会复用 GCM nonce。
+// 票据 ID 等字段在之前的 ack 中明文传输，binder 证明请求方持有恢复密钥：
+// HMAC-SHA256 覆盖 binder 之前的全部负载，见 ComputeResumeBinder()
+struct ResumePayload {
+  uint64_t ticket_id = 0;
+  uint32_t session_id = 0;
+  uint32_t ssrc = 0;
+  std::array<uint8_t, kResumeNonceSize> client_nonce{};
+  std::array<uint8_t, kResumeBinderSize> binder{};
+};
+
+enum class ResumeStatus : uint8_t {
+  kAccepted = 0,
+  kRejected = 1,  ///< 票据未知、已使用或已过期，需要完整握手
 };
 
+// kResumeAck 负载：[status:u8][session_id:u32][ssrc:u32]，接受时后接新票据
+constexpr size_t kResumeBinderOffset = 16 + kResumeNonceSize;
+constexpr size_t kResumePayloadSize = kResumeBinderOffset + kResumeBinderSize;
+constexpr size_t kResumeAckHeaderSize = 9;
+
 enum class InputEventType : uint8_t {
   kMouseMove = 0,
   kMouseClick = 1,
@@ -65,6 +137,30 @@ struct AckPayload {
   uint32_t original_timestamp_ms = 0;
 };
 
+// 选择性确认：cumulative_ack 之前的序列号全部已收到（cumulative_ack 本身缺失），
+// sack_bitmap 第 i 位表示 cumulative_ack + 1 + i 已收到。
+// ack_delay_ms 为接收端合并/延迟 ACK 的耗时，发送端计算 RTT 时需扣除。
+// loss_fraction 为接收端估计的首传丢包率（x/255，同 RTCP RR），用于自适应冗余深度。
+struct SackPayload {
+  uint16_t cumulative_ack = 0;
+  uint64_t sack_bitmap = 0;
+  uint16_t ack_delay_ms = 0;
+  uint8_t loss_fraction = 0;
+};
+
+constexpr size_t kSackBitmapBits = 64;
+
+// 冗余输入块（参考 RFC 2198）：附加在 kInputEvent 主事件之后，
+// 格式为 [count:u8] + count x [sequence_back:u8][event:17B]，
+// sequence_back 为相对主事件序列号的回退量。旧版本接收端只解析前 17 字节。
+struct RedundantInputBlock {
+  uint8_t sequence_back = 0;
+  InputEvent event;
+};
+
+constexpr size_t kInputEventSize = 17;
+constexpr size_t kMaxRedundantInputBlocks = 8;
+
 inline void WriteUint16LE(uint16_t value, std::vector<uint8_t>& out) {
   out.push_back(static_cast<uint8_t>(value & 0xFFU));
   out.push_back(static_cast<uint8_t>((value >> 8U) & 0xFFU));
@@ -82,6 +178,11 @@ inline uint16_t ReadUint16LE(const uint8_t* data) {
          static_cast<uint16_t>(static_cast<uint16_t>(data[1]) << 8U);
 }
 
+inline void WriteUint64LE(uint64_t value, std::vector<uint8_t>& out) {
+  WriteUint32LE(static_cast<uint32_t>(value & 0xFFFFFFFFU), out);
+  WriteUint32LE(static_cast<uint32_t>(value >> 32U), out);
+}
+
 inline uint32_t ReadUint32LE(const uint8_t* data) {
   return static_cast<uint32_t>(data[0]) |
          (static_cast<uint32_t>(data[1]) << 8U) |
@@ -89,6 +190,16 @@ inline uint32_t ReadUint32LE(const uint8_t* data) {
          (static_cast<uint32_t>(data[3]) << 24U);
 }
 
+inline uint64_t ReadUint64LE(const uint8_t* data) {
+  return static_cast<uint64_t>(ReadUint32LE(data)) |
+         (static_cast<uint64_t>(ReadUint32LE(data + 4)) << 32U);
+}
+
+// 16 位序列号的回绕比较 (RFC 1982)
+inline bool SeqLessThan(uint16_t a, uint16_t b) {
+  return static_cast<int16_t>(static_cast<uint16_t>(a - b)) < 0;
+}
+
 inline std::vector<uint8_t> SerializeControlMessage(
     const ControlMessage& message) {
   std::vector<uint8_t> buffer;
@@ -120,12 +231,16 @@ inline std::optional<ControlMessage> ParseControlMessage(const uint8_t* data,
 inline std::vector<uint8_t> SerializeHandshake(
     const HandshakePayload& handshake) {
   std::vector<uint8_t> payload;
-  payload.reserve(14);
+  payload.reserve(HandshakeWireSize(handshake));
   WriteUint32LE(handshake.version, payload);
   WriteUint32LE(handshake.session_id, payload);
   WriteUint32LE(handshake.ssrc, payload);
   payload.push_back(handshake.supported_codecs);
   WriteUint16LE(handshake.capabilities_flags, payload);
+  if (handshake.key_share.has_value()) {
+    payload.insert(payload.end(), handshake.key_share->begin(),
+                   handshake.key_share->end());
+  }
   return payload;
 }
 
@@ -140,9 +255,107 @@ inline std::optional<HandshakePayload> ParseHandshake(const uint8_t* data,
   payload.ssrc = ReadUint32LE(data + 8);
   payload.supported_codecs = data[12];
   payload.capabilities_flags = ReadUint16LE(data + 13);
+  if ((payload.capabilities_flags & kCapabilitySrtp) &&
+      length >= kHandshakePayloadSize + kHandshakeKeyShareSize) {
+    HandshakeKeyShare key_share;
+    std::copy(data + kHandshakePayloadSize,
+              data + kHandshakePayloadSize + kHandshakeKeyShareSize,
+              key_share.begin());
+    payload.key_share = key_share;
+  }
   return payload;
 }
 
+inline void SerializeResumptionTicket(const ResumptionTicket& ticket,
+                                      std::vector<uint8_t>& out) {
+  const auto& parameters = ticket.parameters;
+  const size_t extension_count = parameters.extensions.size() < 0xFFU
+                                     ? parameters.extensions.size()
+                                     : 0xFFU;
+  const size_t config_length = parameters.decoder_config.size() < 0xFFFFU
+                                   ? parameters.decoder_config.size()
+                                   : 0xFFFFU;
+  out.reserve(out.size() + 30 + extension_count * 2 + config_length);
+  WriteUint64LE(ticket.ticket_id, out);
+  WriteUint32LE(ticket.session_id, out);
+  WriteUint32LE(ticket.client_ssrc, out);
+  WriteUint32LE(ticket.server_ssrc, out);
+  WriteUint32LE(ticket.lifetime_ms, out);
+  out.push_back(parameters.codecs);
+  WriteUint16LE(parameters.capabilities_flags, out);
+  out.push_back(static_cast<uint8_t>(extension_count));
+  for (size_t i = 0; i < extension_count; ++i) {
+    out.push_back(parameters.extensions[i].id);
+    out.push_back(parameters.extensions[i].type);
+  }
+  WriteUint16LE(static_cast<uint16_t>(config_length), out);
+  out.insert(out.end(), parameters.decoder_config.begin(),
+             parameters.decoder_config.begin() + config_length);
+}
+
+inline std::optional<ResumptionTicket> ParseResumptionTicket(
+    const uint8_t* data,
+    size_t length) {
+  // 8+4+4+4+4+1+2+1 = 28 字节定长部分
+  if (!data || length < 28) {
+    return std::nullopt;
+  }
+  ResumptionTicket ticket;
+  ticket.ticket_id = ReadUint64LE(data);
+  ticket.session_id = ReadUint32LE(data + 8);
+  ticket.client_ssrc = ReadUint32LE(data + 12);
+  ticket.server_ssrc = ReadUint32LE(data + 16);
+  ticket.lifetime_ms = ReadUint32LE(data + 20);
+  ticket.parameters.codecs = data[24];
+  ticket.parameters.capabilities_flags = ReadUint16LE(data + 25);
+  const size_t extension_count = data[27];
+  size_t offset = 28;
+  if (length < offset + extension_count * 2 + 2) {
+    return std::nullopt;
+  }
+  ticket.parameters.extensions.reserve(extension_count);
+  for (size_t i = 0; i < extension_count; ++i) {
+    ticket.parameters.extensions.push_back({data[offset], data[offset + 1]});
+    offset += 2;
+  }
+  const size_t config_length = ReadUint16LE(data + offset);
+  offset += 2;
+  if (length < offset + config_length) {
+    return std::nullopt;
+  }
+  ticket.parameters.decoder_config.assign(data + offset,
+                                          data + offset + config_length);
+  return ticket;
+}
+
+inline std::vector<uint8_t> SerializeResumePayload(
+    const ResumePayload& resume) {
+  std::vector<uint8_t> payload;
+  payload.reserve(kResumePayloadSize);
+  WriteUint64LE(resume.ticket_id, payload);
+  WriteUint32LE(resume.session_id, payload);
+  WriteUint32LE(resume.ssrc, payload);
+  payload.insert(payload.end(), resume.client_nonce.begin(),
+                 resume.client_nonce.end());
+  payload.insert(payload.end(), resume.binder.begin(), resume.binder.end());
+  return payload;
+}
+
+inline std::optional<ResumePayload> ParseResumePayload(const uint8_t* data,
+                                                       size_t length) {
+  if (!data || length < kResumePayloadSize) {
+    return std::nullopt;
+  }
+  ResumePayload resume;
+  resume.ticket_id = ReadUint64LE(data);
+  resume.session_id = ReadUint32LE(data + 8);
+  resume.ssrc = ReadUint32LE(data + 12);
+  std::copy_n(data + 16, kResumeNonceSize, resume.client_nonce.begin());
+  std::copy_n(data + kResumeBinderOffset, kResumeBinderSize,
+              resume.binder.begin());
+  return resume;
+}
+
 inline std::vector<uint8_t> SerializeInputEvent(const InputEvent& event) {
   std::vector<uint8_t> payload;
   payload.reserve(17);  // 1+2+2+1+1+2+4+4 = 17 bytes
@@ -174,6 +387,52 @@ inline std::optional<InputEvent> ParseInputEvent(const uint8_t* data,
   return event;
 }
 
+inline std::vector<uint8_t> SerializeRedundantInputEvent(
+    const InputEvent& primary,
+    const std::vector<RedundantInputBlock>& blocks) {
+  auto payload = SerializeInputEvent(primary);
+  if (blocks.empty()) {
+    return payload;
+  }
+  const size_t count = blocks.size() < kMaxRedundantInputBlocks
+                           ? blocks.size()
+                           : kMaxRedundantInputBlocks;
+  payload.reserve(kInputEventSize + 1 + count * (1 + kInputEventSize));
+  payload.push_back(static_cast<uint8_t>(count));
+  for (size_t i = 0; i < count; ++i) {
+    payload.push_back(blocks[i].sequence_back);
+    auto event = SerializeInputEvent(blocks[i].event);
+    payload.insert(payload.end(), event.begin(), event.end());
+  }
+  return payload;
+}
+
+// 解析主事件之后的冗余块；没有冗余或格式错误时返回空
+inline std::vector<RedundantInputBlock> ParseRedundantInputBlocks(
+    const uint8_t* data,
+    size_t length) {
+  std::vector<RedundantInputBlock> blocks;
+  if (!data || length <= kInputEventSize) {
+    return blocks;
+  }
+  const size_t count = data[kInputEventSize];
+  const uint8_t* cursor = data + kInputEventSize + 1;
+  const uint8_t* end = data + length;
+  if (count > kMaxRedundantInputBlocks ||
+      static_cast<size_t>(end - cursor) < count * (1 + kInputEventSize)) {
+    return blocks;
+  }
+  blocks.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    RedundantInputBlock block;
+    block.sequence_back = cursor[0];
+    block.event = *ParseInputEvent(cursor + 1, kInputEventSize);
+    blocks.push_back(block);
+    cursor += 1 + kInputEventSize;
+  }
+  return blocks;
+}
+
 inline std::vector<uint8_t> SerializeAckPayload(const AckPayload& ack) {
   std::vector<uint8_t> payload;
   payload.reserve(6);
@@ -193,4 +452,29 @@ inline std::optional<AckPayload> ParseAckPayload(const uint8_t* data,
   return ack;
 }
 
+inline std::vector<uint8_t> SerializeSackPayload(const SackPayload& sack) {
+  std::vector<uint8_t> payload;
+  payload.reserve(13);  // 2+8+2+1 = 13 bytes
+  WriteUint16LE(sack.cumulative_ack, payload);
+  WriteUint64LE(sack.sack_bitmap, payload);
+  WriteUint16LE(sack.ack_delay_ms, payload);
+  payload.push_back(sack.loss_fraction);
+  return payload;
+}
+
+inline std::optional<SackPayload> ParseSackPayload(const uint8_t* data,
+                                                   size_t length) {
+  if (!data || length < 12) {  // 2+8+2 = 12 bytes
+    return std::nullopt;
+  }
+  SackPayload sack;
+  sack.cumulative_ack = ReadUint16LE(data);
+  sack.sack_bitmap = ReadUint64LE(data + 2);
+  sack.ack_delay_ms = ReadUint16LE(data + 10);
+  if (length >= 13) {
+    sack.loss_fraction = data[12];
+  }
+  return sack;
+}
+
 }  // namespace zenremote
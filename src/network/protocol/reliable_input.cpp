@@ -1,100 +1,330 @@
 #include "network/protocol/reliable_input.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "common/log_manager.h"
-#include "network/connection/direct_connection.h"
 
 namespace zenremote {
 
+namespace {
+
+double ElapsedMs(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+}  // namespace
+
 ReliableInputSender::ReliableInputSender(uint32_t ssrc,
-                                         DirectConnection* connection)
+                                         BaseConnection* connection)
     : ssrc_(ssrc), connection_(connection) {}
 
 bool ReliableInputSender::SendInputEvent(const InputEvent& event) {
-  if (!connection_ || !connection_->IsInitialized()) {
+  if (!connection_ || !connection_->IsOpen()) {
     ZENREMOTE_ERROR("Connection not initialized");
     return false;
   }
 
-  PendingMessage msg;
-  msg.event = event;
-  msg.sequence_number = next_sequence_number_++;
-  msg.send_time = std::chrono::steady_clock::now();
-  msg.retry_count = 0;
+  // 槽位按 seq % kWindowSize 索引：只要 send_base_ 未确认，
+  // send_base_ + kWindowSize 就会覆盖它，因此按窗口跨度而非在途数判断
+  const uint16_t window_span =
+      static_cast<uint16_t>(next_sequence_number_ - send_base_);
+  if (window_span >= kWindowSize) {
+    ZENREMOTE_WARN(
+        "Input send window full (base={}, next={}, {} in flight), dropping "
+        "event",
+        send_base_, next_sequence_number_, in_flight_count_);
+    stats_.window_full_drops++;
+    return false;
+  }
 
-  if (!SendViaRTP(event, msg.sequence_number)) {
+  const uint16_t seq = next_sequence_number_;
+  if (!SendViaRTP(event, seq)) {
     ZENREMOTE_ERROR("Failed to send input event");
     return false;
   }
+  next_sequence_number_++;
 
-  pending_messages_.push(msg);
+  auto now = std::chrono::steady_clock::now();
+  PendingSlot& slot = SlotFor(seq);
+  slot.event = event;
+  slot.sequence_number = seq;
+  slot.in_flight = true;
+  slot.last_send_time = now;
+  slot.retry_count = 0;
+  slot.sack_skip_count = 0;
+  in_flight_count_++;
   stats_.events_sent++;
 
   ZENREMOTE_DEBUG("Input event sent: type={}, seq={}",
-                  static_cast<int>(event.type), msg.sequence_number);
+                  static_cast<int>(event.type), seq);
   return true;
 }
 
-void ReliableInputSender::OnAckMessage(const AckPayload& ack) {
-  while (!pending_messages_.empty()) {
-    auto& front = pending_messages_.front();
-    if (front.sequence_number == ack.acked_sequence) {
-      auto now = std::chrono::steady_clock::now();
-      auto rtt_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                        now - front.send_time)
-                        .count();
-      ZENREMOTE_DEBUG("Input ACK received: seq={}, RTT={}ms",
-                      ack.acked_sequence, rtt_ms);
-      stats_.events_acked++;
-      pending_messages_.pop();
-      break;
-    } else if (front.sequence_number < ack.acked_sequence) {
-      pending_messages_.pop();
-    } else {
-      break;
+void ReliableInputSender::SetRedundancyConfig(const RedundancyConfig& config) {
+  redundancy_config_ = config;
+  redundancy_config_.max_depth =
+      std::clamp(config.max_depth, 0,
+                 static_cast<int>(kMaxRedundantInputBlocks));
+  redundancy_config_.min_depth =
+      std::clamp(config.min_depth, 0, redundancy_config_.max_depth);
+  redundancy_depth_ =
+      redundancy_config_.enabled ? redundancy_config_.min_depth : 0;
+}
+
+void ReliableInputSender::OnControlMessage(const uint8_t* payload,
+                                           size_t length) {
+  auto ctrl_msg = ParseControlMessage(payload, length);
+  if (!ctrl_msg.has_value() ||
+      ctrl_msg->type != ControlMessageType::kInputAck) {
+    return;
+  }
+
+  auto sack =
+      ParseSackPayload(ctrl_msg->payload.data(), ctrl_msg->payload.size());
+  if (!sack.has_value()) {
+    ZENREMOTE_WARN("Failed to parse input SACK");
+    return;
+  }
+
+  OnAckMessage(sack.value());
+}
+
+void ReliableInputSender::OnAckMessage(const SackPayload& sack) {
+  // 累积 ACK 不可能超过已发送的最大序列号；落后于 send_base_ 的过期 ACK
+  // 仍可能携带有效的 SACK 位
+  const uint16_t cumulative = sack.cumulative_ack;
+  if (SeqLessThan(next_sequence_number_, cumulative)) {
+    ZENREMOTE_WARN("Ignoring SACK beyond send window: cum={}, next={}",
+                   cumulative, next_sequence_number_);
+    return;
+  }
+
+  UpdateRedundancyDepth(sack.loss_fraction / 255.0);
+
+  auto now = std::chrono::steady_clock::now();
+  bool has_rtt_sample = false;
+  std::chrono::steady_clock::time_point rtt_send_time;
+  bool any_acked = false;
+  uint16_t highest_acked = send_base_;
+
+  auto ack_one = [&](uint16_t seq) {
+    if (!IsInFlight(seq)) {
+      return;
+    }
+    PendingSlot& slot = SlotFor(seq);
+    // Karn 算法：重传过的事件无法区分是哪次发送被确认，不参与 RTT 采样
+    if (slot.retry_count == 0 &&
+        (!has_rtt_sample || rtt_send_time < slot.last_send_time)) {
+      rtt_send_time = slot.last_send_time;
+      has_rtt_sample = true;
+    }
+    if (!any_acked || SeqLessThan(highest_acked, seq)) {
+      highest_acked = seq;
     }
+    any_acked = true;
+    stats_.events_acked++;
+    ZENREMOTE_DEBUG("Input ACK received: seq={}", seq);
+    ReleaseSlot(slot);
+  };
+
+  for (uint16_t seq = send_base_; SeqLessThan(seq, cumulative); ++seq) {
+    ack_one(seq);
   }
+
+  uint64_t bitmap = sack.sack_bitmap;
+  for (size_t i = 0; bitmap != 0 && i < kSackBitmapBits; ++i, bitmap >>= 1U) {
+    if (bitmap & 1U) {
+      ack_one(static_cast<uint16_t>(cumulative + 1 + i));
+    }
+  }
+
+  if (has_rtt_sample) {
+    double sample_ms = ElapsedMs(rtt_send_time, now) - sack.ack_delay_ms;
+    UpdateRto(std::max(sample_ms, 0.0));
+  }
+
+  if (!any_acked) {
+    return;
+  }
+
+  // 后续事件已到达而前面的仍未确认：累计若干次后提前重传空洞
+  for (uint16_t seq = send_base_; SeqLessThan(seq, highest_acked); ++seq) {
+    if (!IsInFlight(seq)) {
+      continue;
+    }
+    PendingSlot& slot = SlotFor(seq);
+    if (++slot.sack_skip_count == kFastRetransmitThreshold &&
+        slot.retry_count < kMaxRetries) {
+      ZENREMOTE_DEBUG("Fast retransmit input event: seq={}", seq);
+      if (Retransmit(slot, now)) {
+        stats_.events_fast_retransmitted++;
+      }
+    }
+  }
+
+  AdvanceWindow();
+}
+
+void ReliableInputSender::OnAckMessage(const AckPayload& ack) {
+  if (!IsInFlight(ack.acked_sequence)) {
+    return;
+  }
+
+  SackPayload sack;
+  if (ack.acked_sequence == send_base_) {
+    sack.cumulative_ack = static_cast<uint16_t>(send_base_ + 1);
+  } else {
+    sack.cumulative_ack = send_base_;
+    sack.sack_bitmap = 1ULL << static_cast<uint16_t>(ack.acked_sequence -
+                                                     send_base_ - 1);
+  }
+  OnAckMessage(sack);
 }
 
 void ReliableInputSender::ProcessRetries() {
+  if (in_flight_count_ == 0) {
+    return;
+  }
+
   auto now = std::chrono::steady_clock::now();
-  std::queue<PendingMessage> remaining;
-
-  while (!pending_messages_.empty()) {
-    auto msg = pending_messages_.front();
-    pending_messages_.pop();
-
-    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          now - msg.send_time)
-                          .count();
-
-    if (elapsed_ms >= kRetryTimeoutMs) {
-      if (msg.retry_count < kMaxRetries) {
-        msg.retry_count++;
-        msg.send_time = now;
-        if (SendViaRTP(msg.event, msg.sequence_number)) {
-          ZENREMOTE_WARN("Retrying input event: seq={}, attempt={}",
-                         msg.sequence_number, msg.retry_count);
-          stats_.events_retried++;
-          remaining.push(msg);
-        } else {
-          ZENREMOTE_ERROR("Retry send failed: seq={}", msg.sequence_number);
-          stats_.events_failed++;
-        }
-      } else {
-        ZENREMOTE_ERROR("Input event failed after {} retries: seq={}",
-                        kMaxRetries, msg.sequence_number);
-        stats_.events_failed++;
-      }
-    } else {
-      remaining.push(msg);
+
+  for (uint16_t seq = send_base_; seq != next_sequence_number_; ++seq) {
+    if (!IsInFlight(seq)) {
+      continue;
     }
+
+    PendingSlot& slot = SlotFor(seq);
+    // RTT 采样已扣除 ACK 延迟，超时需加回接收端的最大延迟 ACK 时间
+    const int timeout_ms =
+        std::min(rto_ms_ << std::min(slot.retry_count, 6), kMaxRtoMs) +
+        ReliableInputReceiver::kDelayedAckMs;
+    if (ElapsedMs(slot.last_send_time, now) < timeout_ms) {
+      continue;
+    }
+
+    if (slot.retry_count >= kMaxRetries) {
+      ZENREMOTE_ERROR("Input event failed after {} retries: seq={}",
+                      kMaxRetries, seq);
+      stats_.events_failed++;
+      ReleaseSlot(slot);
+      continue;
+    }
+
+    if (Retransmit(slot, now)) {
+      ZENREMOTE_WARN("Retrying input event: seq={}, attempt={}, rto={}ms",
+                     seq, slot.retry_count, timeout_ms);
+    }
+  }
+
+  AdvanceWindow();
+}
+
+bool ReliableInputSender::IsInFlight(uint16_t seq) const {
+  if (!SeqLessThan(seq, next_sequence_number_) ||
+      SeqLessThan(seq, send_base_)) {
+    return false;
   }
+  const PendingSlot& slot = window_[seq % kWindowSize];
+  return slot.in_flight && slot.sequence_number == seq;
+}
 
-  pending_messages_ = remaining;
+void ReliableInputSender::ReleaseSlot(PendingSlot& slot) {
+  if (slot.in_flight) {
+    slot.in_flight = false;
+    in_flight_count_--;
+  }
+}
+
+void ReliableInputSender::AdvanceWindow() {
+  while (send_base_ != next_sequence_number_ && !IsInFlight(send_base_)) {
+    send_base_++;
+  }
+}
+
+void ReliableInputSender::UpdateRto(double rtt_sample_ms) {
+  // RFC 6298 2.2/2.3
+  if (!has_rtt_sample_) {
+    srtt_ms_ = rtt_sample_ms;
+    rttvar_ms_ = rtt_sample_ms / 2.0;
+    has_rtt_sample_ = true;
+  } else {
+    rttvar_ms_ = 0.75 * rttvar_ms_ + 0.25 * std::fabs(srtt_ms_ - rtt_sample_ms);
+    srtt_ms_ = 0.875 * srtt_ms_ + 0.125 * rtt_sample_ms;
+  }
+
+  const double rto = srtt_ms_ + std::max(1.0, 4.0 * rttvar_ms_);
+  rto_ms_ = std::clamp(static_cast<int>(std::ceil(rto)), kMinRtoMs, kMaxRtoMs);
+  stats_.rtt_samples++;
+}
+
+void ReliableInputSender::UpdateRedundancyDepth(double loss_fraction) {
+  if (!redundancy_config_.enabled) {
+    return;
+  }
+
+  int depth = redundancy_config_.min_depth;
+  if (loss_fraction >= 1.0) {
+    depth = redundancy_config_.max_depth;
+  } else if (loss_fraction > 0.0) {
+    // 每个事件共发送 depth+1 份，全部丢失的概率约为 loss^(depth+1)
+    const double copies = std::ceil(
+        std::log(redundancy_config_.target_residual_loss) /
+        std::log(loss_fraction));
+    depth = std::max(depth, static_cast<int>(copies) - 1);
+  }
+  depth = std::min(depth, redundancy_config_.max_depth);
+
+  if (depth != redundancy_depth_) {
+    ZENREMOTE_DEBUG("Input redundancy depth {} -> {} (loss={:.3f})",
+                    redundancy_depth_, depth, loss_fraction);
+    redundancy_depth_ = depth;
+  }
+}
+
+std::vector<RedundantInputBlock> ReliableInputSender::CollectRedundantBlocks(
+    uint16_t seq) {
+  std::vector<RedundantInputBlock> blocks;
+  if (redundancy_depth_ <= 0) {
+    return blocks;
+  }
+
+  // 从最近的事件往回取，只携带仍未确认的事件
+  uint16_t candidate = seq;
+  for (size_t back = 1; back <= kWindowSize &&
+                        blocks.size() < static_cast<size_t>(redundancy_depth_);
+       ++back) {
+    --candidate;
+    if (SeqLessThan(candidate, send_base_)) {
+      break;
+    }
+    if (IsInFlight(candidate)) {
+      RedundantInputBlock block;
+      block.sequence_back = static_cast<uint8_t>(back);
+      block.event = SlotFor(candidate).event;
+      blocks.push_back(block);
+    }
+  }
+  return blocks;
+}
+
+bool ReliableInputSender::Retransmit(
+    PendingSlot& slot,
+    std::chrono::steady_clock::time_point now) {
+  slot.retry_count++;
+  slot.last_send_time = now;
+  if (!SendViaRTP(slot.event, slot.sequence_number)) {
+    ZENREMOTE_ERROR("Retry send failed: seq={}", slot.sequence_number);
+    return false;
+  }
+  stats_.events_retried++;
+  return true;
 }
 
 bool ReliableInputSender::SendViaRTP(const InputEvent& event, uint16_t seq) {
-  auto event_payload = SerializeInputEvent(event);
+  const auto blocks = CollectRedundantBlocks(seq);
+  auto event_payload = SerializeRedundantInputEvent(event, blocks);
 
   ControlMessage ctrl_msg;
   ctrl_msg.type = ControlMessageType::kInputEvent;
@@ -118,11 +348,16 @@ bool ReliableInputSender::SendViaRTP(const InputEvent& event, uint16_t seq) {
     return false;
   }
 
-  auto result = connection_->Send(buffer);
-  return result.IsOk();
+  auto result = connection_->Send(buffer.data(), buffer.size());
+  if (result.IsErr()) {
+    return false;
+  }
+  stats_.redundant_events_sent += blocks.size();
+  stats_.redundancy_bytes_sent += event_payload.size() - kInputEventSize;
+  return true;
 }
 
-ReliableInputReceiver::ReliableInputReceiver(DirectConnection* connection)
+ReliableInputReceiver::ReliableInputReceiver(BaseConnection* connection)
     : connection_(connection) {}
 
 void ReliableInputReceiver::SetCallback(InputEventCallback callback,
@@ -139,37 +374,170 @@ void ReliableInputReceiver::OnControlMessage(const uint8_t* payload,
     return;
   }
 
-  if (ctrl_msg->type == ControlMessageType::kInputEvent) {
-    auto event =
-        ParseInputEvent(ctrl_msg->payload.data(), ctrl_msg->payload.size());
-    if (!event.has_value()) {
-      ZENREMOTE_WARN("Failed to parse input event");
-      return;
+  if (ctrl_msg->type != ControlMessageType::kInputEvent) {
+    return;
+  }
+
+  auto event =
+      ParseInputEvent(ctrl_msg->payload.data(), ctrl_msg->payload.size());
+  if (!event.has_value()) {
+    ZENREMOTE_WARN("Failed to parse input event");
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  const uint16_t seq = ctrl_msg->sequence;
+  UpdateLossEstimate(seq);
+
+  // 冗余块按从旧到新的顺序注入，保证事件顺序不变
+  auto blocks = ParseRedundantInputBlocks(ctrl_msg->payload.data(),
+                                          ctrl_msg->payload.size());
+  std::sort(blocks.begin(), blocks.end(),
+            [](const RedundantInputBlock& a, const RedundantInputBlock& b) {
+              return a.sequence_back > b.sequence_back;
+            });
+  int recovered = 0;
+  for (const auto& block : blocks) {
+    if (block.sequence_back != 0 &&
+        DeliverEvent(static_cast<uint16_t>(seq - block.sequence_back),
+                     block.event, true) != Arrival::kDuplicate) {
+      recovered++;
     }
+  }
+
+  const Arrival arrival = DeliverEvent(seq, event.value(), false);
+
+  if (pending_ack_count_ == 0) {
+    ack_pending_since_ = now;
+  }
+  pending_ack_count_ += 1 + recovered;
+
+  // 乱序/重复说明发送端存在空洞或 ACK 丢失，立即反馈；否则合并
+  if (arrival != Arrival::kInOrder ||
+      pending_ack_count_ >= kAckCoalesceCount) {
+    SendAck(now);
+  }
+}
+
+void ReliableInputReceiver::ProcessDelayedAck() {
+  if (pending_ack_count_ == 0) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (ElapsedMs(ack_pending_since_, now) >= kDelayedAckMs) {
+    SendAck(now);
+  }
+}
 
-    if (callback_) {
-      callback_(event.value(), user_data_);
+ReliableInputReceiver::Arrival ReliableInputReceiver::DeliverEvent(
+    uint16_t seq,
+    const InputEvent& event,
+    bool redundant) {
+  const Arrival arrival = RecordSequence(seq);
+
+  if (arrival == Arrival::kDuplicate) {
+    // 冗余副本重复是常态，不计入统计
+    if (!redundant) {
+      stats_.duplicates_dropped++;
+      ZENREMOTE_DEBUG("Duplicate input event dropped: seq={}", seq);
     }
+    return arrival;
+  }
+
+  if (redundant) {
+    stats_.recovered_by_redundancy++;
+  }
+  if (arrival == Arrival::kOutOfOrder) {
+    stats_.out_of_order++;
+  }
+  if (callback_) {
+    callback_(event, user_data_);
+  }
+  stats_.events_delivered++;
+  ZENREMOTE_DEBUG("Input event applied: type={}, seq={}{}",
+                  static_cast<int>(event.type), seq,
+                  redundant ? " (redundant)" : "");
+  return arrival;
+}
 
-    SendAck(ctrl_msg->sequence);
+void ReliableInputReceiver::UpdateLossEstimate(uint16_t primary_seq) {
+  if (!has_primary_sequence_) {
+    has_primary_sequence_ = true;
+    highest_primary_sequence_ = primary_seq;
+    return;
+  }
 
-    ZENREMOTE_DEBUG("Input event applied: type={}, seq={}",
-                    static_cast<int>(event->type), ctrl_msg->sequence);
+  const int16_t offset = static_cast<int16_t>(
+      static_cast<uint16_t>(primary_seq - highest_primary_sequence_));
+  if (offset <= 0) {
+    return;  // 重传或乱序到达，不影响首传丢包统计
   }
+
+  // 首传序列号的空洞视为丢失，EWMA 平滑
+  const int lost = std::min<int>(offset - 1, kSackBitmapBits);
+  for (int i = 0; i < lost; ++i) {
+    loss_estimate_ += kLossEwmaGain * (1.0 - loss_estimate_);
+  }
+  loss_estimate_ -= kLossEwmaGain * loss_estimate_;
+  highest_primary_sequence_ = primary_seq;
 }
 
-void ReliableInputReceiver::SendAck(uint16_t seq) {
-  AckPayload ack;
-  ack.acked_sequence = seq;
-  ack.original_timestamp_ms = GetTimestampMs();
+ReliableInputReceiver::Arrival ReliableInputReceiver::RecordSequence(
+    uint16_t seq) {
+  const int16_t offset =
+      static_cast<int16_t>(static_cast<uint16_t>(seq - next_expected_sequence_));
+
+  if (offset < 0) {
+    return Arrival::kDuplicate;
+  }
+
+  if (offset == 0) {
+    // 推进累积确认点，吸收位图中已连续到达的序列号
+    next_expected_sequence_++;
+    while (true) {
+      const bool received = (received_bitmap_ & 1U) != 0;
+      received_bitmap_ >>= 1U;
+      if (!received) {
+        break;
+      }
+      next_expected_sequence_++;
+    }
+    return Arrival::kInOrder;
+  }
 
-  auto ack_payload = SerializeAckPayload(ack);
+  if (offset > static_cast<int16_t>(kSackBitmapBits)) {
+    // 超出发送窗口：发送端已放弃中间事件，重新同步
+    ZENREMOTE_WARN("Input sequence jumped from {} to {}, resyncing",
+                   next_expected_sequence_, seq);
+    next_expected_sequence_ = static_cast<uint16_t>(seq + 1);
+    received_bitmap_ = 0;
+    return Arrival::kOutOfOrder;
+  }
+
+  const uint64_t bit = 1ULL << static_cast<unsigned>(offset - 1);
+  if (received_bitmap_ & bit) {
+    return Arrival::kDuplicate;
+  }
+  received_bitmap_ |= bit;
+  return Arrival::kOutOfOrder;
+}
+
+void ReliableInputReceiver::SendAck(std::chrono::steady_clock::time_point now) {
+  SackPayload sack;
+  sack.cumulative_ack = next_expected_sequence_;
+  sack.sack_bitmap = received_bitmap_;
+  sack.ack_delay_ms = static_cast<uint16_t>(
+      std::min(ElapsedMs(ack_pending_since_, now), 65535.0));
+  sack.loss_fraction = static_cast<uint8_t>(
+      std::lround(std::clamp(loss_estimate_, 0.0, 1.0) * 255.0));
+  pending_ack_count_ = 0;
 
   ControlMessage ctrl_msg;
   ctrl_msg.type = ControlMessageType::kInputAck;
   ctrl_msg.sequence = ack_sequence_number_++;
-  ctrl_msg.timestamp_ms = ack.original_timestamp_ms;
-  ctrl_msg.payload = ack_payload;
+  ctrl_msg.timestamp_ms = GetTimestampMs();
+  ctrl_msg.payload = SerializeSackPayload(sack);
 
   auto ctrl_payload = SerializeControlMessage(ctrl_msg);
 
@@ -183,8 +551,9 @@ void ReliableInputReceiver::SendAck(uint16_t seq) {
   packet.payload = ctrl_payload;
 
   auto buffer = SerializeRtpPacket(packet);
-  if (!buffer.empty()) {
-    connection_->Send(buffer);
+  if (!buffer.empty() && connection_ &&
+      connection_->Send(buffer.data(), buffer.size()).IsOk()) {
+    stats_.acks_sent++;
   }
 }
 
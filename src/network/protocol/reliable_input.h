@@ -1,79 +1,187 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
-#include <queue>
 #include <vector>
 
 #include "network/connection/base_connection.h"
 #include "network/protocol/packet.h"
 #include "network/protocol/protocol.h"
-#include "protocol.h"
 
 namespace zenremote {
 
-// Forward declaration
-class DirectConnection;
-
+/**
+ * @brief 可靠输入事件发送端
+ *
+ * - 固定大小的环形发送窗口，按序列号取模索引，无需遍历/拷贝队列
+ * - 接收端回复累积 ACK + 64 位 SACK 位图，乱序/合并 ACK 均可正确处理
+ * - RTO 按 RFC 6298 由 SRTT/RTTVAR 自适应计算，重传时指数退避
+ * - SACK 显示后续事件已到达时提前重传空洞（无需等待 RTO）
+ * - 冗余模式：每个包额外携带最近 N 个未确认事件，单次丢包无需等待重传；
+ *   N 根据接收端回报的丢包率自适应
+ *
+ * 非线程安全：SendInputEvent / OnAckMessage / ProcessRetries
+ * 需在同一线程调用。
+ */
 class ReliableInputSender {
  public:
   static constexpr int kMaxRetries = 3;
-  static constexpr int kRetryTimeoutMs = 50;
+  static constexpr size_t kWindowSize = kSackBitmapBits;
+  static constexpr int kInitialRtoMs = 50;
+  static constexpr int kMinRtoMs = 10;
+  static constexpr int kMaxRtoMs = 1000;
+  static constexpr int kFastRetransmitThreshold = 2;
+
+  struct RedundancyConfig {
+    bool enabled = false;
+    int min_depth = 1;  ///< 无丢包时也保留的冗余深度
+    int max_depth = 4;  ///< 上限，不超过 kMaxRedundantInputBlocks
+    double target_residual_loss = 0.001;  ///< 所有副本同时丢失的目标概率
+  };
 
-  explicit ReliableInputSender(uint32_t ssrc, DirectConnection* connection);
+  explicit ReliableInputSender(uint32_t ssrc, BaseConnection* connection);
 
   bool SendInputEvent(const InputEvent& event);
 
+  void SetRedundancyConfig(const RedundancyConfig& config);
+
+  /// @brief 处理对端 kInputAck 控制消息（不含 RTP 头）
+  void OnControlMessage(const uint8_t* payload, size_t length);
+
+  void OnAckMessage(const SackPayload& sack);
+
+  /// @brief 兼容单条 ACK：仅确认 acked_sequence 一个事件
   void OnAckMessage(const AckPayload& ack);
 
   void ProcessRetries();
 
+  size_t GetInFlightCount() const { return in_flight_count_; }
+  int GetRtoMs() const { return rto_ms_; }
+  double GetSmoothedRttMs() const { return srtt_ms_; }
+  int GetRedundancyDepth() const { return redundancy_depth_; }
+
   struct Stats {
     uint64_t events_sent = 0;
+    uint64_t redundant_events_sent = 0;
+    uint64_t redundancy_bytes_sent = 0;
     uint64_t events_acked = 0;
     uint64_t events_retried = 0;
+    uint64_t events_fast_retransmitted = 0;
     uint64_t events_failed = 0;
+    uint64_t window_full_drops = 0;
+    uint64_t rtt_samples = 0;
   };
 
   const Stats& GetStats() const { return stats_; }
 
  private:
-  struct PendingMessage {
+  struct PendingSlot {
     InputEvent event;
-    uint16_t sequence_number;
-    std::chrono::steady_clock::time_point send_time;
+    uint16_t sequence_number = 0;
+    bool in_flight = false;
+    std::chrono::steady_clock::time_point last_send_time;
     int retry_count = 0;
+    int sack_skip_count = 0;
   };
 
+  PendingSlot& SlotFor(uint16_t seq) { return window_[seq % kWindowSize]; }
+  bool IsInFlight(uint16_t seq) const;
+  void ReleaseSlot(PendingSlot& slot);
+  void AdvanceWindow();
+  void UpdateRto(double rtt_sample_ms);
+  void UpdateRedundancyDepth(double loss_fraction);
+  std::vector<RedundantInputBlock> CollectRedundantBlocks(uint16_t seq);
+  bool Retransmit(PendingSlot& slot,
+                  std::chrono::steady_clock::time_point now);
   bool SendViaRTP(const InputEvent& event, uint16_t seq);
 
   uint32_t ssrc_;
-  DirectConnection* connection_;
+  BaseConnection* connection_;
   uint16_t next_sequence_number_ = 0;
-  std::queue<PendingMessage> pending_messages_;
+  uint16_t send_base_ = 0;
+  size_t in_flight_count_ = 0;
+  std::array<PendingSlot, kWindowSize> window_{};
+
+  double srtt_ms_ = 0.0;
+  double rttvar_ms_ = 0.0;
+  bool has_rtt_sample_ = false;
+  int rto_ms_ = kInitialRtoMs;
+
+  RedundancyConfig redundancy_config_;
+  int redundancy_depth_ = 0;
+
   Stats stats_;
 };
 
+/**
+ * @brief 可靠输入事件接收端
+ *
+ * - 按序列号去重，重传的事件不会被重复注入
+ * - ACK 合并：每 kAckCoalesceCount 个按序事件或 kDelayedAckMs 超时发送一次；
+ *   乱序或重复到达时立即发送，让发送端尽快修复空洞
+ * - 处理冗余块：先按序列号注入被恢复的旧事件，再注入主事件
+ * - 按首传序列号空洞估计丢包率，随 SACK 回报给发送端
+ *
+ * 调用方需周期性调用 ProcessDelayedAck()（与 ProcessRetries 同一节拍即可）。
+ */
 class ReliableInputReceiver {
  public:
+  static constexpr int kDelayedAckMs = 5;
+  static constexpr int kAckCoalesceCount = 2;
+  static constexpr double kLossEwmaGain = 1.0 / 16.0;
+
   using InputEventCallback = void (*)(const InputEvent& event, void* user_data);
 
-  explicit ReliableInputReceiver(DirectConnection* connection);
+  explicit ReliableInputReceiver(BaseConnection* connection);
 
   void SetCallback(InputEventCallback callback, void* user_data);
 
   void OnControlMessage(const uint8_t* payload, size_t length);
 
+  void ProcessDelayedAck();
+
+  struct Stats {
+    uint64_t events_delivered = 0;
+    uint64_t duplicates_dropped = 0;
+    uint64_t out_of_order = 0;
+    uint64_t recovered_by_redundancy = 0;
+    uint64_t acks_sent = 0;
+  };
+
+  const Stats& GetStats() const { return stats_; }
+  double GetLossEstimate() const { return loss_estimate_; }
+
  private:
-  void SendAck(uint16_t seq);
+  enum class Arrival {
+    kInOrder,
+    kOutOfOrder,
+    kDuplicate,
+  };
 
-  DirectConnection* connection_;
+  Arrival RecordSequence(uint16_t seq);
+  Arrival DeliverEvent(uint16_t seq, const InputEvent& event, bool redundant);
+  void UpdateLossEstimate(uint16_t primary_seq);
+  void SendAck(std::chrono::steady_clock::time_point now);
+
+  BaseConnection* connection_;
   InputEventCallback callback_ = nullptr;
   void* user_data_ = nullptr;
-  uint16_t last_acked_sequence_ = 0;
+
+  uint16_t next_expected_sequence_ = 0;
+  uint64_t received_bitmap_ = 0;
+
+  bool has_primary_sequence_ = false;
+  uint16_t highest_primary_sequence_ = 0;
+  double loss_estimate_ = 0.0;
+
+  int pending_ack_count_ = 0;
+  std::chrono::steady_clock::time_point ack_pending_since_;
+
   uint16_t ack_sequence_number_ = 0;
   uint32_t ssrc_ = 0;
+  Stats stats_;
 };
 
 }  // namespace zenremote
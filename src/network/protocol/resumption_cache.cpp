@@ -0,0 +1,105 @@
+#include "network/protocol/resumption_cache.h"
+
+#include <random>
+
+#include "network/protocol/srtp.h"
+
+namespace zenremote {
+
+namespace {
+
+// 票据 ID 是兑换票据的凭证之一，不能用可由输出推算内部状态的 mt19937_64
+uint64_t GenerateTicketId() {
+  std::random_device random;
+  return (static_cast<uint64_t>(random()) << 32U) | random();
+}
+
+}  // namespace
+
+ResumptionTicketCache::ResumptionTicketCache()
+    : ResumptionTicketCache(Config{}) {}
+
+ResumptionTicketCache::ResumptionTicketCache(const Config& config)
+    : config_(config) {}
+
+ResumptionTicket ResumptionTicketCache::Issue(
+    uint32_t session_id,
+    uint32_t client_ssrc,
+    uint32_t server_ssrc,
+    const SessionParameters& parameters,
+    const std::optional<std::array<uint8_t, 32>>& master_secret) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto now = Clock::now();
+  EvictLocked(now);
+
+  ResumptionTicket ticket;
+  do {
+    ticket.ticket_id = GenerateTicketId();
+  } while (ticket.ticket_id == 0 || tickets_.count(ticket.ticket_id) > 0);
+  ticket.session_id = session_id;
+  ticket.client_ssrc = client_ssrc;
+  ticket.server_ssrc = server_ssrc;
+  ticket.lifetime_ms = config_.lifetime_ms;
+  ticket.parameters = parameters;
+  if (master_secret.has_value()) {
+    ticket.resumption_secret =
+        DeriveResumptionSecret(*master_secret, ticket.ticket_id);
+  }
+
+  tickets_[ticket.ticket_id] = {
+      ticket, now + std::chrono::milliseconds(config_.lifetime_ms)};
+  issue_order_.push_back(ticket.ticket_id);
+  return ticket;
+}
+
+std::optional<ResumptionTicket> ResumptionTicketCache::Redeem(
+    uint64_t ticket_id,
+    uint32_t session_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tickets_.find(ticket_id);
+  if (it == tickets_.end()) {
+    return std::nullopt;
+  }
+  // 无论成败都作废，避免对同一票据反复尝试
+  Entry entry = std::move(it->second);
+  tickets_.erase(it);
+  if (entry.ticket.session_id != session_id ||
+      Clock::now() >= entry.expires_at) {
+    return std::nullopt;
+  }
+  return entry.ticket;
+}
+
+std::optional<ResumptionTicket> ResumptionTicketCache::Find(
+    uint64_t ticket_id,
+    uint32_t session_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tickets_.find(ticket_id);
+  if (it == tickets_.end() || it->second.ticket.session_id != session_id ||
+      Clock::now() >= it->second.expires_at) {
+    return std::nullopt;
+  }
+  return it->second.ticket;
+}
+
+size_t ResumptionTicketCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tickets_.size();
+}
+
+void ResumptionTicketCache::EvictLocked(Clock::time_point now) {
+  // 按签发顺序淘汰：队首要么已兑换、要么已过期、要么超出容量
+  while (!issue_order_.empty()) {
+    auto it = tickets_.find(issue_order_.front());
+    if (it != tickets_.end() && it->second.expires_at > now &&
+        tickets_.size() < config_.capacity) {
+      break;
+    }
+    if (it != tickets_.end()) {
+      tickets_.erase(it);
+    }
+    issue_order_.pop_front();
+  }
+}
+
+}  // namespace zenremote
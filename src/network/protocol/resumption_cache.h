@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "network/protocol/protocol.h"
+
+namespace zenremote {
+
+/**
+ * @brief 会话恢复票据缓存（被控端）
+ *
+ * 有状态的票据：票据内容保存在被控端，发给控制端的只是随机 ticket_id
+ * （std::random_device 生成，不可预测），无需加密即可防止伪造。ticket_id
+ * 以明文传输，恢复请求还须带上以恢复密钥计算的 binder，见 Find()。
+ * - 每张票据只能兑换一次，兑换成功后由握手方签发新票据，重放的旧票据被拒绝
+ * - 超过 lifetime_ms 的票据失效
+ * - 超过容量时淘汰最早签发的票据
+ *
+ * 线程安全：所有方法可在多个会话线程并发调用。
+ */
+class ResumptionTicketCache {
+ public:
+  struct Config {
+    size_t capacity = 1024;
+    uint32_t lifetime_ms = 10 * 60 * 1000;
+  };
+
+  ResumptionTicketCache();
+  explicit ResumptionTicketCache(const Config& config);
+
+  /**
+   * @brief 为已完成握手的会话签发票据
+   * @param master_secret 会话的 SRTP 主密钥，给出时票据带上恢复密钥
+   */
+  ResumptionTicket Issue(
+      uint32_t session_id,
+      uint32_t client_ssrc,
+      uint32_t server_ssrc,
+      const SessionParameters& parameters,
+      const std::optional<std::array<uint8_t, 32>>& master_secret =
+          std::nullopt);
+
+  /**
+   * @brief 兑换票据（一次性）
+   * @return 票据存在、未过期且会话 ID 匹配时返回票据，并从缓存中移除
+   */
+  std::optional<ResumptionTicket> Redeem(uint64_t ticket_id,
+                                         uint32_t session_id);
+
+  /**
+   * @brief 查找票据但不兑换
+   *
+   * 用于在 Redeem() 之前校验恢复请求的 binder，伪造的请求不会消耗票据。
+   */
+  std::optional<ResumptionTicket> Find(uint64_t ticket_id,
+                                       uint32_t session_id) const;
+
+  size_t Size() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    ResumptionTicket ticket;
+    Clock::time_point expires_at;
+  };
+
+  void EvictLocked(Clock::time_point now);
+
+  Config config_;
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, Entry> tickets_;
+  std::deque<uint64_t> issue_order_;  ///< 可能含已兑换的 ID，淘汰时跳过
+};
+
+}  // namespace zenremote
@@ -25,11 +25,38 @@ std::optional<ReceivedPacket> RTPReceiver::ReceivePacket(
   }
 
   size_t length = result.Value();
-  return ParsePacket(buffer, length);
+  if (srtp_session_) {
+    // 接收缓冲区归本函数所有，就地解密
+    auto plain_length = srtp_session_->UnprotectRtp(buffer, length);
+    if (!plain_length.has_value()) {
+      ZENREMOTE_WARN("Dropping packet that failed SRTP check");
+      return std::nullopt;
+    }
+    length = *plain_length;
+  }
+  return ParsePlainPacket(buffer, length);
 }
 
 std::optional<ReceivedPacket> RTPReceiver::ParsePacket(const uint8_t* buffer,
                                                        size_t length) {
+  if (!srtp_session_) {
+    return ParsePlainPacket(buffer, length);
+  }
+  if (!buffer) {
+    return std::nullopt;
+  }
+  scratch_.assign(buffer, buffer + length);
+  auto plain_length = srtp_session_->UnprotectRtp(scratch_.data(), length);
+  if (!plain_length.has_value()) {
+    ZENREMOTE_WARN("Dropping packet that failed SRTP check");
+    return std::nullopt;
+  }
+  return ParsePlainPacket(scratch_.data(), *plain_length);
+}
+
+std::optional<ReceivedPacket> RTPReceiver::ParsePlainPacket(
+    const uint8_t* buffer,
+    size_t length) {
   auto rtp_packet = ParseRtpPacket(buffer, length);
   if (!rtp_packet.has_value()) {
     ZENREMOTE_WARN("Failed to parse RTP packet");
@@ -2,11 +2,13 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
 #include <vector>
 
 #include "network/connection/base_connection.h"
 #include "network/protocol/packet.h"
+#include "network/protocol/srtp.h"
 
 namespace zenremote {
 
@@ -20,6 +22,11 @@ class RTPReceiver {
  public:
   RTPReceiver();
 
+  /// @brief 设置后只接受通过 SRTP 认证的报文，认证失败或重放的报文被丢弃
+  void SetSrtpSession(std::shared_ptr<SrtpSession> session) {
+    srtp_session_ = std::move(session);
+  }
+
   std::optional<ReceivedPacket> ReceivePacket(BaseConnection* connection,
                                               int timeout_ms = 1000);
 
@@ -40,9 +47,13 @@ class RTPReceiver {
   const Stats& GetStats() const { return stats_; }
 
  private:
+  std::optional<ReceivedPacket> ParsePlainPacket(const uint8_t* buffer,
+                                                 size_t length);
   void UpdateStats(const ReceivedPacket& packet);
 
   Stats stats_;
+  std::shared_ptr<SrtpSession> srtp_session_;
+  std::vector<uint8_t> scratch_;  ///< ParsePacket 解密用，调用方缓冲区只读
   uint16_t expected_sequence_number_ = 0;
   bool has_received_first_packet_ = false;
 };
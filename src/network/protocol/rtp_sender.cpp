@@ -1,5 +1,7 @@
 #include "network/protocol/rtp_sender.h"
 
+#include <algorithm>
+
 #include "common/log_manager.h"
 
 namespace zenremote {
@@ -11,118 +13,81 @@ bool RTPSender::SendVideoFrame(const uint8_t* data,
                                size_t length,
                                uint32_t timestamp_90khz,
                                bool marker) {
+  return SendPacket(BuildHeader(PayloadType::kVideoH264,
+                                video_sequence_number_++, timestamp_90khz,
+                                marker),
+                    data, length, "video");
+}
+
+bool RTPSender::SendFragmentedVideoFrame(const uint8_t* data,
+                                         size_t length,
+                                         uint32_t timestamp_90khz,
+                                         size_t max_payload_size) {
   if (!connection_ || !connection_->IsOpen()) {
     ZENREMOTE_ERROR("Connection not open");
     return false;
   }
-
-  RtpPacket packet;
-  packet.header = BuildHeader(PayloadType::kVideoH264, video_sequence_number_++,
-                              timestamp_90khz, marker);
-  packet.payload.assign(data, data + length);
-
-  auto buffer = SerializeRtpPacket(packet);
-  if (buffer.empty()) {
-    ZENREMOTE_ERROR("Failed to serialize video RTP packet");
+  if (max_payload_size == 0) {
+    ZENREMOTE_ERROR("Invalid max payload size");
     return false;
   }
 
-  auto result = connection_->Send(buffer.data(), buffer.size());
-  if (result.IsOk()) {
-    stats_.packets_sent++;
-    stats_.bytes_sent += buffer.size();
-    stats_.last_sequence_number = packet.header.sequence_number;
-    return true;
+  const size_t count =
+      std::max<size_t>(1, (length + max_payload_size - 1) / max_payload_size);
+  if (fragment_buffers_.size() < count) {
+    fragment_buffers_.resize(count);
   }
-
-  ZENREMOTE_ERROR("Failed to send video packet: {}", result.Message());
-  return false;
-}
-
-bool RTPSender::SendAudioPacket(const uint8_t* data,
-                                size_t length,
-                                uint32_t timestamp_48khz) {
-  if (!connection_ || !connection_->IsOpen()) {
-    ZENREMOTE_ERROR("Connection not open");
-    return false;
+  fragment_views_.resize(count);
+  const uint16_t first_sequence = video_sequence_number_;
+  for (size_t i = 0; i < count; ++i) {
+    const size_t offset = i * max_payload_size;
+    const size_t chunk = std::min(max_payload_size, length - offset);
+    auto& buffer = fragment_buffers_[i];
+    const auto header =
+        BuildHeader(PayloadType::kVideoH264, video_sequence_number_++,
+                    timestamp_90khz, i + 1 == count);
+    const size_t packet_length =
+        WritePacket(header, data + offset, chunk, buffer);
+    fragment_views_[i] = {buffer.data(), packet_length, buffer.size()};
   }
 
-  RtpPacket packet;
-  packet.header = BuildHeader(PayloadType::kAudioOpus, audio_sequence_number_++,
-                              timestamp_48khz, false);
-  packet.payload.assign(data, data + length);
-
-  auto buffer = SerializeRtpPacket(packet);
-  if (buffer.empty()) {
-    ZENREMOTE_ERROR("Failed to serialize audio RTP packet");
+  if (srtp_session_ &&
+      srtp_session_->ProtectRtpBatch(fragment_views_.data(), count) != count) {
+    ZENREMOTE_ERROR("Failed to protect video frame fragments");
     return false;
   }
 
-  auto result = connection_->Send(buffer.data(), buffer.size());
-  if (result.IsOk()) {
-    stats_.packets_sent++;
-    stats_.bytes_sent += buffer.size();
-    stats_.last_sequence_number = packet.header.sequence_number;
-    return true;
+  for (size_t i = 0; i < count; ++i) {
+    const auto& view = fragment_views_[i];
+    if (!Transmit(view.data, view.length,
+                  static_cast<uint16_t>(first_sequence + i), "video")) {
+      return false;
+    }
   }
+  return true;
+}
 
-  ZENREMOTE_ERROR("Failed to send audio packet: {}", result.Message());
-  return false;
+bool RTPSender::SendAudioPacket(const uint8_t* data,
+                                size_t length,
+                                uint32_t timestamp_48khz) {
+  return SendPacket(BuildHeader(PayloadType::kAudioOpus,
+                                audio_sequence_number_++, timestamp_48khz,
+                                false),
+                    data, length, "audio");
 }
 
 bool RTPSender::SendControlMessage(const uint8_t* data,
                                    size_t length,
                                    uint32_t timestamp_ms) {
-  if (!connection_ || !connection_->IsOpen()) {
-    ZENREMOTE_ERROR("Connection not open");
-    return false;
-  }
-
-  RtpPacket packet;
-  packet.header = BuildHeader(PayloadType::kControl, control_sequence_number_++,
-                              timestamp_ms, false);
-  packet.payload.assign(data, data + length);
-
-  auto buffer = SerializeRtpPacket(packet);
-  if (buffer.empty()) {
-    ZENREMOTE_ERROR("Failed to serialize control RTP packet");
-    return false;
-  }
-
-  auto result = connection_->Send(buffer.data(), buffer.size());
-  if (result.IsOk()) {
-    stats_.packets_sent++;
-    stats_.bytes_sent += buffer.size();
-    stats_.last_sequence_number = packet.header.sequence_number;
-    return true;
-  }
-
-  ZENREMOTE_ERROR("Failed to send control packet: {}", result.Message());
-  return false;
+  return SendPacket(BuildHeader(PayloadType::kControl,
+                                control_sequence_number_++, timestamp_ms,
+                                false),
+                    data, length, "control");
 }
 
 bool RTPSender::SendRawRtpPacket(const RtpPacket& packet) {
-  if (!connection_ || !connection_->IsOpen()) {
-    ZENREMOTE_ERROR("Connection not open");
-    return false;
-  }
-
-  auto buffer = SerializeRtpPacket(packet);
-  if (buffer.empty()) {
-    ZENREMOTE_ERROR("Failed to serialize RTP packet");
-    return false;
-  }
-
-  auto result = connection_->Send(buffer.data(), buffer.size());
-  if (result.IsOk()) {
-    stats_.packets_sent++;
-    stats_.bytes_sent += buffer.size();
-    stats_.last_sequence_number = packet.header.sequence_number;
-    return true;
-  }
-
-  ZENREMOTE_ERROR("Failed to send RTP packet: {}", result.Message());
-  return false;
+  return SendPacket(packet.header, packet.payload.data(),
+                    packet.payload.size(), "RTP");
 }
 
 RtpHeader RTPSender::BuildHeader(PayloadType payload_type,
@@ -142,4 +107,56 @@ RtpHeader RTPSender::BuildHeader(PayloadType payload_type,
   return header;
 }
 
+size_t RTPSender::WritePacket(const RtpHeader& header,
+                              const uint8_t* data,
+                              size_t length,
+                              std::vector<uint8_t>& buffer) {
+  const size_t packet_length = kRtpHeaderSize + length;
+  // 尾部预留标签空间，SRTP 就地加密时无需重新分配
+  buffer.resize(packet_length + (srtp_session_ ? kSrtpOverhead : 0));
+  SerializeRtpHeader(header, buffer.data(), buffer.size());
+  if (length > 0) {
+    std::copy(data, data + length, buffer.begin() + kRtpHeaderSize);
+  }
+  return packet_length;
+}
+
+bool RTPSender::SendPacket(const RtpHeader& header,
+                           const uint8_t* data,
+                           size_t length,
+                           const char* kind) {
+  if (!connection_ || !connection_->IsOpen()) {
+    ZENREMOTE_ERROR("Connection not open");
+    return false;
+  }
+
+  size_t packet_length = WritePacket(header, data, length, send_buffer_);
+  if (srtp_session_) {
+    packet_length = srtp_session_->ProtectRtp(
+        send_buffer_.data(), packet_length, send_buffer_.size());
+    if (packet_length == 0) {
+      ZENREMOTE_ERROR("Failed to protect {} RTP packet", kind);
+      return false;
+    }
+  }
+  return Transmit(send_buffer_.data(), packet_length, header.sequence_number,
+                  kind);
+}
+
+bool RTPSender::Transmit(const uint8_t* buffer,
+                         size_t length,
+                         uint16_t sequence_number,
+                         const char* kind) {
+  auto result = connection_->Send(buffer, length);
+  if (result.IsOk()) {
+    stats_.packets_sent++;
+    stats_.bytes_sent += length;
+    stats_.last_sequence_number = sequence_number;
+    return true;
+  }
+
+  ZENREMOTE_ERROR("Failed to send {} packet: {}", kind, result.Message());
+  return false;
+}
+
 }  // namespace zenremote
@@ -2,22 +2,47 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #include "network/connection/base_connection.h"
 #include "network/protocol/packet.h"
+#include "network/protocol/srtp.h"
 
 namespace zenremote {
 
 class RTPSender {
  public:
+  /// @brief SendFragmentedVideoFrame 默认的单包负载上限（适配 1500 MTU）
+  static constexpr size_t kDefaultMaxPayloadSize = 1200;
+
   explicit RTPSender(uint32_t ssrc, BaseConnection* connection);
 
+  /**
+   * @brief 设置后所有报文经 SRTP 加密发送
+   *
+   * 报文序列化到预留了标签空间的复用缓冲区，就地加密后直接发送。
+   */
+  void SetSrtpSession(std::shared_ptr<SrtpSession> session) {
+    srtp_session_ = std::move(session);
+  }
+
   bool SendVideoFrame(const uint8_t* data,
                       size_t length,
                       uint32_t timestamp_90khz,
                       bool marker = false);
 
+  /**
+   * @brief 把一帧切分为多个 RTP 包发送，最后一包置 marker
+   *
+   * 启用 SRTP 时整帧的分片一次批量加密后再逐个发送。
+   */
+  bool SendFragmentedVideoFrame(
+      const uint8_t* data,
+      size_t length,
+      uint32_t timestamp_90khz,
+      size_t max_payload_size = kDefaultMaxPayloadSize);
+
   bool SendAudioPacket(const uint8_t* data,
                        size_t length,
                        uint32_t timestamp_48khz);
@@ -42,12 +67,33 @@ class RTPSender {
                         uint32_t timestamp,
                         bool marker);
 
+  /// @brief 把头部与负载写入 buffer（预留 SRTP 标签空间），返回明文长度
+  size_t WritePacket(const RtpHeader& header,
+                     const uint8_t* data,
+                     size_t length,
+                     std::vector<uint8_t>& buffer);
+
+  bool SendPacket(const RtpHeader& header,
+                  const uint8_t* data,
+                  size_t length,
+                  const char* kind);
+
+  bool Transmit(const uint8_t* buffer,
+                size_t length,
+                uint16_t sequence_number,
+                const char* kind);
+
   uint32_t ssrc_;
   BaseConnection* connection_;
   uint16_t video_sequence_number_ = 0;
   uint16_t audio_sequence_number_ = 0;
   uint16_t control_sequence_number_ = 0;
   Stats stats_;
+
+  std::shared_ptr<SrtpSession> srtp_session_;
+  std::vector<uint8_t> send_buffer_;
+  std::vector<std::vector<uint8_t>> fragment_buffers_;
+  std::vector<SrtpSession::Buffer> fragment_views_;
 };
 
 }  // namespace zenremote
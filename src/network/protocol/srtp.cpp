@@ -0,0 +1,447 @@
+#include "network/protocol/srtp.h"
+
+#include <algorithm>
+#include <string>
+
+#include "common/digest.h"
+#include "common/log_manager.h"
+#include "network/protocol/packet.h"
+#include "network/protocol/protocol.h"
+
+namespace zenremote {
+
+namespace {
+
+constexpr size_t kRtcpHeaderSize = 8;
+constexpr uint32_t kSrtcpEncryptedFlag = 0x80000000U;
+constexpr uint32_t kSrtcpIndexMask = 0x7FFFFFFFU;
+
+inline void StoreBe32(uint32_t value, uint8_t* out) {
+  out[0] = static_cast<uint8_t>(value >> 24);
+  out[1] = static_cast<uint8_t>(value >> 16);
+  out[2] = static_cast<uint8_t>(value >> 8);
+  out[3] = static_cast<uint8_t>(value);
+}
+
+inline uint32_t LoadBe32(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24) |
+         (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+/// @brief RTP 头长度（固定头 + CSRC + 头部扩展），格式错误返回 0
+size_t RtpHeaderLength(const uint8_t* packet, size_t length) {
+  if (length < kRtpHeaderSize || (packet[0] >> 6) != kRtpVersion) {
+    return 0;
+  }
+  size_t header_length = kRtpHeaderSize + 4 * (packet[0] & 0x0FU);
+  if (packet[0] & 0x10U) {
+    if (length < header_length + 4) {
+      return 0;
+    }
+    const size_t words = (static_cast<size_t>(packet[header_length + 2]) << 8) |
+                         packet[header_length + 3];
+    header_length += 4 + 4 * words;
+  }
+  return header_length <= length ? header_length : 0;
+}
+
+/**
+ * @brief RFC 3711 附录 A：由 16 位序列号推算 ROC
+ * @param roc 当前 ROC
+ * @param highest 已见过的最大序列号
+ */
+uint32_t EstimateRoc(uint32_t roc, uint16_t highest, uint16_t sequence) {
+  if (highest < 0x8000) {
+    if (sequence > highest && sequence - highest > 0x8000) {
+      return roc > 0 ? roc - 1 : roc;
+    }
+    return roc;
+  }
+  if (highest - 0x8000 > sequence) {
+    return roc + 1;
+  }
+  return roc;
+}
+
+inline uint64_t PacketIndex(uint32_t roc, uint16_t sequence) {
+  return (static_cast<uint64_t>(roc) << 16) | sequence;
+}
+
+void BuildRtpIv(const std::array<uint8_t, kSrtpSaltSize>& salt,
+                uint32_t ssrc,
+                uint32_t roc,
+                uint16_t sequence,
+                uint8_t* iv) {
+  iv[0] = 0;
+  iv[1] = 0;
+  StoreBe32(ssrc, iv + 2);
+  StoreBe32(roc, iv + 6);
+  iv[10] = static_cast<uint8_t>(sequence >> 8);
+  iv[11] = static_cast<uint8_t>(sequence);
+  for (size_t i = 0; i < kSrtpSaltSize; ++i) {
+    iv[i] ^= salt[i];
+  }
+}
+
+void BuildRtcpIv(const std::array<uint8_t, kSrtpSaltSize>& salt,
+                 uint32_t ssrc,
+                 uint32_t index,
+                 uint8_t* iv) {
+  iv[0] = 0;
+  iv[1] = 0;
+  StoreBe32(ssrc, iv + 2);
+  iv[6] = 0;
+  iv[7] = 0;
+  StoreBe32(index & kSrtcpIndexMask, iv + 8);
+  for (size_t i = 0; i < kSrtpSaltSize; ++i) {
+    iv[i] ^= salt[i];
+  }
+}
+
+void SplitKeys(const std::vector<uint8_t>& material, SrtpKeys& keys) {
+  auto cursor = material.begin();
+  std::copy_n(cursor, keys.rtp_key.size(), keys.rtp_key.begin());
+  cursor += keys.rtp_key.size();
+  std::copy_n(cursor, keys.rtp_salt.size(), keys.rtp_salt.begin());
+  cursor += keys.rtp_salt.size();
+  std::copy_n(cursor, keys.rtcp_key.size(), keys.rtcp_key.begin());
+  cursor += keys.rtcp_key.size();
+  std::copy_n(cursor, keys.rtcp_salt.size(), keys.rtcp_salt.begin());
+}
+
+constexpr size_t kKeyMaterialSize =
+    2 * (AesGcm128::kKeySize + kSrtpSaltSize);
+
+}  // namespace
+
+SrtpMasterSecret DeriveSrtpMasterSecret(const uint8_t* shared_secret,
+                                        size_t shared_secret_length,
+                                        uint32_t session_id,
+                                        uint32_t client_ssrc,
+                                        uint32_t server_ssrc) {
+  std::vector<uint8_t> salt;
+  WriteUint32LE(session_id, salt);
+  WriteUint32LE(client_ssrc, salt);
+  WriteUint32LE(server_ssrc, salt);
+  const auto output =
+      HkdfSha256(salt.data(), salt.size(), shared_secret, shared_secret_length,
+                 "zenremote srtp master", kSrtpMasterSecretSize);
+  SrtpMasterSecret secret;
+  std::copy(output.begin(), output.end(), secret.begin());
+  return secret;
+}
+
+SrtpKeyMaterial DeriveSrtpKeys(const SrtpMasterSecret& master_secret) {
+  SrtpKeyMaterial material;
+  SplitKeys(HkdfExpandSha256(master_secret.data(), master_secret.size(),
+                             "zenremote srtp c2s", kKeyMaterialSize),
+            material.client_to_server);
+  SplitKeys(HkdfExpandSha256(master_secret.data(), master_secret.size(),
+                             "zenremote srtp s2c", kKeyMaterialSize),
+            material.server_to_client);
+  return material;
+}
+
+SrtpMasterSecret DeriveResumptionSecret(const SrtpMasterSecret& master_secret,
+                                        uint64_t ticket_id) {
+  std::vector<uint8_t> id;
+  WriteUint64LE(ticket_id, id);
+  std::string info = "zenremote resumption";
+  info.append(id.begin(), id.end());
+  const auto output = HkdfExpandSha256(
+      master_secret.data(), master_secret.size(), info, kSrtpMasterSecretSize);
+  SrtpMasterSecret secret;
+  std::copy(output.begin(), output.end(), secret.begin());
+  return secret;
+}
+
+SrtpMasterSecret DeriveResumedSessionSecret(
+    const SrtpMasterSecret& resumption_secret,
+    const uint8_t* client_nonce,
+    size_t client_nonce_length) {
+  const auto output = HkdfSha256(
+      client_nonce, client_nonce_length, resumption_secret.data(),
+      resumption_secret.size(), "zenremote srtp resumed",
+      kSrtpMasterSecretSize);
+  SrtpMasterSecret secret;
+  std::copy(output.begin(), output.end(), secret.begin());
+  return secret;
+}
+
+Sha256Digest ComputeResumeBinder(const SrtpMasterSecret& resumption_secret,
+                                 const uint8_t* data,
+                                 size_t length) {
+  const auto key =
+      HkdfExpandSha256(resumption_secret.data(), resumption_secret.size(),
+                       "zenremote resume binder", kSrtpMasterSecretSize);
+  return HmacSha256(key.data(), key.size(), data, length);
+}
+
+std::vector<uint8_t> DeriveMigrationKey(const SrtpMasterSecret& master_secret) {
+  return HkdfExpandSha256(master_secret.data(), master_secret.size(),
+                          "zenremote migration", kSrtpMasterSecretSize);
+}
+
+bool SrtpSession::ReplayWindow::Check(uint64_t index) const {
+  if (!initialized || index > highest_index) {
+    return true;
+  }
+  const uint64_t delta = highest_index - index;
+  return delta < kSrtpReplayWindowSize && !received.test(delta);
+}
+
+void SrtpSession::ReplayWindow::Update(uint64_t index) {
+  if (!initialized) {
+    initialized = true;
+    highest_index = index;
+    received.reset();
+    received.set(0);
+    return;
+  }
+  if (index > highest_index) {
+    const uint64_t shift = index - highest_index;
+    if (shift >= kSrtpReplayWindowSize) {
+      received.reset();
+    } else {
+      received <<= shift;
+    }
+    received.set(0);
+    highest_index = index;
+    return;
+  }
+  received.set(highest_index - index);
+}
+
+SrtpSession::SrtpSession(const SrtpKeys& outbound, const SrtpKeys& inbound)
+    : SrtpSession(outbound, inbound, Config{}) {}
+
+SrtpSession::SrtpSession(const SrtpKeys& outbound,
+                         const SrtpKeys& inbound,
+                         const Config& config)
+    : outbound_rtp_(outbound.rtp_key.data(), config.implementation),
+      outbound_rtcp_(outbound.rtcp_key.data(), config.implementation),
+      inbound_rtp_(inbound.rtp_key.data(), config.implementation),
+      inbound_rtcp_(inbound.rtcp_key.data(), config.implementation),
+      outbound_keys_(outbound),
+      inbound_keys_(inbound) {}
+
+bool SrtpSession::PrepareRtpLocked(uint8_t* packet,
+                                   size_t length,
+                                   size_t capacity,
+                                   uint8_t* iv,
+                                   AesGcm128::Job& job) {
+  const size_t header_length = RtpHeaderLength(packet, length);
+  if (header_length == 0 || capacity < length + kSrtpOverhead) {
+    return false;
+  }
+  const auto header = ParseRtpHeader(packet, length);
+  if (!header.has_value()) {
+    return false;
+  }
+
+  const uint16_t sequence = header->sequence_number;
+  auto [it, inserted] = send_states_.try_emplace(header->ssrc);
+  SendState& state = it->second;
+  if (inserted) {
+    state.highest_sequence = sequence;
+  }
+  // 重传的旧序列号同样按附录 A 推算，不会误增 ROC
+  const uint32_t roc = EstimateRoc(state.roc, state.highest_sequence, sequence);
+  if (PacketIndex(roc, sequence) >
+      PacketIndex(state.roc, state.highest_sequence)) {
+    state.roc = roc;
+    state.highest_sequence = sequence;
+  }
+
+  BuildRtpIv(outbound_keys_.rtp_salt, header->ssrc, roc, sequence, iv);
+  job.iv = iv;
+  job.aad = packet;
+  job.aad_length = header_length;
+  job.data = packet + header_length;
+  job.length = length - header_length;
+  job.tag = packet + length;
+  return true;
+}
+
+size_t SrtpSession::ProtectRtp(uint8_t* packet,
+                               size_t length,
+                               size_t capacity) {
+  uint8_t iv[AesGcm128::kIvSize];
+  AesGcm128::Job job;
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  if (!PrepareRtpLocked(packet, length, capacity, iv, job)) {
+    ZENREMOTE_WARN("SRTP: cannot protect malformed or full packet");
+    return 0;
+  }
+  outbound_rtp_.Seal(job.iv, job.aad, job.aad_length, job.data, job.length,
+                     job.tag);
+  packets_protected_++;
+  return length + kSrtpOverhead;
+}
+
+bool SrtpSession::ProtectRtp(std::vector<uint8_t>& packet) {
+  const size_t length = packet.size();
+  packet.resize(length + kSrtpOverhead);
+  const size_t protected_length =
+      ProtectRtp(packet.data(), length, packet.size());
+  packet.resize(protected_length != 0 ? protected_length : length);
+  return protected_length != 0;
+}
+
+size_t SrtpSession::ProtectRtpBatch(Buffer* buffers, size_t count) {
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  if (batch_ivs_.size() < count) {
+    batch_ivs_.resize(count);
+  }
+  batch_jobs_.clear();
+  for (size_t i = 0; i < count; ++i) {
+    Buffer& buffer = buffers[i];
+    AesGcm128::Job job;
+    if (!PrepareRtpLocked(buffer.data, buffer.length, buffer.capacity,
+                          batch_ivs_[i].data(), job)) {
+      ZENREMOTE_WARN("SRTP: cannot protect malformed or full packet");
+      buffer.length = 0;
+      continue;
+    }
+    buffer.length += kSrtpOverhead;
+    batch_jobs_.push_back(job);
+  }
+  outbound_rtp_.SealBatch(batch_jobs_.data(), batch_jobs_.size());
+  packets_protected_ += batch_jobs_.size();
+  return batch_jobs_.size();
+}
+
+std::optional<size_t> SrtpSession::UnprotectRtp(uint8_t* packet,
+                                                size_t length) {
+  if (length < kSrtpOverhead) {
+    return std::nullopt;
+  }
+  const size_t plain_length = length - kSrtpOverhead;
+  const size_t header_length = RtpHeaderLength(packet, plain_length);
+  if (header_length == 0) {
+    return std::nullopt;
+  }
+  const auto header = ParseRtpHeader(packet, plain_length);
+  if (!header.has_value()) {
+    return std::nullopt;
+  }
+
+  const uint16_t sequence = header->sequence_number;
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  auto [it, inserted] = receive_states_.try_emplace(header->ssrc);
+  ReceiveState& state = it->second;
+  if (inserted) {
+    state.highest_sequence = sequence;
+  }
+  const uint32_t roc = EstimateRoc(state.roc, state.highest_sequence, sequence);
+  const uint64_t index = PacketIndex(roc, sequence);
+  if (!state.rtp_window.Check(index)) {
+    replayed_++;
+    return std::nullopt;
+  }
+
+  uint8_t iv[AesGcm128::kIvSize];
+  BuildRtpIv(inbound_keys_.rtp_salt, header->ssrc, roc, sequence, iv);
+  if (!inbound_rtp_.Open(iv, packet, header_length, packet + header_length,
+                         plain_length - header_length,
+                         packet + plain_length)) {
+    auth_failures_++;
+    if (inserted) {
+      receive_states_.erase(it);
+    }
+    return std::nullopt;
+  }
+
+  // 只有通过认证的报文才推进 ROC 与重放窗口
+  state.rtp_window.Update(index);
+  if (index > PacketIndex(state.roc, state.highest_sequence)) {
+    state.roc = roc;
+    state.highest_sequence = sequence;
+  }
+  packets_unprotected_++;
+  return plain_length;
+}
+
+size_t SrtpSession::ProtectRtcp(uint8_t* packet,
+                                size_t length,
+                                size_t capacity) {
+  if (length < kRtcpHeaderSize || capacity < length + kSrtcpOverhead) {
+    return 0;
+  }
+  const uint32_t ssrc = LoadBe32(packet + 4);
+
+  std::lock_guard<std::mutex> lock(send_mutex_);
+  SendState& state = send_states_[ssrc];
+  if (state.rtcp_index > kSrtcpIndexMask) {
+    ZENREMOTE_ERROR("SRTCP index exhausted for SSRC 0x{:08X}", ssrc);
+    return 0;
+  }
+  const uint32_t index = state.rtcp_index++;
+
+  // AAD = RTCP 头 8 字节 || E|SRTCP index
+  uint8_t aad[kRtcpHeaderSize + kSrtcpIndexSize];
+  std::copy_n(packet, kRtcpHeaderSize, aad);
+  StoreBe32(kSrtcpEncryptedFlag | index, aad + kRtcpHeaderSize);
+  uint8_t iv[AesGcm128::kIvSize];
+  BuildRtcpIv(outbound_keys_.rtcp_salt, ssrc, index, iv);
+  outbound_rtcp_.Seal(iv, aad, sizeof(aad), packet + kRtcpHeaderSize,
+                      length - kRtcpHeaderSize, packet + length);
+  std::copy_n(aad + kRtcpHeaderSize, kSrtcpIndexSize,
+              packet + length + kSrtpTagSize);
+  packets_protected_++;
+  return length + kSrtcpOverhead;
+}
+
+std::optional<size_t> SrtpSession::UnprotectRtcp(uint8_t* packet,
+                                                 size_t length) {
+  if (length < kRtcpHeaderSize + kSrtcpOverhead) {
+    return std::nullopt;
+  }
+  const size_t plain_length = length - kSrtcpOverhead;
+  const uint8_t* trailer = packet + length - kSrtcpIndexSize;
+  const uint32_t word = LoadBe32(trailer);
+  if (!(word & kSrtcpEncryptedFlag)) {
+    // 只接受加密的 SRTCP，不允许降级为仅认证
+    return std::nullopt;
+  }
+  const uint32_t index = word & kSrtcpIndexMask;
+  const uint32_t ssrc = LoadBe32(packet + 4);
+
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  ReceiveState& state = receive_states_[ssrc];
+  if (!state.rtcp_window.Check(index)) {
+    replayed_++;
+    return std::nullopt;
+  }
+
+  uint8_t aad[kRtcpHeaderSize + kSrtcpIndexSize];
+  std::copy_n(packet, kRtcpHeaderSize, aad);
+  std::copy_n(trailer, kSrtcpIndexSize, aad + kRtcpHeaderSize);
+  uint8_t iv[AesGcm128::kIvSize];
+  BuildRtcpIv(inbound_keys_.rtcp_salt, ssrc, index, iv);
+  if (!inbound_rtcp_.Open(iv, aad, sizeof(aad), packet + kRtcpHeaderSize,
+                          plain_length - kRtcpHeaderSize,
+                          packet + plain_length)) {
+    auth_failures_++;
+    return std::nullopt;
+  }
+  state.rtcp_window.Update(index);
+  packets_unprotected_++;
+  return plain_length;
+}
+
+SrtpSession::Stats SrtpSession::GetStats() const {
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    stats.packets_protected = packets_protected_;
+  }
+  std::lock_guard<std::mutex> lock(receive_mutex_);
+  stats.packets_unprotected = packets_unprotected_;
+  stats.auth_failures = auth_failures_;
+  stats.replayed = replayed_;
+  return stats;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,212 @@
+/**
+ * @file srtp.h
+ * @brief SRTP/SRTCP，AEAD_AES_128_GCM（RFC 3711 + RFC 7714）
+ *
+ * - RTP 头（含 CSRC 与头部扩展）作为 AAD 明文传输，负载就地加密，
+ *   16 字节认证标签写入报文尾部预留空间（tailroom），不另分配缓冲区
+ * - IV = (00 00 || SSRC || ROC || SEQ) XOR salt，ROC 按 RFC 3711 附录 A
+ *   由 16 位序列号推算，每个 SSRC 独立维护
+ * - 接收端 128 包重放窗口：标签校验通过后才更新窗口
+ * - ProtectRtpBatch() 一次加密一帧的全部分片
+ *
+ * 密钥不走 SRTP 的 AES-CM KDF，而是从握手的 X25519 共享密钥经 HKDF-SHA256
+ * 派生（DeriveSrtpMasterSecret / DeriveSrtpKeys），RTP 与 RTCP、两个方向
+ * 各用独立的密钥与 salt，保证 IV 不会跨流复用。
+ *
+ * @note 发送与接收状态分别加锁，可由发送线程与接收线程同时使用
+ */
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "common/aes_gcm.h"
+#include "common/digest.h"
+
+namespace zenremote {
+
+constexpr size_t kSrtpMasterSecretSize = 32;
+constexpr size_t kSrtpSaltSize = 12;
+constexpr size_t kSrtpTagSize = AesGcm128::kTagSize;
+constexpr size_t kSrtcpIndexSize = 4;
+/// @brief 受保护报文相对明文增加的字节数
+constexpr size_t kSrtpOverhead = kSrtpTagSize;
+constexpr size_t kSrtcpOverhead = kSrtpTagSize + kSrtcpIndexSize;
+constexpr size_t kSrtpReplayWindowSize = 128;
+
+using SrtpMasterSecret = std::array<uint8_t, kSrtpMasterSecretSize>;
+
+/// @brief 单个方向的会话密钥
+struct SrtpKeys {
+  std::array<uint8_t, AesGcm128::kKeySize> rtp_key{};
+  std::array<uint8_t, kSrtpSaltSize> rtp_salt{};
+  std::array<uint8_t, AesGcm128::kKeySize> rtcp_key{};
+  std::array<uint8_t, kSrtpSaltSize> rtcp_salt{};
+};
+
+struct SrtpKeyMaterial {
+  SrtpKeys client_to_server;
+  SrtpKeys server_to_client;
+};
+
+/**
+ * @brief 由 ECDH 共享密钥派生会话主密钥
+ *
+ * HKDF salt 绑定会话 ID 与双方 SSRC，同一共享密钥不会用于其他会话。
+ */
+SrtpMasterSecret DeriveSrtpMasterSecret(const uint8_t* shared_secret,
+                                        size_t shared_secret_length,
+                                        uint32_t session_id,
+                                        uint32_t client_ssrc,
+                                        uint32_t server_ssrc);
+
+/// @brief 主密钥展开为两个方向的 SRTP/SRTCP 密钥
+SrtpKeyMaterial DeriveSrtpKeys(const SrtpMasterSecret& master_secret);
+
+/**
+ * @brief 恢复票据对应的密钥（双方各自计算，不随票据传输）
+ *
+ * 恢复的会话以它作为新的主密钥，无需再做一次 ECDH 即可发送 0-RTT 媒体。
+ */
+SrtpMasterSecret DeriveResumptionSecret(const SrtpMasterSecret& master_secret,
+                                        uint64_t ticket_id);
+
+/**
+ * @brief 单次恢复尝试的会话主密钥
+ *
+ * HKDF salt 为控制端在 kResume 中携带的随机 nonce：同一票据重试时 SSRC 与
+ * 序列号都从头开始，只有换用新密钥才能避免 AES-GCM nonce 重用。
+ */
+SrtpMasterSecret DeriveResumedSessionSecret(
+    const SrtpMasterSecret& resumption_secret,
+    const uint8_t* client_nonce,
+    size_t client_nonce_length);
+
+/**
+ * @brief 恢复请求的 binder
+ *
+ * 以恢复密钥派生的 HMAC-SHA256 密钥对 kResume 负载（binder 之前的部分）签名。
+ * 被控端在兑换票据前校验，只见过明文票据 ID 的第三方无法冒用票据。
+ */
+Sha256Digest ComputeResumeBinder(const SrtpMasterSecret& resumption_secret,
+                                 const uint8_t* data,
+                                 size_t length);
+
+/// @brief 连接迁移探测 MESSAGE-INTEGRITY 的 HMAC 密钥
+std::vector<uint8_t> DeriveMigrationKey(const SrtpMasterSecret& master_secret);
+
+class SrtpSession {
+ public:
+  struct Config {
+    AesGcm128::Implementation implementation = AesGcm128::Implementation::kAuto;
+  };
+
+  /// @brief 批量加密的一个报文：length 为明文长度，成功后更新为密文长度
+  struct Buffer {
+    uint8_t* data = nullptr;
+    size_t length = 0;
+    size_t capacity = 0;
+  };
+
+  struct Stats {
+    uint64_t packets_protected = 0;
+    uint64_t packets_unprotected = 0;
+    uint64_t auth_failures = 0;
+    uint64_t replayed = 0;  ///< 重复或落在窗口之外的报文
+  };
+
+  SrtpSession(const SrtpKeys& outbound, const SrtpKeys& inbound);
+  SrtpSession(const SrtpKeys& outbound,
+              const SrtpKeys& inbound,
+              const Config& config);
+
+  /**
+   * @brief 就地加密 RTP 报文
+   * @param capacity 缓冲区总大小，需至少 length + kSrtpOverhead
+   * @return 受保护报文长度；报文格式错误或空间不足返回 0
+   */
+  size_t ProtectRtp(uint8_t* packet, size_t length, size_t capacity);
+
+  bool ProtectRtp(std::vector<uint8_t>& packet);
+
+  /**
+   * @brief 批量加密（通常是同一帧的分片），AES-GCM 上下文只准备一次
+   * @return 成功加密的报文数；失败的报文 length 置 0
+   */
+  size_t ProtectRtpBatch(Buffer* buffers, size_t count);
+
+  /**
+   * @brief 校验并就地解密 RTP 报文
+   * @return 明文长度；认证失败或重放返回 std::nullopt
+   */
+  std::optional<size_t> UnprotectRtp(uint8_t* packet, size_t length);
+
+  /// @brief 就地加密 RTCP 复合包，尾部追加标签与 E|SRTCP index
+  size_t ProtectRtcp(uint8_t* packet, size_t length, size_t capacity);
+
+  std::optional<size_t> UnprotectRtcp(uint8_t* packet, size_t length);
+
+  Stats GetStats() const;
+
+  bool IsHardwareAccelerated() const {
+    return outbound_rtp_.IsHardwareAccelerated();
+  }
+
+ private:
+  struct SendState {
+    uint32_t roc = 0;
+    uint16_t highest_sequence = 0;
+    uint32_t rtcp_index = 0;
+  };
+
+  struct ReplayWindow {
+    bool initialized = false;
+    uint64_t highest_index = 0;
+    std::bitset<kSrtpReplayWindowSize> received;  ///< 第 i 位：highest - i
+
+    bool Check(uint64_t index) const;
+    void Update(uint64_t index);
+  };
+
+  struct ReceiveState {
+    uint32_t roc = 0;
+    uint16_t highest_sequence = 0;
+    ReplayWindow rtp_window;
+    ReplayWindow rtcp_window;
+  };
+
+  /// @brief 准备一个报文的 AES-GCM 任务；格式错误或空间不足返回 false
+  bool PrepareRtpLocked(uint8_t* packet,
+                        size_t length,
+                        size_t capacity,
+                        uint8_t* iv,
+                        AesGcm128::Job& job);
+
+  AesGcm128 outbound_rtp_;
+  AesGcm128 outbound_rtcp_;
+  AesGcm128 inbound_rtp_;
+  AesGcm128 inbound_rtcp_;
+  SrtpKeys outbound_keys_;
+  SrtpKeys inbound_keys_;
+
+  mutable std::mutex send_mutex_;
+  std::unordered_map<uint32_t, SendState> send_states_;
+  std::vector<std::array<uint8_t, AesGcm128::kIvSize>> batch_ivs_;
+  std::vector<AesGcm128::Job> batch_jobs_;
+  uint64_t packets_protected_ = 0;
+
+  mutable std::mutex receive_mutex_;
+  std::unordered_map<uint32_t, ReceiveState> receive_states_;
+  uint64_t packets_unprotected_ = 0;
+  uint64_t auth_failures_ = 0;
+  uint64_t replayed_ = 0;
+};
+
+}  // namespace zenremote
@@ -0,0 +1,325 @@
+#include "network/protocol/stun_message.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/digest.h"
+#include "network/io/socket_types.h"
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint8_t kFamilyIpv4 = 0x01;
+constexpr uint8_t kFamilyIpv6 = 0x02;
+
+void WriteUint16BE(uint16_t value, std::vector<uint8_t>& out) {
+  out.push_back(static_cast<uint8_t>(value >> 8U));
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+void WriteUint32BE(uint32_t value, std::vector<uint8_t>& out) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+uint16_t ReadUint16BE(const uint8_t* data) {
+  return static_cast<uint16_t>((data[0] << 8U) | data[1]);
+}
+
+uint32_t ReadUint32BE(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24U) |
+         (static_cast<uint32_t>(data[1]) << 16U) |
+         (static_cast<uint32_t>(data[2]) << 8U) | data[3];
+}
+
+// 类别位 C0/C1 穿插在方法位之间：M11..M7 C1 M6..M4 C0 M3..M0
+uint16_t EncodeMessageType(uint16_t method, StunClass message_class) {
+  return static_cast<uint16_t>((method & 0x000FU) | ((method & 0x0070U) << 1U) |
+                               ((method & 0x0F80U) << 2U) |
+                               static_cast<uint16_t>(message_class));
+}
+
+void DecodeMessageType(uint16_t type,
+                       uint16_t& method,
+                       StunClass& message_class) {
+  method = static_cast<uint16_t>((type & 0x000FU) | ((type & 0x00E0U) >> 1U) |
+                                 ((type & 0x3E00U) >> 2U));
+  message_class = static_cast<StunClass>(type & 0x0110U);
+}
+
+}  // namespace
+
+void StunMessage::AddAttribute(StunAttributeType type,
+                               std::vector<uint8_t> value) {
+  attributes.push_back({static_cast<uint16_t>(type), std::move(value)});
+}
+
+void StunMessage::AddUint32(StunAttributeType type, uint32_t value) {
+  std::vector<uint8_t> buffer;
+  WriteUint32BE(value, buffer);
+  AddAttribute(type, std::move(buffer));
+}
+
+void StunMessage::AddUint64(StunAttributeType type, uint64_t value) {
+  std::vector<uint8_t> buffer;
+  WriteUint32BE(static_cast<uint32_t>(value >> 32U), buffer);
+  WriteUint32BE(static_cast<uint32_t>(value), buffer);
+  AddAttribute(type, std::move(buffer));
+}
+
+void StunMessage::AddFlag(StunAttributeType type) {
+  AddAttribute(type, {});
+}
+
+void StunMessage::AddString(StunAttributeType type, const std::string& value) {
+  AddAttribute(type, std::vector<uint8_t>(value.begin(), value.end()));
+}
+
+void StunMessage::AddErrorCode(int code, const std::string& reason) {
+  std::vector<uint8_t> buffer = {0, 0, static_cast<uint8_t>(code / 100),
+                                 static_cast<uint8_t>(code % 100)};
+  buffer.insert(buffer.end(), reason.begin(), reason.end());
+  AddAttribute(StunAttributeType::kErrorCode, std::move(buffer));
+}
+
+bool StunMessage::AddXorAddress(StunAttributeType type,
+                                const Endpoint& endpoint) {
+  std::vector<uint8_t> buffer;
+  buffer.push_back(0);
+  const uint16_t xor_port =
+      static_cast<uint16_t>(endpoint.port ^ (kStunMagicCookie >> 16U));
+
+  if (endpoint.address.find(':') != std::string::npos) {
+    uint8_t address[16];
+    if (inet_pton(AF_INET6, endpoint.address.c_str(), address) != 1) {
+      return false;
+    }
+    buffer.push_back(kFamilyIpv6);
+    WriteUint16BE(xor_port, buffer);
+    // IPv6 与 magic cookie + 事务 ID 共 16 字节异或
+    uint8_t mask[16];
+    const uint8_t cookie[4] = {0x21, 0x12, 0xA4, 0x42};
+    std::memcpy(mask, cookie, 4);
+    std::memcpy(mask + 4, transaction_id.data(), kStunTransactionIdSize);
+    for (size_t i = 0; i < 16; ++i) {
+      buffer.push_back(address[i] ^ mask[i]);
+    }
+  } else {
+    in_addr address{};
+    if (inet_pton(AF_INET, endpoint.address.c_str(), &address) != 1) {
+      return false;
+    }
+    buffer.push_back(kFamilyIpv4);
+    WriteUint16BE(xor_port, buffer);
+    uint8_t bytes[4];
+    std::memcpy(bytes, &address, 4);
+    WriteUint32BE(ReadUint32BE(bytes) ^ kStunMagicCookie, buffer);
+  }
+  AddAttribute(type, std::move(buffer));
+  return true;
+}
+
+const StunAttribute* StunMessage::Find(StunAttributeType type) const {
+  for (const auto& attribute : attributes) {
+    if (attribute.type == static_cast<uint16_t>(type)) {
+      return &attribute;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<uint32_t> StunMessage::GetUint32(StunAttributeType type) const {
+  const auto* attribute = Find(type);
+  if (!attribute || attribute->value.size() != 4) {
+    return std::nullopt;
+  }
+  return ReadUint32BE(attribute->value.data());
+}
+
+std::optional<uint64_t> StunMessage::GetUint64(StunAttributeType type) const {
+  const auto* attribute = Find(type);
+  if (!attribute || attribute->value.size() != 8) {
+    return std::nullopt;
+  }
+  return (static_cast<uint64_t>(ReadUint32BE(attribute->value.data())) << 32U) |
+         ReadUint32BE(attribute->value.data() + 4);
+}
+
+std::optional<Endpoint> StunMessage::GetXorAddress(
+    StunAttributeType type) const {
+  const auto* attribute = Find(type);
+  if (!attribute || attribute->value.size() < 4) {
+    return std::nullopt;
+  }
+  const uint8_t* value = attribute->value.data();
+  Endpoint endpoint;
+  endpoint.port = static_cast<uint16_t>(ReadUint16BE(value + 2) ^
+                                        (kStunMagicCookie >> 16U));
+
+  char text[INET6_ADDRSTRLEN];
+  if (value[1] == kFamilyIpv4 && attribute->value.size() == 8) {
+    const uint32_t address = ReadUint32BE(value + 4) ^ kStunMagicCookie;
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(address >> 24U),
+        static_cast<uint8_t>(address >> 16U),
+        static_cast<uint8_t>(address >> 8U), static_cast<uint8_t>(address)};
+    if (!inet_ntop(AF_INET, bytes, text, sizeof(text))) {
+      return std::nullopt;
+    }
+  } else if (value[1] == kFamilyIpv6 && attribute->value.size() == 20) {
+    uint8_t mask[16];
+    const uint8_t cookie[4] = {0x21, 0x12, 0xA4, 0x42};
+    std::memcpy(mask, cookie, 4);
+    std::memcpy(mask + 4, transaction_id.data(), kStunTransactionIdSize);
+    uint8_t bytes[16];
+    for (size_t i = 0; i < 16; ++i) {
+      bytes[i] = value[4 + i] ^ mask[i];
+    }
+    if (!inet_ntop(AF_INET6, bytes, text, sizeof(text))) {
+      return std::nullopt;
+    }
+  } else {
+    return std::nullopt;
+  }
+  endpoint.address = text;
+  return endpoint;
+}
+
+std::optional<std::string> StunMessage::GetString(
+    StunAttributeType type) const {
+  const auto* attribute = Find(type);
+  if (!attribute) {
+    return std::nullopt;
+  }
+  return std::string(attribute->value.begin(), attribute->value.end());
+}
+
+std::optional<int> StunMessage::GetErrorCode() const {
+  const auto* attribute = Find(StunAttributeType::kErrorCode);
+  if (!attribute || attribute->value.size() < 4) {
+    return std::nullopt;
+  }
+  return (attribute->value[2] & 0x07) * 100 + attribute->value[3];
+}
+
+std::vector<uint8_t> SerializeStunMessage(const StunMessage& message) {
+  size_t body_size = 0;
+  for (const auto& attribute : message.attributes) {
+    body_size += kStunAttributeHeaderSize +
+                 ((attribute.value.size() + 3) & ~static_cast<size_t>(3));
+  }
+
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kStunHeaderSize + body_size);
+  WriteUint16BE(EncodeMessageType(message.method, message.message_class),
+                buffer);
+  WriteUint16BE(static_cast<uint16_t>(body_size), buffer);
+  WriteUint32BE(kStunMagicCookie, buffer);
+  buffer.insert(buffer.end(), message.transaction_id.begin(),
+                message.transaction_id.end());
+
+  for (const auto& attribute : message.attributes) {
+    WriteUint16BE(attribute.type, buffer);
+    WriteUint16BE(static_cast<uint16_t>(attribute.value.size()), buffer);
+    buffer.insert(buffer.end(), attribute.value.begin(), attribute.value.end());
+    // 属性值按 4 字节对齐填充
+    buffer.resize(buffer.size() + ((4 - attribute.value.size() % 4) % 4), 0);
+  }
+  return buffer;
+}
+
+std::vector<uint8_t> SerializeStunMessage(const StunMessage& message,
+                                          const std::vector<uint8_t>& key) {
+  auto buffer = SerializeStunMessage(message);
+  // HMAC 覆盖 MESSAGE-INTEGRITY 之前的全部内容，但头部长度字段要先计入
+  // 该属性自身（RFC 8489 14.5）
+  const size_t body_size = buffer.size() - kStunHeaderSize +
+                           kStunAttributeHeaderSize + kStunMessageIntegritySize;
+  buffer[2] = static_cast<uint8_t>(body_size >> 8U);
+  buffer[3] = static_cast<uint8_t>(body_size);
+  const auto hmac =
+      HmacSha1(key.data(), key.size(), buffer.data(), buffer.size());
+  WriteUint16BE(static_cast<uint16_t>(StunAttributeType::kMessageIntegrity),
+                buffer);
+  WriteUint16BE(static_cast<uint16_t>(kStunMessageIntegritySize), buffer);
+  buffer.insert(buffer.end(), hmac.begin(), hmac.end());
+  return buffer;
+}
+
+bool VerifyStunMessageIntegrity(const uint8_t* data,
+                                size_t length,
+                                const std::vector<uint8_t>& key) {
+  if (!IsStunMessage(data, length)) {
+    return false;
+  }
+  const size_t end =
+      std::min(length, kStunHeaderSize + ReadUint16BE(data + 2));
+  size_t offset = kStunHeaderSize;
+  while (offset + kStunAttributeHeaderSize <= end) {
+    const uint16_t type = ReadUint16BE(data + offset);
+    const size_t value_size = ReadUint16BE(data + offset + 2);
+    if (type == static_cast<uint16_t>(StunAttributeType::kMessageIntegrity)) {
+      if (value_size != kStunMessageIntegritySize ||
+          offset + kStunAttributeHeaderSize + value_size > end) {
+        return false;
+      }
+      std::vector<uint8_t> signed_part(data, data + offset);
+      const size_t body_size = offset - kStunHeaderSize +
+                               kStunAttributeHeaderSize +
+                               kStunMessageIntegritySize;
+      signed_part[2] = static_cast<uint8_t>(body_size >> 8U);
+      signed_part[3] = static_cast<uint8_t>(body_size);
+      const auto hmac = HmacSha1(key.data(), key.size(), signed_part.data(),
+                                 signed_part.size());
+      return std::memcmp(hmac.data(), data + offset + kStunAttributeHeaderSize,
+                         kStunMessageIntegritySize) == 0;
+    }
+    offset += kStunAttributeHeaderSize + ((value_size + 3) & ~size_t{3});
+  }
+  return false;
+}
+
+std::vector<uint8_t> ComputeStunLongTermKey(const std::string& username,
+                                            const std::string& realm,
+                                            const std::string& password) {
+  const auto digest = Md5(username + ":" + realm + ":" + password);
+  return std::vector<uint8_t>(digest.begin(), digest.end());
+}
+
+std::optional<StunMessage> ParseStunMessage(const uint8_t* data,
+                                            size_t length) {
+  if (!IsStunMessage(data, length)) {
+    return std::nullopt;
+  }
+  const size_t body_size = ReadUint16BE(data + 2);
+  if (body_size % 4 != 0 || kStunHeaderSize + body_size > length) {
+    return std::nullopt;
+  }
+
+  StunMessage message;
+  DecodeMessageType(ReadUint16BE(data), message.method, message.message_class);
+  std::memcpy(message.transaction_id.data(), data + 8, kStunTransactionIdSize);
+
+  size_t offset = kStunHeaderSize;
+  const size_t end = kStunHeaderSize + body_size;
+  while (offset + kStunAttributeHeaderSize <= end) {
+    StunAttribute attribute;
+    attribute.type = ReadUint16BE(data + offset);
+    const size_t value_size = ReadUint16BE(data + offset + 2);
+    offset += kStunAttributeHeaderSize;
+    if (offset + value_size > end) {
+      return std::nullopt;
+    }
+    attribute.value.assign(data + offset, data + offset + value_size);
+    message.attributes.push_back(std::move(attribute));
+    offset += (value_size + 3) & ~static_cast<size_t>(3);
+  }
+  if (offset != end) {
+    return std::nullopt;
+  }
+  return message;
+}
+
+}  // namespace zenremote
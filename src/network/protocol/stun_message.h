@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "network/io/endpoint.h"
+
+namespace zenremote {
+
+/**
+ * @brief STUN 报文（RFC 8489 子集）
+ *
+ * 用于 ICE 连通性检查，TURN（RFC 8656）复用同一编解码。报文首字节高两位为
+ * 00，与 RTP（10）、TURN ChannelData（01）和可靠传输报文（11）在同一连接上
+ * 可直接区分。多字节字段为大端序（网络序），与 STUN 标准一致。
+ *
+ * MESSAGE-INTEGRITY 用于 TURN 长期凭据、ICE 连通性检查的短期凭据（ICE 密码）
+ * 以及 DirectConnection 迁移探测。事务 ID 为 96 位随机数，未签名时伪造响应
+ * 也需要猜中事务 ID。未实现 FINGERPRINT。
+ */
+constexpr uint32_t kStunMagicCookie = 0x2112A442;
+constexpr size_t kStunHeaderSize = 20;
+constexpr size_t kStunTransactionIdSize = 12;
+constexpr size_t kStunAttributeHeaderSize = 4;
+
+enum class StunClass : uint16_t {
+  kRequest = 0x0000,
+  kIndication = 0x0010,
+  kSuccessResponse = 0x0100,
+  kErrorResponse = 0x0110,
+};
+
+enum class StunMethod : uint16_t {
+  kBinding = 0x001,
+  kAllocate = 0x003,
+  kRefresh = 0x004,
+  kSend = 0x006,
+  kData = 0x007,
+  kCreatePermission = 0x008,
+  kChannelBind = 0x009,
+};
+
+/// @brief ERROR-CODE 中 TURN 客户端需要处理的错误码
+constexpr int kStunErrorUnauthorized = 401;
+constexpr int kStunErrorStaleNonce = 438;
+
+/// @brief MESSAGE-INTEGRITY 属性值长度（HMAC-SHA1）
+constexpr size_t kStunMessageIntegritySize = 20;
+
+enum class StunAttributeType : uint16_t {
+  kUsername = 0x0006,
+  kMessageIntegrity = 0x0008,
+  kErrorCode = 0x0009,
+  kChannelNumber = 0x000C,
+  kLifetime = 0x000D,
+  kXorPeerAddress = 0x0012,
+  kData = 0x0013,
+  kRealm = 0x0014,
+  kNonce = 0x0015,
+  kXorRelayedAddress = 0x0016,
+  kRequestedTransport = 0x0019,
+  kXorMappedAddress = 0x0020,
+  kPriority = 0x0024,
+  kUseCandidate = 0x0025,
+  kIceControlled = 0x8029,
+  kIceControlling = 0x802A,
+  /// 私有属性（0xC000 起，可选理解）：DirectConnection 迁移探测的会话 ID
+  kSessionId = 0xC001,
+};
+
+using StunTransactionId = std::array<uint8_t, kStunTransactionIdSize>;
+
+struct StunAttribute {
+  uint16_t type = 0;
+  std::vector<uint8_t> value;
+};
+
+struct StunMessage {
+  uint16_t method = static_cast<uint16_t>(StunMethod::kBinding);
+  StunClass message_class = StunClass::kRequest;
+  StunTransactionId transaction_id{};
+  std::vector<StunAttribute> attributes;
+
+  void AddAttribute(StunAttributeType type, std::vector<uint8_t> value);
+  void AddUint32(StunAttributeType type, uint32_t value);
+  void AddUint64(StunAttributeType type, uint64_t value);
+  /// @brief 无值属性（如 USE-CANDIDATE）
+  void AddFlag(StunAttributeType type);
+  void AddString(StunAttributeType type, const std::string& value);
+  /// @brief ERROR-CODE：类别（百位）+ 编号 + UTF-8 原因短语
+  void AddErrorCode(int code, const std::string& reason);
+  /// @brief XOR 编码的地址属性，地址无效时返回 false
+  bool AddXorAddress(StunAttributeType type, const Endpoint& endpoint);
+
+  const StunAttribute* Find(StunAttributeType type) const;
+  bool Has(StunAttributeType type) const { return Find(type) != nullptr; }
+  std::optional<uint32_t> GetUint32(StunAttributeType type) const;
+  std::optional<uint64_t> GetUint64(StunAttributeType type) const;
+  std::optional<Endpoint> GetXorAddress(StunAttributeType type) const;
+  std::optional<std::string> GetString(StunAttributeType type) const;
+  /// @brief 错误响应的错误码（如 401），没有 ERROR-CODE 属性返回空
+  std::optional<int> GetErrorCode() const;
+
+  bool IsBinding() const {
+    return method == static_cast<uint16_t>(StunMethod::kBinding);
+  }
+  bool Is(StunMethod expected) const {
+    return method == static_cast<uint16_t>(expected);
+  }
+};
+
+inline bool IsStunMessage(const uint8_t* data, size_t length) {
+  return data && length >= kStunHeaderSize && (data[0] & 0xC0U) == 0 &&
+         data[4] == 0x21 && data[5] == 0x12 && data[6] == 0xA4 &&
+         data[7] == 0x42;
+}
+
+std::vector<uint8_t> SerializeStunMessage(const StunMessage& message);
+
+/**
+ * @brief 序列化并在末尾追加 MESSAGE-INTEGRITY
+ * @param key 长期凭据密钥，见 ComputeStunLongTermKey()
+ * @note message 自身不应包含 MESSAGE-INTEGRITY 属性
+ */
+std::vector<uint8_t> SerializeStunMessage(const StunMessage& message,
+                                          const std::vector<uint8_t>& key);
+
+/**
+ * @brief 校验原始报文的 MESSAGE-INTEGRITY
+ * @return 存在该属性且 HMAC 匹配返回 true
+ */
+bool VerifyStunMessageIntegrity(const uint8_t* data,
+                                size_t length,
+                                const std::vector<uint8_t>& key);
+
+/// @brief 长期凭据密钥 MD5(username ":" realm ":" password)
+std::vector<uint8_t> ComputeStunLongTermKey(const std::string& username,
+                                            const std::string& realm,
+                                            const std::string& password);
+
+std::optional<StunMessage> ParseStunMessage(const uint8_t* data,
+                                            size_t length);
+
+/**
+ * @brief TURN ChannelData 报文（RFC 8656 12.4）
+ *
+ * 4 字节头：通道号（0x4000-0x4FFF）+ 数据长度，后接应用数据。通道绑定后
+ * 媒体以此格式收发，相比 Send/Data indication（20 字节 STUN 头 +
+ * XOR-PEER-ADDRESS + DATA 属性头，IPv4 共 36 字节）每包省 32 字节。
+ * UDP 上数据无需补齐到 4 字节。
+ */
+constexpr size_t kChannelDataHeaderSize = 4;
+constexpr uint16_t kMinChannelNumber = 0x4000;
+constexpr uint16_t kMaxChannelNumber = 0x4FFF;
+
+inline bool IsChannelData(const uint8_t* data, size_t length) {
+  return data && length >= kChannelDataHeaderSize && (data[0] & 0xF0U) == 0x40;
+}
+
+inline void WriteChannelDataHeader(uint16_t channel,
+                                   size_t length,
+                                   uint8_t* out) {
+  out[0] = static_cast<uint8_t>(channel >> 8U);
+  out[1] = static_cast<uint8_t>(channel);
+  out[2] = static_cast<uint8_t>(length >> 8U);
+  out[3] = static_cast<uint8_t>(length);
+}
+
+/**
+ * @brief 解析 ChannelData 头
+ * @param payload_length 输出声明的数据长度
+ * @return 通道号；报文不是 ChannelData 或长度不足时返回空
+ */
+inline std::optional<uint16_t> ParseChannelDataHeader(const uint8_t* data,
+                                                      size_t length,
+                                                      size_t& payload_length) {
+  if (!IsChannelData(data, length)) {
+    return std::nullopt;
+  }
+  payload_length = static_cast<size_t>((data[2] << 8U) | data[3]);
+  if (kChannelDataHeaderSize + payload_length > length) {
+    return std::nullopt;
+  }
+  return static_cast<uint16_t>((data[0] << 8U) | data[1]);
+}
+
+}  // namespace zenremote
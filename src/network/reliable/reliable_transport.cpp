@@ -1,30 +1,970 @@
 #include "reliable_transport.h"
 
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+#include "common/log_manager.h"
 #include "network/connection/base_connection.h"
 
 namespace zenremote {
 
+namespace {
+
+double ElapsedMs(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+}  // namespace
+
 ReliableTransport::ReliableTransport(BaseConnection* connection,
                                      const Config& config)
-    : connection_(connection), config_(config) {}
+    : connection_(connection), config_(config) {
+  config_.mtu = std::max(config_.mtu, kDataHeaderSize + 1);
+  cwnd_ = std::max<size_t>(config_.initial_cwnd_packets, 1) * config_.mtu;
+  ssthresh_ = config_.max_receive_buffer_bytes;
+  peer_rwnd_ = config_.max_receive_buffer_bytes;
+  rto_ms_ = std::clamp(config_.initial_rto_ms, kMinRtoMs, kMaxRtoMs);
+  has_lifetime_limit_ = config_.max_packet_life_time_ms > 0;
+  packet_buffer_.reserve(config_.mtu);
+}
 
 ReliableTransport::~ReliableTransport() = default;
 
 Result<void> ReliableTransport::Send(const uint8_t* data, size_t length) {
+  return Send(config_.stream_id, data, length);
+}
+
+Result<void> ReliableTransport::Send(uint16_t stream_id,
+                                     const uint8_t* data,
+                                     size_t length) {
+  return Send(stream_id, data, length, nullptr, 0);
+}
+
+Result<void> ReliableTransport::Send(uint16_t stream_id,
+                                     const uint8_t* header,
+                                     size_t header_length,
+                                     std::shared_ptr<const uint8_t> body,
+                                     size_t body_length) {
   if (!connection_) {
     return Result<void>::Err(ErrorCode::kNetworkError, "No connection");
   }
+  const size_t length = header_length + body_length;
+  if ((header_length > 0 && !header) || (body_length > 0 && !body) ||
+      length == 0) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Invalid message parameters");
+  }
+  const size_t fragments = (length + MaxPayloadSize() - 1) / MaxPayloadSize();
+  // 对端（同样配置）的接收缓冲区放不下的消息永远无法重组
+  if (fragments > 0xFFFFU || length > config_.max_receive_buffer_bytes) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Message too large");
+  }
 
-  // TODO: 添加序列号、ACK 机制
-  auto send_result = connection_->Send(data, length);
-  if (!send_result.IsOk()) {
-    return Result<void>::Err(send_result.Code(), send_result.Message());
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (send_buffered_bytes_ + length > config_.max_send_buffer_bytes) {
+    return Result<void>::Err(ErrorCode::kChannelFull, "Send buffer full");
   }
+
+  auto now = Clock::now();
+  StreamState& stream = GetStreamLocked(stream_id);
+  OutboundMessage message;
+  message.message_id = next_message_id_++;
+  message.stream_id = stream_id;
+  message.unordered = !stream.options.ordered;
+  message.max_retransmits = stream.options.max_retransmits;
+  message.max_packet_life_time_ms = stream.options.max_packet_life_time_ms;
+  auto payload = std::make_shared<MessagePayload>();
+  payload->header.assign(header, header + header_length);
+  payload->body = std::move(body);
+  payload->body_length = body_length;
+  message.data = std::move(payload);
+  message.created = now;
+  stream.queue.push_back(std::move(message));
+  stream.buffered_bytes += length;
+  send_buffered_bytes_ += length;
+  stats_.messages_sent++;
+  scheduler_.SetActive(stream_id, true);
+
+  TrySendLocked(now);
   return Result<void>::Ok();
 }
 
-void ReliableTransport::OnAckReceived(uint32_t sequence_number) {
-  // TODO: 处理 ACK
+void ReliableTransport::OnPacketReceived(const uint8_t* data, size_t length) {
+  if (!IsTransportPacket(data, length)) {
+    return;
+  }
+
+  MessageList ready;
+  OnMessageCallback callback;
+  OnStreamMessageCallback stream_callback;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = Clock::now();
+
+    switch (static_cast<TransportPacketType>(data[0])) {
+      case TransportPacketType::kData: {
+        auto chunk = ParseDataChunk(data, length);
+        if (!chunk.has_value()) {
+          ZENREMOTE_WARN("Failed to parse DATA chunk");
+          return;
+        }
+        OnData(std::move(chunk.value()), now, ready);
+        break;
+      }
+
+      case TransportPacketType::kSack: {
+        auto sack = ParseTransportSack(data, length);
+        if (!sack.has_value()) {
+          ZENREMOTE_WARN("Failed to parse SACK");
+          return;
+        }
+        OnSack(sack.value(), now);
+        break;
+      }
+
+      case TransportPacketType::kForwardTsn: {
+        auto forward_tsn = ParseTransportForwardTsn(data, length);
+        if (!forward_tsn.has_value()) {
+          ZENREMOTE_WARN("Failed to parse FORWARD-TSN");
+          return;
+        }
+        OnForwardTsn(forward_tsn.value(), now, ready);
+        break;
+      }
+    }
+
+    stats_.messages_delivered += ready.size();
+    callback = on_message_callback_;
+    stream_callback = on_stream_message_callback_;
+  }
+
+  for (const auto& message : ready) {
+    if (callback) {
+      callback(message.data.data(), message.data.size());
+    }
+    if (stream_callback) {
+      stream_callback(message.stream_id, message.data.data(),
+                      message.data.size());
+    }
+  }
+}
+
+void ReliableTransport::ProcessTimers() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = Clock::now();
+
+  // AbandonMessage 可能向 outstanding_ 追加占位块，按下标遍历
+  for (size_t i = 0; has_lifetime_limit_ && i < outstanding_.size(); ++i) {
+    auto& chunk = outstanding_[i];
+    if (!chunk.acked && !chunk.abandoned &&
+        IsExpired(chunk.message_created, chunk.max_packet_life_time_ms, now)) {
+      AbandonMessage(chunk);
+    }
+  }
+
+  // RTT 采样已扣除对端延迟 ACK 时间，超时需加回
+  if (rtx_timer_running_ &&
+      ElapsedMs(rtx_timer_start_, now) >= rto_ms_ + kDelayedAckMs) {
+    OnRetransmissionTimeout(now);
+  }
+
+  if (pending_ack_count_ > 0 &&
+      ElapsedMs(ack_pending_since_, now) >= kDelayedAckMs) {
+    SendSack(now);
+  }
+
+  TrySendLocked(now);
+}
+
+int ReliableTransport::GetTimerDelayMs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::optional<Clock::time_point> next;
+  auto consider = [&next](Clock::time_point deadline) {
+    if (!next || deadline < *next) {
+      next = deadline;
+    }
+  };
+
+  if (rtx_timer_running_) {
+    consider(rtx_timer_start_ +
+             std::chrono::milliseconds(rto_ms_ + kDelayedAckMs));
+  }
+  if (pending_ack_count_ > 0) {
+    consider(ack_pending_since_ + std::chrono::milliseconds(kDelayedAckMs));
+  }
+  for (size_t i = 0; has_lifetime_limit_ && i < outstanding_.size(); ++i) {
+    const auto& chunk = outstanding_[i];
+    if (!chunk.acked && !chunk.abandoned &&
+        chunk.max_packet_life_time_ms > 0) {
+      // IsExpired 要求严格超过存活时间
+      consider(chunk.message_created +
+               std::chrono::milliseconds(chunk.max_packet_life_time_ms + 1));
+    }
+  }
+
+  if (!next) {
+    return -1;
+  }
+  const auto remaining = *next - Clock::now();
+  if (remaining <= Clock::duration::zero()) {
+    return 0;
+  }
+  return static_cast<int>(
+      std::chrono::ceil<std::chrono::milliseconds>(remaining).count());
+}
+
+void ReliableTransport::ConfigureStream(uint16_t stream_id,
+                                        const StreamOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  StreamState& stream = GetStreamLocked(stream_id);
+  stream.options = options;
+  if (options.max_packet_life_time_ms > 0) {
+    has_lifetime_limit_ = true;
+  }
+  scheduler_.SetStream(stream_id, options.priority, options.weight);
+}
+
+void ReliableTransport::SetOnMessageCallback(OnMessageCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_message_callback_ = std::move(callback);
+}
+
+void ReliableTransport::SetOnStreamMessageCallback(
+    OnStreamMessageCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_stream_message_callback_ = std::move(callback);
+}
+
+void ReliableTransport::SetOnTimerScheduledCallback(
+    OnTimerScheduledCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_timer_scheduled_callback_ = std::move(callback);
+}
+
+size_t ReliableTransport::GetBufferedAmount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return send_buffered_bytes_;
+}
+
+size_t ReliableTransport::GetBufferedAmount(uint16_t stream_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = streams_.find(stream_id);
+  return it != streams_.end() ? it->second.buffered_bytes : 0;
+}
+
+size_t ReliableTransport::GetCongestionWindow() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cwnd_;
+}
+
+int ReliableTransport::GetRtoMs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return rto_ms_;
+}
+
+double ReliableTransport::GetSmoothedRttMs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return srtt_ms_;
+}
+
+ReliableTransport::Stats ReliableTransport::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+// ============================================================================
+// 发送端
+// ============================================================================
+
+ReliableTransport::StreamState& ReliableTransport::GetStreamLocked(
+    uint16_t stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end()) {
+    return it->second;
+  }
+  StreamState& stream = streams_[stream_id];
+  stream.options.ordered = config_.ordered;
+  stream.options.max_retransmits = config_.max_retransmits;
+  stream.options.max_packet_life_time_ms = config_.max_packet_life_time_ms;
+  scheduler_.SetStream(stream_id, stream.options.priority,
+                       stream.options.weight);
+  return stream;
+}
+
+void ReliableTransport::ReleaseSendBuffer(uint16_t stream_id, size_t bytes) {
+  send_buffered_bytes_ -= bytes;
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end()) {
+    it->second.buffered_bytes -= bytes;
+  }
+}
+
+void ReliableTransport::TrySendLocked(Clock::time_point now) {
+  // 重传优先于新数据，同样受拥塞窗口限制。
+  // 窗口很大时 outstanding_ 可达数千块，无待重传块时不做扫描
+  bool retransmit_blocked = false;
+  for (size_t i = 0; retransmit_pending_ && i < outstanding_.size(); ++i) {
+    auto& chunk = outstanding_[i];
+    if (!chunk.needs_retransmit || chunk.acked || chunk.abandoned) {
+      continue;
+    }
+    // 已超出部分可靠限制的块无需等待拥塞窗口，立即放弃
+    if (ShouldAbandon(chunk, now)) {
+      AbandonMessage(chunk);
+      continue;
+    }
+    const size_t packet_size = kDataHeaderSize + chunk.length;
+    if (flight_size_ > 0 && flight_size_ + packet_size > cwnd_) {
+      retransmit_blocked = true;
+      break;
+    }
+    TransmitChunk(chunk, now);
+  }
+  retransmit_pending_ = retransmit_blocked;
+
+  // 新数据按流调度，每次只取一个数据块，使不同流的分片交错
+  const size_t max_payload = MaxPayloadSize();
+  while (true) {
+    auto next_stream = scheduler_.Next();
+    if (!next_stream.has_value()) {
+      break;
+    }
+    const uint16_t stream_id = next_stream.value();
+    StreamState& stream = streams_[stream_id];
+    if (stream.queue.empty()) {
+      scheduler_.SetActive(stream_id, false);
+      continue;
+    }
+    OutboundMessage& message = stream.queue.front();
+
+    // 尚未发出任何分片的过期消息直接丢弃，不占用 MID
+    if (message.next_fsn == 0 &&
+        IsExpired(message.created, message.max_packet_life_time_ms, now)) {
+      ReleaseSendBuffer(stream_id, message.data->size());
+      stats_.messages_abandoned++;
+      stream.queue.pop_front();
+      continue;
+    }
+
+    const size_t length =
+        std::min(max_payload, message.data->size() - message.offset);
+    const size_t packet_size = kDataHeaderSize + length;
+    if (flight_size_ > 0 &&
+        (flight_size_ + packet_size > cwnd_ || peer_rwnd_ < length)) {
+      break;
+    }
+
+    if (message.next_fsn == 0) {
+      auto& mids = message.unordered ? send_unordered_mid_ : send_ordered_mid_;
+      message.mid = mids[message.stream_id]++;
+    }
+
+    OutstandingChunk chunk;
+    chunk.tsn = next_tsn_++;
+    chunk.stream_id = message.stream_id;
+    chunk.mid = message.mid;
+    chunk.fsn = message.next_fsn;
+    chunk.flags = message.unordered ? kDataFlagUnordered : 0;
+    if (message.offset == 0) {
+      chunk.flags |= kDataFlagBegin;
+    }
+    if (message.offset + length == message.data->size()) {
+      chunk.flags |= kDataFlagEnd;
+    }
+    chunk.message = message.data;
+    chunk.offset = message.offset;
+    chunk.length = length;
+    chunk.message_id = message.message_id;
+    chunk.max_retransmits = message.max_retransmits;
+    chunk.max_packet_life_time_ms = message.max_packet_life_time_ms;
+    chunk.message_created = message.created;
+
+    message.offset += length;
+    message.next_fsn++;
+    if (message.offset == message.data->size()) {
+      stream.queue.pop_front();
+    }
+    scheduler_.OnSent(stream_id, packet_size);
+
+    outstanding_.push_back(std::move(chunk));
+    stats_.bytes_sent += length;
+    TransmitChunk(outstanding_.back(), now);
+  }
+
+  if (forward_tsn_pending_) {
+    SendForwardTsn();
+  }
+}
+
+bool ReliableTransport::TransmitChunk(OutstandingChunk& chunk,
+                                      Clock::time_point now) {
+  if (ShouldAbandon(chunk, now)) {
+    AbandonMessage(chunk);
+    return false;
+  }
+
+  DataChunk header;
+  header.flags = chunk.flags;
+  header.stream_id = chunk.stream_id;
+  header.tsn = chunk.tsn;
+  header.mid = chunk.mid;
+  header.fsn = chunk.fsn;
+
+  packet_buffer_.clear();
+  WriteDataChunkHeader(header, packet_buffer_);
+  chunk.message->AppendTo(chunk.offset, chunk.length, packet_buffer_);
+  SendPacket(packet_buffer_);
+
+  if (chunk.transmit_count > 0) {
+    stats_.packets_retransmitted++;
+  }
+  chunk.transmit_count++;
+  chunk.last_sent = now;
+  chunk.needs_retransmit = false;
+  chunk.in_flight = true;
+  flight_size_ += kDataHeaderSize + chunk.length;
+  peer_rwnd_ = peer_rwnd_ > chunk.length ? peer_rwnd_ - chunk.length : 0;
+  stats_.packets_sent++;
+
+  if (!rtx_timer_running_) {
+    StartRetransmissionTimer(now);
+  }
+  return true;
+}
+
+void ReliableTransport::RemoveFromFlight(OutstandingChunk& chunk) {
+  if (chunk.in_flight) {
+    chunk.in_flight = false;
+    flight_size_ -= kDataHeaderSize + chunk.length;
+  }
+}
+
+void ReliableTransport::AbandonMessage(const OutstandingChunk& target) {
+  const uint64_t message_id = target.message_id;
+  ForwardTsnSkip skip;
+  skip.stream_id = target.stream_id;
+  skip.unordered = (target.flags & kDataFlagUnordered) != 0;
+  skip.mid = target.mid;
+
+  uint32_t last_tsn = target.tsn;
+  for (auto& chunk : outstanding_) {
+    if (chunk.message_id != message_id) {
+      continue;
+    }
+    last_tsn = chunk.tsn;
+    if (chunk.acked || chunk.abandoned) {
+      continue;
+    }
+    chunk.abandoned = true;
+    chunk.needs_retransmit = false;
+    RemoveFromFlight(chunk);
+    ReleaseSendBuffer(chunk.stream_id, chunk.length);
+  }
+
+  // 仍有分片未发出：丢弃剩余部分，并占用一个永不发送的 TSN，
+  // 保证对端只能通过 FORWARD-TSN 越过该消息
+  auto& queue = streams_[skip.stream_id].queue;
+  auto it = std::find_if(queue.begin(), queue.end(),
+                         [message_id](const OutboundMessage& message) {
+                           return message.message_id == message_id;
+                         });
+  if (it != queue.end()) {
+    ReleaseSendBuffer(skip.stream_id, it->data->size() - it->offset);
+    queue.erase(it);
+
+    OutstandingChunk placeholder;
+    placeholder.tsn = next_tsn_++;
+    placeholder.stream_id = skip.stream_id;
+    placeholder.mid = skip.mid;
+    placeholder.message_id = message_id;
+    placeholder.abandoned = true;
+    outstanding_.push_back(std::move(placeholder));
+    last_tsn = outstanding_.back().tsn;
+  }
+
+  ZENREMOTE_DEBUG("Abandoned message: stream={}, mid={}, last_tsn={}",
+                  skip.stream_id, skip.mid, last_tsn);
+  pending_skips_.push_back({skip, last_tsn});
+  stats_.messages_abandoned++;
+  forward_tsn_pending_ = true;
+}
+
+bool ReliableTransport::ShouldAbandon(const OutstandingChunk& chunk,
+                                      Clock::time_point now) const {
+  if (chunk.transmit_count == 0) {
+    return false;
+  }
+  const bool retransmits_exhausted =
+      chunk.max_retransmits >= 0 &&
+      chunk.transmit_count > chunk.max_retransmits;
+  return retransmits_exhausted ||
+         IsExpired(chunk.message_created, chunk.max_packet_life_time_ms, now);
+}
+
+bool ReliableTransport::IsExpired(Clock::time_point created,
+                                  int max_packet_life_time_ms,
+                                  Clock::time_point now) const {
+  return max_packet_life_time_ms > 0 &&
+         ElapsedMs(created, now) > max_packet_life_time_ms;
+}
+
+void ReliableTransport::OnSack(const TransportSack& sack,
+                               Clock::time_point now) {
+  stats_.sacks_received++;
+  const uint32_t cumulative = sack.cumulative_tsn;
+  if (TsnLessThan(cumulative, cumulative_ack_tsn_) ||
+      TsnLessThan(next_tsn_, cumulative)) {
+    return;  // 过期或非法的 SACK
+  }
+
+  const bool cumulative_advanced = cumulative != cumulative_ack_tsn_;
+  size_t bytes_acked = 0;
+  bool has_rtt_sample = false;
+  Clock::time_point rtt_send_time;
+  bool any_newly_acked = false;
+  uint32_t highest_newly_acked = cumulative_ack_tsn_;
+
+  auto ack_chunk = [&](OutstandingChunk& chunk) {
+    if (chunk.acked) {
+      return;
+    }
+    chunk.acked = true;
+    chunk.needs_retransmit = false;
+    RemoveFromFlight(chunk);
+    if (chunk.abandoned) {
+      return;
+    }
+    bytes_acked += chunk.length;
+    ReleaseSendBuffer(chunk.stream_id, chunk.length);
+    // Karn 算法：重传过的块不参与 RTT 采样
+    if (chunk.transmit_count == 1 &&
+        (!has_rtt_sample || rtt_send_time < chunk.last_sent)) {
+      rtt_send_time = chunk.last_sent;
+      has_rtt_sample = true;
+    }
+    if (!any_newly_acked || TsnLessThan(highest_newly_acked, chunk.tsn)) {
+      highest_newly_acked = chunk.tsn;
+    }
+    any_newly_acked = true;
+  };
+
+  while (!outstanding_.empty() &&
+         TsnLessThan(outstanding_.front().tsn, cumulative)) {
+    ack_chunk(outstanding_.front());
+    outstanding_.pop_front();
+  }
+  cumulative_ack_tsn_ = cumulative;
+
+  // outstanding_ 中 TSN 连续，front 即 cumulative
+  for (const auto& block : sack.gap_blocks) {
+    for (uint32_t offset = block.start; offset <= block.end; ++offset) {
+      if (offset >= outstanding_.size()) {
+        break;
+      }
+      ack_chunk(outstanding_[offset]);
+    }
+  }
+
+  if (has_rtt_sample) {
+    const double sample_ms = ElapsedMs(rtt_send_time, now) - sack.ack_delay_ms;
+    UpdateRto(std::max(sample_ms, 0.0));
+  }
+
+  // HTNA：只有比缺失块更新的块被确认时才累计缺失次数
+  bool fast_retransmit = false;
+  if (any_newly_acked) {
+    for (auto& chunk : outstanding_) {
+      if (!TsnLessThan(chunk.tsn, highest_newly_acked)) {
+        break;
+      }
+      if (chunk.acked || chunk.abandoned || !chunk.in_flight) {
+        continue;
+      }
+      if (++chunk.miss_indications >= kFastRetransmitThreshold &&
+          !chunk.fast_retransmitted) {
+        chunk.fast_retransmitted = true;
+        chunk.needs_retransmit = true;
+        retransmit_pending_ = true;
+        RemoveFromFlight(chunk);
+        fast_retransmit = true;
+        stats_.fast_retransmits++;
+        ZENREMOTE_DEBUG("Fast retransmit: tsn={}", chunk.tsn);
+      }
+    }
+  }
+
+  // 恢复开始时已发送的数据全部被累积确认后退出快速恢复
+  if (in_fast_recovery_ && TsnLessThan(fast_recovery_exit_tsn_, cumulative)) {
+    in_fast_recovery_ = false;
+  }
+
+  if (fast_retransmit && !in_fast_recovery_) {
+    ssthresh_ = std::max(cwnd_ / 2, 4 * config_.mtu);
+    cwnd_ = ssthresh_;
+    partial_bytes_acked_ = 0;
+    in_fast_recovery_ = true;
+    fast_recovery_exit_tsn_ = next_tsn_ - 1;
+  } else if (cumulative_advanced && bytes_acked > 0 && !in_fast_recovery_) {
+    if (cwnd_ <= ssthresh_) {
+      cwnd_ += std::min(bytes_acked, config_.mtu);
+    } else {
+      partial_bytes_acked_ += bytes_acked;
+      if (partial_bytes_acked_ >= cwnd_) {
+        partial_bytes_acked_ -= cwnd_;
+        cwnd_ += config_.mtu;
+      }
+    }
+  }
+
+  peer_rwnd_ = sack.a_rwnd > flight_size_ ? sack.a_rwnd - flight_size_ : 0;
+
+  // FORWARD-TSN 尚未被确认时保持定时器，超时后重发
+  const bool forward_tsn_outstanding =
+      AdvancedPeerAckPoint() != cumulative_ack_tsn_;
+  if (flight_size_ == 0 && !forward_tsn_outstanding) {
+    rtx_timer_running_ = false;
+  } else if (cumulative_advanced || !rtx_timer_running_) {
+    rtx_timer_running_ = true;
+    rtx_timer_start_ = now;
+  }
+
+  // 已确认的放弃消息无需再通知
+  pending_skips_.erase(
+      std::remove_if(pending_skips_.begin(), pending_skips_.end(),
+                     [this](const PendingSkip& pending) {
+                       return TsnLessThan(pending.last_tsn,
+                                          cumulative_ack_tsn_);
+                     }),
+      pending_skips_.end());
+  if (forward_tsn_outstanding) {
+    forward_tsn_pending_ = true;
+  }
+
+  TrySendLocked(now);
+}
+
+void ReliableTransport::OnRetransmissionTimeout(Clock::time_point now) {
+  if (flight_size_ == 0) {
+    // 仅 FORWARD-TSN 未被确认：重发即可，不视为拥塞
+    forward_tsn_pending_ = true;
+    rtx_timer_start_ = now;
+    return;
+  }
+
+  stats_.timeouts++;
+  ssthresh_ = std::max(cwnd_ / 2, 4 * config_.mtu);
+  cwnd_ = config_.mtu;
+  partial_bytes_acked_ = 0;
+  in_fast_recovery_ = false;
+  rto_ms_ = std::min(rto_ms_ * 2, kMaxRtoMs);
+
+  for (auto& chunk : outstanding_) {
+    if (chunk.in_flight && !chunk.acked && !chunk.abandoned) {
+      RemoveFromFlight(chunk);
+      chunk.needs_retransmit = true;
+      retransmit_pending_ = true;
+    }
+  }
+  rtx_timer_running_ = false;
+
+  if (AdvancedPeerAckPoint() != cumulative_ack_tsn_ ||
+      !pending_skips_.empty()) {
+    forward_tsn_pending_ = true;
+  }
+
+  ZENREMOTE_DEBUG("Retransmission timeout: cum_ack={}, rto={}ms",
+                  cumulative_ack_tsn_, rto_ms_);
+}
+
+void ReliableTransport::StartRetransmissionTimer(Clock::time_point now) {
+  rtx_timer_running_ = true;
+  rtx_timer_start_ = now;
+  if (on_timer_scheduled_callback_) {
+    on_timer_scheduled_callback_();
+  }
+}
+
+uint32_t ReliableTransport::AdvancedPeerAckPoint() const {
+  uint32_t point = cumulative_ack_tsn_;
+  for (const auto& chunk : outstanding_) {
+    if (!chunk.acked && !chunk.abandoned) {
+      break;
+    }
+    point = chunk.tsn + 1;
+  }
+  return point;
+}
+
+void ReliableTransport::SendForwardTsn() {
+  forward_tsn_pending_ = false;
+
+  TransportForwardTsn forward_tsn;
+  forward_tsn.new_cumulative_tsn = AdvancedPeerAckPoint();
+  forward_tsn.skips.reserve(pending_skips_.size());
+  for (const auto& pending : pending_skips_) {
+    forward_tsn.skips.push_back(pending.skip);
+  }
+  if (forward_tsn.new_cumulative_tsn == cumulative_ack_tsn_ &&
+      forward_tsn.skips.empty()) {
+    return;
+  }
+
+  SendPacket(SerializeTransportForwardTsn(forward_tsn));
+  stats_.forward_tsns_sent++;
+
+  if (!rtx_timer_running_) {
+    StartRetransmissionTimer(Clock::now());
+  }
+}
+
+void ReliableTransport::UpdateRto(double rtt_sample_ms) {
+  // RFC 6298 2.2/2.3
+  if (!has_rtt_sample_) {
+    srtt_ms_ = rtt_sample_ms;
+    rttvar_ms_ = rtt_sample_ms / 2.0;
+    has_rtt_sample_ = true;
+  } else {
+    rttvar_ms_ = 0.75 * rttvar_ms_ + 0.25 * std::fabs(srtt_ms_ - rtt_sample_ms);
+    srtt_ms_ = 0.875 * srtt_ms_ + 0.125 * rtt_sample_ms;
+  }
+
+  const double rto = srtt_ms_ + std::max(1.0, 4.0 * rttvar_ms_);
+  rto_ms_ = std::clamp(static_cast<int>(std::ceil(rto)), kMinRtoMs, kMaxRtoMs);
+}
+
+// ============================================================================
+// 接收端
+// ============================================================================
+
+void ReliableTransport::OnData(DataChunk chunk,
+                               Clock::time_point now,
+                               MessageList& ready) {
+  stats_.packets_received++;
+  const uint32_t tsn = chunk.tsn;
+
+  if (TsnLessThan(tsn, cumulative_tsn_) ||
+      received_above_cumulative_.count(tsn) > 0) {
+    stats_.duplicates_received++;
+    ScheduleAck(true, now);
+    return;
+  }
+
+  // 填补缺口的 TSN 优先接收（RFC 4960 6.2）：缓冲区被乱序数据占满时，
+  // 只有它能推进累积点、交付消息并释放缓冲。给它留一倍余量而不是不设
+  // 上限，避免对端用永不结束的消息无限占用内存
+  const size_t buffer_limit = tsn == cumulative_tsn_
+                                  ? 2 * config_.max_receive_buffer_bytes
+                                  : config_.max_receive_buffer_bytes;
+  if (tsn - cumulative_tsn_ >= kMaxReceiveWindowPackets ||
+      receive_buffered_bytes_ + chunk.payload.size() > buffer_limit) {
+    // 超出接收窗口：不记录，等待发送端重传
+    stats_.packets_dropped_window++;
+    ScheduleAck(true, now);
+    return;
+  }
+
+  bool out_of_order = false;
+  if (tsn == cumulative_tsn_) {
+    cumulative_tsn_++;
+    while (!received_above_cumulative_.empty() &&
+           *received_above_cumulative_.begin() == cumulative_tsn_) {
+      received_above_cumulative_.erase(received_above_cumulative_.begin());
+      cumulative_tsn_++;
+    }
+  } else {
+    received_above_cumulative_.insert(tsn);
+    out_of_order = true;
+  }
+
+  const bool unordered = (chunk.flags & kDataFlagUnordered) != 0;
+  if (!unordered &&
+      TsnLessThan(chunk.mid, next_ordered_mid_[chunk.stream_id])) {
+    // 消息已投递或已被 FORWARD-TSN 跳过
+    ScheduleAck(out_of_order, now);
+    return;
+  }
+
+  MessageKey key{chunk.stream_id, unordered, chunk.mid};
+  PartialMessage& partial = reassembly_[key];
+  if (partial.fragments.count(chunk.fsn) == 0) {
+    partial.bytes += chunk.payload.size();
+    receive_buffered_bytes_ += chunk.payload.size();
+    if (chunk.flags & kDataFlagEnd) {
+      partial.has_end = true;
+      partial.end_fsn = chunk.fsn;
+    }
+    partial.fragments.emplace(chunk.fsn, std::move(chunk.payload));
+  }
+
+  if (partial.has_end &&
+      partial.fragments.size() == static_cast<size_t>(partial.end_fsn) + 1) {
+    std::vector<uint8_t> message;
+    message.reserve(partial.bytes);
+    for (auto& fragment : partial.fragments) {
+      message.insert(message.end(), fragment.second.begin(),
+                     fragment.second.end());
+    }
+    receive_buffered_bytes_ -= partial.bytes;
+    reassembly_.erase(key);
+
+    if (unordered) {
+      ready.push_back({key.stream_id, std::move(message)});
+    } else {
+      receive_buffered_bytes_ += message.size();
+      ordered_ready_[key.stream_id].emplace(key.mid, std::move(message));
+      DeliverOrdered(key.stream_id, ready);
+    }
+  }
+
+  ScheduleAck(out_of_order || !received_above_cumulative_.empty(), now);
+}
+
+void ReliableTransport::OnForwardTsn(const TransportForwardTsn& forward_tsn,
+                                     Clock::time_point now,
+                                     MessageList& ready) {
+  const uint32_t new_cumulative = forward_tsn.new_cumulative_tsn;
+  if (TsnLessThan(cumulative_tsn_, new_cumulative)) {
+    while (!received_above_cumulative_.empty() &&
+           TsnLessThan(*received_above_cumulative_.begin(), new_cumulative)) {
+      received_above_cumulative_.erase(received_above_cumulative_.begin());
+    }
+    cumulative_tsn_ = new_cumulative;
+    while (!received_above_cumulative_.empty() &&
+           *received_above_cumulative_.begin() == cumulative_tsn_) {
+      received_above_cumulative_.erase(received_above_cumulative_.begin());
+      cumulative_tsn_++;
+    }
+  }
+
+  auto skips = forward_tsn.skips;
+  std::sort(skips.begin(), skips.end(),
+            [](const ForwardTsnSkip& a, const ForwardTsnSkip& b) {
+              return TsnLessThan(a.mid, b.mid);
+            });
+
+  for (const auto& skip : skips) {
+    if (skip.unordered) {
+      auto it = reassembly_.find(MessageKey{skip.stream_id, true, skip.mid});
+      if (it != reassembly_.end()) {
+        receive_buffered_bytes_ -= it->second.bytes;
+        reassembly_.erase(it);
+      }
+      continue;
+    }
+
+    uint32_t& next_mid = next_ordered_mid_[skip.stream_id];
+    if (TsnLessThan(skip.mid, next_mid)) {
+      continue;
+    }
+
+    // 丢弃被跳过消息（及更早消息）的残余分片
+    for (auto it = reassembly_.begin(); it != reassembly_.end();) {
+      if (it->first.stream_id == skip.stream_id && !it->first.unordered &&
+          !TsnLessThan(skip.mid, it->first.mid)) {
+        receive_buffered_bytes_ -= it->second.bytes;
+        it = reassembly_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    // 被跳过消息之前已完整的消息按序投递
+    auto& queue = ordered_ready_[skip.stream_id];
+    while (!queue.empty() && TsnLessThan(queue.begin()->first, skip.mid)) {
+      receive_buffered_bytes_ -= queue.begin()->second.size();
+      ready.push_back({skip.stream_id, std::move(queue.begin()->second)});
+      queue.erase(queue.begin());
+    }
+    next_mid = skip.mid + 1;
+    DeliverOrdered(skip.stream_id, ready);
+  }
+
+  ScheduleAck(true, now);
+}
+
+void ReliableTransport::DeliverOrdered(uint16_t stream_id, MessageList& ready) {
+  uint32_t& next_mid = next_ordered_mid_[stream_id];
+  auto& queue = ordered_ready_[stream_id];
+  while (!queue.empty() && queue.begin()->first == next_mid) {
+    receive_buffered_bytes_ -= queue.begin()->second.size();
+    ready.push_back({stream_id, std::move(queue.begin()->second)});
+    queue.erase(queue.begin());
+    next_mid++;
+  }
+}
+
+void ReliableTransport::ScheduleAck(bool immediate, Clock::time_point now) {
+  if (pending_ack_count_++ == 0) {
+    ack_pending_since_ = now;
+  }
+  // 乱序/重复/有间隙时立即反馈，否则合并
+  if (immediate || pending_ack_count_ >= kAckCoalesceCount) {
+    SendSack(now);
+  }
+}
+
+void ReliableTransport::SendSack(Clock::time_point now) {
+  TransportSack sack;
+  sack.cumulative_tsn = cumulative_tsn_;
+  sack.ack_delay_ms = static_cast<uint16_t>(
+      std::min(ElapsedMs(ack_pending_since_, now), 65535.0));
+  sack.a_rwnd = static_cast<uint32_t>(
+      config_.max_receive_buffer_bytes > receive_buffered_bytes_
+          ? config_.max_receive_buffer_bytes - receive_buffered_bytes_
+          : 0);
+  pending_ack_count_ = 0;
+
+  for (uint32_t tsn : received_above_cumulative_) {
+    const uint32_t offset = tsn - cumulative_tsn_;
+    if (offset > 0xFFFFU) {
+      break;
+    }
+    if (!sack.gap_blocks.empty() &&
+        static_cast<uint32_t>(sack.gap_blocks.back().end) + 1 == offset) {
+      sack.gap_blocks.back().end = static_cast<uint16_t>(offset);
+      continue;
+    }
+    if (sack.gap_blocks.size() == kMaxSackGapBlocks) {
+      break;
+    }
+    sack.gap_blocks.push_back(
+        {static_cast<uint16_t>(offset), static_cast<uint16_t>(offset)});
+  }
+
+  SendPacket(SerializeTransportSack(sack));
+  stats_.sacks_sent++;
+}
+
+void ReliableTransport::SendPacket(const std::vector<uint8_t>& packet) {
+  auto result = connection_->Send(packet.data(), packet.size());
+  if (result.IsErr()) {
+    // 发送失败按丢包处理，由重传机制恢复
+    ZENREMOTE_DEBUG("Transport packet send failed: {}", result.Message());
+  }
+}
+
+void ReliableTransport::MessagePayload::AppendTo(
+    size_t offset,
+    size_t length,
+    std::vector<uint8_t>& out) const {
+  if (offset < header.size()) {
+    const size_t n = std::min(length, header.size() - offset);
+    out.insert(out.end(), header.begin() + offset,
+               header.begin() + offset + n);
+    offset += n;
+    length -= n;
+  }
+  if (length > 0) {
+    const uint8_t* begin = body.get() + (offset - header.size());
+    out.insert(out.end(), begin, begin + length);
+  }
+}
+
+size_t ReliableTransport::MaxPayloadSize() const {
+  return config_.mtu - kDataHeaderSize;
 }
 
 }  // namespace zenremote
@@ -1,35 +1,317 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
 
 #include "common/error.h"
+#include "network/reliable/stream_scheduler.h"
+#include "network/reliable/transport_packet.h"
 
 namespace zenremote {
 
 class BaseConnection;
 
 /**
- * @brief 可靠传输层
+ * @brief 可靠传输层（窗口化 ARQ，参考 SCTP / RFC 4960、RFC 8260、RFC 3758）
+ *
+ * - 发送/接收窗口：每个报文一个 TSN，接收端回复累积 TSN + 间隙块（SACK）
+ * - 重传：RFC 6298 自适应 RTO；SACK 连续报告缺失时快速重传
+ * - 有序/无序投递；部分可靠（max_retransmits / max_packet_life_time_ms），
+ *   放弃的消息通过 FORWARD-TSN 通知接收端跳过
+ * - 超过 MTU 的消息自动分片，接收端按 (stream, mid, fsn) 重组
+ * - 多流复用：每个流独立的有序性、可靠性与优先级，发送端由
+ *   StreamScheduler 逐块调度，不同流的分片交错发送
+ * - 拥塞窗口（慢启动 / 拥塞避免 / 快速恢复）与对端接收窗口共同限制发送
+ *
+ * 驱动方式：收到的传输层报文交给 OnPacketReceived()，并在 GetTimerDelayMs()
+ * 给出的时刻调用 ProcessTimers() 处理重传超时、延迟 ACK 与消息过期；
+ * 没有定时器时无需唤醒。其他线程的 Send() 启动新定时器时通过
+ * OnTimerScheduledCallback 通知驱动线程重新计算等待时长。
+ * 线程安全：Send 可与 OnPacketReceived / ProcessTimers 在不同线程调用；
+ * 消息回调在内部锁之外执行。
  */
 class ReliableTransport {
  public:
+  /// @brief 单个流的投递与调度参数
+  struct StreamOptions {
+    bool ordered = true;
+    int max_retransmits = -1;          ///< 部分可靠：最大重传次数，-1 = 不限
+    int max_packet_life_time_ms = 0;   ///< 部分可靠：消息最长存活时间，0 = 不限
+    uint8_t priority = 0;              ///< 严格优先级，越大越优先
+    uint16_t weight = StreamScheduler::kDefaultWeight;  ///< 同优先级内的带宽权重
+  };
+
   struct Config {
-    int max_retries = 3;
+    // 默认流及未经 ConfigureStream 配置的流使用的参数
     bool ordered = true;
-    int timeout_ms = 100;
+    int max_retransmits = -1;          ///< 部分可靠：最大重传次数，-1 = 不限
+    int max_packet_life_time_ms = 0;   ///< 部分可靠：消息最长存活时间，0 = 不限
+    uint16_t stream_id = 0;            ///< Send(data, length) 使用的默认流
+    size_t mtu = 1200;                 ///< 单个报文最大字节数（含传输层头部）
+    int initial_rto_ms = 100;
+    size_t initial_cwnd_packets = 10;  ///< 初始拥塞窗口（RFC 6928）
+    size_t max_send_buffer_bytes = 16 * 1024 * 1024;
+    size_t max_receive_buffer_bytes = 4 * 1024 * 1024;  ///< 两端应相同
+  };
+
+  static constexpr int kMinRtoMs = 20;
+  static constexpr int kMaxRtoMs = 2000;
+  static constexpr int kDelayedAckMs = 5;
+  static constexpr int kAckCoalesceCount = 2;
+  static constexpr int kFastRetransmitThreshold = 3;
+  static constexpr uint32_t kMaxReceiveWindowPackets = 32768;
+
+  struct Stats {
+    uint64_t messages_sent = 0;
+    uint64_t messages_delivered = 0;
+    uint64_t messages_abandoned = 0;
+    uint64_t bytes_sent = 0;  ///< 首次发送的负载字节数
+    uint64_t packets_sent = 0;
+    uint64_t packets_retransmitted = 0;
+    uint64_t fast_retransmits = 0;
+    uint64_t timeouts = 0;
+    uint64_t packets_received = 0;
+    uint64_t duplicates_received = 0;
+    uint64_t packets_dropped_window = 0;
+    uint64_t sacks_sent = 0;
+    uint64_t sacks_received = 0;
+    uint64_t forward_tsns_sent = 0;
   };
 
+  using OnMessageCallback =
+      std::function<void(const uint8_t* data, size_t length)>;
+  using OnStreamMessageCallback = std::function<
+      void(uint16_t stream_id, const uint8_t* data, size_t length)>;
+  /// @brief 空闲状态下启动了新定时器，在内部锁内调用，只应做轻量唤醒
+  using OnTimerScheduledCallback = std::function<void()>;
+
   ReliableTransport(BaseConnection* connection, const Config& config);
   ~ReliableTransport();
 
+  /**
+   * @brief 发送一条消息（超过 MTU 时自动分片）
+   * @return 发送缓冲区已满时返回 kChannelFull；消息超过
+   *         max_receive_buffer_bytes（对端无法重组）时返回 kInvalidParameter
+   */
   Result<void> Send(const uint8_t* data, size_t length);
-  void OnAckReceived(uint32_t sequence_number);
+
+  /// @brief 在指定流上发送一条消息
+  Result<void> Send(uint16_t stream_id, const uint8_t* data, size_t length);
+
+  /**
+   * @brief 发送由 header 与外部 body 拼接而成的消息
+   *
+   * header 被复制；body 仅持有引用（例如指向 mmap 映射区），直到消息被确认
+   * 或放弃，发送与重传期间只在组装报文时读取，不额外复制整条消息。
+   */
+  Result<void> Send(uint16_t stream_id,
+                    const uint8_t* header,
+                    size_t header_length,
+                    std::shared_ptr<const uint8_t> body,
+                    size_t body_length);
+
+  /// @brief 设置流参数，对之后提交的消息生效
+  void ConfigureStream(uint16_t stream_id, const StreamOptions& options);
+
+  /// @brief 处理对端发来的 DATA / SACK / FORWARD-TSN 报文
+  void OnPacketReceived(const uint8_t* data, size_t length);
+
+  void ProcessTimers();
+
+  /**
+   * @brief 距下一个定时器到期的毫秒数（向上取整）
+   * @return 已到期返回 0，没有运行中的定时器返回 -1
+   */
+  int GetTimerDelayMs() const;
+
+  void SetOnMessageCallback(OnMessageCallback callback);
+  void SetOnStreamMessageCallback(OnStreamMessageCallback callback);
+  void SetOnTimerScheduledCallback(OnTimerScheduledCallback callback);
+
+  /// @brief 已提交但尚未被确认（或放弃）的负载字节数
+  size_t GetBufferedAmount() const;
+  size_t GetBufferedAmount(uint16_t stream_id) const;
+  size_t GetCongestionWindow() const;
+  int GetRtoMs() const;
+  double GetSmoothedRttMs() const;
+  Stats GetStats() const;
 
  private:
+  using Clock = std::chrono::steady_clock;
+
+  // 消息内容：header 按值保存，body 引用调用方内存
+  struct MessagePayload {
+    std::vector<uint8_t> header;
+    std::shared_ptr<const uint8_t> body;
+    size_t body_length = 0;
+
+    size_t size() const { return header.size() + body_length; }
+    void AppendTo(size_t offset, size_t length, std::vector<uint8_t>& out) const;
+  };
+
+  // 等待分片发送的消息
+  struct OutboundMessage {
+    uint64_t message_id = 0;
+    uint16_t stream_id = 0;
+    bool unordered = false;
+    std::shared_ptr<const MessagePayload> data;
+    size_t offset = 0;
+    uint16_t next_fsn = 0;
+    uint32_t mid = 0;
+    int max_retransmits = -1;
+    int max_packet_life_time_ms = 0;
+    Clock::time_point created;
+  };
+
+  struct StreamState {
+    StreamOptions options;
+    std::deque<OutboundMessage> queue;
+    size_t buffered_bytes = 0;
+  };
+
+  // 已分配 TSN 的数据块，TSN 在 outstanding_ 中连续递增
+  struct OutstandingChunk {
+    uint32_t tsn = 0;
+    uint16_t stream_id = 0;
+    uint8_t flags = 0;
+    uint32_t mid = 0;
+    uint16_t fsn = 0;
+    std::shared_ptr<const MessagePayload> message;
+    size_t offset = 0;
+    size_t length = 0;
+    uint64_t message_id = 0;
+    int max_retransmits = -1;
+    int max_packet_life_time_ms = 0;
+    Clock::time_point message_created;
+    Clock::time_point last_sent;
+    int transmit_count = 0;
+    int miss_indications = 0;
+    bool acked = false;
+    bool abandoned = false;
+    bool in_flight = false;
+    bool needs_retransmit = false;
+    bool fast_retransmitted = false;
+  };
+
+  struct PendingSkip {
+    ForwardTsnSkip skip;
+    uint32_t last_tsn = 0;
+  };
+
+  struct MessageKey {
+    uint16_t stream_id = 0;
+    bool unordered = false;
+    uint32_t mid = 0;
+
+    bool operator<(const MessageKey& other) const {
+      if (stream_id != other.stream_id) {
+        return stream_id < other.stream_id;
+      }
+      if (unordered != other.unordered) {
+        return unordered < other.unordered;
+      }
+      return mid < other.mid;
+    }
+  };
+
+  struct PartialMessage {
+    std::map<uint16_t, std::vector<uint8_t>> fragments;
+    bool has_end = false;
+    uint16_t end_fsn = 0;
+    size_t bytes = 0;
+  };
+
+  struct DeliveredMessage {
+    uint16_t stream_id = 0;
+    std::vector<uint8_t> data;
+  };
+  using MessageList = std::vector<DeliveredMessage>;
+
+  // ---- 发送端（调用时需持有 mutex_）----
+  StreamState& GetStreamLocked(uint16_t stream_id);
+  void ReleaseSendBuffer(uint16_t stream_id, size_t bytes);
+  void TrySendLocked(Clock::time_point now);
+  bool TransmitChunk(OutstandingChunk& chunk, Clock::time_point now);
+  void RemoveFromFlight(OutstandingChunk& chunk);
+  void AbandonMessage(const OutstandingChunk& chunk);
+  bool ShouldAbandon(const OutstandingChunk& chunk, Clock::time_point now) const;
+  bool IsExpired(Clock::time_point created,
+                 int max_packet_life_time_ms,
+                 Clock::time_point now) const;
+  void OnSack(const TransportSack& sack, Clock::time_point now);
+  void OnRetransmissionTimeout(Clock::time_point now);
+  void StartRetransmissionTimer(Clock::time_point now);
+  uint32_t AdvancedPeerAckPoint() const;
+  void SendForwardTsn();
+  void UpdateRto(double rtt_sample_ms);
+
+  // ---- 接收端（调用时需持有 mutex_）----
+  void OnData(DataChunk chunk, Clock::time_point now, MessageList& ready);
+  void OnForwardTsn(const TransportForwardTsn& forward_tsn,
+                    Clock::time_point now,
+                    MessageList& ready);
+  void DeliverOrdered(uint16_t stream_id, MessageList& ready);
+  void ScheduleAck(bool immediate, Clock::time_point now);
+  void SendSack(Clock::time_point now);
+
+  void SendPacket(const std::vector<uint8_t>& packet);
+  size_t MaxPayloadSize() const;
+
   BaseConnection* connection_;
   Config config_;
-  uint32_t sequence_number_ = 0;
+  mutable std::mutex mutex_;
+  OnMessageCallback on_message_callback_;
+  OnStreamMessageCallback on_stream_message_callback_;
+  OnTimerScheduledCallback on_timer_scheduled_callback_;
+
+  // 发送端状态
+  std::map<uint16_t, StreamState> streams_;
+  StreamScheduler scheduler_;
+  std::deque<OutstandingChunk> outstanding_;
+  std::vector<PendingSkip> pending_skips_;
+  std::map<uint16_t, uint32_t> send_ordered_mid_;
+  std::map<uint16_t, uint32_t> send_unordered_mid_;
+  uint64_t next_message_id_ = 0;
+  uint32_t next_tsn_ = 0;
+  uint32_t cumulative_ack_tsn_ = 0;  ///< 对端已累积确认到的 TSN（下一个期望值）
+  size_t send_buffered_bytes_ = 0;
+  size_t flight_size_ = 0;
+  size_t cwnd_ = 0;
+  size_t ssthresh_ = 0;
+  size_t partial_bytes_acked_ = 0;
+  size_t peer_rwnd_ = 0;
+  bool in_fast_recovery_ = false;
+  uint32_t fast_recovery_exit_tsn_ = 0;
+  bool forward_tsn_pending_ = false;
+  bool retransmit_pending_ = false;  ///< 可能有块待重传，为 false 时跳过扫描
+  bool has_lifetime_limit_ = false;  ///< 有流配置了消息存活时间，需扫描过期块
+
+  bool rtx_timer_running_ = false;
+  Clock::time_point rtx_timer_start_;
+  double srtt_ms_ = 0.0;
+  double rttvar_ms_ = 0.0;
+  bool has_rtt_sample_ = false;
+  int rto_ms_ = 0;
+
+  // 接收端状态
+  uint32_t cumulative_tsn_ = 0;  ///< 下一个期望接收的 TSN
+  std::set<uint32_t> received_above_cumulative_;
+  std::map<MessageKey, PartialMessage> reassembly_;
+  std::map<uint16_t, uint32_t> next_ordered_mid_;
+  std::map<uint16_t, std::map<uint32_t, std::vector<uint8_t>>> ordered_ready_;
+  size_t receive_buffered_bytes_ = 0;
+  int pending_ack_count_ = 0;
+  Clock::time_point ack_pending_since_;
+
+  std::vector<uint8_t> packet_buffer_;
+  Stats stats_;
 };
 
 }  // namespace zenremote
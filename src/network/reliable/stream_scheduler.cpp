@@ -0,0 +1,77 @@
+#include "stream_scheduler.h"
+
+#include <algorithm>
+
+namespace zenremote {
+
+void StreamScheduler::SetStream(uint16_t stream_id,
+                                uint8_t priority,
+                                uint16_t weight) {
+  Stream& stream = streams_[stream_id];
+  if (stream.active && stream.priority != priority) {
+    // 换到新优先级时从该级当前虚拟时间开始，不携带旧级别的积累
+    stream.start_tag = virtual_time_[priority];
+  }
+  stream.priority = priority;
+  stream.weight = std::max<uint16_t>(weight, 1);
+}
+
+void StreamScheduler::RemoveStream(uint16_t stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    return;
+  }
+  if (it->second.active) {
+    active_count_--;
+  }
+  streams_.erase(it);
+}
+
+void StreamScheduler::SetActive(uint16_t stream_id, bool active) {
+  Stream& stream = streams_[stream_id];
+  if (stream.active == active) {
+    return;
+  }
+  stream.active = active;
+  if (active) {
+    // 空闲期间不积累份额：重新激活时不早于当前虚拟时间
+    stream.start_tag =
+        std::max(stream.start_tag, virtual_time_[stream.priority]);
+    active_count_++;
+  } else {
+    active_count_--;
+  }
+}
+
+std::optional<uint16_t> StreamScheduler::Next() const {
+  if (active_count_ == 0) {
+    return std::nullopt;
+  }
+
+  const Stream* best = nullptr;
+  uint16_t best_id = 0;
+  for (const auto& [stream_id, stream] : streams_) {
+    if (!stream.active) {
+      continue;
+    }
+    if (!best || stream.priority > best->priority ||
+        (stream.priority == best->priority &&
+         stream.start_tag < best->start_tag)) {
+      best = &stream;
+      best_id = stream_id;
+    }
+  }
+  return best ? std::optional<uint16_t>(best_id) : std::nullopt;
+}
+
+void StreamScheduler::OnSent(uint16_t stream_id, size_t bytes) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    return;
+  }
+  Stream& stream = it->second;
+  virtual_time_[stream.priority] = stream.start_tag;
+  stream.start_tag += bytes * kWeightScale / stream.weight;
+}
+
+}  // namespace zenremote
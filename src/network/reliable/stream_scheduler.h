@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace zenremote {
+
+/**
+ * @brief 多流发送调度器
+ *
+ * - 不同优先级之间严格优先：高优先级流有待发数据时，低优先级流不发送
+ * - 同一优先级内按权重公平分配带宽（Start-time Fair Queuing）
+ *
+ * 调度粒度为单个数据块而非整条消息，不同流的分片交错发送，
+ * 大消息（剪贴板、文件）不会在发送端阻塞其它流的小消息。
+ * 非线程安全，由 ReliableTransport 在持锁状态下调用。
+ */
+class StreamScheduler {
+ public:
+  static constexpr uint16_t kDefaultWeight = 1;
+
+  /// @brief 注册或更新流的调度参数（priority 越大越优先，weight 至少为 1）
+  void SetStream(uint16_t stream_id, uint8_t priority, uint16_t weight);
+  void RemoveStream(uint16_t stream_id);
+
+  /// @brief 流的发送队列由空变为非空（或反之）时调用
+  void SetActive(uint16_t stream_id, bool active);
+
+  /// @brief 选出下一个发送数据块的流，没有待发数据时返回 nullopt
+  std::optional<uint16_t> Next() const;
+
+  /// @brief 记录 Next() 选出的流发送了 bytes 字节
+  void OnSent(uint16_t stream_id, size_t bytes);
+
+  bool HasActive() const { return active_count_ > 0; }
+
+ private:
+  // 虚拟时间按 bytes * kWeightScale / weight 推进，避免浮点运算
+  static constexpr uint64_t kWeightScale = 1 << 16;
+
+  struct Stream {
+    uint8_t priority = 0;
+    uint16_t weight = kDefaultWeight;
+    bool active = false;
+    uint64_t start_tag = 0;  ///< 下一个数据块的虚拟开始时间
+  };
+
+  std::map<uint16_t, Stream> streams_;
+  std::map<uint8_t, uint64_t> virtual_time_;  ///< 每个优先级的系统虚拟时间
+  size_t active_count_ = 0;
+};
+
+}  // namespace zenremote
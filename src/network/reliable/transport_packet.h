@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "network/protocol/protocol.h"
+
+namespace zenremote {
+
+/**
+ * @brief 可靠传输层报文格式（参考 SCTP I-DATA / SACK / I-FORWARD-TSN）
+ *
+ * 首字节为报文类型，取值 0xD0-0xD2：高两位为 11，不会与 RTP（V=2 → 10）、
+ * STUN（00）和 TURN ChannelData（01）冲突，可在同一连接上复用。
+ * 多字节字段均为小端序，与 protocol.h 保持一致。
+ */
+enum class TransportPacketType : uint8_t {
+  kData = 0xD0,
+  kSack = 0xD1,
+  kForwardTsn = 0xD2,
+};
+
+// DATA 标志位
+constexpr uint8_t kDataFlagUnordered = 0x01;
+constexpr uint8_t kDataFlagBegin = 0x02;
+constexpr uint8_t kDataFlagEnd = 0x04;
+
+// type(1) flags(1) stream_id(2) tsn(4) mid(4) fsn(2)
+constexpr size_t kDataHeaderSize = 14;
+// type(1) flags(1) ack_delay_ms(2) cumulative_tsn(4) a_rwnd(4) gap_count(1)
+constexpr size_t kSackHeaderSize = 13;
+constexpr size_t kSackGapBlockSize = 4;
+constexpr size_t kMaxSackGapBlocks = 32;
+// type(1) flags(1) skip_count(2) new_cumulative_tsn(4)
+constexpr size_t kForwardTsnHeaderSize = 8;
+// stream_id(2) flags(1) reserved(1) mid(4)
+constexpr size_t kForwardTsnSkipSize = 8;
+
+/**
+ * @brief 数据块
+ *
+ * tsn 为每个块的传输序列号，用于确认/重传；
+ * mid 为流内消息序号（有序/无序各自独立编号），fsn 为消息内分片序号。
+ * 以 (stream_id, unordered, mid) + fsn 重组，不要求分片的 TSN 连续，
+ * 因此不同流的分片可以交错发送。
+ */
+struct DataChunk {
+  uint8_t flags = 0;
+  uint16_t stream_id = 0;
+  uint32_t tsn = 0;
+  uint32_t mid = 0;
+  uint16_t fsn = 0;
+  std::vector<uint8_t> payload;
+};
+
+/**
+ * @brief 选择性确认
+ *
+ * cumulative_tsn 为下一个期望的 TSN（之前的全部已收到）；
+ * 间隙块 [start, end] 为相对 cumulative_tsn 的偏移（闭区间，>= 1），表示已收到。
+ */
+struct SackGapBlock {
+  uint16_t start = 0;
+  uint16_t end = 0;
+};
+
+struct TransportSack {
+  uint16_t ack_delay_ms = 0;
+  uint32_t cumulative_tsn = 0;
+  uint32_t a_rwnd = 0;
+  std::vector<SackGapBlock> gap_blocks;
+};
+
+/**
+ * @brief 前移累积确认点（部分可靠）
+ *
+ * 发送端放弃的消息由 skips 列出，接收端丢弃其已收到的分片，
+ * 有序流的期望 MID 越过被放弃的消息。
+ */
+struct ForwardTsnSkip {
+  uint16_t stream_id = 0;
+  bool unordered = false;
+  uint32_t mid = 0;
+};
+
+struct TransportForwardTsn {
+  uint32_t new_cumulative_tsn = 0;
+  std::vector<ForwardTsnSkip> skips;
+};
+
+// 32 位序列号的回绕比较 (RFC 1982)
+inline bool TsnLessThan(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+inline bool IsTransportPacket(const uint8_t* data, size_t length) {
+  return data && length >= 1 &&
+         data[0] >= static_cast<uint8_t>(TransportPacketType::kData) &&
+         data[0] <= static_cast<uint8_t>(TransportPacketType::kForwardTsn);
+}
+
+// 只写入头部（忽略 chunk.payload），便于调用方直接追加负载切片
+inline void WriteDataChunkHeader(const DataChunk& chunk,
+                                 std::vector<uint8_t>& out) {
+  out.push_back(static_cast<uint8_t>(TransportPacketType::kData));
+  out.push_back(chunk.flags);
+  WriteUint16LE(chunk.stream_id, out);
+  WriteUint32LE(chunk.tsn, out);
+  WriteUint32LE(chunk.mid, out);
+  WriteUint16LE(chunk.fsn, out);
+}
+
+inline std::vector<uint8_t> SerializeDataChunk(const DataChunk& chunk) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kDataHeaderSize + chunk.payload.size());
+  WriteDataChunkHeader(chunk, buffer);
+  buffer.insert(buffer.end(), chunk.payload.begin(), chunk.payload.end());
+  return buffer;
+}
+
+inline std::optional<DataChunk> ParseDataChunk(const uint8_t* data,
+                                               size_t length) {
+  if (!data || length < kDataHeaderSize ||
+      data[0] != static_cast<uint8_t>(TransportPacketType::kData)) {
+    return std::nullopt;
+  }
+  DataChunk chunk;
+  chunk.flags = data[1];
+  chunk.stream_id = ReadUint16LE(data + 2);
+  chunk.tsn = ReadUint32LE(data + 4);
+  chunk.mid = ReadUint32LE(data + 8);
+  chunk.fsn = ReadUint16LE(data + 12);
+  chunk.payload.assign(data + kDataHeaderSize, data + length);
+  return chunk;
+}
+
+inline std::vector<uint8_t> SerializeTransportSack(const TransportSack& sack) {
+  const size_t gap_count = sack.gap_blocks.size() < kMaxSackGapBlocks
+                               ? sack.gap_blocks.size()
+                               : kMaxSackGapBlocks;
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kSackHeaderSize + gap_count * kSackGapBlockSize);
+  buffer.push_back(static_cast<uint8_t>(TransportPacketType::kSack));
+  buffer.push_back(0);
+  WriteUint16LE(sack.ack_delay_ms, buffer);
+  WriteUint32LE(sack.cumulative_tsn, buffer);
+  WriteUint32LE(sack.a_rwnd, buffer);
+  buffer.push_back(static_cast<uint8_t>(gap_count));
+  for (size_t i = 0; i < gap_count; ++i) {
+    WriteUint16LE(sack.gap_blocks[i].start, buffer);
+    WriteUint16LE(sack.gap_blocks[i].end, buffer);
+  }
+  return buffer;
+}
+
+inline std::optional<TransportSack> ParseTransportSack(const uint8_t* data,
+                                                       size_t length) {
+  if (!data || length < kSackHeaderSize ||
+      data[0] != static_cast<uint8_t>(TransportPacketType::kSack)) {
+    return std::nullopt;
+  }
+  TransportSack sack;
+  sack.ack_delay_ms = ReadUint16LE(data + 2);
+  sack.cumulative_tsn = ReadUint32LE(data + 4);
+  sack.a_rwnd = ReadUint32LE(data + 8);
+  const size_t gap_count = data[12];
+  if (gap_count > kMaxSackGapBlocks ||
+      length < kSackHeaderSize + gap_count * kSackGapBlockSize) {
+    return std::nullopt;
+  }
+  sack.gap_blocks.resize(gap_count);
+  const uint8_t* cursor = data + kSackHeaderSize;
+  for (size_t i = 0; i < gap_count; ++i) {
+    sack.gap_blocks[i].start = ReadUint16LE(cursor);
+    sack.gap_blocks[i].end = ReadUint16LE(cursor + 2);
+    if (sack.gap_blocks[i].start == 0 ||
+        sack.gap_blocks[i].end < sack.gap_blocks[i].start) {
+      return std::nullopt;
+    }
+    cursor += kSackGapBlockSize;
+  }
+  return sack;
+}
+
+inline std::vector<uint8_t> SerializeTransportForwardTsn(
+    const TransportForwardTsn& forward_tsn) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kForwardTsnHeaderSize +
+                 forward_tsn.skips.size() * kForwardTsnSkipSize);
+  buffer.push_back(static_cast<uint8_t>(TransportPacketType::kForwardTsn));
+  buffer.push_back(0);
+  WriteUint16LE(static_cast<uint16_t>(forward_tsn.skips.size()), buffer);
+  WriteUint32LE(forward_tsn.new_cumulative_tsn, buffer);
+  for (const auto& skip : forward_tsn.skips) {
+    WriteUint16LE(skip.stream_id, buffer);
+    buffer.push_back(skip.unordered ? kDataFlagUnordered : 0);
+    buffer.push_back(0);
+    WriteUint32LE(skip.mid, buffer);
+  }
+  return buffer;
+}
+
+inline std::optional<TransportForwardTsn> ParseTransportForwardTsn(
+    const uint8_t* data,
+    size_t length) {
+  if (!data || length < kForwardTsnHeaderSize ||
+      data[0] != static_cast<uint8_t>(TransportPacketType::kForwardTsn)) {
+    return std::nullopt;
+  }
+  const size_t skip_count = ReadUint16LE(data + 2);
+  if (length < kForwardTsnHeaderSize + skip_count * kForwardTsnSkipSize) {
+    return std::nullopt;
+  }
+  TransportForwardTsn forward_tsn;
+  forward_tsn.new_cumulative_tsn = ReadUint32LE(data + 4);
+  forward_tsn.skips.resize(skip_count);
+  const uint8_t* cursor = data + kForwardTsnHeaderSize;
+  for (size_t i = 0; i < skip_count; ++i) {
+    forward_tsn.skips[i].stream_id = ReadUint16LE(cursor);
+    forward_tsn.skips[i].unordered = (cursor[2] & kDataFlagUnordered) != 0;
+    forward_tsn.skips[i].mid = ReadUint32LE(cursor + 4);
+    cursor += kForwardTsnSkipSize;
+  }
+  return forward_tsn;
+}
+
+}  // namespace zenremote
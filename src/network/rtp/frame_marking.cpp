@@ -0,0 +1,99 @@
+#include "network/rtp/frame_marking.h"
+
+#include <cstring>
+
+#include "network/rtp/rtp_packet.h"
+
+namespace zenremote {
+namespace rtp {
+
+namespace {
+
+constexpr size_t kExtensionHeaderSize = 4;  // profile(2) 长度(2)
+constexpr uint8_t kFrameMarkingDataSize = 3;
+constexpr uint8_t kPaddingElementId = 0;
+constexpr uint8_t kReservedElementId = 15;
+
+}  // namespace
+
+void WriteFrameMarkingExtension(const FrameMarking& marking, uint8_t* out) {
+  out[0] = static_cast<uint8_t>(kOneByteExtensionProfile >> 8U);
+  out[1] = static_cast<uint8_t>(kOneByteExtensionProfile);
+  // 长度以 32 位字计，不含扩展头
+  out[2] = 0;
+  out[3] = (kFrameMarkingExtensionSize - kExtensionHeaderSize) / 4;
+  out[4] = static_cast<uint8_t>((kFrameMarkingExtensionId << 4U) |
+                                (kFrameMarkingDataSize - 1));
+  out[5] = static_cast<uint8_t>(
+      (marking.start_of_frame ? 0x80U : 0U) |
+      (marking.end_of_frame ? 0x40U : 0U) |
+      (marking.independent ? 0x20U : 0U) |
+      (marking.discardable ? 0x10U : 0U) |
+      (marking.base_layer_sync ? 0x08U : 0U) | (marking.temporal_id & 0x07U));
+  out[6] = marking.layer_id;
+  out[7] = marking.tl0_pic_index;
+}
+
+std::optional<FrameMarking> ParseFrameMarking(const uint8_t* packet,
+                                              size_t length) {
+  network::RTPHeader header;
+  if (!packet || length < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(&header, packet, sizeof(header));
+  if (header.version != 2 || !header.extension) {
+    return std::nullopt;
+  }
+
+  const size_t offset = sizeof(header) + header.csrc_count * 4U;
+  if (offset + kExtensionHeaderSize > length) {
+    return std::nullopt;
+  }
+  const uint8_t* extension = packet + offset;
+  const uint16_t profile =
+      static_cast<uint16_t>((extension[0] << 8U) | extension[1]);
+  const size_t extension_size =
+      ((static_cast<size_t>(extension[2]) << 8U) | extension[3]) * 4;
+  if (profile != kOneByteExtensionProfile ||
+      offset + kExtensionHeaderSize + extension_size > length) {
+    return std::nullopt;
+  }
+
+  // RFC 8285 一字节元素：ID(4) | 长度-1(4)，ID 0 为填充，15 终止解析
+  const uint8_t* element = extension + kExtensionHeaderSize;
+  const uint8_t* end = element + extension_size;
+  while (element < end) {
+    const uint8_t id = element[0] >> 4U;
+    if (id == kPaddingElementId) {
+      ++element;
+      continue;
+    }
+    if (id == kReservedElementId) {
+      break;
+    }
+    const size_t data_size = (element[0] & 0x0FU) + 1U;
+    if (element + 1 + data_size > end) {
+      break;
+    }
+    if (id == kFrameMarkingExtensionId && data_size >= 1) {
+      const uint8_t flags = element[1];
+      FrameMarking marking;
+      marking.start_of_frame = (flags & 0x80U) != 0;
+      marking.end_of_frame = (flags & 0x40U) != 0;
+      marking.independent = (flags & 0x20U) != 0;
+      marking.discardable = (flags & 0x10U) != 0;
+      marking.base_layer_sync = (flags & 0x08U) != 0;
+      marking.temporal_id = flags & 0x07U;
+      if (data_size >= kFrameMarkingDataSize) {
+        marking.layer_id = element[2];
+        marking.tl0_pic_index = element[3];
+      }
+      return marking;
+    }
+    element += 1 + data_size;
+  }
+  return std::nullopt;
+}
+
+}  // namespace rtp
+}  // namespace zenremote
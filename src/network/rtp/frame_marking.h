@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace zenremote {
+namespace rtp {
+
+/**
+ * @brief 帧标记 RTP 头扩展（draft-ietf-avtext-framemarking，可伸缩长格式）
+ *
+ * 使发送端/转发端无需解析编码数据即可按时间层丢帧：
+ *
+ *   0 1 2 3 4 5 6 7   LID (8)   TL0PICIDX (8)
+ *  |S|E|I|D|B| TID |
+ *
+ * 以 RFC 8285 一字节扩展头承载（profile 0xBEDE，元素 ID 为
+ * kFrameMarkingExtensionId），扩展块固定 8 字节。扩展块多字节字段为大端序，
+ * 与 RtpDemuxer 跳过扩展头的解析一致。
+ */
+struct FrameMarking {
+  bool start_of_frame = true;
+  bool end_of_frame = true;
+  bool independent = false;      ///< I：可独立解码（关键帧）
+  bool discardable = false;      ///< D：不被其他帧参考
+  bool base_layer_sync = false;  ///< B：只参考 TL0，可在此向上切换
+  uint8_t temporal_id = 0;       ///< TID（0..7）
+  uint8_t layer_id = 0;          ///< LID，只有时间层时为 0
+  uint8_t tl0_pic_index = 0;     ///< TL0 帧计数（回绕）
+};
+
+constexpr uint8_t kFrameMarkingExtensionId = 1;
+constexpr uint16_t kOneByteExtensionProfile = 0xBEDE;
+/// @brief profile(2) + 长度(2) + 元素头(1) + 数据(3)
+constexpr size_t kFrameMarkingExtensionSize = 8;
+
+/// @brief 写入完整扩展块（kFrameMarkingExtensionSize 字节）
+void WriteFrameMarkingExtension(const FrameMarking& marking, uint8_t* out);
+
+/**
+ * @brief 从 RTP 包（含固定头与 CSRC）中查找帧标记扩展
+ *
+ * 没有扩展、不是一字节扩展头或其中没有帧标记元素时返回 std::nullopt。
+ */
+std::optional<FrameMarking> ParseFrameMarking(const uint8_t* packet,
+                                              size_t length);
+
+}  // namespace rtp
+}  // namespace zenremote
@@ -0,0 +1,199 @@
+#include "network/rtp/rtcp_feedback.h"
+
+#include <algorithm>
+
+namespace zenremote {
+namespace rtp {
+
+namespace {
+
+constexpr uint8_t kRtcpVersion = 2;
+constexpr size_t kNackItemSize = 4;  // PID(2) BLP(2)
+constexpr uint16_t kNackBitmaskSpan = 16;
+constexpr uint8_t kRembIdentifier[4] = {'R', 'E', 'M', 'B'};
+constexpr size_t kRembFixedSize = 8;  // 'REMB'(4) 数量(1) 指数/尾数(3)
+constexpr uint64_t kRembMantissaMax = (1U << 18U) - 1;
+
+void WriteUint16BE(uint16_t value, std::vector<uint8_t>& out) {
+  out.push_back(static_cast<uint8_t>(value >> 8U));
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+void WriteUint32BE(uint32_t value, std::vector<uint8_t>& out) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+uint16_t ReadUint16BE(const uint8_t* data) {
+  return static_cast<uint16_t>((data[0] << 8U) | data[1]);
+}
+
+uint32_t ReadUint32BE(const uint8_t* data) {
+  return (static_cast<uint32_t>(data[0]) << 24U) |
+         (static_cast<uint32_t>(data[1]) << 16U) |
+         (static_cast<uint32_t>(data[2]) << 8U) | data[3];
+}
+
+void WriteFeedbackHeader(uint8_t format,
+                         uint8_t packet_type,
+                         size_t fci_size,
+                         uint32_t sender_ssrc,
+                         uint32_t media_ssrc,
+                         std::vector<uint8_t>& out) {
+  out.push_back(static_cast<uint8_t>((kRtcpVersion << 6U) | format));
+  out.push_back(packet_type);
+  // 长度以 32 位字计，不含首个字
+  WriteUint16BE(
+      static_cast<uint16_t>((kRtcpFeedbackHeaderSize + fci_size) / 4 - 1),
+      out);
+  WriteUint32BE(sender_ssrc, out);
+  WriteUint32BE(media_ssrc, out);
+}
+
+}  // namespace
+
+bool IsRtcpPacket(const uint8_t* data, size_t length) {
+  return data && length >= 4 && (data[0] >> 6U) == kRtcpVersion &&
+         data[1] >= 192 && data[1] <= 223;
+}
+
+std::vector<uint8_t> SerializeNack(uint32_t sender_ssrc,
+                                   uint32_t media_ssrc,
+                                   const std::vector<uint16_t>& sequences) {
+  std::vector<uint16_t> sorted = sequences;
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  // PID 之后 16 个序列号的丢失情况放在 BLP 位图中
+  std::vector<std::pair<uint16_t, uint16_t>> items;
+  for (uint16_t sequence : sorted) {
+    if (!items.empty()) {
+      const uint16_t offset =
+          static_cast<uint16_t>(sequence - items.back().first);
+      if (offset >= 1 && offset <= kNackBitmaskSpan) {
+        items.back().second |= static_cast<uint16_t>(1U << (offset - 1));
+        continue;
+      }
+    }
+    items.emplace_back(sequence, 0);
+  }
+
+  std::vector<uint8_t> packet;
+  packet.reserve(kRtcpFeedbackHeaderSize + items.size() * kNackItemSize);
+  WriteFeedbackHeader(kRtcpFormatNack, kRtcpTypeRtpFeedback,
+                      items.size() * kNackItemSize, sender_ssrc, media_ssrc,
+                      packet);
+  for (const auto& item : items) {
+    WriteUint16BE(item.first, packet);
+    WriteUint16BE(item.second, packet);
+  }
+  return packet;
+}
+
+std::vector<uint8_t> SerializePli(uint32_t sender_ssrc, uint32_t media_ssrc) {
+  std::vector<uint8_t> packet;
+  packet.reserve(kRtcpFeedbackHeaderSize);
+  WriteFeedbackHeader(kRtcpFormatPli, kRtcpTypePayloadFeedback, 0,
+                      sender_ssrc, media_ssrc, packet);
+  return packet;
+}
+
+std::vector<uint8_t> SerializeRemb(uint32_t sender_ssrc,
+                                   uint64_t bitrate_bps,
+                                   const std::vector<uint32_t>& media_ssrcs) {
+  uint8_t exponent = 0;
+  uint64_t mantissa = bitrate_bps;
+  while (mantissa > kRembMantissaMax) {
+    mantissa >>= 1U;
+    ++exponent;
+  }
+
+  const size_t ssrc_count = std::min<size_t>(media_ssrcs.size(), 255);
+  std::vector<uint8_t> packet;
+  packet.reserve(kRtcpFeedbackHeaderSize + kRembFixedSize + ssrc_count * 4);
+  WriteFeedbackHeader(kRtcpFormatApplication, kRtcpTypePayloadFeedback,
+                      kRembFixedSize + ssrc_count * 4, sender_ssrc, 0, packet);
+  packet.insert(packet.end(), std::begin(kRembIdentifier),
+                std::end(kRembIdentifier));
+  packet.push_back(static_cast<uint8_t>(ssrc_count));
+  packet.push_back(static_cast<uint8_t>((exponent << 2U) | (mantissa >> 16U)));
+  WriteUint16BE(static_cast<uint16_t>(mantissa), packet);
+  for (size_t i = 0; i < ssrc_count; ++i) {
+    WriteUint32BE(media_ssrcs[i], packet);
+  }
+  return packet;
+}
+
+std::vector<RtcpFeedback> ParseRtcpFeedback(const uint8_t* data,
+                                            size_t length) {
+  std::vector<RtcpFeedback> result;
+  size_t offset = 0;
+  while (IsRtcpPacket(data + offset, length - offset)) {
+    const uint8_t* packet = data + offset;
+    const size_t packet_size =
+        (static_cast<size_t>(ReadUint16BE(packet + 2)) + 1) * 4;
+    if (packet_size > length - offset) {
+      break;
+    }
+    offset += packet_size;
+
+    const uint8_t format = packet[0] & 0x1FU;
+    const uint8_t packet_type = packet[1];
+    if (packet_size < kRtcpFeedbackHeaderSize) {
+      continue;
+    }
+
+    RtcpFeedback feedback;
+    feedback.sender_ssrc = ReadUint32BE(packet + 4);
+    feedback.media_ssrc = ReadUint32BE(packet + 8);
+    if (packet_type == kRtcpTypeRtpFeedback && format == kRtcpFormatNack) {
+      feedback.type = RtcpFeedback::Type::kNack;
+      for (size_t item = kRtcpFeedbackHeaderSize;
+           item + kNackItemSize <= packet_size; item += kNackItemSize) {
+        const uint16_t pid = ReadUint16BE(packet + item);
+        const uint16_t blp = ReadUint16BE(packet + item + 2);
+        feedback.lost_sequences.push_back(pid);
+        for (uint16_t bit = 0; bit < kNackBitmaskSpan; ++bit) {
+          if (blp & (1U << bit)) {
+            feedback.lost_sequences.push_back(
+                static_cast<uint16_t>(pid + bit + 1));
+          }
+        }
+      }
+      result.push_back(std::move(feedback));
+    } else if (packet_type == kRtcpTypePayloadFeedback &&
+               format == kRtcpFormatPli) {
+      feedback.type = RtcpFeedback::Type::kPli;
+      result.push_back(std::move(feedback));
+    } else if (packet_type == kRtcpTypePayloadFeedback &&
+               format == kRtcpFormatApplication &&
+               packet_size >= kRtcpFeedbackHeaderSize + kRembFixedSize &&
+               std::equal(std::begin(kRembIdentifier),
+                          std::end(kRembIdentifier),
+                          packet + kRtcpFeedbackHeaderSize)) {
+      const uint8_t* fci = packet + kRtcpFeedbackHeaderSize;
+      const size_t ssrc_count = fci[4];
+      const uint8_t exponent = fci[5] >> 2U;
+      const uint64_t mantissa =
+          (static_cast<uint64_t>(fci[5] & 0x03U) << 16U) |
+          ReadUint16BE(fci + 6);
+      feedback.type = RtcpFeedback::Type::kRemb;
+      // 指数最大 63，尾数 18 位，移位结果饱和到 uint64_t
+      feedback.bitrate_bps =
+          exponent > 46 ? UINT64_MAX : (mantissa << exponent);
+      for (size_t i = 0; i < ssrc_count; ++i) {
+        const size_t item = kRtcpFeedbackHeaderSize + kRembFixedSize + i * 4;
+        if (item + 4 > packet_size) {
+          break;
+        }
+        feedback.media_ssrc = ReadUint32BE(packet + item);
+        result.push_back(feedback);
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace rtp
+}  // namespace zenremote
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zenremote {
+namespace rtp {
+
+/**
+ * @brief RTCP 传输层/负载相关反馈（RFC 4585 子集）
+ *
+ * 只实现媒体发送端需要响应的三种：
+ * - Generic NACK（PT=205, FMT=1）：接收端报告丢失的序列号，发送端重传
+ * - PLI（PT=206, FMT=1）：接收端无法继续解码，请求关键帧
+ * - REMB（PT=206, FMT=15，draft-alvestrand-rmcat-remb）：接收端的带宽估计，
+ *   发送端据此选择转发的时间层
+ *
+ * 多字节字段为大端序（网络序）。与 RTP 共用连接时按 RFC 5761 区分：
+ * 首字节版本位为 2 且第二字节落在 192..223。
+ */
+struct RtcpFeedback {
+  enum class Type {
+    kNack,
+    kPli,
+    kRemb,
+  };
+
+  Type type = Type::kNack;
+  uint32_t sender_ssrc = 0;  ///< 反馈发送方（接收端）的 SSRC
+  uint32_t media_ssrc = 0;   ///< 被反馈的媒体流 SSRC
+  std::vector<uint16_t> lost_sequences;  ///< 仅 kNack
+  uint64_t bitrate_bps = 0;              ///< 仅 kRemb
+};
+
+constexpr uint8_t kRtcpTypeRtpFeedback = 205;
+constexpr uint8_t kRtcpTypePayloadFeedback = 206;
+constexpr uint8_t kRtcpFormatNack = 1;
+constexpr uint8_t kRtcpFormatPli = 1;
+constexpr uint8_t kRtcpFormatApplication = 15;
+/// @brief 公共头(4) + 发送方 SSRC(4) + 媒体 SSRC(4)
+constexpr size_t kRtcpFeedbackHeaderSize = 12;
+
+bool IsRtcpPacket(const uint8_t* data, size_t length);
+
+/**
+ * @brief 序列化 Generic NACK
+ *
+ * 相邻 17 个序列号内的丢包合并为一个 PID + BLP 项；sequences 可以无序。
+ */
+std::vector<uint8_t> SerializeNack(uint32_t sender_ssrc,
+                                   uint32_t media_ssrc,
+                                   const std::vector<uint16_t>& sequences);
+
+std::vector<uint8_t> SerializePli(uint32_t sender_ssrc, uint32_t media_ssrc);
+
+/**
+ * @brief 序列化 REMB
+ *
+ * 码率以 18 位尾数与 6 位指数表示，超出尾数精度的部分向下取整。
+ */
+std::vector<uint8_t> SerializeRemb(uint32_t sender_ssrc,
+                                   uint64_t bitrate_bps,
+                                   const std::vector<uint32_t>& media_ssrcs);
+
+/**
+ * @brief 解析 RTCP（复合）包中的 NACK、PLI 与 REMB
+ *
+ * REMB 的公共头不带媒体 SSRC，其中列出的每个 SSRC 各产生一条反馈
+ * （media_ssrc 为该 SSRC）。其他类型的 RTCP 包被跳过；长度字段不合法时
+ * 停止解析，返回已解析的部分。
+ */
+std::vector<RtcpFeedback> ParseRtcpFeedback(const uint8_t* data,
+                                            size_t length);
+
+}  // namespace rtp
+}  // namespace zenremote
@@ -7,6 +7,7 @@
 #include "network/rtp/rtp_packet.h"
 
 namespace zenremote {
+namespace rtp {
 
 RTPSender::RTPSender(BaseConnection* connection, const Config& config)
     : connection_(connection), config_(config) {}
@@ -53,4 +54,5 @@ Result<void> RTPSender::SendAudioPacket(const uint8_t* data,
   return SendVideoFrame(data, length, timestamp, true);
 }
 
+}  // namespace rtp
 }  // namespace zenremote
@@ -9,8 +9,12 @@ namespace zenremote {
 
 class BaseConnection;
 
+namespace rtp {
+
 /**
- * @brief RTP 发送器
+ * @brief RTP 发送器（媒体轨道使用）
+ *
+ * 与 network/protocol/rtp_sender.h 中握手使用的同名类区分，放在 rtp 命名空间。
  */
 class RTPSender {
  public:
@@ -46,4 +50,5 @@ class RTPSender {
   Stats stats_;
 };
 
+}  // namespace rtp
 }  // namespace zenremote
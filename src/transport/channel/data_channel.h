@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "common/error.h"
@@ -16,10 +17,21 @@ namespace zenremote {
  */
 class DataChannel {
  public:
+  /// @brief 发送优先级：不同级别之间严格优先（参考 RTCPriorityType）
+  enum class Priority : uint8_t {
+    kVeryLow = 0,
+    kLow = 1,
+    kMedium = 2,
+    kHigh = 3,
+  };
+
   struct Config {
     bool ordered = true;
-    int max_retransmits = 3;
-    int max_packet_life_time = 0;
+    int max_retransmits = -1;      ///< -1 = 完全可靠
+    int max_packet_life_time = 0;  ///< 毫秒，0 = 不限
+    int id = -1;  ///< 流 ID，-1 = 按创建顺序自动分配（两端需以相同顺序创建）
+    Priority priority = Priority::kLow;
+    uint16_t weight = 1;  ///< 同优先级通道之间按权重分配带宽
   };
 
   enum class State {
@@ -32,11 +44,25 @@ class DataChannel {
   virtual ~DataChannel() = default;
 
   virtual std::string GetLabel() const = 0;
+  virtual uint16_t GetId() const = 0;
   virtual State GetState() const = 0;
 
   virtual Result<void> Send(const uint8_t* data, size_t length) = 0;
   virtual Result<void> Send(const std::string& text) = 0;
 
+  /**
+   * @brief 发送 header + body 组成的消息，body 只被引用不被复制
+   *
+   * 用于大块数据（如 mmap 映射的文件内容），body 在消息被确认前保持有效。
+   */
+  virtual Result<void> Send(const uint8_t* header,
+                            size_t header_length,
+                            std::shared_ptr<const uint8_t> body,
+                            size_t body_length) = 0;
+
+  /// @brief 已提交但尚未被对端确认的字节数
+  virtual size_t GetBufferedAmount() const = 0;
+
   using OnMessageCallback =
       std::function<void(const uint8_t* data, size_t length)>;
   virtual void SetOnMessageCallback(OnMessageCallback callback) = 0;
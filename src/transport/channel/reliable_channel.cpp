@@ -21,40 +21,103 @@ Result<void> ReliableChannel::Send(const uint8_t* data, size_t length) {
                              "DataChannel not connected");
   }
 
-  return transport_->Send(data, length);
+  return transport_->Send(GetId(), data, length);
 }
 
 Result<void> ReliableChannel::Send(const std::string& text) {
   return Send(reinterpret_cast<const uint8_t*>(text.data()), text.size());
 }
 
+Result<void> ReliableChannel::Send(const uint8_t* header,
+                                   size_t header_length,
+                                   std::shared_ptr<const uint8_t> body,
+                                   size_t body_length) {
+  if (state_ != State::kOpen) {
+    return Result<void>::Err(ErrorCode::kInvalidOperation,
+                             "DataChannel not open");
+  }
+
+  if (!transport_) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "DataChannel not connected");
+  }
+
+  return transport_->Send(GetId(), header, header_length, std::move(body),
+                          body_length);
+}
+
 void ReliableChannel::SetConnection(BaseConnection* connection) {
   if (!connection) {
-    transport_.reset();
-    state_ = State::kClosed;
-    if (on_close_callback_) {
-      on_close_callback_();
-    }
+    Close();
     return;
   }
 
   ReliableTransport::Config transport_config;
-  transport_config.max_retries = config_.max_retransmits;
-  transport_config.ordered = config_.ordered;
+  transport_config.stream_id = GetId();
+  auto transport =
+      std::make_shared<ReliableTransport>(connection, transport_config);
+  transport->SetOnStreamMessageCallback(
+      [this](uint16_t stream_id, const uint8_t* data, size_t length) {
+        if (stream_id == GetId()) {
+          DeliverMessage(data, length);
+        }
+      });
+  Open(std::move(transport));
+}
+
+void ReliableChannel::AttachTransport(
+    std::shared_ptr<ReliableTransport> transport) {
+  if (!transport) {
+    Close();
+    return;
+  }
+  Open(std::move(transport));
+}
 
-  transport_ =
-      std::make_unique<ReliableTransport>(connection, transport_config);
+void ReliableChannel::Open(std::shared_ptr<ReliableTransport> transport) {
+  ReliableTransport::StreamOptions options;
+  options.ordered = config_.ordered;
+  options.max_retransmits = config_.max_retransmits;
+  options.max_packet_life_time_ms = config_.max_packet_life_time;
+  options.priority = static_cast<uint8_t>(config_.priority);
+  options.weight = config_.weight;
+  transport->ConfigureStream(GetId(), options);
 
+  transport_ = std::move(transport);
   state_ = State::kOpen;
   if (on_open_callback_) {
     on_open_callback_();
   }
 }
 
-void ReliableChannel::OnDataReceived(const uint8_t* data, size_t length) {
+void ReliableChannel::Close() {
+  transport_.reset();
+  state_ = State::kClosed;
+  if (on_close_callback_) {
+    on_close_callback_();
+  }
+}
+
+void ReliableChannel::DeliverMessage(const uint8_t* data, size_t length) {
   if (on_message_callback_) {
     on_message_callback_(data, length);
   }
 }
 
+void ReliableChannel::OnDataReceived(const uint8_t* data, size_t length) {
+  if (transport_) {
+    transport_->OnPacketReceived(data, length);
+  }
+}
+
+void ReliableChannel::ProcessTimers() {
+  if (transport_) {
+    transport_->ProcessTimers();
+  }
+}
+
+size_t ReliableChannel::GetBufferedAmount() const {
+  return transport_ ? transport_->GetBufferedAmount(GetId()) : 0;
+}
+
 }  // namespace zenremote
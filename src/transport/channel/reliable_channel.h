@@ -12,6 +12,11 @@ class ReliableTransport;
 
 /**
  * @brief 可靠数据通道实现
+ *
+ * 每个通道对应传输层的一个流（stream ID = Config::id）。
+ * 由 PeerConnection 管理时，所有通道通过 AttachTransport 共享同一个
+ * ReliableTransport，按流 ID 复用连接；单独使用时 SetConnection
+ * 会为通道创建独占的传输层。
  */
 class ReliableChannel : public DataChannel {
  public:
@@ -19,10 +24,18 @@ class ReliableChannel : public DataChannel {
   ~ReliableChannel() override;
 
   std::string GetLabel() const override { return label_; }
+  uint16_t GetId() const override {
+    return static_cast<uint16_t>(config_.id < 0 ? 0 : config_.id);
+  }
   State GetState() const override { return state_; }
+  const Config& GetConfig() const { return config_; }
 
   Result<void> Send(const uint8_t* data, size_t length) override;
   Result<void> Send(const std::string& text) override;
+  Result<void> Send(const uint8_t* header,
+                    size_t header_length,
+                    std::shared_ptr<const uint8_t> body,
+                    size_t body_length) override;
 
   void SetOnMessageCallback(OnMessageCallback callback) override {
     on_message_callback_ = std::move(callback);
@@ -37,9 +50,25 @@ class ReliableChannel : public DataChannel {
   }
 
   void SetConnection(BaseConnection* connection) override;
+
+  /// @brief 绑定到共享传输层的本通道流上，传入 nullptr 关闭通道
+  void AttachTransport(std::shared_ptr<ReliableTransport> transport);
+
+  /// @brief 共享传输层收到本通道流的消息时由所有者调用
+  void DeliverMessage(const uint8_t* data, size_t length);
+
+  /// @brief 收到本通道的传输层报文（DATA / SACK / FORWARD-TSN）
   void OnDataReceived(const uint8_t* data, size_t length);
 
+  /// @brief 驱动重传与延迟 ACK 定时器，需周期性调用
+  void ProcessTimers();
+
+  size_t GetBufferedAmount() const override;
+
  private:
+  void Open(std::shared_ptr<ReliableTransport> transport);
+  void Close();
+
   std::string label_;
   Config config_;
   State state_ = State::kConnecting;
@@ -48,7 +77,7 @@ class ReliableChannel : public DataChannel {
   OnOpenCallback on_open_callback_;
   OnCloseCallback on_close_callback_;
 
-  std::unique_ptr<ReliableTransport> transport_;
+  std::shared_ptr<ReliableTransport> transport_;
 };
 
 }  // namespace zenremote
\ No newline at end of file
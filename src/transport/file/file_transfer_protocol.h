@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "network/protocol/protocol.h"
+
+namespace zenremote {
+
+/**
+ * @brief 文件传输消息格式（承载于 DataChannel，每条消息首字节为类型）
+ *
+ * 拉取模式：发送端 OFFER 后由接收端按窗口发出 REQUEST，发送端只发送被请求的块。
+ * 接收端据此控制流量，并在续传时只请求缺失的块。多字节字段均为小端序。
+ */
+enum class FileTransferMessageType : uint8_t {
+  kOffer = 1,
+  kRequest = 2,
+  kChunk = 3,
+  kComplete = 4,
+  kCancel = 5,
+};
+
+// type(1) transfer_id(4) file_size(8) chunk_size(4) fingerprint(8) name_len(2)
+constexpr size_t kFileOfferHeaderSize = 27;
+// type(1) transfer_id(4) count(2) + count * chunk_index(4)
+constexpr size_t kFileRequestHeaderSize = 7;
+constexpr size_t kMaxChunksPerRequest = 1024;
+// type(1) transfer_id(4) chunk_index(4) crc32c(4)，块数据紧随其后
+constexpr size_t kFileChunkHeaderSize = 13;
+// type(1) transfer_id(4)
+constexpr size_t kFileCompleteSize = 5;
+// type(1) flags(1) transfer_id(4) error_code(4) reason_len(2)
+constexpr size_t kFileCancelHeaderSize = 12;
+constexpr uint8_t kFileCancelFlagFromSender = 0x01;
+
+/**
+ * @brief 发送端提议传输一个文件
+ *
+ * fingerprint 由文件名、大小与修改时间计算，接收端据此判断能否续传。
+ */
+struct FileOffer {
+  uint32_t transfer_id = 0;
+  uint64_t file_size = 0;
+  uint32_t chunk_size = 0;
+  uint64_t fingerprint = 0;
+  std::string name;
+};
+
+struct FileChunkRequest {
+  uint32_t transfer_id = 0;
+  std::vector<uint32_t> chunk_indices;
+};
+
+struct FileChunkHeader {
+  uint32_t transfer_id = 0;
+  uint32_t chunk_index = 0;
+  uint32_t crc32c = 0;
+};
+
+/**
+ * @brief 取消传输
+ *
+ * 传输 ID 由发送端分配，两端各自的发送方向使用独立的 ID 空间，
+ * from_sender 指明取消方是否为该传输的发送端。
+ */
+struct FileCancel {
+  bool from_sender = false;
+  uint32_t transfer_id = 0;
+  uint32_t error_code = 0;
+  std::string reason;
+};
+
+inline std::optional<FileTransferMessageType> PeekFileTransferMessageType(
+    const uint8_t* data,
+    size_t length) {
+  if (!data || length == 0 ||
+      data[0] < static_cast<uint8_t>(FileTransferMessageType::kOffer) ||
+      data[0] > static_cast<uint8_t>(FileTransferMessageType::kCancel)) {
+    return std::nullopt;
+  }
+  return static_cast<FileTransferMessageType>(data[0]);
+}
+
+inline std::vector<uint8_t> SerializeFileOffer(const FileOffer& offer) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFileOfferHeaderSize + offer.name.size());
+  buffer.push_back(static_cast<uint8_t>(FileTransferMessageType::kOffer));
+  WriteUint32LE(offer.transfer_id, buffer);
+  WriteUint64LE(offer.file_size, buffer);
+  WriteUint32LE(offer.chunk_size, buffer);
+  WriteUint64LE(offer.fingerprint, buffer);
+  WriteUint16LE(static_cast<uint16_t>(offer.name.size()), buffer);
+  buffer.insert(buffer.end(), offer.name.begin(), offer.name.end());
+  return buffer;
+}
+
+inline std::optional<FileOffer> ParseFileOffer(const uint8_t* data,
+                                               size_t length) {
+  if (!data || length < kFileOfferHeaderSize ||
+      data[0] != static_cast<uint8_t>(FileTransferMessageType::kOffer)) {
+    return std::nullopt;
+  }
+  FileOffer offer;
+  offer.transfer_id = ReadUint32LE(data + 1);
+  offer.file_size = ReadUint64LE(data + 5);
+  offer.chunk_size = ReadUint32LE(data + 13);
+  offer.fingerprint = ReadUint64LE(data + 17);
+  const size_t name_length = ReadUint16LE(data + 25);
+  if (offer.chunk_size == 0 || length < kFileOfferHeaderSize + name_length) {
+    return std::nullopt;
+  }
+  offer.name.assign(reinterpret_cast<const char*>(data) + kFileOfferHeaderSize,
+                    name_length);
+  return offer;
+}
+
+inline std::vector<uint8_t> SerializeFileChunkRequest(
+    const FileChunkRequest& request) {
+  const size_t count = request.chunk_indices.size() < kMaxChunksPerRequest
+                           ? request.chunk_indices.size()
+                           : kMaxChunksPerRequest;
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFileRequestHeaderSize + count * 4);
+  buffer.push_back(static_cast<uint8_t>(FileTransferMessageType::kRequest));
+  WriteUint32LE(request.transfer_id, buffer);
+  WriteUint16LE(static_cast<uint16_t>(count), buffer);
+  for (size_t i = 0; i < count; ++i) {
+    WriteUint32LE(request.chunk_indices[i], buffer);
+  }
+  return buffer;
+}
+
+inline std::optional<FileChunkRequest> ParseFileChunkRequest(
+    const uint8_t* data,
+    size_t length) {
+  if (!data || length < kFileRequestHeaderSize ||
+      data[0] != static_cast<uint8_t>(FileTransferMessageType::kRequest)) {
+    return std::nullopt;
+  }
+  const size_t count = ReadUint16LE(data + 5);
+  if (count > kMaxChunksPerRequest ||
+      length < kFileRequestHeaderSize + count * 4) {
+    return std::nullopt;
+  }
+  FileChunkRequest request;
+  request.transfer_id = ReadUint32LE(data + 1);
+  request.chunk_indices.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    request.chunk_indices[i] =
+        ReadUint32LE(data + kFileRequestHeaderSize + i * 4);
+  }
+  return request;
+}
+
+// 只序列化块头部，块数据由调用方作为独立的 body 发送（避免复制）
+inline std::vector<uint8_t> SerializeFileChunkHeader(
+    const FileChunkHeader& header) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFileChunkHeaderSize);
+  buffer.push_back(static_cast<uint8_t>(FileTransferMessageType::kChunk));
+  WriteUint32LE(header.transfer_id, buffer);
+  WriteUint32LE(header.chunk_index, buffer);
+  WriteUint32LE(header.crc32c, buffer);
+  return buffer;
+}
+
+inline std::optional<FileChunkHeader> ParseFileChunkHeader(const uint8_t* data,
+                                                           size_t length) {
+  if (!data || length < kFileChunkHeaderSize ||
+      data[0] != static_cast<uint8_t>(FileTransferMessageType::kChunk)) {
+    return std::nullopt;
+  }
+  FileChunkHeader header;
+  header.transfer_id = ReadUint32LE(data + 1);
+  header.chunk_index = ReadUint32LE(data + 5);
+  header.crc32c = ReadUint32LE(data + 9);
+  return header;
+}
+
+inline std::vector<uint8_t> SerializeFileComplete(uint32_t transfer_id) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFileCompleteSize);
+  buffer.push_back(static_cast<uint8_t>(FileTransferMessageType::kComplete));
+  WriteUint32LE(transfer_id, buffer);
+  return buffer;
+}
+
+inline std::optional<uint32_t> ParseFileComplete(const uint8_t* data,
+                                                 size_t length) {
+  if (!data || length < kFileCompleteSize ||
+      data[0] != static_cast<uint8_t>(FileTransferMessageType::kComplete)) {
+    return std::nullopt;
+  }
+  return ReadUint32LE(data + 1);
+}
+
+inline std::vector<uint8_t> SerializeFileCancel(const FileCancel& cancel) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kFileCancelHeaderSize + cancel.reason.size());
+  buffer.push_back(static_cast<uint8_t>(FileTransferMessageType::kCancel));
+  buffer.push_back(cancel.from_sender ? kFileCancelFlagFromSender : 0);
+  WriteUint32LE(cancel.transfer_id, buffer);
+  WriteUint32LE(cancel.error_code, buffer);
+  WriteUint16LE(static_cast<uint16_t>(cancel.reason.size()), buffer);
+  buffer.insert(buffer.end(), cancel.reason.begin(), cancel.reason.end());
+  return buffer;
+}
+
+inline std::optional<FileCancel> ParseFileCancel(const uint8_t* data,
+                                                 size_t length) {
+  if (!data || length < kFileCancelHeaderSize ||
+      data[0] != static_cast<uint8_t>(FileTransferMessageType::kCancel)) {
+    return std::nullopt;
+  }
+  FileCancel cancel;
+  cancel.from_sender = (data[1] & kFileCancelFlagFromSender) != 0;
+  cancel.transfer_id = ReadUint32LE(data + 2);
+  cancel.error_code = ReadUint32LE(data + 6);
+  const size_t reason_length = ReadUint16LE(data + 10);
+  if (length < kFileCancelHeaderSize + reason_length) {
+    return std::nullopt;
+  }
+  cancel.reason.assign(
+      reinterpret_cast<const char*>(data) + kFileCancelHeaderSize,
+      reason_length);
+  return cancel;
+}
+
+}  // namespace zenremote
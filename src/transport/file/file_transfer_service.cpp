@@ -0,0 +1,787 @@
+#include "file_transfer_service.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "common/crc32c.h"
+#include "common/log_manager.h"
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint32_t kResumeStateMagic = 0x53465A52U;  // "RZFS"
+constexpr uint32_t kResumeStateVersion = 1;
+// magic(4) version(4) fingerprint(8) file_size(8) chunk_size(4) chunk_count(4)
+constexpr size_t kResumeStateHeaderSize = 32;
+
+uint64_t Fnv1a64(const uint8_t* data, size_t length, uint64_t hash) {
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= data[i];
+    hash *= 0x100000001B3ULL;
+  }
+  return hash;
+}
+
+// 文件名 + 大小 + 修改时间，源文件变化后不会误续传
+uint64_t ComputeFingerprint(const std::string& name,
+                            uint64_t size,
+                            const std::filesystem::path& path) {
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  hash = Fnv1a64(reinterpret_cast<const uint8_t*>(name.data()), name.size(),
+                 hash);
+  hash = Fnv1a64(reinterpret_cast<const uint8_t*>(&size), sizeof(size), hash);
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  if (!ec) {
+    const int64_t ticks = mtime.time_since_epoch().count();
+    hash = Fnv1a64(reinterpret_cast<const uint8_t*>(&ticks), sizeof(ticks),
+                   hash);
+  }
+  return hash;
+}
+
+// 只保留文件名部分，防止对端通过路径写到下载目录之外
+std::string SanitizeFileName(const std::string& name) {
+  auto file_name = std::filesystem::path(name).filename().string();
+  if (file_name.empty() || file_name == "." || file_name == "..") {
+    return std::string();
+  }
+  return file_name;
+}
+
+// 目标已存在时依次尝试 "name (1).ext"、"name (2).ext"……，不覆盖已有文件
+std::filesystem::path MakeUniquePath(const std::filesystem::path& path) {
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) {
+    return path;
+  }
+  const auto stem = path.stem().string();
+  const auto extension = path.extension().string();
+  for (int suffix = 1;; ++suffix) {
+    auto candidate = path.parent_path() /
+                     (stem + " (" + std::to_string(suffix) + ")" + extension);
+    if (!std::filesystem::exists(candidate, ec)) {
+      return candidate;
+    }
+  }
+}
+
+}  // namespace
+
+FileTransferService::FileTransferService(std::shared_ptr<DataChannel> channel,
+                                         const Config& config)
+    : channel_(std::move(channel)), config_(config) {
+  config_.chunk_size = std::max<uint32_t>(config_.chunk_size, 1);
+  // 一个窗口的请求放进一条 FileChunkRequest，超出的索引会在序列化时被截掉
+  config_.window_chunks =
+      std::clamp<size_t>(config_.window_chunks, 1, kMaxChunksPerRequest);
+  config_.state_flush_interval =
+      std::max<size_t>(config_.state_flush_interval, 1);
+  channel_->SetOnMessageCallback([this](const uint8_t* data, size_t length) {
+    OnMessage(data, length);
+  });
+}
+
+FileTransferService::~FileTransferService() {
+  channel_->SetOnMessageCallback(nullptr);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& [transfer_id, transfer] : incoming_) {
+    SaveResumeState(transfer);
+  }
+}
+
+Result<uint32_t> FileTransferService::SendFile(const std::string& path,
+                                               const std::string& name) {
+  auto file = std::make_shared<MappedFile>();
+  auto open_result = file->Open(path);
+  if (open_result.IsErr()) {
+    return Result<uint32_t>::Err(open_result.Code(), open_result.Message());
+  }
+
+  const std::string remote_name = SanitizeFileName(
+      name.empty() ? std::filesystem::path(path).filename().string() : name);
+  if (remote_name.empty()) {
+    return Result<uint32_t>::Err(ErrorCode::kInvalidParameter,
+                                 "Invalid file name: " + name);
+  }
+  const uint64_t chunk_count =
+      (file->GetSize() + config_.chunk_size - 1) / config_.chunk_size;
+  if (chunk_count > 0xFFFFFFFFULL) {
+    return Result<uint32_t>::Err(ErrorCode::kInvalidParameter,
+                                 "File too large for chunk size");
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint32_t transfer_id = next_transfer_id_++;
+
+  FileOffer offer;
+  offer.transfer_id = transfer_id;
+  offer.file_size = file->GetSize();
+  offer.chunk_size = config_.chunk_size;
+  offer.fingerprint = ComputeFingerprint(remote_name, offer.file_size, path);
+  offer.name = remote_name;
+  auto message = SerializeFileOffer(offer);
+  auto send_result = channel_->Send(message.data(), message.size());
+  if (send_result.IsErr()) {
+    return Result<uint32_t>::Err(send_result.Code(),
+                                 "Failed to send offer: " +
+                                     send_result.Message());
+  }
+
+  OutgoingTransfer& transfer = outgoing_[transfer_id];
+  transfer.info.transfer_id = transfer_id;
+  transfer.info.direction = Direction::kSend;
+  transfer.info.name = remote_name;
+  transfer.info.path = path;
+  transfer.info.file_size = offer.file_size;
+  transfer.file = std::move(file);
+  transfer.chunk_size = config_.chunk_size;
+  transfer.chunk_count = static_cast<uint32_t>(chunk_count);
+
+  ZENREMOTE_INFO("File offer sent: id={}, name={}, size={}", transfer_id,
+                 remote_name, offer.file_size);
+  return Result<uint32_t>::Ok(transfer_id);
+}
+
+Result<void> FileTransferService::CancelTransfer(uint32_t transfer_id,
+                                                 Direction direction) {
+  NotificationList events;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (direction == Direction::kReceive) {
+      if (incoming_.count(transfer_id) == 0) {
+        return Result<void>::Err(ErrorCode::kInvalidParameter,
+                                 "Unknown transfer");
+      }
+      FailIncoming(transfer_id, ErrorCode::kInvalidOperation,
+                   "Cancelled by receiver", true, events);
+    } else {
+      auto it = outgoing_.find(transfer_id);
+      if (it == outgoing_.end()) {
+        return Result<void>::Err(ErrorCode::kInvalidParameter,
+                                 "Unknown transfer");
+      }
+      FileCancel cancel;
+      cancel.from_sender = true;
+      cancel.transfer_id = transfer_id;
+      cancel.error_code = static_cast<uint32_t>(ErrorCode::kInvalidOperation);
+      cancel.reason = "Cancelled by sender";
+      SendControl(SerializeFileCancel(cancel));
+      events.push_back({it->second.info, true, ErrorCode::kInvalidOperation,
+                        cancel.reason});
+      outgoing_.erase(it);
+    }
+  }
+  Notify(events);
+  return Result<void>::Ok();
+}
+
+void FileTransferService::Process() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FlushControl();
+  for (auto& [transfer_id, transfer] : outgoing_) {
+    FlushPendingChunks(transfer);
+  }
+}
+
+void FileTransferService::OnMessage(const uint8_t* data, size_t length) {
+  auto type = PeekFileTransferMessageType(data, length);
+  if (!type.has_value()) {
+    ZENREMOTE_WARN("Unknown file transfer message");
+    return;
+  }
+
+  NotificationList events;
+  std::optional<TransferInfo> offered;
+  OnOfferCallback on_offer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FlushControl();
+
+    switch (type.value()) {
+      case FileTransferMessageType::kOffer: {
+        auto offer = ParseFileOffer(data, length);
+        if (offer.has_value()) {
+          offered = OnOffer(offer.value());
+          on_offer = on_offer_callback_;
+        }
+        break;
+      }
+
+      case FileTransferMessageType::kRequest: {
+        auto request = ParseFileChunkRequest(data, length);
+        if (request.has_value()) {
+          OnRequest(request.value(), events);
+        }
+        break;
+      }
+
+      case FileTransferMessageType::kChunk: {
+        auto header = ParseFileChunkHeader(data, length);
+        if (header.has_value()) {
+          OnChunk(header.value(), data + kFileChunkHeaderSize,
+                  length - kFileChunkHeaderSize, events);
+        }
+        break;
+      }
+
+      case FileTransferMessageType::kComplete: {
+        auto transfer_id = ParseFileComplete(data, length);
+        if (transfer_id.has_value()) {
+          OnComplete(transfer_id.value(), events);
+        }
+        break;
+      }
+
+      case FileTransferMessageType::kCancel: {
+        auto cancel = ParseFileCancel(data, length);
+        if (cancel.has_value()) {
+          OnCancel(cancel.value(), events);
+        }
+        break;
+      }
+    }
+  }
+
+  // 是否接收由上层决定（可能弹窗询问或按策略判断），回调不能持锁
+  if (offered.has_value()) {
+    const bool accepted = on_offer && on_offer(offered.value());
+    std::lock_guard<std::mutex> lock(mutex_);
+    ResolveOffer(offered->transfer_id, accepted, events);
+  }
+  Notify(events);
+}
+
+void FileTransferService::SetOnOfferCallback(OnOfferCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_offer_callback_ = std::move(callback);
+}
+
+void FileTransferService::SetOnProgressCallback(OnProgressCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_progress_callback_ = std::move(callback);
+}
+
+void FileTransferService::SetOnCompleteCallback(OnCompleteCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_complete_callback_ = std::move(callback);
+}
+
+FileTransferService::Stats FileTransferService::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+// ============================================================================
+// 发送端
+// ============================================================================
+
+void FileTransferService::OnRequest(const FileChunkRequest& request,
+                                    NotificationList& events) {
+  auto it = outgoing_.find(request.transfer_id);
+  if (it == outgoing_.end()) {
+    return;
+  }
+  OutgoingTransfer& transfer = it->second;
+  for (uint32_t chunk_index : request.chunk_indices) {
+    if (chunk_index < transfer.chunk_count) {
+      transfer.pending_chunks.push_back(chunk_index);
+    }
+  }
+  const uint64_t before = transfer.info.bytes_transferred;
+  FlushPendingChunks(transfer);
+  if (transfer.info.bytes_transferred != before) {
+    events.push_back({transfer.info, false, ErrorCode::kSuccess, {}});
+  }
+}
+
+void FileTransferService::OnComplete(uint32_t transfer_id,
+                                     NotificationList& events) {
+  auto it = outgoing_.find(transfer_id);
+  if (it == outgoing_.end()) {
+    return;
+  }
+  ZENREMOTE_INFO("File sent: id={}, name={}, {} bytes this session",
+                 transfer_id, it->second.info.name,
+                 it->second.info.bytes_transferred);
+  events.push_back({it->second.info, true, ErrorCode::kSuccess, {}});
+  outgoing_.erase(it);
+}
+
+void FileTransferService::OnCancel(const FileCancel& cancel,
+                                   NotificationList& events) {
+  const auto error = static_cast<ErrorCode>(cancel.error_code);
+  if (cancel.from_sender) {
+    pending_offers_.erase(cancel.transfer_id);
+    if (incoming_.count(cancel.transfer_id) > 0) {
+      FailIncoming(cancel.transfer_id, error, cancel.reason, false, events);
+    }
+    return;
+  }
+
+  auto it = outgoing_.find(cancel.transfer_id);
+  if (it == outgoing_.end()) {
+    return;
+  }
+  ZENREMOTE_WARN("File transfer {} cancelled by peer: {}", cancel.transfer_id,
+                 cancel.reason);
+  events.push_back({it->second.info, true, error, cancel.reason});
+  outgoing_.erase(it);
+}
+
+void FileTransferService::FlushPendingChunks(OutgoingTransfer& transfer) {
+  while (!transfer.pending_chunks.empty()) {
+    if (!SendChunk(transfer, transfer.pending_chunks.front())) {
+      break;
+    }
+    transfer.pending_chunks.pop_front();
+  }
+}
+
+bool FileTransferService::SendChunk(OutgoingTransfer& transfer,
+                                    uint32_t chunk_index) {
+  const uint64_t offset =
+      static_cast<uint64_t>(chunk_index) * transfer.chunk_size;
+  const size_t length = static_cast<size_t>(
+      std::min<uint64_t>(transfer.chunk_size, transfer.info.file_size - offset));
+  const uint8_t* data = transfer.file->GetData() + offset;
+
+  FileChunkHeader header;
+  header.transfer_id = transfer.info.transfer_id;
+  header.chunk_index = chunk_index;
+  header.crc32c = Crc32c(data, length);
+  auto header_bytes = SerializeFileChunkHeader(header);
+
+  // 别名构造：body 指向映射区，同时持有 MappedFile 保证映射在发送期间有效
+  std::shared_ptr<const uint8_t> body(transfer.file, data);
+  auto result = channel_->Send(header_bytes.data(), header_bytes.size(),
+                               std::move(body), length);
+  if (result.IsErr()) {
+    if (result.Code() != ErrorCode::kChannelFull) {
+      ZENREMOTE_WARN("Failed to send chunk {} of transfer {}: {}",
+                     chunk_index, transfer.info.transfer_id, result.Message());
+    }
+    stats_.send_deferred++;
+    return false;
+  }
+
+  transfer.info.bytes_transferred += length;
+  stats_.chunks_sent++;
+  stats_.bytes_sent += length;
+  return true;
+}
+
+// ============================================================================
+// 接收端
+// ============================================================================
+
+std::optional<FileTransferService::TransferInfo> FileTransferService::OnOffer(
+    const FileOffer& offer) {
+  if (incoming_.count(offer.transfer_id) > 0 ||
+      pending_offers_.count(offer.transfer_id) > 0) {
+    return std::nullopt;
+  }
+
+  const std::string name = SanitizeFileName(offer.name);
+  const uint64_t chunk_count =
+      (offer.file_size + offer.chunk_size - 1) / offer.chunk_size;
+  if (name.empty() || chunk_count > 0xFFFFFFFFULL) {
+    FileCancel cancel;
+    cancel.transfer_id = offer.transfer_id;
+    cancel.error_code = static_cast<uint32_t>(ErrorCode::kInvalidParameter);
+    cancel.reason = "Invalid offer";
+    SendControl(SerializeFileCancel(cancel));
+    return std::nullopt;
+  }
+
+  pending_offers_[offer.transfer_id] = offer;
+  TransferInfo info;
+  info.transfer_id = offer.transfer_id;
+  info.direction = Direction::kReceive;
+  info.name = name;
+  info.path =
+      (std::filesystem::path(config_.download_directory) / name).string();
+  info.file_size = offer.file_size;
+  return info;
+}
+
+void FileTransferService::ResolveOffer(uint32_t transfer_id,
+                                       bool accepted,
+                                       NotificationList& events) {
+  auto it = pending_offers_.find(transfer_id);
+  if (it == pending_offers_.end()) {
+    return;  // 回调期间发送端已取消
+  }
+  const FileOffer offer = it->second;
+  pending_offers_.erase(it);
+
+  if (!accepted) {
+    ZENREMOTE_INFO("File offer rejected: id={}, name={}", transfer_id,
+                   offer.name);
+    FileCancel cancel;
+    cancel.transfer_id = transfer_id;
+    cancel.error_code = static_cast<uint32_t>(ErrorCode::kPermissionDenied);
+    cancel.reason = "Rejected by receiver";
+    SendControl(SerializeFileCancel(cancel));
+    return;
+  }
+  AcceptOffer(offer, events);
+}
+
+void FileTransferService::AcceptOffer(const FileOffer& offer,
+                                      NotificationList& events) {
+  const std::string name = SanitizeFileName(offer.name);
+  IncomingTransfer& transfer = incoming_[offer.transfer_id];
+  transfer.offer = offer;
+  transfer.chunk_count = static_cast<uint32_t>(
+      (offer.file_size + offer.chunk_size - 1) / offer.chunk_size);
+  transfer.info.transfer_id = offer.transfer_id;
+  transfer.info.direction = Direction::kReceive;
+  transfer.info.name = name;
+  transfer.info.path =
+      (std::filesystem::path(config_.download_directory) / name).string();
+  transfer.info.file_size = offer.file_size;
+  transfer.part_path = MakePartPath(name, offer);
+  transfer.state_path = transfer.part_path + ".state";
+
+  auto result = OpenIncoming(transfer);
+  if (result.IsErr()) {
+    FailIncoming(offer.transfer_id, result.Code(), result.Message(), true,
+                 events);
+    return;
+  }
+
+  ZENREMOTE_INFO("Receiving file: id={}, name={}, size={}, resumed={}",
+                 offer.transfer_id, name, offer.file_size,
+                 transfer.info.bytes_resumed);
+  if (transfer.completed_count == transfer.chunk_count) {
+    FinishIncoming(transfer, events);
+    return;
+  }
+  RequestMoreChunks(transfer);
+}
+
+std::string FileTransferService::MakePartPath(const std::string& name,
+                                              const FileOffer& offer) const {
+  // 按 fingerprint 命名：重连后传输 ID 会重新分配，fingerprint 不变，仍可续传
+  const auto directory = std::filesystem::path(config_.download_directory);
+  const std::string stem =
+      fmt::format("{}.{:016x}", name, offer.fingerprint);
+  std::string part_path = (directory / (stem + ".part")).string();
+
+  // 同一文件被并发提议两次时，后者附加传输 ID，避免共用同一个 .part
+  const bool in_use = std::any_of(
+      incoming_.begin(), incoming_.end(), [&](const auto& entry) {
+        return entry.first != offer.transfer_id &&
+               entry.second.part_path == part_path;
+      });
+  if (in_use) {
+    part_path =
+        (directory / fmt::format("{}-{}.part", stem, offer.transfer_id))
+            .string();
+  }
+  return part_path;
+}
+
+void FileTransferService::OnChunk(const FileChunkHeader& header,
+                                  const uint8_t* payload,
+                                  size_t length,
+                                  NotificationList& events) {
+  auto it = incoming_.find(header.transfer_id);
+  if (it == incoming_.end()) {
+    return;
+  }
+  IncomingTransfer& transfer = it->second;
+  const uint32_t index = header.chunk_index;
+  if (index >= transfer.chunk_count || !transfer.requested[index]) {
+    return;
+  }
+  transfer.requested[index] = 0;
+  transfer.outstanding--;
+  if (transfer.completed[index]) {
+    return;
+  }
+
+  const uint64_t offset =
+      static_cast<uint64_t>(index) * transfer.offer.chunk_size;
+  const size_t expected = static_cast<size_t>(std::min<uint64_t>(
+      transfer.offer.chunk_size, transfer.offer.file_size - offset));
+  if (length != expected || Crc32c(payload, length) != header.crc32c) {
+    stats_.checksum_failures++;
+    if (++transfer.retries[index] > config_.max_chunk_retries) {
+      FailIncoming(header.transfer_id, ErrorCode::kProtocolError,
+                   "Chunk checksum mismatch", true, events);
+      return;
+    }
+    ZENREMOTE_WARN("Chunk {} of transfer {} failed checksum, re-requesting",
+                   index, header.transfer_id);
+    transfer.next_scan_index = std::min(transfer.next_scan_index, index);
+    RequestMoreChunks(transfer);
+    return;
+  }
+
+  auto write_result = transfer.file.WriteAt(offset, payload, length);
+  if (write_result.IsErr()) {
+    FailIncoming(header.transfer_id, write_result.Code(),
+                 write_result.Message(), true, events);
+    return;
+  }
+
+  transfer.completed[index] = 1;
+  transfer.checksums[index] = header.crc32c;
+  transfer.completed_count++;
+  transfer.info.bytes_transferred += length;
+  stats_.chunks_received++;
+  stats_.bytes_received += length;
+  if (++transfer.chunks_since_flush >= config_.state_flush_interval) {
+    SaveResumeState(transfer);
+  }
+
+  if (transfer.completed_count == transfer.chunk_count) {
+    FinishIncoming(transfer, events);
+    return;
+  }
+  events.push_back({transfer.info, false, ErrorCode::kSuccess, {}});
+  RequestMoreChunks(transfer);
+}
+
+Result<void> FileTransferService::OpenIncoming(IncomingTransfer& transfer) {
+  std::error_code ec;
+  std::filesystem::create_directories(config_.download_directory, ec);
+
+  transfer.completed.assign(transfer.chunk_count, 0);
+  transfer.checksums.assign(transfer.chunk_count, 0);
+  transfer.requested.assign(transfer.chunk_count, 0);
+
+  if (LoadResumeState(transfer)) {
+    return Result<void>::Ok();
+  }
+
+  auto result = transfer.file.Open(transfer.part_path);
+  if (result.IsErr()) {
+    return result;
+  }
+  return transfer.file.Preallocate(transfer.offer.file_size);
+}
+
+bool FileTransferService::LoadResumeState(IncomingTransfer& transfer) {
+  std::ifstream in(transfer.state_path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::vector<uint8_t> state((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+  const size_t count = transfer.chunk_count;
+  if (state.size() != kResumeStateHeaderSize + count * 5 ||
+      ReadUint32LE(state.data()) != kResumeStateMagic ||
+      ReadUint32LE(state.data() + 4) != kResumeStateVersion ||
+      ReadUint64LE(state.data() + 8) != transfer.offer.fingerprint ||
+      ReadUint64LE(state.data() + 16) != transfer.offer.file_size ||
+      ReadUint32LE(state.data() + 24) != transfer.offer.chunk_size ||
+      ReadUint32LE(state.data() + 28) != transfer.chunk_count) {
+    ZENREMOTE_INFO("Resume state of {} does not match offer, restarting",
+                   transfer.info.name);
+    return false;
+  }
+
+  if (transfer.file.Open(transfer.part_path).IsErr()) {
+    return false;
+  }
+  auto size = transfer.file.GetSize();
+  if (size.IsErr() || size.Value() != transfer.offer.file_size) {
+    transfer.file.Close();
+    return false;
+  }
+
+  // 状态文件可能先于数据落盘，逐块回读校验
+  const uint8_t* completed = state.data() + kResumeStateHeaderSize;
+  const uint8_t* checksums = completed + count;
+  std::vector<uint8_t> buffer(transfer.offer.chunk_size);
+  for (uint32_t index = 0; index < count; ++index) {
+    if (!completed[index]) {
+      continue;
+    }
+    const uint64_t offset =
+        static_cast<uint64_t>(index) * transfer.offer.chunk_size;
+    const size_t length = static_cast<size_t>(std::min<uint64_t>(
+        transfer.offer.chunk_size, transfer.offer.file_size - offset));
+    const uint32_t crc = ReadUint32LE(checksums + index * 4);
+    auto read = transfer.file.ReadAt(offset, buffer.data(), length);
+    if (read.IsErr() || read.Value() != length ||
+        Crc32c(buffer.data(), length) != crc) {
+      continue;
+    }
+    transfer.completed[index] = 1;
+    transfer.checksums[index] = crc;
+    transfer.completed_count++;
+    transfer.info.bytes_resumed += length;
+  }
+  stats_.bytes_resumed += transfer.info.bytes_resumed;
+  return true;
+}
+
+void FileTransferService::SaveResumeState(const IncomingTransfer& transfer) {
+  std::vector<uint8_t> state;
+  state.reserve(kResumeStateHeaderSize + transfer.chunk_count * 5);
+  WriteUint32LE(kResumeStateMagic, state);
+  WriteUint32LE(kResumeStateVersion, state);
+  WriteUint64LE(transfer.offer.fingerprint, state);
+  WriteUint64LE(transfer.offer.file_size, state);
+  WriteUint32LE(transfer.offer.chunk_size, state);
+  WriteUint32LE(transfer.chunk_count, state);
+  state.insert(state.end(), transfer.completed.begin(),
+               transfer.completed.end());
+  for (uint32_t crc : transfer.checksums) {
+    WriteUint32LE(crc, state);
+  }
+
+  std::ofstream out(transfer.state_path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(state.data()),
+            static_cast<std::streamsize>(state.size()));
+  if (!out) {
+    ZENREMOTE_WARN("Failed to save resume state: {}", transfer.state_path);
+  }
+}
+
+void FileTransferService::RequestMoreChunks(IncomingTransfer& transfer) {
+  FileChunkRequest request;
+  request.transfer_id = transfer.info.transfer_id;
+  uint32_t index = transfer.next_scan_index;
+  while (transfer.outstanding < config_.window_chunks &&
+         index < transfer.chunk_count) {
+    if (!transfer.completed[index] && !transfer.requested[index]) {
+      transfer.requested[index] = 1;
+      transfer.outstanding++;
+      request.chunk_indices.push_back(index);
+    }
+    ++index;
+  }
+  transfer.next_scan_index = index;
+
+  if (!request.chunk_indices.empty()) {
+    SendControl(SerializeFileChunkRequest(request));
+  }
+}
+
+void FileTransferService::FinishIncoming(IncomingTransfer& transfer,
+                                         NotificationList& events) {
+  const uint32_t transfer_id = transfer.info.transfer_id;
+  auto sync_result = transfer.file.Sync();
+  transfer.file.Close();
+  if (sync_result.IsErr()) {
+    FailIncoming(transfer_id, sync_result.Code(), sync_result.Message(), true,
+                 events);
+    return;
+  }
+
+  std::error_code ec;
+  const auto destination = MakeUniquePath(transfer.info.path);
+  std::filesystem::rename(transfer.part_path, destination, ec);
+  if (ec) {
+    FailIncoming(transfer_id, ErrorCode::kIOError,
+                 "Failed to rename " + transfer.part_path + ": " +
+                     ec.message(),
+                 true, events);
+    return;
+  }
+  std::filesystem::remove(transfer.state_path, ec);
+  transfer.info.path = destination.string();
+
+  SendControl(SerializeFileComplete(transfer_id));
+  ZENREMOTE_INFO("File received: id={}, path={}, {} bytes this session",
+                 transfer_id, transfer.info.path,
+                 transfer.info.bytes_transferred);
+  events.push_back({transfer.info, true, ErrorCode::kSuccess, {}});
+  incoming_.erase(transfer_id);
+}
+
+void FileTransferService::FailIncoming(uint32_t transfer_id,
+                                       ErrorCode error,
+                                       const std::string& reason,
+                                       bool notify_peer,
+                                       NotificationList& events) {
+  auto it = incoming_.find(transfer_id);
+  if (it == incoming_.end()) {
+    return;
+  }
+  IncomingTransfer& transfer = it->second;
+  if (transfer.file.IsOpen()) {
+    SaveResumeState(transfer);
+    transfer.file.Close();
+  }
+
+  if (notify_peer) {
+    FileCancel cancel;
+    cancel.transfer_id = transfer_id;
+    cancel.error_code = static_cast<uint32_t>(error);
+    cancel.reason = reason;
+    SendControl(SerializeFileCancel(cancel));
+  }
+
+  ZENREMOTE_WARN("File transfer {} failed: {}", transfer_id, reason);
+  events.push_back({transfer.info, true, error, reason});
+  incoming_.erase(it);
+}
+
+// ============================================================================
+// 公共
+// ============================================================================
+
+void FileTransferService::SendControl(const std::vector<uint8_t>& message) {
+  if (pending_control_.empty()) {
+    auto result = channel_->Send(message.data(), message.size());
+    if (result.IsOk()) {
+      return;
+    }
+    if (result.Code() != ErrorCode::kChannelFull) {
+      ZENREMOTE_WARN("Failed to send file transfer control: {}",
+                     result.Message());
+    }
+  }
+  // 控制消息不能丢失（请求丢失会使传输停滞），缓冲区满时排队重试
+  pending_control_.push_back(message);
+}
+
+void FileTransferService::FlushControl() {
+  while (!pending_control_.empty()) {
+    const auto& message = pending_control_.front();
+    if (channel_->Send(message.data(), message.size()).IsErr()) {
+      return;
+    }
+    pending_control_.pop_front();
+  }
+}
+
+void FileTransferService::Notify(NotificationList& events) {
+  if (events.empty()) {
+    return;
+  }
+  OnProgressCallback on_progress;
+  OnCompleteCallback on_complete;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    on_progress = on_progress_callback_;
+    on_complete = on_complete_callback_;
+  }
+
+  for (const auto& event : events) {
+    if (!event.complete) {
+      if (on_progress) {
+        on_progress(event.info);
+      }
+      continue;
+    }
+    if (on_complete) {
+      if (event.error == ErrorCode::kSuccess) {
+        on_complete(event.info, Result<void>::Ok());
+      } else {
+        on_complete(event.info, Result<void>::Err(event.error, event.message));
+      }
+    }
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+#include "common/file_io.h"
+#include "transport/channel/data_channel.h"
+#include "transport/file/file_transfer_protocol.h"
+
+namespace zenremote {
+
+/**
+ * @brief 文件传输服务（基于 DataChannel 的拉取式分块传输）
+ *
+ * - 发送端：源文件整体 mmap，块数据以 shared_ptr 别名直接引用映射区交给
+ *   传输层，不经用户态缓冲复制
+ * - 接收端：按窗口流水线式请求块（同时最多 window_chunks 个），
+ *   校验 CRC-32C 后 pwrite 到预分配（fallocate）的 .part 文件
+ * - 接收确认：每个 OFFER 先交给 OnOfferCallback 决定是否接收，
+ *   未设置回调时拒绝所有 OFFER
+ * - 续传：.part 文件按 fingerprint 命名（同名的并发传输再附加传输 ID），
+ *   接收端定期把已完成块的位图与校验值写入 .part.state，
+ *   重连后收到同一文件（fingerprint 相同）的 OFFER 时，先逐块校验已写入的数据，
+ *   只请求缺失或校验失败的块
+ * - 完成后重命名为目标文件名；目标已存在时不覆盖，改存为 "name (1).ext" 等
+ *
+ * 同一个服务实例可同时收发多个文件。建议为其单独创建低优先级的数据通道，
+ * 避免大文件占用输入等交互通道的带宽。
+ * 线程安全：SendFile / Process 可与通道回调在不同线程调用；
+ * 进度与完成回调在内部锁之外执行。
+ */
+class FileTransferService {
+ public:
+  struct Config {
+    std::string download_directory = ".";
+    uint32_t chunk_size = 256 * 1024;
+    /// 接收端同时在途的块请求数（1 到 kMaxChunksPerRequest）
+    size_t window_chunks = 16;
+    size_t state_flush_interval = 64;  ///< 每完成多少块保存一次续传状态
+    int max_chunk_retries = 3;         ///< 单块校验失败的最大重试次数
+  };
+
+  enum class Direction {
+    kSend,
+    kReceive,
+  };
+
+  struct TransferInfo {
+    uint32_t transfer_id = 0;
+    Direction direction = Direction::kSend;
+    std::string name;
+    std::string path;  ///< 发送端为源文件，接收端为保存路径（完成时为实际路径）
+    uint64_t file_size = 0;
+    uint64_t bytes_transferred = 0;  ///< 本次会话实际传输的字节数
+    uint64_t bytes_resumed = 0;      ///< 续传时复用的已有字节数
+  };
+
+  struct Stats {
+    uint64_t chunks_sent = 0;
+    uint64_t chunks_received = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    uint64_t bytes_resumed = 0;
+    uint64_t checksum_failures = 0;
+    uint64_t send_deferred = 0;  ///< 因发送缓冲区满推迟的块数
+  };
+
+  /// @brief 收到 OFFER 时调用（锁外），返回 true 接收，false 拒绝
+  using OnOfferCallback = std::function<bool(const TransferInfo& info)>;
+  using OnProgressCallback = std::function<void(const TransferInfo& info)>;
+  using OnCompleteCallback =
+      std::function<void(const TransferInfo& info, const Result<void>& result)>;
+
+  FileTransferService(std::shared_ptr<DataChannel> channel,
+                      const Config& config);
+  ~FileTransferService();
+
+  FileTransferService(const FileTransferService&) = delete;
+  FileTransferService& operator=(const FileTransferService&) = delete;
+
+  /**
+   * @brief 提议发送一个文件
+   * @param name 对端保存的文件名，空则使用源文件名
+   * @return 传输 ID
+   */
+  Result<uint32_t> SendFile(const std::string& path,
+                            const std::string& name = "");
+
+  /**
+   * @brief 取消传输并通知对端；接收端保留 .part 文件以便之后续传
+   * @param direction 传输 ID 按方向独立分配，需指明是发送还是接收
+   */
+  Result<void> CancelTransfer(uint32_t transfer_id, Direction direction);
+
+  /**
+   * @brief 重试因发送缓冲区满而推迟的块
+   *
+   * 收到对端请求时也会自动重试；发送大量文件时建议周期性调用。
+   */
+  void Process();
+
+  /// @brief 处理数据通道收到的消息（构造时已注册为通道回调）
+  void OnMessage(const uint8_t* data, size_t length);
+
+  void SetOnOfferCallback(OnOfferCallback callback);
+  void SetOnProgressCallback(OnProgressCallback callback);
+  void SetOnCompleteCallback(OnCompleteCallback callback);
+
+  Stats GetStats() const;
+
+ private:
+  struct OutgoingTransfer {
+    TransferInfo info;
+    std::shared_ptr<MappedFile> file;
+    uint32_t chunk_size = 0;
+    uint32_t chunk_count = 0;
+    std::deque<uint32_t> pending_chunks;  ///< 已被请求、尚未提交给通道的块
+  };
+
+  struct IncomingTransfer {
+    TransferInfo info;
+    FileOffer offer;
+    std::string part_path;
+    std::string state_path;
+    RandomAccessFile file;
+    uint32_t chunk_count = 0;
+    std::vector<uint8_t> completed;   ///< 每块一个字节：1 = 已校验写入
+    std::vector<uint32_t> checksums;  ///< 已完成块的 CRC-32C
+    std::vector<uint8_t> requested;
+    std::map<uint32_t, int> retries;
+    uint32_t completed_count = 0;
+    uint32_t next_scan_index = 0;  ///< 请求扫描起点，之前的块均已请求或完成
+    size_t outstanding = 0;
+    size_t chunks_since_flush = 0;
+  };
+
+  // 在锁外执行的通知
+  struct Notification {
+    TransferInfo info;
+    bool complete = false;
+    ErrorCode error = ErrorCode::kSuccess;
+    std::string message;
+  };
+  using NotificationList = std::vector<Notification>;
+
+  // ---- 发送端（调用时需持有 mutex_）----
+  void OnRequest(const FileChunkRequest& request, NotificationList& events);
+  void OnComplete(uint32_t transfer_id, NotificationList& events);
+  void OnCancel(const FileCancel& cancel, NotificationList& events);
+  void FlushPendingChunks(OutgoingTransfer& transfer);
+  bool SendChunk(OutgoingTransfer& transfer, uint32_t chunk_index);
+
+  // ---- 接收端（调用时需持有 mutex_）----
+  std::optional<TransferInfo> OnOffer(const FileOffer& offer);
+  void ResolveOffer(uint32_t transfer_id,
+                    bool accepted,
+                    NotificationList& events);
+  void AcceptOffer(const FileOffer& offer, NotificationList& events);
+  std::string MakePartPath(const std::string& name,
+                           const FileOffer& offer) const;
+  void OnChunk(const FileChunkHeader& header,
+               const uint8_t* payload,
+               size_t length,
+               NotificationList& events);
+  Result<void> OpenIncoming(IncomingTransfer& transfer);
+  bool LoadResumeState(IncomingTransfer& transfer);
+  void SaveResumeState(const IncomingTransfer& transfer);
+  void RequestMoreChunks(IncomingTransfer& transfer);
+  void FinishIncoming(IncomingTransfer& transfer, NotificationList& events);
+  void FailIncoming(uint32_t transfer_id,
+                    ErrorCode error,
+                    const std::string& reason,
+                    bool notify_peer,
+                    NotificationList& events);
+
+  void SendControl(const std::vector<uint8_t>& message);
+  void FlushControl();
+  void Notify(NotificationList& events);
+
+  std::shared_ptr<DataChannel> channel_;
+  Config config_;
+  mutable std::mutex mutex_;
+
+  std::map<uint32_t, OutgoingTransfer> outgoing_;
+  std::map<uint32_t, IncomingTransfer> incoming_;
+  std::map<uint32_t, FileOffer> pending_offers_;  ///< 等待接收回调决定的 OFFER
+  uint32_t next_transfer_id_ = 1;
+  std::deque<std::vector<uint8_t>> pending_control_;  ///< 待重发的控制消息
+
+  OnOfferCallback on_offer_callback_;
+  OnProgressCallback on_progress_callback_;
+  OnCompleteCallback on_complete_callback_;
+  Stats stats_;
+};
+
+}  // namespace zenremote
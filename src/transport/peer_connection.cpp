@@ -1,15 +1,104 @@
 #include "peer_connection.h"
 
 #include <algorithm>
+#include <cstdlib>
+#include <string>
 
 #include "channel/reliable_channel.h"
 #include "common/log_manager.h"
 #include "network/connection/base_connection.h"
 #include "network/connection/direct_connection.h"
+#include "network/connection/ice_connection.h"
+#include "network/connection/turn_connection.h"
+#include "network/reliable/reliable_transport.h"
+#include "network/rtp/rtcp_feedback.h"
 
 namespace zenremote {
 
-PeerConnection::PeerConnection() = default;
+namespace {
+
+// 通道控制消息走保留流，有序可靠、最高优先级
+constexpr uint16_t kControlStreamId = 0xFFFF;
+constexpr uint8_t kDataChannelOpen = 0x03;
+// type(1) ordered(1) priority(1) reserved(1) stream_id(2) weight(2)
+// max_retransmits(4) max_packet_life_time(4) label_length(2)
+constexpr size_t kDataChannelOpenHeaderSize = 18;
+// OPEN 到达前缓存的消息数上限（每个流）
+constexpr size_t kMaxPendingStreamMessages = 256;
+// 本端可能不发送媒体，反馈的发送方 SSRC 固定为 0；对端按媒体 SSRC 路由
+constexpr uint32_t kFeedbackSenderSsrc = 0;
+
+std::vector<uint8_t> SerializeDataChannelOpen(
+    const std::string& label,
+    const DataChannel::Config& config) {
+  std::vector<uint8_t> buffer;
+  buffer.reserve(kDataChannelOpenHeaderSize + label.size());
+  buffer.push_back(kDataChannelOpen);
+  buffer.push_back(config.ordered ? 1 : 0);
+  buffer.push_back(static_cast<uint8_t>(config.priority));
+  buffer.push_back(0);
+  WriteUint16LE(static_cast<uint16_t>(config.id), buffer);
+  WriteUint16LE(config.weight, buffer);
+  WriteUint32LE(static_cast<uint32_t>(config.max_retransmits), buffer);
+  WriteUint32LE(static_cast<uint32_t>(config.max_packet_life_time), buffer);
+  WriteUint16LE(static_cast<uint16_t>(label.size()), buffer);
+  buffer.insert(buffer.end(), label.begin(), label.end());
+  return buffer;
+}
+
+bool ParseDataChannelOpen(const uint8_t* data,
+                          size_t length,
+                          std::string& label,
+                          DataChannel::Config& config) {
+  if (length < kDataChannelOpenHeaderSize || data[0] != kDataChannelOpen) {
+    return false;
+  }
+  const size_t label_length = ReadUint16LE(data + 16);
+  if (length < kDataChannelOpenHeaderSize + label_length ||
+      data[2] > static_cast<uint8_t>(DataChannel::Priority::kHigh) ||
+      ReadUint16LE(data + 4) == kControlStreamId) {
+    return false;
+  }
+  config.ordered = data[1] != 0;
+  config.priority = static_cast<DataChannel::Priority>(data[2]);
+  config.id = ReadUint16LE(data + 4);
+  config.weight = ReadUint16LE(data + 6);
+  config.max_retransmits = static_cast<int32_t>(ReadUint32LE(data + 8));
+  config.max_packet_life_time = static_cast<int32_t>(ReadUint32LE(data + 12));
+  label.assign(reinterpret_cast<const char*>(data) + kDataChannelOpenHeaderSize,
+               label_length);
+  return true;
+}
+
+// "host:port"，省略端口时使用 TURN 默认端口 3478
+bool ParseHostPort(const std::string& text, std::string& host, uint16_t& port) {
+  const auto colon = text.rfind(':');
+  if (colon == std::string::npos || text.find(':') != colon) {
+    host = text;
+    port = 3478;
+    return !host.empty();
+  }
+  host = text.substr(0, colon);
+  const int value = std::atoi(text.c_str() + colon + 1);
+  if (host.empty() || value <= 0 || value > 0xFFFF) {
+    return false;
+  }
+  port = static_cast<uint16_t>(value);
+  return true;
+}
+
+}  // namespace
+
+PeerConnection::PeerConnection() {
+  rtp_demuxer_.RegisterPayloadType(VideoTrack::kPayloadType,
+                                   MediaTrack::Kind::kVideo);
+  rtp_demuxer_.RegisterPayloadType(AudioTrack::kPayloadType,
+                                   MediaTrack::Kind::kAudio);
+  rtp_demuxer_.SetOnUnknownSsrcCallback(
+      [this](uint32_t ssrc, uint8_t, MediaTrack::Kind kind) {
+        return CreateRemoteTrack(ssrc, kind);
+      });
+}
 
 PeerConnection::~PeerConnection() {
   Disconnect();
@@ -25,6 +114,9 @@ Result<void> PeerConnection::Initialize(const Config& config) {
       conn_config.remote.address = config_.remote_ip;
       conn_config.remote.port = config_.remote_port;
       conn_config.local_port = config_.local_port;
+      conn_config.enable_migration = config_.enable_migration;
+      conn_config.session_id = config_.session_id;
+      conn_config.migration_key = config_.migration_key;
 
       auto result = direct_conn->Initialize(conn_config);
       if (result.IsErr()) {
@@ -37,13 +129,53 @@ Result<void> PeerConnection::Initialize(const Config& config) {
       break;
     }
 
-    case ConnectionMode::kRelay:
-      return Result<void>::Err(ErrorCode::kNotImplemented,
-                               "TURN relay not implemented yet");
+    case ConnectionMode::kRelay: {
+      // 分配中继并绑定对端，数据经中继转发到 remote_ip:remote_port
+      auto relay_conn =
+          CreateRelayConnection({config_.remote_ip, config_.remote_port});
+      if (!relay_conn) {
+        return Result<void>::Err(ErrorCode::kConnectionFailed,
+                                 "Failed to allocate TURN relay");
+      }
+      connection_ = std::move(relay_conn);
+      break;
+    }
+
+    case ConnectionMode::kAuto: {
+      // 候选收集在这里完成，连通性检查推迟到 Connect() 打开连接时
+      IceConnection::Config ice_config;
+      ice_config.local_port = config_.local_port;
+      ice_config.local_addresses = config_.local_candidates;
+      ice_config.remote_candidates = config_.remote_candidates;
+      ice_config.local_password = config_.ice_local_password;
+      ice_config.remote_password = config_.ice_remote_password;
+      if (ice_config.remote_candidates.empty() && !config_.remote_ip.empty()) {
+        ice_config.remote_candidates.push_back(
+            {config_.remote_ip, config_.remote_port});
+      }
+
+      auto ice_conn = std::make_unique<IceConnection>();
+      auto result = ice_conn->Initialize(ice_config);
+      if (result.IsErr()) {
+        return Result<void>::Err(
+            result.Code(),
+            "Failed to gather ICE candidates: " + result.Message());
+      }
+
+      // 中继只为最高优先级的对端候选创建权限与通道
+      if (!config_.turn_server.empty() &&
+          !ice_config.remote_candidates.empty()) {
+        auto relay_result = ice_conn->AddRelayCandidate(
+            CreateRelayConnection(ice_config.remote_candidates.front()));
+        if (relay_result.IsErr()) {
+          ZENREMOTE_WARN("Relay candidate unavailable: {}",
+                         relay_result.Message());
+        }
+      }
 
-    case ConnectionMode::kAuto:
-      return Result<void>::Err(ErrorCode::kNotImplemented,
-                               "Auto mode not implemented yet");
+      connection_ = std::move(ice_conn);
+      break;
+    }
 
     default:
       return Result<void>::Err(ErrorCode::kInvalidParameter,
@@ -53,28 +185,89 @@ Result<void> PeerConnection::Initialize(const Config& config) {
   return Result<void>::Ok();
 }
 
+std::unique_ptr<BaseConnection> PeerConnection::CreateRelayConnection(
+    const Endpoint& peer) const {
+  TurnConnection::Config turn_config;
+  if (!ParseHostPort(config_.turn_server, turn_config.turn_server_ip,
+                     turn_config.turn_server_port)) {
+    ZENREMOTE_WARN("Invalid TURN server: {}", config_.turn_server);
+    return nullptr;
+  }
+  turn_config.username = config_.turn_username;
+  turn_config.password = config_.turn_password;
+  turn_config.peer = peer;
+
+  auto turn_conn = std::make_unique<TurnConnection>();
+  auto result = turn_conn->Initialize(turn_config);
+  if (result.IsOk()) {
+    result = turn_conn->Open();
+  }
+  if (result.IsErr()) {
+    ZENREMOTE_WARN("TURN allocation failed: {}", result.Message());
+    return nullptr;
+  }
+  return turn_conn;
+}
+
 Result<void> PeerConnection::Connect() {
   if (!connection_) {
     return Result<void>::Err(ErrorCode::kNotInitialized,
                              "PeerConnection not initialized");
   }
 
-  auto result = connection_->Open();
-  if (result.IsErr()) {
-    return Result<void>::Err(result.Code(),
-                             "Failed to open connection: " + result.Message());
+  // Initialize 可能已经打开了底层连接（DirectConnection）；
+  // IceConnection 在这里完成连通性检查并选定路径
+  if (!connection_->IsOpen()) {
+    auto result = connection_->Open();
+    if (result.IsErr()) {
+      // 连通性检查失败时释放已收集的候选与套接字，避免半初始化状态
+      connection_->Close();
+      connection_.reset();
+      return Result<void>::Err(
+          result.Code(), "Failed to open connection: " + result.Message());
+    }
   }
 
-  for (auto& track : tracks_) {
+  for (auto& track : GetTracks()) {
     track->SetConnection(connection_.get());
   }
 
-  for (auto& channel : data_channels_) {
-    channel->SetConnection(connection_.get());
+  data_transport_ = std::make_shared<ReliableTransport>(
+      connection_.get(), ReliableTransport::Config{});
+  ReliableTransport::StreamOptions control_options;
+  control_options.priority =
+      static_cast<uint8_t>(DataChannel::Priority::kHigh);
+  data_transport_->ConfigureStream(kControlStreamId, control_options);
+  data_transport_->SetOnStreamMessageCallback(
+      [this](uint16_t stream_id, const uint8_t* data, size_t length) {
+        OnDataChannelMessage(stream_id, data, length);
+      });
+
+  // 其他线程发送时启动的重传定时器需要接收线程重新计算等待时长
+  data_transport_->SetOnTimerScheduledCallback(
+      [this]() { receive_loop_.Wakeup(); });
+
+  auto loop_result = receive_loop_.Start(
+      connection_.get(),
+      [this](const uint8_t* data, size_t length) {
+        ProcessReceivedPacket(data, length);
+      },
+      [this]() { return ProcessTimers(); }, config_.reactor.get());
+  if (loop_result.IsErr()) {
+    for (auto& track : GetTracks()) {
+      track->SetConnection(nullptr);
+    }
+    data_transport_.reset();
+    connection_->Close();
+    connection_.reset();
+    return Result<void>::Err(loop_result.Code(),
+                             "Failed to start receive loop: " +
+                                 loop_result.Message());
   }
 
-  should_stop_ = false;
-  receive_thread_ = std::make_unique<std::thread>([this]() { ReceiveLoop(); });
+  for (auto& channel : GetChannelsSnapshot()) {
+    AnnounceDataChannel(channel);
+  }
 
   ZENREMOTE_INFO("PeerConnection connected");
   return Result<void>::Ok();
@@ -85,17 +278,32 @@ void PeerConnection::Disconnect() {
     return;
   }
 
-  should_stop_ = true;
-  if (receive_thread_ && receive_thread_->joinable()) {
-    receive_thread_->join();
-  }
+  receive_loop_.Stop();
 
-  for (auto& track : tracks_) {
+  for (auto& track : GetTracks()) {
     track->SetConnection(nullptr);
   }
 
-  for (auto& channel : data_channels_) {
-    channel->SetConnection(nullptr);
+  // 接收线程已退出，可以安全地停止轨道处理线程
+  rtp_demuxer_.Clear();
+  {
+    std::lock_guard<std::mutex> lock(remote_tracks_mutex_);
+    remote_tracks_.clear();
+  }
+
+  for (auto& channel : GetChannelsSnapshot()) {
+    channel->AttachTransport(nullptr);
+  }
+  // 只 Initialize() 未 Connect() 时还没有创建数据传输
+  if (data_transport_) {
+    data_transport_->SetOnTimerScheduledCallback(nullptr);
+    data_transport_.reset();
+  }
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    pending_stream_messages_.clear();
+    opened_streams_.clear();
+    rejected_streams_.clear();
   }
 
   connection_->Close();
@@ -108,20 +316,46 @@ bool PeerConnection::IsConnected() const {
   return connection_ && connection_->IsOpen();
 }
 
+Result<void> PeerConnection::MigrateConnection(const std::string& local_ip) {
+  if (!connection_ || !receive_loop_.IsRunning()) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "PeerConnection not connected");
+  }
+  if (config_.mode != ConnectionMode::kDirect || !config_.enable_migration) {
+    return Result<void>::Err(
+        ErrorCode::kNotSupported,
+        "Migration requires kDirect mode with enable_migration");
+  }
+
+  // 连接的 socket 只能在接收线程替换
+  auto* direct = static_cast<DirectConnection*>(connection_.get());
+  receive_loop_.Post([direct, local_ip]() {
+    auto result = direct->Migrate(local_ip);
+    if (result.IsErr()) {
+      ZENREMOTE_WARN("Connection migration failed: {}", result.Message());
+    }
+  });
+  return Result<void>::Ok();
+}
+
 Result<void> PeerConnection::AddTrack(std::shared_ptr<MediaTrack> track) {
   if (!track) {
     return Result<void>::Err(ErrorCode::kInvalidParameter, "Track is null");
   }
 
-  auto it = std::find_if(tracks_.begin(), tracks_.end(), [&](const auto& t) {
-    return t->GetId() == track->GetId();
-  });
-  if (it != tracks_.end()) {
-    return Result<void>::Err(ErrorCode::kInvalidOperation,
-                             "Track already exists: " + track->GetId());
-  }
+  {
+    std::lock_guard<std::mutex> lock(tracks_mutex_);
+    auto it =
+        std::find_if(tracks_.begin(), tracks_.end(), [&](const auto& t) {
+          return t->GetId() == track->GetId();
+        });
+    if (it != tracks_.end()) {
+      return Result<void>::Err(ErrorCode::kInvalidOperation,
+                               "Track already exists: " + track->GetId());
+    }
 
-  tracks_.push_back(track);
+    tracks_.push_back(track);
+  }
 
   if (IsConnected()) {
     track->SetConnection(connection_.get());
@@ -132,54 +366,126 @@ Result<void> PeerConnection::AddTrack(std::shared_ptr<MediaTrack> track) {
 }
 
 Result<void> PeerConnection::RemoveTrack(const std::string& track_id) {
-  auto it = std::find_if(tracks_.begin(), tracks_.end(),
-                         [&](const auto& t) { return t->GetId() == track_id; });
+  std::shared_ptr<MediaTrack> track;
+  {
+    std::lock_guard<std::mutex> lock(tracks_mutex_);
+    auto it = std::find_if(
+        tracks_.begin(), tracks_.end(),
+        [&](const auto& t) { return t->GetId() == track_id; });
+
+    if (it == tracks_.end()) {
+      return Result<void>::Err(ErrorCode::kInvalidParameter,
+                               "Track not found: " + track_id);
+    }
 
-  if (it == tracks_.end()) {
-    return Result<void>::Err(ErrorCode::kInvalidParameter,
-                             "Track not found: " + track_id);
+    track = *it;
+    tracks_.erase(it);
   }
-
-  (*it)->SetConnection(nullptr);
-  tracks_.erase(it);
+  track->SetConnection(nullptr);
 
   ZENREMOTE_INFO("Removed track: {}", track_id);
   return Result<void>::Ok();
 }
 
 std::vector<std::shared_ptr<MediaTrack>> PeerConnection::GetTracks() const {
+  std::lock_guard<std::mutex> lock(tracks_mutex_);
   return tracks_;
 }
 
 std::shared_ptr<MediaTrack> PeerConnection::GetTrack(
     const std::string& track_id) const {
+  std::lock_guard<std::mutex> lock(tracks_mutex_);
   auto it = std::find_if(tracks_.begin(), tracks_.end(),
                          [&](const auto& t) { return t->GetId() == track_id; });
   return it != tracks_.end() ? *it : nullptr;
 }
 
+std::vector<std::shared_ptr<MediaTrack>> PeerConnection::GetRemoteTracks()
+    const {
+  std::lock_guard<std::mutex> lock(remote_tracks_mutex_);
+  return remote_tracks_;
+}
+
+RtpDemuxer::Stats PeerConnection::GetReceiveStats() const {
+  return rtp_demuxer_.GetStats();
+}
+
+Result<void> PeerConnection::SendNack(uint32_t ssrc,
+                                      const std::vector<uint16_t>& sequences) {
+  if (sequences.empty()) {
+    return Result<void>::Ok();
+  }
+  return SendRtcp(rtp::SerializeNack(kFeedbackSenderSsrc, ssrc, sequences));
+}
+
+Result<void> PeerConnection::RequestKeyFrame(uint32_t ssrc) {
+  return SendRtcp(rtp::SerializePli(kFeedbackSenderSsrc, ssrc));
+}
+
+Result<void> PeerConnection::SendBandwidthEstimate(uint32_t ssrc,
+                                                   uint64_t bitrate_bps) {
+  return SendRtcp(rtp::SerializeRemb(kFeedbackSenderSsrc, bitrate_bps, {ssrc}));
+}
+
+Result<void> PeerConnection::SendRtcp(const std::vector<uint8_t>& packet) {
+  if (!IsConnected()) {
+    return Result<void>::Err(ErrorCode::kNotInitialized,
+                             "PeerConnection not connected");
+  }
+  auto result = connection_->Send(packet.data(), packet.size());
+  if (result.IsErr()) {
+    return Result<void>::Err(result.Code(), result.Message());
+  }
+  return Result<void>::Ok();
+}
+
 Result<std::shared_ptr<DataChannel>> PeerConnection::CreateDataChannel(
     const std::string& label,
     const DataChannel::Config& config) {
-  auto existing = GetDataChannel(label);
-  if (existing) {
-    return Result<std::shared_ptr<DataChannel>>::Err(
-        ErrorCode::kInvalidOperation, "DataChannel already exists: " + label);
-  }
+  std::shared_ptr<ReliableChannel> channel;
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    auto it =
+        std::find_if(data_channels_.begin(), data_channels_.end(),
+                     [&](const auto& ch) { return ch->GetLabel() == label; });
+    if (it != data_channels_.end()) {
+      return Result<std::shared_ptr<DataChannel>>::Err(
+          ErrorCode::kInvalidOperation, "DataChannel already exists: " + label);
+    }
 
-  auto channel = std::make_shared<ReliableChannel>(label, config);
-  data_channels_.push_back(channel);
+    DataChannel::Config channel_config = config;
+    if (channel_config.id < 0) {
+      channel_config.id = AllocateStreamIdLocked();
+    }
+    if (channel_config.id < 0 || channel_config.id >= kControlStreamId) {
+      return Result<std::shared_ptr<DataChannel>>::Err(
+          ErrorCode::kInvalidParameter,
+          "Invalid DataChannel stream id: " +
+              std::to_string(channel_config.id));
+    }
+    if (channels_by_stream_.count(channel_config.id) > 0) {
+      return Result<std::shared_ptr<DataChannel>>::Err(
+          ErrorCode::kInvalidOperation,
+          "DataChannel stream id in use: " + std::to_string(channel_config.id));
+    }
 
-  if (IsConnected()) {
-    channel->SetConnection(connection_.get());
+    channel = std::make_shared<ReliableChannel>(label, channel_config);
+    data_channels_.push_back(channel);
+    channels_by_stream_[channel->GetId()] = channel;
   }
 
-  ZENREMOTE_INFO("Created DataChannel: {}", label);
+  if (data_transport_) {
+    AnnounceDataChannel(channel);
+  }
+
+  ZENREMOTE_INFO("Created DataChannel: {} (stream {})", label,
+                 channel->GetId());
   return Result<std::shared_ptr<DataChannel>>::Ok(channel);
 }
 
 std::shared_ptr<DataChannel> PeerConnection::GetDataChannel(
     const std::string& label) const {
+  std::lock_guard<std::mutex> lock(channels_mutex_);
   auto it =
       std::find_if(data_channels_.begin(), data_channels_.end(),
                    [&](const auto& ch) { return ch->GetLabel() == label; });
@@ -190,23 +496,226 @@ uint32_t PeerConnection::AllocateSSRC() {
   return next_ssrc_++;
 }
 
-void PeerConnection::ReceiveLoop() {
-  std::vector<uint8_t> buffer(65536);
+int PeerConnection::ProcessTimers() {
+  // 接收线程按返回值等待，没有定时器时一直阻塞到报文到达或被唤醒
+  data_transport_->ProcessTimers();
+  const int transport_delay = data_transport_->GetTimerDelayMs();
+  const int connection_delay = connection_->ProcessTimers();
+  if (transport_delay < 0 || connection_delay < 0) {
+    return std::max(transport_delay, connection_delay);
+  }
+  return std::min(transport_delay, connection_delay);
+}
 
-  while (!should_stop_) {
-    auto result = connection_->Recv(buffer.data(), buffer.size(), 100);
+void PeerConnection::ProcessReceivedPacket(const uint8_t* data, size_t length) {
+  if (IsTransportPacket(data, length)) {
+    data_transport_->OnPacketReceived(data, length);
+    return;
+  }
+  if (rtp::IsRtcpPacket(data, length)) {
+    ProcessRtcpPacket(data, length);
+    return;
+  }
+  if (rtp_demuxer_.OnRtpPacket(data, length)) {
+    return;
+  }
+  ZENREMOTE_DEBUG("Dropped unrecognized packet: {} bytes", length);
+}
 
-    if (result.IsOk()) {
-      size_t received = result.Value();
-      if (received > 0) {
-        ProcessReceivedPacket(buffer.data(), received);
+void PeerConnection::ProcessRtcpPacket(const uint8_t* data, size_t length) {
+  for (const auto& feedback : rtp::ParseRtcpFeedback(data, length)) {
+    std::shared_ptr<MediaTrack> track;
+    {
+      std::lock_guard<std::mutex> lock(tracks_mutex_);
+      auto it = std::find_if(tracks_.begin(), tracks_.end(),
+                             [&](const auto& t) {
+                               return t->GetSSRC() == feedback.media_ssrc;
+                             });
+      if (it != tracks_.end()) {
+        track = *it;
       }
     }
+    if (track) {
+      track->OnRtcpFeedback(feedback);
+    } else {
+      ZENREMOTE_DEBUG("RTCP feedback for unknown SSRC {}",
+                      feedback.media_ssrc);
+    }
   }
 }
 
-void PeerConnection::ProcessReceivedPacket(const uint8_t* data, size_t length) {
-  ZENREMOTE_DEBUG("Received {} bytes", length);
+std::shared_ptr<MediaTrack> PeerConnection::CreateRemoteTrack(
+    uint32_t ssrc,
+    MediaTrack::Kind kind) {
+  std::shared_ptr<MediaTrack> track;
+  if (kind == MediaTrack::Kind::kVideo) {
+    VideoTrack::Config config;
+    config.id = "remote-video-" + std::to_string(ssrc);
+    config.ssrc = ssrc;
+    track = std::make_shared<VideoTrack>(config);
+  } else {
+    AudioTrack::Config config;
+    config.id = "remote-audio-" + std::to_string(ssrc);
+    config.ssrc = ssrc;
+    track = std::make_shared<AudioTrack>(config);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(remote_tracks_mutex_);
+    remote_tracks_.push_back(track);
+  }
+  ZENREMOTE_INFO("Remote track added: {} (SSRC {})", track->GetId(), ssrc);
+  // 首包在回调返回后才入队，回调中设置的 OnFrameCallback 不会错过任何帧
+  if (on_track_callback_) {
+    on_track_callback_(track);
+  }
+  return track;
+}
+
+void PeerConnection::OnDataChannelMessage(uint16_t stream_id,
+                                          const uint8_t* data,
+                                          size_t length) {
+  if (stream_id == kControlStreamId) {
+    OnDataChannelOpen(data, length);
+    return;
+  }
+
+  std::shared_ptr<ReliableChannel> channel;
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    if (rejected_streams_.count(stream_id) > 0) {
+      ZENREMOTE_DEBUG("Dropped message for conflicting stream {}", stream_id);
+      return;
+    }
+    auto it = channels_by_stream_.find(stream_id);
+    if (it == channels_by_stream_.end() ||
+        opened_streams_.count(stream_id) == 0) {
+      // 不同流之间不保证先后，OPEN 可能晚于该流的首批消息到达；本地已有
+      // 同号通道时也要等 OPEN 确认名称一致，撞号的消息不能交给本地通道
+      auto& pending = pending_stream_messages_[stream_id];
+      if (pending.size() < kMaxPendingStreamMessages) {
+        pending.emplace_back(data, data + length);
+      } else {
+        ZENREMOTE_WARN("Dropped message for unopened stream {}", stream_id);
+      }
+      return;
+    }
+    channel = it->second;
+  }
+  channel->DeliverMessage(data, length);
+}
+
+void PeerConnection::OnDataChannelOpen(const uint8_t* data, size_t length) {
+  std::string label;
+  DataChannel::Config config;
+  if (!ParseDataChannelOpen(data, length, label, config)) {
+    ZENREMOTE_WARN("Invalid DataChannel open message");
+    return;
+  }
+
+  const uint16_t stream_id = static_cast<uint16_t>(config.id);
+  std::shared_ptr<ReliableChannel> channel;
+  bool created = false;
+  std::vector<std::vector<uint8_t>> pending;
+  {
+    std::lock_guard<std::mutex> lock(channels_mutex_);
+    if (opened_streams_.count(stream_id) > 0 ||
+        rejected_streams_.count(stream_id) > 0) {
+      return;
+    }
+    auto existing = channels_by_stream_.find(stream_id);
+    if (existing != channels_by_stream_.end()) {
+      // 名称不同说明两端撞号而不是协商通道：拒绝该流，丢弃对端的消息
+      if (existing->second->GetLabel() != label) {
+        ZENREMOTE_ERROR(
+            "Rejecting DataChannel {} from peer: stream {} is local {}",
+            label, stream_id, existing->second->GetLabel());
+        rejected_streams_.insert(stream_id);
+        pending_stream_messages_.erase(stream_id);
+        return;
+      }
+      channel = existing->second;
+    } else {
+      auto same_label =
+          std::find_if(data_channels_.begin(), data_channels_.end(),
+                       [&](const auto& ch) { return ch->GetLabel() == label; });
+      if (same_label != data_channels_.end()) {
+        ZENREMOTE_WARN("DataChannel {} opened by peer on stream {}, local {}",
+                       label, stream_id, (*same_label)->GetId());
+        return;
+      }
+
+      channel = std::make_shared<ReliableChannel>(label, config);
+      data_channels_.push_back(channel);
+      channels_by_stream_[stream_id] = channel;
+      created = true;
+    }
+    opened_streams_.insert(stream_id);
+    auto it = pending_stream_messages_.find(stream_id);
+    if (it != pending_stream_messages_.end()) {
+      pending = std::move(it->second);
+      pending_stream_messages_.erase(it);
+    }
+  }
+
+  if (!created) {
+    // 两端以相同 ID 各自创建的同名通道（协商通道）
+    for (const auto& message : pending) {
+      channel->DeliverMessage(message.data(), message.size());
+    }
+    return;
+  }
+
+  ZENREMOTE_INFO("Remote DataChannel opened: {} (stream {})", label, stream_id);
+  // 回送 OPEN：对端收到后才把该流上的消息交给它的本地通道
+  AnnounceDataChannel(channel);
+  if (on_datachannel_callback_) {
+    on_datachannel_callback_(channel);
+  }
+  for (const auto& message : pending) {
+    channel->DeliverMessage(message.data(), message.size());
+  }
+}
+
+void PeerConnection::AnnounceDataChannel(
+    const std::shared_ptr<ReliableChannel>& channel) {
+  channel->AttachTransport(data_transport_);
+
+  auto open =
+      SerializeDataChannelOpen(channel->GetLabel(), channel->GetConfig());
+  auto result =
+      data_transport_->Send(kControlStreamId, open.data(), open.size());
+  if (result.IsErr()) {
+    ZENREMOTE_WARN("Failed to announce DataChannel {}: {}",
+                   channel->GetLabel(), result.Message());
+  }
+}
+
+int PeerConnection::AllocateStreamIdLocked() {
+  // 两端都从 0 开始分配会撞号：按角色只用偶数或奇数（RFC 8832 6.5）
+  constexpr uint16_t kStreamIndexCount = kControlStreamId / 2;
+  const uint16_t parity = config_.controlling ? 0 : 1;
+  for (uint32_t attempt = 0; attempt < kStreamIndexCount; ++attempt) {
+    const uint16_t stream_id =
+        static_cast<uint16_t>(next_stream_index_ * 2 + parity);
+    next_stream_index_ =
+        static_cast<uint16_t>((next_stream_index_ + 1) % kStreamIndexCount);
+    if (channels_by_stream_.count(stream_id) == 0) {
+      return stream_id;
+    }
+  }
+  return -1;
+}
+
+std::vector<std::shared_ptr<ReliableChannel>>
+PeerConnection::GetChannelsSnapshot() const {
+  std::lock_guard<std::mutex> lock(channels_mutex_);
+  std::vector<std::shared_ptr<ReliableChannel>> channels;
+  channels.reserve(channels_by_stream_.size());
+  for (const auto& entry : channels_by_stream_) {
+    channels.push_back(entry.second);
+  }
+  return channels;
 }
 
 }  // namespace zenremote
@@ -2,7 +2,10 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -10,17 +13,35 @@
 #include "channel/data_channel.h"
 #include "common/error.h"
 #include "network/connection/base_connection.h"
+#include "network/connection/receive_loop.h"
+#include "network/io/endpoint.h"
+#include "rtp_demuxer.h"
 #include "track/audio_track.h"
 #include "track/media_track.h"
 #include "track/video_track.h"
 
 namespace zenremote {
 
+class ReliableChannel;
+class ReliableTransport;
+
 /**
  * @brief 对等连接
  *
  * 参考 WebRTC RTCPeerConnection
  * 管理连接和所有传输通道
+ *
+ * 所有 DataChannel 共享一个 ReliableTransport，以流 ID 区分（类似 SCTP
+ * association 上的多个 stream）。收到未知流 ID 的消息时自动创建远端通道
+ * 并通过 OnDataChannelCallback 通知。自动分配的流 ID 按角色划分奇偶
+ * （RFC 8832）：controlling 端用偶数、另一端用奇数，两端各自创建通道不会
+ * 撞号。每个流在收到对端同名的 OPEN 后才交付消息（由 OPEN 创建的远端
+ * 通道会回送 OPEN）；对端 OPEN 的流 ID 已被本地不同名的通道占用时拒绝该流。
+ *
+ * 收到的 RTP 包由 RtpDemuxer 按 SSRC 分发到远端轨道，未知 SSRC 的首包按负载
+ * 类型自动创建远端轨道并通过 OnTrackCallback 通知；OnFrameCallback 在各远端
+ * 轨道自己的处理线程执行。RTCP NACK / PLI / REMB 按媒体 SSRC 交给本地
+ * 轨道的 OnRtcpFeedback。
  */
 class PeerConnection {
  public:
@@ -36,9 +57,34 @@ class PeerConnection {
     uint16_t remote_port = 0;
     uint16_t local_port = 0;
 
+    /// host:port；kRelay 经它中继到 remote_ip:remote_port，
+    /// kAuto 时额外收集中继候选
     std::string turn_server;
     std::string turn_username;
     std::string turn_password;
+
+    /// kAuto：对端候选地址，为空时使用 remote_ip:remote_port
+    std::vector<Endpoint> remote_candidates;
+    /// kAuto：本机候选地址，为空时枚举全部网卡
+    std::vector<std::string> local_candidates;
+    /// kAuto：两端各自 GenerateIcePassword() 并随候选交换，用于认证连通性
+    /// 检查；都为空时只接受来自 remote_candidates 的检查
+    std::string ice_local_password;
+    std::string ice_remote_password;
+
+    /// kDirect：网卡地址变化时迁移到新路径，两端填写握手得到的同一会话 ID
+    /// 与迁移密钥（HandshakeManager::GetMigrationKey()）
+    bool enable_migration = false;
+    uint32_t session_id = 0;
+    std::vector<uint8_t> migration_key;
+
+    /// 非空时在共享反应器上接收（多会话主机），不创建接收线程；
+    /// 须已 Start，且在 Disconnect() 之前保持运行
+    std::shared_ptr<NetworkReactor> reactor;
+
+    /// 数据通道角色：发起连接的控制端填 true（偶数流 ID），被控端填 false
+    /// （奇数流 ID），两端必须不同
+    bool controlling = false;
   };
 
   PeerConnection();
@@ -49,11 +95,39 @@ class PeerConnection {
   void Disconnect();
   bool IsConnected() const;
 
+  /**
+   * @brief 把直连迁移到新的本地地址（启用迁移时网卡变化会自动触发）
+   *
+   * 在接收线程探测新路径，对端确认后切换；轨道、数据通道和对端的抖动缓冲
+   * 与解码器状态保持不变，不重新握手，也不需要关键帧。探测异步进行，
+   * 返回 Ok 只表示已开始迁移。
+   * @param local_ip 新的本地地址，为空时重新绑定原地址
+   */
+  Result<void> MigrateConnection(const std::string& local_ip = "");
+
   Result<void> AddTrack(std::shared_ptr<MediaTrack> track);
   Result<void> RemoveTrack(const std::string& track_id);
   std::vector<std::shared_ptr<MediaTrack>> GetTracks() const;
   std::shared_ptr<MediaTrack> GetTrack(const std::string& track_id) const;
 
+  /// @brief 对端发来的轨道（收到其首个 RTP 包时创建）
+  std::vector<std::shared_ptr<MediaTrack>> GetRemoteTracks() const;
+
+  /// @brief 接收分发统计，含网络线程的单包分发开销
+  RtpDemuxer::Stats GetReceiveStats() const;
+
+  /**
+   * @brief 请求对端重传丢失的 RTP 包（RTCP Generic NACK）
+   * @param ssrc 对端轨道的 SSRC（远端轨道的 GetSSRC()）
+   */
+  Result<void> SendNack(uint32_t ssrc, const std::vector<uint16_t>& sequences);
+
+  /// @brief 请求对端轨道发送关键帧（RTCP PLI），用于解码出错后恢复
+  Result<void> RequestKeyFrame(uint32_t ssrc);
+
+  /// @brief 向对端轨道报告本端的接收带宽估计（RTCP REMB）
+  Result<void> SendBandwidthEstimate(uint32_t ssrc, uint64_t bitrate_bps);
+
   Result<std::shared_ptr<DataChannel>> CreateDataChannel(
       const std::string& label,
       const DataChannel::Config& config = {});
@@ -73,22 +147,48 @@ class PeerConnection {
 
  private:
   uint32_t AllocateSSRC();
-  void ReceiveLoop();
+  /// @brief 分配 TURN 中继并为 peer 绑定通道，失败返回空
+  std::unique_ptr<BaseConnection> CreateRelayConnection(
+      const Endpoint& peer) const;
+  int ProcessTimers();
   void ProcessReceivedPacket(const uint8_t* data, size_t length);
+  /// @brief 把 NACK / PLI 交给 SSRC 对应的本地轨道
+  void ProcessRtcpPacket(const uint8_t* data, size_t length);
+  Result<void> SendRtcp(const std::vector<uint8_t>& packet);
+  std::shared_ptr<MediaTrack> CreateRemoteTrack(uint32_t ssrc,
+                                                MediaTrack::Kind kind);
+  void OnDataChannelMessage(uint16_t stream_id,
+                            const uint8_t* data,
+                            size_t length);
+  void OnDataChannelOpen(const uint8_t* data, size_t length);
+  void AnnounceDataChannel(const std::shared_ptr<ReliableChannel>& channel);
+  int AllocateStreamIdLocked();
+  std::vector<std::shared_ptr<ReliableChannel>> GetChannelsSnapshot() const;
 
   Config config_;
   std::unique_ptr<BaseConnection> connection_;
 
   std::vector<std::shared_ptr<MediaTrack>> tracks_;
+  mutable std::mutex tracks_mutex_;  ///< 接收线程按 SSRC 查找本地轨道
+  std::vector<std::shared_ptr<MediaTrack>> remote_tracks_;
+  mutable std::mutex remote_tracks_mutex_;  ///< 远端轨道由接收线程创建
+  RtpDemuxer rtp_demuxer_;
   std::vector<std::shared_ptr<DataChannel>> data_channels_;
+  std::map<uint16_t, std::shared_ptr<ReliableChannel>> channels_by_stream_;
+  std::map<uint16_t, std::vector<std::vector<uint8_t>>>
+      pending_stream_messages_;  ///< 等待对端 OPEN 的消息
+  std::set<uint16_t> opened_streams_;    ///< 已收到对端 OPEN 的流
+  std::set<uint16_t> rejected_streams_;  ///< 对端 OPEN 与本地通道名冲突的流
+  std::shared_ptr<ReliableTransport> data_transport_;
+  mutable std::mutex channels_mutex_;  ///< 保护通道表（接收线程会创建远端通道）
+  uint16_t next_stream_index_ = 0;  ///< 流 ID = 2 * index + 角色奇偶位
 
   OnTrackCallback on_track_callback_;
   OnDataChannelCallback on_datachannel_callback_;
 
   uint32_t next_ssrc_ = 1000;
 
-  std::unique_ptr<std::thread> receive_thread_;
-  std::atomic<bool> should_stop_{false};
+  ReceiveLoop receive_loop_;
 };
 
 }  // namespace zenremote
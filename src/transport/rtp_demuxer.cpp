@@ -0,0 +1,292 @@
+#include "rtp_demuxer.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "network/rtp/rtp_packet.h"
+
+namespace zenremote {
+
+namespace {
+
+constexpr size_t kRtpHeaderSize = sizeof(network::RTPHeader);
+constexpr size_t kExtensionHeaderSize = 4;
+
+// 处理线程空闲时的最长等待时间，兜底漏掉的唤醒
+constexpr auto kWorkerIdleWait = std::chrono::milliseconds(10);
+
+// 队列排空后先短暂让出 CPU 轮询再休眠：包间隔很短时避免网络线程每包都要
+// 进入内核唤醒处理线程
+constexpr int kWorkerSpinRounds = 64;
+
+// 统计只由网络线程写入，无需原子读改写指令
+void Increment(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+}  // namespace
+
+// ============================================================================
+// TrackWorker：单个远端轨道的处理线程
+// ============================================================================
+
+class RtpDemuxer::TrackWorker {
+ public:
+  TrackWorker(std::shared_ptr<MediaTrack> track, size_t queue_capacity)
+      : track_(std::move(track)), queue_(queue_capacity) {
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  ~TrackWorker() { Stop(); }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  // ---- 网络线程 ----
+
+  QueuedPacket* PrepareWrite() { return queue_.PrepareWrite(); }
+
+  void CommitWrite() {
+    queue_.CommitWrite();
+    // 与 Run() 中 waiting_ 的写入配对：两者至少有一方能看到对方的修改，
+    // 处理线程忙碌时不进入内核
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      while (QueuedPacket* packet = queue_.Front()) {
+        track_->DeliverFrame(packet->data.data() + packet->payload_offset,
+                             packet->payload_length, packet->timestamp);
+        queue_.PopFront();
+      }
+      if (Spin()) {
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (stop_) {
+        return;
+      }
+      waiting_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      cv_.wait_for(lock, kWorkerIdleWait,
+                   [this]() { return stop_ || !queue_.Empty(); });
+      waiting_.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  // 轮询等待新包，返回 true 表示队列已非空
+  bool Spin() {
+    for (int i = 0; i < kWorkerSpinRounds; ++i) {
+      if (!queue_.Empty()) {
+        return true;
+      }
+      std::this_thread::yield();
+    }
+    return false;
+  }
+
+  std::shared_ptr<MediaTrack> track_;
+  SpscQueue<QueuedPacket> queue_;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<bool> waiting_{false};
+  bool stop_ = false;
+};
+
+// ============================================================================
+// RtpDemuxer
+// ============================================================================
+
+RtpDemuxer::RtpDemuxer() : RtpDemuxer(Config{}) {}
+
+RtpDemuxer::RtpDemuxer(const Config& config) : config_(config) {
+  payload_kinds_.fill(kUnknownKind);
+}
+
+RtpDemuxer::~RtpDemuxer() {
+  Clear();
+}
+
+void RtpDemuxer::RegisterPayloadType(uint8_t payload_type,
+                                     MediaTrack::Kind kind) {
+  if (payload_type < payload_kinds_.size()) {
+    payload_kinds_[payload_type] = static_cast<int8_t>(kind);
+  }
+}
+
+Result<void> RtpDemuxer::AddTrack(uint32_t ssrc,
+                                  std::shared_ptr<MediaTrack> track) {
+  if (!track) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter, "Track is null");
+  }
+  Route* route = FindRoute(ssrc);
+  if (route && route->worker) {
+    return Result<void>::Err(ErrorCode::kInvalidOperation,
+                             "SSRC already bound: " + std::to_string(ssrc));
+  }
+  if (!route && route_count_ >= kMaxTracks) {
+    return Result<void>::Err(ErrorCode::kInvalidOperation,
+                             "Too many remote tracks");
+  }
+
+  workers_.push_back(
+      std::make_unique<TrackWorker>(std::move(track), config_.queue_capacity));
+  if (route) {
+    route->worker = workers_.back().get();
+  } else {
+    InsertRoute(ssrc, workers_.back().get());
+  }
+  return Result<void>::Ok();
+}
+
+bool RtpDemuxer::OnRtpPacket(const uint8_t* data, size_t length) {
+  const auto start = std::chrono::steady_clock::now();
+  if (!data || length < kRtpHeaderSize) {
+    return false;
+  }
+  network::RTPHeader header;
+  std::memcpy(&header, data, kRtpHeaderSize);
+  if (header.version != 2) {
+    return false;
+  }
+  Increment(stats_.packets_received);
+
+  // 负载范围：跳过 CSRC 列表与扩展头，去掉填充
+  size_t offset = kRtpHeaderSize + header.csrc_count * 4U;
+  size_t end = length;
+  if (header.extension && offset + kExtensionHeaderSize <= end) {
+    const size_t words = (static_cast<size_t>(data[offset + 2]) << 8) |
+                         data[offset + 3];
+    offset += kExtensionHeaderSize + words * 4;
+  }
+  if (header.padding && end > 0) {
+    const size_t padding = data[end - 1];
+    end = padding <= end ? end - padding : 0;
+  }
+  if (offset > end) {
+    Increment(stats_.packets_invalid);
+    return true;
+  }
+
+  Route* route = FindRoute(header.ssrc);
+  if (!route) {
+    const int8_t kind = payload_kinds_[header.payload_type];
+    if (kind == kUnknownKind || !on_unknown_ssrc_callback_ ||
+        route_count_ >= kMaxTracks) {
+      Increment(stats_.packets_unrouted);
+      return true;
+    }
+    auto track = on_unknown_ssrc_callback_(
+        header.ssrc, header.payload_type, static_cast<MediaTrack::Kind>(kind));
+    if (track && AddTrack(header.ssrc, std::move(track)).IsOk()) {
+      Increment(stats_.tracks_created);
+    } else {
+      InsertRoute(header.ssrc, nullptr);  // 之后的包不再询问
+    }
+    route = FindRoute(header.ssrc);
+  }
+
+  if (!route || !route->worker) {
+    Increment(stats_.packets_unrouted);
+    return true;
+  }
+
+  QueuedPacket* slot = route->worker->PrepareWrite();
+  if (!slot) {
+    Increment(stats_.packets_dropped);
+    return true;
+  }
+  slot->data.assign(data, data + length);
+  slot->payload_offset = offset;
+  slot->payload_length = end - offset;
+  slot->timestamp = header.timestamp;
+  route->worker->CommitWrite();
+
+  Increment(stats_.packets_dispatched);
+  Increment(stats_.dispatch_time_ns,
+            static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count()));
+  return true;
+}
+
+void RtpDemuxer::Clear() {
+  for (auto& worker : workers_) {
+    worker->Stop();
+  }
+  workers_.clear();
+  routes_.fill(Route{});
+  route_count_ = 0;
+}
+
+RtpDemuxer::Stats RtpDemuxer::GetStats() const {
+  Stats stats;
+  stats.packets_received =
+      stats_.packets_received.load(std::memory_order_relaxed);
+  stats.packets_dispatched =
+      stats_.packets_dispatched.load(std::memory_order_relaxed);
+  stats.packets_invalid = stats_.packets_invalid.load(std::memory_order_relaxed);
+  stats.packets_unrouted =
+      stats_.packets_unrouted.load(std::memory_order_relaxed);
+  stats.packets_dropped = stats_.packets_dropped.load(std::memory_order_relaxed);
+  stats.tracks_created = stats_.tracks_created.load(std::memory_order_relaxed);
+  stats.dispatch_time_ns =
+      stats_.dispatch_time_ns.load(std::memory_order_relaxed);
+  return stats;
+}
+
+size_t RtpDemuxer::Slot(uint32_t ssrc) {
+  // Fibonacci 散列取高位：SSRC 通常随机，但也可能是连续的小整数
+  return (ssrc * 2654435761U) >> (32 - kTableBits);
+}
+
+RtpDemuxer::Route* RtpDemuxer::FindRoute(uint32_t ssrc) {
+  for (size_t i = 0, slot = Slot(ssrc); i < kTableSize;
+       ++i, slot = (slot + 1) % kTableSize) {
+    Route& route = routes_[slot];
+    if (!route.used) {
+      return nullptr;
+    }
+    if (route.ssrc == ssrc) {
+      return &route;
+    }
+  }
+  return nullptr;
+}
+
+RtpDemuxer::Route* RtpDemuxer::InsertRoute(uint32_t ssrc,
+                                           TrackWorker* worker) {
+  if (route_count_ >= kMaxTracks) {
+    return nullptr;
+  }
+  size_t slot = Slot(ssrc);
+  while (routes_[slot].used) {
+    slot = (slot + 1) % kTableSize;
+  }
+  routes_[slot].ssrc = ssrc;
+  routes_[slot].used = true;
+  routes_[slot].worker = worker;
+  route_count_++;
+  return &routes_[slot];
+}
+
+}  // namespace zenremote
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/error.h"
+#include "common/spsc_queue.h"
+#include "transport/track/media_track.h"
+
+namespace zenremote {
+
+/**
+ * @brief RTP 接收分发器
+ *
+ * 把网络线程收到的 RTP 包按 SSRC 分发到远端轨道：
+ * - SSRC → 轨道：固定容量的开放寻址哈希表，查找为常数时间，不加锁
+ * - 负载类型 → 轨道类型：128 项直接索引表，用于首包自动创建远端轨道
+ * - 每个轨道一个处理线程，网络线程只做头部解析与一次拷贝，通过 SPSC
+ *   无锁队列交给处理线程，OnFrameCallback（解码等耗时工作）不在网络线程执行
+ * - 处理线程落后导致队列满时丢弃新包并计数，网络线程从不阻塞
+ *
+ * 线程模型：OnRtpPacket / AddTrack 由网络线程调用（或在网络线程停止后调用）；
+ * 轨道处理线程由 AddTrack 启动，Clear() 或析构时停止。
+ */
+class RtpDemuxer {
+ public:
+  static constexpr size_t kMaxTracks = 64;
+  static constexpr size_t kDefaultQueueCapacity = 256;
+
+  struct Config {
+    size_t queue_capacity = kDefaultQueueCapacity;  ///< 每个轨道的队列容量
+  };
+
+  /**
+   * @brief 统计（网络线程侧）
+   *
+   * dispatch_time_ns / packets_dispatched 即网络线程分发单包的平均开销。
+   */
+  struct Stats {
+    uint64_t packets_received = 0;
+    uint64_t packets_dispatched = 0;
+    uint64_t packets_invalid = 0;   ///< 头部不合法
+    uint64_t packets_unrouted = 0;  ///< 未知 SSRC 且无法创建轨道
+    uint64_t packets_dropped = 0;   ///< 处理线程队列已满
+    uint64_t tracks_created = 0;
+    uint64_t dispatch_time_ns = 0;  ///< 成功分发的包在 OnRtpPacket 中的累计耗时
+  };
+
+  /**
+   * @brief 首次收到未知 SSRC 时调用，返回要绑定的远端轨道
+   *
+   * 在网络线程执行；返回 nullptr 表示忽略该 SSRC（之后的包直接丢弃）。
+   */
+  using OnUnknownSsrcCallback = std::function<std::shared_ptr<MediaTrack>(
+      uint32_t ssrc,
+      uint8_t payload_type,
+      MediaTrack::Kind kind)>;
+
+  RtpDemuxer();
+  explicit RtpDemuxer(const Config& config);
+  ~RtpDemuxer();
+
+  RtpDemuxer(const RtpDemuxer&) = delete;
+  RtpDemuxer& operator=(const RtpDemuxer&) = delete;
+
+  /// @brief 声明负载类型对应的轨道类型；未声明的负载类型不会自动创建轨道
+  void RegisterPayloadType(uint8_t payload_type, MediaTrack::Kind kind);
+
+  void SetOnUnknownSsrcCallback(OnUnknownSsrcCallback callback) {
+    on_unknown_ssrc_callback_ = std::move(callback);
+  }
+
+  /// @brief 绑定 SSRC 与轨道并启动其处理线程
+  Result<void> AddTrack(uint32_t ssrc, std::shared_ptr<MediaTrack> track);
+
+  /**
+   * @brief 分发一个收到的报文
+   * @return 是否为 RTP 包（不论是否成功交付）；false 表示不是 RTP，
+   *         调用方可继续交给其他协议处理
+   */
+  bool OnRtpPacket(const uint8_t* data, size_t length);
+
+  /// @brief 停止全部处理线程并清空路由表
+  void Clear();
+
+  Stats GetStats() const;
+
+ private:
+  // 交给处理线程的报文，槽位中的 vector 跨轮次复用容量
+  struct QueuedPacket {
+    std::vector<uint8_t> data;
+    size_t payload_offset = 0;
+    size_t payload_length = 0;
+    uint32_t timestamp = 0;
+  };
+
+  class TrackWorker;
+
+  static constexpr int kTableBits = 7;
+  static constexpr size_t kTableSize = size_t{1} << kTableBits;
+  static_assert(kTableSize >= kMaxTracks * 2, "load factor must stay <= 0.5");
+  static constexpr int8_t kUnknownKind = -1;
+
+  // 路由表项；worker 为空表示该 SSRC 已被忽略
+  struct Route {
+    uint32_t ssrc = 0;
+    bool used = false;
+    TrackWorker* worker = nullptr;
+  };
+
+  static size_t Slot(uint32_t ssrc);
+  Route* FindRoute(uint32_t ssrc);
+  Route* InsertRoute(uint32_t ssrc, TrackWorker* worker);
+
+  Config config_;
+  std::array<Route, kTableSize> routes_{};
+  size_t route_count_ = 0;
+  std::array<int8_t, 128> payload_kinds_;
+  std::vector<std::unique_ptr<TrackWorker>> workers_;
+  OnUnknownSsrcCallback on_unknown_ssrc_callback_;
+
+  // 由网络线程写入，GetStats 可在其他线程读取
+  struct AtomicStats {
+    std::atomic<uint64_t> packets_received{0};
+    std::atomic<uint64_t> packets_dispatched{0};
+    std::atomic<uint64_t> packets_invalid{0};
+    std::atomic<uint64_t> packets_unrouted{0};
+    std::atomic<uint64_t> packets_dropped{0};
+    std::atomic<uint64_t> tracks_created{0};
+    std::atomic<uint64_t> dispatch_time_ns{0};
+  };
+  AtomicStats stats_;
+};
+
+}  // namespace zenremote
@@ -8,6 +8,10 @@
 namespace zenremote {
 
 AudioTrack::AudioTrack(const Config& config) : config_(config) {
+  if (config_.ssrc != 0) {
+    ssrc_ = config_.ssrc;
+    return;
+  }
   std::random_device rd;
   std::mt19937 gen(rd());
   std::uniform_int_distribution<uint32_t> dist(1000, 999999);
@@ -30,18 +34,26 @@ Result<void> AudioTrack::SendFrame(const uint8_t* data,
   return rtp_sender_->SendAudioPacket(data, length, timestamp_48khz);
 }
 
+void AudioTrack::DeliverFrame(const uint8_t* data,
+                              size_t length,
+                              uint32_t timestamp_48khz) {
+  if (enabled_ && on_frame_callback_) {
+    on_frame_callback_(data, length, timestamp_48khz);
+  }
+}
+
 void AudioTrack::SetConnection(BaseConnection* connection) {
   if (!connection) {
     rtp_sender_.reset();
     return;
   }
 
-  RTPSender::Config rtp_config;
+  rtp::RTPSender::Config rtp_config;
   rtp_config.ssrc = ssrc_;
-  rtp_config.payload_type = 97;
+  rtp_config.payload_type = kPayloadType;
   rtp_config.clock_rate = config_.clock_rate;
 
-  rtp_sender_ = std::make_unique<RTPSender>(connection, rtp_config);
+  rtp_sender_ = std::make_unique<rtp::RTPSender>(connection, rtp_config);
 }
 
 }  // namespace zenremote
\ No newline at end of file
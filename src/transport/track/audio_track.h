@@ -16,8 +16,11 @@ class AudioTrack : public MediaTrack {
     uint32_t sample_rate = 48000;
     uint32_t clock_rate = 48000;
     uint32_t channels = 2;
+    uint32_t ssrc = 0;  ///< 0 = 随机生成；远端轨道使用对端的 SSRC
   };
 
+  static constexpr uint8_t kPayloadType = 97;
+
   explicit AudioTrack(const Config& config);
   ~AudioTrack() override;
 
@@ -34,10 +37,14 @@ class AudioTrack : public MediaTrack {
     on_frame_callback_ = std::move(callback);
   }
 
+  uint32_t GetSSRC() const override { return ssrc_; }
+  void DeliverFrame(const uint8_t* data,
+                    size_t length,
+                    uint32_t timestamp_48khz) override;
+
   void SetConnection(BaseConnection* connection) override;
 
   const Config& GetConfig() const { return config_; }
-  uint32_t GetSSRC() const { return ssrc_; }
 
  private:
   Config config_;
@@ -45,7 +52,7 @@ class AudioTrack : public MediaTrack {
   uint32_t ssrc_ = 0;
   OnFrameCallback on_frame_callback_;
 
-  std::unique_ptr<RTPSender> rtp_sender_;
+  std::unique_ptr<rtp::RTPSender> rtp_sender_;
 };
 
 }  // namespace zenremote
\ No newline at end of file
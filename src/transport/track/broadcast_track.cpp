@@ -0,0 +1,49 @@
+#include "broadcast_track.h"
+
+#include <utility>
+
+namespace zenremote {
+
+BroadcastTrack::BroadcastTrack(std::string id,
+                               std::shared_ptr<MediaBroadcaster> broadcaster,
+                               std::shared_ptr<MediaBroadcaster::Viewer> viewer)
+    : id_(std::move(id)),
+      broadcaster_(std::move(broadcaster)),
+      viewer_(std::move(viewer)) {}
+
+BroadcastTrack::~BroadcastTrack() {
+  broadcaster_->RemoveViewer(viewer_);
+}
+
+void BroadcastTrack::SetEnabled(bool enabled) {
+  if (enabled_.exchange(enabled) != enabled) {
+    broadcaster_->SetViewerEnabled(*viewer_, enabled);
+  }
+}
+
+Result<void> BroadcastTrack::SendFrame(const uint8_t*, size_t, uint32_t) {
+  return Result<void>::Err(ErrorCode::kInvalidOperation,
+                           "Broadcast tracks are fed by MediaBroadcaster");
+}
+
+void BroadcastTrack::SetConnection(BaseConnection* connection) {
+  broadcaster_->AttachViewer(*viewer_, connection);
+}
+
+void BroadcastTrack::OnRtcpFeedback(const rtp::RtcpFeedback& feedback) {
+  broadcaster_->OnViewerFeedback(*viewer_, feedback);
+}
+
+void BroadcastTrack::SetPacingBitrate(uint32_t bitrate_bps) {
+  broadcaster_->SetViewerPacingBitrate(*viewer_, bitrate_bps);
+}
+
+void BroadcastTrack::SetBandwidthEstimate(uint64_t bitrate_bps) {
+  broadcaster_->SetViewerBandwidthEstimate(*viewer_, bitrate_bps);
+}
+
+MediaBroadcaster::ViewerStats BroadcastTrack::GetStats() const {
+  return broadcaster_->GetViewerStats(*viewer_);
+}
+
+}  // namespace zenremote
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "media_broadcaster.h"
+#include "media_track.h"
+
+namespace zenremote {
+
+/**
+ * @brief MediaBroadcaster 的一个观看者（只发送的视频轨道）
+ *
+ * 由 MediaBroadcaster::CreateTrack 创建并加入观看者的 PeerConnection。
+ * 帧由 MediaBroadcaster::SendFrame 统一送入，本轨道的 SendFrame 返回错误；
+ * PeerConnection 连接后开始接收，首先等待关键帧。重新启用时同样等待关键帧。
+ */
+class BroadcastTrack : public MediaTrack {
+ public:
+  BroadcastTrack(std::string id,
+                 std::shared_ptr<MediaBroadcaster> broadcaster,
+                 std::shared_ptr<MediaBroadcaster::Viewer> viewer);
+  ~BroadcastTrack() override;
+
+  std::string GetId() const override { return id_; }
+  Kind GetKind() const override { return Kind::kVideo; }
+  bool IsEnabled() const override { return enabled_; }
+  void SetEnabled(bool enabled) override;
+
+  Result<void> SendFrame(const uint8_t* data,
+                         size_t length,
+                         uint32_t timestamp_90khz) override;
+
+  void SetOnFrameCallback(OnFrameCallback) override {}
+
+  uint32_t GetSSRC() const override { return broadcaster_->GetSSRC(); }
+  void DeliverFrame(const uint8_t*, size_t, uint32_t) override {}
+
+  void SetConnection(BaseConnection* connection) override;
+  void OnRtcpFeedback(const rtp::RtcpFeedback& feedback) override;
+
+  /// @brief 调整该观看者的发送速率上限（例如按其带宽估计）
+  void SetPacingBitrate(uint32_t bitrate_bps);
+
+  /**
+   * @brief 设置该观看者的带宽估计，用于选择转发的时间层
+   *
+   * 对端的 RTCP REMB 会覆盖此值；0 表示未知，转发全部层。
+   */
+  void SetBandwidthEstimate(uint64_t bitrate_bps);
+
+  MediaBroadcaster::ViewerStats GetStats() const;
+
+ private:
+  std::string id_;
+  std::atomic<bool> enabled_{true};
+  std::shared_ptr<MediaBroadcaster> broadcaster_;
+  std::shared_ptr<MediaBroadcaster::Viewer> viewer_;
+};
+
+}  // namespace zenremote
@@ -0,0 +1,512 @@
+#include "media_broadcaster.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "broadcast_track.h"
+#include "network/connection/base_connection.h"
+#include "network/rtp/frame_marking.h"
+#include "network/rtp/rtcp_feedback.h"
+#include "network/rtp/rtp_packet.h"
+
+namespace zenremote {
+
+namespace {
+
+// 升层前要求带宽估计高出新层累计码率的比例，避免在边界上反复切换
+constexpr double kLayerUpSwitchHeadroom = 1.2;
+
+}  // namespace
+
+MediaBroadcaster::MediaBroadcaster() : MediaBroadcaster(Config{}) {}
+
+MediaBroadcaster::MediaBroadcaster(const Config& config)
+    : config_(config),
+      viewers_(std::make_shared<const std::vector<std::shared_ptr<Viewer>>>()) {
+  if (config_.ssrc != 0) {
+    ssrc_ = config_.ssrc;
+  } else {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<uint32_t> dist(1000, 999999);
+    ssrc_ = dist(gen);
+  }
+  config_.history_size = std::max<size_t>(config_.history_size, 1);
+  config_.pacing_interval_ms =
+      std::max<uint32_t>(config_.pacing_interval_ms, 1);
+  config_.temporal_layers = std::clamp<uint8_t>(config_.temporal_layers, 1,
+                                                kMaxTemporalLayers);
+  config_.layer_rate_window_ms =
+      std::max<uint32_t>(config_.layer_rate_window_ms, 1);
+  history_.resize(config_.history_size);
+
+  pacing_thread_ = std::thread([this]() { PacingLoop(); });
+}
+
+MediaBroadcaster::~MediaBroadcaster() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_one();
+  if (pacing_thread_.joinable()) {
+    pacing_thread_.join();
+  }
+}
+
+std::shared_ptr<BroadcastTrack> MediaBroadcaster::CreateTrack(
+    const std::string& id) {
+  return std::make_shared<BroadcastTrack>(id, shared_from_this(), AddViewer());
+}
+
+Result<void> MediaBroadcaster::SendFrame(const uint8_t* data,
+                                         size_t length,
+                                         uint32_t timestamp,
+                                         bool is_keyframe,
+                                         uint8_t temporal_id) {
+  if (!data || length == 0) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter, "Empty frame");
+  }
+  if (temporal_id >= config_.temporal_layers) {
+    return Result<void>::Err(ErrorCode::kInvalidParameter,
+                             "Temporal layer out of range");
+  }
+  const bool layered = config_.temporal_layers > 1;
+
+  // 与 rtp::RTPSender 相同的报文格式，只打包一次
+  network::RTPHeader header;
+  header.version = 2;
+  header.padding = 0;
+  header.extension = layered ? 1 : 0;
+  header.csrc_count = 0;
+  header.marker = 1;
+  header.payload_type = config_.payload_type;
+  header.sequence_number = sequence_number_++;
+  header.timestamp = timestamp;
+  header.ssrc = ssrc_;
+
+  const size_t header_size =
+      sizeof(network::RTPHeader) +
+      (layered ? rtp::kFrameMarkingExtensionSize : 0);
+  auto packet = std::make_shared<Packet>();
+  packet->sequence_number = header.sequence_number;
+  packet->temporal_id = temporal_id;
+  packet->data.resize(header_size + length);
+  std::memcpy(packet->data.data(), &header, sizeof(network::RTPHeader));
+  if (layered) {
+    if (temporal_id == 0) {
+      ++tl0_pic_index_;
+    }
+    rtp::FrameMarking marking;
+    marking.independent = is_keyframe;
+    marking.discardable = temporal_id + 1 == config_.temporal_layers;
+    // L1T2 / L1T3 中 TL1 只参考 TL0
+    marking.base_layer_sync = temporal_id == 1;
+    marking.temporal_id = temporal_id;
+    marking.tl0_pic_index = tl0_pic_index_;
+    rtp::WriteFrameMarkingExtension(
+        marking, packet->data.data() + sizeof(network::RTPHeader));
+  }
+  std::memcpy(packet->data.data() + header_size, data, length);
+
+  const auto now = Clock::now();
+  std::shared_ptr<const std::vector<std::shared_ptr<Viewer>>> viewers;
+  LayerRates cumulative_rates{};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    history_[packet->sequence_number % history_.size()] = packet;
+    stats_.frames_sent++;
+    if (layered) {
+      layer_window_bytes_[temporal_id] += packet->data.size();
+      const auto window_ms = std::chrono::duration_cast<
+          std::chrono::milliseconds>(now - layer_window_start_);
+      if (window_ms.count() >= config_.layer_rate_window_ms) {
+        for (size_t i = 0; i < kMaxTemporalLayers; ++i) {
+          stats_.layer_bitrate_bps[i] =
+              layer_window_bytes_[i] * 8000 / window_ms.count();
+        }
+        layer_window_bytes_.fill(0);
+        layer_window_start_ = now;
+      }
+      uint64_t sum = 0;
+      for (size_t i = 0; i < kMaxTemporalLayers; ++i) {
+        sum += stats_.layer_bitrate_bps[i];
+        cumulative_rates[i] = sum;
+      }
+    }
+    if (is_keyframe) {
+      // 关键帧满足此前所有观看者的请求
+      last_keyframe_time_ = now;
+      has_keyframe_ = true;
+      keyframe_pending_ = false;
+    }
+    viewers = viewers_;
+  }
+
+  const auto max_queue_delay =
+      std::chrono::milliseconds(config_.max_queue_delay_ms);
+  bool need_keyframe = false;
+  bool queued = false;
+  for (const auto& viewer : *viewers) {
+    std::lock_guard<std::mutex> lock(viewer->mutex);
+    if (!viewer->connection || !viewer->enabled) {
+      continue;
+    }
+    if (!viewer->queue.empty() &&
+        now - viewer->queue.front().enqueue_time > max_queue_delay) {
+      // 积压的增量帧已经过时，直接从下一个关键帧恢复
+      viewer->stats.packets_dropped +=
+          viewer->queue.size() + viewer->retransmissions.size();
+      viewer->queue.clear();
+      viewer->retransmissions.clear();
+      if (!is_keyframe) {
+        viewer->waiting_for_keyframe = true;
+        need_keyframe = true;
+      }
+    }
+    if (layered) {
+      // 降层立即生效；升层等到 TL0，之后的上层帧所参考的帧都已转发
+      const uint8_t target = SelectTemporalLayer(*viewer, cumulative_rates);
+      if (target < viewer->temporal_layer || temporal_id == 0) {
+        viewer->temporal_layer = target;
+      }
+    }
+    if (viewer->waiting_for_keyframe && !is_keyframe) {
+      viewer->stats.packets_dropped++;
+      continue;
+    }
+    viewer->waiting_for_keyframe = false;
+    if (temporal_id > viewer->temporal_layer) {
+      viewer->stats.packets_layer_dropped++;
+      continue;
+    }
+    viewer->queue.push_back({packet, now});
+    queued = true;
+  }
+
+  if (need_keyframe) {
+    RequestKeyFrame();
+  }
+  if (queued) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_pending_ = true;
+    cv_.notify_one();
+  }
+  return Result<void>::Ok();
+}
+
+MediaBroadcaster::Stats MediaBroadcaster::GetStats() const {
+  std::shared_ptr<const std::vector<std::shared_ptr<Viewer>>> viewers;
+  Stats stats;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats = stats_;
+    viewers = viewers_;
+  }
+  stats.viewers = 0;
+  for (const auto& viewer : *viewers) {
+    std::lock_guard<std::mutex> lock(viewer->mutex);
+    if (viewer->connection) {
+      stats.viewers++;
+    }
+  }
+  return stats;
+}
+
+std::shared_ptr<MediaBroadcaster::Viewer> MediaBroadcaster::AddViewer() {
+  auto viewer = std::make_shared<Viewer>();
+  viewer->pacing_bytes_per_ms = config_.pacing_bitrate_bps / 8000.0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto viewers = std::make_shared<std::vector<std::shared_ptr<Viewer>>>(
+      *viewers_);
+  viewers->push_back(viewer);
+  viewers_ = std::move(viewers);
+  return viewer;
+}
+
+void MediaBroadcaster::RemoveViewer(const std::shared_ptr<Viewer>& viewer) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto viewers = std::make_shared<std::vector<std::shared_ptr<Viewer>>>(
+        *viewers_);
+    viewers->erase(std::remove(viewers->begin(), viewers->end(), viewer),
+                   viewers->end());
+    viewers_ = std::move(viewers);
+  }
+  AttachViewer(*viewer, nullptr);
+}
+
+void MediaBroadcaster::AttachViewer(Viewer& viewer,
+                                    BaseConnection* connection) {
+  bool need_keyframe = false;
+  {
+    // 调度线程发送时持有 viewer.mutex，返回后不会再使用旧连接
+    std::lock_guard<std::mutex> lock(viewer.mutex);
+    if (viewer.connection == connection) {
+      return;
+    }
+    viewer.connection = connection;
+    viewer.queue.clear();
+    viewer.retransmissions.clear();
+    viewer.waiting_for_keyframe = true;
+    viewer.budget_bytes =
+        viewer.pacing_bytes_per_ms * config_.pacing_interval_ms;
+    viewer.last_refill = Clock::now();
+    need_keyframe = connection && viewer.enabled;
+  }
+  if (need_keyframe) {
+    RequestKeyFrame();
+  }
+}
+
+void MediaBroadcaster::SetViewerEnabled(Viewer& viewer, bool enabled) {
+  bool need_keyframe = false;
+  {
+    std::lock_guard<std::mutex> lock(viewer.mutex);
+    viewer.enabled = enabled;
+    viewer.queue.clear();
+    viewer.retransmissions.clear();
+    viewer.waiting_for_keyframe = true;
+    need_keyframe = enabled && viewer.connection;
+  }
+  if (need_keyframe) {
+    RequestKeyFrame();
+  }
+}
+
+void MediaBroadcaster::SetViewerPacingBitrate(Viewer& viewer,
+                                              uint32_t bitrate_bps) {
+  std::lock_guard<std::mutex> lock(viewer.mutex);
+  viewer.pacing_bytes_per_ms = bitrate_bps / 8000.0;
+}
+
+void MediaBroadcaster::SetViewerBandwidthEstimate(Viewer& viewer,
+                                                  uint64_t bitrate_bps) {
+  std::lock_guard<std::mutex> lock(viewer.mutex);
+  viewer.bandwidth_estimate_bps = bitrate_bps;
+}
+
+void MediaBroadcaster::OnViewerFeedback(Viewer& viewer,
+                                        const rtp::RtcpFeedback& feedback) {
+  if (feedback.type == rtp::RtcpFeedback::Type::kRemb) {
+    SetViewerBandwidthEstimate(viewer, feedback.bitrate_bps);
+    return;
+  }
+  if (feedback.type == rtp::RtcpFeedback::Type::kPli) {
+    {
+      std::lock_guard<std::mutex> lock(viewer.mutex);
+      viewer.stats.keyframe_requests++;
+      if (!viewer.connection || !viewer.enabled) {
+        return;
+      }
+    }
+    RequestKeyFrame();
+    return;
+  }
+
+  std::vector<PacketRef> packets;
+  uint64_t misses = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint16_t sequence : feedback.lost_sequences) {
+      const auto& entry = history_[sequence % history_.size()];
+      if (entry && entry->sequence_number == sequence) {
+        packets.push_back(entry);
+      } else {
+        misses++;
+      }
+    }
+  }
+
+  bool queued = false;
+  {
+    std::lock_guard<std::mutex> lock(viewer.mutex);
+    viewer.stats.nack_misses += misses;
+    if (!viewer.connection || !viewer.enabled) {
+      return;
+    }
+    for (auto& packet : packets) {
+      if (packet->temporal_id > viewer.temporal_layer) {
+        // 该观看者不接收此层，空洞是有意的
+        continue;
+      }
+      // 仍在排队（尚未发出）或已在重传队列中的包不必重复排入
+      const bool pending =
+          std::any_of(viewer.queue.begin(), viewer.queue.end(),
+                      [&](const QueuedPacket& queued_packet) {
+                        return queued_packet.packet == packet;
+                      }) ||
+          std::find(viewer.retransmissions.begin(),
+                    viewer.retransmissions.end(),
+                    packet) != viewer.retransmissions.end();
+      if (!pending) {
+        viewer.retransmissions.push_back(std::move(packet));
+        queued = true;
+      }
+    }
+  }
+
+  if (queued) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_pending_ = true;
+    cv_.notify_one();
+  }
+}
+
+MediaBroadcaster::ViewerStats MediaBroadcaster::GetViewerStats(
+    Viewer& viewer) const {
+  std::lock_guard<std::mutex> lock(viewer.mutex);
+  ViewerStats stats = viewer.stats;
+  stats.bandwidth_estimate_bps = viewer.bandwidth_estimate_bps;
+  stats.temporal_layer = viewer.temporal_layer;
+  return stats;
+}
+
+uint8_t MediaBroadcaster::SelectTemporalLayer(
+    const Viewer& viewer,
+    const LayerRates& cumulative_rates) const {
+  const uint8_t top = config_.temporal_layers - 1;
+  if (viewer.bandwidth_estimate_bps == 0) {
+    return top;
+  }
+  const auto estimate = static_cast<double>(viewer.bandwidth_estimate_bps);
+  uint8_t layer = std::min(viewer.temporal_layer, top);
+  while (layer > 0 && cumulative_rates[layer] > estimate) {
+    --layer;
+  }
+  while (layer < top && cumulative_rates[layer + 1] * kLayerUpSwitchHeadroom <=
+                            estimate) {
+    ++layer;
+  }
+  return layer;
+}
+
+void MediaBroadcaster::RequestKeyFrame() {
+  bool forward = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.keyframe_requests++;
+    const auto now = Clock::now();
+    if (now >= NextKeyFrameTimeLocked()) {
+      ForwardKeyFrameLocked(now);
+      forward = true;
+    } else if (!keyframe_pending_) {
+      // 由调度线程在间隔到期时转发
+      keyframe_pending_ = true;
+      work_pending_ = true;
+      cv_.notify_one();
+    }
+  }
+  if (forward && on_keyframe_request_callback_) {
+    on_keyframe_request_callback_();
+  }
+}
+
+MediaBroadcaster::Clock::time_point MediaBroadcaster::NextKeyFrameTimeLocked()
+    const {
+  Clock::time_point next{};
+  if (has_keyframe_) {
+    next = std::max(next, last_keyframe_time_);
+  }
+  if (has_keyframe_forward_) {
+    next = std::max(next, last_keyframe_forward_time_);
+  }
+  if (!has_keyframe_ && !has_keyframe_forward_) {
+    return next;
+  }
+  return next + std::chrono::milliseconds(config_.min_keyframe_interval_ms);
+}
+
+void MediaBroadcaster::ForwardKeyFrameLocked(Clock::time_point now) {
+  last_keyframe_forward_time_ = now;
+  has_keyframe_forward_ = true;
+  keyframe_pending_ = false;
+  stats_.keyframes_requested++;
+}
+
+bool MediaBroadcaster::DrainViewer(Viewer& viewer, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(viewer.mutex);
+  if (!viewer.connection) {
+    return false;
+  }
+
+  const double elapsed_ms =
+      std::chrono::duration<double, std::milli>(now - viewer.last_refill)
+          .count();
+  viewer.last_refill = now;
+  viewer.budget_bytes +=
+      std::max(elapsed_ms, 0.0) * viewer.pacing_bytes_per_ms;
+  if (viewer.queue.empty() && viewer.retransmissions.empty()) {
+    // 空闲时最多积累一个调度周期的额度，避免下一帧突发
+    viewer.budget_bytes =
+        std::min(viewer.budget_bytes,
+                 viewer.pacing_bytes_per_ms * config_.pacing_interval_ms);
+    return false;
+  }
+
+  // 额度为正即可发送，大包允许透支，由后续周期偿还
+  while (viewer.budget_bytes > 0) {
+    PacketRef packet;
+    if (!viewer.retransmissions.empty()) {
+      packet = std::move(viewer.retransmissions.front());
+      viewer.retransmissions.pop_front();
+      viewer.stats.packets_retransmitted++;
+    } else if (!viewer.queue.empty()) {
+      packet = std::move(viewer.queue.front().packet);
+      viewer.queue.pop_front();
+    } else {
+      break;
+    }
+
+    auto result = viewer.connection->Send(packet->data.data(),
+                                          packet->data.size());
+    if (result.IsErr()) {
+      viewer.stats.send_errors++;
+    } else {
+      viewer.stats.packets_sent++;
+      viewer.stats.bytes_sent += packet->data.size();
+    }
+    viewer.budget_bytes -= static_cast<double>(packet->data.size());
+  }
+  return !viewer.queue.empty() || !viewer.retransmissions.empty();
+}
+
+void MediaBroadcaster::PacingLoop() {
+  const auto interval = std::chrono::milliseconds(config_.pacing_interval_ms);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    const auto now = Clock::now();
+    bool forward = false;
+    if (keyframe_pending_ && now >= NextKeyFrameTimeLocked()) {
+      ForwardKeyFrameLocked(now);
+      forward = true;
+    }
+    auto viewers = viewers_;
+    work_pending_ = false;
+    lock.unlock();
+
+    if (forward && on_keyframe_request_callback_) {
+      on_keyframe_request_callback_();
+    }
+    bool backlog = false;
+    for (const auto& viewer : *viewers) {
+      backlog = DrainViewer(*viewer, now) || backlog;
+    }
+    viewers.reset();
+
+    lock.lock();
+    if (!running_ || work_pending_) {
+      continue;
+    }
+    if (backlog) {
+      cv_.wait_for(lock, interval);
+    } else if (keyframe_pending_) {
+      cv_.wait_until(lock, NextKeyFrameTimeLocked());
+    } else {
+      cv_.wait(lock, [this]() { return work_pending_ || !running_; });
+    }
+  }
+}
+
+}  // namespace zenremote
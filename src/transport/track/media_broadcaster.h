@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/error.h"
+#include "transport/track/video_track.h"
+
+namespace zenremote {
+
+class BaseConnection;
+class BroadcastTrack;
+
+namespace rtp {
+struct RtcpFeedback;
+}  // namespace rtp
+
+/**
+ * @brief 一路采集编码、分发给多个观看者
+ *
+ * 每帧只打包一次，RTP 包是所有观看者共享的只读引用计数缓冲区，增加一个观看者
+ * 只增加一次入队与一次发送，不增加采集、编码、打包或拷贝：
+ * - 每个观看者一个 BroadcastTrack，加入各自的 PeerConnection；所有观看者使用
+ *   同一 SSRC 与序列号空间
+ * - 发送节奏：一个调度线程为每个观看者维护独立的令牌桶，慢速观看者不拖累
+ *   其他人；排队超过 max_queue_delay_ms 时丢弃积压，直到下一个关键帧
+ * - 重传：共享的发送历史按序列号索引，NACK 只把历史包重新排入该观看者的
+ *   队列（优先于新包），报文本身不复制
+ * - 关键帧仲裁：新观看者加入、PLI、积压丢弃都会请求关键帧；两次转发给编码器
+ *   的间隔不小于 min_keyframe_interval_ms，期间的请求合并，由下一个关键帧
+ *   一并满足
+ * - 时间分层：temporal_layers 大于 1 时每个包携带帧标记扩展
+ *   （rtp::FrameMarking）；按各层的实测码率与观看者的带宽估计（REMB 或
+ *   BroadcastTrack::SetBandwidthEstimate）选择转发的最高层。降层立即生效，
+ *   升层在下一个 TL0 帧生效。序列号不按观看者重写，丢弃的层在接收端表现为
+ *   序列号空洞，对应的 NACK 被忽略
+ *
+ * 必须由 std::make_shared 创建（轨道持有 MediaBroadcaster 的引用）。
+ * SendFrame 在编码线程调用；NACK/PLI 在各 PeerConnection 的接收线程处理。
+ */
+class MediaBroadcaster : public std::enable_shared_from_this<MediaBroadcaster> {
+ public:
+  struct Config {
+    uint32_t ssrc = 0;  ///< 0 = 随机生成
+    uint8_t payload_type = VideoTrack::kPayloadType;
+    /// 观看者默认的发送速率上限（令牌桶），可用 BroadcastTrack 单独调整
+    uint32_t pacing_bitrate_bps = 20000000;
+    uint32_t pacing_interval_ms = 5;
+    /// 观看者队首排队超过此时长即丢弃积压并等待关键帧
+    uint32_t max_queue_delay_ms = 300;
+    size_t history_size = 1024;  ///< 可重传的历史包数
+    uint32_t min_keyframe_interval_ms = 500;
+    /// 时间层数，与编码器的 EncoderConfig::temporal_layers 一致
+    uint8_t temporal_layers = 1;
+    uint32_t layer_rate_window_ms = 1000;  ///< 各层码率的统计窗口
+  };
+
+  static constexpr uint8_t kMaxTemporalLayers = 3;
+
+  struct Stats {
+    uint64_t frames_sent = 0;
+    uint64_t keyframe_requests = 0;    ///< 收到的请求（加入、PLI、积压丢弃）
+    uint64_t keyframes_requested = 0;  ///< 转发给编码器的请求
+    size_t viewers = 0;                ///< 已连接的观看者
+    /// 各时间层在上一个统计窗口的码率（不含其他层）
+    std::array<uint64_t, kMaxTemporalLayers> layer_bitrate_bps{};
+  };
+
+  struct ViewerStats {
+    uint64_t packets_sent = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t packets_retransmitted = 0;
+    uint64_t nack_misses = 0;       ///< 请求重传但已不在历史中的包
+    uint64_t packets_dropped = 0;   ///< 积压丢弃或等待关键帧期间跳过的包
+    uint64_t send_errors = 0;
+    uint64_t keyframe_requests = 0;  ///< 该观看者发来的 PLI
+    uint64_t packets_layer_dropped = 0;  ///< 超出带宽估计而不转发的高层包
+    uint64_t bandwidth_estimate_bps = 0;  ///< 0 = 未知，转发全部层
+    uint8_t temporal_layer = 0;           ///< 当前转发的最高 TID
+  };
+
+  /// @brief 请求编码器尽快输出关键帧；可能在任意线程调用，不应阻塞
+  using OnKeyFrameRequestCallback = std::function<void()>;
+
+  MediaBroadcaster();
+  explicit MediaBroadcaster(const Config& config);
+  ~MediaBroadcaster();
+
+  MediaBroadcaster(const MediaBroadcaster&) = delete;
+  MediaBroadcaster& operator=(const MediaBroadcaster&) = delete;
+
+  /// @brief 新观看者的轨道，加入其 PeerConnection 后开始接收
+  std::shared_ptr<BroadcastTrack> CreateTrack(const std::string& id);
+
+  /// @brief 在创建轨道之前设置
+  void SetOnKeyFrameRequestCallback(OnKeyFrameRequestCallback callback) {
+    on_keyframe_request_callback_ = std::move(callback);
+  }
+
+  /**
+   * @brief 打包一帧并排入所有观看者的发送队列（不等待发送完成）
+   *
+   * 同一时刻只能由一个线程调用（编码线程）。
+   * @param is_keyframe 关键帧满足所有等待中的关键帧请求
+   * @param temporal_id 编码器输出的时间层（EncodedPacket::temporal_id），
+   *        须小于 Config::temporal_layers
+   */
+  Result<void> SendFrame(const uint8_t* data,
+                         size_t length,
+                         uint32_t timestamp,
+                         bool is_keyframe,
+                         uint8_t temporal_id = 0);
+
+  uint32_t GetSSRC() const { return ssrc_; }
+  const Config& GetConfig() const { return config_; }
+  Stats GetStats() const;
+
+ private:
+  friend class BroadcastTrack;
+
+  using Clock = std::chrono::steady_clock;
+
+  // 打包后的 RTP 包，创建后只读，由历史与各观看者队列共享
+  struct Packet {
+    std::vector<uint8_t> data;
+    uint16_t sequence_number = 0;
+    uint8_t temporal_id = 0;
+  };
+  using LayerRates = std::array<uint64_t, kMaxTemporalLayers>;
+  using PacketRef = std::shared_ptr<const Packet>;
+
+  struct QueuedPacket {
+    PacketRef packet;
+    Clock::time_point enqueue_time;
+  };
+
+  struct Viewer {
+    std::mutex mutex;
+    BaseConnection* connection = nullptr;
+    bool enabled = true;
+    bool waiting_for_keyframe = true;
+    std::deque<QueuedPacket> queue;
+    std::deque<PacketRef> retransmissions;
+    uint64_t bandwidth_estimate_bps = 0;
+    uint8_t temporal_layer = 0;
+    double pacing_bytes_per_ms = 0;
+    double budget_bytes = 0;
+    Clock::time_point last_refill;
+    ViewerStats stats;
+  };
+
+  // 由 BroadcastTrack 调用
+  std::shared_ptr<Viewer> AddViewer();
+  void RemoveViewer(const std::shared_ptr<Viewer>& viewer);
+  void AttachViewer(Viewer& viewer, BaseConnection* connection);
+  void SetViewerEnabled(Viewer& viewer, bool enabled);
+  void SetViewerPacingBitrate(Viewer& viewer, uint32_t bitrate_bps);
+  void SetViewerBandwidthEstimate(Viewer& viewer, uint64_t bitrate_bps);
+  void OnViewerFeedback(Viewer& viewer, const rtp::RtcpFeedback& feedback);
+  ViewerStats GetViewerStats(Viewer& viewer) const;
+
+  /**
+   * @brief 按带宽估计选择观看者转发的最高时间层
+   * @param cumulative_rates 第 i 项为 TID 0..i 的码率之和
+   */
+  uint8_t SelectTemporalLayer(const Viewer& viewer,
+                              const LayerRates& cumulative_rates) const;
+
+  /// @brief 观看者需要关键帧；按最小间隔转发或合并
+  void RequestKeyFrame();
+  /// @brief 最早可以再次转发关键帧请求的时刻
+  Clock::time_point NextKeyFrameTimeLocked() const;
+  /// @brief 登记一次转发，调用方在锁外执行回调
+  void ForwardKeyFrameLocked(Clock::time_point now);
+
+  /// @brief 按令牌桶发送一个观看者的队列，返回是否仍有积压
+  bool DrainViewer(Viewer& viewer, Clock::time_point now);
+  void PacingLoop();
+
+  Config config_;
+  uint32_t ssrc_ = 0;
+  OnKeyFrameRequestCallback on_keyframe_request_callback_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  // 写时复制：SendFrame / 调度线程只拷贝一次 shared_ptr
+  std::shared_ptr<const std::vector<std::shared_ptr<Viewer>>> viewers_;
+  std::vector<PacketRef> history_;  ///< 按 序列号 % history_size 索引
+  uint16_t sequence_number_ = 0;
+  uint8_t tl0_pic_index_ = 0;
+  LayerRates layer_window_bytes_{};
+  Clock::time_point layer_window_start_{};
+  Clock::time_point last_keyframe_time_{};
+  Clock::time_point last_keyframe_forward_time_{};
+  bool has_keyframe_ = false;
+  bool has_keyframe_forward_ = false;
+  bool keyframe_pending_ = false;
+  bool work_pending_ = false;
+  bool running_ = true;
+  Stats stats_;
+
+  std::thread pacing_thread_;
+};
+
+}  // namespace zenremote
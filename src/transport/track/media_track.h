@@ -11,6 +11,10 @@
 
 namespace zenremote {
 
+namespace rtp {
+struct RtcpFeedback;
+}  // namespace rtp
+
 /**
  * @brief 媒体轨道抽象
  *
@@ -39,7 +43,26 @@ class MediaTrack {
       void(const uint8_t* data, size_t length, uint32_t timestamp)>;
   virtual void SetOnFrameCallback(OnFrameCallback callback) = 0;
 
+  /// @brief RTP 同步源标识；远端轨道为对端发送时使用的 SSRC
+  virtual uint32_t GetSSRC() const = 0;
+
+  /**
+   * @brief 交付一帧收到的媒体数据，触发 OnFrameCallback
+   *
+   * 由 PeerConnection 在该轨道的接收处理线程调用（不是网络线程）。
+   */
+  virtual void DeliverFrame(const uint8_t* data,
+                            size_t length,
+                            uint32_t timestamp) = 0;
+
   virtual void SetConnection(BaseConnection* connection) = 0;
+
+  /**
+   * @brief 对端针对本轨道 SSRC 发来的 NACK / PLI
+   *
+   * 由 PeerConnection 在网络接收线程调用；默认忽略。
+   */
+  virtual void OnRtcpFeedback(const rtp::RtcpFeedback& /*feedback*/) {}
 };
 
 }  // namespace zenremote
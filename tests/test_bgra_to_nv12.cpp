@@ -0,0 +1,328 @@
+/**
+ * @file test_bgra_to_nv12.cpp
+ * @brief BgraToNv12 向量化色彩转换测试
+ *
+ * 测试目标：
+ * - 各向量实现与标量实现逐位相同（含非整块宽度、奇数宽高）
+ * - 结果与 BT.709 浮点公式相差不超过 1
+ * - 按矩形转换只写外扩后的色度块，多矩形增量更新与整帧转换一致
+ * - 按条带并行的结果与单线程相同
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "common/slice_pool.h"
+#include "media/codec/encoder/bgra_to_nv12.h"
+
+namespace zenremote {
+
+namespace {
+
+using Isa = BgraToNv12::Isa;
+
+const Isa kVectorIsas[] = {Isa::kSse41, Isa::kAvx2, Isa::kAvx512};
+
+struct Nv12Image {
+  Nv12Image(int w, int h)
+      : width(w),
+        height(h),
+        uv_stride((w + 1) & ~1),
+        y(static_cast<size_t>(w) * h, 0xAA),
+        uv(static_cast<size_t>(uv_stride) * ((h + 1) / 2), 0xAA) {}
+
+  int width;
+  int height;
+  int uv_stride;
+  std::vector<uint8_t> y;
+  std::vector<uint8_t> uv;
+};
+
+std::vector<uint8_t> RandomBgra(int width, int height, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+  for (auto& byte : pixels) {
+    byte = static_cast<uint8_t>(rng());
+  }
+  return pixels;
+}
+
+void ConvertFull(const BgraToNv12& converter,
+                 const std::vector<uint8_t>& bgra,
+                 Nv12Image& image) {
+  converter.Convert(bgra.data(), image.width * 4, image.width, image.height,
+                    image.y.data(), image.width, image.uv.data(),
+                    image.uv_stride);
+}
+
+}  // namespace
+
+TEST(BgraToNv12Test, VectorImplementationsMatchScalar) {
+  const int sizes[][2] = {{1920, 8}, {67, 35}, {33, 2}, {16, 1}, {1, 1}};
+  for (bool full_range : {true, false}) {
+    const BgraToNv12 scalar(full_range, Isa::kScalar);
+    for (const auto& size : sizes) {
+      const auto bgra = RandomBgra(size[0], size[1], 42);
+      Nv12Image expected(size[0], size[1]);
+      ConvertFull(scalar, bgra, expected);
+
+      for (Isa isa : kVectorIsas) {
+        if (!BgraToNv12::IsaAvailable(isa)) {
+          continue;
+        }
+        const BgraToNv12 vector(full_range, isa);
+        ASSERT_EQ(vector.GetIsa(), isa);
+        Nv12Image actual(size[0], size[1]);
+        ConvertFull(vector, bgra, actual);
+        EXPECT_EQ(actual.y, expected.y)
+            << BgraToNv12::IsaName(isa) << " " << size[0] << "x" << size[1];
+        EXPECT_EQ(actual.uv, expected.uv)
+            << BgraToNv12::IsaName(isa) << " " << size[0] << "x" << size[1];
+      }
+    }
+  }
+}
+
+TEST(BgraToNv12Test, MatchesBt709Formula) {
+  std::mt19937 rng(7);
+  for (bool full_range : {true, false}) {
+    const BgraToNv12 converter(full_range);
+    const double y_scale = full_range ? 255.0 : 219.0;
+    const double uv_scale = full_range ? 255.0 : 224.0;
+    const double y_offset = full_range ? 0.0 : 16.0;
+    for (int i = 0; i < 1000; ++i) {
+      const int b = static_cast<int>(rng() % 256);
+      const int g = static_cast<int>(rng() % 256);
+      const int r = static_cast<int>(rng() % 256);
+      // 2x2 纯色块
+      std::vector<uint8_t> bgra;
+      for (int p = 0; p < 4; ++p) {
+        bgra.insert(bgra.end(), {static_cast<uint8_t>(b),
+                                 static_cast<uint8_t>(g),
+                                 static_cast<uint8_t>(r), 255});
+      }
+      Nv12Image image(2, 2);
+      ConvertFull(converter, bgra, image);
+
+      const double luma = (0.2126 * r + 0.7152 * g + 0.0722 * b) / 255.0;
+      const double cb = (b / 255.0 - luma) / 1.8556;
+      const double cr = (r / 255.0 - luma) / 1.5748;
+      const double expected_y = luma * y_scale + y_offset;
+      const double expected_u = std::min(cb * uv_scale + 128.0, 255.0);
+      const double expected_v = std::min(cr * uv_scale + 128.0, 255.0);
+      EXPECT_NEAR(image.y[0], expected_y, 1.0);
+      EXPECT_NEAR(image.uv[0], expected_u, 1.0);
+      EXPECT_NEAR(image.uv[1], expected_v, 1.0);
+    }
+  }
+
+  // 白色与黑色的边界值
+  const BgraToNv12 limited(false);
+  Nv12Image white(2, 2);
+  ConvertFull(limited, std::vector<uint8_t>(16, 255), white);
+  EXPECT_EQ(white.y[0], 235);
+  EXPECT_EQ(white.uv[0], 128);
+  Nv12Image black(2, 2);
+  ConvertFull(limited, std::vector<uint8_t>(16, 0), black);
+  EXPECT_EQ(black.y[0], 16);
+  EXPECT_EQ(black.uv[1], 128);
+}
+
+TEST(BgraToNv12Test, RectWritesOnlyAlignedChromaBlocks) {
+  const int width = 64;
+  const int height = 32;
+  const auto bgra = RandomBgra(width, height, 3);
+  const BgraToNv12 converter(true);
+  Nv12Image full(width, height);
+  ConvertFull(converter, bgra, full);
+
+  // [5, 3) - (41, 18) 外扩为 [4, 2) - (42, 18)
+  Nv12Image rect(width, height);
+  converter.ConvertRect(bgra.data(), width * 4, width, height, 5, 3, 41, 18,
+                        rect.y.data(), width, rect.uv.data(), rect.uv_stride);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const size_t index = static_cast<size_t>(y) * width + x;
+      const bool inside = x >= 4 && x < 42 && y >= 2 && y < 18;
+      EXPECT_EQ(rect.y[index], inside ? full.y[index] : 0xAA)
+          << x << "," << y;
+    }
+  }
+  for (int y = 0; y < height / 2; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const size_t index = static_cast<size_t>(y) * rect.uv_stride + x;
+      const bool inside = x >= 4 && x < 42 && y >= 1 && y < 9;
+      EXPECT_EQ(rect.uv[index], inside ? full.uv[index] : 0xAA)
+          << x << "," << y;
+    }
+  }
+
+  // 越界矩形裁剪到帧内，空矩形不写
+  Nv12Image clipped(width, height);
+  converter.ConvertRect(bgra.data(), width * 4, width, height, -10, -10, 3, 1,
+                        clipped.y.data(), width, clipped.uv.data(),
+                        clipped.uv_stride);
+  EXPECT_EQ(clipped.y[0], full.y[0]);
+  EXPECT_EQ(clipped.y[width * 2], 0xAA);
+  converter.ConvertRect(bgra.data(), width * 4, width, height, 10, 10, 10, 20,
+                        clipped.y.data(), width, clipped.uv.data(),
+                        clipped.uv_stride);
+  EXPECT_EQ(clipped.y[10 * width + 10], 0xAA);
+}
+
+TEST(BgraToNv12Test, IncrementalRectsMatchFullConversion) {
+  const int width = 101;  // 奇数宽高，最后一列/行单独组成色度块
+  const int height = 57;
+  auto bgra = RandomBgra(width, height, 11);
+  const BgraToNv12 converter(false);
+  Nv12Image incremental(width, height);
+  ConvertFull(converter, bgra, incremental);
+
+  // 修改几个矩形（其中一个贴着右下角），只转换这些矩形
+  const int rects[][4] = {{3, 7, 40, 9}, {60, 20, 101, 57}, {0, 0, 1, 1}};
+  std::mt19937 rng(5);
+  for (const auto& rect : rects) {
+    for (int y = rect[1]; y < rect[3]; ++y) {
+      for (int x = rect[0]; x < rect[2]; ++x) {
+        for (int c = 0; c < 4; ++c) {
+          bgra[(static_cast<size_t>(y) * width + x) * 4 + c] =
+              static_cast<uint8_t>(rng());
+        }
+      }
+    }
+  }
+  for (const auto& rect : rects) {
+    converter.ConvertRect(bgra.data(), width * 4, width, height, rect[0],
+                          rect[1], rect[2], rect[3], incremental.y.data(),
+                          width, incremental.uv.data(), incremental.uv_stride);
+  }
+
+  Nv12Image full(width, height);
+  ConvertFull(converter, bgra, full);
+  EXPECT_EQ(incremental.y, full.y);
+  EXPECT_EQ(incremental.uv, full.uv);
+}
+
+TEST(BgraToNv12Test, ParallelBandsMatchSingleThread) {
+  const int width = 1001;
+  const int height = 603;
+  const auto bgra = RandomBgra(width, height, 9);
+  const BgraToNv12 converter(true);
+  SlicePool pool(3);
+
+  Nv12Image expected(width, height);
+  ConvertFull(converter, bgra, expected);
+  Nv12Image actual(width, height);
+  converter.Convert(bgra.data(), width * 4, width, height, actual.y.data(),
+                    width, actual.uv.data(), actual.uv_stride, &pool);
+  EXPECT_EQ(actual.y, expected.y);
+  EXPECT_EQ(actual.uv, expected.uv);
+
+  // 奇数边界、相互重叠、跨越多个条带的矩形
+  const std::vector<media::capture::DirtyRect> rects = {
+      {1, 3, 999, 401}, {500, 200, 1001, 603}, {7, 590, 9, 603}};
+  Nv12Image serial(width, height);
+  Nv12Image parallel(width, height);
+  converter.ConvertRects(bgra.data(), width * 4, width, height, rects,
+                         serial.y.data(), width, serial.uv.data(),
+                         serial.uv_stride);
+  converter.ConvertRects(bgra.data(), width * 4, width, height, rects,
+                         parallel.y.data(), width, parallel.uv.data(),
+                         parallel.uv_stride, &pool);
+  EXPECT_EQ(parallel.y, serial.y);
+  EXPECT_EQ(parallel.uv, serial.uv);
+}
+
+TEST(BgraToNv12Test, DISABLED_BenchmarkFullFrameAndDirtyRects) {
+  const int width = 1920;
+  const int height = 1080;
+  const auto bgra = RandomBgra(width, height, 1);
+  Nv12Image image(width, height);
+  constexpr int kIterations = 100;
+
+  auto measure = [&](const BgraToNv12& converter, int rect_width,
+                     int rect_height) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+      converter.ConvertRect(bgra.data(), width * 4, width, height, 100, 100,
+                            100 + rect_width, 100 + rect_height,
+                            image.y.data(), width, image.uv.data(),
+                            image.uv_stride);
+    }
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           kIterations;
+  };
+
+  for (Isa isa : {Isa::kScalar, Isa::kSse41, Isa::kAvx2, Isa::kAvx512}) {
+    if (!BgraToNv12::IsaAvailable(isa)) {
+      continue;
+    }
+    const BgraToNv12 converter(true, isa);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+      ConvertFull(converter, bgra, image);
+    }
+    const double full_us = std::chrono::duration<double, std::micro>(
+                               std::chrono::steady_clock::now() - start)
+                               .count() /
+                           kIterations;
+    std::cout << "[ BENCH    ] " << BgraToNv12::IsaName(isa)
+              << " 1920x1080 full frame: " << full_us << " us ("
+              << width * height / full_us << " Mpixel/s)" << std::endl;
+  }
+
+  // 文本光标、1%、10%、50% 脏区域（单个矩形）
+  const BgraToNv12 best(true);
+  const int dirty[][2] = {{200, 30}, {192, 108}, {608, 341}, {1358, 764}};
+  for (const auto& rect : dirty) {
+    const double us = measure(best, rect[0], rect[1]);
+    std::cout << "[ BENCH    ] " << BgraToNv12::IsaName(best.GetIsa())
+              << " dirty " << rect[0] << "x" << rect[1] << " ("
+              << 100.0 * rect[0] * rect[1] / (width * height)
+              << "%): " << us << " us" << std::endl;
+  }
+}
+
+TEST(BgraToNv12Test, DISABLED_BenchmarkSliceParallel) {
+  const int resolutions[][2] = {
+      {1920, 1080}, {2560, 1440}, {3840, 2160}, {5120, 2880}};
+  const BgraToNv12 converter(true);
+  const size_t max_threads =
+      std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  constexpr int kIterations = 30;
+
+  for (const auto& resolution : resolutions) {
+    const int width = resolution[0];
+    const int height = resolution[1];
+    const auto bgra = RandomBgra(width, height, 2);
+    Nv12Image image(width, height);
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+      SlicePool pool(threads);
+      const auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < kIterations; ++i) {
+        converter.Convert(bgra.data(), width * 4, width, height,
+                          image.y.data(), width, image.uv.data(),
+                          image.uv_stride, &pool);
+      }
+      const double ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count() /
+                        kIterations;
+      std::cout << "[ BENCH    ] " << BgraToNv12::IsaName(converter.GetIsa())
+                << " " << width << "x" << height << " " << threads
+                << " thread(s): " << ms << " ms" << std::endl;
+    }
+  }
+}
+
+}  // namespace zenremote
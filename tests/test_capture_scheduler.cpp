@@ -0,0 +1,156 @@
+/**
+ * @file test_capture_scheduler.cpp
+ * @brief CaptureScheduler 按画面变化调度采集的测试
+ *
+ * 测试目标：
+ * - 有变化的帧全帧率送出，静止帧丢弃且采集间隔加倍到上限
+ * - 出现变化或输入活动时立即恢复全帧率
+ * - 静止期间按保活间隔送出帧；关闭跳过时每帧都送出
+ * - 有效帧率反映实际送出的帧
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "media/pipeline/capture_scheduler.h"
+
+namespace zenremote {
+
+namespace {
+
+using Clock = CaptureScheduler::Clock;
+using std::chrono::milliseconds;
+using Decision = CaptureScheduler::Decision;
+
+CaptureSchedulerConfig MakeConfig() {
+  CaptureSchedulerConfig config;
+  config.framerate = 50;  // 20ms
+  config.idle_interval = milliseconds(100);
+  config.keepalive_interval = milliseconds(1000);
+  return config;
+}
+
+}  // namespace
+
+TEST(CaptureSchedulerTest, StaticFramesSkipAndBackOff) {
+  CaptureScheduler scheduler(MakeConfig());
+  const auto t0 = Clock::time_point() + std::chrono::hours(1);
+  scheduler.Reset(t0);
+  EXPECT_EQ(scheduler.GetNextCaptureTime(), t0);
+
+  auto now = t0;
+  EXPECT_EQ(scheduler.OnFrame(true, now), Decision::kForward);
+  EXPECT_EQ(scheduler.GetInterval(), milliseconds(20));
+  EXPECT_EQ(scheduler.GetNextCaptureTime(), t0 + milliseconds(20));
+
+  // 20 → 40 → 80 → 100（上限）
+  const milliseconds expected[] = {milliseconds(40), milliseconds(80),
+                                   milliseconds(100), milliseconds(100)};
+  for (const auto interval : expected) {
+    now = scheduler.GetNextCaptureTime();
+    EXPECT_EQ(scheduler.OnFrame(false, now), Decision::kSkip);
+    EXPECT_EQ(scheduler.GetInterval(), interval);
+    EXPECT_EQ(scheduler.GetNextCaptureTime(), now + interval);
+  }
+
+  // 采集器超时同样退避
+  scheduler.OnFrame(true, now);
+  scheduler.OnNoFrame(now);
+  EXPECT_EQ(scheduler.GetInterval(), milliseconds(40));
+}
+
+TEST(CaptureSchedulerTest, DamageAndActivityRestoreFullRate) {
+  CaptureScheduler scheduler(MakeConfig());
+  auto now = Clock::time_point() + std::chrono::hours(1);
+  scheduler.Reset(now);
+  for (int i = 0; i < 5; ++i) {
+    scheduler.OnFrame(false, now);
+    now = scheduler.GetNextCaptureTime();
+  }
+  ASSERT_EQ(scheduler.GetInterval(), milliseconds(100));
+
+  // 输入活动：不等退避后的采集时刻
+  const auto activity = now - milliseconds(90);
+  scheduler.OnActivity(activity);
+  EXPECT_EQ(scheduler.GetNextCaptureTime(), activity);
+  EXPECT_EQ(scheduler.GetInterval(), milliseconds(20));
+
+  // 静止后的第一帧变化立即恢复全帧率
+  scheduler.OnFrame(false, now);
+  now = scheduler.GetNextCaptureTime();
+  scheduler.OnFrame(false, now);
+  EXPECT_GT(scheduler.GetInterval(), milliseconds(20));
+  now = scheduler.GetNextCaptureTime();
+  EXPECT_EQ(scheduler.OnFrame(true, now), Decision::kForward);
+  EXPECT_EQ(scheduler.GetNextCaptureTime(), now + milliseconds(20));
+}
+
+TEST(CaptureSchedulerTest, KeepAliveWhileStatic) {
+  CaptureScheduler scheduler(MakeConfig());
+  auto now = Clock::time_point() + std::chrono::hours(1);
+  scheduler.Reset(now);
+  scheduler.OnFrame(true, now);
+
+  int keepalive = 0;
+  int skipped = 0;
+  const auto end = now + std::chrono::seconds(10);
+  while (now < end) {
+    now = scheduler.GetNextCaptureTime();
+    const auto decision = scheduler.OnFrame(false, now);
+    keepalive += decision == Decision::kKeepAlive;
+    skipped += decision == Decision::kSkip;
+  }
+  EXPECT_EQ(keepalive, 10);
+  // 退避后每秒约 10 次采集
+  EXPECT_GT(skipped, 80);
+  EXPECT_LT(skipped, 100);
+  EXPECT_NEAR(scheduler.GetEffectiveFps(), 1.0, 0.2);
+
+  auto config = MakeConfig();
+  config.keepalive_interval = milliseconds(0);
+  CaptureScheduler no_keepalive(config);
+  now = Clock::time_point() + std::chrono::hours(1);
+  no_keepalive.Reset(now);
+  for (int i = 0; i < 200; ++i) {
+    now += milliseconds(100);
+    EXPECT_EQ(no_keepalive.OnFrame(false, now), Decision::kSkip);
+  }
+}
+
+TEST(CaptureSchedulerTest, SkipDisabledForwardsEveryFrame) {
+  auto config = MakeConfig();
+  config.skip_static_frames = false;
+  CaptureScheduler scheduler(config);
+  auto now = Clock::time_point() + std::chrono::hours(1);
+  scheduler.Reset(now);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(scheduler.OnFrame(false, now), Decision::kForward);
+    EXPECT_EQ(scheduler.GetInterval(), milliseconds(20));
+    now = scheduler.GetNextCaptureTime();
+  }
+  EXPECT_NEAR(scheduler.GetEffectiveFps(), 50.0, 1.0);
+}
+
+TEST(CaptureSchedulerTest, OfficeTraceForwardsFewFrames) {
+  // 办公桌面：每 5 秒中有 1 秒在打字/滚动（每帧都有变化），其余静止
+  CaptureScheduler scheduler(MakeConfig());
+  auto now = Clock::time_point() + std::chrono::hours(1);
+  const auto start = now;
+  scheduler.Reset(now);
+  int forwarded = 0;
+  int captured = 0;
+  while (now - start < std::chrono::seconds(60)) {
+    const auto phase = (now - start) % std::chrono::seconds(5);
+    const bool active = phase < std::chrono::seconds(1);
+    forwarded += scheduler.OnFrame(active, now) != Decision::kSkip;
+    ++captured;
+    now = scheduler.GetNextCaptureTime();
+  }
+  // 固定 50fps 时需要处理 3000 帧
+  EXPECT_LT(forwarded, 3000 / 2);
+  EXPECT_GT(forwarded, 500);
+  EXPECT_LT(captured, 3000 / 2);
+}
+
+}  // namespace zenremote
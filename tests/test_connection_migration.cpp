@@ -0,0 +1,360 @@
+/**
+ * @file test_connection_migration.cpp
+ * @brief 直连迁移测试（本机 UDP 回环，127.0.0.1 -> 127.0.0.2 模拟换网卡）
+ *
+ * 测试目标：
+ * - NetworkMonitor 可打开，Linux 上提供 netlink 事件句柄
+ * - 会话 ID 匹配的探测让对端切换发送地址，迁移期间旧路径的在途报文不丢
+ * - 会话 ID 不匹配的探测被忽略，重传耗尽后放弃新路径、保留旧路径
+ * - 迁移密钥不同（签名无效）的探测被丢弃；从其他地址重放的有效探测只会
+ *   触发路径挑战，不会切换发送地址
+ * - PeerConnection 推流中途换本地地址：帧全部送达，帧间隔没有明显空洞，
+ *   旧 socket 关闭后反方向的数据通道仍可用（对端已切换地址）
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network/connection/direct_connection.h"
+#include "network/connection/network_monitor.h"
+#include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
+#include "transport/peer_connection.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kPortA = 47371;
+constexpr uint16_t kPortB = 47372;
+constexpr uint16_t kForeignPortA = 47373;
+constexpr uint16_t kForeignPortB = 47374;
+constexpr uint16_t kStreamPortA = 47375;
+constexpr uint16_t kStreamPortB = 47376;
+constexpr uint16_t kForgedPortA = 47377;
+constexpr uint16_t kForgedPortB = 47378;
+constexpr uint16_t kReplayPortA = 47379;
+constexpr uint16_t kReplayPortB = 47380;
+constexpr uint32_t kSessionId = 0x5E55104U;
+
+const std::vector<uint8_t> kMigrationKey(32, 0x5A);
+
+std::unique_ptr<DirectConnection> MakeConnection(
+    uint16_t local_port,
+    uint16_t remote_port,
+    uint32_t session_id,
+    const std::vector<uint8_t>& migration_key = kMigrationKey) {
+  DirectConnection::Config config;
+  config.local_ip = "127.0.0.1";
+  config.local_port = local_port;
+  config.remote = {"127.0.0.1", remote_port};
+  config.enable_migration = true;
+  config.session_id = session_id;
+  config.migration_key = migration_key;
+  config.probe_rto_ms = 10;
+  config.max_probe_attempts = 3;
+  config.retire_grace_ms = 50;
+  auto connection = std::make_unique<DirectConnection>();
+  EXPECT_TRUE(connection->Initialize(config).IsOk());
+  return connection;
+}
+
+bool Send(DirectConnection& connection, const std::string& text) {
+  return connection
+      .Send(reinterpret_cast<const uint8_t*>(text.data()), text.size())
+      .IsOk();
+}
+
+/**
+ * @brief 单线程轮流驱动两端的定时器与接收，直到 done() 或超时
+ * @param received 收到的数据报文（按连接分别记录）
+ */
+bool Pump(DirectConnection& a,
+          DirectConnection& b,
+          std::vector<std::string>& received_a,
+          std::vector<std::string>& received_b,
+          const std::function<bool()>& done) {
+  uint8_t buffer[2048];
+  const auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (done()) {
+      return true;
+    }
+    a.ProcessTimers();
+    b.ProcessTimers();
+    auto result = a.Recv(buffer, sizeof(buffer), 2);
+    if (result.IsOk()) {
+      received_a.emplace_back(reinterpret_cast<char*>(buffer),
+                              result.Value());
+    }
+    result = b.Recv(buffer, sizeof(buffer), 2);
+    if (result.IsOk()) {
+      received_b.emplace_back(reinterpret_cast<char*>(buffer),
+                              result.Value());
+    }
+  }
+  return done();
+}
+
+bool Contains(const std::vector<std::string>& messages,
+              const std::string& text) {
+  return std::find(messages.begin(), messages.end(), text) != messages.end();
+}
+
+}  // namespace
+
+TEST(NetworkMonitorTest, OpensWithEventHandleOnLinux) {
+  NetworkMonitor monitor;
+  ASSERT_TRUE(monitor.Open().IsOk());
+  EXPECT_TRUE(monitor.IsOpen());
+#ifdef __linux__
+  EXPECT_NE(monitor.GetHandle(), kInvalidSocket);
+#else
+  EXPECT_EQ(monitor.GetHandle(), kInvalidSocket);
+#endif
+  monitor.Close();
+  EXPECT_FALSE(monitor.IsOpen());
+  EXPECT_FALSE(monitor.ReadChanges());
+}
+
+TEST(DirectConnectionMigrationTest, ProbeMovesPeerToNewPath) {
+  auto a = MakeConnection(kPortA, kPortB, kSessionId);
+  auto b = MakeConnection(kPortB, kPortA, kSessionId);
+  const size_t handles_before = a->GetPollHandles().size();
+  const uint32_t generation_before = a->GetPollHandlesGeneration();
+
+  ASSERT_TRUE(a->Migrate("127.0.0.2").IsOk());
+  EXPECT_EQ(a->GetPollHandles().size(), handles_before + 1);
+  EXPECT_NE(a->GetPollHandlesGeneration(), generation_before);
+  // 对端切换之前发出的报文仍走旧路径
+  ASSERT_TRUE(Send(*b, "in-flight"));
+
+  std::vector<std::string> received_a;
+  std::vector<std::string> received_b;
+  // 对端在路径挑战得到回复后才切换，比本端提交迁移晚半个往返
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b, [&] {
+    return a->GetStats().migrations == 1 &&
+           b->GetStats().path_switches == 1;
+  }));
+  EXPECT_TRUE(Contains(received_a, "in-flight"));
+  // 探测是内部报文，不交给调用方
+  EXPECT_TRUE(received_b.empty());
+
+  const Endpoint remote = b->GetRemote();
+  EXPECT_EQ(remote.address, "127.0.0.2");
+  EXPECT_EQ(remote.port, a->GetLocalPort());
+  EXPECT_NE(a->GetLocalPort(), kPortA);
+  EXPECT_EQ(b->GetStats().path_switches, 1U);
+
+  // 两个方向都走新路径
+  ASSERT_TRUE(Send(*a, "from-new-path"));
+  ASSERT_TRUE(Send(*b, "to-new-path"));
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b, [&] {
+    return Contains(received_a, "to-new-path") &&
+           Contains(received_b, "from-new-path");
+  }));
+
+  // 宽限期过后旧 socket 关闭
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b, [&] {
+    return a->GetPollHandles().size() == handles_before;
+  }));
+  EXPECT_EQ(a->GetStats().migration_failures, 0U);
+}
+
+TEST(DirectConnectionMigrationTest, ForeignSessionProbeIsIgnored) {
+  auto a = MakeConnection(kForeignPortA, kForeignPortB, kSessionId);
+  auto b = MakeConnection(kForeignPortB, kForeignPortA, kSessionId + 1);
+  const size_t handles_before = a->GetPollHandles().size();
+
+  ASSERT_TRUE(a->Migrate("127.0.0.2").IsOk());
+  std::vector<std::string> received_a;
+  std::vector<std::string> received_b;
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b,
+                   [&] { return a->GetStats().migration_failures == 1; }));
+
+  EXPECT_EQ(a->GetStats().migrations, 0U);
+  EXPECT_EQ(a->GetLocalPort(), kForeignPortA);
+  EXPECT_EQ(a->GetPollHandles().size(), handles_before);
+  EXPECT_EQ(b->GetStats().path_switches, 0U);
+  EXPECT_EQ(b->GetRemote().port, kForeignPortA);
+  EXPECT_TRUE(received_b.empty());
+
+  // 原路径不受影响
+  ASSERT_TRUE(Send(*a, "still-here"));
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b,
+                   [&] { return Contains(received_b, "still-here"); }));
+}
+
+TEST(DirectConnectionMigrationTest, UnauthenticatedProbeIsDropped) {
+  auto a = MakeConnection(kForgedPortA, kForgedPortB, kSessionId,
+                          std::vector<uint8_t>(32, 0x11));
+  auto b = MakeConnection(kForgedPortB, kForgedPortA, kSessionId);
+
+  // 会话 ID 正确但签名密钥不同：对端既不回复也不切换
+  ASSERT_TRUE(a->Migrate("127.0.0.2").IsOk());
+  std::vector<std::string> received_a;
+  std::vector<std::string> received_b;
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b,
+                   [&] { return a->GetStats().migration_failures == 1; }));
+
+  EXPECT_EQ(a->GetStats().migrations, 0U);
+  EXPECT_GT(b->GetStats().probes_rejected, 0U);
+  EXPECT_EQ(b->GetStats().path_switches, 0U);
+  EXPECT_EQ(b->GetRemote().address, "127.0.0.1");
+  EXPECT_EQ(b->GetRemote().port, kForgedPortA);
+}
+
+TEST(DirectConnectionMigrationTest, ReplayedProbeDoesNotRedirectPeer) {
+  auto a = MakeConnection(kReplayPortA, kReplayPortB, kSessionId);
+  auto b = MakeConnection(kReplayPortB, kReplayPortA, kSessionId);
+
+  // 攻击者从自己的地址重放一个签名有效的探测（签名不覆盖源地址）
+  UdpSocket::Config attacker_config;
+  attacker_config.local_ip = "127.0.0.3";
+  UdpSocket attacker(attacker_config);
+  ASSERT_TRUE(attacker.Open());
+  StunMessage probe;
+  probe.transaction_id.fill(0x42);
+  probe.AddUint32(StunAttributeType::kSessionId, kSessionId);
+  const auto replayed = SerializeStunMessage(probe, kMigrationKey);
+  ASSERT_TRUE(attacker.SendTo(replayed.data(), replayed.size(), "127.0.0.1",
+                              kReplayPortB));
+
+  // 对端回复并向攻击者地址发送挑战；攻击者无法应答，发送地址保持不变
+  std::vector<std::string> received_a;
+  std::vector<std::string> received_b;
+  const auto settle = std::chrono::steady_clock::now() + 300ms;
+  Pump(*a, *b, received_a, received_b,
+       [&] { return std::chrono::steady_clock::now() >= settle; });
+  EXPECT_EQ(b->GetStats().path_switches, 0U);
+  EXPECT_EQ(b->GetRemote().address, "127.0.0.1");
+  EXPECT_EQ(b->GetRemote().port, kReplayPortA);
+
+  // 真正的迁移仍能通过挑战完成
+  ASSERT_TRUE(a->Migrate("127.0.0.2").IsOk());
+  ASSERT_TRUE(Pump(*a, *b, received_a, received_b, [&] {
+    return a->GetStats().migrations == 1 &&
+           b->GetStats().path_switches == 1;
+  }));
+  EXPECT_EQ(b->GetRemote().address, "127.0.0.2");
+  EXPECT_EQ(b->GetRemote().port, a->GetLocalPort());
+}
+
+TEST(PeerConnectionMigrationTest, MidStreamRebindKeepsFramesFlowing) {
+  constexpr uint32_t kFrames = 120;
+  constexpr uint32_t kMigrateAtFrame = 40;
+  constexpr auto kFrameInterval = std::chrono::microseconds(16667);
+
+  auto make_config = [](uint16_t local_port, uint16_t remote_port) {
+    PeerConnection::Config config;
+    config.mode = PeerConnection::ConnectionMode::kDirect;
+    config.remote_ip = "127.0.0.1";
+    config.remote_port = remote_port;
+    config.local_port = local_port;
+    config.enable_migration = true;
+    config.session_id = kSessionId;
+    config.migration_key = kMigrationKey;
+    return config;
+  };
+
+  PeerConnection sender;
+  PeerConnection receiver;
+  ASSERT_TRUE(
+      sender.Initialize(make_config(kStreamPortA, kStreamPortB)).IsOk());
+  ASSERT_TRUE(
+      receiver.Initialize(make_config(kStreamPortB, kStreamPortA)).IsOk());
+
+  auto video = std::make_shared<VideoTrack>(VideoTrack::Config{});
+  ASSERT_TRUE(sender.AddTrack(video).IsOk());
+  auto sender_channel = sender.CreateDataChannel("control");
+  ASSERT_TRUE(sender_channel.IsOk());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::chrono::steady_clock::time_point> arrivals;
+  std::vector<std::string> replies;
+  std::shared_ptr<DataChannel> receiver_channel;
+  receiver.SetOnTrackCallback([&](std::shared_ptr<MediaTrack> track) {
+    track->SetOnFrameCallback([&](const uint8_t*, size_t, uint32_t) {
+      std::lock_guard<std::mutex> lock(mutex);
+      arrivals.push_back(std::chrono::steady_clock::now());
+      cv.notify_all();
+    });
+  });
+  receiver.SetOnDataChannelCallback([&](std::shared_ptr<DataChannel> channel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    receiver_channel = channel;
+    cv.notify_all();
+  });
+  sender_channel.Value()->SetOnMessageCallback(
+      [&](const uint8_t* data, size_t length) {
+        std::lock_guard<std::mutex> lock(mutex);
+        replies.emplace_back(reinterpret_cast<const char*>(data), length);
+        cv.notify_all();
+      });
+
+  ASSERT_TRUE(receiver.Connect().IsOk());
+  ASSERT_TRUE(sender.Connect().IsOk());
+
+  const std::string frame(4000, 'v');
+  auto next_frame = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kFrames; ++i) {
+    if (i == kMigrateAtFrame) {
+      ASSERT_TRUE(sender.MigrateConnection("127.0.0.2").IsOk());
+    }
+    ASSERT_TRUE(video
+                    ->SendFrame(reinterpret_cast<const uint8_t*>(frame.data()),
+                                frame.size(), i * 1500)
+                    .IsOk());
+    next_frame += kFrameInterval;
+    std::this_thread::sleep_until(next_frame);
+  }
+
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(cv.wait_for(lock, 3s, [&] {
+    return arrivals.size() >= kFrames && receiver_channel != nullptr;
+  }));
+  double max_gap_ms = 0.0;
+  for (size_t i = 1; i < arrivals.size(); ++i) {
+    max_gap_ms = std::max(
+        max_gap_ms, std::chrono::duration<double, std::milli>(
+                        arrivals[i] - arrivals[i - 1])
+                        .count());
+  }
+  std::cout << "[ MIGRATE  ] " << arrivals.size() << "/" << kFrames
+            << " frames, max inter-frame gap " << max_gap_ms
+            << " ms (nominal 16.7 ms)" << std::endl;
+  EXPECT_EQ(arrivals.size(), kFrames);
+  EXPECT_LT(max_gap_ms, 100.0);
+
+  // 等旧 socket 过了宽限期关闭，反方向的消息只能经新路径到达
+  lock.unlock();
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(DirectConnection::Config{}.retire_grace_ms) +
+      200ms);
+  const std::string reply = "ack";
+  ASSERT_TRUE(receiver_channel
+                  ->Send(reinterpret_cast<const uint8_t*>(reply.data()),
+                         reply.size())
+                  .IsOk());
+  lock.lock();
+  EXPECT_TRUE(cv.wait_for(lock, 3s, [&] { return !replies.empty(); }));
+  lock.unlock();
+
+  sender.Disconnect();
+  receiver.Disconnect();
+}
+
+}  // namespace zenremote
@@ -0,0 +1,361 @@
+/**
+ * @file test_copy_rect.cpp
+ * @brief 复制命令（滚动、窗口拖动）的发送端累积、SEI 编解码与接收端合成测试
+ *
+ * 测试目标：
+ * - SEI 插入在第一个条带之前，防竞争字节往返正确，H.264 与 HEVC 都能解析
+ * - 滚动只留下新露出的条带作为残差；多帧合并时未更新的残差随复制平移
+ * - 奇数坐标与源目标冲突的移动区域按脏区域处理；Reset() 后不再带命令
+ * - 端到端：发送端只转换残差区域、接收端在上一帧上合成，逐帧与屏幕一致
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "media/codec/copy_rect.h"
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+using media::capture::MoveRect;
+
+bool SameRect(const DirtyRect& a, const DirtyRect& b) {
+  return a.left == b.left && a.top == b.top && a.right == b.right &&
+         a.bottom == b.bottom;
+}
+
+AVFramePtr MakeNv12(int width, int height) {
+  AVFramePtr frame = MakeAVFrame();
+  frame->format = AV_PIX_FMT_NV12;
+  frame->width = width;
+  frame->height = height;
+  if (av_frame_get_buffer(frame.get(), 32) < 0) {
+    return nullptr;
+  }
+  return frame;
+}
+
+/// NV12 的两个平面上 rect 对应的行：fn(plane, row pointer, bytes)
+template <typename Fn>
+void ForEachRow(AVFrame* frame, const DirtyRect& rect, Fn fn) {
+  for (int plane = 0; plane < 2; ++plane) {
+    const int shift = plane;
+    const int left = (rect.left >> shift) << shift;
+    for (int y = rect.top >> shift; y < (rect.bottom + shift) >> shift; ++y) {
+      fn(plane, frame->data[plane] + y * frame->linesize[plane] + left,
+         static_cast<size_t>(((rect.right + shift) >> shift << shift) - left));
+    }
+  }
+}
+
+void CopyRegion(const AVFrame* src, AVFrame* dst, const DirtyRect& rect) {
+  for (int plane = 0; plane < 2; ++plane) {
+    const int shift = plane;
+    const int left = (rect.left >> shift) << shift;
+    const int right = (rect.right + shift) >> shift << shift;
+    for (int y = rect.top >> shift; y < (rect.bottom + shift) >> shift; ++y) {
+      std::memcpy(dst->data[plane] + y * dst->linesize[plane] + left,
+                  src->data[plane] + y * src->linesize[plane] + left,
+                  static_cast<size_t>(right - left));
+    }
+  }
+}
+
+bool SamePixels(const AVFrame* a, const AVFrame* b) {
+  for (int plane = 0; plane < 2; ++plane) {
+    const int rows = plane == 0 ? a->height : a->height / 2;
+    for (int y = 0; y < rows; ++y) {
+      if (std::memcmp(a->data[plane] + y * a->linesize[plane],
+                      b->data[plane] + y * b->linesize[plane],
+                      static_cast<size_t>(a->width)) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// 模拟屏幕：移动区域以变化前的画面为源，其余变化随机填充
+class Screen {
+ public:
+  Screen(int width, int height) : frame_(MakeNv12(width, height)) {
+    Paint({0, 0, width, height});
+  }
+
+  AVFrame* Frame() { return frame_.get(); }
+
+  void Paint(const DirtyRect& rect) {
+    ForEachRow(frame_.get(), rect, [this](int, uint8_t* row, size_t bytes) {
+      for (size_t i = 0; i < bytes; ++i) {
+        row[i] = static_cast<uint8_t>(Next());
+      }
+    });
+  }
+
+  void Move(const MoveRect& move) {
+    AVFramePtr before = MakeNv12(frame_->width, frame_->height);
+    CopyRegion(frame_.get(), before.get(),
+               {0, 0, frame_->width, frame_->height});
+    const int dx = move.destination.left - move.source.left;
+    const int dy = move.destination.top - move.source.top;
+    for (int y = move.destination.top; y < move.destination.bottom; ++y) {
+      for (int x = move.destination.left; x < move.destination.right; ++x) {
+        frame_->data[0][y * frame_->linesize[0] + x] =
+            before->data[0][(y - dy) * before->linesize[0] + x - dx];
+        if (y % 2 == 0 && x % 2 == 0) {
+          for (int c = 0; c < 2; ++c) {
+            frame_->data[1][y / 2 * frame_->linesize[1] + x + c] =
+                before->data[1][(y - dy) / 2 * before->linesize[1] + x - dx +
+                                c];
+          }
+        }
+      }
+    }
+  }
+
+  uint32_t Next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return state_;
+  }
+
+ private:
+  AVFramePtr frame_;
+  uint32_t state_ = 0x2545F491u;
+};
+
+}  // namespace
+
+TEST(CopyRectTest, SeiRoundTrip) {
+  CopyRectCommand command;
+  command.copies.push_back({{0, 2, 96, 64}, {0, 0, 96, 62}});
+  command.copies.push_back({{256, 0, 258, 2}, {0, 0, 2, 2}});
+  // 全零坐标触发防竞争字节
+  command.residual_rects.push_back({0, 0, 2, 2});
+  command.residual_rects.push_back({0, 62, 1920, 64});
+
+  for (AVCodecID codec : {AV_CODEC_ID_H264, AV_CODEC_ID_HEVC}) {
+    auto sei = BuildCopyRectSei(command, codec);
+    ASSERT_TRUE(sei.IsOk());
+    for (size_t i = 4; i + 2 < sei.Value().size(); ++i) {
+      ASSERT_FALSE(sei.Value()[i] == 0 && sei.Value()[i + 1] == 0 &&
+                   sei.Value()[i + 2] <= 2);
+    }
+
+    // 参数集 + 条带；SEI 插到条带之前
+    std::vector<uint8_t> access_unit =
+        codec == AV_CODEC_ID_H264
+            ? std::vector<uint8_t>{0, 0, 0, 1, 0x67, 0x42, 0, 0, 0, 1, 0x65,
+                                   0x88, 0x84}
+            : std::vector<uint8_t>{0, 0, 0, 1, 0x42, 0x01, 0x01, 0, 0, 0, 1,
+                                   0x26, 0x01, 0xAF};
+    const std::vector<uint8_t> original = access_unit;
+    const size_t slice = codec == AV_CODEC_ID_H264 ? 6 : 7;
+    EXPECT_FALSE(ParseCopyRectSei(access_unit.data(), access_unit.size(), codec)
+                     .has_value());
+    ASSERT_TRUE(InsertCopyRectSei(sei.Value(), codec, access_unit).IsOk());
+    ASSERT_EQ(access_unit.size(), original.size() + sei.Value().size());
+    EXPECT_EQ(std::memcmp(access_unit.data() + slice, sei.Value().data(),
+                          sei.Value().size()),
+              0);
+    EXPECT_EQ(std::memcmp(access_unit.data() + slice + sei.Value().size(),
+                          original.data() + slice, original.size() - slice),
+              0);
+
+    auto parsed =
+        ParseCopyRectSei(access_unit.data(), access_unit.size(), codec);
+    ASSERT_TRUE(parsed.has_value());
+    ASSERT_EQ(parsed->copies.size(), 2U);
+    EXPECT_TRUE(SameRect(parsed->copies[0].source, {0, 2, 96, 64}));
+    EXPECT_TRUE(SameRect(parsed->copies[0].destination, {0, 0, 96, 62}));
+    EXPECT_TRUE(SameRect(parsed->copies[1].source, {256, 0, 258, 2}));
+    ASSERT_EQ(parsed->residual_rects.size(), 2U);
+    EXPECT_TRUE(SameRect(parsed->residual_rects[0], {0, 0, 2, 2}));
+    EXPECT_TRUE(SameRect(parsed->residual_rects[1], {0, 62, 1920, 64}));
+  }
+
+  // 没有条带（非 Annex B）时无法插入；不支持的编码
+  std::vector<uint8_t> avcc = {0, 0, 0, 3, 0x65, 0x88, 0x84};
+  auto sei = BuildCopyRectSei(command, AV_CODEC_ID_H264);
+  EXPECT_EQ(InsertCopyRectSei(sei.Value(), AV_CODEC_ID_H264, avcc).Code(),
+            ErrorCode::kInvalidParameter);
+  EXPECT_EQ(BuildCopyRectSei(command, AV_CODEC_ID_VP9).Code(),
+            ErrorCode::kUnsupportedCodec);
+}
+
+TEST(CopyRectTest, ScrollLeavesOnlyExposedStrip) {
+  CopyRectTracker tracker;
+  tracker.Reset(1920, 1080);
+  CopyRectCommand command;
+  EXPECT_FALSE(tracker.TakeCommand(command));
+
+  // 文档区向上滚动 20 行，底部露出新的一行
+  tracker.AddFrame({{160, 1000, 1760, 1020}},
+                   {{{160, 84, 1760, 1020}, {160, 64, 1760, 1000}}});
+  ASSERT_EQ(tracker.GetResidualRects().size(), 1U);
+  EXPECT_TRUE(SameRect(tracker.GetResidualRects()[0], {160, 1000, 1760, 1020}));
+  ASSERT_TRUE(tracker.TakeCommand(command));
+  ASSERT_EQ(command.copies.size(), 1U);
+  EXPECT_TRUE(tracker.IsComposited());
+
+  // 此后每帧都带命令（编码器输入帧在滚动过的位置与屏幕不一致）
+  tracker.AddFrame({{171, 201, 179, 215}}, {});
+  ASSERT_TRUE(tracker.TakeCommand(command));
+  EXPECT_TRUE(command.copies.empty());
+  ASSERT_EQ(command.residual_rects.size(), 1U);
+  EXPECT_TRUE(SameRect(command.residual_rects[0], {170, 200, 180, 216}));
+
+  tracker.Reset(1920, 1080);
+  tracker.AddFrame({{0, 0, 16, 16}}, {});
+  EXPECT_FALSE(tracker.TakeCommand(command));
+}
+
+TEST(CopyRectTest, MergedFramesMoveResidual) {
+  CopyRectTracker tracker;
+  tracker.Reset(64, 64);
+  // 第一帧改了一行，尚未发送；第二帧向上滚动 8 行
+  tracker.AddFrame({{0, 40, 64, 48}}, {});
+  tracker.AddFrame({{0, 56, 64, 64}}, {{{0, 8, 64, 64}, {0, 0, 64, 56}}});
+  CopyRectCommand command;
+  ASSERT_TRUE(tracker.TakeCommand(command));
+  ASSERT_EQ(command.copies.size(), 1U);
+  ASSERT_EQ(command.residual_rects.size(), 2U);
+  EXPECT_TRUE(SameRect(command.residual_rects[0], {0, 32, 64, 40}));
+  EXPECT_TRUE(SameRect(command.residual_rects[1], {0, 56, 64, 64}));
+
+  // 奇数偏移不能在 4:2:0 上复制；同一帧内源与较早的目标相交
+  tracker.AddFrame({}, {{{0, 1, 16, 17}, {0, 0, 16, 16}},
+                        {{32, 32, 48, 48}, {32, 0, 48, 16}},
+                        {{32, 8, 48, 24}, {32, 40, 48, 56}}});
+  ASSERT_TRUE(tracker.TakeCommand(command));
+  ASSERT_EQ(command.copies.size(), 1U);
+  EXPECT_TRUE(SameRect(command.copies[0].destination, {32, 0, 48, 16}));
+  ASSERT_EQ(command.residual_rects.size(), 2U);
+  EXPECT_TRUE(SameRect(command.residual_rects[0], {0, 0, 16, 16}));
+  EXPECT_TRUE(SameRect(command.residual_rects[1], {32, 40, 48, 56}));
+}
+
+TEST(CopyRectTest, EndToEndMatchesScreen) {
+  constexpr int kWidth = 96;
+  constexpr int kHeight = 64;
+  Screen screen(kWidth, kHeight);
+  AVFramePtr encoder_input = MakeNv12(kWidth, kHeight);
+  CopyRegion(screen.Frame(), encoder_input.get(), {0, 0, kWidth, kHeight});
+  CopyRectTracker tracker;
+  tracker.Reset(kWidth, kHeight);
+  CopyRectCompositor compositor;
+  CopyRectCommand command;
+  int commands = 0;
+
+  for (int frame = 0; frame < 300; ++frame) {
+    // 1~3 次屏幕变化合并为一帧（中间的采集帧被丢弃）
+    const int updates = 1 + static_cast<int>(screen.Next() % 3);
+    for (int u = 0; u < updates; ++u) {
+      std::vector<DirtyRect> dirty;
+      std::vector<MoveRect> moves;
+      const uint32_t kind = screen.Next() % 4;
+      if (kind == 0 || kind == 1) {
+        // 滚动：偶数或奇数行距，新露出的条带重新绘制
+        const int step = 1 + static_cast<int>(screen.Next() % 12);
+        MoveRect move = kind == 0
+                            ? MoveRect{{8, 4 + step, 88, 60},
+                                       {8, 4, 88, 60 - step}}
+                            : MoveRect{{8, 4, 88, 60 - step},
+                                       {8, 4 + step, 88, 60}};
+        screen.Move(move);
+        moves.push_back(move);
+        const DirtyRect exposed =
+            kind == 0 ? DirtyRect{8, 60 - step, 88, 60}
+                      : DirtyRect{8, 4, 88, 4 + step};
+        screen.Paint(exposed);
+        dirty.push_back(exposed);
+      } else if (kind == 2) {
+        // 窗口拖动：旧位置露出的背景重绘
+        const int x = 2 * static_cast<int>(screen.Next() % 24);
+        const int y = 2 * static_cast<int>(screen.Next() % 16);
+        const int nx = 2 * static_cast<int>(screen.Next() % 24);
+        const int ny = 2 * static_cast<int>(screen.Next() % 16);
+        MoveRect move{{x, y, x + 40, y + 30}, {nx, ny, nx + 40, ny + 30}};
+        screen.Move(move);
+        moves.push_back(move);
+        screen.Paint(move.source);
+        dirty.push_back(move.source);
+      } else {
+        // 输入文字（奇数坐标）
+        const int x = static_cast<int>(screen.Next() % 90);
+        const int y = static_cast<int>(screen.Next() % 56);
+        const DirtyRect glyph{x, y, x + 5, y + 7};
+        screen.Paint(glyph);
+        dirty.push_back(glyph);
+      }
+      tracker.AddFrame(dirty, moves);
+    }
+
+    const bool full_frame = frame % 97 == 0;
+    bool has_command = false;
+    if (full_frame) {
+      CopyRegion(screen.Frame(), encoder_input.get(),
+                 {0, 0, kWidth, kHeight});
+      tracker.Reset(kWidth, kHeight);
+    } else {
+      for (const auto& rect : tracker.GetResidualRects()) {
+        CopyRegion(screen.Frame(), encoder_input.get(), rect);
+      }
+      has_command = tracker.TakeCommand(command);
+    }
+    commands += has_command ? 1 : 0;
+
+    // 无损的“编解码”：解码帧是编码器输入的副本，经过 SEI 往返
+    AVFramePtr decoded = MakeNv12(kWidth, kHeight);
+    CopyRegion(encoder_input.get(), decoded.get(), {0, 0, kWidth, kHeight});
+    std::vector<uint8_t> access_unit = {0, 0, 0, 1, 0x65, 0x88};
+    if (has_command) {
+      auto sei = BuildCopyRectSei(command, AV_CODEC_ID_H264);
+      ASSERT_TRUE(sei.IsOk());
+      ASSERT_TRUE(
+          InsertCopyRectSei(sei.Value(), AV_CODEC_ID_H264, access_unit).IsOk());
+    }
+    auto parsed = ParseCopyRectSei(access_unit.data(), access_unit.size(),
+                                   AV_CODEC_ID_H264);
+    ASSERT_EQ(parsed.has_value(), has_command);
+
+    auto shown = compositor.Compose(decoded.get(), parsed ? &*parsed : nullptr);
+    ASSERT_TRUE(shown.IsOk()) << shown.Message();
+    ASSERT_TRUE(SamePixels(shown.Value(), screen.Frame())) << "frame " << frame;
+  }
+  EXPECT_GT(commands, 200);
+}
+
+TEST(CopyRectTest, CompositorNeedsBaseFrame) {
+  CopyRectCompositor compositor;
+  AVFramePtr decoded = MakeNv12(64, 32);
+  std::memset(decoded->data[0], 7, decoded->linesize[0] * 32);
+  CopyRectCommand command;
+  command.copies.push_back({{0, 2, 64, 32}, {0, 0, 64, 30}});
+
+  // 丢包后 Reset()：没有基准帧
+  EXPECT_EQ(compositor.Compose(decoded.get(), &command).Code(),
+            ErrorCode::kInvalidState);
+  auto shown = compositor.Compose(decoded.get(), nullptr);
+  ASSERT_TRUE(shown.IsOk());
+  EXPECT_EQ(shown.Value(), decoded.get());
+  shown = compositor.Compose(decoded.get(), &command);
+  ASSERT_TRUE(shown.IsOk());
+  EXPECT_NE(shown.Value(), decoded.get());
+
+  command.residual_rects.push_back({0, 0, 66, 2});
+  EXPECT_EQ(compositor.Compose(decoded.get(), &command).Code(),
+            ErrorCode::kInvalidParameter);
+  compositor.Reset();
+  command.residual_rects.clear();
+  EXPECT_EQ(compositor.Compose(decoded.get(), &command).Code(),
+            ErrorCode::kInvalidState);
+}
+
+}  // namespace zenremote
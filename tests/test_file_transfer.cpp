@@ -0,0 +1,635 @@
+/**
+ * @file test_file_transfer.cpp
+ * @brief 文件传输服务单元测试
+ *
+ * 测试目标：
+ * - CRC-32C 标准测试向量与分段计算
+ * - 文件传输消息序列化
+ * - 丢包链路上的完整传输、断点续传、块校验失败重传
+ * - 窗口大于单条请求的块数上限时不丢请求
+ * - 对端文件名净化（不允许写出下载目录）
+ * - 接收确认回调、不覆盖已有文件、同名并发传输使用独立的 .part
+ * - 千兆链路吞吐与 CPU 占用基准（DISABLED，手动运行）
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "common/crc32c.h"
+#include "loopback_impairment.h"
+#include "network/reliable/transport_packet.h"
+#include "transport/channel/reliable_channel.h"
+#include "transport/file/file_transfer_service.h"
+
+using namespace std::chrono_literals;
+namespace fs = std::filesystem;
+
+namespace zenremote {
+
+namespace {
+
+/**
+ * @brief 测试用临时目录，析构时删除
+ */
+class TempDirectory {
+ public:
+  explicit TempDirectory(const std::string& name)
+      : path_(fs::temp_directory_path() /
+              ("zenremote_" + name + "_" +
+               std::to_string(std::chrono::steady_clock::now()
+                                  .time_since_epoch()
+                                  .count()))) {
+    fs::create_directories(path_);
+  }
+
+  ~TempDirectory() {
+    std::error_code ec;
+    fs::remove_all(path_, ec);
+  }
+
+  const fs::path& path() const { return path_; }
+
+ private:
+  fs::path path_;
+};
+
+std::vector<uint8_t> MakeFileContent(size_t size) {
+  std::vector<uint8_t> content(size);
+  uint32_t state = 0x12345678U;
+  for (auto& byte : content) {
+    state = state * 1664525U + 1013904223U;
+    byte = static_cast<uint8_t>(state >> 24);
+  }
+  return content;
+}
+
+void WriteFile(const fs::path& path, const std::vector<uint8_t>& content) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(content.data()),
+            static_cast<std::streamsize>(content.size()));
+}
+
+std::vector<uint8_t> ReadFile(const fs::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+}
+
+// 目录下以 suffix 结尾的文件数
+size_t CountFilesWithSuffix(const fs::path& directory,
+                            const std::string& suffix) {
+  size_t count = 0;
+  for (const auto& entry : fs::directory_iterator(directory)) {
+    const auto name = entry.path().filename().string();
+    if (name.size() >= suffix.size() &&
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) ==
+            0) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief 通过损伤回环相连的两个文件传输端点，单线程驱动
+ *
+ * sender 端发起传输，receiver 端保存到 download_directory，默认接收所有 OFFER。
+ */
+class FileTransferPair {
+ public:
+  FileTransferPair(const ImpairedLoopback::Config& link_config,
+                   const FileTransferService::Config& config)
+      : link_(link_config),
+        sender_channel_(std::make_shared<ReliableChannel>(
+            "file", DataChannel::Config{})),
+        receiver_channel_(std::make_shared<ReliableChannel>(
+            "file", DataChannel::Config{})) {
+    sender_channel_->SetConnection(link_.a());
+    receiver_channel_->SetConnection(link_.b());
+    sender_ = std::make_unique<FileTransferService>(sender_channel_, config);
+    receiver_ =
+        std::make_unique<FileTransferService>(receiver_channel_, config);
+    receiver_->SetOnOfferCallback(
+        [](const FileTransferService::TransferInfo&) { return true; });
+
+    sender_->SetOnCompleteCallback(
+        [this](const FileTransferService::TransferInfo&,
+               const Result<void>& result) {
+          sender_done_ = true;
+          sender_error_ = result.Code();
+        });
+    receiver_->SetOnCompleteCallback(
+        [this](const FileTransferService::TransferInfo& info,
+               const Result<void>& result) {
+          receiver_done_ = true;
+          receiver_error_ = result.Code();
+          receiver_info_ = info;
+        });
+  }
+
+  FileTransferService& sender() { return *sender_; }
+  FileTransferService& receiver() { return *receiver_; }
+
+  bool sender_done() const { return sender_done_; }
+  bool receiver_done() const { return receiver_done_; }
+  ErrorCode sender_error() const { return sender_error_; }
+  ErrorCode receiver_error() const { return receiver_error_; }
+  const FileTransferService::TransferInfo& receiver_info() const {
+    return receiver_info_;
+  }
+
+  // 修改发往接收端的原始报文（返回前可原地篡改）
+  void SetOnReceiverPacket(std::function<void(uint8_t*, size_t)> hook) {
+    on_receiver_packet_ = std::move(hook);
+  }
+
+  void PumpOnce() {
+    uint8_t buffer[2048];
+    while (true) {
+      auto result = link_.b()->Recv(buffer, sizeof(buffer), 0);
+      if (result.IsErr()) {
+        break;
+      }
+      if (on_receiver_packet_) {
+        on_receiver_packet_(buffer, result.Value());
+      }
+      receiver_channel_->OnDataReceived(buffer, result.Value());
+    }
+    while (true) {
+      auto result = link_.a()->Recv(buffer, sizeof(buffer), 0);
+      if (result.IsErr()) {
+        break;
+      }
+      sender_channel_->OnDataReceived(buffer, result.Value());
+    }
+    sender_channel_->ProcessTimers();
+    receiver_channel_->ProcessTimers();
+    sender_->Process();
+    receiver_->Process();
+  }
+
+  bool PumpUntil(const std::function<bool()>& done,
+                 std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+      PumpOnce();
+      if (done()) {
+        return true;
+      }
+      std::this_thread::sleep_for(100us);
+    }
+    return done();
+  }
+
+ private:
+  ImpairedLoopback link_;
+  std::shared_ptr<ReliableChannel> sender_channel_;
+  std::shared_ptr<ReliableChannel> receiver_channel_;
+  std::unique_ptr<FileTransferService> sender_;
+  std::unique_ptr<FileTransferService> receiver_;
+  std::function<void(uint8_t*, size_t)> on_receiver_packet_;
+
+  bool sender_done_ = false;
+  bool receiver_done_ = false;
+  ErrorCode sender_error_ = ErrorCode::kSuccess;
+  ErrorCode receiver_error_ = ErrorCode::kSuccess;
+  FileTransferService::TransferInfo receiver_info_;
+};
+
+}  // namespace
+
+// ============================================================================
+// CRC-32C 与消息格式
+// ============================================================================
+
+TEST(Crc32cTest, KnownVector) {
+  const std::string input = "123456789";
+  const auto* data = reinterpret_cast<const uint8_t*>(input.data());
+  EXPECT_EQ(Crc32c(data, input.size()), 0xE3069283U);
+  EXPECT_EQ(Crc32c(data, 0), 0U);
+}
+
+TEST(Crc32cTest, IncrementalMatchesSinglePass) {
+  auto content = MakeFileContent(10007);
+  const uint32_t whole = Crc32c(content.data(), content.size());
+  for (size_t split : {size_t{1}, size_t{7}, size_t{4096}, size_t{10000}}) {
+    const uint32_t first = Crc32c(content.data(), split);
+    EXPECT_EQ(Crc32c(content.data() + split, content.size() - split, first),
+              whole);
+  }
+}
+
+TEST(FileTransferProtocolTest, MessagesRoundtrip) {
+  FileOffer offer;
+  offer.transfer_id = 9;
+  offer.file_size = 0x123456789ULL;
+  offer.chunk_size = 65536;
+  offer.fingerprint = 0xDEADBEEFCAFEULL;
+  offer.name = "report.pdf";
+  auto buffer = SerializeFileOffer(offer);
+  ASSERT_EQ(buffer.size(), kFileOfferHeaderSize + offer.name.size());
+  auto parsed_offer = ParseFileOffer(buffer.data(), buffer.size());
+  ASSERT_TRUE(parsed_offer.has_value());
+  EXPECT_EQ(parsed_offer->file_size, offer.file_size);
+  EXPECT_EQ(parsed_offer->fingerprint, offer.fingerprint);
+  EXPECT_EQ(parsed_offer->name, offer.name);
+  EXPECT_FALSE(ParseFileOffer(buffer.data(), buffer.size() - 1).has_value());
+
+  FileChunkRequest request;
+  request.transfer_id = 9;
+  request.chunk_indices = {0, 5, 70000};
+  buffer = SerializeFileChunkRequest(request);
+  auto parsed_request = ParseFileChunkRequest(buffer.data(), buffer.size());
+  ASSERT_TRUE(parsed_request.has_value());
+  EXPECT_EQ(parsed_request->chunk_indices, request.chunk_indices);
+
+  FileChunkHeader header{9, 5, 0xABCDEF01U};
+  buffer = SerializeFileChunkHeader(header);
+  ASSERT_EQ(buffer.size(), kFileChunkHeaderSize);
+  auto parsed_header = ParseFileChunkHeader(buffer.data(), buffer.size());
+  ASSERT_TRUE(parsed_header.has_value());
+  EXPECT_EQ(parsed_header->chunk_index, 5U);
+  EXPECT_EQ(parsed_header->crc32c, 0xABCDEF01U);
+
+  FileCancel cancel;
+  cancel.from_sender = true;
+  cancel.transfer_id = 9;
+  cancel.error_code = 708;
+  cancel.reason = "disk full";
+  buffer = SerializeFileCancel(cancel);
+  EXPECT_EQ(PeekFileTransferMessageType(buffer.data(), buffer.size()),
+            FileTransferMessageType::kCancel);
+  auto parsed_cancel = ParseFileCancel(buffer.data(), buffer.size());
+  ASSERT_TRUE(parsed_cancel.has_value());
+  EXPECT_TRUE(parsed_cancel->from_sender);
+  EXPECT_EQ(parsed_cancel->error_code, 708U);
+  EXPECT_EQ(parsed_cancel->reason, cancel.reason);
+}
+
+// ============================================================================
+// 传输服务
+// ============================================================================
+
+TEST(FileTransferServiceTest, TransfersFileOverLossyLink) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(3 * 1024 * 1024 + 123);
+  WriteFile(source.path() / "data.bin", content);
+
+  ImpairedLoopback::Config link;
+  link.loss_rate = 0.02;
+  link.delay_ms = 2;
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 64 * 1024;
+  FileTransferPair pair(link, config);
+
+  auto id = pair.sender().SendFile((source.path() / "data.bin").string());
+  ASSERT_TRUE(id.IsOk()) << id.Message();
+  ASSERT_TRUE(pair.PumpUntil(
+      [&] { return pair.sender_done() && pair.receiver_done(); }, 30s));
+
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  EXPECT_EQ(pair.sender_error(), ErrorCode::kSuccess);
+  EXPECT_EQ(ReadFile(download.path() / "data.bin"), content);
+  EXPECT_EQ(CountFilesWithSuffix(download.path(), ".part"), 0U);
+  EXPECT_EQ(CountFilesWithSuffix(download.path(), ".part.state"), 0U);
+
+  auto stats = pair.receiver().GetStats();
+  EXPECT_EQ(stats.bytes_received, content.size());
+  EXPECT_EQ(stats.chunks_received, 49U);
+  EXPECT_EQ(stats.checksum_failures, 0U);
+  EXPECT_EQ(pair.sender().GetStats().bytes_sent, content.size());
+}
+
+TEST(FileTransferServiceTest, ClampsWindowToChunksPerRequest) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(3000 * 64);
+  WriteFile(source.path() / "many.bin", content);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 64;
+  config.window_chunks = 4 * kMaxChunksPerRequest;
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "many.bin").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil(
+      [&] { return pair.sender_done() && pair.receiver_done(); }, 10s));
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  EXPECT_EQ(ReadFile(download.path() / "many.bin"), content);
+  EXPECT_EQ(pair.receiver().GetStats().chunks_received, 3000U);
+}
+
+TEST(FileTransferServiceTest, ResumesInterruptedTransfer) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(2 * 1024 * 1024);
+  const auto source_path = (source.path() / "resume.bin").string();
+  WriteFile(source_path, content);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 32 * 1024;
+  config.state_flush_interval = 8;
+
+  uint64_t first_session_bytes = 0;
+  {
+    FileTransferPair pair(ImpairedLoopback::Config{}, config);
+    ASSERT_TRUE(pair.sender().SendFile(source_path).IsOk());
+    ASSERT_TRUE(pair.PumpUntil(
+        [&] {
+          return pair.receiver().GetStats().bytes_received >=
+                 content.size() / 2;
+        },
+        10s));
+    first_session_bytes = pair.receiver().GetStats().bytes_received;
+    ASSERT_FALSE(pair.receiver_done());
+    // 连接中断：服务析构时保存续传状态
+  }
+  EXPECT_EQ(CountFilesWithSuffix(download.path(), ".part"), 1U);
+  EXPECT_EQ(CountFilesWithSuffix(download.path(), ".part.state"), 1U);
+
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+  ASSERT_TRUE(pair.sender().SendFile(source_path).IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.receiver_done(); }, 10s));
+
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  EXPECT_EQ(ReadFile(download.path() / "resume.bin"), content);
+  EXPECT_EQ(pair.receiver_info().bytes_resumed, first_session_bytes);
+  EXPECT_EQ(pair.receiver_info().bytes_transferred + first_session_bytes,
+            content.size());
+}
+
+TEST(FileTransferServiceTest, RestartsWhenSourceChanged) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(512 * 1024);
+  const auto source_path = (source.path() / "changed.bin").string();
+  WriteFile(source_path, content);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 16 * 1024;
+  {
+    FileTransferPair pair(ImpairedLoopback::Config{}, config);
+    ASSERT_TRUE(pair.sender().SendFile(source_path).IsOk());
+    ASSERT_TRUE(pair.PumpUntil(
+        [&] { return pair.receiver().GetStats().chunks_received >= 4; }, 10s));
+  }
+
+  // 源文件大小变化后 fingerprint 不同，不能复用旧数据
+  content = MakeFileContent(600 * 1024);
+  WriteFile(source_path, content);
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+  ASSERT_TRUE(pair.sender().SendFile(source_path).IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.receiver_done(); }, 10s));
+  EXPECT_EQ(pair.receiver_info().bytes_resumed, 0U);
+  EXPECT_EQ(ReadFile(download.path() / "changed.bin"), content);
+}
+
+TEST(FileTransferServiceTest, RerequestsCorruptedChunk) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(256 * 1024);
+  WriteFile(source.path() / "corrupt.bin", content);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 32 * 1024;
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  // 翻转第一个满载 DATA 报文末尾的一个字节，模拟传输层未察觉的损坏
+  bool corrupted = false;
+  pair.SetOnReceiverPacket([&](uint8_t* data, size_t length) {
+    if (!corrupted && length > 1000 &&
+        data[0] == static_cast<uint8_t>(TransportPacketType::kData)) {
+      data[length - 1] ^= 0xFF;
+      corrupted = true;
+    }
+  });
+
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "corrupt.bin").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.receiver_done(); }, 10s));
+
+  EXPECT_TRUE(corrupted);
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  EXPECT_EQ(pair.receiver().GetStats().checksum_failures, 1U);
+  EXPECT_EQ(ReadFile(download.path() / "corrupt.bin"), content);
+}
+
+TEST(FileTransferServiceTest, KeepsOfferedNameInsideDownloadDirectory) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(1000);
+  WriteFile(source.path() / "a.bin", content);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  ASSERT_TRUE(pair.sender()
+                  .SendFile((source.path() / "a.bin").string(),
+                            "../../escaped.bin")
+                  .IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.receiver_done(); }, 5s));
+  EXPECT_EQ(ReadFile(download.path() / "escaped.bin"), content);
+  EXPECT_FALSE(fs::exists(download.path().parent_path() / "escaped.bin"));
+
+  EXPECT_TRUE(pair.sender()
+                  .SendFile((source.path() / "a.bin").string(), "..")
+                  .IsErr());
+  EXPECT_EQ(pair.sender().SendFile((source.path() / "missing").string())
+                .Code(),
+            ErrorCode::kFileNotFound);
+}
+
+TEST(FileTransferServiceTest, TransfersEmptyFile) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  WriteFile(source.path() / "empty.bin", {});
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "empty.bin").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil(
+      [&] { return pair.sender_done() && pair.receiver_done(); }, 5s));
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  EXPECT_TRUE(fs::exists(download.path() / "empty.bin"));
+  EXPECT_EQ(fs::file_size(download.path() / "empty.bin"), 0U);
+}
+
+TEST(FileTransferServiceTest, ReceiverCancelNotifiesSender) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  WriteFile(source.path() / "big.bin", MakeFileContent(1024 * 1024));
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 16 * 1024;
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "big.bin").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil(
+      [&] { return pair.receiver().GetStats().chunks_received >= 2; }, 5s));
+
+  // 接收端的传输 ID 与发送端分配的一致
+  ASSERT_TRUE(pair.receiver()
+                  .CancelTransfer(1, FileTransferService::Direction::kReceive)
+                  .IsOk());
+  EXPECT_TRUE(pair.receiver_done());
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kInvalidOperation);
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.sender_done(); }, 5s));
+  EXPECT_EQ(pair.sender_error(), ErrorCode::kInvalidOperation);
+  // 保留部分数据以便之后续传
+  EXPECT_EQ(CountFilesWithSuffix(download.path(), ".part.state"), 1U);
+}
+
+TEST(FileTransferServiceTest, RejectsOfferWithoutConsent) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  WriteFile(source.path() / "unwanted.bin", MakeFileContent(4096));
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  std::string offered_name;
+  pair.receiver().SetOnOfferCallback(
+      [&](const FileTransferService::TransferInfo& info) {
+        offered_name = info.name;
+        return false;
+      });
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "unwanted.bin").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.sender_done(); }, 5s));
+  EXPECT_EQ(offered_name, "unwanted.bin");
+  EXPECT_EQ(pair.sender_error(), ErrorCode::kPermissionDenied);
+  EXPECT_TRUE(fs::is_empty(download.path()));
+
+  // 未设置回调时同样拒绝
+  pair.receiver().SetOnOfferCallback(nullptr);
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "unwanted.bin").string()).IsOk());
+  pair.PumpUntil([&] { return false; }, 200ms);
+  EXPECT_EQ(pair.sender_error(), ErrorCode::kPermissionDenied);
+  EXPECT_EQ(pair.receiver().GetStats().bytes_received, 0U);
+  EXPECT_TRUE(fs::is_empty(download.path()));
+}
+
+TEST(FileTransferServiceTest, DoesNotOverwriteExistingFile) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(8192);
+  auto existing = MakeFileContent(100);
+  WriteFile(source.path() / "report.txt", content);
+  WriteFile(download.path() / "report.txt", existing);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "report.txt").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.receiver_done(); }, 5s));
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  EXPECT_EQ(ReadFile(download.path() / "report.txt"), existing);
+  EXPECT_EQ(ReadFile(download.path() / "report (1).txt"), content);
+  EXPECT_EQ(fs::path(pair.receiver_info().path),
+            download.path() / "report (1).txt");
+}
+
+TEST(FileTransferServiceTest, ConcurrentSameNameOffersUseSeparatePartFiles) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  auto content = MakeFileContent(256 * 1024);
+  const auto source_path = (source.path() / "twice.bin").string();
+  WriteFile(source_path, content);
+
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  config.chunk_size = 16 * 1024;
+  config.window_chunks = 2;
+  FileTransferPair pair(ImpairedLoopback::Config{}, config);
+
+  int completed = 0;
+  int failed = 0;
+  pair.receiver().SetOnCompleteCallback(
+      [&](const FileTransferService::TransferInfo&,
+          const Result<void>& result) {
+        if (result.IsOk()) {
+          ++completed;
+        } else {
+          ++failed;
+        }
+      });
+
+  // 同一文件 fingerprint 相同，两个传输同时进行时不能共用 .part
+  ASSERT_TRUE(pair.sender().SendFile(source_path).IsOk());
+  ASSERT_TRUE(pair.sender().SendFile(source_path).IsOk());
+  ASSERT_TRUE(pair.PumpUntil(
+      [&] { return CountFilesWithSuffix(download.path(), ".part") == 2; },
+      5s));
+  ASSERT_TRUE(pair.PumpUntil([&] { return completed + failed == 2; }, 10s));
+
+  EXPECT_EQ(completed, 2);
+  EXPECT_EQ(ReadFile(download.path() / "twice.bin"), content);
+  EXPECT_EQ(ReadFile(download.path() / "twice (1).bin"), content);
+  EXPECT_EQ(CountFilesWithSuffix(download.path(), ".part"), 0U);
+}
+
+// ============================================================================
+// 基准测试（手动运行：--gtest_also_run_disabled_tests）
+// ============================================================================
+
+TEST(FileTransferServiceTest, DISABLED_BenchmarkGigabitThroughput) {
+  TempDirectory source("ft_src");
+  TempDirectory download("ft_dst");
+  constexpr size_t kFileSize = 256 * 1024 * 1024;
+  WriteFile(source.path() / "bench.bin", MakeFileContent(kFileSize));
+
+  ImpairedLoopback::Config link;
+  link.bandwidth_bps = 1000ULL * 1000 * 1000;
+  link.delay_ms = 1;
+  FileTransferService::Config config;
+  config.download_directory = download.path().string();
+  FileTransferPair pair(link, config);
+
+  const auto start = std::chrono::steady_clock::now();
+  const std::clock_t cpu_start = std::clock();
+  ASSERT_TRUE(
+      pair.sender().SendFile((source.path() / "bench.bin").string()).IsOk());
+  ASSERT_TRUE(pair.PumpUntil([&] { return pair.receiver_done(); }, 120s));
+  const double cpu_seconds =
+      static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  EXPECT_EQ(pair.receiver_error(), ErrorCode::kSuccess);
+  std::cout << "[ BENCH    ] 1 Gbit/s link, " << kFileSize / (1024 * 1024)
+            << " MiB file" << std::endl;
+  std::cout << "[ BENCH    ] elapsed " << seconds << " s, throughput "
+            << kFileSize * 8.0 / seconds / 1e6 << " Mbit/s" << std::endl;
+  std::cout << "[ BENCH    ] CPU time " << cpu_seconds << " s ("
+            << cpu_seconds / seconds * 100.0
+            << "% of one core, both endpoints and link)" << std::endl;
+}
+
+}  // namespace zenremote
@@ -0,0 +1,93 @@
+/**
+ * @file test_frame_size_limiter.cpp
+ * @brief FrameSizeLimiter 单帧大小上限与跳帧的测试
+ *
+ * 测试目标：
+ * - 上限 = 码率 × 延迟预算，至少一帧的平均大小，随码率更新
+ * - 平均大小附近波动的帧不触发跳帧
+ * - 超过上限的帧计入命中率，之后的帧跳过到超出部分按链路速率排空
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "media/pipeline/frame_size_limiter.h"
+
+namespace zenremote {
+
+namespace {
+
+using Clock = FrameSizeLimiter::Clock;
+using std::chrono::milliseconds;
+
+/// 1 MB/s、50fps（每帧平均 20000 字节），上限 60000 字节
+FrameSizeLimiterConfig MakeConfig() {
+  FrameSizeLimiterConfig config;
+  config.bitrate = 8000000;
+  config.framerate = 50;
+  config.latency_budget = milliseconds(60);
+  return config;
+}
+
+}  // namespace
+
+TEST(FrameSizeLimiterTest, CapFollowsBudgetAndBitrate) {
+  FrameSizeLimiter limiter(MakeConfig());
+  EXPECT_EQ(limiter.GetFrameCap(), 60000u);
+  limiter.SetBitrate(4000000);
+  EXPECT_EQ(limiter.GetFrameCap(), 30000u);
+
+  // 预算小于一个帧间隔：上限取一帧的平均大小
+  EXPECT_EQ(FrameSizeLimiter::ComputeFrameCap(8000000, 50, milliseconds(5)),
+            20000u);
+}
+
+TEST(FrameSizeLimiterTest, NormalFramesAreNotDropped) {
+  FrameSizeLimiter limiter(MakeConfig());
+  const auto t0 = Clock::time_point() + std::chrono::hours(1);
+  limiter.Reset(t0);
+  for (int i = 0; i < 200; ++i) {
+    const auto now = t0 + milliseconds(20 * i);
+    ASSERT_FALSE(limiter.ShouldDrop(now)) << "frame " << i;
+    EXPECT_FALSE(limiter.OnFrameEncoded(i % 2 == 0 ? 12000 : 28000, now));
+  }
+  EXPECT_EQ(limiter.GetStats().frames, 200u);
+  EXPECT_EQ(limiter.GetStats().frames_dropped, 0u);
+  EXPECT_EQ(limiter.GetStats().CapHitRate(), 0.0);
+  EXPECT_EQ(limiter.GetStats().max_frame_bytes, 28000u);
+}
+
+TEST(FrameSizeLimiterTest, OversizedFrameDrainsBeforeNextFrame) {
+  FrameSizeLimiter limiter(MakeConfig());
+  const auto t0 = Clock::time_point() + std::chrono::hours(1);
+  limiter.Reset(t0);
+
+  // 切换窗口：一帧相当于 10 个平均帧
+  ASSERT_FALSE(limiter.ShouldDrop(t0));
+  EXPECT_TRUE(limiter.OnFrameEncoded(200000, t0));
+
+  // 积压排空到 40000 字节（160ms）之前的帧都跳过
+  int dropped = 0;
+  auto now = t0 + milliseconds(20);
+  while (limiter.ShouldDrop(now)) {
+    ++dropped;
+    now += milliseconds(20);
+  }
+  EXPECT_EQ(dropped, 7);
+  EXPECT_EQ(now, t0 + milliseconds(160));
+  EXPECT_EQ(limiter.GetStats().frames_dropped, 7u);
+
+  // 之后的正常帧排队时间不超过预算
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_FALSE(limiter.OnFrameEncoded(20000, now));
+    EXPECT_LE(limiter.GetBacklog(), limiter.GetFrameCap());
+    now += milliseconds(20);
+    ASSERT_FALSE(limiter.ShouldDrop(now)) << "frame " << i;
+  }
+  EXPECT_EQ(limiter.GetStats().frames_over_cap, 1u);
+  EXPECT_DOUBLE_EQ(limiter.GetStats().CapHitRate(), 1.0 / 51.0);
+  EXPECT_EQ(limiter.GetStats().max_frame_bytes, 200000u);
+}
+
+}  // namespace zenremote
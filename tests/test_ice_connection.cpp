@@ -0,0 +1,576 @@
+/**
+ * @file test_ice_connection.cpp
+ * @brief STUN 编解码与 IceConnection 自动选路测试（多个本机回环地址）
+ *
+ * 测试目标：
+ * - STUN 报文往返，XOR 地址支持 IPv4/IPv6，与 RTP/可靠传输报文可区分
+ * - 候选优先级：本机 > peer-reflexive > 中继
+ * - 多条路径并行检查，提名 RTT 最低的路径而不是优先级最高的路径
+ * - 后台检查发现明显更快的路径后切换
+ * - 两个 IceConnection 互为对端（IPv4 + IPv6 回环），角色自动协商，数据双向可达
+ * - 第三方主机的检查不能抢占已选路径或翻转角色；配置 ICE 密码后未签名或
+ *   签错的检查被丢弃，签名正确的未知地址最多学到 max_peer_reflexive_pairs 个
+ * - PeerConnection kAuto 模式端到端传输 DataChannel 消息
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "network/connection/ice_connection.h"
+#include "network/connection/receive_loop.h"
+#include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
+#include "transport/peer_connection.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kResponderPort = 47351;
+constexpr uint16_t kAgentPortA = 47352;
+constexpr uint16_t kAgentPortB = 47353;
+constexpr uint16_t kPeerPortA = 47354;
+constexpr uint16_t kPeerPortB = 47355;
+constexpr uint16_t kSilentPort = 47356;
+constexpr uint16_t kAttackerPort = 47357;  ///< 47357-47360
+
+/**
+ * @brief 按固定延迟应答 Binding 请求的假对端，用来在回环上制造不同的 RTT
+ */
+class DelayedStunResponder {
+ public:
+  DelayedStunResponder(const std::string& address, int delay_ms)
+      : delay_ms_(delay_ms) {
+    UdpSocket::Config config;
+    config.local_ip = address;
+    config.local_port = kResponderPort;
+    config.recv_timeout_ms = 0;
+    socket_ = std::make_unique<UdpSocket>(config);
+    EXPECT_TRUE(socket_->Open());
+    thread_ = std::thread([this]() { Run(); });
+  }
+
+  ~DelayedStunResponder() {
+    stop_ = true;
+    thread_.join();
+  }
+
+  void SetDelay(int delay_ms) { delay_ms_ = delay_ms; }
+  Endpoint GetEndpoint(const std::string& address) const {
+    return {address, kResponderPort};
+  }
+
+ private:
+  struct Pending {
+    std::chrono::steady_clock::time_point due;
+    std::vector<uint8_t> bytes;
+    Endpoint to;
+  };
+
+  void Run() {
+    std::vector<uint8_t> buffer(2048);
+    std::deque<Pending> pending;
+    while (!stop_) {
+      size_t length = buffer.size();
+      Endpoint from;
+      if (socket_->RecvFrom(buffer.data(), length, from.address, from.port,
+                            1)) {
+        auto request = ParseStunMessage(buffer.data(), length);
+        if (request && request->message_class == StunClass::kRequest) {
+          StunMessage response;
+          response.message_class = StunClass::kSuccessResponse;
+          response.transaction_id = request->transaction_id;
+          response.AddXorAddress(StunAttributeType::kXorMappedAddress, from);
+          pending.push_back(
+              {std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(delay_ms_.load()),
+               SerializeStunMessage(response), from});
+        }
+      }
+      const auto now = std::chrono::steady_clock::now();
+      while (!pending.empty() && pending.front().due <= now) {
+        const auto& item = pending.front();
+        socket_->SendTo(item.bytes.data(), item.bytes.size(), item.to.address,
+                        item.to.port);
+        pending.pop_front();
+      }
+    }
+  }
+
+  std::unique_ptr<UdpSocket> socket_;
+  std::atomic<int> delay_ms_;
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+IceConnection::Config MakeIceConfig(std::vector<std::string> local_addresses,
+                                    uint16_t local_port,
+                                    std::vector<Endpoint> remote_candidates) {
+  IceConnection::Config config;
+  config.local_addresses = std::move(local_addresses);
+  config.local_port = local_port;
+  config.remote_candidates = std::move(remote_candidates);
+  config.connect_timeout_ms = 2000;
+  return config;
+}
+
+/// @brief 同时打开两个 IceConnection 并等待双方选定路径
+void OpenPair(IceConnection& a, IceConnection& b) {
+  Result<void> result_b = Result<void>::Ok();
+  std::thread open_b([&]() { result_b = b.Open(); });
+  auto result_a = a.Open();
+  open_b.join();
+  ASSERT_TRUE(result_a.IsOk()) << result_a.Message();
+  ASSERT_TRUE(result_b.IsOk()) << result_b.Message();
+}
+
+std::unique_ptr<UdpSocket> OpenAttackerSocket(uint16_t port) {
+  UdpSocket::Config config;
+  config.local_ip = "127.0.0.5";
+  config.local_port = port;
+  config.recv_timeout_ms = 0;
+  auto socket = std::make_unique<UdpSocket>(config);
+  EXPECT_TRUE(socket->Open());
+  return socket;
+}
+
+/**
+ * @brief 从 socket 发送带 USE-CANDIDATE 与最大 tie-breaker 的 Binding 请求
+ * @param key 非空时签名
+ */
+void SendHijackCheck(UdpSocket& socket,
+                     const Endpoint& to,
+                     const std::vector<uint8_t>& key = {}) {
+  static uint8_t next_id = 0;
+  StunMessage request;
+  request.transaction_id.fill(++next_id);
+  request.AddUint32(StunAttributeType::kPriority,
+                    ComputeCandidatePriority(IceCandidateType::kHost, 0xFFFF));
+  request.AddUint64(StunAttributeType::kIceControlling, UINT64_MAX);
+  request.AddFlag(StunAttributeType::kUseCandidate);
+  const auto bytes = key.empty() ? SerializeStunMessage(request)
+                                 : SerializeStunMessage(request, key);
+  socket.SendTo(bytes.data(), bytes.size(), to.address, to.port);
+}
+
+/// @brief 让 connection 在 Recv() 中处理已到达的检查（没有数据时超时返回）
+void DrainChecks(IceConnection& connection) {
+  std::vector<uint8_t> buffer(1500);
+  while (connection.Recv(buffer.data(), buffer.size(), 100).IsOk()) {
+  }
+}
+
+bool ReceivesStun(UdpSocket& socket) {
+  std::vector<uint8_t> buffer(1500);
+  size_t length = buffer.size();
+  Endpoint from;
+  return socket.RecvFrom(buffer.data(), length, from.address, from.port, 100) &&
+         IsStunMessage(buffer.data(), length);
+}
+
+}  // namespace
+
+TEST(StunMessageTest, RoundTripsAttributesAndXorAddresses) {
+  StunMessage message;
+  message.message_class = StunClass::kSuccessResponse;
+  for (size_t i = 0; i < message.transaction_id.size(); ++i) {
+    message.transaction_id[i] = static_cast<uint8_t>(i * 17);
+  }
+  message.AddUint32(StunAttributeType::kPriority, 0x6E7F00FF);
+  message.AddUint64(StunAttributeType::kIceControlling, 0x0123456789ABCDEFULL);
+  message.AddFlag(StunAttributeType::kUseCandidate);
+  ASSERT_TRUE(message.AddXorAddress(StunAttributeType::kXorMappedAddress,
+                                    {"192.168.1.20", 50000}));
+
+  const auto bytes = SerializeStunMessage(message);
+  ASSERT_EQ(bytes.size() % 4, 0U);
+  // Binding 成功响应的类型码为 0x0101
+  EXPECT_EQ(bytes[0], 0x01);
+  EXPECT_EQ(bytes[1], 0x01);
+
+  auto parsed = ParseStunMessage(bytes.data(), bytes.size());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_TRUE(parsed->IsBinding());
+  EXPECT_EQ(parsed->message_class, StunClass::kSuccessResponse);
+  EXPECT_EQ(parsed->transaction_id, message.transaction_id);
+  EXPECT_EQ(parsed->GetUint32(StunAttributeType::kPriority), 0x6E7F00FFU);
+  EXPECT_EQ(parsed->GetUint64(StunAttributeType::kIceControlling),
+            0x0123456789ABCDEFULL);
+  EXPECT_TRUE(parsed->Has(StunAttributeType::kUseCandidate));
+  EXPECT_FALSE(parsed->Has(StunAttributeType::kIceControlled));
+  auto address = parsed->GetXorAddress(StunAttributeType::kXorMappedAddress);
+  ASSERT_TRUE(address.has_value());
+  EXPECT_EQ(*address, (Endpoint{"192.168.1.20", 50000}));
+
+  StunMessage ipv6;
+  ASSERT_TRUE(ipv6.AddXorAddress(StunAttributeType::kXorMappedAddress,
+                                 {"2001:db8::1", 3478}));
+  const auto ipv6_bytes = SerializeStunMessage(ipv6);
+  auto ipv6_parsed = ParseStunMessage(ipv6_bytes.data(), ipv6_bytes.size());
+  ASSERT_TRUE(ipv6_parsed.has_value());
+  EXPECT_EQ(ipv6_parsed->message_class, StunClass::kRequest);
+  EXPECT_EQ(ipv6_parsed->GetXorAddress(StunAttributeType::kXorMappedAddress),
+            (Endpoint{"2001:db8::1", 3478}));
+}
+
+TEST(StunMessageTest, RejectsMalformedAndForeignPackets) {
+  StunMessage message;
+  message.AddUint32(StunAttributeType::kPriority, 1);
+  const auto bytes = SerializeStunMessage(message);
+  EXPECT_TRUE(IsStunMessage(bytes.data(), bytes.size()));
+  EXPECT_FALSE(ParseStunMessage(bytes.data(), bytes.size() - 4).has_value());
+
+  auto bad_length = bytes;
+  bad_length[3] = 6;  // 属性区长度必须是 4 的倍数
+  EXPECT_FALSE(ParseStunMessage(bad_length.data(), bad_length.size()));
+
+  // RTP (V=2) 与可靠传输报文 (0xD0) 不会被当成 STUN
+  auto rtp = bytes;
+  rtp[0] = 0x80;
+  EXPECT_FALSE(IsStunMessage(rtp.data(), rtp.size()));
+  auto transport = bytes;
+  transport[0] = 0xD0;
+  EXPECT_FALSE(IsStunMessage(transport.data(), transport.size()));
+}
+
+TEST(IceCandidateTest, PrioritiesFollowTypePreference) {
+  const uint32_t host = ComputeCandidatePriority(IceCandidateType::kHost, 0);
+  const uint32_t prflx =
+      ComputeCandidatePriority(IceCandidateType::kPeerReflexive, 0xFFFF);
+  const uint32_t relay =
+      ComputeCandidatePriority(IceCandidateType::kRelay, 0xFFFF);
+  EXPECT_GT(host, prflx);
+  EXPECT_GT(prflx, relay);
+  EXPECT_EQ(ComputeCandidatePriority(IceCandidateType::kHost, 0xFFFF),
+            (126U << 24U) | (0xFFFFU << 8U) | 255U);
+
+  // 两端各自计算的候选对优先级相同（只差控制方的 1）
+  EXPECT_EQ(ComputePairPriority(host, relay) - 1,
+            ComputePairPriority(relay, host));
+  EXPECT_GT(ComputePairPriority(host, host), ComputePairPriority(host, relay));
+
+  for (const auto& host_address : EnumerateHostAddresses(true, true)) {
+    EXPECT_NE(host_address.address.rfind("fe80", 0), 0U);
+  }
+}
+
+TEST(IceConnectionTest, NominatesLowestRttPathOverHigherPriority) {
+  // 优先级更高的 127.0.0.3 更慢
+  DelayedStunResponder slow("127.0.0.3", 30);
+  DelayedStunResponder fast("127.0.0.4", 0);
+
+  IceConnection connection;
+  ASSERT_TRUE(connection
+                  .Initialize(MakeIceConfig(
+                      {"127.0.0.1", "127.0.0.2"}, kAgentPortA,
+                      {slow.GetEndpoint("127.0.0.3"),
+                       fast.GetEndpoint("127.0.0.4")}))
+                  .IsOk());
+  EXPECT_EQ(connection.GetLocalCandidates().size(), 2U);
+
+  ASSERT_TRUE(connection.Open().IsOk());
+  auto path = connection.GetSelectedPath();
+  ASSERT_TRUE(path.has_value());
+  EXPECT_EQ(path->remote.address, "127.0.0.4");
+  EXPECT_LT(path->rtt_ms, 15.0);
+  EXPECT_TRUE(connection.IsControlling());
+  EXPECT_EQ(connection.GetType(), ConnectionType::kDirect);
+
+  const auto stats = connection.GetStats();
+  EXPECT_EQ(stats.candidate_pairs, 4U);
+  EXPECT_GE(stats.succeeded_pairs, 2U);
+  // 慢路径 30ms + 提名等待，远小于一次检查重传
+  EXPECT_LT(stats.setup_time_ms, 150.0);
+}
+
+TEST(IceConnectionTest, SwitchesToFasterPathInBackground) {
+  DelayedStunResponder first("127.0.0.3", 0);
+  DelayedStunResponder second("127.0.0.4", 40);
+
+  auto config = MakeIceConfig(
+      {"127.0.0.1"}, kAgentPortA,
+      {first.GetEndpoint("127.0.0.3"), second.GetEndpoint("127.0.0.4")});
+  config.keepalive_interval_ms = 20;
+  IceConnection connection;
+  ASSERT_TRUE(connection.Initialize(config).IsOk());
+  ASSERT_TRUE(connection.Open().IsOk());
+  ASSERT_EQ(connection.GetSelectedPath()->remote.address, "127.0.0.3");
+
+  // 后台检查的响应由接收线程处理
+  ReceiveLoop loop;
+  ASSERT_TRUE(
+      loop.Start(&connection, [](const uint8_t*, size_t) {}, nullptr).IsOk());
+
+  first.SetDelay(40);
+  second.SetDelay(0);
+  const auto deadline = std::chrono::steady_clock::now() + 3s;
+  while (connection.GetSelectedPath()->remote.address != "127.0.0.4" &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(10ms);
+  }
+  loop.Stop();
+
+  auto path = connection.GetSelectedPath();
+  EXPECT_EQ(path->remote.address, "127.0.0.4");
+  EXPECT_EQ(connection.GetStats().path_switches, 1U);
+}
+
+TEST(IceConnectionTest, TwoAgentsConnectOverMultipleLoopbackAddresses) {
+  IceConnection a;
+  IceConnection b;
+  ASSERT_TRUE(a.Initialize(MakeIceConfig({"127.0.0.1", "127.0.0.2", "::1"},
+                                         kAgentPortA,
+                                         {{"127.0.0.3", kAgentPortB},
+                                          {"127.0.0.4", kAgentPortB},
+                                          {"::1", kAgentPortB}}))
+                  .IsOk());
+  ASSERT_TRUE(b.Initialize(MakeIceConfig({"127.0.0.3", "127.0.0.4", "::1"},
+                                         kAgentPortB,
+                                         {{"127.0.0.1", kAgentPortA},
+                                          {"127.0.0.2", kAgentPortA},
+                                          {"::1", kAgentPortA}}))
+                  .IsOk());
+
+  Result<void> result_b = Result<void>::Ok();
+  std::thread open_b([&]() { result_b = b.Open(); });
+  auto result_a = a.Open();
+  open_b.join();
+  ASSERT_TRUE(result_a.IsOk()) << result_a.Message();
+  ASSERT_TRUE(result_b.IsOk()) << result_b.Message();
+
+  EXPECT_NE(a.IsControlling(), b.IsControlling());
+  // 2x2 IPv4 + 1x1 IPv6
+  EXPECT_EQ(a.GetStats().candidate_pairs, 5U);
+  EXPECT_LT(a.GetStats().setup_time_ms, 500.0);
+  EXPECT_LT(b.GetStats().setup_time_ms, 500.0);
+  EXPECT_LT(a.GetSelectedPath()->rtt_ms, 5.0);
+
+  // 检查与保活报文在 Recv() 内部消费，只返回数据
+  const std::string ping = "ping";
+  const std::string pong = "pong";
+  std::vector<uint8_t> buffer(1500);
+  ASSERT_TRUE(
+      a.Send(reinterpret_cast<const uint8_t*>(ping.data()), ping.size())
+          .IsOk());
+  auto received = b.Recv(buffer.data(), buffer.size(), 1000);
+  ASSERT_TRUE(received.IsOk());
+  EXPECT_EQ(std::string(buffer.begin(), buffer.begin() + received.Value()),
+            ping);
+
+  ASSERT_TRUE(
+      b.Send(reinterpret_cast<const uint8_t*>(pong.data()), pong.size())
+          .IsOk());
+  received = a.Recv(buffer.data(), buffer.size(), 1000);
+  ASSERT_TRUE(received.IsOk());
+  EXPECT_EQ(std::string(buffer.begin(), buffer.begin() + received.Value()),
+            pong);
+}
+
+TEST(IceConnectionTest, TimesOutWhenNoPathResponds) {
+  auto config =
+      MakeIceConfig({"127.0.0.1"}, kAgentPortA, {{"127.0.0.1", kSilentPort}});
+  config.connect_timeout_ms = 300;
+  IceConnection connection;
+  ASSERT_TRUE(connection.Initialize(config).IsOk());
+
+  const auto start = std::chrono::steady_clock::now();
+  auto result = connection.Open();
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_TRUE(result.IsErr());
+  EXPECT_EQ(result.Code(), ErrorCode::kConnectionTimeout);
+  EXPECT_LT(elapsed, 1s);
+  EXPECT_FALSE(connection.IsOpen());
+}
+
+TEST(IceConnectionTest, ThirdHostCannotStealSelectedPath) {
+  IceConnection a;
+  IceConnection b;
+  ASSERT_TRUE(a.Initialize(MakeIceConfig({"127.0.0.1"}, kAgentPortA,
+                                         {{"127.0.0.3", kAgentPortB}}))
+                  .IsOk());
+  ASSERT_TRUE(b.Initialize(MakeIceConfig({"127.0.0.3"}, kAgentPortB,
+                                         {{"127.0.0.1", kAgentPortA}}))
+                  .IsOk());
+  OpenPair(a, b);
+  const bool a_controlling = a.IsControlling();
+  ASSERT_NE(a_controlling, b.IsControlling());
+
+  // 受控方会跟随 USE-CANDIDATE，控制方会被最大的 tie-breaker 夺走角色
+  auto attacker = OpenAttackerSocket(kAttackerPort);
+  SendHijackCheck(*attacker, {"127.0.0.1", kAgentPortA});
+  SendHijackCheck(*attacker, {"127.0.0.3", kAgentPortB});
+  DrainChecks(a);
+  DrainChecks(b);
+
+  EXPECT_FALSE(ReceivesStun(*attacker));
+  EXPECT_EQ(a.IsControlling(), a_controlling);
+  EXPECT_EQ(b.IsControlling(), !a_controlling);
+  EXPECT_EQ(a.GetSelectedPath()->remote, (Endpoint{"127.0.0.3", kAgentPortB}));
+  EXPECT_EQ(b.GetSelectedPath()->remote, (Endpoint{"127.0.0.1", kAgentPortA}));
+  EXPECT_EQ(a.GetStats().candidate_pairs, 1U);
+  EXPECT_EQ(b.GetStats().candidate_pairs, 1U);
+  EXPECT_EQ(a.GetStats().checks_rejected, 1U);
+  EXPECT_EQ(b.GetStats().checks_rejected, 1U);
+
+  // 数据仍然发给真正的对端
+  const std::string ping = "ping";
+  std::vector<uint8_t> buffer(1500);
+  ASSERT_TRUE(
+      b.Send(reinterpret_cast<const uint8_t*>(ping.data()), ping.size())
+          .IsOk());
+  auto received = a.Recv(buffer.data(), buffer.size(), 1000);
+  ASSERT_TRUE(received.IsOk());
+  EXPECT_EQ(std::string(buffer.begin(), buffer.begin() + received.Value()),
+            ping);
+}
+
+TEST(IceConnectionTest, PasswordsAuthenticateChecks) {
+  const std::string password_a = GenerateIcePassword();
+  const std::string password_b = GenerateIcePassword();
+  ASSERT_EQ(password_a.size(), kIcePasswordLength);
+  ASSERT_NE(password_a, password_b);
+
+  auto config_a = MakeIceConfig({"127.0.0.1"}, kAgentPortA,
+                                {{"127.0.0.3", kAgentPortB}});
+  config_a.local_password = password_a;
+  config_a.remote_password = password_b;
+  config_a.max_peer_reflexive_pairs = 2;
+  auto config_b = MakeIceConfig({"127.0.0.3"}, kAgentPortB,
+                                {{"127.0.0.1", kAgentPortA}});
+  config_b.local_password = password_b;
+  config_b.remote_password = password_a;
+
+  {
+    // 都拿错了对端密码：双方互相丢弃检查，无法连通
+    auto mismatched_a = config_a;
+    mismatched_a.remote_password = GenerateIcePassword();
+    mismatched_a.connect_timeout_ms = 300;
+    auto mismatched_b = config_b;
+    mismatched_b.remote_password = GenerateIcePassword();
+    mismatched_b.connect_timeout_ms = 300;
+    IceConnection a;
+    IceConnection b;
+    ASSERT_TRUE(a.Initialize(mismatched_a).IsOk());
+    ASSERT_TRUE(b.Initialize(mismatched_b).IsOk());
+    Result<void> result_b = Result<void>::Ok();
+    std::thread open_b([&]() { result_b = b.Open(); });
+    EXPECT_EQ(a.Open().Code(), ErrorCode::kConnectionTimeout);
+    open_b.join();
+    EXPECT_EQ(result_b.Code(), ErrorCode::kConnectionTimeout);
+    EXPECT_GT(a.GetStats().checks_rejected, 0U);
+  }
+
+  auto only_local = config_a;
+  only_local.remote_password.clear();
+  EXPECT_EQ(IceConnection().Initialize(only_local).Code(),
+            ErrorCode::kInvalidParameter);
+
+  IceConnection a;
+  IceConnection b;
+  ASSERT_TRUE(a.Initialize(config_a).IsOk());
+  ASSERT_TRUE(b.Initialize(config_b).IsOk());
+  OpenPair(a, b);
+  const bool a_controlling = a.IsControlling();
+  const Endpoint a_endpoint{"127.0.0.1", kAgentPortA};
+
+  // 未签名与用错误密码签名的检查都被丢弃，不回复
+  auto attacker = OpenAttackerSocket(kAttackerPort);
+  const auto wrong_key = std::vector<uint8_t>(password_b.begin(),
+                                              password_b.end());
+  SendHijackCheck(*attacker, a_endpoint);
+  SendHijackCheck(*attacker, a_endpoint, wrong_key);
+  DrainChecks(a);
+  EXPECT_FALSE(ReceivesStun(*attacker));
+  EXPECT_EQ(a.GetStats().checks_rejected, 2U);
+  EXPECT_EQ(a.GetStats().candidate_pairs, 1U);
+  EXPECT_EQ(a.IsControlling(), a_controlling);
+  EXPECT_EQ(a.GetSelectedPath()->remote, (Endpoint{"127.0.0.3", kAgentPortB}));
+
+  // 持有密码的对端换了地址也能被学到，但数量有上限
+  const auto key = std::vector<uint8_t>(password_a.begin(), password_a.end());
+  std::vector<std::unique_ptr<UdpSocket>> sockets;
+  for (uint16_t i = 1; i <= 3; ++i) {
+    sockets.push_back(OpenAttackerSocket(kAttackerPort + i));
+  }
+  for (size_t i = 0; i < sockets.size(); ++i) {
+    StunMessage request;
+    request.transaction_id.fill(static_cast<uint8_t>(0x80 + i));
+    request.AddUint32(StunAttributeType::kPriority, 1);
+    const auto bytes = SerializeStunMessage(request, key);
+    sockets[i]->SendTo(bytes.data(), bytes.size(), a_endpoint.address,
+                   a_endpoint.port);
+  }
+  DrainChecks(a);
+  EXPECT_EQ(a.GetStats().candidate_pairs, 3U);
+  EXPECT_EQ(a.GetStats().checks_rejected, 3U);
+  EXPECT_TRUE(ReceivesStun(*sockets[0]));
+  EXPECT_FALSE(ReceivesStun(*sockets[2]));
+}
+
+TEST(PeerConnectionAutoTest, ConnectsAndExchangesDataChannelMessages) {
+  PeerConnection::Config config_a;
+  config_a.mode = PeerConnection::ConnectionMode::kAuto;
+  config_a.local_port = kPeerPortA;
+  config_a.local_candidates = {"127.0.0.1", "127.0.0.2"};
+  config_a.remote_candidates = {{"127.0.0.3", kPeerPortB},
+                                {"127.0.0.4", kPeerPortB}};
+  config_a.ice_local_password = GenerateIcePassword();
+  config_a.ice_remote_password = GenerateIcePassword();
+  PeerConnection::Config config_b = config_a;
+  config_b.local_port = kPeerPortB;
+  config_b.local_candidates = {"127.0.0.3", "127.0.0.4"};
+  config_b.remote_candidates = {{"127.0.0.1", kPeerPortA},
+                                {"127.0.0.2", kPeerPortA}};
+  std::swap(config_b.ice_local_password, config_b.ice_remote_password);
+
+  PeerConnection a;
+  PeerConnection b;
+  ASSERT_TRUE(a.Initialize(config_a).IsOk());
+  ASSERT_TRUE(b.Initialize(config_b).IsOk());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> messages;
+  b.SetOnDataChannelCallback([&](std::shared_ptr<DataChannel> channel) {
+    channel->SetOnMessageCallback([&](const uint8_t* data, size_t length) {
+      std::lock_guard<std::mutex> lock(mutex);
+      messages.emplace_back(reinterpret_cast<const char*>(data), length);
+      cv.notify_all();
+    });
+  });
+  auto channel = a.CreateDataChannel("control");
+  ASSERT_TRUE(channel.IsOk());
+
+  Result<void> result_b = Result<void>::Ok();
+  std::thread connect_b([&]() { result_b = b.Connect(); });
+  auto result_a = a.Connect();
+  connect_b.join();
+  ASSERT_TRUE(result_a.IsOk()) << result_a.Message();
+  ASSERT_TRUE(result_b.IsOk()) << result_b.Message();
+  EXPECT_TRUE(a.IsConnected());
+  EXPECT_TRUE(b.IsConnected());
+
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(channel.Value()->Send("msg-" + std::to_string(i)).IsOk());
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(cv.wait_for(lock, 3s, [&] { return messages.size() == 5; }));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(messages[i], "msg-" + std::to_string(i));
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,82 @@
+/**
+ * @file test_latency_histogram.cpp
+ * @brief LatencyHistogram 对数桶直方图测试
+ *
+ * 测试目标：
+ * - 分位数落在真实值所在的桶内（相对误差不超过一个桶宽）
+ * - 超出范围的值计入最后一个桶，最大值与均值精确
+ * - 多线程并发 Record() 不丢计数
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "common/latency_histogram.h"
+
+namespace zenremote {
+
+namespace {
+
+/// 相邻桶上界之比
+const double kBucketRatio = LatencyHistogram::BucketUpperBound(1) /
+                            LatencyHistogram::BucketUpperBound(0);
+
+}  // namespace
+
+TEST(LatencyHistogramTest, PercentilesWithinOneBucket) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.Record(i * 10.0);  // 10us .. 10ms 均匀分布
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 1000U);
+  EXPECT_DOUBLE_EQ(snapshot.max_us, 10000.0);
+  EXPECT_NEAR(snapshot.mean_us, 5005.0, 1.0);
+
+  EXPECT_GE(snapshot.p50_us, 5000.0);
+  EXPECT_LE(snapshot.p50_us, 5000.0 * kBucketRatio);
+  EXPECT_GE(snapshot.p90_us, 9000.0);
+  EXPECT_LE(snapshot.p90_us, 9000.0 * kBucketRatio);
+  EXPECT_GE(snapshot.p99_us, 9900.0);
+  EXPECT_LE(snapshot.p99_us, 10000.0);
+}
+
+TEST(LatencyHistogramTest, EmptyAndOutOfRangeValues) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.GetSnapshot().count, 0U);
+  EXPECT_DOUBLE_EQ(histogram.GetSnapshot().p99_us, 0.0);
+
+  histogram.Record(-5.0);
+  histogram.Record(10.0e6);  // 10 秒，超出最后一个桶的上界
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 2U);
+  EXPECT_LE(snapshot.p50_us, LatencyHistogram::kFirstBucketUs);
+  EXPECT_DOUBLE_EQ(snapshot.p99_us, 10.0e6);
+
+  histogram.Reset();
+  EXPECT_EQ(histogram.GetSnapshot().count, 0U);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecordKeepsEveryCount) {
+  LatencyHistogram histogram;
+  constexpr int kThreads = 4;
+  constexpr int kSamples = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&histogram, t]() {
+      for (int i = 0; i < kSamples; ++i) {
+        histogram.Record(100.0 * (t + 1));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, static_cast<uint64_t>(kThreads * kSamples));
+  EXPECT_DOUBLE_EQ(snapshot.max_us, 400.0);
+}
+
+}  // namespace zenremote
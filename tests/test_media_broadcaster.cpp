@@ -0,0 +1,589 @@
+/**
+ * @file test_media_broadcaster.cpp
+ * @brief 一对多广播（MediaBroadcaster / BroadcastTrack）与 RTCP 反馈测试
+ *
+ * 测试目标：
+ * - NACK / PLI 的序列化与解析（RFC 4585），与 RTP 包的区分
+ * - 每帧只打包一次，所有观看者收到同一份报文
+ * - 新观看者从关键帧开始接收，加入时的关键帧请求被合并
+ * - NACK 只向请求的观看者重传，历史之外的包计入 nack_misses
+ * - 关键帧请求按最小间隔限速，到期后补发一次
+ * - 慢速观看者积压过久时丢弃并等待关键帧，不影响其他观看者
+ * - 经 PeerConnection 的端到端广播与反馈
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loopback_impairment.h"
+#include "network/connection/direct_connection.h"
+#include "network/rtp/rtcp_feedback.h"
+#include "network/rtp/rtp_packet.h"
+#include "transport/peer_connection.h"
+#include "transport/track/broadcast_track.h"
+#include "transport/track/media_broadcaster.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kSenderPortA = 47391;
+constexpr uint16_t kViewerPortA = 47392;
+constexpr uint16_t kSenderPortB = 47393;
+constexpr uint16_t kViewerPortB = 47394;
+constexpr uint16_t kBenchSinkPort = 47395;
+
+struct ReceivedPacket {
+  uint16_t sequence_number = 0;
+  uint32_t ssrc = 0;
+  std::string payload;
+};
+
+/// @brief 从回环端点读取广播报文，直到收到 count 个或超时
+std::vector<ReceivedPacket> ReadPackets(BaseConnection* endpoint,
+                                        size_t count,
+                                        std::chrono::milliseconds timeout) {
+  std::vector<ReceivedPacket> packets;
+  std::vector<uint8_t> buffer(65536);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (packets.size() < count) {
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      break;
+    }
+    auto result = endpoint->Recv(buffer.data(), buffer.size(),
+                                 static_cast<int>(remaining.count()));
+    if (result.IsErr() || result.Value() < sizeof(network::RTPHeader)) {
+      continue;
+    }
+    network::RTPHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    ReceivedPacket packet;
+    packet.sequence_number = header.sequence_number;
+    packet.ssrc = header.ssrc;
+    packet.payload.assign(
+        reinterpret_cast<const char*>(buffer.data()) + sizeof(header),
+        result.Value() - sizeof(header));
+    packets.push_back(std::move(packet));
+  }
+  return packets;
+}
+
+Result<void> SendFrame(MediaBroadcaster& broadcaster,
+                       const std::string& frame,
+                       uint32_t timestamp,
+                       bool is_keyframe) {
+  return broadcaster.SendFrame(reinterpret_cast<const uint8_t*>(frame.data()),
+                               frame.size(), timestamp, is_keyframe);
+}
+
+/// @brief 编码器侧：记录转发来的关键帧请求
+class KeyFrameCounter {
+ public:
+  void Attach(MediaBroadcaster& broadcaster) {
+    broadcaster.SetOnKeyFrameRequestCallback([this]() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      count_++;
+      cv_.notify_all();
+    });
+  }
+
+  bool WaitFor(int count, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [&] { return count_ >= count; });
+  }
+
+  int count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int count_ = 0;
+};
+
+rtp::RtcpFeedback MakeNack(uint32_t ssrc, std::vector<uint16_t> sequences) {
+  rtp::RtcpFeedback feedback;
+  feedback.type = rtp::RtcpFeedback::Type::kNack;
+  feedback.media_ssrc = ssrc;
+  feedback.lost_sequences = std::move(sequences);
+  return feedback;
+}
+
+rtp::RtcpFeedback MakePli(uint32_t ssrc) {
+  rtp::RtcpFeedback feedback;
+  feedback.type = rtp::RtcpFeedback::Type::kPli;
+  feedback.media_ssrc = ssrc;
+  return feedback;
+}
+
+}  // namespace
+
+// ============================================================================
+// RTCP 反馈
+// ============================================================================
+
+TEST(RtcpFeedbackTest, NackRoundTripPacksBitmask) {
+  const std::vector<uint16_t> lost = {100, 101, 116, 117, 300, 65535};
+  auto packet = rtp::SerializeNack(7, 42, lost);
+  // 100 + BLP(101, 116)，117（偏移 17）另起一项，300、65535 各一项
+  EXPECT_EQ(packet.size(), rtp::kRtcpFeedbackHeaderSize + 4 * 4);
+  ASSERT_TRUE(rtp::IsRtcpPacket(packet.data(), packet.size()));
+
+  auto feedback = rtp::ParseRtcpFeedback(packet.data(), packet.size());
+  ASSERT_EQ(feedback.size(), 1U);
+  EXPECT_EQ(feedback[0].type, rtp::RtcpFeedback::Type::kNack);
+  EXPECT_EQ(feedback[0].sender_ssrc, 7U);
+  EXPECT_EQ(feedback[0].media_ssrc, 42U);
+  EXPECT_EQ(feedback[0].lost_sequences, lost);
+}
+
+TEST(RtcpFeedbackTest, CompoundPacketWithPli) {
+  auto packet = rtp::SerializePli(1, 2);
+  auto nack = rtp::SerializeNack(1, 3, {9});
+  packet.insert(packet.end(), nack.begin(), nack.end());
+
+  auto feedback = rtp::ParseRtcpFeedback(packet.data(), packet.size());
+  ASSERT_EQ(feedback.size(), 2U);
+  EXPECT_EQ(feedback[0].type, rtp::RtcpFeedback::Type::kPli);
+  EXPECT_EQ(feedback[0].media_ssrc, 2U);
+  EXPECT_EQ(feedback[1].type, rtp::RtcpFeedback::Type::kNack);
+  EXPECT_EQ(feedback[1].lost_sequences, std::vector<uint16_t>{9});
+
+  // 截断的包只解析完整的部分
+  feedback = rtp::ParseRtcpFeedback(packet.data(), packet.size() - 2);
+  EXPECT_EQ(feedback.size(), 1U);
+}
+
+TEST(RtcpFeedbackTest, MediaPacketsAreNotRtcp) {
+  auto broadcaster = std::make_shared<MediaBroadcaster>();
+  auto track = broadcaster->CreateTrack("video0");
+  ImpairedLoopback link({});
+  track->SetConnection(link.a());
+  ASSERT_TRUE(SendFrame(*broadcaster, "key", 0, true).IsOk());
+
+  std::vector<uint8_t> buffer(2048);
+  auto result = link.b()->Recv(buffer.data(), buffer.size(), 1000);
+  ASSERT_TRUE(result.IsOk());
+  EXPECT_FALSE(rtp::IsRtcpPacket(buffer.data(), result.Value()));
+  track->SetConnection(nullptr);
+}
+
+// ============================================================================
+// MediaBroadcaster
+// ============================================================================
+
+TEST(MediaBroadcasterTest, FramesArePacketizedOnceForAllViewers) {
+  auto broadcaster = std::make_shared<MediaBroadcaster>();
+  KeyFrameCounter keyframes;
+  keyframes.Attach(*broadcaster);
+
+  constexpr size_t kViewers = 3;
+  std::vector<std::unique_ptr<ImpairedLoopback>> links;
+  std::vector<std::shared_ptr<BroadcastTrack>> tracks;
+  for (size_t i = 0; i < kViewers; ++i) {
+    links.push_back(std::make_unique<ImpairedLoopback>(
+        ImpairedLoopback::Config{}));
+    tracks.push_back(broadcaster->CreateTrack("video0"));
+    tracks.back()->SetConnection(links.back()->a());
+    EXPECT_EQ(tracks.back()->GetSSRC(), broadcaster->GetSSRC());
+  }
+
+  // 三个观看者加入只触发一次编码器关键帧
+  ASSERT_TRUE(keyframes.WaitFor(1, 1s));
+  ASSERT_TRUE(SendFrame(*broadcaster, std::string(3000, 'K'), 0, true).IsOk());
+  for (uint32_t i = 1; i < 5; ++i) {
+    ASSERT_TRUE(
+        SendFrame(*broadcaster, "delta" + std::to_string(i), i * 3000, false)
+            .IsOk());
+  }
+
+  for (size_t v = 0; v < kViewers; ++v) {
+    auto packets = ReadPackets(links[v]->b(), 5, 2s);
+    ASSERT_EQ(packets.size(), 5U) << "viewer " << v;
+    EXPECT_EQ(packets[0].payload, std::string(3000, 'K'));
+    EXPECT_EQ(packets[4].payload, "delta4");
+    for (size_t i = 0; i < packets.size(); ++i) {
+      EXPECT_EQ(packets[i].ssrc, broadcaster->GetSSRC());
+      EXPECT_EQ(packets[i].sequence_number,
+                static_cast<uint16_t>(packets[0].sequence_number + i));
+    }
+    EXPECT_EQ(tracks[v]->GetStats().packets_sent, 5U);
+  }
+
+  auto stats = broadcaster->GetStats();
+  EXPECT_EQ(stats.frames_sent, 5U);
+  EXPECT_EQ(stats.viewers, kViewers);
+  EXPECT_EQ(stats.keyframe_requests, kViewers);
+  EXPECT_EQ(stats.keyframes_requested, 1U);
+  EXPECT_EQ(keyframes.count(), 1);
+
+  EXPECT_EQ(tracks[0]->SendFrame(nullptr, 0, 0).Code(),
+            ErrorCode::kInvalidOperation);
+  for (auto& track : tracks) {
+    track->SetConnection(nullptr);
+  }
+  EXPECT_EQ(broadcaster->GetStats().viewers, 0U);
+}
+
+TEST(MediaBroadcasterTest, LateViewerStartsAtKeyFrame) {
+  MediaBroadcaster::Config config;
+  config.min_keyframe_interval_ms = 0;
+  auto broadcaster = std::make_shared<MediaBroadcaster>(config);
+  KeyFrameCounter keyframes;
+  keyframes.Attach(*broadcaster);
+
+  ImpairedLoopback early_link({});
+  ImpairedLoopback late_link({});
+  auto early = broadcaster->CreateTrack("video0");
+  auto late = broadcaster->CreateTrack("video0");
+  early->SetConnection(early_link.a());
+  ASSERT_TRUE(SendFrame(*broadcaster, "key1", 0, true).IsOk());
+  ASSERT_TRUE(SendFrame(*broadcaster, "delta1", 3000, false).IsOk());
+
+  late->SetConnection(late_link.a());
+  ASSERT_TRUE(keyframes.WaitFor(2, 1s));
+  // 加入后的增量帧无法解码，不发送给新观看者
+  ASSERT_TRUE(SendFrame(*broadcaster, "delta2", 6000, false).IsOk());
+  ASSERT_TRUE(SendFrame(*broadcaster, "key2", 9000, true).IsOk());
+  ASSERT_TRUE(SendFrame(*broadcaster, "delta3", 12000, false).IsOk());
+
+  auto early_packets = ReadPackets(early_link.b(), 5, 2s);
+  ASSERT_EQ(early_packets.size(), 5U);
+  auto late_packets = ReadPackets(late_link.b(), 2, 2s);
+  ASSERT_EQ(late_packets.size(), 2U);
+  EXPECT_EQ(late_packets[0].payload, "key2");
+  EXPECT_EQ(late_packets[1].payload, "delta3");
+  EXPECT_EQ(late->GetStats().packets_dropped, 1U);
+
+  // 停用后重新启用同样从关键帧开始
+  late->SetEnabled(false);
+  ASSERT_TRUE(SendFrame(*broadcaster, "delta4", 15000, false).IsOk());
+  late->SetEnabled(true);
+  ASSERT_TRUE(keyframes.WaitFor(3, 1s));
+  ASSERT_TRUE(SendFrame(*broadcaster, "delta5", 18000, false).IsOk());
+  ASSERT_TRUE(SendFrame(*broadcaster, "key3", 21000, true).IsOk());
+  late_packets = ReadPackets(late_link.b(), 1, 2s);
+  ASSERT_EQ(late_packets.size(), 1U);
+  EXPECT_EQ(late_packets[0].payload, "key3");
+
+  early->SetConnection(nullptr);
+  late->SetConnection(nullptr);
+}
+
+TEST(MediaBroadcasterTest, NackRetransmitsOnlyToRequestingViewer) {
+  MediaBroadcaster::Config config;
+  config.history_size = 4;
+  auto broadcaster = std::make_shared<MediaBroadcaster>(config);
+  ImpairedLoopback lossy_link({});
+  ImpairedLoopback clean_link({});
+  auto lossy = broadcaster->CreateTrack("video0");
+  auto clean = broadcaster->CreateTrack("video0");
+  lossy->SetConnection(lossy_link.a());
+  clean->SetConnection(clean_link.a());
+
+  for (uint32_t i = 0; i < 6; ++i) {
+    ASSERT_TRUE(SendFrame(*broadcaster, "frame" + std::to_string(i),
+                          i * 3000, i == 0)
+                    .IsOk());
+  }
+  auto packets = ReadPackets(lossy_link.b(), 6, 2s);
+  ASSERT_EQ(packets.size(), 6U);
+  ASSERT_EQ(ReadPackets(clean_link.b(), 6, 2s).size(), 6U);
+  const uint16_t first = packets[0].sequence_number;
+
+  // 历史只保留最近 4 个包：frame0 已淘汰
+  lossy->OnRtcpFeedback(MakeNack(broadcaster->GetSSRC(),
+                                 {first, static_cast<uint16_t>(first + 3),
+                                  static_cast<uint16_t>(first + 5)}));
+
+  auto retransmitted = ReadPackets(lossy_link.b(), 2, 2s);
+  ASSERT_EQ(retransmitted.size(), 2U);
+  EXPECT_EQ(retransmitted[0].payload, "frame3");
+  EXPECT_EQ(retransmitted[0].sequence_number, first + 3);
+  EXPECT_EQ(retransmitted[1].payload, "frame5");
+  EXPECT_TRUE(ReadPackets(clean_link.b(), 1, 100ms).empty());
+
+  auto stats = lossy->GetStats();
+  EXPECT_EQ(stats.packets_retransmitted, 2U);
+  EXPECT_EQ(stats.nack_misses, 1U);
+  EXPECT_EQ(stats.packets_sent, 8U);
+  EXPECT_EQ(clean->GetStats().packets_retransmitted, 0U);
+
+  lossy->SetConnection(nullptr);
+  clean->SetConnection(nullptr);
+}
+
+TEST(MediaBroadcasterTest, KeyFrameRequestsAreRateLimited) {
+  MediaBroadcaster::Config config;
+  config.min_keyframe_interval_ms = 200;
+  auto broadcaster = std::make_shared<MediaBroadcaster>(config);
+  KeyFrameCounter keyframes;
+  keyframes.Attach(*broadcaster);
+
+  ImpairedLoopback link_a({});
+  ImpairedLoopback link_b({});
+  auto viewer_a = broadcaster->CreateTrack("video0");
+  auto viewer_b = broadcaster->CreateTrack("video0");
+  viewer_a->SetConnection(link_a.a());
+  viewer_b->SetConnection(link_b.a());
+  ASSERT_TRUE(keyframes.WaitFor(1, 1s));
+  ASSERT_TRUE(SendFrame(*broadcaster, "key", 0, true).IsOk());
+
+  // 间隔内的 PLI 合并为一次，到期后由调度线程转发
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; ++i) {
+    auto& viewer = (i % 2 == 0) ? viewer_a : viewer_b;
+    viewer->OnRtcpFeedback(MakePli(broadcaster->GetSSRC()));
+  }
+  EXPECT_EQ(keyframes.count(), 1);
+  ASSERT_TRUE(keyframes.WaitFor(2, 2s));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 150ms);
+  std::this_thread::sleep_for(300ms);
+  EXPECT_EQ(keyframes.count(), 2);
+
+  // 关键帧满足等待中的请求
+  ASSERT_TRUE(SendFrame(*broadcaster, "key", 3000, true).IsOk());
+  viewer_a->OnRtcpFeedback(MakePli(broadcaster->GetSSRC()));
+  ASSERT_TRUE(SendFrame(*broadcaster, "key", 6000, true).IsOk());
+  std::this_thread::sleep_for(300ms);
+  EXPECT_EQ(keyframes.count(), 2);
+
+  auto stats = broadcaster->GetStats();
+  EXPECT_EQ(stats.keyframe_requests, 13U);
+  EXPECT_EQ(stats.keyframes_requested, 2U);
+  EXPECT_EQ(viewer_a->GetStats().keyframe_requests, 6U);
+  EXPECT_EQ(viewer_b->GetStats().keyframe_requests, 5U);
+
+  viewer_a->SetConnection(nullptr);
+  viewer_b->SetConnection(nullptr);
+}
+
+TEST(MediaBroadcasterTest, SlowViewerDropsBacklogWithoutStallingOthers) {
+  MediaBroadcaster::Config config;
+  config.max_queue_delay_ms = 100;
+  config.min_keyframe_interval_ms = 0;
+  auto broadcaster = std::make_shared<MediaBroadcaster>(config);
+  KeyFrameCounter keyframes;
+  keyframes.Attach(*broadcaster);
+
+  ImpairedLoopback fast_link({});
+  ImpairedLoopback slow_link({});
+  auto fast = broadcaster->CreateTrack("video0");
+  auto slow = broadcaster->CreateTrack("video0");
+  slow->SetPacingBitrate(80000);  // 10 字节/ms
+  fast->SetConnection(fast_link.a());
+  slow->SetConnection(slow_link.a());
+  ASSERT_TRUE(keyframes.WaitFor(1, 1s));
+
+  // 30 帧 × 2000 字节，慢速观看者每帧要 200ms
+  const std::string frame(2000, 'x');
+  for (uint32_t i = 0; i < 30; ++i) {
+    ASSERT_TRUE(SendFrame(*broadcaster, frame, i * 3000, i == 0).IsOk());
+    std::this_thread::sleep_for(10ms);
+  }
+
+  EXPECT_EQ(ReadPackets(fast_link.b(), 30, 2s).size(), 30U);
+  auto slow_stats = slow->GetStats();
+  EXPECT_GT(slow_stats.packets_dropped, 0U);
+  EXPECT_LT(slow_stats.packets_sent, 10U);
+  EXPECT_EQ(fast->GetStats().packets_dropped, 0U);
+  // 积压丢弃后请求关键帧
+  EXPECT_GE(keyframes.count(), 2);
+
+  fast->SetConnection(nullptr);
+  slow->SetConnection(nullptr);
+}
+
+TEST(MediaBroadcasterTest, BroadcastsThroughPeerConnections) {
+  auto broadcaster = std::make_shared<MediaBroadcaster>();
+  KeyFrameCounter keyframes;
+  keyframes.Attach(*broadcaster);
+
+  auto make_config = [](uint16_t local_port, uint16_t remote_port) {
+    PeerConnection::Config config;
+    config.mode = PeerConnection::ConnectionMode::kDirect;
+    config.remote_ip = "127.0.0.1";
+    config.remote_port = remote_port;
+    config.local_port = local_port;
+    return config;
+  };
+
+  const uint16_t sender_ports[] = {kSenderPortA, kSenderPortB};
+  const uint16_t viewer_ports[] = {kViewerPortA, kViewerPortB};
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::map<int, std::vector<std::string>> frames;
+  std::map<int, uint32_t> remote_ssrcs;
+
+  std::vector<std::unique_ptr<PeerConnection>> senders;
+  std::vector<std::unique_ptr<PeerConnection>> viewers;
+  for (int i = 0; i < 2; ++i) {
+    auto viewer = std::make_unique<PeerConnection>();
+    ASSERT_TRUE(
+        viewer->Initialize(make_config(viewer_ports[i], sender_ports[i]))
+            .IsOk());
+    viewer->SetOnTrackCallback([&, i](std::shared_ptr<MediaTrack> track) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        remote_ssrcs[i] = track->GetSSRC();
+      }
+      track->SetOnFrameCallback(
+          [&, i](const uint8_t* data, size_t length, uint32_t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            frames[i].emplace_back(reinterpret_cast<const char*>(data),
+                                   length);
+            cv.notify_all();
+          });
+    });
+    ASSERT_TRUE(viewer->Connect().IsOk());
+
+    auto sender = std::make_unique<PeerConnection>();
+    ASSERT_TRUE(
+        sender->Initialize(make_config(sender_ports[i], viewer_ports[i]))
+            .IsOk());
+    ASSERT_TRUE(sender->AddTrack(broadcaster->CreateTrack("video0")).IsOk());
+    ASSERT_TRUE(sender->Connect().IsOk());
+    viewers.push_back(std::move(viewer));
+    senders.push_back(std::move(sender));
+  }
+
+  ASSERT_TRUE(keyframes.WaitFor(1, 1s));
+  ASSERT_TRUE(SendFrame(*broadcaster, "key", 0, true).IsOk());
+  ASSERT_TRUE(SendFrame(*broadcaster, "delta", 3000, false).IsOk());
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 3s, [&] {
+      return frames[0].size() >= 2 && frames[1].size() >= 2;
+    }));
+    EXPECT_EQ(frames[0][0], "key");
+    EXPECT_EQ(frames[1][1], "delta");
+    EXPECT_EQ(remote_ssrcs[0], broadcaster->GetSSRC());
+  }
+
+  // 观看者经 RTCP 请求重传与关键帧
+  auto track = std::static_pointer_cast<BroadcastTrack>(
+      senders[1]->GetTrack("video0"));
+  ASSERT_TRUE(track);
+  // 广播器的序列号从 0 开始："key" 为 0，"delta" 为 1
+  ASSERT_TRUE(viewers[1]->SendNack(broadcaster->GetSSRC(), {0, 1}).IsOk());
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 3s, [&] { return frames[1].size() >= 4; }));
+    EXPECT_EQ(frames[1][2], "key");
+    EXPECT_EQ(frames[0].size(), 2U);
+  }
+  EXPECT_EQ(track->GetStats().packets_retransmitted, 2U);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      broadcaster->GetConfig().min_keyframe_interval_ms));
+  ASSERT_TRUE(viewers[0]->RequestKeyFrame(broadcaster->GetSSRC()).IsOk());
+  ASSERT_TRUE(keyframes.WaitFor(2, 2s));
+
+  for (auto& sender : senders) {
+    sender->Disconnect();
+  }
+  for (auto& viewer : viewers) {
+    viewer->Disconnect();
+  }
+  EXPECT_EQ(broadcaster->GetStats().viewers, 0U);
+}
+
+// ============================================================================
+// 基准测试（手动运行：--gtest_also_run_disabled_tests）
+// ============================================================================
+
+TEST(MediaBroadcasterTest, DISABLED_BenchmarkCpuPerViewer) {
+  // 60 fps、每帧 20 KB（约 10 Mbit/s），经本机 UDP 发送；接收端不读取，
+  // 只计发送侧开销。采集与编码只有一路，不在测量范围内。
+  constexpr int kFrames = 3000;
+  constexpr size_t kFrameSize = 20000;
+  const std::string frame(kFrameSize, 'f');
+
+  DirectConnection::Config sink_config;
+  sink_config.local_port = kBenchSinkPort;
+  sink_config.remote = {"127.0.0.1", kBenchSinkPort};
+  DirectConnection sink;
+  ASSERT_TRUE(sink.Initialize(sink_config).IsOk());
+
+  // 第一轮只用于预热（socket 缓冲区、分配器），不输出
+  double single_viewer_us = 0;
+  for (size_t viewers : {1, 1, 2, 4, 8, 16, 32}) {
+    MediaBroadcaster::Config config;
+    config.pacing_bitrate_bps = 1000000000;
+    auto broadcaster = std::make_shared<MediaBroadcaster>(config);
+    std::vector<std::unique_ptr<DirectConnection>> connections;
+    std::vector<std::shared_ptr<BroadcastTrack>> tracks;
+    for (size_t i = 0; i < viewers; ++i) {
+      DirectConnection::Config conn_config;
+      conn_config.remote = {"127.0.0.1", kBenchSinkPort};
+      connections.push_back(std::make_unique<DirectConnection>());
+      ASSERT_TRUE(connections.back()->Initialize(conn_config).IsOk());
+      tracks.push_back(broadcaster->CreateTrack("video0"));
+      tracks.back()->SetConnection(connections.back().get());
+    }
+
+    const std::clock_t cpu_start = std::clock();
+    for (int i = 0; i < kFrames; ++i) {
+      ASSERT_TRUE(SendFrame(*broadcaster, frame, i * 1500, i == 0).IsOk());
+    }
+    const uint64_t expected = static_cast<uint64_t>(kFrames) * viewers;
+    const auto deadline = std::chrono::steady_clock::now() + 10s;
+    uint64_t sent = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+      sent = 0;
+      for (auto& track : tracks) {
+        auto stats = track->GetStats();
+        sent += stats.packets_sent + stats.send_errors;
+      }
+      if (sent >= expected) {
+        break;
+      }
+      std::this_thread::sleep_for(1ms);
+    }
+    const double cpu_us =
+        static_cast<double>(std::clock() - cpu_start) * 1e6 / CLOCKS_PER_SEC;
+    EXPECT_EQ(sent, expected);
+
+    const double per_frame_us = cpu_us / kFrames;
+    for (auto& track : tracks) {
+      track->SetConnection(nullptr);
+    }
+    if (viewers == 1) {
+      const bool warmup = single_viewer_us == 0;
+      single_viewer_us = per_frame_us;
+      if (warmup) {
+        continue;
+      }
+    }
+    std::cout << "[ BENCH    ] " << viewers << " viewers: " << per_frame_us
+              << " us CPU per frame";
+    if (viewers > 1) {
+      std::cout << ", +"
+                << (per_frame_us - single_viewer_us) / (viewers - 1)
+                << " us per additional viewer";
+    }
+    std::cout << " (" << per_frame_us * 60 / 1e4
+              << "% of one core at 60 fps)" << std::endl;
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,349 @@
+/**
+ * @file test_peer_connection.cpp
+ * @brief PeerConnection 数据通道复用与媒体接收测试（本机 UDP 回环）
+ *
+ * 测试目标：
+ * - 多个 DataChannel 共享一个连接，按流 ID 区分
+ * - 对端通过 OPEN 消息自动创建同名通道
+ * - 两端以相同 ID 创建的协商通道
+ * - 两端各自创建通道时按角色分配奇偶流 ID，不会撞号；撞号且名称不同的
+ *   对端通道被拒绝，消息不会交给本地通道
+ * - 对端轨道的首个 RTP 包触发 OnTrackCallback，帧交付到 OnFrameCallback
+ * - 只 Initialize() 未 Connect() 的对象可以安全断开与析构
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "transport/peer_connection.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kPortA = 47321;
+constexpr uint16_t kPortB = 47322;
+constexpr uint16_t kMediaPortA = 47323;
+constexpr uint16_t kMediaPortB = 47324;
+constexpr uint16_t kRolePortA = 47325;
+constexpr uint16_t kRolePortB = 47326;
+constexpr uint16_t kConflictPortA = 47327;
+constexpr uint16_t kConflictPortB = 47328;
+constexpr uint16_t kUnconnectedPort = 47329;
+
+PeerConnection::Config MakeConfig(uint16_t local_port,
+                                  uint16_t remote_port,
+                                  bool controlling = false) {
+  PeerConnection::Config config;
+  config.mode = PeerConnection::ConnectionMode::kDirect;
+  config.remote_ip = "127.0.0.1";
+  config.remote_port = remote_port;
+  config.local_port = local_port;
+  config.controlling = controlling;
+  return config;
+}
+
+/**
+ * @brief 收集各通道收到的文本消息（回调在接收线程执行）
+ */
+class MessageLog {
+ public:
+  void Attach(const std::shared_ptr<DataChannel>& channel) {
+    const std::string label = channel->GetLabel();
+    channel->SetOnMessageCallback([this, label](const uint8_t* data,
+                                                size_t length) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      messages_[label].emplace_back(reinterpret_cast<const char*>(data),
+                                    length);
+      cv_.notify_all();
+    });
+  }
+
+  bool WaitFor(const std::string& label, size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, 3s,
+                        [&] { return messages_[label].size() >= count; });
+  }
+
+  std::vector<std::string> Get(const std::string& label) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messages_[label];
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<std::string, std::vector<std::string>> messages_;
+};
+
+}  // namespace
+
+TEST(PeerConnectionTest, RemoteChannelsAreCreatedFromOpenMessages) {
+  PeerConnection local;
+  PeerConnection remote;
+  ASSERT_TRUE(local.Initialize(MakeConfig(kPortA, kPortB)).IsOk());
+  ASSERT_TRUE(remote.Initialize(MakeConfig(kPortB, kPortA)).IsOk());
+
+  MessageLog log;
+  std::mutex remote_mutex;
+  std::vector<std::string> remote_labels;
+  remote.SetOnDataChannelCallback([&](std::shared_ptr<DataChannel> channel) {
+    log.Attach(channel);
+    std::lock_guard<std::mutex> lock(remote_mutex);
+    remote_labels.push_back(channel->GetLabel());
+  });
+
+  DataChannel::Config input_config;
+  input_config.priority = DataChannel::Priority::kHigh;
+  auto input = local.CreateDataChannel("input", input_config);
+  auto clipboard = local.CreateDataChannel("clipboard");
+  ASSERT_TRUE(input.IsOk());
+  ASSERT_TRUE(clipboard.IsOk());
+  EXPECT_NE(input.Value()->GetId(), clipboard.Value()->GetId());
+
+  ASSERT_TRUE(remote.Connect().IsOk());
+  ASSERT_TRUE(local.Connect().IsOk());
+
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(input.Value()->Send("event-" + std::to_string(i)).IsOk());
+  }
+  ASSERT_TRUE(clipboard.Value()->Send(std::string(200 * 1024, 'c')).IsOk());
+
+  ASSERT_TRUE(log.WaitFor("input", 10));
+  ASSERT_TRUE(log.WaitFor("clipboard", 1));
+  auto events = log.Get("input");
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(events[i], "event-" + std::to_string(i));
+  }
+  EXPECT_EQ(log.Get("clipboard")[0].size(), 200U * 1024);
+
+  ASSERT_NE(remote.GetDataChannel("input"), nullptr);
+  EXPECT_EQ(remote.GetDataChannel("input")->GetId(), input.Value()->GetId());
+  {
+    std::lock_guard<std::mutex> lock(remote_mutex);
+    EXPECT_EQ(remote_labels.size(), 2U);
+  }
+
+  local.Disconnect();
+  remote.Disconnect();
+}
+
+TEST(PeerConnectionTest, NegotiatedChannelsShareStreamId) {
+  PeerConnection local;
+  PeerConnection remote;
+  ASSERT_TRUE(local.Initialize(MakeConfig(kPortA, kPortB)).IsOk());
+  ASSERT_TRUE(remote.Initialize(MakeConfig(kPortB, kPortA)).IsOk());
+
+  DataChannel::Config config;
+  config.id = 7;
+  auto local_channel = local.CreateDataChannel("control", config);
+  auto remote_channel = remote.CreateDataChannel("control", config);
+  ASSERT_TRUE(local_channel.IsOk());
+  ASSERT_TRUE(remote_channel.IsOk());
+  EXPECT_TRUE(local.CreateDataChannel("other", config).IsErr());
+
+  MessageLog local_log;
+  MessageLog remote_log;
+  local_log.Attach(local_channel.Value());
+  remote_log.Attach(remote_channel.Value());
+
+  ASSERT_TRUE(remote.Connect().IsOk());
+  ASSERT_TRUE(local.Connect().IsOk());
+
+  ASSERT_TRUE(local_channel.Value()->Send("ping").IsOk());
+  ASSERT_TRUE(remote_log.WaitFor("control", 1));
+  ASSERT_TRUE(remote_channel.Value()->Send("pong").IsOk());
+  ASSERT_TRUE(local_log.WaitFor("control", 1));
+  EXPECT_EQ(remote_log.Get("control")[0], "ping");
+  EXPECT_EQ(local_log.Get("control")[0], "pong");
+
+  local.Disconnect();
+  remote.Disconnect();
+}
+
+TEST(PeerConnectionTest, IndependentlyCreatedChannelsUseDisjointStreamIds) {
+  PeerConnection local;
+  PeerConnection remote;
+  ASSERT_TRUE(local.Initialize(MakeConfig(kRolePortA, kRolePortB, true)).IsOk());
+  ASSERT_TRUE(remote.Initialize(MakeConfig(kRolePortB, kRolePortA)).IsOk());
+
+  MessageLog local_log;
+  MessageLog remote_log;
+  local.SetOnDataChannelCallback(
+      [&](std::shared_ptr<DataChannel> channel) { local_log.Attach(channel); });
+  remote.SetOnDataChannelCallback([&](std::shared_ptr<DataChannel> channel) {
+    remote_log.Attach(channel);
+  });
+
+  // 两端在连接前各自创建通道，互相都不知道对方的分配
+  auto input = local.CreateDataChannel("input");
+  auto clipboard = remote.CreateDataChannel("clipboard");
+  ASSERT_TRUE(input.IsOk());
+  ASSERT_TRUE(clipboard.IsOk());
+  EXPECT_EQ(input.Value()->GetId() % 2, 0);
+  EXPECT_EQ(clipboard.Value()->GetId() % 2, 1);
+
+  ASSERT_TRUE(remote.Connect().IsOk());
+  ASSERT_TRUE(local.Connect().IsOk());
+
+  ASSERT_TRUE(input.Value()->Send("key").IsOk());
+  ASSERT_TRUE(clipboard.Value()->Send("text").IsOk());
+  ASSERT_TRUE(remote_log.WaitFor("input", 1));
+  ASSERT_TRUE(local_log.WaitFor("clipboard", 1));
+  EXPECT_EQ(remote_log.Get("input")[0], "key");
+  EXPECT_EQ(local_log.Get("clipboard")[0], "text");
+  EXPECT_TRUE(remote_log.Get("clipboard").empty());
+  EXPECT_TRUE(local_log.Get("input").empty());
+
+  local.Disconnect();
+  remote.Disconnect();
+}
+
+TEST(PeerConnectionTest, ConflictingOpenIsRejected) {
+  PeerConnection local;
+  PeerConnection remote;
+  ASSERT_TRUE(
+      local.Initialize(MakeConfig(kConflictPortA, kConflictPortB, true))
+          .IsOk());
+  ASSERT_TRUE(
+      remote.Initialize(MakeConfig(kConflictPortB, kConflictPortA)).IsOk());
+
+  // 显式指定了同一流 ID 但名称不同：不是协商通道
+  DataChannel::Config config;
+  config.id = 9;
+  auto input = local.CreateDataChannel("input", config);
+  auto clipboard = remote.CreateDataChannel("clipboard", config);
+  auto done = local.CreateDataChannel("done");
+  ASSERT_TRUE(input.IsOk());
+  ASSERT_TRUE(clipboard.IsOk());
+  ASSERT_TRUE(done.IsOk());
+
+  MessageLog remote_log;
+  remote_log.Attach(clipboard.Value());
+  remote.SetOnDataChannelCallback([&](std::shared_ptr<DataChannel> channel) {
+    remote_log.Attach(channel);
+  });
+
+  ASSERT_TRUE(remote.Connect().IsOk());
+  ASSERT_TRUE(local.Connect().IsOk());
+
+  ASSERT_TRUE(input.Value()->Send("misrouted").IsOk());
+  ASSERT_TRUE(done.Value()->Send("done").IsOk());
+  ASSERT_TRUE(remote_log.WaitFor("done", 1));
+  std::this_thread::sleep_for(50ms);
+  EXPECT_TRUE(remote_log.Get("clipboard").empty());
+  EXPECT_EQ(remote.GetDataChannel("input"), nullptr);
+
+  local.Disconnect();
+  remote.Disconnect();
+}
+
+TEST(PeerConnectionTest, RemoteTracksAreCreatedFromRtpPackets) {
+  PeerConnection sender;
+  PeerConnection receiver;
+  ASSERT_TRUE(sender.Initialize(MakeConfig(kMediaPortA, kMediaPortB)).IsOk());
+  ASSERT_TRUE(
+      receiver.Initialize(MakeConfig(kMediaPortB, kMediaPortA)).IsOk());
+
+  auto video = std::make_shared<VideoTrack>(VideoTrack::Config{});
+  auto audio = std::make_shared<AudioTrack>(AudioTrack::Config{});
+  ASSERT_TRUE(sender.AddTrack(video).IsOk());
+  ASSERT_TRUE(sender.AddTrack(audio).IsOk());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::shared_ptr<MediaTrack>> remote_tracks;
+  std::map<uint32_t, std::vector<std::string>> frames;
+  std::thread::id receive_thread;
+  std::thread::id video_thread;
+  receiver.SetOnTrackCallback([&](std::shared_ptr<MediaTrack> track) {
+    const uint32_t ssrc = track->GetSSRC();
+    track->SetOnFrameCallback(
+        [&, ssrc](const uint8_t* data, size_t length, uint32_t) {
+          std::lock_guard<std::mutex> lock(mutex);
+          frames[ssrc].emplace_back(reinterpret_cast<const char*>(data),
+                                    length);
+          if (ssrc == video->GetSSRC()) {
+            video_thread = std::this_thread::get_id();
+          }
+          cv.notify_all();
+        });
+    std::lock_guard<std::mutex> lock(mutex);
+    remote_tracks.push_back(track);
+    receive_thread = std::this_thread::get_id();
+  });
+
+  ASSERT_TRUE(receiver.Connect().IsOk());
+  ASSERT_TRUE(sender.Connect().IsOk());
+
+  const std::string video_frame(4000, 'v');
+  const std::string audio_frame = "opus";
+  for (uint32_t i = 0; i < 5; ++i) {
+    ASSERT_TRUE(video
+                    ->SendFrame(
+                        reinterpret_cast<const uint8_t*>(video_frame.data()),
+                        video_frame.size(), i * 3000)
+                    .IsOk());
+    ASSERT_TRUE(audio
+                    ->SendFrame(
+                        reinterpret_cast<const uint8_t*>(audio_frame.data()),
+                        audio_frame.size(), i * 960)
+                    .IsOk());
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 3s, [&] {
+      return frames[video->GetSSRC()].size() >= 5 &&
+             frames[audio->GetSSRC()].size() >= 5;
+    }));
+    ASSERT_EQ(remote_tracks.size(), 2U);
+    EXPECT_EQ(remote_tracks[0]->GetKind(), MediaTrack::Kind::kVideo);
+    EXPECT_EQ(remote_tracks[0]->GetSSRC(), video->GetSSRC());
+    EXPECT_EQ(remote_tracks[1]->GetKind(), MediaTrack::Kind::kAudio);
+    EXPECT_EQ(frames[video->GetSSRC()][0], video_frame);
+    EXPECT_EQ(frames[audio->GetSSRC()][4], audio_frame);
+    // 帧回调不在网络接收线程执行
+    EXPECT_NE(video_thread, receive_thread);
+  }
+
+  EXPECT_EQ(receiver.GetRemoteTracks().size(), 2U);
+  auto stats = receiver.GetReceiveStats();
+  EXPECT_EQ(stats.tracks_created, 2U);
+  EXPECT_EQ(stats.packets_dispatched, 10U);
+
+  sender.Disconnect();
+  receiver.Disconnect();
+  EXPECT_TRUE(receiver.GetRemoteTracks().empty());
+}
+
+TEST(PeerConnectionTest, InitializedButNeverConnectedDestroysCleanly) {
+  {
+    PeerConnection peer;
+    ASSERT_TRUE(
+        peer.Initialize(MakeConfig(kUnconnectedPort, kUnconnectedPort + 1))
+            .IsOk());
+    // 析构函数调用 Disconnect()，此时还没有数据传输
+  }
+
+  PeerConnection peer;
+  ASSERT_TRUE(
+      peer.Initialize(MakeConfig(kUnconnectedPort, kUnconnectedPort + 1))
+          .IsOk());
+  peer.Disconnect();
+  EXPECT_FALSE(peer.IsConnected());
+  // 底层连接已释放，再次 Connect() 报未初始化而不是崩溃
+  EXPECT_TRUE(peer.Connect().IsErr());
+}
+
+}  // namespace zenremote
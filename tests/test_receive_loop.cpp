@@ -0,0 +1,230 @@
+/**
+ * @file test_receive_loop.cpp
+ * @brief EventPoller / ReceiveLoop 事件驱动接收线程测试（本机 UDP 回环）
+ *
+ * 测试目标：
+ * - Wakeup() 立即打断无限等待，多次唤醒合并
+ * - 报文到达即交付，Stop() 不等待超时
+ * - 没有定时器时空闲线程不被唤醒
+ * - 定时器回调决定等待时长，Post() 的任务在接收线程执行
+ * - ReliableTransport 报告下一个定时器，空闲时为 -1
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "network/connection/direct_connection.h"
+#include "network/connection/receive_loop.h"
+#include "network/io/event_poller.h"
+#include "network/reliable/reliable_transport.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kPortA = 47331;
+constexpr uint16_t kPortB = 47332;
+
+std::unique_ptr<DirectConnection> MakeConnection(uint16_t local_port,
+                                                 uint16_t remote_port) {
+  DirectConnection::Config config;
+  config.local_ip = "127.0.0.1";
+  config.local_port = local_port;
+  config.remote = {"127.0.0.1", remote_port};
+  auto connection = std::make_unique<DirectConnection>();
+  EXPECT_TRUE(connection->Initialize(config).IsOk());
+  return connection;
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+TEST(EventPollerTest, WakeupInterruptsInfiniteWait) {
+  EventPoller poller;
+  ASSERT_TRUE(poller.Open().IsOk());
+
+  const auto start = std::chrono::steady_clock::now();
+  std::thread waker([&]() {
+    std::this_thread::sleep_for(20ms);
+    poller.Wakeup();
+    poller.Wakeup();  // 合并到同一次唤醒
+  });
+  auto result = poller.Wait(kInvalidSocket, -1);
+  waker.join();
+
+  ASSERT_TRUE(result.IsOk());
+  EXPECT_FALSE(result.Value());
+  EXPECT_LT(ElapsedMs(start), 500.0);
+
+  // 唤醒已被取走，下一次等待按超时返回
+  auto timed_out = poller.Wait(kInvalidSocket, 10);
+  ASSERT_TRUE(timed_out.IsOk());
+  EXPECT_FALSE(timed_out.Value());
+}
+
+TEST(EventPollerTest, ReportsReadableSocket) {
+  auto a = MakeConnection(kPortA, kPortB);
+  auto b = MakeConnection(kPortB, kPortA);
+  EventPoller poller;
+  ASSERT_TRUE(poller.Open().IsOk());
+
+  auto idle = poller.Wait(b->GetPollHandles(), 0);
+  ASSERT_TRUE(idle.IsOk());
+  EXPECT_FALSE(idle.Value());
+
+  const uint8_t payload[] = {1, 2, 3};
+  ASSERT_TRUE(a->Send(payload, sizeof(payload)).IsOk());
+  auto ready = poller.Wait(b->GetPollHandles(), 1000);
+  ASSERT_TRUE(ready.IsOk());
+  EXPECT_TRUE(ready.Value());
+}
+
+TEST(ReceiveLoopTest, DeliversPacketsAndStopsWithoutTimeout) {
+  auto a = MakeConnection(kPortA, kPortB);
+  auto b = MakeConnection(kPortB, kPortA);
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<uint8_t> received;
+  ReceiveLoop loop;
+  ASSERT_TRUE(loop.Start(
+                      b.get(),
+                      [&](const uint8_t* data, size_t length) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        received.push_back(length == 1 ? data[0] : 0);
+                        cv.notify_all();
+                      },
+                      nullptr)
+                  .IsOk());
+
+  for (uint8_t i = 1; i <= 10; ++i) {
+    ASSERT_TRUE(a->Send(&i, 1).IsOk());
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 2s, [&] { return received.size() == 10; }));
+    for (uint8_t i = 0; i < 10; ++i) {
+      EXPECT_EQ(received[i], i + 1);
+    }
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  loop.Stop();
+  EXPECT_LT(ElapsedMs(start), 20.0);
+  EXPECT_FALSE(loop.IsRunning());
+  EXPECT_EQ(loop.GetStats().packets_received, 10U);
+}
+
+TEST(ReceiveLoopTest, IdleLoopDoesNotWake) {
+  auto b = MakeConnection(kPortB, kPortA);
+  std::atomic<int> timer_calls{0};
+  ReceiveLoop loop;
+  ASSERT_TRUE(loop.Start(
+                      b.get(), [](const uint8_t*, size_t) {},
+                      [&]() {
+                        timer_calls++;
+                        return -1;
+                      })
+                  .IsOk());
+
+  std::this_thread::sleep_for(200ms);
+  EXPECT_EQ(loop.GetStats().wakeups, 0U);
+  EXPECT_EQ(timer_calls.load(), 1);
+  loop.Stop();
+}
+
+TEST(ReceiveLoopTest, TimerDelayControlsWaitAndWakeupRecomputesIt) {
+  auto b = MakeConnection(kPortB, kPortA);
+  std::atomic<int> delay_ms{-1};
+  std::atomic<int> timer_calls{0};
+  ReceiveLoop loop;
+  ASSERT_TRUE(loop.Start(
+                      b.get(), [](const uint8_t*, size_t) {},
+                      [&]() {
+                        timer_calls++;
+                        return delay_ms.load();
+                      })
+                  .IsOk());
+
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(timer_calls.load(), 1);
+
+  // 新定时器：唤醒后按 10ms 周期驱动
+  delay_ms = 10;
+  loop.Wakeup();
+  std::this_thread::sleep_for(200ms);
+  const int calls = timer_calls.load();
+  EXPECT_GE(calls, 5);
+  EXPECT_LE(calls, 30);
+  loop.Stop();
+}
+
+TEST(ReceiveLoopTest, PostRunsTaskOnLoopThread) {
+  auto b = MakeConnection(kPortB, kPortA);
+  ReceiveLoop loop;
+  std::thread::id loop_thread;
+  ASSERT_TRUE(loop.Start(
+                      b.get(), [](const uint8_t*, size_t) {},
+                      [&]() {
+                        loop_thread = std::this_thread::get_id();
+                        return -1;
+                      })
+                  .IsOk());
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  std::thread::id task_thread;
+  loop.Post([&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    task_thread = std::this_thread::get_id();
+    done = true;
+    cv.notify_all();
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 1s, [&] { return done; }));
+  }
+  loop.Stop();
+  EXPECT_EQ(task_thread, loop_thread);
+  EXPECT_NE(task_thread, std::this_thread::get_id());
+  EXPECT_EQ(loop.GetStats().tasks_run, 1U);
+}
+
+TEST(ReliableTransportTimerTest, ReportsNextTimerAndSchedulingCallback) {
+  auto a = MakeConnection(kPortA, kPortB);
+  ReliableTransport::Config config;
+  config.initial_rto_ms = 50;
+  ReliableTransport transport(a.get(), config);
+  int scheduled = 0;
+  transport.SetOnTimerScheduledCallback([&]() { scheduled++; });
+
+  EXPECT_EQ(transport.GetTimerDelayMs(), -1);
+
+  const uint8_t message[] = {1, 2, 3, 4};
+  ASSERT_TRUE(transport.Send(message, sizeof(message)).IsOk());
+  EXPECT_EQ(scheduled, 1);
+  const int delay = transport.GetTimerDelayMs();
+  EXPECT_GT(delay, 0);
+  EXPECT_LE(delay, config.initial_rto_ms + ReliableTransport::kDelayedAckMs);
+
+  // 定时器已在运行，再次发送不重复通知
+  ASSERT_TRUE(transport.Send(message, sizeof(message)).IsOk());
+  EXPECT_EQ(scheduled, 1);
+}
+
+}  // namespace zenremote
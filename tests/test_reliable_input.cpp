@@ -0,0 +1,614 @@
+/**
+ * @file test_reliable_input.cpp
+ * @brief 可靠输入传输（滑动窗口 + SACK）单元测试
+ *
+ * 测试目标：
+ * - 累积 ACK + SACK 位图的生成与处理
+ * - 接收端去重、ACK 合并与延迟 ACK
+ * - 基于 SACK 的快速重传和基于 RTO 的超时重传
+ * - SRTT/RTTVAR 自适应 RTO
+ * - 冗余模式：冗余块恢复丢失事件、按丢包率调整冗余深度
+ * - 5% 丢包下的输入往返时延基准（DISABLED，手动运行）
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "loopback_impairment.h"
+#include "network/protocol/packet.h"
+#include "network/protocol/protocol.h"
+#include "network/protocol/reliable_input.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+struct DeliveryLog {
+  std::vector<uint32_t> key_codes;
+};
+
+void RecordDelivery(const InputEvent& event, void* user_data) {
+  static_cast<DeliveryLog*>(user_data)->key_codes.push_back(event.key_code);
+}
+
+InputEvent MakeKeyEvent(uint32_t key_code) {
+  InputEvent event;
+  event.type = InputEventType::kKeyDown;
+  event.key_code = key_code;
+  return event;
+}
+
+// 从端点取出一个 RTP 包
+std::optional<RtpPacket> RecvRtp(BaseConnection* connection,
+                                 int timeout_ms = 0) {
+  uint8_t buffer[2048];
+  auto result = connection->Recv(buffer, sizeof(buffer), timeout_ms);
+  if (result.IsErr()) {
+    return std::nullopt;
+  }
+  return ParseRtpPacket(buffer, result.Value());
+}
+
+std::optional<SackPayload> ParseSackPacket(const RtpPacket& packet) {
+  auto ctrl =
+      ParseControlMessage(packet.payload.data(), packet.payload.size());
+  if (!ctrl.has_value() || ctrl->type != ControlMessageType::kInputAck) {
+    return std::nullopt;
+  }
+  return ParseSackPayload(ctrl->payload.data(), ctrl->payload.size());
+}
+
+std::vector<uint8_t> MakeEventMessage(uint16_t seq, uint32_t key_code) {
+  ControlMessage msg;
+  msg.type = ControlMessageType::kInputEvent;
+  msg.sequence = seq;
+  msg.payload = SerializeInputEvent(MakeKeyEvent(key_code));
+  return SerializeControlMessage(msg);
+}
+
+}  // namespace
+
+class ReliableInputTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    link_ = std::make_unique<ImpairedLoopback>(ImpairedLoopback::Config{});
+    sender_ = std::make_unique<ReliableInputSender>(0x1234, link_->a());
+    receiver_ = std::make_unique<ReliableInputReceiver>(link_->b());
+    receiver_->SetCallback(&RecordDelivery, &log_);
+  }
+
+  // 把 A→B 方向所有到达的包交给接收端
+  void PumpReceiver() {
+    while (auto packet = RecvRtp(link_->b())) {
+      receiver_->OnControlMessage(packet->payload.data(),
+                                  packet->payload.size());
+    }
+  }
+
+  // 把 B→A 方向所有到达的 ACK 交给发送端
+  void PumpSender() {
+    while (auto packet = RecvRtp(link_->a())) {
+      sender_->OnControlMessage(packet->payload.data(),
+                                packet->payload.size());
+    }
+  }
+
+  std::unique_ptr<ImpairedLoopback> link_;
+  std::unique_ptr<ReliableInputSender> sender_;
+  std::unique_ptr<ReliableInputReceiver> receiver_;
+  DeliveryLog log_;
+};
+
+// ============================================================================
+// SACK 序列化
+// ============================================================================
+
+TEST(SackPayloadTest, Roundtrip) {
+  SackPayload original;
+  original.cumulative_ack = 65530;
+  original.sack_bitmap = 0x8000000000000005ULL;
+  original.ack_delay_ms = 7;
+  original.loss_fraction = 13;
+
+  auto serialized = SerializeSackPayload(original);
+  ASSERT_EQ(serialized.size(), 13);
+
+  auto parsed = ParseSackPayload(serialized.data(), serialized.size());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->cumulative_ack, original.cumulative_ack);
+  EXPECT_EQ(parsed->sack_bitmap, original.sack_bitmap);
+  EXPECT_EQ(parsed->ack_delay_ms, original.ack_delay_ms);
+  EXPECT_EQ(parsed->loss_fraction, original.loss_fraction);
+}
+
+TEST(SackPayloadTest, ParseWithoutLossFraction) {
+  SackPayload original;
+  original.cumulative_ack = 3;
+  original.loss_fraction = 200;
+  auto serialized = SerializeSackPayload(original);
+
+  auto parsed = ParseSackPayload(serialized.data(), 12);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->cumulative_ack, 3);
+  EXPECT_EQ(parsed->loss_fraction, 0);
+}
+
+TEST(SackPayloadTest, ParseBufferTooSmall) {
+  uint8_t data[11] = {0};
+  EXPECT_FALSE(ParseSackPayload(data, sizeof(data)).has_value());
+}
+
+TEST(SackPayloadTest, SequenceWraparoundCompare) {
+  EXPECT_TRUE(SeqLessThan(1, 2));
+  EXPECT_TRUE(SeqLessThan(65535, 0));
+  EXPECT_FALSE(SeqLessThan(0, 65535));
+  EXPECT_FALSE(SeqLessThan(5, 5));
+}
+
+TEST(RedundantInputTest, SerializeRoundtrip) {
+  std::vector<RedundantInputBlock> blocks(2);
+  blocks[0].sequence_back = 1;
+  blocks[0].event = MakeKeyEvent(11);
+  blocks[1].sequence_back = 3;
+  blocks[1].event = MakeKeyEvent(9);
+
+  auto payload = SerializeRedundantInputEvent(MakeKeyEvent(12), blocks);
+  EXPECT_EQ(payload.size(), kInputEventSize + 1 + 2 * (1 + kInputEventSize));
+
+  // 旧版本解析方式仍能取到主事件
+  auto primary = ParseInputEvent(payload.data(), payload.size());
+  ASSERT_TRUE(primary.has_value());
+  EXPECT_EQ(primary->key_code, 12U);
+
+  auto parsed = ParseRedundantInputBlocks(payload.data(), payload.size());
+  ASSERT_EQ(parsed.size(), 2U);
+  EXPECT_EQ(parsed[0].sequence_back, 1);
+  EXPECT_EQ(parsed[0].event.key_code, 11U);
+  EXPECT_EQ(parsed[1].sequence_back, 3);
+  EXPECT_EQ(parsed[1].event.key_code, 9U);
+}
+
+TEST(RedundantInputTest, TruncatedBlocksIgnored) {
+  std::vector<RedundantInputBlock> blocks(1);
+  blocks[0].sequence_back = 1;
+  auto payload = SerializeRedundantInputEvent(MakeKeyEvent(1), blocks);
+
+  EXPECT_TRUE(
+      ParseRedundantInputBlocks(payload.data(), payload.size() - 1).empty());
+  EXPECT_TRUE(ParseRedundantInputBlocks(payload.data(), kInputEventSize)
+                  .empty());
+}
+
+// ============================================================================
+// 接收端
+// ============================================================================
+
+TEST_F(ReliableInputTest, InOrderDeliveryWithCoalescedAcks) {
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(i)));
+  }
+  PumpReceiver();
+
+  EXPECT_EQ(log_.key_codes, (std::vector<uint32_t>{0, 1, 2, 3}));
+  // 每 kAckCoalesceCount 个按序事件才回一个 ACK
+  EXPECT_EQ(receiver_->GetStats().acks_sent,
+            4U / ReliableInputReceiver::kAckCoalesceCount);
+
+  PumpSender();
+  EXPECT_EQ(sender_->GetInFlightCount(), 0U);
+  EXPECT_EQ(sender_->GetStats().events_acked, 4U);
+}
+
+TEST_F(ReliableInputTest, DelayedAckFlushesAfterTimeout) {
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(1)));
+  PumpReceiver();
+
+  receiver_->ProcessDelayedAck();
+  EXPECT_EQ(receiver_->GetStats().acks_sent, 0U);
+
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(ReliableInputReceiver::kDelayedAckMs + 2));
+  receiver_->ProcessDelayedAck();
+  EXPECT_EQ(receiver_->GetStats().acks_sent, 1U);
+
+  auto packet = RecvRtp(link_->a());
+  ASSERT_TRUE(packet.has_value());
+  auto sack = ParseSackPacket(*packet);
+  ASSERT_TRUE(sack.has_value());
+  EXPECT_EQ(sack->cumulative_ack, 1);
+  EXPECT_GE(sack->ack_delay_ms, ReliableInputReceiver::kDelayedAckMs);
+}
+
+TEST_F(ReliableInputTest, OutOfOrderArrivalProducesSackBitmap) {
+  auto msg1 = MakeEventMessage(1, 101);
+  auto msg2 = MakeEventMessage(2, 102);
+  receiver_->OnControlMessage(msg1.data(), msg1.size());
+  receiver_->OnControlMessage(msg2.data(), msg2.size());
+
+  // 乱序到达立即回 ACK：cum=0（缺失），位图标记 1、2
+  auto first = RecvRtp(link_->a());
+  auto second = RecvRtp(link_->a());
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  auto sack = ParseSackPacket(*second);
+  ASSERT_TRUE(sack.has_value());
+  EXPECT_EQ(sack->cumulative_ack, 0);
+  EXPECT_EQ(sack->sack_bitmap, 0b11ULL);
+
+  // 补上空洞后累积确认点一次推进到 3
+  auto msg0 = MakeEventMessage(0, 100);
+  receiver_->OnControlMessage(msg0.data(), msg0.size());
+  receiver_->ProcessDelayedAck();
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(ReliableInputReceiver::kDelayedAckMs + 2));
+  receiver_->ProcessDelayedAck();
+
+  std::optional<SackPayload> last;
+  while (auto packet = RecvRtp(link_->a())) {
+    last = ParseSackPacket(*packet);
+  }
+  ASSERT_TRUE(last.has_value());
+  EXPECT_EQ(last->cumulative_ack, 3);
+  EXPECT_EQ(last->sack_bitmap, 0ULL);
+  EXPECT_EQ(log_.key_codes, (std::vector<uint32_t>{101, 102, 100}));
+}
+
+TEST_F(ReliableInputTest, DuplicateEventsAreNotRedelivered) {
+  auto msg = MakeEventMessage(0, 42);
+  receiver_->OnControlMessage(msg.data(), msg.size());
+  receiver_->OnControlMessage(msg.data(), msg.size());
+
+  auto ooo = MakeEventMessage(5, 47);
+  receiver_->OnControlMessage(ooo.data(), ooo.size());
+  receiver_->OnControlMessage(ooo.data(), ooo.size());
+
+  EXPECT_EQ(log_.key_codes, (std::vector<uint32_t>{42, 47}));
+  EXPECT_EQ(receiver_->GetStats().duplicates_dropped, 2U);
+}
+
+// ============================================================================
+// 发送端
+// ============================================================================
+
+TEST_F(ReliableInputTest, SackReleasesOnlyAcknowledgedSlots) {
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(i)));
+  }
+
+  SackPayload sack;
+  sack.cumulative_ack = 0;
+  sack.sack_bitmap = 0b101ULL;  // seq 1, 3
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetInFlightCount(), 2U);
+
+  sack.cumulative_ack = 2;
+  sack.sack_bitmap = 0;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetInFlightCount(), 1U);
+
+  // 乱序到达的旧累积 ACK 不应产生影响
+  SackPayload stale;
+  stale.cumulative_ack = 1;
+  sender_->OnAckMessage(stale);
+  EXPECT_EQ(sender_->GetInFlightCount(), 1U);
+  EXPECT_EQ(sender_->GetStats().events_acked, 3U);
+}
+
+TEST_F(ReliableInputTest, SackHoleTriggersFastRetransmit) {
+  for (uint32_t i = 0; i < 3; ++i) {
+    ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(i)));
+  }
+
+  SackPayload sack;
+  sack.cumulative_ack = 0;
+  sack.sack_bitmap = 0b1ULL;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetStats().events_fast_retransmitted, 0U);
+
+  sack.sack_bitmap = 0b11ULL;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetStats().events_fast_retransmitted, 1U);
+  EXPECT_EQ(sender_->GetInFlightCount(), 1U);
+}
+
+TEST_F(ReliableInputTest, RetransmitsAfterRto) {
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(7)));
+
+  sender_->ProcessRetries();
+  EXPECT_EQ(sender_->GetStats().events_retried, 0U);
+
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(sender_->GetRtoMs() +
+                                ReliableInputReceiver::kDelayedAckMs + 5));
+  sender_->ProcessRetries();
+  EXPECT_EQ(sender_->GetStats().events_retried, 1U);
+
+  // 原始包和重传包都到达，接收端只注入一次
+  PumpReceiver();
+  EXPECT_EQ(log_.key_codes, (std::vector<uint32_t>{7}));
+  EXPECT_EQ(receiver_->GetStats().duplicates_dropped, 1U);
+}
+
+TEST_F(ReliableInputTest, WindowFullRejectsNewEvents) {
+  for (size_t i = 0; i < ReliableInputSender::kWindowSize; ++i) {
+    ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(i)));
+  }
+  EXPECT_FALSE(sender_->SendInputEvent(MakeKeyEvent(999)));
+  EXPECT_EQ(sender_->GetStats().window_full_drops, 1U);
+}
+
+TEST_F(ReliableInputTest, UnackedSendBaseBlocksSlotReuse) {
+  for (size_t i = 0; i < ReliableInputSender::kWindowSize; ++i) {
+    ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(i)));
+  }
+
+  // seq 0 仍在重传，1..63 已被 SACK：在途数虽为 1，窗口跨度仍是满的
+  SackPayload sack;
+  sack.cumulative_ack = 0;
+  sack.sack_bitmap = ~0ULL >> 1;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetInFlightCount(), 1U);
+
+  // seq 64 与 seq 0 共用槽位，不能覆盖未确认的 seq 0
+  EXPECT_FALSE(sender_->SendInputEvent(MakeKeyEvent(64)));
+  EXPECT_EQ(sender_->GetStats().window_full_drops, 1U);
+
+  sack.cumulative_ack = ReliableInputSender::kWindowSize;
+  sack.sack_bitmap = 0;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetInFlightCount(), 0U);
+
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(64)));
+  sack.cumulative_ack = ReliableInputSender::kWindowSize + 1;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetInFlightCount(), 0U);
+  EXPECT_EQ(sender_->GetStats().events_acked,
+            ReliableInputSender::kWindowSize + 1);
+}
+
+// ============================================================================
+// 冗余模式
+// ============================================================================
+
+TEST_F(ReliableInputTest, RedundancyRecoversLostEventWithoutRetransmit) {
+  ReliableInputSender::RedundancyConfig config;
+  config.enabled = true;
+  config.min_depth = 1;
+  sender_->SetRedundancyConfig(config);
+  EXPECT_EQ(sender_->GetRedundancyDepth(), 1);
+
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(1)));
+  ASSERT_TRUE(RecvRtp(link_->b()).has_value());  // 模拟首个包丢失
+
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(2)));
+  PumpReceiver();
+
+  EXPECT_EQ(log_.key_codes, (std::vector<uint32_t>{1, 2}));
+  EXPECT_EQ(receiver_->GetStats().recovered_by_redundancy, 1U);
+  EXPECT_EQ(receiver_->GetStats().duplicates_dropped, 0U);
+
+  PumpSender();
+  EXPECT_EQ(sender_->GetInFlightCount(), 0U);
+  EXPECT_EQ(sender_->GetStats().events_retried, 0U);
+  EXPECT_EQ(sender_->GetStats().redundant_events_sent, 1U);
+}
+
+TEST_F(ReliableInputTest, RedundantCopiesAreNotCountedAsDuplicates) {
+  ReliableInputSender::RedundancyConfig config;
+  config.enabled = true;
+  config.min_depth = 2;
+  sender_->SetRedundancyConfig(config);
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(i)));
+  }
+  PumpReceiver();
+
+  EXPECT_EQ(log_.key_codes, (std::vector<uint32_t>{0, 1, 2}));
+  EXPECT_EQ(receiver_->GetStats().duplicates_dropped, 0U);
+  EXPECT_EQ(receiver_->GetStats().recovered_by_redundancy, 0U);
+  EXPECT_EQ(sender_->GetStats().redundant_events_sent, 3U);  // 0 + 1 + 2
+}
+
+TEST_F(ReliableInputTest, RedundancyDepthAdaptsToReportedLoss) {
+  ReliableInputSender::RedundancyConfig config;
+  config.enabled = true;
+  config.min_depth = 1;
+  config.max_depth = 4;
+  sender_->SetRedundancyConfig(config);
+
+  SackPayload sack;
+  sack.loss_fraction = 13;  // ~5%
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetRedundancyDepth(), 2);
+
+  sack.loss_fraction = 77;  // ~30%
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetRedundancyDepth(), 4);
+
+  sack.loss_fraction = 0;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetRedundancyDepth(), 1);
+}
+
+TEST_F(ReliableInputTest, RedundancyDisabledByDefault) {
+  SackPayload sack;
+  sack.loss_fraction = 128;
+  sender_->OnAckMessage(sack);
+  EXPECT_EQ(sender_->GetRedundancyDepth(), 0);
+
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(1)));
+  ASSERT_TRUE(sender_->SendInputEvent(MakeKeyEvent(2)));
+  EXPECT_EQ(sender_->GetStats().redundant_events_sent, 0U);
+}
+
+TEST_F(ReliableInputTest, ReceiverEstimatesLossFromSequenceGaps) {
+  for (uint16_t seq = 0; seq < 40; ++seq) {
+    if (seq % 4 == 3) {
+      continue;  // 25% 首传丢失
+    }
+    auto msg = MakeEventMessage(seq, seq);
+    receiver_->OnControlMessage(msg.data(), msg.size());
+  }
+  EXPECT_GT(receiver_->GetLossEstimate(), 0.1);
+  EXPECT_LT(receiver_->GetLossEstimate(), 0.4);
+
+  std::optional<SackPayload> last;
+  while (auto packet = RecvRtp(link_->a())) {
+    last = ParseSackPacket(*packet);
+  }
+  ASSERT_TRUE(last.has_value());
+  EXPECT_GT(last->loss_fraction, 0);
+}
+
+TEST(ReliableInputRtoTest, RtoTracksMeasuredRtt) {
+  ImpairedLoopback::Config config;
+  config.delay_ms = 10;
+  ImpairedLoopback link(config);
+  ReliableInputSender sender(1, link.a());
+  ReliableInputReceiver receiver(link.b());
+
+  for (uint32_t i = 0; i < 8; ++i) {
+    ASSERT_TRUE(sender.SendInputEvent(MakeKeyEvent(i)));
+    if (auto packet = RecvRtp(link.b(), 50)) {
+      receiver.OnControlMessage(packet->payload.data(),
+                                packet->payload.size());
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(ReliableInputReceiver::kDelayedAckMs + 1));
+    receiver.ProcessDelayedAck();
+    if (auto packet = RecvRtp(link.a(), 50)) {
+      sender.OnControlMessage(packet->payload.data(), packet->payload.size());
+    }
+  }
+
+  EXPECT_EQ(sender.GetInFlightCount(), 0U);
+  EXPECT_GT(sender.GetStats().rtt_samples, 0U);
+  // 往返约 20ms（已扣除接收端延迟 ACK 时间）
+  EXPECT_GE(sender.GetSmoothedRttMs(), 15.0);
+  EXPECT_LE(sender.GetSmoothedRttMs(), 60.0);
+  EXPECT_GT(sender.GetRtoMs(), static_cast<int>(sender.GetSmoothedRttMs()));
+}
+
+// ============================================================================
+// 性能基准测试（DISABLED，手动运行）
+// ============================================================================
+
+namespace {
+
+void RunLossyRoundTripBenchmark(bool redundancy) {
+  ImpairedLoopback::Config config;
+  config.loss_rate = 0.05;
+  config.delay_ms = 2;
+  config.jitter_ms = 1;
+  config.seed = 26;
+  ImpairedLoopback link(config);
+
+  ReliableInputSender sender(1, link.a());
+  ReliableInputReceiver receiver(link.b());
+  ReliableInputSender::RedundancyConfig redundancy_config;
+  redundancy_config.enabled = redundancy;
+  sender.SetRedundancyConfig(redundancy_config);
+
+  constexpr uint32_t kEvents = 2000;
+  constexpr auto kInterval = 4ms;  // 250 Hz 鼠标事件
+  using Clock = std::chrono::steady_clock;
+
+  struct Context {
+    std::vector<Clock::time_point> sent;
+    std::vector<double> latency_ms;
+  } ctx;
+  ctx.sent.resize(kEvents);
+  ctx.latency_ms.assign(kEvents, -1.0);
+
+  receiver.SetCallback(
+      [](const InputEvent& event, void* user_data) {
+        auto* c = static_cast<Context*>(user_data);
+        c->latency_ms[event.key_code] =
+            std::chrono::duration<double, std::milli>(
+                Clock::now() - c->sent[event.key_code])
+                .count();
+      },
+      &ctx);
+
+  uint32_t next_event = 0;
+  auto next_send = Clock::now();
+  const auto deadline = Clock::now() + kInterval * kEvents + 2s;
+
+  while (Clock::now() < deadline) {
+    if (next_event < kEvents && Clock::now() >= next_send) {
+      ctx.sent[next_event] = Clock::now();
+      sender.SendInputEvent(MakeKeyEvent(next_event));
+      next_event++;
+      next_send += kInterval;
+    }
+    while (auto packet = RecvRtp(link.b())) {
+      receiver.OnControlMessage(packet->payload.data(),
+                                packet->payload.size());
+    }
+    receiver.ProcessDelayedAck();
+    while (auto packet = RecvRtp(link.a())) {
+      sender.OnControlMessage(packet->payload.data(), packet->payload.size());
+    }
+    sender.ProcessRetries();
+    if (next_event == kEvents && sender.GetInFlightCount() == 0) {
+      break;
+    }
+    std::this_thread::sleep_for(200us);
+  }
+
+  std::vector<double> delivered;
+  for (double ms : ctx.latency_ms) {
+    if (ms >= 0) {
+      delivered.push_back(ms);
+    }
+  }
+  std::sort(delivered.begin(), delivered.end());
+  ASSERT_FALSE(delivered.empty());
+  auto pct = [&](double p) {
+    return delivered[static_cast<size_t>(p * (delivered.size() - 1))];
+  };
+
+  const auto& stats = sender.GetStats();
+  const double seconds =
+      std::chrono::duration<double>(kInterval * kEvents).count();
+  std::cout << "Input latency under 5% loss (one-way 2ms + 0-1ms jitter, "
+            << (redundancy ? "redundancy" : "no redundancy") << "):\n"
+            << "  delivered " << delivered.size() << "/" << kEvents
+            << ", failed " << stats.events_failed << "\n"
+            << "  p50 " << pct(0.50) << " ms, p95 " << pct(0.95)
+            << " ms, p99 " << pct(0.99) << " ms, max " << delivered.back()
+            << " ms\n"
+            << "  retransmits " << stats.events_retried << " (fast "
+            << stats.events_fast_retransmitted << "), acks "
+            << receiver.GetStats().acks_sent << ", srtt "
+            << sender.GetSmoothedRttMs() << " ms, rto " << sender.GetRtoMs()
+            << " ms\n"
+            << "  redundant events " << stats.redundant_events_sent
+            << ", depth " << sender.GetRedundancyDepth() << ", overhead "
+            << stats.redundancy_bytes_sent / seconds << " B/s, recovered "
+            << receiver.GetStats().recovered_by_redundancy << "\n";
+
+  EXPECT_EQ(delivered.size(), kEvents);
+}
+
+}  // namespace
+
+TEST(ReliableInputBenchmark, DISABLED_RoundTripLatencyUnderLoss) {
+  RunLossyRoundTripBenchmark(false);
+}
+
+TEST(ReliableInputBenchmark, DISABLED_RoundTripLatencyUnderLossWithRedundancy) {
+  RunLossyRoundTripBenchmark(true);
+}
+
+}  // namespace zenremote
@@ -0,0 +1,151 @@
+/**
+ * @file test_roi_map.cpp
+ * @brief 脏区域到编码器 ROI 的转换测试
+ *
+ * 测试目标：
+ * - 缩放到编码尺寸、外扩到块边界、裁剪到帧内
+ * - 被包含的矩形去重，超出数量上限时合并，矩形很多时取外接矩形
+ * - 变化面积过大或没有脏区域时不生成 ROI
+ * - AV_FRAME_DATA_REGIONS_OF_INTEREST 的内容与 QP 偏移换算
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "media/codec/encoder/roi_map.h"
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+
+bool SameRect(const DirtyRect& a, const DirtyRect& b) {
+  return a.left == b.left && a.top == b.top && a.right == b.right &&
+         a.bottom == b.bottom;
+}
+
+bool Covers(const std::vector<DirtyRect>& rects, const DirtyRect& dirty) {
+  for (const auto& rect : rects) {
+    if (rect.left <= dirty.left && rect.top <= dirty.top &&
+        rect.right >= dirty.right && rect.bottom >= dirty.bottom) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(RoiMapTest, ScalesAlignsAndClips) {
+  // 同尺寸：外扩到 16 的倍数
+  auto rects = BuildRoiRects({{35, 20, 41, 37}}, 1920, 1080, 1920, 1080);
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_TRUE(SameRect(rects[0], {32, 16, 48, 48}));
+
+  // 2560x1440 → 1920x1080（0.75），右下角裁剪到帧内
+  rects = BuildRoiRects({{2500, 1400, 2560, 1440}}, 2560, 1440, 1920, 1080);
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_TRUE(SameRect(rects[0], {1872, 1040, 1920, 1080}));
+
+  RoiMapConfig config;
+  config.block_size = 64;
+  rects = BuildRoiRects({{70, 70, 80, 80}}, 1920, 1080, 1920, 1080, config);
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_TRUE(SameRect(rects[0], {64, 64, 128, 128}));
+
+  // 空矩形与帧外的矩形被忽略
+  EXPECT_TRUE(
+      BuildRoiRects({{10, 10, 10, 20}, {4000, 0, 4100, 10}}, 1920, 1080,
+                    1920, 1080)
+          .empty());
+  EXPECT_TRUE(BuildRoiRects({}, 1920, 1080, 1920, 1080).empty());
+  EXPECT_TRUE(BuildRoiRects({{0, 0, 16, 16}}, 0, 0, 1920, 1080).empty());
+}
+
+TEST(RoiMapTest, MergesToRegionLimit) {
+  // 同一宏块内的多个字符合并为一个
+  std::vector<DirtyRect> typing;
+  for (int x = 0; x < 16; x += 4) {
+    typing.push_back({96 + x, 200, 100 + x, 212});
+  }
+  auto rects = BuildRoiRects(typing, 1920, 1080, 1920, 1080);
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_TRUE(SameRect(rects[0], {96, 192, 112, 224}));
+
+  // 24 个分散的小区域合并到 8 个，仍覆盖所有脏区域
+  std::vector<DirtyRect> scattered;
+  for (int i = 0; i < 24; ++i) {
+    const int x = (i % 8) * 200;
+    const int y = (i / 8) * 200;
+    scattered.push_back({x, y, x + 20, y + 20});
+  }
+  RoiMapConfig config;
+  config.max_regions = 8;
+  config.max_area_ratio = 1.0;  // 合并后的外接矩形面积较大
+  rects = BuildRoiRects(scattered, 1920, 1080, 1920, 1080, config);
+  EXPECT_EQ(rects.size(), 8U);
+  for (const auto& dirty : scattered) {
+    EXPECT_TRUE(Covers(rects, dirty));
+  }
+
+  // 超过上限的 4 倍：取外接矩形
+  config.max_regions = 2;
+  rects = BuildRoiRects(scattered, 1920, 1080, 1920, 1080, config);
+  ASSERT_EQ(rects.size(), 1U);
+  EXPECT_TRUE(SameRect(rects[0], {0, 0, 1424, 432}));
+}
+
+TEST(RoiMapTest, SkipsLargeDamage) {
+  // 滚动整个窗口：超过一半的画面变化
+  EXPECT_TRUE(BuildRoiRects({{0, 0, 1920, 600}}, 1920, 1080, 1920, 1080)
+                  .empty());
+  RoiMapConfig config;
+  config.max_area_ratio = 1.0;
+  EXPECT_EQ(
+      BuildRoiRects({{0, 0, 1920, 600}}, 1920, 1080, 1920, 1080, config)
+          .size(),
+      1U);
+}
+
+TEST(RoiMapTest, AttachesSideData) {
+  AVFramePtr frame = MakeAVFrame();
+  ASSERT_TRUE(frame);
+  const std::vector<DirtyRect> rects = {{0, 0, 64, 32}, {128, 64, 256, 96}};
+  ASSERT_TRUE(AttachRegionsOfInterest(frame.get(), rects, -6).IsOk());
+
+  const AVFrameSideData* side_data =
+      av_frame_get_side_data(frame.get(), AV_FRAME_DATA_REGIONS_OF_INTEREST);
+  ASSERT_NE(side_data, nullptr);
+  ASSERT_EQ(side_data->size, 2 * sizeof(AVRegionOfInterest));
+  const auto* regions =
+      reinterpret_cast<const AVRegionOfInterest*>(side_data->data);
+  EXPECT_EQ(regions[1].self_size, sizeof(AVRegionOfInterest));
+  EXPECT_EQ(regions[1].left, 128);
+  EXPECT_EQ(regions[1].top, 64);
+  EXPECT_EQ(regions[1].right, 256);
+  EXPECT_EQ(regions[1].bottom, 96);
+  // libx264 以 qoffset × 51 换算 QP 偏移
+  EXPECT_EQ(regions[0].qoffset.num, -6);
+  EXPECT_EQ(regions[0].qoffset.den, 51);
+
+  // 重新附加时替换；空列表移除
+  ASSERT_TRUE(AttachRegionsOfInterest(frame.get(), {rects[0]}, -100).IsOk());
+  side_data =
+      av_frame_get_side_data(frame.get(), AV_FRAME_DATA_REGIONS_OF_INTEREST);
+  ASSERT_NE(side_data, nullptr);
+  EXPECT_EQ(side_data->size, sizeof(AVRegionOfInterest));
+  EXPECT_EQ(reinterpret_cast<const AVRegionOfInterest*>(side_data->data)
+                ->qoffset.num,
+            -51);
+  ASSERT_TRUE(AttachRegionsOfInterest(frame.get(), {}, -6).IsOk());
+  EXPECT_EQ(
+      av_frame_get_side_data(frame.get(), AV_FRAME_DATA_REGIONS_OF_INTEREST),
+      nullptr);
+
+  EXPECT_EQ(AttachRegionsOfInterest(nullptr, rects, -6).Code(),
+            ErrorCode::kInvalidParameter);
+}
+
+}  // namespace zenremote
@@ -0,0 +1,416 @@
+/**
+ * @file test_rtp_demuxer.cpp
+ * @brief RTP 接收分发单元测试
+ *
+ * 测试目标：
+ * - SpscQueue 先进先出、容量限制与跨线程传递
+ * - 按 SSRC 分发到对应轨道，回调在轨道处理线程执行
+ * - 未知 SSRC 按负载类型自动创建轨道；未声明的负载类型与非 RTP 报文
+ * - 处理线程阻塞时丢包而不阻塞调用方
+ * - CSRC / 扩展头 / 填充的剥离
+ * - 网络线程单包分发开销基准（DISABLED，手动运行）
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/spsc_queue.h"
+#include "network/rtp/rtp_packet.h"
+#include "transport/rtp_demuxer.h"
+#include "transport/track/audio_track.h"
+#include "transport/track/video_track.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+std::vector<uint8_t> MakeRtpPacket(uint32_t ssrc,
+                                   uint8_t payload_type,
+                                   uint32_t timestamp,
+                                   const std::vector<uint8_t>& payload) {
+  network::RTPHeader header{};
+  header.version = 2;
+  header.payload_type = payload_type;
+  header.marker = 1;
+  header.timestamp = timestamp;
+  header.ssrc = ssrc;
+
+  std::vector<uint8_t> packet(sizeof(header) + payload.size());
+  std::memcpy(packet.data(), &header, sizeof(header));
+  std::memcpy(packet.data() + sizeof(header), payload.data(), payload.size());
+  return packet;
+}
+
+/**
+ * @brief 收集轨道收到的帧（回调在轨道处理线程执行）
+ */
+class FrameLog {
+ public:
+  void Attach(const std::shared_ptr<MediaTrack>& track) {
+    const uint32_t ssrc = track->GetSSRC();
+    track->SetOnFrameCallback(
+        [this, ssrc](const uint8_t* data, size_t length, uint32_t timestamp) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          frames_[ssrc].push_back(
+              {std::vector<uint8_t>(data, data + length), timestamp});
+          threads_[ssrc] = std::this_thread::get_id();
+          cv_.notify_all();
+        });
+  }
+
+  bool WaitFor(uint32_t ssrc, size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, 3s,
+                        [&] { return frames_[ssrc].size() >= count; });
+  }
+
+  struct Frame {
+    std::vector<uint8_t> data;
+    uint32_t timestamp = 0;
+  };
+
+  std::vector<Frame> Get(uint32_t ssrc) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_[ssrc];
+  }
+
+  std::thread::id Thread(uint32_t ssrc) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return threads_[ssrc];
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<uint32_t, std::vector<Frame>> frames_;
+  std::map<uint32_t, std::thread::id> threads_;
+};
+
+std::shared_ptr<VideoTrack> MakeVideoTrack(uint32_t ssrc) {
+  VideoTrack::Config config;
+  config.id = "video-" + std::to_string(ssrc);
+  config.ssrc = ssrc;
+  return std::make_shared<VideoTrack>(config);
+}
+
+}  // namespace
+
+// ============================================================================
+// SpscQueue
+// ============================================================================
+
+TEST(SpscQueueTest, FifoWithinCapacity) {
+  SpscQueue<int> queue(3);
+  EXPECT_EQ(queue.Capacity(), 3U);
+  EXPECT_TRUE(queue.Empty());
+  EXPECT_EQ(queue.Front(), nullptr);
+
+  for (int i = 0; i < 3; ++i) {
+    int* slot = queue.PrepareWrite();
+    ASSERT_NE(slot, nullptr);
+    *slot = i;
+    queue.CommitWrite();
+  }
+  EXPECT_EQ(queue.PrepareWrite(), nullptr);
+  EXPECT_EQ(queue.Size(), 3U);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(queue.Front(), nullptr);
+    EXPECT_EQ(*queue.Front(), i);
+    queue.PopFront();
+  }
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(SpscQueueTest, TransfersAcrossThreadsInOrder) {
+  constexpr uint64_t kCount = 200000;
+  SpscQueue<uint64_t> queue(64);
+
+  std::thread producer([&] {
+    for (uint64_t i = 0; i < kCount; ++i) {
+      uint64_t* slot;
+      while ((slot = queue.PrepareWrite()) == nullptr) {
+        std::this_thread::yield();
+      }
+      *slot = i;
+      queue.CommitWrite();
+    }
+  });
+
+  uint64_t expected = 0;
+  while (expected < kCount) {
+    uint64_t* value = queue.Front();
+    if (!value) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(*value, expected);
+    queue.PopFront();
+    ++expected;
+  }
+  producer.join();
+  EXPECT_TRUE(queue.Empty());
+}
+
+// ============================================================================
+// RtpDemuxer
+// ============================================================================
+
+TEST(RtpDemuxerTest, RoutesBySsrcOnTrackThread) {
+  RtpDemuxer demuxer;
+  FrameLog log;
+  auto first = MakeVideoTrack(1111);
+  auto second = MakeVideoTrack(2222);
+  log.Attach(first);
+  log.Attach(second);
+  ASSERT_TRUE(demuxer.AddTrack(1111, first).IsOk());
+  ASSERT_TRUE(demuxer.AddTrack(2222, second).IsOk());
+  EXPECT_TRUE(demuxer.AddTrack(1111, MakeVideoTrack(1111)).IsErr());
+
+  for (uint32_t i = 0; i < 10; ++i) {
+    const uint32_t ssrc = (i % 2 == 0) ? 1111 : 2222;
+    auto packet =
+        MakeRtpPacket(ssrc, VideoTrack::kPayloadType, 3000 * i,
+                      {static_cast<uint8_t>(i), static_cast<uint8_t>(i + 1)});
+    EXPECT_TRUE(demuxer.OnRtpPacket(packet.data(), packet.size()));
+  }
+
+  ASSERT_TRUE(log.WaitFor(1111, 5));
+  ASSERT_TRUE(log.WaitFor(2222, 5));
+  auto frames = log.Get(1111);
+  for (uint32_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(frames[i].timestamp, 3000 * (2 * i));
+    EXPECT_EQ(frames[i].data,
+              (std::vector<uint8_t>{static_cast<uint8_t>(2 * i),
+                                    static_cast<uint8_t>(2 * i + 1)}));
+  }
+  EXPECT_NE(log.Thread(1111), std::this_thread::get_id());
+  EXPECT_NE(log.Thread(1111), log.Thread(2222));
+
+  auto stats = demuxer.GetStats();
+  EXPECT_EQ(stats.packets_received, 10U);
+  EXPECT_EQ(stats.packets_dispatched, 10U);
+  EXPECT_EQ(stats.tracks_created, 0U);
+}
+
+TEST(RtpDemuxerTest, CreatesTrackForUnknownSsrc) {
+  RtpDemuxer demuxer;
+  demuxer.RegisterPayloadType(VideoTrack::kPayloadType,
+                              MediaTrack::Kind::kVideo);
+  demuxer.RegisterPayloadType(AudioTrack::kPayloadType,
+                              MediaTrack::Kind::kAudio);
+
+  FrameLog log;
+  std::vector<std::pair<uint32_t, MediaTrack::Kind>> created;
+  demuxer.SetOnUnknownSsrcCallback(
+      [&](uint32_t ssrc, uint8_t, MediaTrack::Kind kind)
+          -> std::shared_ptr<MediaTrack> {
+        created.emplace_back(ssrc, kind);
+        std::shared_ptr<MediaTrack> track;
+        if (kind == MediaTrack::Kind::kVideo) {
+          track = MakeVideoTrack(ssrc);
+        } else {
+          AudioTrack::Config config;
+          config.ssrc = ssrc;
+          track = std::make_shared<AudioTrack>(config);
+        }
+        log.Attach(track);
+        return track;
+      });
+
+  for (int i = 0; i < 3; ++i) {
+    auto video = MakeRtpPacket(42, VideoTrack::kPayloadType, i, {1, 2, 3});
+    auto audio = MakeRtpPacket(43, AudioTrack::kPayloadType, i, {4});
+    demuxer.OnRtpPacket(video.data(), video.size());
+    demuxer.OnRtpPacket(audio.data(), audio.size());
+  }
+
+  // 首包即交付，且每个 SSRC 只创建一次
+  ASSERT_TRUE(log.WaitFor(42, 3));
+  ASSERT_TRUE(log.WaitFor(43, 3));
+  ASSERT_EQ(created.size(), 2U);
+  EXPECT_EQ(created[0],
+            std::make_pair(uint32_t{42}, MediaTrack::Kind::kVideo));
+  EXPECT_EQ(created[1],
+            std::make_pair(uint32_t{43}, MediaTrack::Kind::kAudio));
+  EXPECT_EQ(demuxer.GetStats().tracks_created, 2U);
+}
+
+TEST(RtpDemuxerTest, IgnoresUnroutablePackets) {
+  RtpDemuxer demuxer;
+  demuxer.RegisterPayloadType(VideoTrack::kPayloadType,
+                              MediaTrack::Kind::kVideo);
+  int callbacks = 0;
+  demuxer.SetOnUnknownSsrcCallback(
+      [&](uint32_t, uint8_t, MediaTrack::Kind) -> std::shared_ptr<MediaTrack> {
+        ++callbacks;
+        return nullptr;
+      });
+
+  // 非 RTP：版本号不为 2 或长度不足
+  std::vector<uint8_t> garbage(20, 0);
+  EXPECT_FALSE(demuxer.OnRtpPacket(garbage.data(), garbage.size()));
+  EXPECT_FALSE(demuxer.OnRtpPacket(garbage.data(), 4));
+
+  // 未声明的负载类型不会创建轨道
+  auto unknown_type = MakeRtpPacket(7, 111, 0, {1});
+  EXPECT_TRUE(demuxer.OnRtpPacket(unknown_type.data(), unknown_type.size()));
+  EXPECT_EQ(callbacks, 0);
+
+  // 被拒绝的 SSRC 只询问一次
+  auto declined = MakeRtpPacket(8, VideoTrack::kPayloadType, 0, {1});
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_TRUE(demuxer.OnRtpPacket(declined.data(), declined.size()));
+  }
+  EXPECT_EQ(callbacks, 1);
+
+  auto stats = demuxer.GetStats();
+  EXPECT_EQ(stats.packets_received, 6U);
+  EXPECT_EQ(stats.packets_unrouted, 6U);
+  EXPECT_EQ(stats.packets_dispatched, 0U);
+
+  // 之后仍可显式绑定被拒绝的 SSRC
+  FrameLog log;
+  auto track = MakeVideoTrack(8);
+  log.Attach(track);
+  ASSERT_TRUE(demuxer.AddTrack(8, track).IsOk());
+  demuxer.OnRtpPacket(declined.data(), declined.size());
+  EXPECT_TRUE(log.WaitFor(8, 1));
+}
+
+TEST(RtpDemuxerTest, DropsWhenTrackQueueIsFull) {
+  RtpDemuxer::Config config;
+  config.queue_capacity = 4;
+  RtpDemuxer demuxer(config);
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool release = false;
+  std::atomic<int> delivered{0};
+  auto track = MakeVideoTrack(5);
+  track->SetOnFrameCallback([&](const uint8_t*, size_t, uint32_t) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return release; });
+    delivered++;
+  });
+  ASSERT_TRUE(demuxer.AddTrack(5, track).IsOk());
+
+  // 处理线程卡在第一帧：队列再容纳 4 个，其余丢弃，调用方不阻塞
+  auto packet = MakeRtpPacket(5, VideoTrack::kPayloadType, 0, {9});
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 20; ++i) {
+    demuxer.OnRtpPacket(packet.data(), packet.size());
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  demuxer.Clear();
+
+  auto stats = demuxer.GetStats();
+  EXPECT_EQ(stats.packets_dispatched + stats.packets_dropped, 20U);
+  EXPECT_GE(stats.packets_dropped, 15U);
+  EXPECT_EQ(static_cast<uint64_t>(delivered.load()),
+            stats.packets_dispatched);
+}
+
+TEST(RtpDemuxerTest, StripsCsrcExtensionAndPadding) {
+  RtpDemuxer demuxer;
+  FrameLog log;
+  auto track = MakeVideoTrack(77);
+  log.Attach(track);
+  ASSERT_TRUE(demuxer.AddTrack(77, track).IsOk());
+
+  auto packet = MakeRtpPacket(77, VideoTrack::kPayloadType, 1, {});
+  network::RTPHeader header;
+  std::memcpy(&header, packet.data(), sizeof(header));
+  header.csrc_count = 1;
+  header.extension = 1;
+  header.padding = 1;
+  std::memcpy(packet.data(), &header, sizeof(header));
+  const std::vector<uint8_t> csrc = {0, 0, 0, 1};
+  const std::vector<uint8_t> extension = {0xBE, 0xDE, 0, 1, 1, 2, 3, 4};
+  const std::vector<uint8_t> payload = {10, 20, 30};
+  const std::vector<uint8_t> padding = {0, 0, 3};
+  for (const auto* part : {&csrc, &extension, &payload, &padding}) {
+    packet.insert(packet.end(), part->begin(), part->end());
+  }
+
+  ASSERT_TRUE(demuxer.OnRtpPacket(packet.data(), packet.size()));
+  ASSERT_TRUE(log.WaitFor(77, 1));
+  EXPECT_EQ(log.Get(77)[0].data, payload);
+
+  // 扩展头长度越界
+  auto truncated = MakeRtpPacket(77, VideoTrack::kPayloadType, 1, {0, 0, 0, 9});
+  std::memcpy(&header, truncated.data(), sizeof(header));
+  header.extension = 1;
+  header.csrc_count = 0;
+  header.padding = 0;
+  std::memcpy(truncated.data(), &header, sizeof(header));
+  EXPECT_TRUE(demuxer.OnRtpPacket(truncated.data(), truncated.size()));
+  EXPECT_EQ(demuxer.GetStats().packets_invalid, 1U);
+}
+
+// ============================================================================
+// 基准测试（手动运行：--gtest_also_run_disabled_tests）
+// ============================================================================
+
+TEST(RtpDemuxerBenchmark, DISABLED_NetworkThreadCostPerPacket) {
+  constexpr int kTracks = 4;
+  constexpr int kPackets = 1000000;
+  RtpDemuxer::Config config;
+  config.queue_capacity = 4096;
+  RtpDemuxer demuxer(config);
+
+  std::atomic<uint64_t> delivered{0};
+  std::vector<std::vector<uint8_t>> packets;
+  for (int i = 0; i < kTracks; ++i) {
+    const uint32_t ssrc = 0x10000000U + i * 7919;
+    auto track = MakeVideoTrack(ssrc);
+    track->SetOnFrameCallback(
+        [&](const uint8_t*, size_t, uint32_t) { delivered++; });
+    ASSERT_TRUE(demuxer.AddTrack(ssrc, track).IsOk());
+    packets.push_back(MakeRtpPacket(ssrc, VideoTrack::kPayloadType, 0,
+                                    std::vector<uint8_t>(1200, 0xAB)));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kPackets; ++i) {
+    const auto& packet = packets[i % kTracks];
+    demuxer.OnRtpPacket(packet.data(), packet.size());
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  demuxer.Clear();
+
+  auto stats = demuxer.GetStats();
+  std::cout << "[ BENCH    ] " << kPackets << " packets, " << kTracks
+            << " tracks, 1200-byte payload" << std::endl;
+  std::cout << "[ BENCH    ] dispatched " << stats.packets_dispatched
+            << ", dropped " << stats.packets_dropped << ", delivered "
+            << delivered.load() << std::endl;
+  std::cout << "[ BENCH    ] network thread "
+            << stats.dispatch_time_ns /
+                   std::max<uint64_t>(stats.packets_dispatched, 1)
+            << " ns/packet (in OnRtpPacket), wall "
+            << seconds * 1e9 / kPackets << " ns/packet" << std::endl;
+}
+
+}  // namespace zenremote
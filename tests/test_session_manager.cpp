@@ -0,0 +1,416 @@
+/**
+ * @file test_session_manager.cpp
+ * @brief 多会话主机测试：共享反应器、编码线程池、准入与回环压测
+ *
+ * 测试目标：
+ * - NetworkReactor 用少量线程服务多个连接，Unregister 后回调不再执行
+ * - EncoderWorkerPool 同一会话串行、会话间轮转，排队超限丢弃最旧任务
+ * - SessionManager 超出 CPU / 带宽预算时以 kResourceExhausted 拒绝
+ * - RunLoadTest 在回环上建立多个会话并报告每个会话的延迟分位数
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "app/server/encoder_worker_pool.h"
+#include "app/server/latency_window.h"
+#include "app/server/load_test.h"
+#include "app/server/session_manager.h"
+#include "app/server/synthetic_video_source.h"
+#include "network/connection/direct_connection.h"
+#include "network/connection/network_reactor.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kReactorBasePort = 47411;  // 47411..47418
+constexpr uint16_t kLoadTestBasePort = 47421;
+constexpr uint16_t kAdmissionBasePort = 47431;
+constexpr uint16_t kBenchBasePort = 47441;
+
+std::unique_ptr<DirectConnection> MakeConnection(uint16_t local_port,
+                                                 uint16_t remote_port) {
+  DirectConnection::Config config;
+  config.local_ip = "127.0.0.1";
+  config.local_port = local_port;
+  config.remote = {"127.0.0.1", remote_port};
+  auto connection = std::make_unique<DirectConnection>();
+  EXPECT_TRUE(connection->Initialize(config).IsOk());
+  return connection;
+}
+
+template <typename Predicate>
+bool WaitFor(Predicate predicate, std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (!predicate()) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(LatencyWindowTest, ReportsNearestRankPercentiles) {
+  LatencyWindow window(100);
+  for (int i = 1; i <= 100; ++i) {
+    window.Add(static_cast<double>(i));
+  }
+  auto summary = window.Summarize();
+  EXPECT_EQ(summary.samples, 100U);
+  EXPECT_DOUBLE_EQ(summary.p50_ms, 50.0);
+  EXPECT_DOUBLE_EQ(summary.p90_ms, 90.0);
+  EXPECT_DOUBLE_EQ(summary.p99_ms, 99.0);
+  EXPECT_DOUBLE_EQ(summary.max_ms, 100.0);
+
+  // 窗口满后覆盖最旧的样本
+  for (int i = 0; i < 100; ++i) {
+    window.Add(1.0);
+  }
+  EXPECT_DOUBLE_EQ(window.Summarize().max_ms, 1.0);
+}
+
+TEST(NetworkReactorTest, ServesManyConnectionsOnFewThreads) {
+  constexpr size_t kPairs = 4;
+  NetworkReactor::Config config;
+  config.threads = 2;
+  NetworkReactor reactor(config);
+  ASSERT_TRUE(reactor.Start().IsOk());
+
+  std::vector<std::unique_ptr<DirectConnection>> senders;
+  std::vector<std::unique_ptr<DirectConnection>> receivers;
+  std::vector<std::atomic<int>> received(kPairs);
+  std::vector<NetworkReactor::RegistrationId> ids;
+  for (size_t i = 0; i < kPairs; ++i) {
+    const auto send_port = static_cast<uint16_t>(kReactorBasePort + 2 * i);
+    senders.push_back(MakeConnection(send_port, send_port + 1));
+    receivers.push_back(MakeConnection(send_port + 1, send_port));
+    auto id = reactor.Register(
+        receivers.back().get(),
+        [&received, i](const uint8_t*, size_t) { received[i]++; }, nullptr);
+    ASSERT_TRUE(id.IsOk());
+    ids.push_back(id.Value());
+  }
+  EXPECT_EQ(reactor.GetStats().registrations, kPairs);
+
+  const uint8_t packet[32] = {1};
+  for (int round = 0; round < 10; ++round) {
+    for (auto& sender : senders) {
+      ASSERT_TRUE(sender->Send(packet, sizeof(packet)).IsOk());
+    }
+  }
+  EXPECT_TRUE(WaitFor(
+      [&]() {
+        for (auto& count : received) {
+          if (count < 10) {
+            return false;
+          }
+        }
+        return true;
+      },
+      2000ms));
+
+  // 注销返回后回调不再执行
+  reactor.Unregister(ids[0]);
+  const int before = received[0];
+  ASSERT_TRUE(senders[0]->Send(packet, sizeof(packet)).IsOk());
+  ASSERT_TRUE(senders[1]->Send(packet, sizeof(packet)).IsOk());
+  EXPECT_TRUE(WaitFor([&]() { return received[1] >= 11; }, 2000ms));
+  EXPECT_EQ(received[0], before);
+  EXPECT_EQ(reactor.GetStats().registrations, kPairs - 1);
+
+  // 投递的任务在连接所在的线程执行
+  std::atomic<bool> ran{false};
+  reactor.Post(ids[2], [&ran]() { ran = true; });
+  EXPECT_TRUE(WaitFor([&]() { return ran.load(); }, 2000ms));
+
+  reactor.Stop();
+}
+
+TEST(EncoderWorkerPoolTest, SerializesEachSessionAndRunsSessionsInParallel) {
+  EncoderWorkerPool::Config config;
+  config.threads = 4;
+  config.max_pending_per_session = 64;
+  EncoderWorkerPool pool(config);
+
+  constexpr int kJobs = 20;
+  auto a = pool.AddSession();
+  auto b = pool.AddSession();
+  std::atomic<int> in_flight_a{0};
+  std::atomic<int> max_in_flight_a{0};
+  std::atomic<int> concurrent_sessions{0};
+  std::atomic<int> max_concurrent_sessions{0};
+  std::mutex order_mutex;
+  std::vector<int> order_a;
+  std::atomic<int> done{0};
+
+  auto track_concurrency = [&]() {
+    const int now = ++concurrent_sessions;
+    int expected = max_concurrent_sessions;
+    while (now > expected &&
+           !max_concurrent_sessions.compare_exchange_weak(expected, now)) {
+    }
+    std::this_thread::sleep_for(1ms);
+    --concurrent_sessions;
+  };
+
+  for (int i = 0; i < kJobs; ++i) {
+    ASSERT_TRUE(pool.Submit(a, [&, i]() {
+                      const int now = ++in_flight_a;
+                      if (now > max_in_flight_a) {
+                        max_in_flight_a = now;
+                      }
+                      track_concurrency();
+                      {
+                        std::lock_guard<std::mutex> lock(order_mutex);
+                        order_a.push_back(i);
+                      }
+                      --in_flight_a;
+                      ++done;
+                    })
+                    .IsOk());
+    ASSERT_TRUE(pool.Submit(b, [&]() {
+                      track_concurrency();
+                      ++done;
+                    })
+                    .IsOk());
+  }
+  ASSERT_TRUE(WaitFor([&]() { return done == 2 * kJobs; }, 5000ms));
+
+  EXPECT_EQ(max_in_flight_a, 1);
+  EXPECT_EQ(max_concurrent_sessions, 2);
+  ASSERT_EQ(order_a.size(), static_cast<size_t>(kJobs));
+  for (int i = 0; i < kJobs; ++i) {
+    EXPECT_EQ(order_a[i], i);
+  }
+  auto stats = pool.GetSessionStats(a);
+  ASSERT_TRUE(stats.IsOk());
+  EXPECT_EQ(stats.Value().jobs_completed, static_cast<uint64_t>(kJobs));
+  EXPECT_GT(stats.Value().busy_time_us, 0U);
+}
+
+TEST(EncoderWorkerPoolTest, RoundRobinKeepsBacklogFromStarvingOthers) {
+  EncoderWorkerPool::Config config;
+  config.threads = 1;
+  config.max_pending_per_session = 64;
+  EncoderWorkerPool pool(config);
+
+  // 先占住唯一的线程，再让 a 积压、b 提交一个任务
+  std::mutex gate_mutex;
+  std::condition_variable gate_cv;
+  bool open = false;
+  auto blocker = pool.AddSession();
+  ASSERT_TRUE(pool.Submit(blocker, [&]() {
+                    std::unique_lock<std::mutex> lock(gate_mutex);
+                    gate_cv.wait(lock, [&]() { return open; });
+                  })
+                  .IsOk());
+
+  auto a = pool.AddSession();
+  auto b = pool.AddSession();
+  std::mutex order_mutex;
+  std::vector<char> order;
+  auto record = [&](char name) {
+    return [&, name]() {
+      std::lock_guard<std::mutex> lock(order_mutex);
+      order.push_back(name);
+    };
+  };
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(pool.Submit(a, record('a')).IsOk());
+  }
+  ASSERT_TRUE(pool.Submit(b, record('b')).IsOk());
+  {
+    std::lock_guard<std::mutex> lock(gate_mutex);
+    open = true;
+  }
+  gate_cv.notify_all();
+
+  ASSERT_TRUE(WaitFor(
+      [&]() {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        return order.size() == 11;
+      },
+      2000ms));
+  // b 在 a 的第一个任务之后执行，而不是等 a 的积压全部执行完
+  EXPECT_EQ(order[0], 'a');
+  EXPECT_EQ(order[1], 'b');
+}
+
+TEST(EncoderWorkerPoolTest, DropsOldestPendingJobAndRemoveWaitsForRunning) {
+  EncoderWorkerPool::Config config;
+  config.threads = 1;
+  config.max_pending_per_session = 1;
+  EncoderWorkerPool pool(config);
+
+  std::mutex gate_mutex;
+  std::condition_variable gate_cv;
+  bool open = false;
+  std::atomic<bool> running{false};
+  auto session = pool.AddSession();
+  ASSERT_TRUE(pool.Submit(session, [&]() {
+                    running = true;
+                    std::unique_lock<std::mutex> lock(gate_mutex);
+                    gate_cv.wait(lock, [&]() { return open; });
+                  })
+                  .IsOk());
+  ASSERT_TRUE(WaitFor([&]() { return running.load(); }, 2000ms));
+
+  std::atomic<int> last_run{-1};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(pool.Submit(session, [&, i]() { last_run = i; }).IsOk());
+  }
+  auto stats = pool.GetSessionStats(session);
+  ASSERT_TRUE(stats.IsOk());
+  EXPECT_EQ(stats.Value().jobs_dropped, 2U);
+
+  {
+    std::lock_guard<std::mutex> lock(gate_mutex);
+    open = true;
+  }
+  gate_cv.notify_all();
+  ASSERT_TRUE(WaitFor([&]() { return last_run == 2; }, 2000ms));
+
+  // 移除时等待执行中的任务返回，之后的提交被拒绝
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  ASSERT_TRUE(pool.Submit(session, [&]() {
+                    started = true;
+                    std::this_thread::sleep_for(20ms);
+                    finished = true;
+                  })
+                  .IsOk());
+  ASSERT_TRUE(WaitFor([&]() { return started.load(); }, 2000ms));
+  pool.RemoveSession(session);
+  EXPECT_TRUE(finished);
+  EXPECT_TRUE(pool.Submit(session, []() {}).IsErr());
+}
+
+TEST(SessionManagerTest, RejectsSessionsOverCpuAndBandwidthBudget) {
+  SessionManager::Config config;
+  config.encoder_threads = 2;
+  config.cpu_budget_cores = 1.0;
+  config.bandwidth_budget_bps = 5000000;
+  SessionManager manager(config);
+  ASSERT_TRUE(manager.Start().IsOk());
+
+  auto make_session = [](uint16_t port, double cpu, uint32_t bitrate) {
+    SessionManager::SessionConfig session;
+    session.name = "viewer-" + std::to_string(port);
+    session.controller.remote_ip = "127.0.0.1";
+    session.controller.remote_port = port;
+    session.controller.enable_audio = false;
+    session.controller.video_bitrate_bps = bitrate;
+    session.controller.video_framerate = 10;
+    SyntheticVideoSource::Config source;
+    source.encode_cost_ms = 0.0;
+    session.source = std::make_shared<SyntheticVideoSource>(source);
+    session.cpu_cores = cpu;
+    return session;
+  };
+
+  auto first =
+      manager.AddSession(make_session(kAdmissionBasePort, 0.4, 2000000));
+  ASSERT_TRUE(first.IsOk()) << first.Message();
+  auto second =
+      manager.AddSession(make_session(kAdmissionBasePort + 1, 0.4, 2000000));
+  ASSERT_TRUE(second.IsOk()) << second.Message();
+
+  auto over_cpu =
+      manager.AddSession(make_session(kAdmissionBasePort + 2, 0.4, 500000));
+  ASSERT_TRUE(over_cpu.IsErr());
+  EXPECT_EQ(over_cpu.Code(), ErrorCode::kResourceExhausted);
+
+  auto over_bandwidth =
+      manager.AddSession(make_session(kAdmissionBasePort + 3, 0.1, 2000000));
+  ASSERT_TRUE(over_bandwidth.IsErr());
+  EXPECT_EQ(over_bandwidth.Code(), ErrorCode::kResourceExhausted);
+
+  auto stats = manager.GetStats();
+  EXPECT_EQ(stats.sessions, 2U);
+  EXPECT_EQ(stats.sessions_rejected, 2U);
+  EXPECT_EQ(stats.bandwidth_committed_bps, 4000000U);
+
+  // 释放预算后可以再加入
+  manager.RemoveSession(first.Value());
+  auto retry =
+      manager.AddSession(make_session(kAdmissionBasePort + 2, 0.4, 500000));
+  EXPECT_TRUE(retry.IsOk()) << retry.Message();
+
+  manager.Stop();
+}
+
+TEST(SessionManagerTest, LoadTestDeliversFramesForEverySession) {
+  LoadTestConfig config;
+  config.sessions = 4;
+  config.base_port = kLoadTestBasePort;
+  config.duration = 600ms;
+  config.framerate = 50;
+  config.source.encode_cost_ms = 1.0;
+  config.manager.encoder_threads = 2;
+  config.manager.cpu_budget_cores = 4.0;
+
+  auto report = RunLoadTest(config);
+  ASSERT_TRUE(report.IsOk()) << report.Message();
+  const auto& value = report.Value();
+  EXPECT_EQ(value.sessions_admitted, config.sessions);
+  ASSERT_EQ(value.sessions.size(), config.sessions);
+  for (const auto& session : value.sessions) {
+    EXPECT_TRUE(session.admitted);
+    EXPECT_GE(session.frames_sent, 10U) << session.name;
+    EXPECT_GE(session.frames_received, 10U) << session.name;
+    EXPECT_GT(session.end_to_end_latency.samples, 0U);
+    EXPECT_GT(session.end_to_end_latency.p50_ms, 0.0);
+    EXPECT_LE(session.end_to_end_latency.p50_ms,
+              session.end_to_end_latency.p99_ms);
+    EXPECT_LT(session.end_to_end_latency.p50_ms, 200.0) << session.name;
+  }
+  // 主机的连接都注册在共享反应器上，不为每个连接创建接收线程
+  EXPECT_EQ(value.manager.reactor.registrations, config.sessions);
+  EXPECT_FALSE(value.Format().empty());
+}
+
+TEST(SessionManagerTest, DISABLED_BenchmarkSessionScaling) {
+  for (size_t sessions : {4U, 16U, 32U}) {
+    LoadTestConfig config;
+    config.sessions = sessions;
+    config.base_port = kBenchBasePort;
+    config.duration = 3000ms;
+    config.framerate = 30;
+    config.source.encode_cost_ms = 2.0;
+    config.manager.reactor_threads = 2;
+    config.manager.cpu_budget_cores = 64.0;
+
+    auto report = RunLoadTest(config);
+    ASSERT_TRUE(report.IsOk()) << report.Message();
+    std::vector<double> p50;
+    std::vector<double> p99;
+    for (const auto& session : report.Value().sessions) {
+      p50.push_back(session.end_to_end_latency.p50_ms);
+      p99.push_back(session.end_to_end_latency.p99_ms);
+    }
+    std::sort(p50.begin(), p50.end());
+    std::sort(p99.begin(), p99.end());
+    std::printf(
+        "[ BENCH    ] %2zu sessions: e2e p50 median %.2f ms, worst p99 "
+        "%.2f ms, CPU %.2f cores\n",
+        sessions, p50[p50.size() / 2], p99.back(),
+        report.Value().manager.cpu_measured_cores);
+  }
+}
+
+}  // namespace zenremote
@@ -0,0 +1,297 @@
+/**
+ * @file test_session_resumption.cpp
+ * @brief 会话恢复（恢复票据 + 0-RTT）测试
+ *
+ * 测试目标：
+ * - 恢复票据序列化
+ * - 票据缓存：一次性兑换（查看不兑换）、过期、容量淘汰
+ * - 完整握手签发票据，重连后凭票据恢复并在首个发送批次中携带媒体
+ * - 重放旧票据被拒绝，控制端回退到完整握手
+ * - 早于恢复请求到达的媒体包被缓存而非丢弃
+ * - 本机回环上重连到首帧的耗时（要求 < 100ms）
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "network/connection/direct_connection.h"
+#include "network/protocol/handshake.h"
+#include "network/protocol/resumption_cache.h"
+#include "network/protocol/rtp_receiver.h"
+#include "network/protocol/rtp_sender.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kServerPort = 47341;
+constexpr uint16_t kClientPort = 47342;
+constexpr uint16_t kServerPortAfterBlip = 47343;
+constexpr uint16_t kClientPortAfterBlip = 47344;
+
+constexpr uint32_t kClientSsrc = 0xAAAA0001;
+constexpr uint32_t kServerSsrc = 0xBBBB0001;
+constexpr uint32_t kSessionId = 0x12345678;
+
+std::unique_ptr<DirectConnection> MakeConnection(uint16_t local_port,
+                                                 uint16_t remote_port) {
+  DirectConnection::Config config;
+  config.local_ip = "127.0.0.1";
+  config.local_port = local_port;
+  config.remote = {"127.0.0.1", remote_port};
+  auto connection = std::make_unique<DirectConnection>();
+  EXPECT_TRUE(connection->Initialize(config).IsOk());
+  return connection;
+}
+
+SessionParameters MakeParameters() {
+  SessionParameters parameters;
+  parameters.codecs = 0x01;
+  parameters.capabilities_flags = 0x0007;
+  parameters.extensions = {{1, 3}, {2, 5}};
+  parameters.decoder_config = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x1F,
+                               0x00, 0x00, 0x00, 0x01, 0x68, 0xCE, 0x3C, 0x80};
+  return parameters;
+}
+
+// 完整握手，返回控制端拿到的票据
+std::optional<ResumptionTicket> RunFullHandshake(
+    ResumptionTicketCache& cache) {
+  auto server_connection = MakeConnection(kServerPort, kClientPort);
+  auto client_connection = MakeConnection(kClientPort, kServerPort);
+
+  auto server = std::async(std::launch::async, [&]() {
+    HandshakeManager server(kServerSsrc, server_connection.get());
+    server.SetTicketCache(&cache);
+    server.SetSessionParameters(MakeParameters());
+    return server.WaitForHandshakeRequest(2000);
+  });
+
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  EXPECT_TRUE(client.InitiateHandshake(kSessionId));
+  EXPECT_TRUE(client.WaitForHandshakeResponse(2000));
+  EXPECT_TRUE(server.get());
+  EXPECT_FALSE(client.IsResumed());
+  return client.GetResumptionTicket();
+}
+
+bool IsVideo(const ReceivedPacket& packet) {
+  return packet.header.payload_type == PayloadType::kVideoH264;
+}
+
+}  // namespace
+
+TEST(ResumptionTicketTest, SerializeRoundtrip) {
+  ResumptionTicket ticket;
+  ticket.ticket_id = 0x0102030405060708ULL;
+  ticket.session_id = kSessionId;
+  ticket.client_ssrc = kClientSsrc;
+  ticket.server_ssrc = kServerSsrc;
+  ticket.lifetime_ms = 60000;
+  ticket.parameters = MakeParameters();
+
+  std::vector<uint8_t> data;
+  SerializeResumptionTicket(ticket, data);
+  auto parsed = ParseResumptionTicket(data.data(), data.size());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->ticket_id, ticket.ticket_id);
+  EXPECT_EQ(parsed->session_id, ticket.session_id);
+  EXPECT_EQ(parsed->client_ssrc, ticket.client_ssrc);
+  EXPECT_EQ(parsed->server_ssrc, ticket.server_ssrc);
+  EXPECT_EQ(parsed->lifetime_ms, ticket.lifetime_ms);
+  EXPECT_EQ(parsed->parameters.codecs, ticket.parameters.codecs);
+  ASSERT_EQ(parsed->parameters.extensions.size(), 2U);
+  EXPECT_EQ(parsed->parameters.extensions[1].id, 2);
+  EXPECT_EQ(parsed->parameters.extensions[1].type, 5);
+  EXPECT_EQ(parsed->parameters.decoder_config,
+            ticket.parameters.decoder_config);
+
+  EXPECT_FALSE(ParseResumptionTicket(data.data(), data.size() - 1).has_value());
+}
+
+TEST(ResumptionTicketCacheTest, RedeemIsSingleUse) {
+  ResumptionTicketCache cache;
+  auto ticket = cache.Issue(kSessionId, kClientSsrc, kServerSsrc, {});
+  EXPECT_NE(ticket.ticket_id, 0U);
+
+  EXPECT_FALSE(cache.Redeem(ticket.ticket_id + 1, kSessionId).has_value());
+  // Find() 只查看不兑换（用于先校验 binder）
+  EXPECT_FALSE(cache.Find(ticket.ticket_id, kSessionId + 1).has_value());
+  ASSERT_TRUE(cache.Find(ticket.ticket_id, kSessionId).has_value());
+  EXPECT_EQ(cache.Size(), 1U);
+  auto redeemed = cache.Redeem(ticket.ticket_id, kSessionId);
+  ASSERT_TRUE(redeemed.has_value());
+  EXPECT_EQ(redeemed->client_ssrc, kClientSsrc);
+  EXPECT_FALSE(cache.Redeem(ticket.ticket_id, kSessionId).has_value());
+}
+
+TEST(ResumptionTicketCacheTest, RejectsExpiredAndMismatchedTickets) {
+  ResumptionTicketCache::Config config;
+  config.lifetime_ms = 20;
+  ResumptionTicketCache cache(config);
+
+  auto mismatched = cache.Issue(kSessionId, kClientSsrc, kServerSsrc, {});
+  EXPECT_FALSE(cache.Redeem(mismatched.ticket_id, kSessionId + 1).has_value());
+
+  auto expired = cache.Issue(kSessionId, kClientSsrc, kServerSsrc, {});
+  std::this_thread::sleep_for(40ms);
+  EXPECT_FALSE(cache.Redeem(expired.ticket_id, kSessionId).has_value());
+}
+
+TEST(ResumptionTicketCacheTest, EvictsOldestBeyondCapacity) {
+  ResumptionTicketCache::Config config;
+  config.capacity = 2;
+  ResumptionTicketCache cache(config);
+
+  auto first = cache.Issue(1, kClientSsrc, kServerSsrc, {});
+  auto second = cache.Issue(2, kClientSsrc, kServerSsrc, {});
+  auto third = cache.Issue(3, kClientSsrc, kServerSsrc, {});
+  EXPECT_EQ(cache.Size(), 2U);
+  EXPECT_FALSE(cache.Redeem(first.ticket_id, 1).has_value());
+  EXPECT_TRUE(cache.Redeem(second.ticket_id, 2).has_value());
+  EXPECT_TRUE(cache.Redeem(third.ticket_id, 3).has_value());
+}
+
+TEST(SessionResumptionTest, ResumesWithZeroRttMediaAfterBlip) {
+  ResumptionTicketCache cache;
+  auto ticket = RunFullHandshake(cache);
+  ASSERT_TRUE(ticket.has_value());
+  EXPECT_EQ(ticket->session_id, kSessionId);
+  EXPECT_EQ(ticket->parameters.decoder_config,
+            MakeParameters().decoder_config);
+
+  // 网络闪断：双方换用新的 socket（控制端端口也变了）
+  auto server_connection =
+      MakeConnection(kServerPortAfterBlip, kClientPortAfterBlip);
+  std::promise<std::chrono::steady_clock::time_point> first_frame;
+  auto server = std::async(std::launch::async, [&]() {
+    HandshakeManager server(kServerSsrc, server_connection.get());
+    server.SetTicketCache(&cache);
+    if (!server.WaitForHandshakeRequest(2000) || !server.IsResumed()) {
+      return false;
+    }
+    // 恢复的会话直接带回缓存的解码参数，无需等待新的关键帧参数集
+    EXPECT_EQ(server.GetSessionParameters().decoder_config,
+              MakeParameters().decoder_config);
+    EXPECT_EQ(server.GetRemoteSSRC(), kClientSsrc);
+
+    for (auto& packet : server.TakeEarlyPackets()) {
+      if (IsVideo(packet)) {
+        first_frame.set_value(packet.arrival_time);
+        return true;
+      }
+    }
+    RTPReceiver receiver;
+    const auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (std::chrono::steady_clock::now() < deadline) {
+      auto packet = receiver.ReceivePacket(server_connection.get(), 100);
+      if (packet.has_value() && IsVideo(*packet)) {
+        first_frame.set_value(packet->arrival_time);
+        return true;
+      }
+    }
+    return false;
+  });
+
+  const auto reconnect_start = std::chrono::steady_clock::now();
+  auto client_connection =
+      MakeConnection(kClientPortAfterBlip, kServerPortAfterBlip);
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  ASSERT_TRUE(client.ResumeSession(*ticket));
+  ASSERT_TRUE(client.CanSendMedia());
+  EXPECT_FALSE(client.IsCompleted());
+
+  // 首个发送批次：恢复请求之后紧跟关键帧，不等待往返
+  RTPSender media(kClientSsrc, client_connection.get());
+  const std::vector<uint8_t> keyframe(1000, 0x65);
+  ASSERT_TRUE(media.SendVideoFrame(keyframe.data(), keyframe.size(), 0, true));
+
+  ASSERT_TRUE(client.WaitForResumeResponse(2000));
+  EXPECT_TRUE(client.IsCompleted());
+  EXPECT_TRUE(client.IsResumed());
+  EXPECT_EQ(client.GetRemoteSSRC(), kServerSsrc);
+  ASSERT_TRUE(client.GetResumptionTicket().has_value());
+  EXPECT_NE(client.GetResumptionTicket()->ticket_id, ticket->ticket_id);
+
+  ASSERT_TRUE(server.get());
+  const double reconnect_ms =
+      std::chrono::duration<double, std::milli>(
+          first_frame.get_future().get() - reconnect_start)
+          .count();
+  std::cout << "[ RESUME   ] reconnect to first frame: " << reconnect_ms
+            << " ms" << std::endl;
+  EXPECT_LT(reconnect_ms, 100.0);
+}
+
+TEST(SessionResumptionTest, ReplayedTicketFallsBackToFullHandshake) {
+  ResumptionTicketCache cache;
+  auto ticket = RunFullHandshake(cache);
+  ASSERT_TRUE(ticket.has_value());
+  // 票据已被兑换一次
+  ASSERT_TRUE(cache.Redeem(ticket->ticket_id, ticket->session_id).has_value());
+
+  auto server_connection =
+      MakeConnection(kServerPortAfterBlip, kClientPortAfterBlip);
+  auto client_connection =
+      MakeConnection(kClientPortAfterBlip, kServerPortAfterBlip);
+  auto server = std::async(std::launch::async, [&]() {
+    HandshakeManager server(kServerSsrc, server_connection.get());
+    server.SetTicketCache(&cache);
+    const bool resumed = server.WaitForHandshakeRequest(2000);
+    const bool full = server.WaitForHandshakeRequest(2000);
+    return !resumed && full && !server.IsResumed() &&
+           server.TakeEarlyPackets().empty();
+  });
+
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  ASSERT_TRUE(client.ResumeSession(*ticket));
+  RTPSender media(kClientSsrc, client_connection.get());
+  const uint8_t frame[] = {1, 2, 3};
+  media.SendVideoFrame(frame, sizeof(frame), 0, true);
+
+  EXPECT_FALSE(client.WaitForResumeResponse(2000));
+  EXPECT_EQ(client.GetState(), HandshakeState::kIdle);
+  ASSERT_TRUE(client.InitiateHandshake(kSessionId + 1));
+  EXPECT_TRUE(client.WaitForHandshakeResponse(2000));
+  EXPECT_TRUE(server.get());
+}
+
+TEST(SessionResumptionTest, BuffersMediaArrivingBeforeResumeRequest) {
+  ResumptionTicketCache cache;
+  auto ticket = RunFullHandshake(cache);
+  ASSERT_TRUE(ticket.has_value());
+
+  auto server_connection =
+      MakeConnection(kServerPortAfterBlip, kClientPortAfterBlip);
+  auto client_connection =
+      MakeConnection(kClientPortAfterBlip, kServerPortAfterBlip);
+
+  // 模拟乱序：媒体包先于恢复请求到达被控端
+  RTPSender media(kClientSsrc, client_connection.get());
+  const uint8_t frame[] = {9, 8, 7};
+  ASSERT_TRUE(media.SendVideoFrame(frame, sizeof(frame), 90000, true));
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  ASSERT_TRUE(client.ResumeSession(*ticket));
+
+  HandshakeManager server(kServerSsrc, server_connection.get());
+  server.SetTicketCache(&cache);
+  ASSERT_TRUE(server.WaitForHandshakeRequest(2000));
+  EXPECT_TRUE(server.IsResumed());
+  auto early = server.TakeEarlyPackets();
+  ASSERT_EQ(early.size(), 1U);
+  EXPECT_TRUE(IsVideo(early[0]));
+  EXPECT_EQ(early[0].header.timestamp, 90000U);
+  EXPECT_EQ(early[0].payload, std::vector<uint8_t>(frame, frame + 3));
+
+  EXPECT_TRUE(client.WaitForResumeResponse(2000));
+}
+
+}  // namespace zenremote
@@ -0,0 +1,74 @@
+/**
+ * @file test_slice_pool.cpp
+ * @brief SlicePool 分片并行执行器测试
+ *
+ * 测试目标：
+ * - 每个分片恰好执行一次，Run() 返回时全部完成
+ * - 分片数多于或少于线程数、单线程、空任务都正确
+ * - 同一个池反复 Run()（每帧调用的场景）不丢分片
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "common/slice_pool.h"
+
+namespace zenremote {
+
+TEST(SlicePoolTest, RunsEverySliceExactlyOnce) {
+  SlicePool pool(4);
+  EXPECT_EQ(pool.GetThreadCount(), 4U);
+  for (size_t count : {0U, 1U, 3U, 4U, 37U}) {
+    std::vector<std::atomic<int>> hits(count);
+    pool.Run(count, [&hits](size_t index) { hits[index].fetch_add(1); });
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(hits[i].load(), 1) << "count " << count << " index " << i;
+    }
+  }
+}
+
+TEST(SlicePoolTest, UsesWorkerThreads) {
+  SlicePool pool(3);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> waiting{0};
+  // 每个分片等到三个分片同时在执行，只有三个线程并行时才能完成
+  pool.Run(3, [&](size_t /*index*/) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    }
+    waiting.fetch_add(1);
+    while (waiting.load() < 3) {
+      std::this_thread::yield();
+    }
+  });
+  EXPECT_EQ(threads.size(), 3U);
+}
+
+TEST(SlicePoolTest, RepeatedRunsAndSingleThread) {
+  SlicePool pool(4);
+  SlicePool single(1);
+  EXPECT_EQ(single.GetThreadCount(), 1U);
+  int64_t total = 0;
+  int64_t single_total = 0;
+  for (int round = 0; round < 2000; ++round) {
+    std::atomic<int64_t> sum{0};
+    pool.Run(8, [&sum](size_t index) {
+      sum.fetch_add(static_cast<int64_t>(index) + 1);
+    });
+    total += sum.load();
+    single.Run(8, [&single_total](size_t index) {
+      single_total += static_cast<int64_t>(index) + 1;
+    });
+  }
+  EXPECT_EQ(total, 2000 * 36);
+  EXPECT_EQ(single_total, 2000 * 36);
+}
+
+}  // namespace zenremote
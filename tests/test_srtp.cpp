@@ -0,0 +1,781 @@
+/**
+ * @file test_srtp.cpp
+ * @brief 媒体加密测试：AES-GCM、X25519、HKDF 与 SRTP/SRTCP
+ *
+ * 测试目标：
+ * - AES-128-GCM 与 NIST GCM 规范测试向量一致，硬件与可移植实现结果相同
+ * - X25519（RFC 7748）、HKDF-SHA256（RFC 5869）测试向量
+ * - SRTP 往返、篡改检测、重放窗口、ROC 回绕与乱序、批量与逐包结果一致
+ * - SRTCP 往返与重放
+ * - 握手交换 X25519 公钥后双方得到匹配的会话密钥；一方未启用时握手失败；
+ *   会话恢复的 0-RTT 媒体同样加密，被控端解密早到报文；重试同一票据时派生
+ *   新密钥；只知道明文票据 ID 的第三方无法兑换票据
+ * - 基准：50 Mbit/s（60 fps）下每字节周期数与单核 CPU 占用
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define ZENREMOTE_HAS_RDTSC 1
+#endif
+
+#include "common/aes_gcm.h"
+#include "common/digest.h"
+#include "common/x25519.h"
+#include "network/connection/direct_connection.h"
+#include "network/protocol/handshake.h"
+#include "network/protocol/resumption_cache.h"
+#include "network/protocol/rtp_receiver.h"
+#include "network/protocol/rtp_sender.h"
+#include "network/protocol/srtp.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kServerPort = 47381;
+constexpr uint16_t kClientPort = 47382;
+constexpr uint16_t kMismatchServerPort = 47383;
+constexpr uint16_t kMismatchClientPort = 47384;
+constexpr uint16_t kResumeServerPort = 47385;
+constexpr uint16_t kResumeClientPort = 47386;
+
+constexpr uint32_t kClientSsrc = 0xC1C10001;
+constexpr uint32_t kServerSsrc = 0x5E5E0001;
+constexpr uint32_t kSessionId = 0x0BADF00D;
+
+std::vector<uint8_t> FromHex(const std::string& hex) {
+  std::vector<uint8_t> bytes;
+  for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+    bytes.push_back(
+        static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+  }
+  return bytes;
+}
+
+std::string ToHex(const uint8_t* data, size_t length) {
+  std::string hex;
+  char digits[3];
+  for (size_t i = 0; i < length; ++i) {
+    std::snprintf(digits, sizeof(digits), "%02x", data[i]);
+    hex += digits;
+  }
+  return hex;
+}
+
+struct GcmVector {
+  const char* key;
+  const char* iv;
+  const char* plaintext;
+  const char* aad;
+  const char* ciphertext;
+  const char* tag;
+};
+
+// NIST GCM 规范（McGrew & Viega）Test Case 1-4
+const GcmVector kGcmVectors[] = {
+    {"00000000000000000000000000000000", "000000000000000000000000", "", "",
+     "", "58e2fccefa7e3061367f1d57a4e7455a"},
+    {"00000000000000000000000000000000", "000000000000000000000000",
+     "00000000000000000000000000000000", "",
+     "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf"},
+    {"feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+     "",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+     "4d5c2af327cd64a62cf35abd2ba6fab4"},
+    {"feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39",
+     "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+};
+
+const AesGcm128::Implementation kImplementations[] = {
+    AesGcm128::Implementation::kAuto, AesGcm128::Implementation::kPortable};
+
+SrtpKeyMaterial MakeKeyMaterial() {
+  SrtpMasterSecret master;
+  for (size_t i = 0; i < master.size(); ++i) {
+    master[i] = static_cast<uint8_t>(i * 7 + 1);
+  }
+  return DeriveSrtpKeys(master);
+}
+
+/// @brief 控制端 → 被控端方向的一对会话
+struct SrtpPair {
+  explicit SrtpPair(AesGcm128::Implementation implementation =
+                        AesGcm128::Implementation::kAuto) {
+    const auto keys = MakeKeyMaterial();
+    SrtpSession::Config config;
+    config.implementation = implementation;
+    client = std::make_unique<SrtpSession>(keys.client_to_server,
+                                           keys.server_to_client, config);
+    server = std::make_unique<SrtpSession>(keys.server_to_client,
+                                           keys.client_to_server, config);
+  }
+
+  std::unique_ptr<SrtpSession> client;
+  std::unique_ptr<SrtpSession> server;
+};
+
+std::vector<uint8_t> MakeRtp(uint16_t sequence,
+                             size_t payload_size,
+                             uint32_t ssrc = kClientSsrc) {
+  RtpPacket packet;
+  packet.header.payload_type = PayloadType::kVideoH264;
+  packet.header.sequence_number = sequence;
+  packet.header.timestamp = 90000U + sequence;
+  packet.header.ssrc = ssrc;
+  packet.payload.resize(payload_size);
+  for (size_t i = 0; i < payload_size; ++i) {
+    packet.payload[i] = static_cast<uint8_t>(sequence + i);
+  }
+  return SerializeRtpPacket(packet);
+}
+
+std::vector<uint8_t> Protect(SrtpSession& session,
+                             const std::vector<uint8_t>& packet) {
+  auto copy = packet;
+  EXPECT_TRUE(session.ProtectRtp(copy));
+  return copy;
+}
+
+bool Unprotect(SrtpSession& session,
+               std::vector<uint8_t> packet,
+               const std::vector<uint8_t>& expected) {
+  auto length = session.UnprotectRtp(packet.data(), packet.size());
+  if (!length.has_value()) {
+    return false;
+  }
+  packet.resize(*length);
+  EXPECT_EQ(packet, expected);
+  return packet == expected;
+}
+
+std::unique_ptr<DirectConnection> MakeConnection(uint16_t local_port,
+                                                 uint16_t remote_port) {
+  DirectConnection::Config config;
+  config.local_ip = "127.0.0.1";
+  config.local_port = local_port;
+  config.remote = {"127.0.0.1", remote_port};
+  auto connection = std::make_unique<DirectConnection>();
+  EXPECT_TRUE(connection->Initialize(config).IsOk());
+  return connection;
+}
+
+std::vector<uint8_t> MakeFrame(size_t size) {
+  std::vector<uint8_t> frame(size);
+  for (size_t i = 0; i < size; ++i) {
+    frame[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return frame;
+}
+
+/// @brief 按到达顺序拼接视频负载直到 marker 包
+std::vector<uint8_t> ReceiveFrame(RTPReceiver& receiver,
+                                  BaseConnection* connection) {
+  std::vector<uint8_t> frame;
+  const auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (std::chrono::steady_clock::now() < deadline) {
+    auto packet = receiver.ReceivePacket(connection, 100);
+    if (!packet.has_value() ||
+        packet->header.payload_type != PayloadType::kVideoH264) {
+      continue;
+    }
+    frame.insert(frame.end(), packet->payload.begin(), packet->payload.end());
+    if (packet->header.marker) {
+      break;
+    }
+  }
+  return frame;
+}
+
+}  // namespace
+
+// ============================================================================
+// 密码学原语
+// ============================================================================
+
+TEST(AesGcm128Test, MatchesNistVectors) {
+  for (auto implementation : kImplementations) {
+    for (const auto& vector : kGcmVectors) {
+      const auto key = FromHex(vector.key);
+      const auto iv = FromHex(vector.iv);
+      const auto aad = FromHex(vector.aad);
+      const auto plaintext = FromHex(vector.plaintext);
+      AesGcm128 gcm(key.data(), implementation);
+
+      auto data = plaintext;
+      uint8_t tag[AesGcm128::kTagSize];
+      gcm.Seal(iv.data(), aad.data(), aad.size(), data.data(), data.size(),
+               tag);
+      EXPECT_EQ(ToHex(data.data(), data.size()), vector.ciphertext);
+      EXPECT_EQ(ToHex(tag, sizeof(tag)), vector.tag);
+
+      ASSERT_TRUE(gcm.Open(iv.data(), aad.data(), aad.size(), data.data(),
+                           data.size(), tag));
+      EXPECT_EQ(data, plaintext);
+    }
+  }
+}
+
+TEST(AesGcm128Test, HardwareMatchesPortableAndRejectsTampering) {
+  std::mt19937 rng(37);
+  for (int i = 0; i < 200; ++i) {
+    uint8_t key[AesGcm128::kKeySize];
+    uint8_t iv[AesGcm128::kIvSize];
+    for (auto& byte : key) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    for (auto& byte : iv) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> aad(rng() % 40);
+    std::vector<uint8_t> data(rng() % 300);
+    for (auto& byte : aad) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    for (auto& byte : data) {
+      byte = static_cast<uint8_t>(rng());
+    }
+
+    AesGcm128 fast(key);
+    AesGcm128 portable(key, AesGcm128::Implementation::kPortable);
+    auto fast_data = data;
+    auto portable_data = data;
+    uint8_t fast_tag[AesGcm128::kTagSize];
+    uint8_t portable_tag[AesGcm128::kTagSize];
+    fast.Seal(iv, aad.data(), aad.size(), fast_data.data(), fast_data.size(),
+              fast_tag);
+    portable.Seal(iv, aad.data(), aad.size(), portable_data.data(),
+                  portable_data.size(), portable_tag);
+    ASSERT_EQ(fast_data, portable_data);
+    ASSERT_EQ(ToHex(fast_tag, sizeof(fast_tag)),
+              ToHex(portable_tag, sizeof(portable_tag)));
+
+    fast_tag[i % AesGcm128::kTagSize] ^= 0x01;
+    EXPECT_FALSE(fast.Open(iv, aad.data(), aad.size(), fast_data.data(),
+                           fast_data.size(), fast_tag));
+  }
+}
+
+TEST(X25519Test, MatchesRfc7748Vectors) {
+  X25519Key alice;
+  X25519Key bob;
+  auto alice_bytes = FromHex(
+      "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a");
+  auto bob_bytes = FromHex(
+      "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb");
+  std::copy(alice_bytes.begin(), alice_bytes.end(), alice.begin());
+  std::copy(bob_bytes.begin(), bob_bytes.end(), bob.begin());
+
+  const auto alice_public = X25519PublicKey(alice);
+  const auto bob_public = X25519PublicKey(bob);
+  EXPECT_EQ(ToHex(alice_public.data(), alice_public.size()),
+            "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a");
+  EXPECT_EQ(ToHex(bob_public.data(), bob_public.size()),
+            "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f");
+
+  X25519Key shared_alice;
+  X25519Key shared_bob;
+  ASSERT_TRUE(X25519SharedSecret(alice, bob_public, shared_alice));
+  ASSERT_TRUE(X25519SharedSecret(bob, alice_public, shared_bob));
+  EXPECT_EQ(ToHex(shared_alice.data(), shared_alice.size()),
+            "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742");
+  EXPECT_EQ(shared_alice, shared_bob);
+
+  // 小阶点（全 0）得到全 0 共享密钥，必须拒绝
+  X25519Key zero{};
+  X25519Key rejected;
+  EXPECT_FALSE(X25519SharedSecret(alice, zero, rejected));
+}
+
+TEST(DigestTest, Sha256HmacAndHkdfVectors) {
+  const std::string abc = "abc";
+  const auto digest =
+      Sha256(reinterpret_cast<const uint8_t*>(abc.data()), abc.size());
+  EXPECT_EQ(ToHex(digest.data(), digest.size()),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+  // RFC 4231 Test Case 2
+  const std::string key = "Jefe";
+  const std::string data = "what do ya want for nothing?";
+  const auto mac = HmacSha256(reinterpret_cast<const uint8_t*>(key.data()),
+                              key.size(),
+                              reinterpret_cast<const uint8_t*>(data.data()),
+                              data.size());
+  EXPECT_EQ(ToHex(mac.data(), mac.size()),
+            "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+
+  // RFC 5869 Test Case 1
+  const auto ikm = FromHex("0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b");
+  const auto salt = FromHex("000102030405060708090a0b0c");
+  const auto info = FromHex("f0f1f2f3f4f5f6f7f8f9");
+  const auto okm =
+      HkdfSha256(salt.data(), salt.size(), ikm.data(), ikm.size(),
+                 std::string(info.begin(), info.end()), 42);
+  EXPECT_EQ(ToHex(okm.data(), okm.size()),
+            "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf"
+            "34007208d5b887185865");
+}
+
+// ============================================================================
+// SRTP / SRTCP
+// ============================================================================
+
+TEST(SrtpSessionTest, RoundTripEncryptsPayloadOnly) {
+  SrtpPair pair;
+  const auto plain = MakeRtp(100, 500);
+  const auto protected_packet = Protect(*pair.client, plain);
+  ASSERT_EQ(protected_packet.size(), plain.size() + kSrtpOverhead);
+  // 头部作为 AAD 保持明文，负载已加密
+  EXPECT_TRUE(std::equal(plain.begin(), plain.begin() + kRtpHeaderSize,
+                         protected_packet.begin()));
+  EXPECT_FALSE(std::equal(plain.begin() + kRtpHeaderSize, plain.end(),
+                          protected_packet.begin() + kRtpHeaderSize));
+
+  EXPECT_TRUE(Unprotect(*pair.server, protected_packet, plain));
+  // 方向密钥不同：自己发出的包自己解不开
+  EXPECT_FALSE(Unprotect(*pair.client, protected_packet, plain));
+  EXPECT_EQ(pair.client->GetStats().packets_protected, 1U);
+  EXPECT_EQ(pair.server->GetStats().packets_unprotected, 1U);
+}
+
+TEST(SrtpSessionTest, RejectsTamperedHeaderPayloadAndTag) {
+  SrtpPair pair;
+  const auto plain = MakeRtp(7, 64);
+  const auto protected_packet = Protect(*pair.client, plain);
+  for (size_t offset : {size_t{1}, kRtpHeaderSize + 3,
+                        protected_packet.size() - 1}) {
+    auto tampered = protected_packet;
+    tampered[offset] ^= 0x40;
+    EXPECT_FALSE(Unprotect(*pair.server, tampered, plain));
+  }
+  EXPECT_EQ(pair.server->GetStats().auth_failures, 3U);
+  // 失败的尝试不影响后续正常报文
+  EXPECT_TRUE(Unprotect(*pair.server, protected_packet, plain));
+}
+
+TEST(SrtpSessionTest, ReplayWindowRejectsDuplicatesAndStalePackets) {
+  SrtpPair pair;
+  std::vector<std::vector<uint8_t>> plain;
+  std::vector<std::vector<uint8_t>> wire;
+  for (uint16_t sequence = 0; sequence < 300; ++sequence) {
+    plain.push_back(MakeRtp(sequence, 32));
+    wire.push_back(Protect(*pair.client, plain.back()));
+  }
+
+  EXPECT_TRUE(Unprotect(*pair.server, wire[10], plain[10]));
+  EXPECT_FALSE(Unprotect(*pair.server, wire[10], plain[10]));
+  // 窗口内的乱序报文仍可接收
+  EXPECT_TRUE(Unprotect(*pair.server, wire[5], plain[5]));
+  EXPECT_TRUE(Unprotect(*pair.server, wire[299], plain[299]));
+  EXPECT_TRUE(Unprotect(*pair.server, wire[299 - 127], plain[299 - 127]));
+  // 落后超过 128 个的报文被拒绝
+  EXPECT_FALSE(Unprotect(*pair.server, wire[299 - 128], plain[299 - 128]));
+  EXPECT_EQ(pair.server->GetStats().replayed, 2U);
+}
+
+TEST(SrtpSessionTest, RolloverCounterSurvivesWrapAndReordering) {
+  SrtpPair pair;
+  std::vector<std::vector<uint8_t>> plain;
+  std::vector<std::vector<uint8_t>> wire;
+  // 跨越 65535 → 0，发送端 ROC 加 1
+  for (uint32_t i = 0; i < 40; ++i) {
+    const auto sequence = static_cast<uint16_t>(65520 + i);
+    plain.push_back(MakeRtp(sequence, 48));
+    wire.push_back(Protect(*pair.client, plain.back()));
+  }
+
+  // 回绕前后的报文交错到达
+  const std::vector<size_t> order = {0, 1, 2, 3, 20, 4, 5, 21, 6, 7, 8,
+                                     9, 10, 11, 12, 13, 14, 15, 16, 17};
+  for (size_t index : order) {
+    EXPECT_TRUE(Unprotect(*pair.server, wire[index], plain[index]))
+        << "packet " << index;
+  }
+  for (size_t index = 18; index < wire.size(); ++index) {
+    if (index == 20 || index == 21) {
+      continue;
+    }
+    EXPECT_TRUE(Unprotect(*pair.server, wire[index], plain[index]))
+        << "packet " << index;
+  }
+  // 回绕后的重放仍被识别（索引含 ROC）
+  EXPECT_FALSE(Unprotect(*pair.server, wire[30], plain[30]));
+}
+
+TEST(SrtpSessionTest, BatchMatchesPerPacketProtection) {
+  for (auto implementation : kImplementations) {
+    SrtpPair single(implementation);
+    SrtpPair batch(implementation);
+
+    std::vector<std::vector<uint8_t>> plain;
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<SrtpSession::Buffer> views;
+    for (uint16_t sequence = 0; sequence < 20; ++sequence) {
+      plain.push_back(MakeRtp(sequence, 100 + sequence * 61));
+      buffers.push_back(plain.back());
+      buffers.back().resize(plain.back().size() + kSrtpOverhead);
+    }
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      views.push_back({buffers[i].data(), plain[i].size(), buffers[i].size()});
+    }
+    ASSERT_EQ(batch.client->ProtectRtpBatch(views.data(), views.size()),
+              views.size());
+
+    for (size_t i = 0; i < plain.size(); ++i) {
+      EXPECT_EQ(views[i].length, plain[i].size() + kSrtpOverhead);
+      EXPECT_EQ(buffers[i], Protect(*single.client, plain[i]));
+      EXPECT_TRUE(Unprotect(*batch.server, buffers[i], plain[i]));
+    }
+  }
+}
+
+TEST(SrtpSessionTest, ProtectFailsWithoutTailroom) {
+  SrtpPair pair;
+  auto packet = MakeRtp(1, 20);
+  EXPECT_EQ(pair.client->ProtectRtp(packet.data(), packet.size(),
+                                    packet.size()),
+            0U);
+  uint8_t garbage[4] = {0x80, 0, 0, 0};
+  EXPECT_EQ(pair.client->ProtectRtp(garbage, sizeof(garbage), 64), 0U);
+}
+
+TEST(SrtpSessionTest, RtcpRoundTripAndReplay) {
+  SrtpPair pair;
+  // RTCP RR 头：V=2 RC=0 PT=201 length=1，后接发送者 SSRC
+  std::vector<uint8_t> plain = {0x80, 201, 0x00, 0x01, 0xC1, 0xC1, 0x00, 0x01,
+                                0xDE, 0xAD, 0xBE, 0xEF};
+  std::vector<uint8_t> buffer = plain;
+  buffer.resize(plain.size() + kSrtcpOverhead);
+  ASSERT_EQ(pair.client->ProtectRtcp(buffer.data(), plain.size(),
+                                     buffer.size()),
+            buffer.size());
+  // E 标志置位，索引从 0 开始
+  EXPECT_EQ(buffer[buffer.size() - 4], 0x80);
+
+  auto received = buffer;
+  auto length = pair.server->UnprotectRtcp(received.data(), received.size());
+  ASSERT_TRUE(length.has_value());
+  received.resize(*length);
+  EXPECT_EQ(received, plain);
+
+  received = buffer;
+  EXPECT_FALSE(
+      pair.server->UnprotectRtcp(received.data(), received.size()).has_value());
+  received = buffer;
+  received[9] ^= 0x01;
+  EXPECT_FALSE(
+      pair.server->UnprotectRtcp(received.data(), received.size()).has_value());
+}
+
+// ============================================================================
+// 握手集成
+// ============================================================================
+
+TEST(SrtpHandshakeTest, KeyExchangeProtectsFragmentedFrames) {
+  auto server_connection = MakeConnection(kServerPort, kClientPort);
+  auto client_connection = MakeConnection(kClientPort, kServerPort);
+
+  HandshakeManager server(kServerSsrc, server_connection.get());
+  server.EnableSrtp(true);
+  auto server_done = std::async(
+      std::launch::async, [&] { return server.WaitForHandshakeRequest(2000); });
+
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  client.EnableSrtp(true);
+  ASSERT_TRUE(client.InitiateHandshake(kSessionId));
+  ASSERT_TRUE(client.WaitForHandshakeResponse(2000));
+  ASSERT_TRUE(server_done.get());
+  ASSERT_NE(client.GetSrtpSession(), nullptr);
+  ASSERT_NE(server.GetSrtpSession(), nullptr);
+
+  RTPSender sender(kClientSsrc, client_connection.get());
+  sender.SetSrtpSession(client.GetSrtpSession());
+  RTPReceiver receiver;
+  receiver.SetSrtpSession(server.GetSrtpSession());
+
+  const auto frame = MakeFrame(10000);
+  ASSERT_TRUE(sender.SendFragmentedVideoFrame(frame.data(), frame.size(), 0));
+  EXPECT_EQ(ReceiveFrame(receiver, server_connection.get()), frame);
+  EXPECT_EQ(client.GetSrtpSession()->GetStats().packets_protected, 9U);
+
+  // 反方向：被控端发送，控制端解密
+  RTPSender reply_sender(kServerSsrc, server_connection.get());
+  reply_sender.SetSrtpSession(server.GetSrtpSession());
+  RTPReceiver reply_receiver;
+  reply_receiver.SetSrtpSession(client.GetSrtpSession());
+  const uint8_t input[] = {1, 2, 3, 4};
+  ASSERT_TRUE(reply_sender.SendControlMessage(input, sizeof(input), 1));
+  auto reply = reply_receiver.ReceivePacket(client_connection.get(), 1000);
+  ASSERT_TRUE(reply.has_value());
+  EXPECT_EQ(reply->payload, std::vector<uint8_t>(input, input + 4));
+
+  // 没有密钥的接收端看到的是密文
+  RTPSender plain_check(kClientSsrc, client_connection.get());
+  plain_check.SetSrtpSession(client.GetSrtpSession());
+  ASSERT_TRUE(plain_check.SendAudioPacket(input, sizeof(input), 0));
+  RTPReceiver eavesdropper;
+  auto sniffed = eavesdropper.ReceivePacket(server_connection.get(), 1000);
+  ASSERT_TRUE(sniffed.has_value());
+  EXPECT_EQ(sniffed->payload.size(), sizeof(input) + kSrtpTagSize);
+  EXPECT_FALSE(std::equal(input, input + 4, sniffed->payload.begin()));
+}
+
+TEST(SrtpHandshakeTest, MismatchedSrtpConfigurationFails) {
+  auto server_connection =
+      MakeConnection(kMismatchServerPort, kMismatchClientPort);
+  auto client_connection =
+      MakeConnection(kMismatchClientPort, kMismatchServerPort);
+
+  auto server_done = std::async(std::launch::async, [&] {
+    HandshakeManager server(kServerSsrc, server_connection.get());
+    return server.WaitForHandshakeRequest(1000);
+  });
+
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  client.EnableSrtp(true);
+  ASSERT_TRUE(client.InitiateHandshake(kSessionId));
+  EXPECT_FALSE(server_done.get());
+  EXPECT_FALSE(client.WaitForHandshakeResponse(300));
+  EXPECT_EQ(client.GetSrtpSession(), nullptr);
+}
+
+TEST(SrtpHandshakeTest, ResumedSessionEncryptsZeroRttMedia) {
+  ResumptionTicketCache cache;
+  std::optional<ResumptionTicket> ticket;
+  {
+    auto server_connection = MakeConnection(kServerPort, kClientPort);
+    auto client_connection = MakeConnection(kClientPort, kServerPort);
+    auto server_done = std::async(std::launch::async, [&] {
+      HandshakeManager server(kServerSsrc, server_connection.get());
+      server.EnableSrtp(true);
+      server.SetTicketCache(&cache);
+      return server.WaitForHandshakeRequest(2000);
+    });
+    HandshakeManager client(kClientSsrc, client_connection.get());
+    client.EnableSrtp(true);
+    ASSERT_TRUE(client.InitiateHandshake(kSessionId));
+    ASSERT_TRUE(client.WaitForHandshakeResponse(2000));
+    ASSERT_TRUE(server_done.get());
+    ticket = client.GetResumptionTicket();
+  }
+  ASSERT_TRUE(ticket.has_value());
+  ASSERT_TRUE(ticket->resumption_secret.has_value());
+
+  auto server_connection =
+      MakeConnection(kResumeServerPort, kResumeClientPort);
+  auto client_connection =
+      MakeConnection(kResumeClientPort, kResumeServerPort);
+
+  // 0-RTT：恢复请求之后立即发送加密的关键帧
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  client.EnableSrtp(true);
+  ASSERT_TRUE(client.ResumeSession(*ticket));
+  ASSERT_NE(client.GetSrtpSession(), nullptr);
+  RTPSender media(kClientSsrc, client_connection.get());
+  media.SetSrtpSession(client.GetSrtpSession());
+  const auto keyframe = MakeFrame(3000);
+  ASSERT_TRUE(
+      media.SendFragmentedVideoFrame(keyframe.data(), keyframe.size(), 0));
+
+  HandshakeManager server(kServerSsrc, server_connection.get());
+  server.EnableSrtp(true);
+  server.SetTicketCache(&cache);
+  ASSERT_TRUE(server.WaitForHandshakeRequest(2000));
+  ASSERT_TRUE(server.IsResumed());
+  ASSERT_NE(server.GetSrtpSession(), nullptr);
+
+  RTPReceiver receiver;
+  receiver.SetSrtpSession(server.GetSrtpSession());
+  std::vector<uint8_t> frame;
+  for (auto& packet : server.TakeEarlyPackets()) {
+    frame.insert(frame.end(), packet.payload.begin(), packet.payload.end());
+  }
+  if (frame.size() < keyframe.size()) {
+    auto rest = ReceiveFrame(receiver, server_connection.get());
+    frame.insert(frame.end(), rest.begin(), rest.end());
+  }
+  EXPECT_EQ(frame, keyframe);
+
+  // 恢复后换发的票据同样带恢复密钥，且双方一致
+  ASSERT_TRUE(client.WaitForResumeResponse(2000));
+  ASSERT_TRUE(client.GetResumptionTicket().has_value());
+  EXPECT_TRUE(client.GetResumptionTicket()->resumption_secret.has_value());
+  const auto next = cache.Redeem(client.GetResumptionTicket()->ticket_id,
+                                 kSessionId);
+  ASSERT_TRUE(next.has_value());
+  EXPECT_EQ(next->resumption_secret,
+            client.GetResumptionTicket()->resumption_secret);
+}
+
+TEST(SrtpHandshakeTest, RetriedResumeDerivesFreshKeys) {
+  ResumptionTicketCache cache;
+  std::optional<ResumptionTicket> ticket;
+  {
+    auto server_connection = MakeConnection(kServerPort, kClientPort);
+    auto client_connection = MakeConnection(kClientPort, kServerPort);
+    auto server_done = std::async(std::launch::async, [&] {
+      HandshakeManager server(kServerSsrc, server_connection.get());
+      server.EnableSrtp(true);
+      server.SetTicketCache(&cache);
+      return server.WaitForHandshakeRequest(2000);
+    });
+    HandshakeManager client(kClientSsrc, client_connection.get());
+    client.EnableSrtp(true);
+    ASSERT_TRUE(client.InitiateHandshake(kSessionId));
+    ASSERT_TRUE(client.WaitForHandshakeResponse(2000));
+    ASSERT_TRUE(server_done.get());
+    ticket = client.GetResumptionTicket();
+  }
+  ASSERT_TRUE(ticket.has_value());
+
+  // 例如 kResumeAck 丢失后用同一票据重试：两次尝试的 SSRC 与序列号相同，
+  // 同一明文的密文必须不同，否则 AES-GCM nonce 被重用
+  auto connection = MakeConnection(kResumeClientPort, kResumeServerPort);
+  HandshakeManager first(kClientSsrc, connection.get());
+  first.EnableSrtp(true);
+  ASSERT_TRUE(first.ResumeSession(*ticket));
+  HandshakeManager retry(kClientSsrc, connection.get());
+  retry.EnableSrtp(true);
+  ASSERT_TRUE(retry.ResumeSession(*ticket));
+
+  const auto plain = MakeRtp(0, 200);
+  EXPECT_NE(Protect(*first.GetSrtpSession(), plain),
+            Protect(*retry.GetSrtpSession(), plain));
+}
+
+TEST(SrtpHandshakeTest, ForgedResumeIsIgnoredWithoutConsumingTicket) {
+  ResumptionTicketCache cache;
+  std::optional<ResumptionTicket> ticket;
+  {
+    auto server_connection = MakeConnection(kServerPort, kClientPort);
+    auto client_connection = MakeConnection(kClientPort, kServerPort);
+    auto server_done = std::async(std::launch::async, [&] {
+      HandshakeManager server(kServerSsrc, server_connection.get());
+      server.EnableSrtp(true);
+      server.SetTicketCache(&cache);
+      return server.WaitForHandshakeRequest(2000);
+    });
+    HandshakeManager client(kClientSsrc, client_connection.get());
+    client.EnableSrtp(true);
+    ASSERT_TRUE(client.InitiateHandshake(kSessionId));
+    ASSERT_TRUE(client.WaitForHandshakeResponse(2000));
+    ASSERT_TRUE(server_done.get());
+    ticket = client.GetResumptionTicket();
+  }
+  ASSERT_TRUE(ticket.has_value());
+
+  auto server_connection =
+      MakeConnection(kResumeServerPort, kResumeClientPort);
+  auto client_connection =
+      MakeConnection(kResumeClientPort, kResumeServerPort);
+  HandshakeManager server(kServerSsrc, server_connection.get());
+  server.EnableSrtp(true);
+  server.SetTicketCache(&cache);
+
+  // 窃听者从 HandshakeAck 得到票据 ID、会话 ID 与 SSRC，但没有恢复密钥
+  ResumptionTicket forged = *ticket;
+  forged.resumption_secret->fill(0x5A);
+  HandshakeManager attacker(kClientSsrc, client_connection.get());
+  attacker.EnableSrtp(true);
+  ASSERT_TRUE(attacker.ResumeSession(forged));
+  EXPECT_FALSE(server.WaitForHandshakeRequest(1000));
+  EXPECT_FALSE(server.IsResumed());
+  EXPECT_EQ(server.GetSrtpSession(), nullptr);
+  EXPECT_EQ(cache.Size(), 1U);
+
+  // 被忽略的请求没有回复，真正的控制端随后恢复成功
+  HandshakeManager client(kClientSsrc, client_connection.get());
+  client.EnableSrtp(true);
+  ASSERT_TRUE(client.ResumeSession(*ticket));
+  ASSERT_TRUE(server.WaitForHandshakeRequest(1000));
+  EXPECT_TRUE(server.IsResumed());
+  EXPECT_TRUE(client.WaitForResumeResponse(1000));
+  EXPECT_TRUE(client.IsResumed());
+}
+
+// ============================================================================
+// 基准测试（手动运行：--gtest_also_run_disabled_tests）
+// ============================================================================
+
+TEST(SrtpSessionTest, DISABLED_BenchmarkCyclesPerByteAt50Mbit) {
+  constexpr double kBitrate = 50e6;
+  constexpr int kFps = 60;
+  constexpr size_t kPayloadSize = 1200;
+  constexpr int kFrames = 3000;
+  const size_t frame_bytes = static_cast<size_t>(kBitrate / 8 / kFps);
+  const size_t packets_per_frame =
+      (frame_bytes + kPayloadSize - 1) / kPayloadSize;
+
+  for (auto implementation : kImplementations) {
+    SrtpPair pair(implementation);
+    std::vector<std::vector<uint8_t>> buffers(packets_per_frame);
+    std::vector<SrtpSession::Buffer> views(packets_per_frame);
+    uint16_t sequence = 0;
+    size_t bytes = 0;
+    uint64_t cycles = 0;
+    double seconds = 0.0;
+
+    for (int frame = 0; frame < kFrames; ++frame) {
+      for (size_t i = 0; i < packets_per_frame; ++i) {
+        buffers[i] = MakeRtp(sequence++, kPayloadSize);
+        const size_t length = buffers[i].size();
+        buffers[i].resize(length + kSrtpOverhead);
+        views[i] = {buffers[i].data(), length, buffers[i].size()};
+      }
+      const auto start = std::chrono::steady_clock::now();
+#ifdef ZENREMOTE_HAS_RDTSC
+      const uint64_t tsc_start = __rdtsc();
+#endif
+      pair.client->ProtectRtpBatch(views.data(), views.size());
+#ifdef ZENREMOTE_HAS_RDTSC
+      cycles += __rdtsc() - tsc_start;
+#endif
+      seconds += std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+      bytes += packets_per_frame * kPayloadSize;
+    }
+
+    const char* name =
+        pair.client->IsHardwareAccelerated() ? "AES-NI/PCLMUL" : "portable";
+    const double bytes_per_second = kBitrate / 8;
+    std::cout << "[ BENCH    ] " << name << ": " << packets_per_frame
+              << " packets/frame x " << kFrames << " frames, "
+              << bytes / seconds / 1e6 << " MB/s" << std::endl;
+#ifdef ZENREMOTE_HAS_RDTSC
+    std::cout << "[ BENCH    ] " << name << ": "
+              << static_cast<double>(cycles) / bytes << " cycles/byte (TSC)"
+              << std::endl;
+#endif
+    std::cout << "[ BENCH    ] " << name << ": "
+              << seconds / bytes * bytes_per_second * 100.0
+              << "% of one core at 50 Mbit/s" << std::endl;
+  }
+}
+
+}  // namespace zenremote
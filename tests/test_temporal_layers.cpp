@@ -0,0 +1,348 @@
+/**
+ * @file test_temporal_layers.cpp
+ * @brief 时间可伸缩（L1T2 / L1T3）与按观看者带宽丢层测试
+ *
+ * 测试目标：
+ * - L1T2 / L1T3 的层号周期与参考关系
+ * - 帧标记头扩展（RFC 8285 一字节格式）的写入与解析
+ * - REMB 的序列化与解析
+ * - MediaBroadcaster 按带宽估计为每个观看者丢弃高层，升层等到 TL0，
+ *   不重传被丢弃层的包
+ * - 经 PeerConnection 的 REMB 上报，接收端正确跳过扩展头
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loopback_impairment.h"
+#include "media/codec/encoder/temporal_layers.h"
+#include "network/rtp/frame_marking.h"
+#include "network/rtp/rtcp_feedback.h"
+#include "network/rtp/rtp_packet.h"
+#include "transport/peer_connection.h"
+#include "transport/track/broadcast_track.h"
+#include "transport/track/media_broadcaster.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kSenderPort = 47401;
+constexpr uint16_t kViewerPort = 47402;
+
+struct LayeredPacket {
+  uint16_t sequence_number = 0;
+  std::optional<rtp::FrameMarking> marking;
+  std::string payload;
+};
+
+/// @brief 读取广播报文并解析帧标记，直到收到 count 个或超时
+std::vector<LayeredPacket> ReadLayeredPackets(
+    BaseConnection* endpoint,
+    size_t count,
+    std::chrono::milliseconds timeout) {
+  std::vector<LayeredPacket> packets;
+  std::vector<uint8_t> buffer(65536);
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (packets.size() < count) {
+    const auto remaining =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      break;
+    }
+    auto result = endpoint->Recv(buffer.data(), buffer.size(),
+                                 static_cast<int>(remaining.count()));
+    const size_t header_size =
+        sizeof(network::RTPHeader) + rtp::kFrameMarkingExtensionSize;
+    if (result.IsErr() || result.Value() < header_size) {
+      continue;
+    }
+    network::RTPHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    LayeredPacket packet;
+    packet.sequence_number = header.sequence_number;
+    packet.marking = rtp::ParseFrameMarking(buffer.data(), result.Value());
+    packet.payload.assign(
+        reinterpret_cast<const char*>(buffer.data()) + header_size,
+        result.Value() - header_size);
+    packets.push_back(std::move(packet));
+  }
+  return packets;
+}
+
+Result<void> SendLayer(MediaBroadcaster& broadcaster,
+                       const std::string& frame,
+                       uint8_t temporal_id,
+                       bool is_keyframe = false) {
+  return broadcaster.SendFrame(reinterpret_cast<const uint8_t*>(frame.data()),
+                               frame.size(), 0, is_keyframe, temporal_id);
+}
+
+std::vector<std::string> Payloads(const std::vector<LayeredPacket>& packets) {
+  std::vector<std::string> payloads;
+  for (const auto& packet : packets) {
+    payloads.push_back(packet.payload.substr(0, 4));
+  }
+  return payloads;
+}
+
+}  // namespace
+
+// ============================================================================
+// 参考结构与报文格式
+// ============================================================================
+
+TEST(TemporalLayersTest, PatternsMatchReferenceStructures) {
+  const std::vector<uint8_t> l1t2 = {0, 1, 0, 1, 0, 1};
+  const std::vector<uint8_t> l1t3 = {0, 2, 1, 2, 0, 2, 1, 2};
+  for (size_t i = 0; i < l1t2.size(); ++i) {
+    EXPECT_EQ(TemporalLayerId(i, 1), 0) << i;
+    EXPECT_EQ(TemporalLayerId(i, 2), l1t2[i]) << i;
+  }
+  for (size_t i = 0; i < l1t3.size(); ++i) {
+    EXPECT_EQ(TemporalLayerId(i, 3), l1t3[i]) << i;
+  }
+  EXPECT_EQ(TemporalLayerCycle(1), 1);
+  EXPECT_EQ(TemporalLayerCycle(2), 2);
+  EXPECT_EQ(TemporalLayerCycle(3), 4);
+
+  // 最高层不被参考，可以单独丢弃
+  EXPECT_TRUE(IsTemporalLayerReference(0, 2));
+  EXPECT_FALSE(IsTemporalLayerReference(1, 2));
+  EXPECT_TRUE(IsTemporalLayerReference(1, 3));
+  EXPECT_FALSE(IsTemporalLayerReference(2, 3));
+}
+
+TEST(FrameMarkingTest, RoundTripThroughRtpPacket) {
+  network::RTPHeader header{};
+  header.version = 2;
+  header.extension = 1;
+  header.csrc_count = 1;
+  header.sequence_number = 7;
+
+  rtp::FrameMarking marking;
+  marking.independent = true;
+  marking.discardable = false;
+  marking.base_layer_sync = true;
+  marking.temporal_id = 1;
+  marking.tl0_pic_index = 200;
+
+  std::vector<uint8_t> packet(sizeof(header) + 4 +
+                              rtp::kFrameMarkingExtensionSize + 3);
+  std::memcpy(packet.data(), &header, sizeof(header));
+  rtp::WriteFrameMarkingExtension(marking, packet.data() + sizeof(header) + 4);
+
+  auto parsed = rtp::ParseFrameMarking(packet.data(), packet.size());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_TRUE(parsed->start_of_frame);
+  EXPECT_TRUE(parsed->end_of_frame);
+  EXPECT_TRUE(parsed->independent);
+  EXPECT_FALSE(parsed->discardable);
+  EXPECT_TRUE(parsed->base_layer_sync);
+  EXPECT_EQ(parsed->temporal_id, 1);
+  EXPECT_EQ(parsed->layer_id, 0);
+  EXPECT_EQ(parsed->tl0_pic_index, 200);
+
+  // 截断的扩展块与不带扩展的包
+  EXPECT_FALSE(rtp::ParseFrameMarking(packet.data(), sizeof(header) + 8));
+  header.extension = 0;
+  std::memcpy(packet.data(), &header, sizeof(header));
+  EXPECT_FALSE(rtp::ParseFrameMarking(packet.data(), packet.size()));
+}
+
+TEST(RtcpFeedbackTest, RembRoundTripPerSsrc) {
+  auto packet = rtp::SerializeRemb(9, 2500000, {42, 43});
+  ASSERT_TRUE(rtp::IsRtcpPacket(packet.data(), packet.size()));
+  auto feedback = rtp::ParseRtcpFeedback(packet.data(), packet.size());
+  ASSERT_EQ(feedback.size(), 2U);
+  for (size_t i = 0; i < feedback.size(); ++i) {
+    EXPECT_EQ(feedback[i].type, rtp::RtcpFeedback::Type::kRemb);
+    EXPECT_EQ(feedback[i].sender_ssrc, 9U);
+    EXPECT_EQ(feedback[i].bitrate_bps, 2500000U);
+    EXPECT_EQ(feedback[i].media_ssrc, 42U + i);
+  }
+
+  // 超出 18 位尾数的部分向下取整，误差小于 2^-17
+  const uint64_t large = 10000000007ULL;
+  packet = rtp::SerializeRemb(9, large, {42});
+  feedback = rtp::ParseRtcpFeedback(packet.data(), packet.size());
+  ASSERT_EQ(feedback.size(), 1U);
+  EXPECT_LE(feedback[0].bitrate_bps, large);
+  EXPECT_GT(feedback[0].bitrate_bps, large - (large >> 17U));
+}
+
+// ============================================================================
+// 按观看者丢层
+// ============================================================================
+
+TEST(TemporalLayerForwardingTest, DropsUpperLayersPerViewerBandwidth) {
+  MediaBroadcaster::Config config;
+  config.temporal_layers = 3;
+  config.layer_rate_window_ms = 50;
+  config.min_keyframe_interval_ms = 0;
+  auto broadcaster = std::make_shared<MediaBroadcaster>(config);
+
+  ImpairedLoopback full_link({});
+  ImpairedLoopback mid_link({});
+  ImpairedLoopback low_link({});
+  auto full = broadcaster->CreateTrack("video0");
+  auto mid = broadcaster->CreateTrack("video0");
+  auto low = broadcaster->CreateTrack("video0");
+  full->SetConnection(full_link.a());
+  mid->SetConnection(mid_link.a());
+  low->SetConnection(low_link.a());
+  mid->SetBandwidthEstimate(5000000);
+  low->SetBandwidthEstimate(100000);
+
+  // 各层大小差距悬殊，码率统计窗口的时间误差不影响选层：
+  // 约 60ms 窗口内 TL0 ~0.6 Mbps，TL0+1 ~2.7 Mbps，全部 ~20 Mbps
+  const std::string tl0(1000, '0');
+  const std::string tl1(4000, '1');
+  const std::string tl2(16000, '2');
+  ASSERT_TRUE(SendLayer(*broadcaster, "key0" + tl0, 0, true).IsOk());
+  for (int cycle = 0; cycle < 4; ++cycle) {
+    ASSERT_TRUE(SendLayer(*broadcaster, "m" + std::to_string(cycle) + "p0" +
+                                            tl0, 0).IsOk());
+    ASSERT_TRUE(SendLayer(*broadcaster, "m" + std::to_string(cycle) + "b2" +
+                                            tl2, 2).IsOk());
+    ASSERT_TRUE(SendLayer(*broadcaster, "m" + std::to_string(cycle) + "B1" +
+                                            tl1, 1).IsOk());
+    ASSERT_TRUE(SendLayer(*broadcaster, "m" + std::to_string(cycle) + "b2" +
+                                            tl2, 2).IsOk());
+  }
+  // 统计之前各层码率未知，所有观看者收到全部层
+  for (BaseConnection* endpoint : {full_link.b(), mid_link.b(), low_link.b()}) {
+    EXPECT_EQ(ReadLayeredPackets(endpoint, 17, 2s).size(), 17U);
+  }
+
+  std::this_thread::sleep_for(60ms);
+  const std::vector<std::pair<std::string, uint8_t>> frames = {
+      {"P0__", 0}, {"b2a_", 2}, {"B1a_", 1}, {"b2b_", 2},
+      {"P1__", 0}, {"b2c_", 2}, {"B1b_", 1}, {"b2d_", 2}};
+  for (const auto& frame : frames) {
+    ASSERT_TRUE(SendLayer(*broadcaster, frame.first, frame.second).IsOk());
+  }
+
+  auto full_packets = ReadLayeredPackets(full_link.b(), 8, 2s);
+  ASSERT_EQ(full_packets.size(), 8U);
+  EXPECT_EQ(Payloads(ReadLayeredPackets(mid_link.b(), 4, 2s)),
+            (std::vector<std::string>{"P0__", "B1a_", "P1__", "B1b_"}));
+  EXPECT_EQ(Payloads(ReadLayeredPackets(low_link.b(), 2, 2s)),
+            (std::vector<std::string>{"P0__", "P1__"}));
+
+  // 帧标记：TL2 可丢弃，TL1 为基础层同步点，TL0PICIDX 随 TL0 递增
+  ASSERT_TRUE(full_packets[0].marking && full_packets[1].marking &&
+              full_packets[2].marking && full_packets[4].marking);
+  EXPECT_EQ(full_packets[1].marking->temporal_id, 2);
+  EXPECT_TRUE(full_packets[1].marking->discardable);
+  EXPECT_TRUE(full_packets[2].marking->base_layer_sync);
+  EXPECT_FALSE(full_packets[2].marking->discardable);
+  EXPECT_EQ(full_packets[2].marking->tl0_pic_index,
+            full_packets[0].marking->tl0_pic_index);
+  EXPECT_EQ(static_cast<uint8_t>(full_packets[4].marking->tl0_pic_index),
+            static_cast<uint8_t>(full_packets[0].marking->tl0_pic_index + 1));
+
+  EXPECT_EQ(full->GetStats().temporal_layer, 2);
+  EXPECT_EQ(mid->GetStats().temporal_layer, 1);
+  EXPECT_EQ(mid->GetStats().packets_layer_dropped, 4U);
+  EXPECT_EQ(low->GetStats().temporal_layer, 0);
+  EXPECT_EQ(low->GetStats().packets_layer_dropped, 6U);
+  auto stats = broadcaster->GetStats();
+  EXPECT_GT(stats.layer_bitrate_bps[0], 0U);
+  EXPECT_GT(stats.layer_bitrate_bps[2], stats.layer_bitrate_bps[1]);
+
+  // 被丢弃层的 NACK 不重传
+  rtp::RtcpFeedback nack;
+  nack.type = rtp::RtcpFeedback::Type::kNack;
+  nack.media_ssrc = broadcaster->GetSSRC();
+  nack.lost_sequences = {full_packets[1].sequence_number,
+                         full_packets[2].sequence_number};
+  low->OnRtcpFeedback(nack);
+
+  // 带宽恢复后，升层等到下一个 TL0
+  low->SetBandwidthEstimate(1000000000);
+  ASSERT_TRUE(SendLayer(*broadcaster, "b2e_", 2).IsOk());
+  ASSERT_TRUE(SendLayer(*broadcaster, "P2__", 0).IsOk());
+  ASSERT_TRUE(SendLayer(*broadcaster, "b2f_", 2).IsOk());
+  EXPECT_EQ(Payloads(ReadLayeredPackets(low_link.b(), 2, 2s)),
+            (std::vector<std::string>{"P2__", "b2f_"}));
+  EXPECT_EQ(low->GetStats().packets_retransmitted, 0U);
+  EXPECT_EQ(low->GetStats().temporal_layer, 2);
+
+  EXPECT_TRUE(SendLayer(*broadcaster, "bad", 3).IsErr());
+  full->SetConnection(nullptr);
+  mid->SetConnection(nullptr);
+  low->SetConnection(nullptr);
+}
+
+TEST(TemporalLayerForwardingTest, RembThroughPeerConnection) {
+  MediaBroadcaster::Config broadcast_config;
+  broadcast_config.temporal_layers = 2;
+  auto broadcaster = std::make_shared<MediaBroadcaster>(broadcast_config);
+
+  auto make_config = [](uint16_t local_port, uint16_t remote_port) {
+    PeerConnection::Config config;
+    config.mode = PeerConnection::ConnectionMode::kDirect;
+    config.remote_ip = "127.0.0.1";
+    config.remote_port = remote_port;
+    config.local_port = local_port;
+    return config;
+  };
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::string> frames;
+  PeerConnection viewer;
+  ASSERT_TRUE(viewer.Initialize(make_config(kViewerPort, kSenderPort)).IsOk());
+  viewer.SetOnTrackCallback([&](std::shared_ptr<MediaTrack> track) {
+    track->SetOnFrameCallback(
+        [&](const uint8_t* data, size_t length, uint32_t) {
+          std::lock_guard<std::mutex> lock(mutex);
+          frames.emplace_back(reinterpret_cast<const char*>(data), length);
+          cv.notify_all();
+        });
+  });
+  ASSERT_TRUE(viewer.Connect().IsOk());
+
+  PeerConnection sender;
+  ASSERT_TRUE(sender.Initialize(make_config(kSenderPort, kViewerPort)).IsOk());
+  auto track = broadcaster->CreateTrack("video0");
+  ASSERT_TRUE(sender.AddTrack(track).IsOk());
+  ASSERT_TRUE(sender.Connect().IsOk());
+
+  ASSERT_TRUE(SendLayer(*broadcaster, "key", 0, true).IsOk());
+  ASSERT_TRUE(SendLayer(*broadcaster, "upper", 1).IsOk());
+  {
+    // 接收端按扩展头长度跳过帧标记，负载不变
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(cv.wait_for(lock, 3s, [&] { return frames.size() >= 2; }));
+    EXPECT_EQ(frames[0], "key");
+    EXPECT_EQ(frames[1], "upper");
+  }
+
+  ASSERT_TRUE(
+      viewer.SendBandwidthEstimate(broadcaster->GetSSRC(), 750000).IsOk());
+  const auto deadline = std::chrono::steady_clock::now() + 3s;
+  while (track->GetStats().bandwidth_estimate_bps != 750000 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(5ms);
+  }
+  EXPECT_EQ(track->GetStats().bandwidth_estimate_bps, 750000U);
+
+  sender.Disconnect();
+  viewer.Disconnect();
+}
+
+}  // namespace zenremote
@@ -0,0 +1,533 @@
+/**
+ * @file test_tiled_encoder.cpp
+ * @brief 分块编码的网格、容器格式与 TiledVideoEncoder 测试
+ *
+ * 测试目标：
+ * - 分块边界对齐到 16，最后一列/行取剩余部分，小画面自动减少行列数
+ * - 容器格式往返正确，截断或与网格不一致的包被拒绝
+ * - 分块帧是输入帧的裁剪引用，编码后释放；ROI 按分块裁剪平移
+ * - 只编码与变化区域相交的分块；关键帧请求与首帧编码全部分块
+ * - 流式输出：分块编码完即单独成包，最后一个包标记帧结束
+ * - 端到端：接收端按分块合成的画面逐帧与屏幕一致
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "media/codec/encoder/roi_map.h"
+#include "media/codec/encoder/tiled_encoder.h"
+#include "media/codec/tiled_frame.h"
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+
+bool SameRect(const DirtyRect& a, const DirtyRect& b) {
+  return a.left == b.left && a.top == b.top && a.right == b.right &&
+         a.bottom == b.bottom;
+}
+
+AVFramePtr MakeNv12(int width, int height) {
+  AVFramePtr frame = MakeAVFrame();
+  frame->format = AV_PIX_FMT_NV12;
+  frame->width = width;
+  frame->height = height;
+  if (av_frame_get_buffer(frame.get(), 32) < 0) {
+    return nullptr;
+  }
+  return frame;
+}
+
+/// 无损的替身编码器：输出分块的 NV12 原始像素，记录收到的帧
+class RawTileEncoder : public IVideoEncoder {
+ public:
+  Result<void> Initialize(const EncoderConfig& config) override {
+    config_ = config;
+    return Result<void>::Ok();
+  }
+  void Shutdown() override {}
+
+  Result<bool> Encode(AVFrame* frame, EncodedPacket& packet) override {
+    ++frames;
+    last_luma = frame->data[0];
+    last_chroma = frame->data[1];
+    last_width = frame->width;
+    last_height = frame->height;
+    last_roi.clear();
+    if (const AVFrameSideData* side_data = av_frame_get_side_data(
+            frame, AV_FRAME_DATA_REGIONS_OF_INTEREST)) {
+      const auto* rois =
+          reinterpret_cast<const AVRegionOfInterest*>(side_data->data);
+      for (size_t i = 0; i < side_data->size / sizeof(*rois); ++i) {
+        last_roi.push_back(
+            {rois[i].left, rois[i].top, rois[i].right, rois[i].bottom});
+      }
+    }
+    if (fail_next) {
+      fail_next = false;
+      return Result<bool>::Err(ErrorCode::kEncodeFailed, "injected");
+    }
+    packet.data.clear();
+    for (int plane = 0; plane < 2; ++plane) {
+      const int rows = plane == 0 ? frame->height : frame->height / 2;
+      for (int y = 0; y < rows; ++y) {
+        const uint8_t* row = frame->data[plane] + y * frame->linesize[plane];
+        packet.data.insert(packet.data.end(), row, row + frame->width);
+      }
+    }
+    packet.is_keyframe = force_keyframe_ || frames == 1;
+    keyframes += packet.is_keyframe ? 1 : 0;
+    force_keyframe_ = false;
+    return Result<bool>::Ok(true);
+  }
+
+  Result<void> Flush(std::vector<EncodedPacket>&) override {
+    return Result<void>::Ok();
+  }
+  void ForceKeyFrame() override { force_keyframe_ = true; }
+  Result<void> UpdateBitrate(int bitrate) override {
+    config_.bitrate = bitrate;
+    return Result<void>::Ok();
+  }
+  EncoderStats GetStats() const override { return {}; }
+  bool IsInitialized() const override { return true; }
+  EncoderType GetEncoderType() const override {
+    return EncoderType::kSoftware;
+  }
+  std::string GetEncoderName() const override { return "raw"; }
+
+  const EncoderConfig& config() const { return config_; }
+
+  int frames = 0;
+  int keyframes = 0;
+  bool fail_next = false;
+  const uint8_t* last_luma = nullptr;
+  const uint8_t* last_chroma = nullptr;
+  int last_width = 0;
+  int last_height = 0;
+  std::vector<DirtyRect> last_roi;
+
+ private:
+  EncoderConfig config_;
+  bool force_keyframe_ = false;
+};
+
+/// 创建 TiledVideoEncoder，tiles 收集各分块的替身编码器
+std::unique_ptr<TiledVideoEncoder> MakeTiledEncoder(
+    const EncoderConfig& config,
+    std::vector<RawTileEncoder*>& tiles) {
+  auto encoder = std::make_unique<TiledVideoEncoder>(
+      [&tiles](const EncoderConfig& tile_config)
+          -> Result<std::unique_ptr<IVideoEncoder>> {
+        auto tile = std::make_unique<RawTileEncoder>();
+        tile->Initialize(tile_config);
+        tiles.push_back(tile.get());
+        return Result<std::unique_ptr<IVideoEncoder>>::Ok(std::move(tile));
+      });
+  if (encoder->Initialize(config).IsErr()) {
+    return nullptr;
+  }
+  return encoder;
+}
+
+EncoderConfig TiledConfig(int width, int height, int columns, int rows) {
+  EncoderConfig config;
+  config.width = width;
+  config.height = height;
+  config.tile_columns = columns;
+  config.tile_rows = rows;
+  config.thread_count = 4;
+  config.bitrate = 4000000;
+  return config;
+}
+
+/// 接收端：把包中的原始像素分块贴到画面上
+void ApplyPacket(const EncodedPacket& packet, AVFrame* canvas) {
+  auto parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk()) << parsed.Message();
+  for (const auto& tile : parsed.Value().tiles) {
+    AVFramePtr decoded = MakeNv12(tile.rect.Width(), tile.rect.Height());
+    ASSERT_TRUE(decoded);
+    const uint8_t* cursor = tile.data;
+    for (int plane = 0; plane < 2; ++plane) {
+      const int rows = plane == 0 ? decoded->height : decoded->height / 2;
+      for (int y = 0; y < rows; ++y) {
+        std::memcpy(decoded->data[plane] + y * decoded->linesize[plane],
+                    cursor, static_cast<size_t>(decoded->width));
+        cursor += decoded->width;
+      }
+    }
+    ASSERT_EQ(cursor, tile.data + tile.size);
+    ASSERT_TRUE(CopyTileToFrame(decoded.get(), canvas, tile.rect.left,
+                                tile.rect.top)
+                    .IsOk());
+  }
+}
+
+bool SamePixels(const AVFrame* a, const AVFrame* b) {
+  for (int plane = 0; plane < 2; ++plane) {
+    const int rows = plane == 0 ? a->height : a->height / 2;
+    for (int y = 0; y < rows; ++y) {
+      if (std::memcmp(a->data[plane] + y * a->linesize[plane],
+                      b->data[plane] + y * b->linesize[plane],
+                      static_cast<size_t>(a->width)) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST(TiledFrameTest, LayoutAlignsTiles) {
+  const TileLayout uhd = ComputeTileLayout(3840, 2160, 4, 4);
+  ASSERT_EQ(uhd.TileCount(), 16u);
+  EXPECT_TRUE(SameRect(uhd.tiles[0], {0, 0, 960, 544}));
+  EXPECT_TRUE(SameRect(uhd.tiles[15], {2880, 1632, 3840, 2160}));
+  int64_t area = 0;
+  for (const auto& tile : uhd.tiles) {
+    EXPECT_EQ(tile.left % kTileAlignment, 0);
+    EXPECT_EQ(tile.top % kTileAlignment, 0);
+    area += static_cast<int64_t>(tile.Width()) * tile.Height();
+  }
+  EXPECT_EQ(area, 3840 * 2160);
+
+  // 16 列放不下：每列至少 16 像素
+  const TileLayout small = ComputeTileLayout(100, 40, 16, 16);
+  EXPECT_EQ(small.columns, 7);
+  EXPECT_EQ(small.rows, 3);
+  EXPECT_TRUE(SameRect(small.tiles.back(), {96, 32, 100, 40}));
+
+  std::vector<bool> dirty;
+  MarkDirtyTiles(uhd, {{950, 10, 970, 20}}, dirty);
+  ASSERT_EQ(dirty.size(), 16u);
+  EXPECT_TRUE(dirty[0]);
+  EXPECT_TRUE(dirty[1]);
+  EXPECT_FALSE(dirty[2]);
+  EXPECT_FALSE(dirty[4]);
+}
+
+TEST(TiledFrameTest, ContainerRoundTrip) {
+  const TileLayout layout = ComputeTileLayout(1920, 1080, 2, 2);
+  const std::vector<uint8_t> first = {0, 0, 0, 1, 0x65, 0x88};
+  const std::vector<uint8_t> last = {0, 0, 1, 0x41};
+  std::vector<uint8_t> packet;
+  BeginTiledFrame(layout, true, packet);
+  ASSERT_TRUE(IsTiledFrame(packet.data(), packet.size()));
+  ASSERT_TRUE(
+      AppendTile(layout, 0, true, first.data(), first.size(), packet).IsOk());
+  ASSERT_TRUE(
+      AppendTile(layout, 3, false, last.data(), last.size(), packet).IsOk());
+  EXPECT_TRUE(AppendTile(layout, 4, false, last.data(), last.size(), packet)
+                  .IsErr());
+
+  auto parsed = ParseTiledFrame(packet.data(), packet.size());
+  ASSERT_TRUE(parsed.IsOk()) << parsed.Message();
+  const TiledFrame& frame = parsed.Value();
+  EXPECT_TRUE(frame.end_of_frame);
+  EXPECT_EQ(frame.layout.width, 1920);
+  EXPECT_EQ(frame.layout.height, 1080);
+  ASSERT_EQ(frame.tiles.size(), 2u);
+  EXPECT_EQ(frame.tiles[0].index, 0u);
+  EXPECT_TRUE(frame.tiles[0].keyframe);
+  EXPECT_EQ(std::vector<uint8_t>(frame.tiles[0].data,
+                                 frame.tiles[0].data + frame.tiles[0].size),
+            first);
+  EXPECT_EQ(frame.tiles[1].index, 3u);
+  EXPECT_FALSE(frame.tiles[1].keyframe);
+  EXPECT_TRUE(SameRect(frame.tiles[1].rect, layout.tiles[3]));
+  EXPECT_EQ(std::vector<uint8_t>(frame.tiles[1].data,
+                                 frame.tiles[1].data + frame.tiles[1].size),
+            last);
+
+  // Annex B 码流不是容器；截断的包与坐标不符的分块被拒绝
+  EXPECT_FALSE(IsTiledFrame(first.data(), first.size()));
+  EXPECT_TRUE(ParseTiledFrame(packet.data(), packet.size() - 1).IsErr());
+  std::vector<uint8_t> moved = packet;
+  moved[11 + 2 + 1] += 16;  // 第一个分块的 left
+  EXPECT_TRUE(ParseTiledFrame(moved.data(), moved.size()).IsErr());
+
+  std::vector<uint8_t> partial;
+  BeginTiledFrame(layout, false, partial);
+  auto parsed_partial = ParseTiledFrame(partial.data(), partial.size());
+  ASSERT_TRUE(parsed_partial.IsOk());
+  EXPECT_FALSE(parsed_partial.Value().end_of_frame);
+  EXPECT_TRUE(parsed_partial.Value().tiles.empty());
+}
+
+TEST(TiledEncoderTest, EncodesOnlyChangedTiles) {
+  std::vector<RawTileEncoder*> tiles;
+  auto encoder = MakeTiledEncoder(TiledConfig(96, 64, 2, 2), tiles);
+  ASSERT_TRUE(encoder);
+  ASSERT_EQ(tiles.size(), 4u);
+  for (auto* tile : tiles) {
+    EXPECT_EQ(tile->config().thread_count, 1);
+    EXPECT_EQ(tile->config().tile_columns, 1);
+    EXPECT_EQ(tile->config().bitrate, 1000000);
+  }
+
+  AVFramePtr frame = MakeNv12(96, 64);
+  ASSERT_TRUE(frame);
+  EncodedPacket packet;
+
+  // 首帧：全部分块，都是关键帧；分块帧引用输入帧的像素
+  auto encoded = encoder->Encode(frame.get(), packet);
+  ASSERT_TRUE(encoded.IsOk()) << encoded.Message();
+  ASSERT_TRUE(encoded.Value());
+  EXPECT_TRUE(packet.is_keyframe);
+  EXPECT_EQ(packet.pts, 0);
+  const auto& layout = encoder->GetLayout();
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    const DirtyRect& rect = layout.tiles[i];
+    EXPECT_EQ(tiles[i]->frames, 1);
+    EXPECT_EQ(tiles[i]->last_width, rect.Width());
+    EXPECT_EQ(tiles[i]->last_height, rect.Height());
+    EXPECT_EQ(tiles[i]->last_luma,
+              frame->data[0] + rect.top * frame->linesize[0] + rect.left);
+    EXPECT_EQ(tiles[i]->last_chroma,
+              frame->data[1] + rect.top / 2 * frame->linesize[1] + rect.left);
+  }
+  // 编码后不再持有输入帧的引用
+  EXPECT_TRUE(av_frame_is_writable(frame.get()));
+
+  // 只有右下角的分块变化
+  encoder->SetChangedRegions({{60, 40, 64, 44}});
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  EXPECT_FALSE(packet.is_keyframe);
+  EXPECT_EQ(packet.pts, 1);
+  auto parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk());
+  ASSERT_EQ(parsed.Value().tiles.size(), 1u);
+  EXPECT_EQ(parsed.Value().tiles[0].index, 3u);
+  EXPECT_EQ(tiles[0]->frames, 1);
+  EXPECT_EQ(tiles[3]->frames, 2);
+
+  // 没有变化：只有头部
+  encoder->SetChangedRegions({});
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk());
+  EXPECT_TRUE(parsed.Value().tiles.empty());
+
+  // 关键帧请求：全部分块都是关键帧
+  encoder->ForceKeyFrame();
+  encoder->SetChangedRegions({{0, 0, 2, 2}});
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  EXPECT_TRUE(packet.is_keyframe);
+  for (auto* tile : tiles) {
+    EXPECT_EQ(tile->keyframes, 2);
+  }
+
+  // 没有调用 SetChangedRegions()：按整帧变化
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  EXPECT_FALSE(packet.is_keyframe);
+  EXPECT_EQ(tiles[1]->frames, 3);
+
+  // 码率按面积分配
+  ASSERT_TRUE(encoder->UpdateBitrate(2000000).IsOk());
+  EXPECT_EQ(tiles[2]->config().bitrate, 500000);
+}
+
+TEST(TiledEncoderTest, CropsRegionsOfInterest) {
+  std::vector<RawTileEncoder*> tiles;
+  auto encoder = MakeTiledEncoder(TiledConfig(96, 64, 2, 2), tiles);
+  ASSERT_TRUE(encoder);
+  AVFramePtr frame = MakeNv12(96, 64);
+  ASSERT_TRUE(frame);
+  ASSERT_TRUE(AttachRegionsOfInterest(frame.get(), {{16, 16, 64, 48}}, -6)
+                  .IsOk());
+
+  EncodedPacket packet;
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  // 网格为 48x32 的 2x2
+  ASSERT_EQ(tiles[0]->last_roi.size(), 1u);
+  EXPECT_TRUE(SameRect(tiles[0]->last_roi[0], {16, 16, 48, 32}));
+  ASSERT_EQ(tiles[1]->last_roi.size(), 1u);
+  EXPECT_TRUE(SameRect(tiles[1]->last_roi[0], {0, 16, 16, 32}));
+  ASSERT_EQ(tiles[3]->last_roi.size(), 1u);
+  EXPECT_TRUE(SameRect(tiles[3]->last_roi[0], {0, 0, 16, 16}));
+
+  ASSERT_TRUE(AttachRegionsOfInterest(frame.get(), {{0, 0, 16, 16}}, -6)
+                  .IsOk());
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  EXPECT_EQ(tiles[0]->last_roi.size(), 1u);
+  EXPECT_TRUE(tiles[3]->last_roi.empty());
+}
+
+TEST(TiledEncoderTest, TileErrorForcesKeyFrame) {
+  std::vector<RawTileEncoder*> tiles;
+  auto encoder = MakeTiledEncoder(TiledConfig(96, 64, 2, 2), tiles);
+  ASSERT_TRUE(encoder);
+  AVFramePtr frame = MakeNv12(96, 64);
+  ASSERT_TRUE(frame);
+  EncodedPacket packet;
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+
+  tiles[1]->fail_next = true;
+  encoder->SetChangedRegions({{0, 0, 96, 2}});
+  EXPECT_TRUE(encoder->Encode(frame.get(), packet).IsErr());
+  EXPECT_TRUE(av_frame_is_writable(frame.get()));
+
+  // 接收端缺少出错那一帧的分块：全部分块重新编码为关键帧
+  encoder->SetChangedRegions({});
+  ASSERT_TRUE(encoder->Encode(frame.get(), packet).IsOk());
+  EXPECT_TRUE(packet.is_keyframe);
+  auto parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk());
+  EXPECT_EQ(parsed.Value().tiles.size(), 4u);
+}
+
+TEST(TiledEncoderTest, RejectsDelayedTiles) {
+  std::vector<RawTileEncoder*> tiles;
+  EncoderConfig config = TiledConfig(96, 64, 2, 2);
+  config.max_b_frames = 2;
+  EXPECT_FALSE(MakeTiledEncoder(config, tiles));
+  config = TiledConfig(96, 64, 2, 2);
+  config.temporal_layers = 2;
+  EXPECT_FALSE(MakeTiledEncoder(config, tiles));
+  EXPECT_TRUE(tiles.empty());
+}
+
+TEST(TiledEncoderTest, StreamsTilesAsTheyFinish) {
+  std::vector<RawTileEncoder*> tiles;
+  auto encoder = MakeTiledEncoder(TiledConfig(100, 64, 3, 2), tiles);
+  ASSERT_TRUE(encoder);
+  std::vector<EncodedPacket> parts;
+  ASSERT_TRUE(encoder->SetPartialOutputCallback(
+      [&parts](EncodedPacket& part) { parts.push_back(part); }));
+
+  AVFramePtr screen = MakeNv12(100, 64);
+  AVFramePtr canvas = MakeNv12(100, 64);
+  ASSERT_TRUE(screen && canvas);
+  for (int y = 0; y < 64; ++y) {
+    for (int x = 0; x < 100; ++x) {
+      screen->data[0][y * screen->linesize[0] + x] =
+          static_cast<uint8_t>(x * 3 + y);
+      screen->data[1][y / 2 * screen->linesize[1] + x] =
+          static_cast<uint8_t>(x ^ y);
+    }
+  }
+
+  // 首帧：先完成的 5 个分块各自成包，最后一个分块随 Encode() 输出
+  EncodedPacket packet;
+  ASSERT_TRUE(encoder->Encode(screen.get(), packet).IsOk());
+  ASSERT_EQ(parts.size(), 5u);
+  std::vector<bool> seen(6, false);
+  size_t bytes = packet.data.size();
+  for (const auto& part : parts) {
+    EXPECT_FALSE(part.end_of_frame);
+    EXPECT_FALSE(part.is_keyframe);
+    EXPECT_EQ(part.pts, 0);
+    auto parsed = ParseTiledFrame(part.data.data(), part.data.size());
+    ASSERT_TRUE(parsed.IsOk());
+    EXPECT_FALSE(parsed.Value().end_of_frame);
+    ASSERT_EQ(parsed.Value().tiles.size(), 1u);
+    seen[parsed.Value().tiles[0].index] = true;
+    bytes += part.data.size();
+    ASSERT_NO_FATAL_FAILURE(ApplyPacket(part, canvas.get()));
+  }
+  EXPECT_TRUE(packet.end_of_frame);
+  EXPECT_TRUE(packet.is_keyframe);
+  auto parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk());
+  EXPECT_TRUE(parsed.Value().end_of_frame);
+  ASSERT_EQ(parsed.Value().tiles.size(), 1u);
+  seen[parsed.Value().tiles[0].index] = true;
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), true), 6);
+  ASSERT_NO_FATAL_FAILURE(ApplyPacket(packet, canvas.get()));
+  EXPECT_TRUE(SamePixels(screen.get(), canvas.get()));
+  EXPECT_EQ(encoder->GetStats().total_bytes, bytes);
+
+  // 只有一个分块变化：没有额外的包
+  parts.clear();
+  encoder->SetChangedRegions({{0, 0, 2, 2}});
+  ASSERT_TRUE(encoder->Encode(screen.get(), packet).IsOk());
+  EXPECT_TRUE(parts.empty());
+  parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk());
+  EXPECT_EQ(parsed.Value().tiles.size(), 1u);
+
+  // 没有变化：只有标记帧结束的头部
+  encoder->SetChangedRegions({});
+  ASSERT_TRUE(encoder->Encode(screen.get(), packet).IsOk());
+  EXPECT_TRUE(parts.empty());
+  EXPECT_TRUE(packet.end_of_frame);
+  parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+  ASSERT_TRUE(parsed.IsOk());
+  EXPECT_TRUE(parsed.Value().end_of_frame);
+  EXPECT_TRUE(parsed.Value().tiles.empty());
+}
+
+TEST(TiledEncoderTest, EndToEndMatchesScreen) {
+  constexpr int kWidth = 100;
+  constexpr int kHeight = 64;
+  std::vector<RawTileEncoder*> tiles;
+  auto encoder = MakeTiledEncoder(TiledConfig(kWidth, kHeight, 3, 2), tiles);
+  ASSERT_TRUE(encoder);
+  // 最后一列只有 4 像素宽
+  EXPECT_EQ(encoder->GetLayout().tiles[2].Width(), 4);
+
+  AVFramePtr screen = MakeNv12(kWidth, kHeight);
+  AVFramePtr canvas = MakeNv12(kWidth, kHeight);
+  ASSERT_TRUE(screen && canvas);
+  std::mt19937 rng(7);
+  for (int plane = 0; plane < 2; ++plane) {
+    for (int y = 0; y < (plane == 0 ? kHeight : kHeight / 2); ++y) {
+      for (int x = 0; x < kWidth; ++x) {
+        screen->data[plane][y * screen->linesize[plane] + x] =
+            static_cast<uint8_t>(rng());
+      }
+    }
+  }
+
+  EncodedPacket packet;
+  int tiles_encoded = 0;
+  for (int frame = 0; frame < 200; ++frame) {
+    if (frame > 0) {
+      // 偶数坐标的随机变化区域（色度逐像素对应）
+      std::vector<DirtyRect> dirty;
+      const int count = static_cast<int>(rng() % 3);
+      for (int i = 0; i < count; ++i) {
+        const int left = static_cast<int>(rng() % (kWidth / 2)) * 2;
+        const int top = static_cast<int>(rng() % (kHeight / 2)) * 2;
+        const int right =
+            std::min(left + 2 + static_cast<int>(rng() % 8) * 2, kWidth);
+        const int bottom =
+            std::min(top + 2 + static_cast<int>(rng() % 8) * 2, kHeight);
+        const uint8_t value = static_cast<uint8_t>(rng());
+        for (int y = top; y < bottom; ++y) {
+          std::memset(screen->data[0] + y * screen->linesize[0] + left, value,
+                      static_cast<size_t>(right - left));
+        }
+        for (int y = top / 2; y < bottom / 2; ++y) {
+          std::memset(screen->data[1] + y * screen->linesize[1] + left,
+                      value ^ 0x55, static_cast<size_t>(right - left));
+        }
+        dirty.push_back({left, top, right, bottom});
+      }
+      encoder->SetChangedRegions(dirty);
+    }
+    if (frame % 67 == 66) {
+      encoder->ForceKeyFrame();
+    }
+    auto encoded = encoder->Encode(screen.get(), packet);
+    ASSERT_TRUE(encoded.IsOk()) << encoded.Message();
+    ASSERT_NO_FATAL_FAILURE(ApplyPacket(packet, canvas.get()));
+    ASSERT_TRUE(SamePixels(screen.get(), canvas.get())) << "frame " << frame;
+    auto parsed = ParseTiledFrame(packet.data.data(), packet.data.size());
+    tiles_encoded += static_cast<int>(parsed.Value().tiles.size());
+  }
+  // 大多数帧只有一两个分块变化
+  EXPECT_LT(tiles_encoded, 200 * 6 / 2);
+}
+
+}  // namespace zenremote
@@ -0,0 +1,464 @@
+/**
+ * @file test_turn_connection.cpp
+ * @brief TURN 客户端测试（本机最小 TURN 服务器，见 turn_test_server.h）
+ *
+ * 测试目标：
+ * - MD5 / SHA-1 / HMAC-SHA1 标准测试向量，MESSAGE-INTEGRITY 签名与校验
+ * - 401 质询后以长期凭据完成 Allocate、CreatePermission、ChannelBind
+ * - 媒体经 ChannelData 收发，线上开销 4 字节；关闭后退回 Send indication
+ *   （36 字节）
+ * - 后台刷新：lifetime 过半时 Refresh，nonce 过期（438）后换新 nonce 重发
+ * - 错误口令返回 kPermissionDenied
+ * - DISABLED_ 基准：直连与两种中继封装的吞吐和往返时延
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/digest.h"
+#include "network/connection/turn_connection.h"
+#include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
+#include "turn_test_server.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+constexpr uint16_t kServerPort = 47361;
+constexpr uint16_t kPeerPort = 47362;
+constexpr char kLoopback[] = "127.0.0.1";
+
+template <size_t N>
+std::string ToHex(const std::array<uint8_t, N>& digest) {
+  std::string text;
+  char byte[3];
+  for (uint8_t value : digest) {
+    std::snprintf(byte, sizeof(byte), "%02x", value);
+    text += byte;
+  }
+  return text;
+}
+
+std::vector<uint8_t> Bytes(const std::string& text) {
+  return std::vector<uint8_t>(text.begin(), text.end());
+}
+
+TurnTestServer::Config MakeServerConfig(uint32_t max_lifetime_s = 600) {
+  TurnTestServer::Config config;
+  config.address = kLoopback;
+  config.port = kServerPort;
+  config.max_lifetime_s = max_lifetime_s;
+  return config;
+}
+
+TurnConnection::Config MakeClientConfig(const TurnTestServer::Config& server) {
+  TurnConnection::Config config;
+  config.local_ip = kLoopback;
+  config.turn_server_ip = server.address;
+  config.turn_server_port = server.port;
+  config.username = server.username;
+  config.password = server.password;
+  config.peer = {kLoopback, kPeerPort};
+  return config;
+}
+
+std::unique_ptr<UdpSocket> OpenPeerSocket() {
+  UdpSocket::Config config;
+  config.local_ip = kLoopback;
+  config.local_port = kPeerPort;
+  auto socket = std::make_unique<UdpSocket>(config);
+  EXPECT_TRUE(socket->Open());
+  return socket;
+}
+
+/// @brief 对端 -> 中继 -> 客户端，以及客户端 -> 中继 -> 对端各一个报文
+void ExpectRelaysBothWays(TurnConnection& client, UdpSocket& peer) {
+  const auto relayed = client.GetRelayedAddress();
+  const auto inbound = Bytes("peer to client");
+  ASSERT_TRUE(peer.SendTo(inbound.data(), inbound.size(), relayed.address,
+                          relayed.port));
+  std::vector<uint8_t> buffer(2048);
+  auto received = client.Recv(buffer.data(), buffer.size(), 1000);
+  ASSERT_TRUE(received.IsOk()) << received.Message();
+  EXPECT_EQ(std::vector<uint8_t>(buffer.begin(),
+                                 buffer.begin() + received.Value()),
+            inbound);
+
+  const auto outbound = Bytes("client to peer");
+  ASSERT_TRUE(client.Send(outbound.data(), outbound.size()).IsOk());
+  Endpoint from;
+  size_t length = buffer.size();
+  ASSERT_TRUE(peer.RecvFrom(buffer.data(), length, from.address, from.port,
+                            1000));
+  EXPECT_EQ(std::vector<uint8_t>(buffer.begin(), buffer.begin() + length),
+            outbound);
+  // 对端看到的来源是中继地址，而不是客户端本机地址
+  EXPECT_EQ(from, relayed);
+}
+
+}  // namespace
+
+TEST(DigestTest, MatchesStandardTestVectors) {
+  EXPECT_EQ(ToHex(Md5("")), "d41d8cd98f00b204e9800998ecf8427e");
+  EXPECT_EQ(ToHex(Md5("abc")), "900150983cd24fb0d6963f7d28e17f72");
+  EXPECT_EQ(ToHex(Md5("12345678901234567890123456789012345678901234567890123"
+                      "456789012345678901234567890")),
+            "57edf4a22be3c955ac49da2e2107b67a");
+
+  const std::string abc = "abc";
+  EXPECT_EQ(ToHex(Sha1(reinterpret_cast<const uint8_t*>(abc.data()),
+                       abc.size())),
+            "a9993e364706816aba3e25717850c26c9cd0d89d");
+  const std::string two_blocks =
+      "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  EXPECT_EQ(ToHex(Sha1(reinterpret_cast<const uint8_t*>(two_blocks.data()),
+                       two_blocks.size())),
+            "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+
+  // RFC 2202 测试用例 2 与 6（密钥长于分组，先做哈希）
+  const auto key = Bytes("Jefe");
+  const auto data = Bytes("what do ya want for nothing?");
+  EXPECT_EQ(ToHex(HmacSha1(key.data(), key.size(), data.data(), data.size())),
+            "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+  const std::vector<uint8_t> long_key(80, 0xAA);
+  const auto long_data =
+      Bytes("Test Using Larger Than Block-Size Key - Hash Key First");
+  EXPECT_EQ(ToHex(HmacSha1(long_key.data(), long_key.size(), long_data.data(),
+                           long_data.size())),
+            "aa4ae5e15272d00e95705637ce8a3b55ed402112");
+}
+
+TEST(StunMessageTest, MessageIntegrityRejectsTamperingAndWrongKey) {
+  StunMessage request;
+  request.method = static_cast<uint16_t>(StunMethod::kAllocate);
+  request.transaction_id.fill(0x5A);
+  request.AddUint32(StunAttributeType::kLifetime, 600);
+  request.AddString(StunAttributeType::kUsername, "user");
+  const auto key = ComputeStunLongTermKey("user", "realm", "secret");
+  ASSERT_EQ(key.size(), 16U);
+
+  const auto bytes = SerializeStunMessage(request, key);
+  // MESSAGE-INTEGRITY 是最后一个属性，头部长度计入它
+  EXPECT_EQ(bytes.size(), SerializeStunMessage(request).size() + 24);
+  EXPECT_TRUE(VerifyStunMessageIntegrity(bytes.data(), bytes.size(), key));
+
+  auto parsed = ParseStunMessage(bytes.data(), bytes.size());
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_TRUE(parsed->Is(StunMethod::kAllocate));
+  EXPECT_EQ(parsed->GetString(StunAttributeType::kUsername), "user");
+  EXPECT_TRUE(parsed->Has(StunAttributeType::kMessageIntegrity));
+
+  auto tampered = bytes;
+  tampered[kStunHeaderSize + 7] ^= 0x01;  // LIFETIME 值
+  EXPECT_FALSE(
+      VerifyStunMessageIntegrity(tampered.data(), tampered.size(), key));
+  const auto wrong_key = ComputeStunLongTermKey("user", "realm", "guess");
+  EXPECT_FALSE(
+      VerifyStunMessageIntegrity(bytes.data(), bytes.size(), wrong_key));
+  const auto unsigned_bytes = SerializeStunMessage(request);
+  EXPECT_FALSE(VerifyStunMessageIntegrity(unsigned_bytes.data(),
+                                          unsigned_bytes.size(), key));
+
+  StunMessage error;
+  error.message_class = StunClass::kErrorResponse;
+  error.AddErrorCode(kStunErrorStaleNonce, "Stale Nonce");
+  const auto error_bytes = SerializeStunMessage(error);
+  auto parsed_error = ParseStunMessage(error_bytes.data(), error_bytes.size());
+  ASSERT_TRUE(parsed_error.has_value());
+  EXPECT_EQ(parsed_error->GetErrorCode(), kStunErrorStaleNonce);
+}
+
+TEST(StunMessageTest, ChannelDataHeaderIsDistinctFromStunAndRtp) {
+  std::vector<uint8_t> packet(kChannelDataHeaderSize + 5, 0xEE);
+  WriteChannelDataHeader(0x4001, 5, packet.data());
+  size_t payload_length = 0;
+  EXPECT_EQ(ParseChannelDataHeader(packet.data(), packet.size(),
+                                   payload_length),
+            0x4001);
+  EXPECT_EQ(payload_length, 5U);
+  EXPECT_FALSE(IsStunMessage(packet.data(), packet.size()));
+
+  // 声明长度超过实际数据
+  EXPECT_FALSE(ParseChannelDataHeader(packet.data(), packet.size() - 1,
+                                      payload_length)
+                   .has_value());
+
+  const uint8_t rtp[12] = {0x80, 96};
+  EXPECT_FALSE(IsChannelData(rtp, sizeof(rtp)));
+  const auto stun = SerializeStunMessage(StunMessage{});
+  EXPECT_FALSE(IsChannelData(stun.data(), stun.size()));
+}
+
+TEST(TurnConnectionTest, AllocatesAndRelaysViaChannelData) {
+  const auto server_config = MakeServerConfig();
+  TurnTestServer server(server_config);
+  ASSERT_TRUE(server.Start());
+  auto peer = OpenPeerSocket();
+
+  TurnConnection client;
+  ASSERT_TRUE(client.Initialize(MakeClientConfig(server_config)).IsOk());
+  auto opened = client.Open();
+  ASSERT_TRUE(opened.IsOk()) << opened.Message();
+  EXPECT_TRUE(client.IsOpen());
+  EXPECT_EQ(client.GetType(), ConnectionType::kRelay);
+
+  // 首个 Allocate 被 401 质询，之后的请求都带凭据
+  const auto& stats = server.GetStats();
+  EXPECT_EQ(stats.unauthorized, 1U);
+  EXPECT_EQ(stats.allocations, 1U);
+  EXPECT_EQ(stats.permissions, 1U);
+  EXPECT_EQ(stats.channel_binds, 1U);
+
+  const auto relayed = client.GetRelayedAddress();
+  EXPECT_EQ(relayed.address, kLoopback);
+  EXPECT_NE(relayed.port, 0);
+  EXPECT_NE(relayed.port, kServerPort);
+  EXPECT_EQ(client.GetMappedAddress().address, kLoopback);
+
+  ExpectRelaysBothWays(client, *peer);
+  // 4 字节 ChannelData 头
+  EXPECT_EQ(stats.channel_data_relayed, 1U);
+  EXPECT_EQ(stats.last_client_data_size,
+            kChannelDataHeaderSize + std::string("client to peer").size());
+  EXPECT_EQ(client.GetStats().channel_data_sent, 1U);
+  EXPECT_EQ(client.GetStats().packets_received, 1U);
+
+  // 分配与通道都有刷新定时器
+  const int delay = client.ProcessTimers();
+  EXPECT_GT(delay, 0);
+  EXPECT_LE(delay, 300 * 1000);
+}
+
+TEST(TurnConnectionTest, FallsBackToSendIndications) {
+  const auto server_config = MakeServerConfig();
+  TurnTestServer server(server_config);
+  ASSERT_TRUE(server.Start());
+  auto peer = OpenPeerSocket();
+
+  auto client_config = MakeClientConfig(server_config);
+  client_config.use_channel_data = false;
+  TurnConnection client;
+  ASSERT_TRUE(client.Initialize(client_config).IsOk());
+  ASSERT_TRUE(client.Open().IsOk());
+  EXPECT_EQ(server.GetStats().channel_binds, 0U);
+
+  // 没有通道：对端数据以 Data indication 到达，发送走 Send indication
+  ExpectRelaysBothWays(client, *peer);
+  EXPECT_EQ(server.GetStats().indications_relayed, 1U);
+  // STUN 头 20 + XOR-PEER-ADDRESS 12 + DATA 属性头 4，数据补齐到 4 字节
+  const size_t payload = std::string("client to peer").size();
+  EXPECT_EQ(server.GetStats().last_client_data_size,
+            36 + ((payload + 3) & ~size_t{3}));
+  EXPECT_EQ(client.GetStats().indications_sent, 1U);
+}
+
+TEST(TurnConnectionTest, RefreshesAllocationAndRecoversFromStaleNonce) {
+  // 服务器只授予 1 秒 lifetime，客户端应在约 500 ms 时刷新
+  const auto server_config = MakeServerConfig(1);
+  TurnTestServer server(server_config);
+  ASSERT_TRUE(server.Start());
+  auto peer = OpenPeerSocket();
+
+  TurnConnection client;
+  ASSERT_TRUE(client.Initialize(MakeClientConfig(server_config)).IsOk());
+  ASSERT_TRUE(client.Open().IsOk());
+  server.RotateNonce();
+
+  // 模拟接收线程：按 ProcessTimers() 的返回值等待
+  std::vector<uint8_t> buffer(2048);
+  const auto deadline = std::chrono::steady_clock::now() + 3s;
+  while (client.GetStats().refreshes < 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    const int delay = client.ProcessTimers();
+    ASSERT_GE(delay, 0);
+    client.Recv(buffer.data(), buffer.size(), std::min(delay, 50));
+  }
+
+  EXPECT_GE(client.GetStats().refreshes, 2U);
+  EXPECT_GE(server.GetStats().refreshes, 2U);
+  // 第一次刷新带旧 nonce 被拒，换新 nonce 后成功
+  EXPECT_EQ(server.GetStats().stale_nonce, 1U);
+  EXPECT_EQ(server.GetStats().unauthorized, 1U);
+
+  ExpectRelaysBothWays(client, *peer);
+}
+
+TEST(TurnConnectionTest, RejectsWrongPassword) {
+  const auto server_config = MakeServerConfig();
+  TurnTestServer server(server_config);
+  ASSERT_TRUE(server.Start());
+
+  auto client_config = MakeClientConfig(server_config);
+  client_config.password = "wrong";
+  TurnConnection client;
+  ASSERT_TRUE(client.Initialize(client_config).IsOk());
+  auto opened = client.Open();
+  ASSERT_TRUE(opened.IsErr());
+  EXPECT_EQ(opened.Code(), ErrorCode::kPermissionDenied);
+  EXPECT_FALSE(client.IsOpen());
+  EXPECT_EQ(server.GetStats().unauthorized, 2U);
+  EXPECT_EQ(server.GetStats().allocations, 0U);
+}
+
+TEST(TurnConnectionTest, TimesOutWithoutServer) {
+  TurnConnection::Config config;
+  config.local_ip = kLoopback;
+  config.turn_server_ip = kLoopback;
+  config.turn_server_port = kServerPort;
+  config.request_rto_ms = 10;
+  config.max_request_attempts = 3;
+  TurnConnection client;
+  ASSERT_TRUE(client.Initialize(config).IsOk());
+  auto opened = client.Open();
+  ASSERT_TRUE(opened.IsErr());
+  EXPECT_EQ(opened.Code(), ErrorCode::kConnectionTimeout);
+  EXPECT_EQ(client.GetStats().requests_sent, 3U);
+  EXPECT_EQ(client.GetStats().retransmissions, 2U);
+}
+
+/**
+ * 基准：1200 字节媒体包，直连 / ChannelData / Send indication 三种路径的
+ * 单向吞吐（对端独立线程接收）和往返时延（对端回显）。
+ */
+TEST(TurnConnectionTest, DISABLED_BenchmarkRelayOverheadAndThroughput) {
+  constexpr size_t kPayloadSize = 1200;
+  constexpr int kThroughputPackets = 50000;
+  constexpr int kBurst = 32;
+  constexpr int kRoundTrips = 2000;
+
+  const auto server_config = MakeServerConfig();
+  TurnTestServer server(server_config);
+  ASSERT_TRUE(server.Start());
+
+  struct Path {
+    const char* name;
+    bool relay;
+    bool channel_data;
+  };
+  const Path paths[] = {{"direct", false, false},
+                        {"turn-channeldata", true, true},
+                        {"turn-indication", true, false}};
+
+  for (const auto& path : paths) {
+    auto peer = OpenPeerSocket();
+    std::unique_ptr<TurnConnection> client;
+    std::unique_ptr<UdpSocket> direct;
+    Endpoint target{kLoopback, kPeerPort};
+    if (path.relay) {
+      auto client_config = MakeClientConfig(server_config);
+      client_config.use_channel_data = path.channel_data;
+      client = std::make_unique<TurnConnection>();
+      ASSERT_TRUE(client->Initialize(client_config).IsOk());
+      ASSERT_TRUE(client->Open().IsOk());
+      target = client->GetRelayedAddress();
+    } else {
+      UdpSocket::Config config;
+      config.local_ip = kLoopback;
+      direct = std::make_unique<UdpSocket>(config);
+      ASSERT_TRUE(direct->Open());
+    }
+
+    std::vector<uint8_t> payload(kPayloadSize, 0x5C);
+    auto send = [&]() {
+      return client ? client->Send(payload.data(), payload.size()).IsOk()
+                    : direct->SendTo(payload.data(), payload.size(),
+                                     kLoopback, kPeerPort);
+    };
+    std::vector<uint8_t> buffer(2048);
+    auto recv = [&](int timeout_ms) -> bool {
+      if (client) {
+        return client->Recv(buffer.data(), buffer.size(), timeout_ms).IsOk();
+      }
+      std::string from_ip;
+      uint16_t from_port = 0;
+      size_t length = buffer.size();
+      return direct->RecvFrom(buffer.data(), length, from_ip, from_port,
+                              timeout_ms);
+    };
+
+    // 吞吐：成组发送，组间让出 CPU 给服务器线程，避免回环队列溢出
+    // 对端收不到新报文 200 ms 即认为结束，吞吐按最后一个报文到达时间计算
+    int delivered = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto last_delivery = start;
+    std::thread receiver([&]() {
+      std::vector<uint8_t> peer_buffer(2048);
+      std::string from_ip;
+      uint16_t from_port = 0;
+      while (delivered < kThroughputPackets) {
+        size_t length = peer_buffer.size();
+        if (!peer->RecvFrom(peer_buffer.data(), length, from_ip, from_port,
+                            200)) {
+          break;
+        }
+        delivered++;
+        last_delivery = std::chrono::steady_clock::now();
+      }
+    });
+    for (int i = 0; i < kThroughputPackets; ++i) {
+      ASSERT_TRUE(send());
+      if (i % kBurst == kBurst - 1) {
+        std::this_thread::sleep_for(20us);
+      }
+    }
+    receiver.join();
+    const double seconds =
+        std::chrono::duration<double>(last_delivery - start).count();
+
+    // 往返：对端回显，客户端逐个等待
+    std::atomic<bool> echoing{true};
+    std::thread echo([&]() {
+      std::vector<uint8_t> peer_buffer(2048);
+      Endpoint from;
+      while (echoing) {
+        size_t length = peer_buffer.size();
+        if (peer->RecvFrom(peer_buffer.data(), length, from.address,
+                           from.port, 50)) {
+          peer->SendTo(peer_buffer.data(), length, from.address, from.port);
+        }
+      }
+    });
+    std::vector<double> rtts;
+    for (int i = 0; i < kRoundTrips; ++i) {
+      const auto sent_at = std::chrono::steady_clock::now();
+      ASSERT_TRUE(send());
+      if (recv(1000)) {
+        rtts.push_back(std::chrono::duration<double, std::micro>(
+                           std::chrono::steady_clock::now() - sent_at)
+                           .count());
+      }
+    }
+    echoing = false;
+    echo.join();
+    ASSERT_FALSE(rtts.empty());
+    std::sort(rtts.begin(), rtts.end());
+
+    const size_t overhead =
+        !path.relay ? 0
+        : path.channel_data
+            ? kChannelDataHeaderSize
+            : server.GetStats().last_client_data_size.load() - kPayloadSize;
+    std::cout << "[ BENCH    ] " << path.name << ": overhead " << overhead
+              << " B/pkt, delivered " << delivered << "/"
+              << kThroughputPackets << ", "
+              << delivered * kPayloadSize * 8 / seconds / 1e6 << " Mbps, "
+              << delivered / seconds / 1000 << " kpps, rtt p50 "
+              << rtts[rtts.size() / 2] << " us, p99 "
+              << rtts[rtts.size() * 99 / 100] << " us" << std::endl;
+  }
+}
+
+}  // namespace zenremote
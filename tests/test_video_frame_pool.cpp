@@ -0,0 +1,245 @@
+/**
+ * @file test_video_frame_pool.cpp
+ * @brief VideoFramePool 帧缓冲池测试
+ *
+ * 测试目标：
+ * - 帧的几何、对齐与 av_frame_get_buffer() 分配的帧一致，可写
+ * - 帧释放后缓冲回到池中，稳态下不再向分配器申请
+ * - 多个帧同时在用时池扩容；池关闭后在用的帧仍然有效
+ * - 非法参数返回错误
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "media/codec/video_frame_pool.h"
+
+namespace zenremote {
+
+namespace {
+
+VideoFramePoolConfig MakeConfig(int width,
+                                int height,
+                                AVPixelFormat format = AV_PIX_FMT_NV12) {
+  VideoFramePoolConfig config;
+  config.width = width;
+  config.height = height;
+  config.format = format;
+  return config;
+}
+
+bool IsAligned(const void* pointer, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(VideoFramePoolTest, FrameGeometryMatchesConfig) {
+  VideoFramePool pool;
+  ASSERT_TRUE(pool.Initialize(MakeConfig(1918, 1080)).IsOk());
+
+  auto frame = pool.Acquire();
+  ASSERT_TRUE(frame.IsOk());
+  AVFrame* f = frame.Value().get();
+  EXPECT_EQ(f->width, 1918);
+  EXPECT_EQ(f->height, 1080);
+  EXPECT_EQ(f->format, AV_PIX_FMT_NV12);
+  ASSERT_NE(f->data[0], nullptr);
+  ASSERT_NE(f->data[1], nullptr);
+  EXPECT_GE(f->linesize[0], 1918);
+  EXPECT_EQ(f->linesize[0] % 64, 0);
+  EXPECT_TRUE(IsAligned(f->data[0], 64));
+  EXPECT_TRUE(IsAligned(f->data[1], 64));
+  EXPECT_TRUE(av_frame_is_writable(f));
+
+  // 整帧可写
+  std::memset(f->data[0], 0x10, static_cast<size_t>(f->linesize[0]) * 1080);
+  std::memset(f->data[1], 0x80, static_cast<size_t>(f->linesize[1]) * 540);
+
+  VideoFramePool yuv420p;
+  ASSERT_TRUE(
+      yuv420p.Initialize(MakeConfig(640, 360, AV_PIX_FMT_YUV420P)).IsOk());
+  auto planar = yuv420p.Acquire();
+  ASSERT_TRUE(planar.IsOk());
+  EXPECT_NE(planar.Value()->data[2], nullptr);
+  EXPECT_GE(planar.Value()->linesize[1], 320);
+}
+
+TEST(VideoFramePoolTest, ReleasedBuffersAreRecycled) {
+  VideoFramePool pool;
+  ASSERT_TRUE(pool.Initialize(MakeConfig(320, 240)).IsOk());
+
+  // 结构体复用：同一个 AVFrame 反复取帧，旧引用自动释放
+  AVFramePtr frame = MakeAVFrame();
+  uint8_t* first = nullptr;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(pool.Acquire(frame.get()).IsOk());
+    if (i == 0) {
+      first = frame->data[0];
+    }
+    EXPECT_EQ(frame->data[0], first);
+  }
+  frame.reset();
+
+  // 流水线中的引用：编码器持有一份，队列持有一份
+  for (int i = 0; i < 100; ++i) {
+    auto acquired = pool.Acquire();
+    ASSERT_TRUE(acquired.IsOk());
+    AVFramePtr reference = MakeAVFrame();
+    ASSERT_EQ(av_frame_ref(reference.get(), acquired.Value().get()), 0);
+    EXPECT_FALSE(av_frame_is_writable(acquired.Value().get()));
+  }
+
+  auto stats = pool.GetStats();
+  EXPECT_EQ(stats.buffers_allocated, 1U);
+  EXPECT_EQ(stats.frames_acquired, 200U);
+  EXPECT_EQ(stats.buffer_size,
+            static_cast<size_t>(av_image_get_buffer_size(AV_PIX_FMT_NV12,
+                                                         320, 240, 64)));
+}
+
+TEST(VideoFramePoolTest, GrowsForOutstandingFramesAndOutlivesShutdown) {
+  VideoFramePool pool;
+  ASSERT_TRUE(pool.Initialize(MakeConfig(64, 64)).IsOk());
+
+  std::vector<AVFramePtr> frames;
+  for (int i = 0; i < 3; ++i) {
+    auto frame = pool.Acquire();
+    ASSERT_TRUE(frame.IsOk());
+    frames.push_back(std::move(frame.Value()));
+  }
+  EXPECT_NE(frames[0]->data[0], frames[1]->data[0]);
+  EXPECT_EQ(pool.GetStats().buffers_allocated, 3U);
+
+  frames.clear();
+  for (int i = 0; i < 3; ++i) {
+    auto frame = pool.Acquire();
+    ASSERT_TRUE(frame.IsOk());
+    frames.push_back(std::move(frame.Value()));
+  }
+  EXPECT_EQ(pool.GetStats().buffers_allocated, 3U);
+
+  // 关闭后在用的帧仍可读写，最后一个引用释放时回收
+  pool.Shutdown();
+  EXPECT_FALSE(pool.IsInitialized());
+  std::memset(frames[2]->data[0], 0xFF, 64 * 64);
+  frames.clear();
+  EXPECT_EQ(pool.Acquire().Code(), ErrorCode::kNotInitialized);
+
+  // 可以重新初始化为其他尺寸
+  EXPECT_TRUE(pool.Initialize(MakeConfig(128, 128)).IsOk());
+  EXPECT_EQ(pool.GetStats().buffers_allocated, 0U);
+}
+
+TEST(VideoFramePoolTest, RejectsInvalidConfig) {
+  VideoFramePool pool;
+  EXPECT_EQ(pool.Initialize(MakeConfig(0, 1080)).Code(),
+            ErrorCode::kInvalidParameter);
+  auto config = MakeConfig(64, 64);
+  config.alignment = 48;
+  EXPECT_EQ(pool.Initialize(config).Code(), ErrorCode::kInvalidParameter);
+  EXPECT_EQ(pool.Acquire(nullptr).Code(), ErrorCode::kNotInitialized);
+
+  ASSERT_TRUE(pool.Initialize(MakeConfig(64, 64)).IsOk());
+  EXPECT_EQ(pool.Initialize(MakeConfig(64, 64)).Code(),
+            ErrorCode::kAlreadyInitialized);
+  EXPECT_EQ(pool.Acquire(nullptr).Code(), ErrorCode::kInvalidParameter);
+}
+
+TEST(VideoFramePoolTest, HugePagesFallBackWhenUnavailable) {
+  auto config = MakeConfig(3840, 2160);
+  config.huge_pages = true;
+  VideoFramePool pool;
+  ASSERT_TRUE(pool.Initialize(config).IsOk());
+  auto frame = pool.Acquire();
+  ASSERT_TRUE(frame.IsOk());
+  std::memset(frame.Value()->data[0], 0x10,
+              static_cast<size_t>(frame.Value()->linesize[0]) * 2160);
+  auto stats = pool.GetStats();
+  EXPECT_EQ(stats.buffers_allocated, 1U);
+  EXPECT_LE(stats.huge_page_buffers, 1U);
+}
+
+namespace {
+
+/// 进程累计的缺页次数（次要缺页，不含 I/O）
+long MinorPageFaults() {
+#ifdef _WIN32
+  return 0;
+#else
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+#endif
+}
+
+}  // namespace
+
+TEST(VideoFramePoolTest, DISABLED_BenchmarkPoolVersusFrameGetBuffer) {
+  // 4K NV12 每帧约 12 MB；写满整帧，计入缺页的代价
+  constexpr int kWidth = 3840;
+  constexpr int kHeight = 2160;
+  constexpr int kFrames = 120;
+  constexpr int kInFlight = 3;  // 转换、编码、队列中各一帧
+
+  auto run = [&](const char* name, auto&& acquire) {
+    std::vector<AVFramePtr> in_flight(kInFlight);
+    const long faults_before = MinorPageFaults();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kFrames; ++i) {
+      AVFramePtr& slot = in_flight[i % kInFlight];
+      slot = acquire();
+      ASSERT_TRUE(slot);
+      std::memset(slot->data[0], i,
+                  static_cast<size_t>(slot->linesize[0]) * kHeight);
+      std::memset(slot->data[1], i,
+                  static_cast<size_t>(slot->linesize[1]) * kHeight / 2);
+    }
+    const double us = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      kFrames;
+    std::cout << "[ BENCH    ] " << name << ": " << us << " us/frame, "
+              << static_cast<double>(MinorPageFaults() - faults_before) /
+                     kFrames
+              << " page faults/frame" << std::endl;
+  };
+
+  run("av_frame_get_buffer", []() {
+    AVFramePtr frame = MakeAVFrame();
+    frame->format = AV_PIX_FMT_NV12;
+    frame->width = kWidth;
+    frame->height = kHeight;
+    if (av_frame_get_buffer(frame.get(), 32) < 0) {
+      frame.reset();
+    }
+    return frame;
+  });
+
+  for (bool huge_pages : {false, true}) {
+    auto config = MakeConfig(kWidth, kHeight);
+    config.huge_pages = huge_pages;
+    VideoFramePool pool;
+    ASSERT_TRUE(pool.Initialize(config).IsOk());
+    run(huge_pages ? "VideoFramePool (huge pages)" : "VideoFramePool",
+        [&pool]() {
+          auto frame = pool.Acquire();
+          return frame.IsOk() ? std::move(frame.Value()) : AVFramePtr();
+        });
+    auto stats = pool.GetStats();
+    std::cout << "[ BENCH    ]   buffers allocated " << stats.buffers_allocated
+              << " for " << stats.frames_acquired << " frames, huge page "
+              << stats.huge_page_buffers << std::endl;
+  }
+}
+
+}  // namespace zenremote
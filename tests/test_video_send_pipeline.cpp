@@ -0,0 +1,421 @@
+/**
+ * @file test_video_send_pipeline.cpp
+ * @brief VideoSendPipeline 线程与丢帧策略测试（替身采集器、转换器、编码器）
+ *
+ * 测试目标：
+ * - 送出的帧保持采集顺序，RTP 时间戳不回退
+ * - 下游阻塞时上游停止采集而不是无限排队，恢复后只编码最新的帧
+ * - 被丢弃帧的关键帧请求转移到下一个编码的帧
+ * - 各队列都有在途帧时 Stop() 及时返回，采集帧全部释放，之后可重新启动
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "media/pipeline/video_send_pipeline.h"
+
+using namespace std::chrono_literals;
+
+namespace zenremote {
+
+namespace {
+
+using media::capture::DirtyRect;
+
+constexpr int kWidth = 64;
+constexpr int kHeight = 16;
+
+/// 替身采集器：每帧左上角像素写入递增的帧号（从 1 开始）
+class FakeCapturer : public media::capture::ScreenCapturer {
+ public:
+  bool Initialize(const media::capture::CaptureConfig&) override {
+    return true;
+  }
+  bool Start() override { return true; }
+  void Stop() override {}
+
+  std::optional<media::capture::Frame> CaptureFrame() override {
+    const uint32_t id = ++captured_;
+    std::memcpy(pixels_.data(), &id, sizeof(id));
+    outstanding_++;
+
+    media::capture::Frame frame;
+    frame.width = kWidth;
+    frame.height = kHeight;
+    frame.stride = kWidth * 4;
+    frame.format = media::capture::PixelFormat::BGRA32;
+    frame.data = pixels_.data();
+    frame.size = pixels_.size();
+    frame.metadata.timestamp_us = 0;
+    frame.metadata.dirty_rects = {DirtyRect{0, 0, kWidth, kHeight}};
+    frame.metadata.is_key_frame = id == keyframe_id_;
+    frame.metadata.accumulated_frames = 0;
+    frame.metadata.dirty_ratio = 1.0f;
+    return frame;
+  }
+
+  void ReleaseFrame() override { outstanding_--; }
+  void ForceKeyFrame() override {}
+  void GetResolution(int32_t& width, int32_t& height) const override {
+    width = kWidth;
+    height = kHeight;
+  }
+  media::capture::PixelFormat GetPixelFormat() const override {
+    return media::capture::PixelFormat::BGRA32;
+  }
+  uint32_t GetCurrentFps() const override { return 0; }
+  bool IsInitialized() const override { return true; }
+
+  /// @brief 帧号为 id 的帧标记为关键帧
+  void SetKeyFrameId(uint32_t id) { keyframe_id_ = id; }
+  uint32_t captured() const { return captured_; }
+  /// 已采集、尚未 ReleaseFrame() 的帧数
+  int outstanding() const { return outstanding_; }
+
+ private:
+  std::vector<uint8_t> pixels_ =
+      std::vector<uint8_t>(static_cast<size_t>(kWidth) * 4 * kHeight);
+  std::atomic<uint32_t> captured_{0};
+  std::atomic<int> outstanding_{0};
+  std::atomic<uint32_t> keyframe_id_{0};
+};
+
+/// 替身转换器：不转换像素，只把帧号带到输出帧的 pts
+class FakeConverter : public IFrameConverter {
+ public:
+  Result<void> Initialize(const ColorConverterConfig& config) override {
+    config_ = config;
+    initialized_ = true;
+    return Result<void>::Ok();
+  }
+  void Shutdown() override { initialized_ = false; }
+
+  Result<void> ConvertIncremental(const uint8_t* src_data,
+                                  int,
+                                  const std::vector<DirtyRect>&,
+                                  bool,
+                                  AVFrame* dst_frame) override {
+    uint32_t id = 0;
+    std::memcpy(&id, src_data, sizeof(id));
+    av_frame_unref(dst_frame);
+    dst_frame->width = config_.dst_width;
+    dst_frame->height = config_.dst_height;
+    dst_frame->format = config_.dst_format;
+    dst_frame->pts = id;
+    return Result<void>::Ok();
+  }
+
+  bool UsesFastPath() const override { return true; }
+  bool IsInitialized() const override { return initialized_; }
+  int GetSrcWidth() const override { return config_.src_width; }
+  int GetSrcHeight() const override { return config_.src_height; }
+  AVPixelFormat GetSrcFormat() const override { return config_.src_format; }
+
+ private:
+  ColorConverterConfig config_;
+  bool initialized_ = false;
+};
+
+/// 替身编码器：包内容为输入帧号，可阻塞或延迟 Encode()
+class FakeEncoder : public IVideoEncoder {
+ public:
+  Result<void> Initialize(const EncoderConfig&) override {
+    return Result<void>::Ok();
+  }
+  void Shutdown() override {}
+
+  Result<bool> Encode(AVFrame* frame, EncodedPacket& packet) override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      encoding_ = true;
+      cv_.notify_all();
+      cv_.wait(lock, [this]() { return !blocked_; });
+    }
+    if (delay_.count() > 0) {
+      std::this_thread::sleep_for(delay_);
+    }
+    const auto id = static_cast<uint32_t>(frame->pts);
+    packet.data.resize(sizeof(id));
+    std::memcpy(packet.data.data(), &id, sizeof(id));
+    // 流水线按 pts（输入帧序号）找回采集时刻
+    packet.pts = next_pts_++;
+    packet.is_keyframe = force_keyframe_.exchange(false);
+    packet.end_of_frame = true;
+    return Result<bool>::Ok(true);
+  }
+
+  Result<void> Flush(std::vector<EncodedPacket>&) override {
+    return Result<void>::Ok();
+  }
+  void ForceKeyFrame() override { force_keyframe_ = true; }
+  Result<void> UpdateBitrate(int) override { return Result<void>::Ok(); }
+  EncoderStats GetStats() const override { return {}; }
+  bool IsInitialized() const override { return true; }
+  EncoderType GetEncoderType() const override {
+    return EncoderType::kSoftware;
+  }
+  std::string GetEncoderName() const override { return "fake"; }
+
+  void SetDelay(std::chrono::milliseconds delay) { delay_ = delay; }
+
+  /// @brief 之后的 Encode() 阻塞到 Unblock()
+  void Block() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocked_ = true;
+    encoding_ = false;
+  }
+  void Unblock() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocked_ = false;
+    }
+    cv_.notify_all();
+  }
+  /// @brief 等待某次 Encode() 开始
+  bool WaitUntilEncoding(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, timeout, [this]() { return encoding_; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool blocked_ = false;
+  bool encoding_ = false;
+  std::chrono::milliseconds delay_{0};
+  int64_t next_pts_ = 0;
+  std::atomic<bool> force_keyframe_{false};
+};
+
+struct SentPacket {
+  uint32_t frame_id = 0;
+  bool is_keyframe = false;
+  uint32_t timestamp_90khz = 0;
+};
+
+/// 记录发送阶段收到的包
+class PacketRecorder {
+ public:
+  VideoSendPipeline::PacketSink MakeSink() {
+    return [this](const EncodedPacket& packet, uint32_t timestamp_90khz) {
+      if (delay_.count() > 0) {
+        std::this_thread::sleep_for(delay_);
+      }
+      SentPacket sent;
+      std::memcpy(&sent.frame_id, packet.data.data(), sizeof(sent.frame_id));
+      sent.is_keyframe = packet.is_keyframe;
+      sent.timestamp_90khz = timestamp_90khz;
+      std::lock_guard<std::mutex> lock(mutex_);
+      packets_.push_back(sent);
+      return Result<void>::Ok();
+    };
+  }
+
+  void SetDelay(std::chrono::milliseconds delay) { delay_ = delay; }
+
+  std::vector<SentPacket> packets() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return packets_;
+  }
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return packets_.size();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<SentPacket> packets_;
+  std::chrono::milliseconds delay_{0};
+};
+
+VideoSendPipeline::Config MakeConfig(int framerate) {
+  VideoSendPipeline::Config config;
+  config.encoder.width = kWidth;
+  config.encoder.height = kHeight;
+  config.encoder.framerate = framerate;
+  config.frame_queue_depth = 2;
+  config.packet_queue_depth = 4;
+  config.skip_static_frames = false;
+  return config;
+}
+
+bool WaitFor(const std::function<bool()>& done,
+             std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (done()) {
+      return true;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return done();
+}
+
+/// @brief 等待采集停止（帧数在 quiet 内不再增加）
+bool WaitForCaptureStall(const FakeCapturer& capturer,
+                         std::chrono::milliseconds quiet,
+                         std::chrono::milliseconds timeout) {
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  uint32_t last = capturer.captured();
+  auto last_change = std::chrono::steady_clock::now();
+  while (std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(5ms);
+    const uint32_t now = capturer.captured();
+    if (now != last) {
+      last = now;
+      last_change = std::chrono::steady_clock::now();
+    } else if (std::chrono::steady_clock::now() - last_change >= quiet) {
+      return true;
+    }
+  }
+  return false;
+}
+
+struct FakeStages {
+  FakeStages() {
+    auto converter_ptr = std::make_unique<FakeConverter>();
+    auto encoder_ptr = std::make_unique<FakeEncoder>();
+    encoder = encoder_ptr.get();
+    stages.capturer = &capturer;
+    stages.converter = std::move(converter_ptr);
+    stages.encoder = std::move(encoder_ptr);
+    stages.sink = recorder.MakeSink();
+  }
+
+  FakeCapturer capturer;
+  PacketRecorder recorder;
+  FakeEncoder* encoder = nullptr;  ///< 由流水线持有，Stop() 后失效
+  VideoSendPipeline::Stages stages;
+};
+
+}  // namespace
+
+TEST(VideoSendPipelineTest, RequiresAllStages) {
+  VideoSendPipeline pipeline(MakeConfig(100));
+  FakeStages fakes;
+  fakes.stages.converter.reset();
+  EXPECT_EQ(pipeline.Start(std::move(fakes.stages)).Code(),
+            ErrorCode::kInvalidParameter);
+  EXPECT_FALSE(pipeline.IsRunning());
+}
+
+TEST(VideoSendPipelineTest, DeliversFramesInCaptureOrder) {
+  VideoSendPipeline pipeline(MakeConfig(200));
+  FakeStages fakes;
+  ASSERT_TRUE(pipeline.Start(std::move(fakes.stages)).IsOk());
+  ASSERT_TRUE(WaitFor([&]() { return fakes.recorder.size() >= 20; }, 5s));
+  pipeline.Stop();
+
+  const auto packets = fakes.recorder.packets();
+  for (size_t i = 1; i < packets.size(); ++i) {
+    EXPECT_GT(packets[i].frame_id, packets[i - 1].frame_id) << i;
+    EXPECT_GE(packets[i].timestamp_90khz, packets[i - 1].timestamp_90khz)
+        << i;
+  }
+  const auto stats = pipeline.GetStats();
+  EXPECT_EQ(stats.stages[static_cast<size_t>(
+                                VideoSendPipeline::Stage::kPacketize)]
+                .processed,
+            packets.size());
+}
+
+TEST(VideoSendPipelineTest, BlockedEncoderStallsCaptureAndDropsStaleFrames) {
+  VideoSendPipeline pipeline(MakeConfig(100));
+  FakeStages fakes;
+  fakes.encoder->Block();
+  ASSERT_TRUE(pipeline.Start(std::move(fakes.stages)).IsOk());
+  ASSERT_TRUE(fakes.encoder->WaitUntilEncoding(5s));
+
+  // 编码阻塞期间各队列填满后采集暂停，不会无限排队
+  ASSERT_TRUE(WaitForCaptureStall(fakes.capturer, 100ms, 5s));
+  // 正在编码的 1 帧 + 转换后 2 帧 + 采集队列 3 帧（各 frame_queue_depth + 1
+  // 个槽位，编码中的帧占用转换队列的一个），另加转换阶段按最新帧优先丢弃的
+  const auto blocked_stats = pipeline.GetStats();
+  EXPECT_EQ(fakes.capturer.captured(),
+            6U + blocked_stats
+                     .stages[static_cast<size_t>(
+                         VideoSendPipeline::Stage::kConvert)]
+                     .dropped);
+  EXPECT_EQ(fakes.recorder.size(), 0U);
+
+  fakes.encoder->Unblock();
+  ASSERT_TRUE(WaitFor([&]() { return fakes.recorder.size() >= 5; }, 5s));
+  pipeline.Stop();
+
+  const auto packets = fakes.recorder.packets();
+  for (size_t i = 1; i < packets.size(); ++i) {
+    EXPECT_GT(packets[i].frame_id, packets[i - 1].frame_id) << i;
+  }
+  // 恢复后排在队列中的旧帧被丢弃，只编码最新的
+  ASSERT_GE(packets.size(), 2U);
+  EXPECT_GT(packets[1].frame_id, packets[0].frame_id + 1);
+  const auto stats = pipeline.GetStats();
+  EXPECT_GT(
+      stats.stages[static_cast<size_t>(VideoSendPipeline::Stage::kEncode)]
+          .dropped,
+      0U);
+}
+
+TEST(VideoSendPipelineTest, DroppedKeyFrameForcesNextEncodedKeyFrame) {
+  VideoSendPipeline pipeline(MakeConfig(100));
+  FakeStages fakes;
+  // 第 2 帧是关键帧，编码阻塞期间它排在队列里，恢复后被丢弃
+  fakes.capturer.SetKeyFrameId(2);
+  fakes.encoder->Block();
+  ASSERT_TRUE(pipeline.Start(std::move(fakes.stages)).IsOk());
+  ASSERT_TRUE(fakes.encoder->WaitUntilEncoding(5s));
+  ASSERT_TRUE(WaitForCaptureStall(fakes.capturer, 100ms, 5s));
+  fakes.encoder->Unblock();
+  ASSERT_TRUE(WaitFor([&]() { return fakes.recorder.size() >= 3; }, 5s));
+  pipeline.Stop();
+
+  const auto packets = fakes.recorder.packets();
+  ASSERT_GE(packets.size(), 3U);
+  EXPECT_EQ(packets[0].frame_id, 1U);
+  EXPECT_FALSE(packets[0].is_keyframe);
+  // 关键帧请求随丢弃转移到下一个编码的帧，且只生效一次
+  EXPECT_GT(packets[1].frame_id, 2U);
+  EXPECT_TRUE(packets[1].is_keyframe);
+  EXPECT_FALSE(packets[2].is_keyframe);
+}
+
+TEST(VideoSendPipelineTest, StopsCleanlyWithFramesInFlight) {
+  VideoSendPipeline pipeline(MakeConfig(200));
+  {
+    FakeStages fakes;
+    fakes.encoder->SetDelay(5ms);
+    fakes.recorder.SetDelay(5ms);
+    ASSERT_TRUE(pipeline.Start(std::move(fakes.stages)).IsOk());
+    ASSERT_TRUE(WaitFor([&]() { return fakes.recorder.size() >= 5; }, 5s));
+
+    const auto start = std::chrono::steady_clock::now();
+    pipeline.Stop();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+    EXPECT_FALSE(pipeline.IsRunning());
+    EXPECT_EQ(fakes.capturer.outstanding(), 0);
+
+    // Stop() 返回后不再调用任何阶段
+    const size_t sent = fakes.recorder.size();
+    const uint32_t captured = fakes.capturer.captured();
+    std::this_thread::sleep_for(50ms);
+    EXPECT_EQ(fakes.recorder.size(), sent);
+    EXPECT_EQ(fakes.capturer.captured(), captured);
+  }
+
+  // 可用新的阶段实现重新启动
+  FakeStages fakes;
+  ASSERT_TRUE(pipeline.Start(std::move(fakes.stages)).IsOk());
+  EXPECT_TRUE(WaitFor([&]() { return fakes.recorder.size() >= 3; }, 5s));
+  pipeline.Stop();
+}
+
+}  // namespace zenremote
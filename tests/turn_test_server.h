@@ -0,0 +1,351 @@
+/**
+ * @file turn_test_server.h
+ * @brief 测试用最小 TURN 服务器（RFC 8656 子集，UDP）
+ *
+ * 支持 TurnConnection 用到的全部流程：
+ * - 长期凭据：未带 MESSAGE-INTEGRITY 的请求返回 401 + REALM/NONCE，
+ *   nonce 轮换后旧 nonce 的请求返回 438
+ * - Allocate / Refresh（lifetime 0 释放）/ CreatePermission / ChannelBind
+ * - 客户端 -> 对端：Send indication 与 ChannelData
+ * - 对端 -> 客户端：已绑定通道用 ChannelData，否则 Data indication
+ *
+ * 每个分配一个中继 socket，与监听 socket 一起在单线程中 poll。不做分配
+ * 过期回收和配额限制，只用于单元测试和中继开销基准。
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network/io/endpoint.h"
+#include "network/io/event_poller.h"
+#include "network/io/udp_socket.h"
+#include "network/protocol/stun_message.h"
+
+namespace zenremote {
+
+class TurnTestServer {
+ public:
+  struct Config {
+    std::string address = "127.0.0.1";
+    uint16_t port = 0;  ///< 0 = 自动分配
+    std::string realm = "zenremote.test";
+    std::string username = "user";
+    std::string password = "secret";
+    uint32_t max_lifetime_s = 600;  ///< 授予的 lifetime 上限
+  };
+
+  struct Stats {
+    std::atomic<uint64_t> unauthorized{0};  ///< 401 响应数
+    std::atomic<uint64_t> stale_nonce{0};   ///< 438 响应数
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> refreshes{0};
+    std::atomic<uint64_t> permissions{0};
+    std::atomic<uint64_t> channel_binds{0};
+    std::atomic<uint64_t> channel_data_relayed{0};  ///< 客户端 -> 对端
+    std::atomic<uint64_t> indications_relayed{0};   ///< 客户端 -> 对端
+    std::atomic<uint64_t> peer_packets_relayed{0};  ///< 对端 -> 客户端
+    std::atomic<size_t> last_client_data_size{0};   ///< 最近数据报文线上长度
+  };
+
+  explicit TurnTestServer(const Config& config)
+      : config_(config),
+        key_(ComputeStunLongTermKey(config.username,
+                                    config.realm,
+                                    config.password)) {}
+
+  ~TurnTestServer() { Stop(); }
+
+  TurnTestServer(const TurnTestServer&) = delete;
+  TurnTestServer& operator=(const TurnTestServer&) = delete;
+
+  bool Start() {
+    UdpSocket::Config socket_config;
+    socket_config.local_ip = config_.address;
+    socket_config.local_port = config_.port;
+    socket_ = std::make_unique<UdpSocket>(socket_config);
+    if (!socket_->Open() || poller_.Open().IsErr()) {
+      socket_.reset();
+      return false;
+    }
+    running_ = true;
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+  }
+
+  void Stop() {
+    if (!thread_.joinable()) {
+      return;
+    }
+    running_ = false;
+    poller_.Wakeup();
+    thread_.join();
+    allocations_.clear();
+    socket_.reset();
+  }
+
+  uint16_t GetPort() const { return socket_ ? socket_->GetLocalPort() : 0; }
+
+  /// @brief 更换 nonce，之后带旧 nonce 的请求收到 438
+  void RotateNonce() {
+    std::lock_guard<std::mutex> lock(nonce_mutex_);
+    nonce_ = "nonce-" + std::to_string(++nonce_generation_);
+  }
+
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  struct Allocation {
+    Endpoint client;
+    std::unique_ptr<UdpSocket> relay;
+    std::set<std::string> permissions;  ///< 对端 IP（权限不含端口）
+    std::map<uint16_t, Endpoint> channels;
+  };
+
+  static std::string Key(const Endpoint& endpoint) {
+    return endpoint.address + "|" + std::to_string(endpoint.port);
+  }
+
+  std::string CurrentNonce() {
+    std::lock_guard<std::mutex> lock(nonce_mutex_);
+    return nonce_;
+  }
+
+  void Run() {
+    std::vector<uint8_t> buffer(65536);
+    while (running_) {
+      std::vector<socket_t> handles = {socket_->GetHandle()};
+      for (const auto& entry : allocations_) {
+        handles.push_back(entry.second.relay->GetHandle());
+      }
+      poller_.Wait(handles, 50);
+
+      Endpoint from;
+      size_t received = buffer.size();
+      while (socket_->RecvFrom(buffer.data(), received, from.address,
+                               from.port, 0)) {
+        HandleClientPacket(buffer.data(), received, from);
+        received = buffer.size();
+      }
+      for (auto& entry : allocations_) {
+        received = buffer.size();
+        while (entry.second.relay->RecvFrom(buffer.data(), received,
+                                            from.address, from.port, 0)) {
+          HandlePeerPacket(entry.second, buffer.data(), received, from);
+          received = buffer.size();
+        }
+      }
+    }
+  }
+
+  void HandleClientPacket(const uint8_t* data,
+                          size_t length,
+                          const Endpoint& from) {
+    auto it = allocations_.find(Key(from));
+    size_t payload_length = 0;
+    if (auto channel = ParseChannelDataHeader(data, length, payload_length)) {
+      if (it == allocations_.end()) {
+        return;
+      }
+      auto peer = it->second.channels.find(*channel);
+      if (peer == it->second.channels.end()) {
+        return;
+      }
+      stats_.last_client_data_size = length;
+      stats_.channel_data_relayed++;
+      it->second.relay->SendTo(data + kChannelDataHeaderSize, payload_length,
+                               peer->second.address, peer->second.port);
+      return;
+    }
+
+    auto message = ParseStunMessage(data, length);
+    if (!message) {
+      return;
+    }
+    if (message->message_class == StunClass::kIndication) {
+      if (it == allocations_.end() || !message->Is(StunMethod::kSend)) {
+        return;
+      }
+      auto peer = message->GetXorAddress(StunAttributeType::kXorPeerAddress);
+      const auto* payload = message->Find(StunAttributeType::kData);
+      if (!peer || !payload ||
+          !it->second.permissions.count(peer->address)) {
+        return;
+      }
+      stats_.last_client_data_size = length;
+      stats_.indications_relayed++;
+      it->second.relay->SendTo(payload->value.data(), payload->value.size(),
+                               peer->address, peer->port);
+      return;
+    }
+    if (message->message_class != StunClass::kRequest ||
+        !Authenticate(*message, data, length, from)) {
+      return;
+    }
+
+    StunMessage response;
+    response.method = message->method;
+    response.message_class = StunClass::kSuccessResponse;
+    response.transaction_id = message->transaction_id;
+
+    if (message->Is(StunMethod::kAllocate)) {
+      if (it == allocations_.end()) {
+        Allocation allocation;
+        allocation.client = from;
+        UdpSocket::Config relay_config;
+        relay_config.local_ip = config_.address;
+        allocation.relay = std::make_unique<UdpSocket>(relay_config);
+        if (!allocation.relay->Open()) {
+          return;
+        }
+        it = allocations_.emplace(Key(from), std::move(allocation)).first;
+        stats_.allocations++;
+      }
+      response.AddXorAddress(
+          StunAttributeType::kXorRelayedAddress,
+          {config_.address, it->second.relay->GetLocalPort()});
+      response.AddXorAddress(StunAttributeType::kXorMappedAddress, from);
+      response.AddUint32(StunAttributeType::kLifetime,
+                         GrantedLifetime(*message));
+    } else if (it == allocations_.end()) {
+      SendError(*message, 437, "Allocation Mismatch", from);
+      return;
+    } else if (message->Is(StunMethod::kRefresh)) {
+      const uint32_t lifetime = GrantedLifetime(*message);
+      response.AddUint32(StunAttributeType::kLifetime, lifetime);
+      if (lifetime == 0) {
+        allocations_.erase(it);
+      } else {
+        stats_.refreshes++;
+      }
+    } else if (message->Is(StunMethod::kCreatePermission)) {
+      auto peer = message->GetXorAddress(StunAttributeType::kXorPeerAddress);
+      if (!peer) {
+        SendError(*message, 400, "Bad Request", from);
+        return;
+      }
+      it->second.permissions.insert(peer->address);
+      stats_.permissions++;
+    } else if (message->Is(StunMethod::kChannelBind)) {
+      auto peer = message->GetXorAddress(StunAttributeType::kXorPeerAddress);
+      auto number = message->GetUint32(StunAttributeType::kChannelNumber);
+      const uint16_t channel = number ? static_cast<uint16_t>(*number >> 16U)
+                                      : 0;
+      if (!peer || channel < kMinChannelNumber ||
+          channel > kMaxChannelNumber) {
+        SendError(*message, 400, "Bad Request", from);
+        return;
+      }
+      // 通道绑定同时安装权限（RFC 8656 12.2）
+      it->second.channels[channel] = *peer;
+      it->second.permissions.insert(peer->address);
+      stats_.channel_binds++;
+    } else {
+      SendError(*message, 400, "Bad Request", from);
+      return;
+    }
+
+    const auto bytes = SerializeStunMessage(response, key_);
+    socket_->SendTo(bytes.data(), bytes.size(), from.address, from.port);
+  }
+
+  void HandlePeerPacket(Allocation& allocation,
+                        const uint8_t* data,
+                        size_t length,
+                        const Endpoint& from) {
+    if (!allocation.permissions.count(from.address)) {
+      return;
+    }
+    stats_.peer_packets_relayed++;
+    for (const auto& channel : allocation.channels) {
+      if (channel.second == from) {
+        std::vector<uint8_t> packet(kChannelDataHeaderSize + length);
+        WriteChannelDataHeader(channel.first, length, packet.data());
+        std::memcpy(packet.data() + kChannelDataHeaderSize, data, length);
+        socket_->SendTo(packet.data(), packet.size(),
+                        allocation.client.address, allocation.client.port);
+        return;
+      }
+    }
+
+    StunMessage indication;
+    indication.method = static_cast<uint16_t>(StunMethod::kData);
+    indication.message_class = StunClass::kIndication;
+    indication.AddXorAddress(StunAttributeType::kXorPeerAddress, from);
+    indication.AddAttribute(StunAttributeType::kData,
+                            std::vector<uint8_t>(data, data + length));
+    const auto bytes = SerializeStunMessage(indication);
+    socket_->SendTo(bytes.data(), bytes.size(), allocation.client.address,
+                    allocation.client.port);
+  }
+
+  /// @brief 长期凭据校验，失败时已回复 401/438
+  bool Authenticate(const StunMessage& request,
+                    const uint8_t* data,
+                    size_t length,
+                    const Endpoint& from) {
+    const auto username = request.GetString(StunAttributeType::kUsername);
+    const auto nonce = request.GetString(StunAttributeType::kNonce);
+    if (!request.Has(StunAttributeType::kMessageIntegrity) || !username ||
+        *username != config_.username || !nonce ||
+        !VerifyStunMessageIntegrity(data, length, key_)) {
+      stats_.unauthorized++;
+      SendError(request, kStunErrorUnauthorized, "Unauthorized", from);
+      return false;
+    }
+    if (*nonce != CurrentNonce()) {
+      stats_.stale_nonce++;
+      SendError(request, kStunErrorStaleNonce, "Stale Nonce", from);
+      return false;
+    }
+    return true;
+  }
+
+  void SendError(const StunMessage& request,
+                 int code,
+                 const std::string& reason,
+                 const Endpoint& to) {
+    StunMessage response;
+    response.method = request.method;
+    response.message_class = StunClass::kErrorResponse;
+    response.transaction_id = request.transaction_id;
+    response.AddErrorCode(code, reason);
+    response.AddString(StunAttributeType::kRealm, config_.realm);
+    response.AddString(StunAttributeType::kNonce, CurrentNonce());
+    const auto bytes = SerializeStunMessage(response);
+    socket_->SendTo(bytes.data(), bytes.size(), to.address, to.port);
+  }
+
+  uint32_t GrantedLifetime(const StunMessage& request) const {
+    const uint32_t requested =
+        request.GetUint32(StunAttributeType::kLifetime)
+            .value_or(config_.max_lifetime_s);
+    return std::min(requested, config_.max_lifetime_s);
+  }
+
+  Config config_;
+  std::vector<uint8_t> key_;
+  std::unique_ptr<UdpSocket> socket_;
+  EventPoller poller_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+
+  std::map<std::string, Allocation> allocations_;  ///< 只在服务线程访问
+
+  std::mutex nonce_mutex_;
+  std::string nonce_ = "nonce-0";
+  int nonce_generation_ = 0;
+
+  Stats stats_;
+};
+
+}  // namespace zenremote